@@ -0,0 +1,356 @@
+///////////////////////////////////////////////////////////////////////////////
+// assetwatcher.cpp
+// ============
+// watch the texture, shader and scene files for changes on a background
+// thread, so they can be reloaded while the application runs
+//
+//  Created for CS-330-Computational Graphics and Visualization
+///////////////////////////////////////////////////////////////////////////////
+
+#include "AssetWatcher.h"
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <sys/stat.h>
+#include <sys/types.h>
+#ifdef __linux__
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+#endif
+
+// declaration of the global variables and defines
+namespace
+{
+	// longest time the watching thread waits before checking
+	// whether it has been asked to stop, in milliseconds
+	const int STOP_CHECK_INTERVAL = 250;
+	// time given to an editor to finish writing a file before
+	// it is checked, in milliseconds
+	const int SETTLE_TIME = 100;
+
+	/***********************************************************
+	 *  GetFileStatus()
+	 *
+	 *  This function is used to get the size and modification
+	 *  time of a file, which are both -1 when it is missing.
+	 *  The time is kept at the finest resolution the system
+	 *  gives, so two saves within a second are both seen.
+	 ***********************************************************/
+	void GetFileStatus(const std::string& filePath, long long& modifiedTime, long long& size)
+	{
+		modifiedTime = -1;
+		size = -1;
+#ifdef _WIN32
+		WIN32_FILE_ATTRIBUTE_DATA attributes;
+		if (GetFileAttributesExA(filePath.c_str(), GetFileExInfoStandard, &attributes) != 0)
+		{
+			modifiedTime = ((long long)attributes.ftLastWriteTime.dwHighDateTime << 32) |
+				attributes.ftLastWriteTime.dwLowDateTime;
+			size = ((long long)attributes.nFileSizeHigh << 32) | attributes.nFileSizeLow;
+		}
+#else
+		struct stat fileStatus;
+		if (stat(filePath.c_str(), &fileStatus) == 0)
+		{
+#if defined(__APPLE__)
+			modifiedTime = (long long)fileStatus.st_mtimespec.tv_sec * 1000000000LL + fileStatus.st_mtimespec.tv_nsec;
+#else
+			modifiedTime = (long long)fileStatus.st_mtim.tv_sec * 1000000000LL + fileStatus.st_mtim.tv_nsec;
+#endif
+			size = (long long)fileStatus.st_size;
+		}
+#endif
+	}
+
+	/***********************************************************
+	 *  GetDirectory()
+	 *
+	 *  This function is used to get the directory part of a
+	 *  file path, or "." for a file in the working directory.
+	 ***********************************************************/
+	std::string GetDirectory(const std::string& filePath)
+	{
+		size_t slash = filePath.find_last_of("/\\");
+		if (slash == std::string::npos)
+		{
+			return(".");
+		}
+		return(filePath.substr(0, slash));
+	}
+}
+
+/***********************************************************
+ *  AssetWatcher()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+AssetWatcher::AssetWatcher()
+{
+	m_bHasChanges = false;
+	m_bDirectoriesAdded = false;
+	m_bStop = false;
+}
+
+/***********************************************************
+ *  ~AssetWatcher()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+AssetWatcher::~AssetWatcher()
+{
+	Stop();
+}
+
+/***********************************************************
+ *  WatchFile()
+ *
+ *  This method is used for adding a file to the watched
+ *  list.  A file added while the watching thread runs is
+ *  compared with how it looks when it is added, and the
+ *  thread starts waiting on its directory, if that is new,
+ *  the next time it wakes.
+ ***********************************************************/
+void AssetWatcher::WatchFile(const std::string& filePath)
+{
+	std::lock_guard<std::mutex> lock(m_fileMutex);
+	for (size_t i = 0; i < m_files.size(); i++)
+	{
+		if (m_files[i].path == filePath)
+		{
+			return;
+		}
+	}
+
+	WATCHED_FILE file;
+	file.path = filePath;
+	GetFileStatus(filePath, file.modifiedTime, file.size);
+	m_files.push_back(file);
+
+	std::string directory = GetDirectory(filePath);
+	if (std::find(m_directories.begin(), m_directories.end(), directory) == m_directories.end())
+	{
+		m_directories.push_back(directory);
+		m_bDirectoriesAdded = true;
+	}
+}
+
+/***********************************************************
+ *  Start()
+ *
+ *  This method is used for starting the watching thread.
+ ***********************************************************/
+bool AssetWatcher::Start()
+{
+	std::lock_guard<std::mutex> lock(m_fileMutex);
+	if ((m_thread.joinable() == true) || (m_files.empty() == true))
+	{
+		return(false);
+	}
+
+	m_bStop = false;
+	m_bDirectoriesAdded = true;
+	m_thread = std::thread(&AssetWatcher::WatchDirectories, this);
+	std::cout << "INFO: Watching " << m_files.size() << " asset files in "
+		<< m_directories.size() << " directories for changes" << std::endl;
+	return(true);
+}
+
+/***********************************************************
+ *  Stop()
+ *
+ *  This method is used for ending the watching thread.
+ ***********************************************************/
+void AssetWatcher::Stop()
+{
+	if (m_thread.joinable() == true)
+	{
+		m_bStop = true;
+		m_thread.join();
+	}
+}
+
+/***********************************************************
+ *  HasChanges()
+ *
+ *  This method is used for checking whether there are any
+ *  changed files waiting to be taken.
+ ***********************************************************/
+bool AssetWatcher::HasChanges() const
+{
+	return(m_bHasChanges);
+}
+
+/***********************************************************
+ *  TakeChangedFiles()
+ *
+ *  This method is used for collecting the files that have
+ *  changed since it was last called.
+ ***********************************************************/
+void AssetWatcher::TakeChangedFiles(std::vector<std::string>& filePaths)
+{
+	std::lock_guard<std::mutex> lock(m_changeMutex);
+	filePaths.insert(filePaths.end(), m_changedFiles.begin(), m_changedFiles.end());
+	m_changedFiles.clear();
+	m_bHasChanges = false;
+}
+
+/***********************************************************
+ *  WatchDirectories()
+ *
+ *  This method is run by the watching thread.  It sleeps in
+ *  the operating system until a watched directory changes
+ *  or the stop interval passes, and after a change waits a
+ *  moment for the writing to finish before the files are
+ *  checked.  Directories added since it last woke are
+ *  waited on from then on.
+ ***********************************************************/
+void AssetWatcher::WatchDirectories()
+{
+#ifdef _WIN32
+	std::vector<HANDLE> handles;
+	size_t watchedDirectories = 0;
+	while (m_bStop == false)
+	{
+		if (m_bDirectoriesAdded.exchange(false) == true)
+		{
+			std::lock_guard<std::mutex> lock(m_fileMutex);
+			for (; (watchedDirectories < m_directories.size()) && (handles.size() < MAXIMUM_WAIT_OBJECTS); watchedDirectories++)
+			{
+				HANDLE handle = FindFirstChangeNotificationA(m_directories[watchedDirectories].c_str(), FALSE,
+					FILE_NOTIFY_CHANGE_LAST_WRITE | FILE_NOTIFY_CHANGE_FILE_NAME | FILE_NOTIFY_CHANGE_SIZE);
+				if (handle != INVALID_HANDLE_VALUE)
+				{
+					handles.push_back(handle);
+				}
+			}
+		}
+
+		DWORD result = WAIT_TIMEOUT;
+		if (handles.empty() == false)
+		{
+			result = WaitForMultipleObjects((DWORD)handles.size(), &handles[0], FALSE, STOP_CHECK_INTERVAL);
+		}
+		else
+		{
+			Sleep(STOP_CHECK_INTERVAL);
+		}
+		if ((result >= WAIT_OBJECT_0) && (result < WAIT_OBJECT_0 + handles.size()))
+		{
+			Sleep(SETTLE_TIME);
+			FindNextChangeNotification(handles[result - WAIT_OBJECT_0]);
+			CheckFiles();
+		}
+		else if (handles.empty() == true)
+		{
+			CheckFiles();
+		}
+	}
+
+	for (size_t i = 0; i < handles.size(); i++)
+	{
+		FindCloseChangeNotification(handles[i]);
+	}
+#elif defined(__linux__)
+	int notifyDescriptor = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+	size_t watchedDirectories = 0;
+	char events[4096];
+	while (m_bStop == false)
+	{
+		if ((m_bDirectoriesAdded.exchange(false) == true) && (notifyDescriptor >= 0))
+		{
+			std::lock_guard<std::mutex> lock(m_fileMutex);
+			for (; watchedDirectories < m_directories.size(); watchedDirectories++)
+			{
+				inotify_add_watch(notifyDescriptor, m_directories[watchedDirectories].c_str(),
+					IN_CLOSE_WRITE | IN_MODIFY | IN_MOVED_TO | IN_CREATE);
+			}
+		}
+
+		if (notifyDescriptor < 0)
+		{
+			std::this_thread::sleep_for(std::chrono::milliseconds(STOP_CHECK_INTERVAL));
+			CheckFiles();
+			continue;
+		}
+
+		pollfd waitFor;
+		waitFor.fd = notifyDescriptor;
+		waitFor.events = POLLIN;
+		waitFor.revents = 0;
+		if (poll(&waitFor, 1, STOP_CHECK_INTERVAL) > 0)
+		{
+			// the events only say that something changed, the
+			// files themselves are compared afterwards
+			std::this_thread::sleep_for(std::chrono::milliseconds(SETTLE_TIME));
+			while (read(notifyDescriptor, events, sizeof(events)) > 0)
+			{
+			}
+			CheckFiles();
+		}
+	}
+
+	if (notifyDescriptor >= 0)
+	{
+		close(notifyDescriptor);
+	}
+#else
+	while (m_bStop == false)
+	{
+		std::this_thread::sleep_for(std::chrono::milliseconds(STOP_CHECK_INTERVAL));
+		CheckFiles();
+	}
+#endif
+}
+
+/***********************************************************
+ *  CheckFiles()
+ *
+ *  This method is used for finding the watched files whose
+ *  size or modification time differs from the last check.
+ *  A file that has gone missing is not reported, since
+ *  editors often remove a file just before writing it again.
+ ***********************************************************/
+void AssetWatcher::CheckFiles()
+{
+	std::vector<std::string> changedFiles;
+	{
+		std::lock_guard<std::mutex> fileLock(m_fileMutex);
+		for (size_t i = 0; i < m_files.size(); i++)
+		{
+			WATCHED_FILE& file = m_files[i];
+			long long modifiedTime = 0;
+			long long size = 0;
+			GetFileStatus(file.path, modifiedTime, size);
+			if ((size < 0) || ((modifiedTime == file.modifiedTime) && (size == file.size)))
+			{
+				continue;
+			}
+			file.modifiedTime = modifiedTime;
+			file.size = size;
+			changedFiles.push_back(file.path);
+		}
+	}
+	if (changedFiles.empty() == true)
+	{
+		return;
+	}
+
+	std::lock_guard<std::mutex> lock(m_changeMutex);
+	for (size_t i = 0; i < changedFiles.size(); i++)
+	{
+		if (std::find(m_changedFiles.begin(), m_changedFiles.end(), changedFiles[i]) == m_changedFiles.end())
+		{
+			m_changedFiles.push_back(changedFiles[i]);
+		}
+	}
+	m_bHasChanges = true;
+}
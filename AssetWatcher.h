@@ -0,0 +1,83 @@
+///////////////////////////////////////////////////////////////////////////////
+// assetwatcher.h
+// ============
+// watch the texture, shader and scene files for changes on a background
+// thread, so they can be reloaded while the application runs
+//
+//  Created for CS-330-Computational Graphics and Visualization
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+/***********************************************************
+ *  AssetWatcher
+ *
+ *  This class contains the code for noticing when any of a
+ *  list of files is written.  A background thread waits on
+ *  the operating system's change notifications for the
+ *  directories holding the files, inotify on Linux and
+ *  directory change notifications on Windows, and polls on
+ *  other systems.  When a directory changes, the size and
+ *  modification time of its watched files are compared
+ *  with the last ones seen, so only the files that really
+ *  changed are reported, once each.
+ ***********************************************************/
+class AssetWatcher
+{
+public:
+	// constructor
+	AssetWatcher();
+	// destructor
+	~AssetWatcher();
+
+	// add a file to watch, before or after the watching is started
+	void WatchFile(const std::string& filePath);
+	// start watching the files on a background thread
+	bool Start();
+	// stop watching and wait for the thread to end
+	void Stop();
+
+	// check whether any files have changed that have not been
+	// taken yet
+	bool HasChanges() const;
+	// move the files that have changed since the last call into
+	// the passed in list
+	void TakeChangedFiles(std::vector<std::string>& filePaths);
+
+private:
+	// a watched file and how it looked when last checked
+	struct WATCHED_FILE
+	{
+		std::string path;
+		long long modifiedTime;
+		long long size;
+	};
+
+	// the watched files and their directories, which files can
+	// be added to while the watching thread runs
+	std::mutex m_fileMutex;
+	std::vector<WATCHED_FILE> m_files;
+	std::vector<std::string> m_directories;
+	// true when directories have been added that the watching
+	// thread has not started waiting on yet
+	std::atomic<bool> m_bDirectoriesAdded;
+	// changed files waiting to be taken
+	mutable std::mutex m_changeMutex;
+	std::vector<std::string> m_changedFiles;
+	std::atomic<bool> m_bHasChanges;
+	// the watching thread and the flag that asks it to end
+	std::thread m_thread;
+	std::atomic<bool> m_bStop;
+
+	// wait for the directories to change until asked to stop
+	void WatchDirectories();
+	// compare the watched files with how they looked before and
+	// report the ones that changed
+	void CheckFiles();
+};
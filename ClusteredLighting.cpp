@@ -0,0 +1,525 @@
+///////////////////////////////////////////////////////////////////////////////
+// clusteredlighting.cpp
+// ============
+// divide the view frustum into clusters and assign the scene lights to
+// the clusters they reach, so each fragment only shades nearby lights
+//
+//  Created for CS-330-Computational Graphics and Visualization
+///////////////////////////////////////////////////////////////////////////////
+
+#include "ClusteredLighting.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <thread>
+
+// declaration of the global variables and defines
+namespace
+{
+	// shader storage buffer binding points
+	const GLuint LIGHT_BUFFER_BINDING = 0;
+	const GLuint CLUSTER_BUFFER_BINDING = 1;
+	const GLuint INDEX_BUFFER_BINDING = 2;
+
+	// lights are only assigned on worker threads when there are
+	// enough of them to pay for starting the threads
+	const size_t THREADED_LIGHT_COUNT = 64;
+
+	/***********************************************************
+	 *  UploadBuffer()
+	 *
+	 *  This function is used to replace the contents of a
+	 *  shader storage buffer.  A few bytes are always allocated
+	 *  so the buffer can be bound even when it has no data.
+	 ***********************************************************/
+	void UploadBuffer(GLuint buffer, GLuint binding, const void* data, size_t size)
+	{
+		glBindBuffer(GL_SHADER_STORAGE_BUFFER, buffer);
+		if (size > 0)
+		{
+			glBufferData(GL_SHADER_STORAGE_BUFFER, size, data, GL_DYNAMIC_DRAW);
+		}
+		else
+		{
+			glBufferData(GL_SHADER_STORAGE_BUFFER, 16, NULL, GL_DYNAMIC_DRAW);
+		}
+		glBindBufferBase(GL_SHADER_STORAGE_BUFFER, binding, buffer);
+	}
+
+	/***********************************************************
+	 *  BindStorageBlock()
+	 *
+	 *  This function is used to connect a storage block in a
+	 *  program to a buffer binding point.
+	 ***********************************************************/
+	void BindStorageBlock(GLuint program, const char* blockName, GLuint binding)
+	{
+		GLuint blockIndex = glGetProgramResourceIndex(program, GL_SHADER_STORAGE_BLOCK, blockName);
+		if (blockIndex != GL_INVALID_INDEX)
+		{
+			glShaderStorageBlockBinding(program, blockIndex, binding);
+		}
+	}
+}
+
+/***********************************************************
+ *  ClusteredLighting()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+ClusteredLighting::ClusteredLighting()
+{
+	m_lightBuffer = 0;
+	m_clusterBuffer = 0;
+	m_indexBuffer = 0;
+	m_boundsProjection = glm::mat4(1.0f);
+	m_bBoundsValid = false;
+	m_nearDepth = 0.1f;
+	m_farDepth = 100.0f;
+	m_viewportX = 0;
+	m_viewportY = 0;
+	m_viewportWidth = 1;
+	m_viewportHeight = 1;
+	m_assignTime = 0.0;
+}
+
+/***********************************************************
+ *  ~ClusteredLighting()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+ClusteredLighting::~ClusteredLighting()
+{
+	if (m_lightBuffer != 0)
+	{
+		glDeleteBuffers(1, &m_lightBuffer);
+		glDeleteBuffers(1, &m_clusterBuffer);
+		glDeleteBuffers(1, &m_indexBuffer);
+	}
+}
+
+/***********************************************************
+ *  IsSupported()
+ *
+ *  This method is used for checking whether the driver has
+ *  the shader storage buffers that clustered lighting needs.
+ ***********************************************************/
+bool ClusteredLighting::IsSupported()
+{
+	return(GLEW_ARB_shader_storage_buffer_object &&
+		(GLEW_VERSION_4_3 || GLEW_ARB_program_interface_query));
+}
+
+/***********************************************************
+ *  Initialize()
+ *
+ *  This method is used for creating the shader storage
+ *  buffers that the cluster grid is uploaded into.
+ ***********************************************************/
+bool ClusteredLighting::Initialize()
+{
+	if (IsSupported() == false)
+	{
+		return(false);
+	}
+
+	glGenBuffers(1, &m_lightBuffer);
+	glGenBuffers(1, &m_clusterBuffer);
+	glGenBuffers(1, &m_indexBuffer);
+
+	m_clusterRanges.resize(CLUSTER_COUNT);
+
+	return(true);
+}
+
+/***********************************************************
+ *  Update()
+ *
+ *  This method is used for assigning every light to the
+ *  clusters that its range reaches, and uploading the light
+ *  list, the cluster ranges and the light indices.  With
+ *  many lights the depth slices are shared out between
+ *  worker threads.
+ ***********************************************************/
+void ClusteredLighting::Update(
+	const std::vector<LIGHT_SOURCE>& lights,
+	const glm::mat4& view,
+	const glm::mat4& projection)
+{
+	std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+
+	if (m_lightBuffer == 0)
+	{
+		return;
+	}
+
+	// the tiles are sized to the viewport being rendered, which
+	// is smaller than the window with dynamic resolution, and
+	// placed from its corner, which is not the corner of the
+	// window when the views are drawn side by side
+	GLint viewport[4];
+	glGetIntegerv(GL_VIEWPORT, viewport);
+	m_viewportX = (int)viewport[0];
+	m_viewportY = (int)viewport[1];
+	m_viewportWidth = std::max(1, (int)viewport[2]);
+	m_viewportHeight = std::max(1, (int)viewport[3]);
+
+	if ((m_bBoundsValid == false) || (projection != m_boundsProjection))
+	{
+		ComputeClusterBounds(projection);
+	}
+
+	// pack the lights and find their view space bounds
+	m_packedLights.resize(lights.size());
+	m_viewLights.resize(lights.size());
+	for (size_t i = 0; i < lights.size(); i++)
+	{
+		const LIGHT_SOURCE& light = lights[i];
+		PACKED_LIGHT& packed = m_packedLights[i];
+		packed.positionRange = glm::vec4(light.position, light.range);
+		packed.directionType = glm::vec4(glm::normalize(light.direction), (float)light.type);
+		packed.ambientFocal = glm::vec4(light.ambientColor, light.focalStrength);
+		packed.diffuseIntensity = glm::vec4(light.diffuseColor, light.specularIntensity);
+		packed.specular = glm::vec4(light.specularColor, 0.0f);
+		packed.cone = glm::vec4(
+			std::cos(glm::radians(light.innerConeAngle)),
+			std::cos(glm::radians(light.outerConeAngle)),
+			0.0f, 0.0f);
+
+		VIEW_LIGHT& viewLight = m_viewLights[i];
+		viewLight.center = glm::vec3(view * glm::vec4(light.position, 1.0f));
+		viewLight.radius = light.range;
+		float depth = -viewLight.center.z;
+		if ((depth + light.range < m_nearDepth) || (depth - light.range > m_farDepth))
+		{
+			// the light is entirely in front of or behind the frustum
+			viewLight.firstSlice = 1;
+			viewLight.lastSlice = 0;
+		}
+		else
+		{
+			viewLight.firstSlice = GetDepthSlice(depth - light.range);
+			viewLight.lastSlice = GetDepthSlice(depth + light.range);
+		}
+	}
+
+	// find the clusters each light touches, sharing the lights
+	// out between threads that each collect their own hits
+	int threadCount = 1;
+	if (lights.size() >= THREADED_LIGHT_COUNT)
+	{
+		threadCount = std::max(1, (int)std::thread::hardware_concurrency());
+	}
+
+	m_threadHits.resize(threadCount);
+	std::vector<std::thread> workers;
+	for (int t = 0; t < threadCount; t++)
+	{
+		size_t firstLight = (lights.size() * t) / threadCount;
+		size_t endLight = (lights.size() * (t + 1)) / threadCount;
+		if (t == 0)
+		{
+			continue;
+		}
+		workers.push_back(std::thread(&ClusteredLighting::AssignLights, this,
+			firstLight, endLight, std::ref(m_threadHits[t])));
+	}
+	AssignLights(0, lights.size() / threadCount, m_threadHits[0]);
+	for (size_t t = 0; t < workers.size(); t++)
+	{
+		workers[t].join();
+	}
+
+	// sort the hits into a light index list per cluster, first
+	// counting the lights in each cluster to find its offset
+	for (int c = 0; c < CLUSTER_COUNT; c++)
+	{
+		m_clusterRanges[c] = glm::uvec2(0, 0);
+	}
+	size_t hitCount = 0;
+	for (int t = 0; t < threadCount; t++)
+	{
+		for (size_t i = 0; i < m_threadHits[t].size(); i++)
+		{
+			m_clusterRanges[m_threadHits[t][i].cluster].y++;
+		}
+		hitCount += m_threadHits[t].size();
+	}
+
+	GLuint offset = 0;
+	for (int c = 0; c < CLUSTER_COUNT; c++)
+	{
+		m_clusterRanges[c].x = offset;
+		offset += m_clusterRanges[c].y;
+	}
+
+	m_lightIndices.resize(hitCount);
+	std::vector<GLuint> writePosition(CLUSTER_COUNT);
+	for (int c = 0; c < CLUSTER_COUNT; c++)
+	{
+		writePosition[c] = m_clusterRanges[c].x;
+	}
+	for (int t = 0; t < threadCount; t++)
+	{
+		for (size_t i = 0; i < m_threadHits[t].size(); i++)
+		{
+			const CLUSTER_HIT& hit = m_threadHits[t][i];
+			m_lightIndices[writePosition[hit.cluster]++] = hit.light;
+		}
+	}
+
+	UploadBuffer(m_lightBuffer, LIGHT_BUFFER_BINDING,
+		m_packedLights.empty() ? NULL : &m_packedLights[0],
+		m_packedLights.size() * sizeof(PACKED_LIGHT));
+	UploadBuffer(m_clusterBuffer, CLUSTER_BUFFER_BINDING,
+		&m_clusterRanges[0],
+		m_clusterRanges.size() * sizeof(glm::uvec2));
+	UploadBuffer(m_indexBuffer, INDEX_BUFFER_BINDING,
+		m_lightIndices.empty() ? NULL : &m_lightIndices[0],
+		m_lightIndices.size() * sizeof(GLuint));
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+	m_assignTime = std::chrono::duration<double, std::milli>(
+		std::chrono::steady_clock::now() - startTime).count();
+}
+
+/***********************************************************
+ *  ApplyToProgram()
+ *
+ *  This method is used for connecting the storage buffers
+ *  to the passed in program and setting the uniforms that
+ *  map a fragment to its cluster.  The program must be the
+ *  one that is currently in use.
+ ***********************************************************/
+void ClusteredLighting::ApplyToProgram(GLuint program) const
+{
+	if ((m_lightBuffer == 0) || (program == 0))
+	{
+		return;
+	}
+
+	BindStorageBlock(program, "LightBuffer", LIGHT_BUFFER_BINDING);
+	BindStorageBlock(program, "ClusterBuffer", CLUSTER_BUFFER_BINDING);
+	BindStorageBlock(program, "LightIndexBuffer", INDEX_BUFFER_BINDING);
+
+	// slice = log(depth) * scale + bias, for slices that grow
+	// exponentially from the near plane to the far plane
+	float depthRatio = std::log(m_farDepth / m_nearDepth);
+	float depthScale = CLUSTER_COUNT_Z / depthRatio;
+	float depthBias = -CLUSTER_COUNT_Z * std::log(m_nearDepth) / depthRatio;
+
+	glUniform3i(glGetUniformLocation(program, "clusterCounts"),
+		CLUSTER_COUNT_X, CLUSTER_COUNT_Y, CLUSTER_COUNT_Z);
+	glUniform2f(glGetUniformLocation(program, "clusterTileScale"),
+		(float)CLUSTER_COUNT_X / m_viewportWidth,
+		(float)CLUSTER_COUNT_Y / m_viewportHeight);
+	glUniform2f(glGetUniformLocation(program, "clusterViewportOrigin"),
+		(float)m_viewportX, (float)m_viewportY);
+	glUniform1f(glGetUniformLocation(program, "clusterDepthScale"), depthScale);
+	glUniform1f(glGetUniformLocation(program, "clusterDepthBias"), depthBias);
+}
+
+/***********************************************************
+ *  GetAssignTime()
+ *
+ *  This method returns the time taken by the last update,
+ *  in milliseconds.
+ ***********************************************************/
+double ClusteredLighting::GetAssignTime() const
+{
+	return(m_assignTime);
+}
+
+/***********************************************************
+ *  GetAverageLightsPerCluster()
+ *
+ *  This method returns the average number of lights that
+ *  each cluster was assigned in the last update.
+ ***********************************************************/
+double ClusteredLighting::GetAverageLightsPerCluster() const
+{
+	return((double)m_lightIndices.size() / CLUSTER_COUNT);
+}
+
+/***********************************************************
+ *  ComputeClusterBounds()
+ *
+ *  This method is used for computing the view space bounds
+ *  of every cluster.  Each tile corner is unprojected into a
+ *  line through the frustum, which works for perspective and
+ *  orthographic projections alike, and the line is cut at
+ *  the depth of each slice boundary.
+ ***********************************************************/
+void ClusteredLighting::ComputeClusterBounds(const glm::mat4& projection)
+{
+	glm::mat4 inverseProjection = glm::inverse(projection);
+
+	// unproject a point in normalized device coordinates
+	struct CORNER_LINE
+	{
+		glm::vec3 nearPoint;
+		glm::vec3 farPoint;
+	};
+	const int cornerCountX = CLUSTER_COUNT_X + 1;
+	const int cornerCountY = CLUSTER_COUNT_Y + 1;
+	std::vector<CORNER_LINE> corners(cornerCountX * cornerCountY);
+	for (int y = 0; y < cornerCountY; y++)
+	{
+		for (int x = 0; x < cornerCountX; x++)
+		{
+			float ndcX = -1.0f + (2.0f * x) / CLUSTER_COUNT_X;
+			float ndcY = -1.0f + (2.0f * y) / CLUSTER_COUNT_Y;
+			glm::vec4 nearPoint = inverseProjection * glm::vec4(ndcX, ndcY, -1.0f, 1.0f);
+			glm::vec4 farPoint = inverseProjection * glm::vec4(ndcX, ndcY, 1.0f, 1.0f);
+			corners[y * cornerCountX + x].nearPoint = glm::vec3(nearPoint) / nearPoint.w;
+			corners[y * cornerCountX + x].farPoint = glm::vec3(farPoint) / farPoint.w;
+		}
+	}
+
+	// the depth range of the frustum, from its center line
+	glm::vec4 nearCenter = inverseProjection * glm::vec4(0.0f, 0.0f, -1.0f, 1.0f);
+	glm::vec4 farCenter = inverseProjection * glm::vec4(0.0f, 0.0f, 1.0f, 1.0f);
+	m_nearDepth = std::max(-nearCenter.z / nearCenter.w, 0.001f);
+	m_farDepth = std::max(-farCenter.z / farCenter.w, m_nearDepth * 2.0f);
+
+	m_clusterBounds.resize(CLUSTER_COUNT);
+	m_columnBounds.resize(CLUSTER_COUNT_Z * CLUSTER_COUNT_X);
+	m_rowBounds.resize(CLUSTER_COUNT_Z * CLUSTER_COUNT_Y);
+	for (int z = 0; z < CLUSTER_COUNT_Z; z++)
+	{
+		float sliceNear = m_nearDepth * std::pow(m_farDepth / m_nearDepth, (float)z / CLUSTER_COUNT_Z);
+		float sliceFar = m_nearDepth * std::pow(m_farDepth / m_nearDepth, (float)(z + 1) / CLUSTER_COUNT_Z);
+
+		for (int y = 0; y < CLUSTER_COUNT_Y; y++)
+		{
+			for (int x = 0; x < CLUSTER_COUNT_X; x++)
+			{
+				CLUSTER_BOUNDS& bounds = m_clusterBounds[(z * CLUSTER_COUNT_Y + y) * CLUSTER_COUNT_X + x];
+				bounds.minimum = glm::vec3(1.0e30f);
+				bounds.maximum = glm::vec3(-1.0e30f);
+
+				CLUSTER_BOUNDS& column = m_columnBounds[z * CLUSTER_COUNT_X + x];
+				CLUSTER_BOUNDS& row = m_rowBounds[z * CLUSTER_COUNT_Y + y];
+				if (y == 0)
+				{
+					column = bounds;
+				}
+				if (x == 0)
+				{
+					row = bounds;
+				}
+
+				for (int corner = 0; corner < 4; corner++)
+				{
+					const CORNER_LINE& line = corners[(y + corner / 2) * cornerCountX + x + corner % 2];
+					glm::vec3 direction = line.farPoint - line.nearPoint;
+					for (int side = 0; side < 2; side++)
+					{
+						float depth = (side == 0) ? sliceNear : sliceFar;
+						float t = (-depth - line.nearPoint.z) / direction.z;
+						glm::vec3 point = line.nearPoint + direction * t;
+						bounds.minimum = glm::min(bounds.minimum, point);
+						bounds.maximum = glm::max(bounds.maximum, point);
+					}
+				}
+
+				column.minimum = glm::min(column.minimum, bounds.minimum);
+				column.maximum = glm::max(column.maximum, bounds.maximum);
+				row.minimum = glm::min(row.minimum, bounds.minimum);
+				row.maximum = glm::max(row.maximum, bounds.maximum);
+			}
+		}
+	}
+
+	m_boundsProjection = projection;
+	m_bBoundsValid = true;
+}
+
+/***********************************************************
+ *  GetDepthSlice()
+ *
+ *  This method is used for getting the depth slice that a
+ *  view space depth falls into, clamped to the grid.
+ ***********************************************************/
+int ClusteredLighting::GetDepthSlice(float depth) const
+{
+	if (depth <= m_nearDepth)
+	{
+		return(0);
+	}
+	int slice = (int)std::floor(std::log(depth / m_nearDepth) /
+		std::log(m_farDepth / m_nearDepth) * CLUSTER_COUNT_Z);
+	return(std::min(std::max(slice, 0), CLUSTER_COUNT_Z - 1));
+}
+
+/***********************************************************
+ *  AssignLights()
+ *
+ *  This method is used for finding the clusters touched by
+ *  a range of lights.  For each depth slice a light reaches,
+ *  it is narrowed down to the columns and rows of clusters
+ *  it touches, and then tested against each cluster in that
+ *  rectangle, so lights are only tested where they might be.
+ ***********************************************************/
+void ClusteredLighting::AssignLights(size_t firstLight, size_t endLight, std::vector<CLUSTER_HIT>& hits)
+{
+	hits.clear();
+
+	for (size_t i = firstLight; i < endLight; i++)
+	{
+		const VIEW_LIGHT& light = m_viewLights[i];
+
+		for (int z = light.firstSlice; z <= light.lastSlice; z++)
+		{
+			int firstX = CLUSTER_COUNT_X;
+			int lastX = -1;
+			for (int x = 0; x < CLUSTER_COUNT_X; x++)
+			{
+				if (SphereTouchesBounds(light, m_columnBounds[z * CLUSTER_COUNT_X + x]))
+				{
+					firstX = std::min(firstX, x);
+					lastX = x;
+				}
+			}
+			int firstY = CLUSTER_COUNT_Y;
+			int lastY = -1;
+			for (int y = 0; y < CLUSTER_COUNT_Y; y++)
+			{
+				if (SphereTouchesBounds(light, m_rowBounds[z * CLUSTER_COUNT_Y + y]))
+				{
+					firstY = std::min(firstY, y);
+					lastY = y;
+				}
+			}
+
+			for (int y = firstY; y <= lastY; y++)
+			{
+				for (int x = firstX; x <= lastX; x++)
+				{
+					int cluster = (z * CLUSTER_COUNT_Y + y) * CLUSTER_COUNT_X + x;
+					if (SphereTouchesBounds(light, m_clusterBounds[cluster]))
+					{
+						CLUSTER_HIT hit;
+						hit.cluster = (GLuint)cluster;
+						hit.light = (GLuint)i;
+						hits.push_back(hit);
+					}
+				}
+			}
+		}
+	}
+}
+
+/***********************************************************
+ *  SphereTouchesBounds()
+ *
+ *  This method is used for checking whether the sphere of a
+ *  light's range touches a box in view space.
+ ***********************************************************/
+bool ClusteredLighting::SphereTouchesBounds(const VIEW_LIGHT& light, const CLUSTER_BOUNDS& bounds)
+{
+	glm::vec3 closest = glm::clamp(light.center, bounds.minimum, bounds.maximum);
+	glm::vec3 offsetToLight = light.center - closest;
+	return(glm::dot(offsetToLight, offsetToLight) <= light.radius * light.radius);
+}
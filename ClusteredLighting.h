@@ -0,0 +1,183 @@
+///////////////////////////////////////////////////////////////////////////////
+// clusteredlighting.h
+// ============
+// divide the view frustum into clusters and assign the scene lights to
+// the clusters they reach, so each fragment only shades nearby lights
+//
+//  Created for CS-330-Computational Graphics and Visualization
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+#include <vector>
+
+/***********************************************************
+ *  LIGHT_SOURCE
+ *
+ *  A point or spot light in the scene.  The light fades out
+ *  to nothing at its range, which is what lets it be culled
+ *  from the clusters it cannot reach.
+ ***********************************************************/
+struct LIGHT_SOURCE
+{
+	enum LIGHT_TYPE
+	{
+		LIGHT_POINT = 0,
+		LIGHT_SPOT
+	};
+
+	LIGHT_TYPE type;
+	glm::vec3 position;
+	// direction the spot light points in
+	glm::vec3 direction;
+	// distance at which the light has faded out completely
+	float range;
+	// spot light cone angles in degrees, full intensity inside
+	// the inner angle fading to none at the outer angle
+	float innerConeAngle;
+	float outerConeAngle;
+	glm::vec3 ambientColor;
+	glm::vec3 diffuseColor;
+	glm::vec3 specularColor;
+	float focalStrength;
+	float specularIntensity;
+};
+
+/***********************************************************
+ *  ClusteredLighting
+ *
+ *  This class contains the code for building the light
+ *  cluster grid on the CPU each frame and uploading it in
+ *  shader storage buffers:
+ *
+ *    the light list, packed for std430
+ *    an offset and count into the index list per cluster
+ *    the light index list for all clusters
+ *
+ *  Clusters are screen tiles split into depth slices that
+ *  grow exponentially with distance from the camera.
+ ***********************************************************/
+class ClusteredLighting
+{
+public:
+	// number of clusters across, down and into the screen
+	static const int CLUSTER_COUNT_X = 16;
+	static const int CLUSTER_COUNT_Y = 9;
+	static const int CLUSTER_COUNT_Z = 24;
+
+	// constructor
+	ClusteredLighting();
+	// destructor
+	~ClusteredLighting();
+
+	// check whether the driver supports shader storage buffers
+	static bool IsSupported();
+
+	// create the shader storage buffers
+	bool Initialize();
+
+	// assign the lights to the clusters of the passed in view
+	// and upload the results, sized to the current viewport
+	void Update(
+		const std::vector<LIGHT_SOURCE>& lights,
+		const glm::mat4& view,
+		const glm::mat4& projection);
+
+	// bind the buffers and set the cluster uniforms into the
+	// passed in program
+	void ApplyToProgram(GLuint program) const;
+
+	// time taken by the last light assignment, in milliseconds
+	double GetAssignTime() const;
+	// average number of lights per cluster in the last update
+	double GetAverageLightsPerCluster() const;
+
+private:
+	// total number of clusters in the grid
+	static const int CLUSTER_COUNT = CLUSTER_COUNT_X * CLUSTER_COUNT_Y * CLUSTER_COUNT_Z;
+
+	// light layout in the light buffer, matching the std430
+	// PackedLight struct in the fragment shader
+	struct PACKED_LIGHT
+	{
+		// xyz position, w range
+		glm::vec4 positionRange;
+		// xyz spot direction, w light type
+		glm::vec4 directionType;
+		// rgb ambient color, w focal strength
+		glm::vec4 ambientFocal;
+		// rgb diffuse color, w specular intensity
+		glm::vec4 diffuseIntensity;
+		// rgb specular color
+		glm::vec4 specular;
+		// x cosine of the inner cone angle, y of the outer
+		glm::vec4 cone;
+	};
+
+	// view space bounds of one cluster
+	struct CLUSTER_BOUNDS
+	{
+		glm::vec3 minimum;
+		glm::vec3 maximum;
+	};
+
+	// light bounds in view space, used for the assignment
+	struct VIEW_LIGHT
+	{
+		glm::vec3 center;
+		float radius;
+		int firstSlice;
+		int lastSlice;
+	};
+
+	// a light found to touch a cluster
+	struct CLUSTER_HIT
+	{
+		GLuint cluster;
+		GLuint light;
+	};
+
+	// light list, cluster ranges and light index buffers
+	GLuint m_lightBuffer;
+	GLuint m_clusterBuffer;
+	GLuint m_indexBuffer;
+
+	// projection the cluster bounds were computed for
+	glm::mat4 m_boundsProjection;
+	bool m_bBoundsValid;
+	std::vector<CLUSTER_BOUNDS> m_clusterBounds;
+	// bounds of each column and row of clusters within a slice
+	std::vector<CLUSTER_BOUNDS> m_columnBounds;
+	std::vector<CLUSTER_BOUNDS> m_rowBounds;
+	// view space depth of the near and far planes
+	float m_nearDepth;
+	float m_farDepth;
+
+	// offset and count into the index list for each cluster
+	std::vector<glm::uvec2> m_clusterRanges;
+	std::vector<GLuint> m_lightIndices;
+	std::vector<PACKED_LIGHT> m_packedLights;
+	std::vector<VIEW_LIGHT> m_viewLights;
+	// clusters touched by the lights, collected per thread
+	std::vector< std::vector<CLUSTER_HIT> > m_threadHits;
+
+	// viewport the clusters were sized for
+	int m_viewportX;
+	int m_viewportY;
+	int m_viewportWidth;
+	int m_viewportHeight;
+
+	double m_assignTime;
+
+	// compute the view space bounds of every cluster
+	void ComputeClusterBounds(const glm::mat4& projection);
+	// get the depth slice holding a view space depth
+	int GetDepthSlice(float depth) const;
+	// find the clusters touched by a range of lights
+	void AssignLights(size_t firstLight, size_t endLight, std::vector<CLUSTER_HIT>& hits);
+	// check whether the sphere of a light's range touches a box
+	static bool SphereTouchesBounds(const VIEW_LIGHT& light, const CLUSTER_BOUNDS& bounds);
+};
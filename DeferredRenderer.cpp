@@ -0,0 +1,476 @@
+///////////////////////////////////////////////////////////////////////////////
+// deferredrenderer.cpp
+// ============
+// render the opaque scene objects into a packed G-buffer, then light
+// every pixel once with the lights gathered per screen tile
+//
+//  Created for CS-330-Computational Graphics and Visualization
+///////////////////////////////////////////////////////////////////////////////
+
+#include "DeferredRenderer.h"
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+// declaration of the global variables and defines
+namespace
+{
+	// shader storage buffer binding points, kept apart from the
+	// ones used by ClusteredLighting
+	const GLuint LIGHT_BUFFER_BINDING = 3;
+	const GLuint MATERIAL_BUFFER_BINDING = 4;
+	// texture units the G-buffer is read from, above the 16
+	// slots used by the scene textures
+	const GLuint ALBEDO_TEXTURE_UNIT = 16;
+	const GLuint NORMAL_TEXTURE_UNIT = 17;
+	const GLuint DEPTH_TEXTURE_UNIT = 18;
+	// image unit the lit image is written to
+	const GLuint OUTPUT_IMAGE_UNIT = 0;
+
+	/***********************************************************
+	 *  ReadSourceFile()
+	 *
+	 *  This function is used to read a whole shader source
+	 *  file into a string.
+	 ***********************************************************/
+	bool ReadSourceFile(const char* filePath, std::string& source)
+	{
+		std::ifstream file(filePath);
+		if (!file.is_open())
+		{
+			std::cout << "ERROR::SHADER_FILE_NOT_READ: " << filePath << std::endl;
+			return(false);
+		}
+
+		std::stringstream stream;
+		stream << file.rdbuf();
+		source = stream.str();
+		return(true);
+	}
+
+	/***********************************************************
+	 *  CreateTexture()
+	 *
+	 *  This function is used to allocate one G-buffer texture,
+	 *  read with texelFetch so it needs no filtering.
+	 ***********************************************************/
+	GLuint CreateTexture(GLenum internalFormat, GLenum format, GLenum type, int width, int height)
+	{
+		GLuint texture = 0;
+		glGenTextures(1, &texture);
+		glBindTexture(GL_TEXTURE_2D, texture);
+		glTexImage2D(GL_TEXTURE_2D, 0, internalFormat, width, height, 0, format, type, NULL);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+		glBindTexture(GL_TEXTURE_2D, 0);
+		return(texture);
+	}
+
+	/***********************************************************
+	 *  UploadBuffer()
+	 *
+	 *  This function is used to replace the contents of a
+	 *  shader storage buffer.  A few bytes are always allocated
+	 *  so the buffer can be bound even when it has no data.
+	 ***********************************************************/
+	void UploadBuffer(GLuint buffer, GLuint binding, const void* data, size_t size)
+	{
+		glBindBuffer(GL_SHADER_STORAGE_BUFFER, buffer);
+		if (size > 0)
+		{
+			glBufferData(GL_SHADER_STORAGE_BUFFER, size, data, GL_DYNAMIC_DRAW);
+		}
+		else
+		{
+			glBufferData(GL_SHADER_STORAGE_BUFFER, 16, NULL, GL_DYNAMIC_DRAW);
+		}
+		glBindBufferBase(GL_SHADER_STORAGE_BUFFER, binding, buffer);
+		glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+	}
+}
+
+/***********************************************************
+ *  DeferredRenderer()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+DeferredRenderer::DeferredRenderer()
+{
+	m_geometryFramebuffer = 0;
+	m_albedoTexture = 0;
+	m_normalTexture = 0;
+	m_depthTexture = 0;
+	m_outputFramebuffer = 0;
+	m_outputTexture = 0;
+	m_bufferWidth = 0;
+	m_bufferHeight = 0;
+	m_renderWidth = 0;
+	m_renderHeight = 0;
+	m_savedFramebuffer = 0;
+	for (int i = 0; i < 4; i++)
+	{
+		m_savedViewport[i] = 0;
+	}
+	m_lightingProgram = 0;
+	m_lightBuffer = 0;
+	m_materialBuffer = 0;
+}
+
+/***********************************************************
+ *  ~DeferredRenderer()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+DeferredRenderer::~DeferredRenderer()
+{
+	DestroyBuffers();
+	if (0 != m_lightingProgram)
+	{
+		glDeleteProgram(m_lightingProgram);
+		m_lightingProgram = 0;
+	}
+	if (0 != m_lightBuffer)
+	{
+		glDeleteBuffers(1, &m_lightBuffer);
+		glDeleteBuffers(1, &m_materialBuffer);
+		m_lightBuffer = 0;
+		m_materialBuffer = 0;
+	}
+}
+
+/***********************************************************
+ *  IsSupported()
+ *
+ *  This method is used for checking whether the driver has
+ *  the compute shaders, storage buffers and image stores
+ *  that the lighting pass needs.
+ ***********************************************************/
+bool DeferredRenderer::IsSupported()
+{
+	return(GLEW_VERSION_4_3);
+}
+
+/***********************************************************
+ *  Initialize()
+ *
+ *  This method is used for compiling the lighting compute
+ *  shader and creating its storage buffers.  The G-buffer
+ *  is allocated by the first geometry pass.
+ ***********************************************************/
+bool DeferredRenderer::Initialize(const char* lightingShaderPath)
+{
+	if (IsSupported() == false)
+	{
+		std::cout << "INFO: Compute shaders are not supported, using forward shading" << std::endl;
+		return(false);
+	}
+
+	std::string source;
+	if (ReadSourceFile(lightingShaderPath, source) == false)
+	{
+		return(false);
+	}
+
+	const char* sourceText = source.c_str();
+	GLuint computeShader = glCreateShader(GL_COMPUTE_SHADER);
+	glShaderSource(computeShader, 1, &sourceText, NULL);
+	glCompileShader(computeShader);
+
+	GLint success = 0;
+	glGetShaderiv(computeShader, GL_COMPILE_STATUS, &success);
+	if (!success)
+	{
+		char infoLog[1024];
+		glGetShaderInfoLog(computeShader, 1024, NULL, infoLog);
+		std::cout << "ERROR::SHADER_COMPILATION_ERROR\n" << infoLog << std::endl;
+		glDeleteShader(computeShader);
+		return(false);
+	}
+
+	m_lightingProgram = glCreateProgram();
+	glAttachShader(m_lightingProgram, computeShader);
+	glLinkProgram(m_lightingProgram);
+	glDeleteShader(computeShader);
+
+	glGetProgramiv(m_lightingProgram, GL_LINK_STATUS, &success);
+	if (!success)
+	{
+		char infoLog[1024];
+		glGetProgramInfoLog(m_lightingProgram, 1024, NULL, infoLog);
+		std::cout << "ERROR::PROGRAM_LINKING_ERROR\n" << infoLog << std::endl;
+		glDeleteProgram(m_lightingProgram);
+		m_lightingProgram = 0;
+		return(false);
+	}
+
+	glGenBuffers(1, &m_lightBuffer);
+	glGenBuffers(1, &m_materialBuffer);
+
+	return(true);
+}
+
+/***********************************************************
+ *  SetMaterials()
+ *
+ *  This method is used for uploading the materials that the
+ *  G-buffer material indices refer to.  Index zero is kept
+ *  for surfaces without a material, so an index of one
+ *  refers to the first material.
+ ***********************************************************/
+void DeferredRenderer::SetMaterials(const std::vector<DEFERRED_MATERIAL>& materials)
+{
+	if (m_materialBuffer == 0)
+	{
+		return;
+	}
+
+	size_t materialCount = std::min(materials.size(), (size_t)MAX_MATERIAL_COUNT);
+	std::vector<PACKED_MATERIAL> packedMaterials(materialCount);
+	for (size_t i = 0; i < materialCount; i++)
+	{
+		const DEFERRED_MATERIAL& material = materials[i];
+		packedMaterials[i].ambient = glm::vec4(material.ambientColor, material.ambientStrength);
+		packedMaterials[i].diffuse = glm::vec4(material.diffuseColor, 0.0f);
+		packedMaterials[i].specular = glm::vec4(material.specularColor, material.shininess);
+	}
+
+	UploadBuffer(m_materialBuffer, MATERIAL_BUFFER_BINDING,
+		packedMaterials.empty() ? NULL : &packedMaterials[0],
+		packedMaterials.size() * sizeof(PACKED_MATERIAL));
+}
+
+/***********************************************************
+ *  BeginGeometryPass()
+ *
+ *  This method is called before the opaque objects are
+ *  drawn.  It remembers the framebuffer and viewport being
+ *  rendered to, binds the G-buffer at the same size and
+ *  clears it.  Returns false when the G-buffer could not be
+ *  allocated, and the objects should be drawn forward.
+ ***********************************************************/
+bool DeferredRenderer::BeginGeometryPass()
+{
+	glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &m_savedFramebuffer);
+	glGetIntegerv(GL_VIEWPORT, m_savedViewport);
+
+	m_renderWidth = std::max(1, (int)m_savedViewport[2]);
+	m_renderHeight = std::max(1, (int)m_savedViewport[3]);
+	if ((m_renderWidth > m_bufferWidth) || (m_renderHeight > m_bufferHeight))
+	{
+		CreateBuffers(
+			std::max(m_renderWidth, m_bufferWidth),
+			std::max(m_renderHeight, m_bufferHeight));
+	}
+	if ((m_geometryFramebuffer == 0) || (m_lightingProgram == 0))
+	{
+		return(false);
+	}
+
+	glBindFramebuffer(GL_FRAMEBUFFER, m_geometryFramebuffer);
+	glViewport(0, 0, m_renderWidth, m_renderHeight);
+
+	// clear the attachments without changing the clear color
+	// that the rest of the frame uses
+	const GLfloat clearColor[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+	glClearBufferfv(GL_COLOR, 0, clearColor);
+	glClearBufferfv(GL_COLOR, 1, clearColor);
+	glClearBufferfi(GL_DEPTH_STENCIL, 0, 1.0f, 0);
+
+	return(true);
+}
+
+/***********************************************************
+ *  EndGeometryPass()
+ *
+ *  This method is called after the opaque objects are drawn
+ *  into the G-buffer.  The lighting compute shader shades
+ *  every covered pixel with the lights of its tile, and the
+ *  lit image and depth are copied to the framebuffer that
+ *  was bound before, so transparent objects can be drawn
+ *  over them as usual.
+ ***********************************************************/
+void DeferredRenderer::EndGeometryPass(
+	const std::vector<LIGHT_SOURCE>& lights,
+	const glm::mat4& view,
+	const glm::mat4& projection,
+	const glm::vec3& viewPosition,
+	const glm::vec3& ambientLight,
+	bool bUseLighting)
+{
+	if ((m_lightingProgram == 0) || (m_geometryFramebuffer == 0))
+	{
+		glBindFramebuffer(GL_FRAMEBUFFER, m_savedFramebuffer);
+		glViewport(m_savedViewport[0], m_savedViewport[1], m_savedViewport[2], m_savedViewport[3]);
+		return;
+	}
+
+	// pack the lights in the same layout ClusteredLighting uses
+	m_packedLights.resize(lights.size());
+	for (size_t i = 0; i < lights.size(); i++)
+	{
+		const LIGHT_SOURCE& light = lights[i];
+		PACKED_LIGHT& packed = m_packedLights[i];
+		packed.positionRange = glm::vec4(light.position, light.range);
+		packed.directionType = glm::vec4(glm::normalize(light.direction), (float)light.type);
+		packed.ambientFocal = glm::vec4(light.ambientColor, light.focalStrength);
+		packed.diffuseIntensity = glm::vec4(light.diffuseColor, light.specularIntensity);
+		packed.specular = glm::vec4(light.specularColor, 0.0f);
+		packed.cone = glm::vec4(
+			std::cos(glm::radians(light.innerConeAngle)),
+			std::cos(glm::radians(light.outerConeAngle)),
+			0.0f, 0.0f);
+	}
+	UploadBuffer(m_lightBuffer, LIGHT_BUFFER_BINDING,
+		m_packedLights.empty() ? NULL : &m_packedLights[0],
+		m_packedLights.size() * sizeof(PACKED_LIGHT));
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, MATERIAL_BUFFER_BINDING, m_materialBuffer);
+
+	// pixels that no object covered get the frame's clear color
+	GLfloat backgroundColor[4];
+	glGetFloatv(GL_COLOR_CLEAR_VALUE, backgroundColor);
+
+	GLint savedProgram = 0;
+	GLint activeTexture = GL_TEXTURE0;
+	glGetIntegerv(GL_CURRENT_PROGRAM, &savedProgram);
+	glGetIntegerv(GL_ACTIVE_TEXTURE, &activeTexture);
+
+	glActiveTexture(GL_TEXTURE0 + ALBEDO_TEXTURE_UNIT);
+	glBindTexture(GL_TEXTURE_2D, m_albedoTexture);
+	glActiveTexture(GL_TEXTURE0 + NORMAL_TEXTURE_UNIT);
+	glBindTexture(GL_TEXTURE_2D, m_normalTexture);
+	glActiveTexture(GL_TEXTURE0 + DEPTH_TEXTURE_UNIT);
+	glBindTexture(GL_TEXTURE_2D, m_depthTexture);
+	glActiveTexture(activeTexture);
+	glBindImageTexture(OUTPUT_IMAGE_UNIT, m_outputTexture, 0, GL_FALSE, 0, GL_WRITE_ONLY, GL_RGBA8);
+
+	glUseProgram(m_lightingProgram);
+	glUniform1i(glGetUniformLocation(m_lightingProgram, "albedoMaterialTexture"), ALBEDO_TEXTURE_UNIT);
+	glUniform1i(glGetUniformLocation(m_lightingProgram, "normalTexture"), NORMAL_TEXTURE_UNIT);
+	glUniform1i(glGetUniformLocation(m_lightingProgram, "depthTexture"), DEPTH_TEXTURE_UNIT);
+	glUniform1i(glGetUniformLocation(m_lightingProgram, "outputImage"), OUTPUT_IMAGE_UNIT);
+	glUniform1i(glGetUniformLocation(m_lightingProgram, "lightCount"), (GLint)lights.size());
+	glUniform2i(glGetUniformLocation(m_lightingProgram, "renderSize"), m_renderWidth, m_renderHeight);
+	glUniformMatrix4fv(glGetUniformLocation(m_lightingProgram, "view"), 1, GL_FALSE, &view[0][0]);
+	glm::mat4 inverseProjection = glm::inverse(projection);
+	glm::mat4 inverseView = glm::inverse(view);
+	glUniformMatrix4fv(glGetUniformLocation(m_lightingProgram, "inverseProjection"), 1, GL_FALSE, &inverseProjection[0][0]);
+	glUniformMatrix4fv(glGetUniformLocation(m_lightingProgram, "inverseView"), 1, GL_FALSE, &inverseView[0][0]);
+	glUniform3f(glGetUniformLocation(m_lightingProgram, "viewPosition"), viewPosition.x, viewPosition.y, viewPosition.z);
+	glUniform3f(glGetUniformLocation(m_lightingProgram, "ambientLight"), ambientLight.x, ambientLight.y, ambientLight.z);
+	glUniform1i(glGetUniformLocation(m_lightingProgram, "bUseLighting"), bUseLighting ? 1 : 0);
+	glUniform4fv(glGetUniformLocation(m_lightingProgram, "backgroundColor"), 1, backgroundColor);
+
+	glDispatchCompute(
+		(m_renderWidth + TILE_SIZE - 1) / TILE_SIZE,
+		(m_renderHeight + TILE_SIZE - 1) / TILE_SIZE,
+		1);
+	// the lit image is read by the framebuffer copy below
+	glMemoryBarrier(GL_FRAMEBUFFER_BARRIER_BIT);
+
+	glUseProgram(savedProgram);
+
+	// copy the lit image and the depth into the place the frame
+	// was being rendered to.  the depth formats match the window
+	// and the dynamic resolution buffer, as the copy requires
+	glBindFramebuffer(GL_READ_FRAMEBUFFER, m_outputFramebuffer);
+	glBindFramebuffer(GL_DRAW_FRAMEBUFFER, m_savedFramebuffer);
+	glBlitFramebuffer(
+		0, 0, m_renderWidth, m_renderHeight,
+		m_savedViewport[0], m_savedViewport[1],
+		m_savedViewport[0] + m_renderWidth, m_savedViewport[1] + m_renderHeight,
+		GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT, GL_NEAREST);
+
+	glBindFramebuffer(GL_FRAMEBUFFER, m_savedFramebuffer);
+	glViewport(m_savedViewport[0], m_savedViewport[1], m_savedViewport[2], m_savedViewport[3]);
+}
+
+/***********************************************************
+ *  CreateBuffers()
+ *
+ *  This method is used for allocating the G-buffer and the
+ *  lit output image.  The frame is rendered into the lower
+ *  left part of them, like the dynamic resolution buffer.
+ ***********************************************************/
+bool DeferredRenderer::CreateBuffers(int width, int height)
+{
+	DestroyBuffers();
+
+	if ((width <= 0) || (height <= 0))
+	{
+		return(false);
+	}
+
+	m_albedoTexture = CreateTexture(GL_RGBA8, GL_RGBA, GL_UNSIGNED_BYTE, width, height);
+	m_normalTexture = CreateTexture(GL_RG16, GL_RG, GL_UNSIGNED_SHORT, width, height);
+	m_depthTexture = CreateTexture(GL_DEPTH24_STENCIL8, GL_DEPTH_STENCIL, GL_UNSIGNED_INT_24_8, width, height);
+	m_outputTexture = CreateTexture(GL_RGBA8, GL_RGBA, GL_UNSIGNED_BYTE, width, height);
+
+	glGenFramebuffers(1, &m_geometryFramebuffer);
+	glBindFramebuffer(GL_FRAMEBUFFER, m_geometryFramebuffer);
+	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, m_albedoTexture, 0);
+	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT1, GL_TEXTURE_2D, m_normalTexture, 0);
+	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_TEXTURE_2D, m_depthTexture, 0);
+	const GLenum drawBuffers[2] = { GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1 };
+	glDrawBuffers(2, drawBuffers);
+	GLenum geometryStatus = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+
+	glGenFramebuffers(1, &m_outputFramebuffer);
+	glBindFramebuffer(GL_FRAMEBUFFER, m_outputFramebuffer);
+	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, m_outputTexture, 0);
+	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_TEXTURE_2D, m_depthTexture, 0);
+	GLenum outputStatus = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+	glBindFramebuffer(GL_FRAMEBUFFER, m_savedFramebuffer);
+
+	if ((geometryStatus != GL_FRAMEBUFFER_COMPLETE) || (outputStatus != GL_FRAMEBUFFER_COMPLETE))
+	{
+		std::cout << "G-buffer framebuffer is incomplete: " << geometryStatus << ", " << outputStatus << std::endl;
+		DestroyBuffers();
+		return(false);
+	}
+
+	m_bufferWidth = width;
+	m_bufferHeight = height;
+
+	return(true);
+}
+
+/***********************************************************
+ *  DestroyBuffers()
+ *
+ *  This method is used for freeing the G-buffer and the lit
+ *  output image.
+ ***********************************************************/
+void DeferredRenderer::DestroyBuffers()
+{
+	if (0 != m_geometryFramebuffer)
+	{
+		glDeleteFramebuffers(1, &m_geometryFramebuffer);
+		m_geometryFramebuffer = 0;
+	}
+	if (0 != m_outputFramebuffer)
+	{
+		glDeleteFramebuffers(1, &m_outputFramebuffer);
+		m_outputFramebuffer = 0;
+	}
+
+	GLuint textures[4] = { m_albedoTexture, m_normalTexture, m_depthTexture, m_outputTexture };
+	for (int i = 0; i < 4; i++)
+	{
+		if (0 != textures[i])
+		{
+			glDeleteTextures(1, &textures[i]);
+		}
+	}
+	m_albedoTexture = 0;
+	m_normalTexture = 0;
+	m_depthTexture = 0;
+	m_outputTexture = 0;
+
+	m_bufferWidth = 0;
+	m_bufferHeight = 0;
+}
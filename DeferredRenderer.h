@@ -0,0 +1,144 @@
+///////////////////////////////////////////////////////////////////////////////
+// deferredrenderer.h
+// ============
+// render the opaque scene objects into a packed G-buffer, then light
+// every pixel once with the lights gathered per screen tile
+//
+//  Created for CS-330-Computational Graphics and Visualization
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "ClusteredLighting.h"
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+#include <string>
+#include <vector>
+
+/***********************************************************
+ *  DeferredRenderer
+ *
+ *  This class contains the code for the deferred shading
+ *  path.  The geometry pass writes each pixel's surface into
+ *  a G-buffer of 12 bytes per pixel:
+ *
+ *    RGBA8   albedo color, material index in alpha
+ *    RG16    octahedral encoded world space normal
+ *    D24S8   depth, also used to rebuild the position
+ *
+ *  A compute shader then splits the screen into tiles, finds
+ *  the lights that reach the depth range of each tile, and
+ *  shades each pixel with only those lights.  The lighting
+ *  cost no longer depends on how many surfaces overlap.
+ ***********************************************************/
+class DeferredRenderer
+{
+public:
+	// material properties the lighting pass can look up by the
+	// index stored in the G-buffer
+	struct DEFERRED_MATERIAL
+	{
+		glm::vec3 ambientColor;
+		float ambientStrength;
+		glm::vec3 diffuseColor;
+		glm::vec3 specularColor;
+		float shininess;
+	};
+
+	// width and height of a lighting tile in pixels, matching the
+	// work group size of the lighting compute shader
+	static const int TILE_SIZE = 16;
+	// the material index is stored in 8 bits, and zero is kept
+	// for surfaces without a material
+	static const int MAX_MATERIAL_COUNT = 255;
+
+	// constructor
+	DeferredRenderer();
+	// destructor
+	~DeferredRenderer();
+
+	// check whether the driver supports compute shaders
+	static bool IsSupported();
+
+	// build the lighting compute shader from the passed in file
+	bool Initialize(const char* lightingShaderPath);
+	// set the materials that G-buffer material indices refer to
+	void SetMaterials(const std::vector<DEFERRED_MATERIAL>& materials);
+
+	// redirect the rendering into the G-buffer, sized to the
+	// current viewport
+	bool BeginGeometryPass();
+	// light the G-buffer and copy the result and its depth into
+	// the framebuffer that was bound before the geometry pass
+	void EndGeometryPass(
+		const std::vector<LIGHT_SOURCE>& lights,
+		const glm::mat4& view,
+		const glm::mat4& projection,
+		const glm::vec3& viewPosition,
+		const glm::vec3& ambientLight,
+		bool bUseLighting);
+
+private:
+	// light layout in the light buffer, matching the std430
+	// PackedLight struct in the lighting shader
+	struct PACKED_LIGHT
+	{
+		// xyz position, w range
+		glm::vec4 positionRange;
+		// xyz spot direction, w light type
+		glm::vec4 directionType;
+		// rgb ambient color, w focal strength
+		glm::vec4 ambientFocal;
+		// rgb diffuse color, w specular intensity
+		glm::vec4 diffuseIntensity;
+		// rgb specular color
+		glm::vec4 specular;
+		// x cosine of the inner cone angle, y of the outer
+		glm::vec4 cone;
+	};
+
+	// material layout in the material buffer
+	struct PACKED_MATERIAL
+	{
+		// rgb ambient color, w ambient strength
+		glm::vec4 ambient;
+		// rgb diffuse color
+		glm::vec4 diffuse;
+		// rgb specular color, w shininess
+		glm::vec4 specular;
+	};
+
+	// G-buffer framebuffer and its textures
+	GLuint m_geometryFramebuffer;
+	GLuint m_albedoTexture;
+	GLuint m_normalTexture;
+	GLuint m_depthTexture;
+	// lit image written by the lighting pass, with the G-buffer
+	// depth attached so both are copied out together
+	GLuint m_outputFramebuffer;
+	GLuint m_outputTexture;
+	// allocated size of the buffers, which only grows so that a
+	// changing resolution does not reallocate every frame
+	int m_bufferWidth;
+	int m_bufferHeight;
+	// size of the area being rendered this frame
+	int m_renderWidth;
+	int m_renderHeight;
+
+	// framebuffer and viewport bound before the geometry pass
+	GLint m_savedFramebuffer;
+	GLint m_savedViewport[4];
+
+	// lighting compute shader and its storage buffers
+	GLuint m_lightingProgram;
+	GLuint m_lightBuffer;
+	GLuint m_materialBuffer;
+	std::vector<PACKED_LIGHT> m_packedLights;
+
+	// allocate the G-buffer and output image at the passed in size
+	bool CreateBuffers(int width, int height);
+	// free the G-buffer and output image
+	void DestroyBuffers();
+};
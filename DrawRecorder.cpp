@@ -0,0 +1,468 @@
+///////////////////////////////////////////////////////////////////////////////
+// drawrecorder.cpp
+// ============
+// record the opaque scene objects into draw lists on worker threads, and
+// replay the lists with one instanced draw for each run of objects that
+// share their shader variant, mesh, texture and material
+//
+//  Created for CS-330-Computational Graphics and Visualization
+///////////////////////////////////////////////////////////////////////////////
+
+#include "DrawRecorder.h"
+
+#include <algorithm>
+#include <chrono>
+
+// declaration of the global variables and defines
+namespace
+{
+	// items recorded by one job
+	const int CHUNK_SIZE = 2048;
+	// RGBA float texels in the record of one object
+	const int RECORD_TEXELS = sizeof(DrawRecorder::OBJECT_RECORD) / (4 * sizeof(float));
+	// texture unit the records are read through, after the units
+	// of the scene textures, the G-buffer, the baked probes and
+	// the impostor atlas
+	const GLuint RECORD_TEXTURE_UNIT = 25;
+
+	/***********************************************************
+	 *  IsSameState()
+	 *
+	 *  This function is used to check whether two runs are
+	 *  drawn with the same state, and can be joined.
+	 ***********************************************************/
+	bool IsSameState(const DrawRecorder::DRAW_RUN& a, const DrawRecorder::DRAW_RUN& b)
+	{
+		return((a.variantKey == b.variantKey) &&
+			(a.mesh == b.mesh) &&
+			(a.textureSlot == b.textureSlot) &&
+			(a.materialIndex == b.materialIndex));
+	}
+}
+
+/***********************************************************
+ *  DrawRecorder()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+DrawRecorder::DrawRecorder()
+{
+	m_recordCount = 0;
+	m_recordTime = 0.0;
+	m_pItems = NULL;
+	m_pRecordItem = NULL;
+	m_recordBuffer = 0;
+	m_recordTexture = 0;
+	m_bufferCapacity = 0;
+	m_maxRecords = 0;
+	m_firstObjectLocation = -1;
+	m_jobCount = 0;
+	m_nextJob = 0;
+	m_busyWorkers = 0;
+	m_jobGeneration = 0;
+	m_bStopWorkers = false;
+
+	int workerCount = (int)std::thread::hardware_concurrency() - 1;
+	for (int i = 0; i < workerCount; i++)
+	{
+		m_workers.push_back(std::thread(&DrawRecorder::WorkerLoop, this));
+	}
+}
+
+/***********************************************************
+ *  ~DrawRecorder()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+DrawRecorder::~DrawRecorder()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_jobMutex);
+		m_bStopWorkers = true;
+	}
+	m_jobStarted.notify_all();
+	for (size_t i = 0; i < m_workers.size(); i++)
+	{
+		m_workers[i].join();
+	}
+	m_workers.clear();
+
+	for (size_t i = 0; i < m_meshes.size(); i++)
+	{
+		MeshImporter::DestroyMesh(m_meshes[i]);
+	}
+	m_meshes.clear();
+	if (m_recordTexture != 0)
+	{
+		glDeleteTextures(1, &m_recordTexture);
+		m_recordTexture = 0;
+	}
+	if (m_recordBuffer != 0)
+	{
+		glDeleteBuffers(1, &m_recordBuffer);
+		m_recordBuffer = 0;
+	}
+}
+
+/***********************************************************
+ *  Initialize()
+ *
+ *  This method is used for creating the buffer the records
+ *  are copied into and the buffer texture the variants read
+ *  it through.  The texture can only read as many texels as
+ *  the driver allows, which sets how many objects a frame
+ *  can record.
+ ***********************************************************/
+bool DrawRecorder::Initialize()
+{
+	if (m_recordBuffer != 0)
+	{
+		return(true);
+	}
+
+	GLint maxTexels = 0;
+	glGetIntegerv(GL_MAX_TEXTURE_BUFFER_SIZE, &maxTexels);
+	m_maxRecords = maxTexels / RECORD_TEXELS;
+	if (m_maxRecords <= 0)
+	{
+		return(false);
+	}
+
+	glGenBuffers(1, &m_recordBuffer);
+	glBindBuffer(GL_TEXTURE_BUFFER, m_recordBuffer);
+	glBufferData(GL_TEXTURE_BUFFER, sizeof(OBJECT_RECORD), NULL, GL_STREAM_DRAW);
+	m_bufferCapacity = 1;
+
+	glGenTextures(1, &m_recordTexture);
+	glBindTexture(GL_TEXTURE_BUFFER, m_recordTexture);
+	glTexBuffer(GL_TEXTURE_BUFFER, GL_RGBA32F, m_recordBuffer);
+	glBindTexture(GL_TEXTURE_BUFFER, 0);
+	glBindBuffer(GL_TEXTURE_BUFFER, 0);
+	return(true);
+}
+
+/***********************************************************
+ *  AddMesh()
+ *
+ *  This method is used for uploading the vertices and the
+ *  triangles of a mesh into buffers of its own, which the
+ *  runs are drawn from.
+ ***********************************************************/
+int DrawRecorder::AddMesh(const std::vector<MeshImporter::MESH_VERTEX>& vertices, const std::vector<unsigned int>& indices)
+{
+	if ((vertices.empty() == true) || (indices.empty() == true))
+	{
+		return(-1);
+	}
+
+	MeshImporter::GPU_MESH mesh;
+	MeshImporter::UploadMesh(&vertices[0], vertices.size(), &indices[0], indices.size(), mesh);
+	m_meshes.push_back(mesh);
+	return((int)m_meshes.size() - 1);
+}
+
+/***********************************************************
+ *  Record()
+ *
+ *  This method is used for recording the records and runs
+ *  of the passed in items.  The chunks are shared out
+ *  between the workers and the calling thread, and their
+ *  runs are then joined in order, numbering the records
+ *  across the whole frame.  Runs that continue from one
+ *  chunk into the next become one.
+ ***********************************************************/
+void DrawRecorder::Record(const std::vector<int>& items, const RECORD_FUNCTION& recordItem)
+{
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+	int jobCount = (int)((items.size() + CHUNK_SIZE - 1) / CHUNK_SIZE);
+	if ((int)m_chunks.size() < jobCount)
+	{
+		m_chunks.resize(jobCount);
+	}
+	m_pItems = &items;
+	m_pRecordItem = &recordItem;
+
+	if (jobCount > 0)
+	{
+		{
+			std::lock_guard<std::mutex> lock(m_jobMutex);
+			m_jobCount = jobCount;
+			m_nextJob = 0;
+			m_busyWorkers = (int)m_workers.size();
+			m_jobGeneration++;
+		}
+		m_jobStarted.notify_all();
+
+		TakeJobs(jobCount);
+
+		std::unique_lock<std::mutex> lock(m_jobMutex);
+		m_jobFinished.wait(lock, [this]()
+			{
+				return(m_busyWorkers == 0);
+			});
+	}
+	m_pItems = NULL;
+	m_pRecordItem = NULL;
+
+	m_runs.clear();
+	m_recordCount = 0;
+	for (int i = 0; i < jobCount; i++)
+	{
+		const RECORD_CHUNK& chunk = m_chunks[i];
+		for (size_t r = 0; r < chunk.runs.size(); r++)
+		{
+			DRAW_RUN run = chunk.runs[r];
+			run.firstObject += m_recordCount;
+			if ((m_runs.empty() == false) && (IsSameState(m_runs.back(), run) == true) &&
+				(m_runs.back().firstObject + m_runs.back().objectCount == run.firstObject))
+			{
+				m_runs.back().objectCount += run.objectCount;
+			}
+			else
+			{
+				m_runs.push_back(run);
+			}
+		}
+		m_recordCount += (int)chunk.records.size();
+	}
+	// chunks past the end of a smaller frame are not uploaded
+	for (size_t i = jobCount; i < m_chunks.size(); i++)
+	{
+		m_chunks[i].records.clear();
+		m_chunks[i].runs.clear();
+	}
+
+	m_recordTime = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+/***********************************************************
+ *  Upload()
+ *
+ *  This method is used for copying the records of the frame
+ *  into the record buffer.  The buffer is given new storage
+ *  every frame, so the driver never waits for the frames it
+ *  is still drawing from the old one, and grows by half
+ *  again whenever the records do not fit.
+ ***********************************************************/
+bool DrawRecorder::Upload()
+{
+	if ((m_recordBuffer == 0) || (m_recordCount > m_maxRecords))
+	{
+		return(false);
+	}
+	if (m_recordCount == 0)
+	{
+		return(true);
+	}
+
+	if (m_recordCount > m_bufferCapacity)
+	{
+		m_bufferCapacity = std::min(std::max(m_recordCount, m_bufferCapacity + m_bufferCapacity / 2), m_maxRecords);
+	}
+	glBindBuffer(GL_TEXTURE_BUFFER, m_recordBuffer);
+	glBufferData(GL_TEXTURE_BUFFER, (GLsizeiptr)m_bufferCapacity * sizeof(OBJECT_RECORD), NULL, GL_STREAM_DRAW);
+	GLintptr offset = 0;
+	for (size_t i = 0; i < m_chunks.size(); i++)
+	{
+		const std::vector<OBJECT_RECORD>& records = m_chunks[i].records;
+		if (records.empty() == false)
+		{
+			GLsizeiptr size = (GLsizeiptr)(records.size() * sizeof(OBJECT_RECORD));
+			glBufferSubData(GL_TEXTURE_BUFFER, offset, size, &records[0]);
+			offset += size;
+		}
+	}
+	glBindBuffer(GL_TEXTURE_BUFFER, 0);
+	return(true);
+}
+
+/***********************************************************
+ *  ApplyToProgram()
+ *
+ *  This method is used for binding the record texture into
+ *  a recorded variant, and finding the uniform that the
+ *  runs pass their first record in.  The program must be
+ *  the one currently in use.
+ ***********************************************************/
+void DrawRecorder::ApplyToProgram(GLuint program)
+{
+	GLint activeTexture = GL_TEXTURE0;
+	glGetIntegerv(GL_ACTIVE_TEXTURE, &activeTexture);
+	glActiveTexture(GL_TEXTURE0 + RECORD_TEXTURE_UNIT);
+	glBindTexture(GL_TEXTURE_BUFFER, m_recordTexture);
+	glActiveTexture(activeTexture);
+
+	glUniform1i(glGetUniformLocation(program, "objectRecords"), RECORD_TEXTURE_UNIT);
+	m_firstObjectLocation = glGetUniformLocation(program, "firstObject");
+}
+
+/***********************************************************
+ *  GetRunCount()
+ *
+ *  This method is used for getting the number of runs the
+ *  frame was recorded into.
+ ***********************************************************/
+int DrawRecorder::GetRunCount() const
+{
+	return((int)m_runs.size());
+}
+
+/***********************************************************
+ *  GetRun()
+ *
+ *  This method is used for getting a recorded run, for
+ *  setting its state before it is drawn.
+ ***********************************************************/
+const DrawRecorder::DRAW_RUN& DrawRecorder::GetRun(int run) const
+{
+	return(m_runs[run]);
+}
+
+/***********************************************************
+ *  DrawRun()
+ *
+ *  This method is used for drawing every object of a run
+ *  as the instances of one draw of its mesh.  Each instance
+ *  reads the record at the first object plus its instance
+ *  number.
+ ***********************************************************/
+void DrawRecorder::DrawRun(int run) const
+{
+	const DRAW_RUN& drawRun = m_runs[run];
+	if ((drawRun.mesh < 0) || (drawRun.mesh >= (int)m_meshes.size()))
+	{
+		return;
+	}
+
+	const MeshImporter::GPU_MESH& mesh = m_meshes[drawRun.mesh];
+	glUniform1i(m_firstObjectLocation, drawRun.firstObject);
+	glBindVertexArray(mesh.vertexArray);
+	glDrawElementsInstanced(GL_TRIANGLES, mesh.indexCount, GL_UNSIGNED_INT, (void*)0, drawRun.objectCount);
+	glBindVertexArray(0);
+}
+
+/***********************************************************
+ *  GetRecordCount()
+ *
+ *  This method is used for getting the number of objects
+ *  the frame recorded.
+ ***********************************************************/
+int DrawRecorder::GetRecordCount() const
+{
+	return(m_recordCount);
+}
+
+/***********************************************************
+ *  GetRecordTime()
+ *
+ *  This method is used for getting the time in milliseconds
+ *  the last frame took to record.
+ ***********************************************************/
+double DrawRecorder::GetRecordTime() const
+{
+	return(m_recordTime);
+}
+
+/***********************************************************
+ *  GetThreadCount()
+ *
+ *  This method is used for getting the number of threads
+ *  that record the chunks of a frame, including the one
+ *  that starts it.
+ ***********************************************************/
+int DrawRecorder::GetThreadCount() const
+{
+	return((int)m_workers.size() + 1);
+}
+
+/***********************************************************
+ *  WorkerLoop()
+ *
+ *  This method is used for running a worker thread.  It
+ *  sleeps until a frame is started, takes its chunks until
+ *  none are left, and reports that it is done.
+ ***********************************************************/
+void DrawRecorder::WorkerLoop()
+{
+	unsigned int generation = 0;
+	while (true)
+	{
+		int jobCount = 0;
+		{
+			std::unique_lock<std::mutex> lock(m_jobMutex);
+			m_jobStarted.wait(lock, [this, generation]()
+				{
+					return((m_bStopWorkers == true) || (m_jobGeneration != generation));
+				});
+			if (m_bStopWorkers == true)
+			{
+				return;
+			}
+			generation = m_jobGeneration;
+			jobCount = m_jobCount;
+		}
+
+		TakeJobs(jobCount);
+
+		{
+			std::lock_guard<std::mutex> lock(m_jobMutex);
+			m_busyWorkers--;
+		}
+		m_jobFinished.notify_one();
+	}
+}
+
+/***********************************************************
+ *  TakeJobs()
+ *
+ *  This method is used for taking the next chunk of the
+ *  frame and recording it, until none are left.
+ ***********************************************************/
+void DrawRecorder::TakeJobs(int jobCount)
+{
+	for (int job = m_nextJob++; job < jobCount; job = m_nextJob++)
+	{
+		RecordChunk(job);
+	}
+}
+
+/***********************************************************
+ *  RecordChunk()
+ *
+ *  This method is used for recording one chunk of the
+ *  items into the chunk's own records and runs, with the
+ *  records numbered from the start of the chunk.  A new
+ *  run starts wherever the state changes.
+ ***********************************************************/
+void DrawRecorder::RecordChunk(int job)
+{
+	RECORD_CHUNK& chunk = m_chunks[job];
+	chunk.records.clear();
+	chunk.runs.clear();
+
+	const std::vector<int>& items = *m_pItems;
+	size_t first = (size_t)job * CHUNK_SIZE;
+	size_t last = std::min(first + CHUNK_SIZE, items.size());
+	OBJECT_RECORD record;
+	DRAW_RUN state;
+	for (size_t i = first; i < last; i++)
+	{
+		if ((*m_pRecordItem)(items[i], record, state) == false)
+		{
+			continue;
+		}
+
+		if ((chunk.runs.empty() == false) && (IsSameState(chunk.runs.back(), state) == true))
+		{
+			chunk.runs.back().objectCount++;
+		}
+		else
+		{
+			state.firstObject = (int)chunk.records.size();
+			state.objectCount = 1;
+			chunk.runs.push_back(state);
+		}
+		chunk.records.push_back(record);
+	}
+}
@@ -0,0 +1,163 @@
+///////////////////////////////////////////////////////////////////////////////
+// drawrecorder.h
+// ============
+// record the opaque scene objects into draw lists on worker threads, and
+// replay the lists with one instanced draw for each run of objects that
+// share their shader variant, mesh, texture and material
+//
+//  Created for CS-330-Computational Graphics and Visualization
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "MeshImporter.h"
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/***********************************************************
+ *  DrawRecorder
+ *
+ *  This class contains the code for moving the work of
+ *  submitting many objects off the OpenGL thread.  Drawing
+ *  an object on its own sets its transform, color and
+ *  material uniforms one at a time, all on the thread that
+ *  owns the context.  Instead, the list of objects is split
+ *  into chunks that worker threads record in parallel, each
+ *  into its own storage that is kept from frame to frame:
+ *
+ *    records   the transform, normal matrix and color of
+ *              each object, as eight RGBA float texels
+ *    runs      neighboring objects that share their state,
+ *              drawn together as the instances of one draw
+ *
+ *  The OpenGL thread then copies the records into a texture
+ *  buffer with one call per chunk, and replays the runs.
+ *  The recorded shader variants read the record of each
+ *  instance from the buffer, so only the state that changes
+ *  between runs is set as uniforms.  The meshes and buffers
+ *  are created up front, and nothing is allocated once the
+ *  storage has grown to the size of the scene.
+ ***********************************************************/
+class DrawRecorder
+{
+public:
+	// the values of one object read by the recorded variants
+	struct OBJECT_RECORD
+	{
+		glm::mat4 model;
+		// columns of the normal matrix, padded to four floats
+		glm::vec4 normalMatrix[3];
+		// the color, or the UV scale of a textured object
+		glm::vec4 color;
+	};
+
+	// objects drawn with the same state by one instanced draw
+	struct DRAW_RUN
+	{
+		unsigned int variantKey;
+		// mesh index, from AddMesh()
+		int mesh;
+		// texture slot, or -1 for an untextured object
+		int textureSlot;
+		int materialIndex;
+		// first record and number of records of the run
+		int firstObject;
+		int objectCount;
+	};
+
+	// fills in the record and the state of the passed in item,
+	// returning false to leave it out of the frame.  it is called
+	// on several threads at once
+	typedef std::function<bool(int item, OBJECT_RECORD& record, DRAW_RUN& state)> RECORD_FUNCTION;
+
+	// constructor
+	DrawRecorder();
+	// destructor
+	~DrawRecorder();
+
+	// create the record buffer
+	bool Initialize();
+	// upload a mesh, returning the index runs refer to it by
+	int AddMesh(const std::vector<MeshImporter::MESH_VERTEX>& vertices, const std::vector<unsigned int>& indices);
+
+	// record the passed in items on every thread.  items sorted
+	// by their state give the longest runs
+	void Record(const std::vector<int>& items, const RECORD_FUNCTION& recordItem);
+	// copy the records into the record buffer, returning false
+	// when there are more than the buffer can be read with
+	bool Upload();
+	// bind the record buffer for a recorded variant
+	void ApplyToProgram(GLuint program);
+
+	// number of runs recorded for the frame
+	int GetRunCount() const;
+	// get a recorded run
+	const DRAW_RUN& GetRun(int run) const;
+	// draw the objects of a run with the bound variant
+	void DrawRun(int run) const;
+
+	// number of objects recorded for the frame
+	int GetRecordCount() const;
+	// time in milliseconds the last Record() took
+	double GetRecordTime() const;
+	// number of threads the chunks are shared out between
+	int GetThreadCount() const;
+
+private:
+	// the records and runs of one chunk of the items
+	struct RECORD_CHUNK
+	{
+		std::vector<OBJECT_RECORD> records;
+		std::vector<DRAW_RUN> runs;
+	};
+
+	std::vector<MeshImporter::GPU_MESH> m_meshes;
+
+	// the chunks recorded for the frame, and their runs joined
+	// with the records numbered across the whole frame
+	std::vector<RECORD_CHUNK> m_chunks;
+	std::vector<DRAW_RUN> m_runs;
+	int m_recordCount;
+	double m_recordTime;
+
+	// the items and function of the frame being recorded
+	const std::vector<int>* m_pItems;
+	const RECORD_FUNCTION* m_pRecordItem;
+
+	// buffer the records are copied into, the texture it is read
+	// through, its size in records and the most the texture can
+	// read
+	GLuint m_recordBuffer;
+	GLuint m_recordTexture;
+	int m_bufferCapacity;
+	int m_maxRecords;
+	// location of the first object uniform of the bound variant
+	GLint m_firstObjectLocation;
+
+	// worker threads, which wait for a new frame and take its
+	// chunks until none are left
+	std::vector<std::thread> m_workers;
+	std::mutex m_jobMutex;
+	std::condition_variable m_jobStarted;
+	std::condition_variable m_jobFinished;
+	int m_jobCount;
+	std::atomic<int> m_nextJob;
+	int m_busyWorkers;
+	unsigned int m_jobGeneration;
+	bool m_bStopWorkers;
+
+	// wait for frames to record on a worker thread
+	void WorkerLoop();
+	// take chunks of the frame until none are left
+	void TakeJobs(int jobCount);
+	// record one chunk of the items
+	void RecordChunk(int job);
+};
@@ -0,0 +1,456 @@
+///////////////////////////////////////////////////////////////////////////////
+// dynamicresolution.cpp
+// ============
+// render the scene offscreen at a resolution that holds a frame
+// time target, then upscale it to the display window
+//
+//  Created for CS-330-Computational Graphics and Visualization
+///////////////////////////////////////////////////////////////////////////////
+
+#include "DynamicResolution.h"
+
+#include <cmath>
+#include <cstring>
+#include <iostream>
+
+// declaration of the global variables and defines
+namespace
+{
+	// full screen triangle generated from the vertex index
+	const char* g_UpscaleVertexShader =
+		"#version 330 core\n"
+		"out vec2 fragmentTextureCoordinate;\n"
+		"void main()\n"
+		"{\n"
+		"    vec2 position = vec2((gl_VertexID << 1) & 2, gl_VertexID & 2);\n"
+		"    fragmentTextureCoordinate = position;\n"
+		"    gl_Position = vec4(position * 2.0 - 1.0, 0.0, 1.0);\n"
+		"}\n";
+
+	// bilinear upscale with an optional contrast limited sharpen,
+	// sampling only the rendered part of the offscreen texture
+	const char* g_UpscaleFragmentShader =
+		"#version 330 core\n"
+		"in vec2 fragmentTextureCoordinate;\n"
+		"out vec4 outFragmentColor;\n"
+		"uniform sampler2D sourceTexture;\n"
+		"uniform vec2 UVscale;\n"
+		"uniform vec2 texelSize;\n"
+		"uniform bool bSharpen;\n"
+		"uniform float sharpness;\n"
+		"vec3 fetch(vec2 uv)\n"
+		"{\n"
+		"    uv = clamp(uv, texelSize * 0.5, UVscale - texelSize * 0.5);\n"
+		"    return texture(sourceTexture, uv).rgb;\n"
+		"}\n"
+		"void main()\n"
+		"{\n"
+		"    vec2 uv = fragmentTextureCoordinate * UVscale;\n"
+		"    vec3 color = fetch(uv);\n"
+		"    if (bSharpen)\n"
+		"    {\n"
+		"        vec3 north = fetch(uv + vec2(0.0, texelSize.y));\n"
+		"        vec3 south = fetch(uv - vec2(0.0, texelSize.y));\n"
+		"        vec3 east = fetch(uv + vec2(texelSize.x, 0.0));\n"
+		"        vec3 west = fetch(uv - vec2(texelSize.x, 0.0));\n"
+		"        vec3 lowest = min(color, min(min(north, south), min(east, west)));\n"
+		"        vec3 highest = max(color, max(max(north, south), max(east, west)));\n"
+		"        vec3 sharpened = color + sharpness * (4.0 * color - north - south - east - west) * 0.25;\n"
+		"        color = clamp(sharpened, lowest, highest);\n"
+		"    }\n"
+		"    outFragmentColor = vec4(color, 1.0);\n"
+		"}\n";
+
+	// strength of the sharpening filter
+	const float SHARPNESS = 0.6f;
+	// fraction of the measured error corrected per adjustment
+	const float SCALE_ADJUST_RATE = 0.25f;
+	// measured times within this fraction of the target are left alone
+	const double TARGET_DEADBAND = 0.05;
+	// weight of each new GPU time sample in the smoothed time
+	const double TIME_SMOOTHING = 0.2;
+	// shortest time between resolution reports, in seconds
+	const double REPORT_INTERVAL = 1.0;
+
+	/***********************************************************
+	 *  CompileShaderStage()
+	 *
+	 *  This function is used to compile one shader stage and
+	 *  report any compile errors.
+	 ***********************************************************/
+	GLuint CompileShaderStage(GLenum type, const char* source)
+	{
+		GLuint shader = glCreateShader(type);
+		glShaderSource(shader, 1, &source, NULL);
+		glCompileShader(shader);
+
+		GLint success = 0;
+		glGetShaderiv(shader, GL_COMPILE_STATUS, &success);
+		if (!success)
+		{
+			char infoLog[1024];
+			glGetShaderInfoLog(shader, 1024, NULL, infoLog);
+			std::cout << "ERROR::SHADER_COMPILATION_ERROR\n" << infoLog << std::endl;
+		}
+		return(shader);
+	}
+}
+
+/***********************************************************
+ *  DynamicResolution()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+DynamicResolution::DynamicResolution()
+{
+	m_pWindow = NULL;
+	m_bufferWidth = 0;
+	m_bufferHeight = 0;
+	m_scale = 1.0f;
+	m_minScale = 0.5f;
+	m_maxScale = 1.0f;
+	m_targetFrameTime = 1.0 / 60.0;
+	m_measuredFrameTime = 0.0;
+	for (int i = 0; i < QUERY_COUNT; i++)
+	{
+		m_timerQueries[i] = 0;
+		m_bQueryIssued[i] = false;
+	}
+	m_queryIndex = 0;
+	m_upscaleProgram = 0;
+	m_emptyVertexArray = 0;
+	m_filter = FILTER_BILINEAR;
+	m_savedProgram = 0;
+	m_lastReportTime = 0.0;
+	m_lastReportedWidth = 0;
+	m_lastReportedHeight = 0;
+}
+
+/***********************************************************
+ *  ~DynamicResolution()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+DynamicResolution::~DynamicResolution()
+{
+	if (0 != m_timerQueries[0])
+	{
+		glDeleteQueries(QUERY_COUNT, m_timerQueries);
+	}
+	if (0 != m_upscaleProgram)
+	{
+		glDeleteProgram(m_upscaleProgram);
+		m_upscaleProgram = 0;
+	}
+	if (0 != m_emptyVertexArray)
+	{
+		glDeleteVertexArrays(1, &m_emptyVertexArray);
+		m_emptyVertexArray = 0;
+	}
+	m_pWindow = NULL;
+}
+
+/***********************************************************
+ *  Initialize()
+ *
+ *  This method is used for creating the GPU timer queries
+ *  and the shader program used for upscaling.
+ ***********************************************************/
+bool DynamicResolution::Initialize(GLFWwindow* window)
+{
+	m_pWindow = window;
+	glfwGetFramebufferSize(m_pWindow, &m_bufferWidth, &m_bufferHeight);
+
+	glGenQueries(QUERY_COUNT, m_timerQueries);
+
+	// compile and link the upscale shader program
+	GLuint vertexShader = CompileShaderStage(GL_VERTEX_SHADER, g_UpscaleVertexShader);
+	GLuint fragmentShader = CompileShaderStage(GL_FRAGMENT_SHADER, g_UpscaleFragmentShader);
+	m_upscaleProgram = glCreateProgram();
+	glAttachShader(m_upscaleProgram, vertexShader);
+	glAttachShader(m_upscaleProgram, fragmentShader);
+	glLinkProgram(m_upscaleProgram);
+	glDeleteShader(vertexShader);
+	glDeleteShader(fragmentShader);
+
+	GLint success = 0;
+	glGetProgramiv(m_upscaleProgram, GL_LINK_STATUS, &success);
+	if (!success)
+	{
+		char infoLog[1024];
+		glGetProgramInfoLog(m_upscaleProgram, 1024, NULL, infoLog);
+		std::cout << "ERROR::PROGRAM_LINKING_ERROR\n" << infoLog << std::endl;
+		return(false);
+	}
+
+	// the full screen triangle needs no vertex data, but a
+	// vertex array must be bound to draw in the core profile
+	glGenVertexArrays(1, &m_emptyVertexArray);
+
+	return(true);
+}
+
+/***********************************************************
+ *  SetTargetFrameTime()
+ *
+ *  This method is used for setting the GPU time per frame
+ *  that the resolution is adjusted to hold.
+ ***********************************************************/
+void DynamicResolution::SetTargetFrameTime(double milliseconds)
+{
+	m_targetFrameTime = milliseconds / 1000.0;
+}
+
+/***********************************************************
+ *  SetUpscaleFilter()
+ *
+ *  This method is used for setting the filter used when
+ *  upscaling the scene into the window.
+ ***********************************************************/
+void DynamicResolution::SetUpscaleFilter(UPSCALE_FILTER filter)
+{
+	m_filter = filter;
+}
+
+/***********************************************************
+ *  SetScaleLimits()
+ *
+ *  This method is used for setting the range of resolution
+ *  scales the controller may choose from.
+ ***********************************************************/
+void DynamicResolution::SetScaleLimits(float minScale, float maxScale)
+{
+	m_minScale = minScale;
+	m_maxScale = maxScale;
+	if (m_scale < m_minScale)
+	{
+		m_scale = m_minScale;
+	}
+	if (m_scale > m_maxScale)
+	{
+		m_scale = m_maxScale;
+	}
+}
+
+/***********************************************************
+ *  BeginFrame()
+ *
+ *  This method is called before the scene is rendered, with
+ *  the offscreen target bound.  It limits the viewport to
+ *  the current render resolution and starts the GPU timer.
+ ***********************************************************/
+void DynamicResolution::BeginFrame()
+{
+	// follow any change to the window size, which the offscreen
+	// targets are allocated at
+	glfwGetFramebufferSize(m_pWindow, &m_bufferWidth, &m_bufferHeight);
+
+	// read back any finished timings before reusing a query
+	UpdateScale();
+
+	glBeginQuery(GL_TIME_ELAPSED, m_timerQueries[m_queryIndex]);
+
+	glViewport(0, 0, GetRenderWidth(), GetRenderHeight());
+}
+
+/***********************************************************
+ *  EndFrame()
+ *
+ *  This method is called after the scene is rendered, with
+ *  the window framebuffer bound.  It draws the rendered part
+ *  of the offscreen texture over the whole window and stops
+ *  the GPU timer.
+ ***********************************************************/
+void DynamicResolution::EndFrame(GLuint sceneTexture)
+{
+	glViewport(0, 0, m_bufferWidth, m_bufferHeight);
+
+	// save the state changed by the upscale pass
+	GLboolean bBlend = glIsEnabled(GL_BLEND);
+	GLboolean bDepthTest = glIsEnabled(GL_DEPTH_TEST);
+	glGetIntegerv(GL_CURRENT_PROGRAM, &m_savedProgram);
+	// the scene textures stay bound to their slots between frames
+	GLint activeTexture = GL_TEXTURE0;
+	GLint savedTexture = 0;
+	glGetIntegerv(GL_ACTIVE_TEXTURE, &activeTexture);
+	glActiveTexture(GL_TEXTURE0);
+	glGetIntegerv(GL_TEXTURE_BINDING_2D, &savedTexture);
+
+	glDisable(GL_BLEND);
+	glDisable(GL_DEPTH_TEST);
+
+	glUseProgram(m_upscaleProgram);
+	glBindTexture(GL_TEXTURE_2D, sceneTexture);
+	glUniform1i(glGetUniformLocation(m_upscaleProgram, "sourceTexture"), 0);
+	glUniform2f(glGetUniformLocation(m_upscaleProgram, "UVscale"),
+		(float)GetRenderWidth() / (float)m_bufferWidth,
+		(float)GetRenderHeight() / (float)m_bufferHeight);
+	glUniform2f(glGetUniformLocation(m_upscaleProgram, "texelSize"),
+		1.0f / (float)m_bufferWidth,
+		1.0f / (float)m_bufferHeight);
+	glUniform1i(glGetUniformLocation(m_upscaleProgram, "bSharpen"), m_filter == FILTER_SHARPEN);
+	glUniform1f(glGetUniformLocation(m_upscaleProgram, "sharpness"), SHARPNESS);
+
+	glBindVertexArray(m_emptyVertexArray);
+	glDrawArrays(GL_TRIANGLES, 0, 3);
+	glBindVertexArray(0);
+
+	glEndQuery(GL_TIME_ELAPSED);
+	m_bQueryIssued[m_queryIndex] = true;
+	m_queryIndex = (m_queryIndex + 1) % QUERY_COUNT;
+
+	// restore the scene rendering state
+	glUseProgram(m_savedProgram);
+	glBindTexture(GL_TEXTURE_2D, savedTexture);
+	glActiveTexture(activeTexture);
+	if (bBlend)
+	{
+		glEnable(GL_BLEND);
+	}
+	if (bDepthTest)
+	{
+		glEnable(GL_DEPTH_TEST);
+	}
+
+	ReportResolution();
+}
+
+/***********************************************************
+ *  GetRenderWidth()
+ *
+ *  This method returns the width the scene is rendered at.
+ ***********************************************************/
+int DynamicResolution::GetRenderWidth() const
+{
+	int width = (int)(m_bufferWidth * m_scale + 0.5f);
+	return((width > 0) ? width : 1);
+}
+
+/***********************************************************
+ *  GetRenderHeight()
+ *
+ *  This method returns the height the scene is rendered at.
+ ***********************************************************/
+int DynamicResolution::GetRenderHeight() const
+{
+	int height = (int)(m_bufferHeight * m_scale + 0.5f);
+	return((height > 0) ? height : 1);
+}
+
+/***********************************************************
+ *  UpdateScale()
+ *
+ *  This method is used for reading the GPU timer query that
+ *  is about to be reused, if its result is ready, and moving
+ *  the resolution scale towards the target frame time.  The
+ *  rendering cost is treated as proportional to the pixel
+ *  count, so the scale for each axis follows the square root
+ *  of the time ratio.
+ ***********************************************************/
+void DynamicResolution::UpdateScale()
+{
+	if (m_bQueryIssued[m_queryIndex] == false)
+	{
+		return;
+	}
+
+	GLint bAvailable = 0;
+	glGetQueryObjectiv(m_timerQueries[m_queryIndex], GL_QUERY_RESULT_AVAILABLE, &bAvailable);
+	if (!bAvailable)
+	{
+		// waiting would stall the pipeline, so skip this sample
+		return;
+	}
+
+	GLuint64 elapsed = 0;
+	glGetQueryObjectui64v(m_timerQueries[m_queryIndex], GL_QUERY_RESULT, &elapsed);
+	m_bQueryIssued[m_queryIndex] = false;
+
+	double sample = (double)elapsed / 1.0e9;
+	if (m_measuredFrameTime <= 0.0)
+	{
+		m_measuredFrameTime = sample;
+	}
+	else
+	{
+		m_measuredFrameTime += (sample - m_measuredFrameTime) * TIME_SMOOTHING;
+	}
+
+	if (m_measuredFrameTime <= 0.0)
+	{
+		return;
+	}
+
+	double ratio = m_targetFrameTime / m_measuredFrameTime;
+	if (std::fabs(ratio - 1.0) < TARGET_DEADBAND)
+	{
+		return;
+	}
+
+	float desiredScale = m_scale * (float)std::sqrt(ratio);
+	m_scale += (desiredScale - m_scale) * SCALE_ADJUST_RATE;
+	if (m_scale < m_minScale)
+	{
+		m_scale = m_minScale;
+	}
+	if (m_scale > m_maxScale)
+	{
+		m_scale = m_maxScale;
+	}
+}
+
+/***********************************************************
+ *  ReportResolution()
+ *
+ *  This method is used for printing the render resolution
+ *  whenever it has changed, at most once per second.
+ ***********************************************************/
+void DynamicResolution::ReportResolution()
+{
+	double currentTime = glfwGetTime();
+	if (currentTime - m_lastReportTime < REPORT_INTERVAL)
+	{
+		return;
+	}
+
+	int width = GetRenderWidth();
+	int height = GetRenderHeight();
+	if ((width == m_lastReportedWidth) && (height == m_lastReportedHeight))
+	{
+		return;
+	}
+
+	std::cout << "INFO: Render resolution: " << width << "x" << height
+		<< " (" << (int)(m_scale * 100.0f + 0.5f) << "% of "
+		<< m_bufferWidth << "x" << m_bufferHeight << ")"
+		<< ", GPU time: " << m_measuredFrameTime * 1000.0 << " ms"
+		<< ", target: " << m_targetFrameTime * 1000.0 << " ms"
+		<< " at " << currentTime << " s" << std::endl;
+
+	m_lastReportTime = currentTime;
+	m_lastReportedWidth = width;
+	m_lastReportedHeight = height;
+}
+
+/***********************************************************
+ *  ParseUpscaleFilter()
+ *
+ *  This method is used for converting an upscale filter name
+ *  from the command line into a filter value.
+ ***********************************************************/
+bool DynamicResolution::ParseUpscaleFilter(const char* name, UPSCALE_FILTER& filter)
+{
+	if (strcmp(name, "bilinear") == 0)
+	{
+		filter = FILTER_BILINEAR;
+	}
+	else if (strcmp(name, "sharpen") == 0)
+	{
+		filter = FILTER_SHARPEN;
+	}
+	else
+	{
+		return(false);
+	}
+	return(true);
+}
@@ -0,0 +1,105 @@
+///////////////////////////////////////////////////////////////////////////////
+// dynamicresolution.h
+// ============
+// render the scene offscreen at a resolution that holds a frame
+// time target, then upscale it to the display window
+//
+//  Created for CS-330-Computational Graphics and Visualization
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <GL/glew.h>
+#include "GLFW/glfw3.h"
+
+/***********************************************************
+ *  DynamicResolution
+ *
+ *  This class contains the code for rendering the scene into
+ *  an offscreen target, timing the rendering on the GPU,
+ *  adjusting the offscreen resolution to hit a target time,
+ *  and upscaling the result into the display window.  The
+ *  offscreen color and depth targets are transient targets
+ *  of the render graph, allocated at the window size.
+ ***********************************************************/
+class DynamicResolution
+{
+public:
+	// filters used for upscaling to the window
+	enum UPSCALE_FILTER
+	{
+		FILTER_BILINEAR = 0,
+		FILTER_SHARPEN
+	};
+
+	// constructor
+	DynamicResolution();
+	// destructor
+	~DynamicResolution();
+
+	// create the timer queries and upscale shader
+	bool Initialize(GLFWwindow* window);
+	// set the GPU time to aim for per frame, in milliseconds
+	void SetTargetFrameTime(double milliseconds);
+	// set the filter used for upscaling
+	void SetUpscaleFilter(UPSCALE_FILTER filter);
+	// set the lowest and highest resolution scale allowed
+	void SetScaleLimits(float minScale, float maxScale);
+
+	// limit the scene rendering to the render resolution of the
+	// bound offscreen target
+	void BeginFrame();
+	// upscale the rendered part of the scene texture into the
+	// bound framebuffer
+	void EndFrame(GLuint sceneTexture);
+
+	// the width and height the scene is being rendered at
+	int GetRenderWidth() const;
+	int GetRenderHeight() const;
+
+	// parse an upscale filter name from the command line
+	static bool ParseUpscaleFilter(const char* name, UPSCALE_FILTER& filter);
+
+private:
+	// number of timer queries in flight, so results are read
+	// a few frames later without stalling the pipeline
+	static const int QUERY_COUNT = 4;
+
+	// the display window
+	GLFWwindow* m_pWindow;
+	// allocated size of the offscreen targets (the window size)
+	int m_bufferWidth;
+	int m_bufferHeight;
+	// current resolution scale for each axis
+	float m_scale;
+	float m_minScale;
+	float m_maxScale;
+	// target GPU time per frame in seconds
+	double m_targetFrameTime;
+	// smoothed measured GPU time per frame in seconds
+	double m_measuredFrameTime;
+
+	// GPU timer queries and whether each one has been issued
+	GLuint m_timerQueries[QUERY_COUNT];
+	bool m_bQueryIssued[QUERY_COUNT];
+	int m_queryIndex;
+
+	// upscale shader program and empty vertex array for drawing
+	// the full screen triangle
+	GLuint m_upscaleProgram;
+	GLuint m_emptyVertexArray;
+	UPSCALE_FILTER m_filter;
+
+	// the program that was active before the upscale pass
+	GLint m_savedProgram;
+
+	// time of the last resolution report
+	double m_lastReportTime;
+	int m_lastReportedWidth;
+	int m_lastReportedHeight;
+
+	// read finished timer queries and adjust the scale
+	void UpdateScale();
+	// print the chosen resolution when it has changed
+	void ReportResolution();
+};
@@ -0,0 +1,812 @@
+///////////////////////////////////////////////////////////////////////////////
+// framecapture.cpp
+// ============
+// save screenshots and continuous frame captures by reading the window
+// back through a ring of pixel buffers, encoding them on worker threads
+//
+//  Created for CS-330-Computational Graphics and Visualization
+///////////////////////////////////////////////////////////////////////////////
+
+#include "FrameCapture.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+
+#ifdef _WIN32
+#include <direct.h>
+#else
+#include <sys/stat.h>
+#include <sys/types.h>
+#endif
+
+// declaration of the global variables and defines
+namespace
+{
+	// most worker threads writing frames at once
+	const int MAX_WORKER_THREADS = 4;
+
+	// the length and distance codes of a deflate match, with the
+	// first value of each and the extra bits that follow it
+	const int LENGTH_BASE[] = {
+		3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31,
+		35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258 };
+	const int LENGTH_EXTRA[] = {
+		0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2,
+		3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0 };
+	const int LENGTH_CODES = 29;
+	const int DISTANCE_BASE[] = {
+		1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193,
+		257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577 };
+	const int DISTANCE_EXTRA[] = {
+		0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6,
+		7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13 };
+	const int DISTANCE_CODES = 30;
+	// shortest and longest match, and the farthest one can reach
+	const int MIN_MATCH = 3;
+	const int MAX_MATCH = 258;
+	const size_t MAX_DISTANCE = 32768;
+
+	// bits waiting to be written into a deflate stream, which
+	// fills each byte from its lowest bit
+	struct BIT_WRITER
+	{
+		std::vector<unsigned char>* pBytes;
+		unsigned int bits;
+		int bitCount;
+	};
+
+	/***********************************************************
+	 *  PutBits()
+	 *
+	 *  This function is used to add up to 16 bits to a deflate
+	 *  stream, lowest bit first.
+	 ***********************************************************/
+	void PutBits(BIT_WRITER& writer, unsigned int value, int count)
+	{
+		writer.bits |= value << writer.bitCount;
+		writer.bitCount += count;
+		while (writer.bitCount >= 8)
+		{
+			writer.pBytes->push_back((unsigned char)(writer.bits & 0xFF));
+			writer.bits >>= 8;
+			writer.bitCount -= 8;
+		}
+	}
+
+	/***********************************************************
+	 *  PutCode()
+	 *
+	 *  This function is used to add a Huffman code, which
+	 *  deflate stores highest bit first.
+	 ***********************************************************/
+	void PutCode(BIT_WRITER& writer, unsigned int code, int length)
+	{
+		unsigned int reversed = 0;
+		for (int i = 0; i < length; i++)
+		{
+			reversed = (reversed << 1) | ((code >> i) & 1);
+		}
+		PutBits(writer, reversed, length);
+	}
+
+	/***********************************************************
+	 *  PutSymbol()
+	 *
+	 *  This function is used to add a literal, length or end
+	 *  of block symbol with the fixed Huffman codes.
+	 ***********************************************************/
+	void PutSymbol(BIT_WRITER& writer, int symbol)
+	{
+		if (symbol < 144)
+		{
+			PutCode(writer, 0x30 + symbol, 8);
+		}
+		else if (symbol < 256)
+		{
+			PutCode(writer, 0x190 + (symbol - 144), 9);
+		}
+		else if (symbol < 280)
+		{
+			PutCode(writer, symbol - 256, 7);
+		}
+		else
+		{
+			PutCode(writer, 0xC0 + (symbol - 280), 8);
+		}
+	}
+
+	/***********************************************************
+	 *  PutMatch()
+	 *
+	 *  This function is used to add a copy of earlier bytes,
+	 *  as a length code and a distance code with their extra
+	 *  bits.
+	 ***********************************************************/
+	void PutMatch(BIT_WRITER& writer, int length, int distance)
+	{
+		int lengthCode = LENGTH_CODES - 1;
+		while (LENGTH_BASE[lengthCode] > length)
+		{
+			lengthCode--;
+		}
+		PutSymbol(writer, 257 + lengthCode);
+		PutBits(writer, length - LENGTH_BASE[lengthCode], LENGTH_EXTRA[lengthCode]);
+
+		int distanceCode = DISTANCE_CODES - 1;
+		while (DISTANCE_BASE[distanceCode] > distance)
+		{
+			distanceCode--;
+		}
+		PutCode(writer, distanceCode, 5);
+		PutBits(writer, distance - DISTANCE_BASE[distanceCode], DISTANCE_EXTRA[distanceCode]);
+	}
+
+	/***********************************************************
+	 *  Deflate()
+	 *
+	 *  This function is used to compress the filtered rows of
+	 *  an image into a zlib stream, as one block with the fixed
+	 *  Huffman codes.  Only three distances are searched for
+	 *  matches: the byte before, the pixel before and the row
+	 *  above.  That finds the runs and repeated rows most
+	 *  rendered frames are made of, at a few compares a byte.
+	 ***********************************************************/
+	void Deflate(const std::vector<unsigned char>& data, size_t rowBytes, int pixelBytes, std::vector<unsigned char>& bytes)
+	{
+		// zlib header for deflate with a 32K window
+		bytes.push_back(0x78);
+		bytes.push_back(0x01);
+
+		BIT_WRITER writer;
+		writer.pBytes = &bytes;
+		writer.bits = 0;
+		writer.bitCount = 0;
+		// final block, fixed Huffman codes
+		PutBits(writer, 1, 1);
+		PutBits(writer, 1, 2);
+
+		const size_t distances[] = { 1, (size_t)pixelBytes, rowBytes };
+		size_t size = data.size();
+		size_t i = 0;
+		while (i < size)
+		{
+			int bestLength = 0;
+			size_t bestDistance = 0;
+			size_t maxLength = std::min((size_t)MAX_MATCH, size - i);
+			for (int d = 0; d < 3; d++)
+			{
+				size_t distance = distances[d];
+				if ((distance > i) || (distance > MAX_DISTANCE))
+				{
+					continue;
+				}
+				const unsigned char* pCurrent = &data[i];
+				const unsigned char* pEarlier = pCurrent - distance;
+				size_t length = 0;
+				while ((length < maxLength) && (pCurrent[length] == pEarlier[length]))
+				{
+					length++;
+				}
+				if ((int)length > bestLength)
+				{
+					bestLength = (int)length;
+					bestDistance = distance;
+				}
+			}
+
+			if (bestLength >= MIN_MATCH)
+			{
+				PutMatch(writer, bestLength, (int)bestDistance);
+				i += bestLength;
+			}
+			else
+			{
+				PutSymbol(writer, data[i]);
+				i++;
+			}
+		}
+		PutSymbol(writer, 256);
+		if (writer.bitCount > 0)
+		{
+			bytes.push_back((unsigned char)(writer.bits & 0xFF));
+		}
+
+		// Adler-32 checksum of the uncompressed data
+		unsigned int a = 1;
+		unsigned int b = 0;
+		for (size_t start = 0; start < size; start += 5552)
+		{
+			size_t end = std::min(size, start + 5552);
+			for (size_t j = start; j < end; j++)
+			{
+				a += data[j];
+				b += a;
+			}
+			a %= 65521;
+			b %= 65521;
+		}
+		unsigned int adler = (b << 16) | a;
+		for (int shift = 24; shift >= 0; shift -= 8)
+		{
+			bytes.push_back((unsigned char)(adler >> shift));
+		}
+	}
+
+	/***********************************************************
+	 *  UpdateCrc()
+	 *
+	 *  This function is used to add bytes to the CRC-32 that
+	 *  ends each PNG chunk.
+	 ***********************************************************/
+	unsigned int UpdateCrc(unsigned int crc, const unsigned char* data, size_t size)
+	{
+		static const std::vector<unsigned int> table = []()
+		{
+			std::vector<unsigned int> values(256);
+			for (unsigned int n = 0; n < 256; n++)
+			{
+				unsigned int c = n;
+				for (int k = 0; k < 8; k++)
+				{
+					c = (c & 1) ? (0xEDB88320u ^ (c >> 1)) : (c >> 1);
+				}
+				values[n] = c;
+			}
+			return(values);
+		}();
+
+		for (size_t i = 0; i < size; i++)
+		{
+			crc = table[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+		}
+		return(crc);
+	}
+
+	/***********************************************************
+	 *  PutBigEndian()
+	 *
+	 *  This function is used to add a 32 bit value to a PNG
+	 *  file, highest byte first.
+	 ***********************************************************/
+	void PutBigEndian(std::vector<unsigned char>& bytes, unsigned int value)
+	{
+		for (int shift = 24; shift >= 0; shift -= 8)
+		{
+			bytes.push_back((unsigned char)(value >> shift));
+		}
+	}
+
+	/***********************************************************
+	 *  EndChunk()
+	 *
+	 *  This function is used to finish a PNG chunk that starts
+	 *  at the passed in offset, filling in its length and
+	 *  adding its CRC.
+	 ***********************************************************/
+	void EndChunk(std::vector<unsigned char>& bytes, size_t chunkStart)
+	{
+		unsigned int length = (unsigned int)(bytes.size() - chunkStart - 8);
+		for (int i = 0; i < 4; i++)
+		{
+			bytes[chunkStart + i] = (unsigned char)(length >> (24 - i * 8));
+		}
+		unsigned int crc = UpdateCrc(0xFFFFFFFFu, &bytes[chunkStart + 4], length + 4) ^ 0xFFFFFFFFu;
+		PutBigEndian(bytes, crc);
+	}
+
+	/***********************************************************
+	 *  BeginChunk()
+	 *
+	 *  This function is used to start a PNG chunk, leaving
+	 *  room for its length, and return where it starts.
+	 ***********************************************************/
+	size_t BeginChunk(std::vector<unsigned char>& bytes, const char* type)
+	{
+		size_t chunkStart = bytes.size();
+		PutBigEndian(bytes, 0);
+		bytes.insert(bytes.end(), type, type + 4);
+		return(chunkStart);
+	}
+}
+
+/***********************************************************
+ *  FrameCapture()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+FrameCapture::FrameCapture()
+{
+	for (int i = 0; i < RING_SIZE; i++)
+	{
+		m_slots[i].buffer = 0;
+		m_slots[i].bufferSize = 0;
+		m_slots[i].fence = 0;
+		m_slots[i].width = 0;
+		m_slots[i].height = 0;
+		m_slots[i].format = FORMAT_PNG;
+		m_slots[i].bScreenshot = false;
+		m_slots[i].pPixels = NULL;
+		m_slots[i].state = SLOT_FREE;
+		m_slots[i].bWritten = false;
+	}
+	m_nextSlot = 0;
+	m_format = FORMAT_PNG;
+	m_frameNumber = 0;
+	m_capturedFrames = 0;
+	m_writtenFrames = 0;
+	m_droppedFrames = 0;
+	m_captureTime = 0.0;
+	m_bStopWorkers = false;
+}
+
+/***********************************************************
+ *  ~FrameCapture()
+ *
+ *  The destructor for the class.  The frames that have been
+ *  captured are written before the buffers are freed.
+ ***********************************************************/
+FrameCapture::~FrameCapture()
+{
+	if (m_workers.empty() == false)
+	{
+		Flush();
+		ReportCapture();
+
+		{
+			std::lock_guard<std::mutex> lock(m_jobMutex);
+			m_bStopWorkers = true;
+		}
+		m_jobAdded.notify_all();
+		for (size_t i = 0; i < m_workers.size(); i++)
+		{
+			m_workers[i].join();
+		}
+		m_workers.clear();
+	}
+
+	for (int i = 0; i < RING_SIZE; i++)
+	{
+		if (0 != m_slots[i].buffer)
+		{
+			glDeleteBuffers(1, &m_slots[i].buffer);
+			m_slots[i].buffer = 0;
+		}
+	}
+}
+
+/***********************************************************
+ *  Initialize()
+ *
+ *  This method is used for creating the ring of pixel pack
+ *  buffers and starting the worker threads.  The buffers
+ *  are sized by the first frame captured into them.
+ ***********************************************************/
+bool FrameCapture::Initialize()
+{
+	for (int i = 0; i < RING_SIZE; i++)
+	{
+		glGenBuffers(1, &m_slots[i].buffer);
+	}
+
+	int threadCount = (int)std::thread::hardware_concurrency() / 2;
+	threadCount = std::max(1, std::min(threadCount, MAX_WORKER_THREADS));
+	for (int i = 0; i < threadCount; i++)
+	{
+		m_workers.push_back(std::thread(&FrameCapture::WorkerLoop, this));
+	}
+	return(true);
+}
+
+/***********************************************************
+ *  SetFormat()
+ *
+ *  This method is used for setting the format of the frames
+ *  captured from now on.
+ ***********************************************************/
+void FrameCapture::SetFormat(CAPTURE_FORMAT format)
+{
+	m_format = format;
+}
+
+/***********************************************************
+ *  StartContinuous()
+ *
+ *  This method is used for saving every frame drawn from now
+ *  on into the passed in directory, which is created when
+ *  it does not exist.  The files are numbered from zero.
+ ***********************************************************/
+void FrameCapture::StartContinuous(const char* directory)
+{
+#ifdef _WIN32
+	_mkdir(directory);
+#else
+	mkdir(directory, 0755);
+#endif
+	m_continuousDirectory = directory;
+	m_frameNumber = 0;
+	std::cout << "INFO: Capturing every frame into " << directory << std::endl;
+}
+
+/***********************************************************
+ *  StopContinuous()
+ *
+ *  This method is used for no longer saving every frame.
+ *  The frames already captured are still written.
+ ***********************************************************/
+void FrameCapture::StopContinuous()
+{
+	m_continuousDirectory.clear();
+	ReportCapture();
+}
+
+/***********************************************************
+ *  RequestScreenshot()
+ *
+ *  This method is used for saving the next frame drawn into
+ *  the working directory, named after the current time.
+ ***********************************************************/
+void FrameCapture::RequestScreenshot()
+{
+	std::time_t now = std::time(NULL);
+	char timeText[32];
+	std::strftime(timeText, sizeof(timeText), "%Y%m%d_%H%M%S", std::localtime(&now));
+	m_screenshotPath = std::string("screenshot_") + timeText;
+}
+
+/***********************************************************
+ *  IsCaptureWanted()
+ *
+ *  This method returns whether the next frame drawn is to
+ *  be captured.
+ ***********************************************************/
+bool FrameCapture::IsCaptureWanted() const
+{
+	return((m_continuousDirectory.empty() == false) || (m_screenshotPath.empty() == false));
+}
+
+/***********************************************************
+ *  CaptureFrame()
+ *
+ *  This method is used for copying the bound read
+ *  framebuffer into the next buffer of the ring and placing
+ *  a fence after the copy.  The copy runs on the GPU with
+ *  the rest of the frame, so nothing waits for it here.
+ *  The frame is dropped when the next buffer is still being
+ *  read back or written.
+ ***********************************************************/
+void FrameCapture::CaptureFrame(int width, int height)
+{
+	if ((IsCaptureWanted() == false) || (width <= 0) || (height <= 0))
+	{
+		return;
+	}
+
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+	CAPTURE_SLOT& slot = m_slots[m_nextSlot];
+	if (slot.state != SLOT_FREE)
+	{
+		m_droppedFrames++;
+		if (m_continuousDirectory.empty() == false)
+		{
+			m_frameNumber++;
+		}
+		return;
+	}
+
+	// the file name is made here, so the numbers follow the
+	// frames even when some are dropped
+	std::ostringstream filePath;
+	slot.bScreenshot = (m_screenshotPath.empty() == false);
+	if (slot.bScreenshot == true)
+	{
+		filePath << m_screenshotPath;
+		m_screenshotPath.clear();
+	}
+	else
+	{
+		filePath << m_continuousDirectory << "/frame_" << std::setw(6) << std::setfill('0') << m_frameNumber;
+		m_frameNumber++;
+	}
+	if (m_format == FORMAT_RAW)
+	{
+		filePath << "_" << width << "x" << height << ".raw";
+	}
+	else
+	{
+		filePath << ".png";
+	}
+
+	// the whole window is read as RGBA, which needs no row padding
+	size_t frameSize = (size_t)width * (size_t)height * 4;
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.buffer);
+	if (slot.bufferSize != frameSize)
+	{
+		glBufferData(GL_PIXEL_PACK_BUFFER, frameSize, NULL, GL_STREAM_READ);
+		slot.bufferSize = frameSize;
+	}
+	glPixelStorei(GL_PACK_ALIGNMENT, 4);
+	glReadPixels(0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, 0);
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+	slot.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	slot.width = width;
+	slot.height = height;
+	slot.format = m_format;
+	slot.filePath = filePath.str();
+	slot.state = SLOT_READING;
+	m_nextSlot = (m_nextSlot + 1) % RING_SIZE;
+	m_capturedFrames++;
+
+	m_captureTime += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+/***********************************************************
+ *  Update()
+ *
+ *  This method is called once a frame.  The buffers whose
+ *  fences have passed are mapped and queued for the worker
+ *  threads, without waiting on the fences that have not,
+ *  and the buffers the workers have written are unmapped so
+ *  the ring can use them again.
+ ***********************************************************/
+void FrameCapture::Update()
+{
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+	for (int i = 0; i < RING_SIZE; i++)
+	{
+		CAPTURE_SLOT& slot = m_slots[i];
+		if (slot.state == SLOT_READING)
+		{
+			GLenum result = glClientWaitSync(slot.fence, GL_SYNC_FLUSH_COMMANDS_BIT, 0);
+			if ((result != GL_ALREADY_SIGNALED) && (result != GL_CONDITION_SATISFIED))
+			{
+				continue;
+			}
+			glDeleteSync(slot.fence);
+			slot.fence = 0;
+
+			glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.buffer);
+			slot.pPixels = (const unsigned char*)glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, slot.bufferSize, GL_MAP_READ_BIT);
+			glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+			if (NULL == slot.pPixels)
+			{
+				std::cout << "ERROR::CAPTURE_NOT_MAPPED: " << slot.filePath << std::endl;
+				slot.state = SLOT_FREE;
+				continue;
+			}
+
+			slot.state = SLOT_WRITING;
+			{
+				std::lock_guard<std::mutex> lock(m_jobMutex);
+				m_jobs.push_back(i);
+			}
+			m_jobAdded.notify_one();
+		}
+		else if (slot.state == SLOT_WRITTEN)
+		{
+			glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.buffer);
+			glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+			glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+			slot.pPixels = NULL;
+			if (slot.bWritten == true)
+			{
+				m_writtenFrames++;
+				if (slot.bScreenshot == true)
+				{
+					std::cout << "INFO: Saved screenshot: " << slot.filePath << std::endl;
+				}
+			}
+			slot.state = SLOT_FREE;
+		}
+	}
+
+	m_captureTime += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+/***********************************************************
+ *  HasPendingFrames()
+ *
+ *  This method returns whether any captured frame has not
+ *  been written and its buffer reused yet.
+ ***********************************************************/
+bool FrameCapture::HasPendingFrames() const
+{
+	for (int i = 0; i < RING_SIZE; i++)
+	{
+		if (m_slots[i].state != SLOT_FREE)
+		{
+			return(true);
+		}
+	}
+	return(false);
+}
+
+/***********************************************************
+ *  Flush()
+ *
+ *  This method is used for waiting until every captured
+ *  frame has been written, before the application exits.
+ ***********************************************************/
+void FrameCapture::Flush()
+{
+	glFinish();
+	while (HasPendingFrames() == true)
+	{
+		Update();
+		if (HasPendingFrames() == true)
+		{
+			std::this_thread::sleep_for(std::chrono::milliseconds(1));
+		}
+	}
+}
+
+/***********************************************************
+ *  ParseFormat()
+ *
+ *  This method is used for converting a capture format name
+ *  from the command line into a format value.
+ ***********************************************************/
+bool FrameCapture::ParseFormat(const char* name, CAPTURE_FORMAT& format)
+{
+	if (strcmp(name, "png") == 0)
+	{
+		format = FORMAT_PNG;
+	}
+	else if (strcmp(name, "raw") == 0)
+	{
+		format = FORMAT_RAW;
+	}
+	else
+	{
+		return(false);
+	}
+	return(true);
+}
+
+/***********************************************************
+ *  WorkerLoop()
+ *
+ *  This method is run by each worker thread.  It takes the
+ *  mapped slots from the queue and writes them, keeping its
+ *  encoding buffers from frame to frame, until it is asked
+ *  to stop.
+ ***********************************************************/
+void FrameCapture::WorkerLoop()
+{
+	std::vector<unsigned char> rows;
+	std::vector<unsigned char> bytes;
+	while (true)
+	{
+		int job = -1;
+		{
+			std::unique_lock<std::mutex> lock(m_jobMutex);
+			m_jobAdded.wait(lock, [this]() { return((m_bStopWorkers == true) || (m_jobs.empty() == false)); });
+			if (m_jobs.empty() == true)
+			{
+				return;
+			}
+			job = m_jobs.front();
+			m_jobs.pop_front();
+		}
+
+		CAPTURE_SLOT& slot = m_slots[job];
+		slot.bWritten = WriteSlot(slot, rows, bytes);
+		if (slot.bWritten == false)
+		{
+			std::cout << "ERROR::CAPTURE_NOT_SAVED: " << slot.filePath << std::endl;
+		}
+		slot.state = SLOT_WRITTEN;
+	}
+}
+
+/***********************************************************
+ *  WriteSlot()
+ *
+ *  This method is used for writing the mapped pixels of a
+ *  slot into its file, top row first.  A PNG file keeps the
+ *  red, green and blue channels, with each byte stored as
+ *  the difference from the pixel to its left, which turns
+ *  flat and smoothly shaded areas into runs that deflate
+ *  well.  A raw file is the RGBA bytes as they were read.
+ ***********************************************************/
+bool FrameCapture::WriteSlot(CAPTURE_SLOT& slot, std::vector<unsigned char>& rows, std::vector<unsigned char>& bytes)
+{
+	size_t sourceRowBytes = (size_t)slot.width * 4;
+
+	std::ofstream file(slot.filePath.c_str(), std::ios::binary | std::ios::trunc);
+	if (!file.is_open())
+	{
+		return(false);
+	}
+
+	if (slot.format == FORMAT_RAW)
+	{
+		for (int y = slot.height - 1; y >= 0; y--)
+		{
+			file.write((const char*)slot.pPixels + (size_t)y * sourceRowBytes, sourceRowBytes);
+		}
+	}
+	else
+	{
+		// filter each row with the difference from the pixel to the
+		// left, PNG filter type 1
+		size_t rowBytes = 1 + (size_t)slot.width * 3;
+		rows.resize(rowBytes * slot.height);
+		for (int y = 0; y < slot.height; y++)
+		{
+			const unsigned char* pSource = slot.pPixels + (size_t)(slot.height - 1 - y) * sourceRowBytes;
+			unsigned char* pRow = &rows[(size_t)y * rowBytes];
+			pRow[0] = 1;
+			for (int c = 0; c < 3; c++)
+			{
+				pRow[1 + c] = pSource[c];
+			}
+			for (int x = 1; x < slot.width; x++)
+			{
+				for (int c = 0; c < 3; c++)
+				{
+					pRow[1 + x * 3 + c] = (unsigned char)(pSource[x * 4 + c] - pSource[(x - 1) * 4 + c]);
+				}
+			}
+		}
+
+		bytes.clear();
+		const unsigned char signature[] = { 137, 'P', 'N', 'G', '\r', '\n', 26, '\n' };
+		bytes.insert(bytes.end(), signature, signature + 8);
+
+		// 8 bits per channel, RGB, no interlacing
+		size_t chunkStart = BeginChunk(bytes, "IHDR");
+		PutBigEndian(bytes, (unsigned int)slot.width);
+		PutBigEndian(bytes, (unsigned int)slot.height);
+		bytes.push_back(8);
+		bytes.push_back(2);
+		bytes.push_back(0);
+		bytes.push_back(0);
+		bytes.push_back(0);
+		EndChunk(bytes, chunkStart);
+
+		chunkStart = BeginChunk(bytes, "IDAT");
+		Deflate(rows, rowBytes, 3, bytes);
+		EndChunk(bytes, chunkStart);
+
+		chunkStart = BeginChunk(bytes, "IEND");
+		EndChunk(bytes, chunkStart);
+
+		file.write((const char*)&bytes[0], bytes.size());
+	}
+
+	if (!file)
+	{
+		file.close();
+		std::remove(slot.filePath.c_str());
+		return(false);
+	}
+	return(true);
+}
+
+/***********************************************************
+ *  ReportCapture()
+ *
+ *  This method is used for printing how many frames were
+ *  captured, written and dropped, and the time the render
+ *  thread spent on each captured frame.
+ ***********************************************************/
+void FrameCapture::ReportCapture()
+{
+	if ((m_capturedFrames == 0) && (m_droppedFrames == 0))
+	{
+		return;
+	}
+	std::cout << "INFO: Captured " << m_capturedFrames << " frames, " << m_writtenFrames << " written, "
+		<< m_droppedFrames << " dropped, render thread time: "
+		<< ((m_capturedFrames > 0) ? m_captureTime / m_capturedFrames : 0.0) << " ms per frame" << std::endl;
+}
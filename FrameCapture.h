@@ -0,0 +1,148 @@
+///////////////////////////////////////////////////////////////////////////////
+// framecapture.h
+// ============
+// save screenshots and continuous frame captures by reading the window
+// back through a ring of pixel buffers, encoding them on worker threads
+//
+//  Created for CS-330-Computational Graphics and Visualization
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <GL/glew.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+/***********************************************************
+ *  FrameCapture
+ *
+ *  This class contains the code for saving rendered frames
+ *  without waiting for the GPU.  Reading the window straight
+ *  into system memory would stall until every command before
+ *  it had finished.  Instead, each captured frame is copied
+ *  into one of a ring of pixel pack buffers, and a fence is
+ *  placed after the copy.  Once the fence has passed, a few
+ *  frames later, the buffer is mapped and handed to a worker
+ *  thread, which encodes the pixels into a PNG or raw file
+ *  straight from the mapped memory.  The buffer is unmapped
+ *  and reused once the file is written.  When every buffer
+ *  is still in use, the frame is dropped rather than waited
+ *  for, so the render thread only ever issues the copy.
+ ***********************************************************/
+class FrameCapture
+{
+public:
+	// file formats the frames are written in
+	enum CAPTURE_FORMAT
+	{
+		// 24 bit color PNG
+		FORMAT_PNG = 0,
+		// RGBA bytes with the top row first, and the size in the
+		// file name
+		FORMAT_RAW
+	};
+
+	// constructor
+	FrameCapture();
+	// destructor
+	~FrameCapture();
+
+	// create the pixel buffers and start the worker threads
+	bool Initialize();
+	// set the format of the files written from now on
+	void SetFormat(CAPTURE_FORMAT format);
+
+	// save every frame into the passed in directory
+	void StartContinuous(const char* directory);
+	// stop saving every frame
+	void StopContinuous();
+	// save the next frame into a file named after the time
+	void RequestScreenshot();
+
+	// check whether the next frame is to be captured
+	bool IsCaptureWanted() const;
+	// start reading back the bound read framebuffer
+	void CaptureFrame(int width, int height);
+	// hand the frames that have been read back to the worker
+	// threads, and reuse the buffers of the written ones
+	void Update();
+	// check whether any frames are still being read or written
+	bool HasPendingFrames() const;
+	// wait until every captured frame has been written
+	void Flush();
+
+	// parse a capture format name from the command line
+	static bool ParseFormat(const char* name, CAPTURE_FORMAT& format);
+
+private:
+	// number of frames that can be read back and written at once
+	static const int RING_SIZE = 6;
+
+	// what a buffer of the ring is being used for
+	enum SLOT_STATE
+	{
+		SLOT_FREE = 0,
+		// the copy has been issued and its fence has not passed
+		SLOT_READING,
+		// mapped, and being written by a worker thread
+		SLOT_WRITING,
+		// written, waiting to be unmapped
+		SLOT_WRITTEN
+	};
+
+	// a buffer of the ring and the frame it holds
+	struct CAPTURE_SLOT
+	{
+		GLuint buffer;
+		size_t bufferSize;
+		GLsync fence;
+		int width;
+		int height;
+		CAPTURE_FORMAT format;
+		std::string filePath;
+		bool bScreenshot;
+		// the mapped pixels, bottom row first
+		const unsigned char* pPixels;
+		std::atomic<int> state;
+		bool bWritten;
+	};
+
+	CAPTURE_SLOT m_slots[RING_SIZE];
+	int m_nextSlot;
+	CAPTURE_FORMAT m_format;
+
+	// directory every frame is saved into, or empty, and the
+	// number of the next frame saved there
+	std::string m_continuousDirectory;
+	long long m_frameNumber;
+	// file the next frame is saved into as a screenshot, or empty
+	std::string m_screenshotPath;
+
+	// frames captured, written and dropped, and the time the
+	// render thread spent capturing, in milliseconds
+	long long m_capturedFrames;
+	long long m_writtenFrames;
+	long long m_droppedFrames;
+	double m_captureTime;
+
+	// worker threads, which take the mapped slots from the queue
+	// and write them until asked to stop
+	std::vector<std::thread> m_workers;
+	std::mutex m_jobMutex;
+	std::condition_variable m_jobAdded;
+	std::deque<int> m_jobs;
+	bool m_bStopWorkers;
+
+	// wait for slots to write on a worker thread
+	void WorkerLoop();
+	// encode and write the frame of a slot
+	bool WriteSlot(CAPTURE_SLOT& slot, std::vector<unsigned char>& rows, std::vector<unsigned char>& bytes);
+	// print the number of frames captured and dropped
+	void ReportCapture();
+};
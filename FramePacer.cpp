@@ -0,0 +1,315 @@
+///////////////////////////////////////////////////////////////////////////////
+// framepacer.cpp
+// ============
+// control the swap interval and pace the rendered frames
+//
+//  Created for CS-330-Computational Graphics and Visualization
+///////////////////////////////////////////////////////////////////////////////
+
+#include "FramePacer.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+#include <thread>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#include <timeapi.h>
+#pragma comment(lib, "winmm.lib")
+#endif
+
+// declaration of the global variables and defines
+namespace
+{
+	// the length of each sleep step while waiting for a frame
+	const std::chrono::microseconds SLEEP_STEP(1000);
+	// the initial guess of how long a sleep step really takes
+	const double INITIAL_SLEEP_ESTIMATE = 0.005;
+	// the default time between statistics reports, in seconds
+	const double DEFAULT_REPORT_INTERVAL = 5.0;
+}
+
+/***********************************************************
+ *  FramePacer()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+FramePacer::FramePacer()
+{
+	m_swapMode = SWAP_VSYNC;
+	m_targetFrameTime = 0.0;
+	m_bHaveLastFrame = false;
+	m_sleepEstimate = INITIAL_SLEEP_ESTIMATE;
+	m_sleepMean = INITIAL_SLEEP_ESTIMATE;
+	m_sleepM2 = 0.0;
+	m_sleepCount = 1;
+	m_reportInterval = DEFAULT_REPORT_INTERVAL;
+	m_lastReport = Clock::now();
+	m_missedFrames = 0;
+
+#ifdef _WIN32
+	// raise the system timer resolution so short sleeps are possible
+	timeBeginPeriod(1);
+#endif
+}
+
+/***********************************************************
+ *  ~FramePacer()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+FramePacer::~FramePacer()
+{
+#ifdef _WIN32
+	timeEndPeriod(1);
+#endif
+}
+
+/***********************************************************
+ *  SetSwapMode()
+ *
+ *  This method is used for setting the buffer swap interval
+ *  on the current OpenGL context.  Adaptive sync falls back
+ *  to regular vsync when the driver does not support tearing
+ *  on late frames.
+ ***********************************************************/
+void FramePacer::SetSwapMode(SWAP_MODE swapMode)
+{
+	int swapInterval = 1;
+
+	switch (swapMode)
+	{
+	case SWAP_IMMEDIATE:
+		swapInterval = 0;
+		break;
+	case SWAP_ADAPTIVE:
+		if (glfwExtensionSupported("WGL_EXT_swap_control_tear") ||
+			glfwExtensionSupported("GLX_EXT_swap_control_tear"))
+		{
+			swapInterval = -1;
+		}
+		else
+		{
+			std::cout << "INFO: Adaptive sync is not supported, using vsync" << std::endl;
+			swapMode = SWAP_VSYNC;
+		}
+		break;
+	default:
+		swapMode = SWAP_VSYNC;
+		break;
+	}
+
+	glfwSwapInterval(swapInterval);
+	m_swapMode = swapMode;
+}
+
+/***********************************************************
+ *  SetFrameRateCap()
+ *
+ *  This method is used for setting the highest frame rate
+ *  that will be rendered.  A value of zero removes the cap.
+ ***********************************************************/
+void FramePacer::SetFrameRateCap(double framesPerSecond)
+{
+	if (framesPerSecond > 0.0)
+	{
+		m_targetFrameTime = 1.0 / framesPerSecond;
+	}
+	else
+	{
+		m_targetFrameTime = 0.0;
+	}
+	m_bHaveLastFrame = false;
+}
+
+/***********************************************************
+ *  SetReportInterval()
+ *
+ *  This method is used for setting how often the frame time
+ *  statistics are printed.  A value of zero turns them off.
+ ***********************************************************/
+void FramePacer::SetReportInterval(double seconds)
+{
+	m_reportInterval = seconds;
+}
+
+/***********************************************************
+ *  WaitForNextFrame()
+ *
+ *  This method is called at the start of every rendered
+ *  frame.  When a frame rate cap is set it waits until the
+ *  frame is due, so that the input sampled afterwards is as
+ *  fresh as possible when the camera is updated.
+ ***********************************************************/
+void FramePacer::WaitForNextFrame()
+{
+	Clock::time_point frameStart;
+
+	if ((m_bHaveLastFrame == true) && (m_targetFrameTime > 0.0))
+	{
+		Clock::time_point deadline = m_lastFrameStart +
+			std::chrono::duration_cast<Clock::duration>(
+				std::chrono::duration<double>(m_targetFrameTime));
+
+		if (Clock::now() < deadline)
+		{
+			WaitUntil(deadline);
+			frameStart = deadline;
+		}
+		else
+		{
+			// the frame is late, so start it now rather than
+			// trying to catch up with several quick frames
+			frameStart = Clock::now();
+			m_missedFrames++;
+		}
+	}
+	else
+	{
+		frameStart = Clock::now();
+	}
+
+	// record the time between frames for the statistics
+	if (m_bHaveLastFrame == true)
+	{
+		double frameTime = std::chrono::duration<double>(
+			Clock::now() - m_lastFrameStart).count();
+		m_frameTimes.push_back(frameTime);
+	}
+
+	m_lastFrameStart = frameStart;
+	m_bHaveLastFrame = true;
+
+	if ((m_reportInterval > 0.0) &&
+		(std::chrono::duration<double>(Clock::now() - m_lastReport).count() >= m_reportInterval))
+	{
+		ReportStatistics();
+	}
+}
+
+/***********************************************************
+ *  ResetTiming()
+ *
+ *  This method is called when the render loop has been idle
+ *  so that the idle time is not counted as a frame time.
+ ***********************************************************/
+void FramePacer::ResetTiming()
+{
+	m_bHaveLastFrame = false;
+}
+
+/***********************************************************
+ *  WaitUntil()
+ *
+ *  This method is used for waiting until the passed in time.
+ *  It sleeps in short steps while there is clearly enough
+ *  time left, using a running estimate of how long a sleep
+ *  really takes, and then spins for the remainder.
+ ***********************************************************/
+void FramePacer::WaitUntil(Clock::time_point deadline)
+{
+	while (true)
+	{
+		double remaining = std::chrono::duration<double>(deadline - Clock::now()).count();
+		if (remaining <= m_sleepEstimate)
+		{
+			break;
+		}
+
+		Clock::time_point sleepStart = Clock::now();
+		std::this_thread::sleep_for(SLEEP_STEP);
+		double observed = std::chrono::duration<double>(Clock::now() - sleepStart).count();
+
+		// update the mean and deviation of the sleep duration
+		m_sleepCount++;
+		double delta = observed - m_sleepMean;
+		m_sleepMean += delta / m_sleepCount;
+		m_sleepM2 += delta * (observed - m_sleepMean);
+		double deviation = std::sqrt(m_sleepM2 / (m_sleepCount - 1));
+		m_sleepEstimate = m_sleepMean + deviation;
+	}
+
+	// spin for the last part of the wait
+	while (Clock::now() < deadline)
+	{
+		std::this_thread::yield();
+	}
+}
+
+/***********************************************************
+ *  ReportStatistics()
+ *
+ *  This method is used for printing the average frame time,
+ *  the jitter (standard deviation) and the worst frame times
+ *  collected since the last report.
+ ***********************************************************/
+void FramePacer::ReportStatistics()
+{
+	m_lastReport = Clock::now();
+
+	if (m_frameTimes.size() < 2)
+	{
+		m_frameTimes.clear();
+		m_missedFrames = 0;
+		return;
+	}
+
+	double total = 0.0;
+	for (size_t i = 0; i < m_frameTimes.size(); i++)
+	{
+		total += m_frameTimes[i];
+	}
+	double mean = total / m_frameTimes.size();
+
+	double variance = 0.0;
+	for (size_t i = 0; i < m_frameTimes.size(); i++)
+	{
+		variance += (m_frameTimes[i] - mean) * (m_frameTimes[i] - mean);
+	}
+	double jitter = std::sqrt(variance / (m_frameTimes.size() - 1));
+
+	std::sort(m_frameTimes.begin(), m_frameTimes.end());
+	double p99 = m_frameTimes[(m_frameTimes.size() * 99) / 100];
+
+	std::cout << "INFO: Frames: " << m_frameTimes.size()
+		<< ", avg: " << mean * 1000.0 << " ms"
+		<< ", jitter: " << jitter * 1000.0 << " ms"
+		<< ", min: " << m_frameTimes.front() * 1000.0 << " ms"
+		<< ", p99: " << p99 * 1000.0 << " ms"
+		<< ", max: " << m_frameTimes.back() * 1000.0 << " ms"
+		<< ", late: " << m_missedFrames << std::endl;
+
+	m_frameTimes.clear();
+	m_missedFrames = 0;
+}
+
+/***********************************************************
+ *  ParseSwapMode()
+ *
+ *  This method is used for converting a swap mode name from
+ *  the command line into a swap mode value.
+ ***********************************************************/
+bool FramePacer::ParseSwapMode(const char* name, SWAP_MODE& swapMode)
+{
+	if (strcmp(name, "off") == 0)
+	{
+		swapMode = SWAP_IMMEDIATE;
+	}
+	else if (strcmp(name, "on") == 0)
+	{
+		swapMode = SWAP_VSYNC;
+	}
+	else if (strcmp(name, "adaptive") == 0)
+	{
+		swapMode = SWAP_ADAPTIVE;
+	}
+	else
+	{
+		return(false);
+	}
+	return(true);
+}
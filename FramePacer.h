@@ -0,0 +1,86 @@
+///////////////////////////////////////////////////////////////////////////////
+// framepacer.h
+// ============
+// control the swap interval and pace the rendered frames
+//
+//  Created for CS-330-Computational Graphics and Visualization
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+// GLFW library
+#include "GLFW/glfw3.h"
+
+#include <chrono>
+#include <vector>
+
+/***********************************************************
+ *  FramePacer
+ *
+ *  This class contains the code for setting the buffer swap
+ *  interval, limiting the frame rate with a sleep-plus-spin
+ *  wait, and reporting frame time jitter statistics.
+ ***********************************************************/
+class FramePacer
+{
+public:
+	// buffer swap synchronization modes
+	enum SWAP_MODE
+	{
+		SWAP_IMMEDIATE = 0,
+		SWAP_VSYNC,
+		SWAP_ADAPTIVE
+	};
+
+	// constructor
+	FramePacer();
+	// destructor
+	~FramePacer();
+
+	// set the swap mode on the current OpenGL context
+	void SetSwapMode(SWAP_MODE swapMode);
+	// set the frame rate cap, or zero for no cap
+	void SetFrameRateCap(double framesPerSecond);
+	// set how often the frame time statistics are reported
+	void SetReportInterval(double seconds);
+
+	// wait until the next frame is due to start
+	void WaitForNextFrame();
+	// forget the last frame time after the render loop was idle
+	void ResetTiming();
+
+	// parse a swap mode name from the command line
+	static bool ParseSwapMode(const char* name, SWAP_MODE& swapMode);
+
+private:
+	typedef std::chrono::steady_clock Clock;
+
+	// the active swap mode
+	SWAP_MODE m_swapMode;
+	// the target time between frames, in seconds, or zero
+	double m_targetFrameTime;
+	// the start time of the previous frame
+	Clock::time_point m_lastFrameStart;
+	// true when the previous frame start time is valid
+	bool m_bHaveLastFrame;
+
+	// running estimate of how long a short sleep really takes
+	double m_sleepEstimate;
+	double m_sleepMean;
+	double m_sleepM2;
+	long m_sleepCount;
+
+	// frame intervals collected since the last report
+	std::vector<double> m_frameTimes;
+	// time between statistics reports, in seconds
+	double m_reportInterval;
+	// the time of the last statistics report
+	Clock::time_point m_lastReport;
+	// frames that started later than their deadline
+	int m_missedFrames;
+
+	// sleep and then spin until the passed in deadline
+	void WaitUntil(Clock::time_point deadline);
+	// print the frame time statistics and start a new period
+	void ReportStatistics();
+};
@@ -0,0 +1,705 @@
+///////////////////////////////////////////////////////////////////////////////
+// impostoratlas.cpp
+// ============
+// bake groups of objects into octahedral atlases of views, and draw each
+// distant group as a single camera facing quad
+//
+//  Created for CS-330-Computational Graphics and Visualization
+///////////////////////////////////////////////////////////////////////////////
+
+#include "ImpostorAtlas.h"
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+
+// declaration of the global variables and defines
+namespace
+{
+	// identifies a baked impostor file written by this class
+	const unsigned int IMPOSTOR_FILE_MAGIC = 0x53504D49;	// "IMPS"
+	// increase when the layout of the file or the bake changes
+	const unsigned int IMPOSTOR_FILE_VERSION = 1;
+
+	// FNV-1a hash constants
+	const unsigned long long HASH_OFFSET = 14695981039346656037ULL;
+	const unsigned long long HASH_PRIME = 1099511628211ULL;
+
+	// texture units the atlas is read from, after the ones used by
+	// the scene textures, the G-buffer and the baked probes
+	const GLuint COLOR_TEXTURE_UNIT = 23;
+	const GLuint DEPTH_TEXTURE_UNIT = 24;
+	// coarsest mipmap level, where a frame is 8 pixels across
+	const int MAX_MIPMAP_LEVEL = 3;
+	// values in each quad's instance, the bounding sphere and the
+	// atlas layer
+	const int INSTANCE_FLOATS = 5;
+
+	// header written at the start of each baked impostor file
+	struct IMPOSTOR_FILE_HEADER
+	{
+		unsigned int magic;
+		unsigned int version;
+		unsigned long long key;
+		unsigned int groupCount;
+		unsigned int frameGrid;
+		unsigned int frameSize;
+		unsigned int reserved;
+	};
+
+	/***********************************************************
+	 *  HashBytes()
+	 *
+	 *  This function is used to add a block of memory into a
+	 *  running FNV-1a hash.
+	 ***********************************************************/
+	unsigned long long HashBytes(unsigned long long hash, const void* data, size_t size)
+	{
+		const unsigned char* bytes = (const unsigned char*)data;
+		for (size_t i = 0; i < size; i++)
+		{
+			hash ^= bytes[i];
+			hash *= HASH_PRIME;
+		}
+		return(hash);
+	}
+
+	/***********************************************************
+	 *  ReadSourceFile()
+	 *
+	 *  This function is used to read a whole shader source
+	 *  file into a string.
+	 ***********************************************************/
+	bool ReadSourceFile(const char* filePath, std::string& source)
+	{
+		std::ifstream file(filePath);
+		if (!file.is_open())
+		{
+			std::cout << "ERROR::SHADER_FILE_NOT_READ: " << filePath << std::endl;
+			return(false);
+		}
+
+		std::stringstream stream;
+		stream << file.rdbuf();
+		source = stream.str();
+		return(true);
+	}
+
+	/***********************************************************
+	 *  CompileShader()
+	 *
+	 *  This function is used to compile one shader stage from
+	 *  a source file, returning zero when it fails.
+	 ***********************************************************/
+	GLuint CompileShader(GLenum type, const char* filePath)
+	{
+		std::string source;
+		if (ReadSourceFile(filePath, source) == false)
+		{
+			return(0);
+		}
+
+		const char* sourceText = source.c_str();
+		GLuint shader = glCreateShader(type);
+		glShaderSource(shader, 1, &sourceText, NULL);
+		glCompileShader(shader);
+
+		GLint success = 0;
+		glGetShaderiv(shader, GL_COMPILE_STATUS, &success);
+		if (!success)
+		{
+			char infoLog[1024];
+			glGetShaderInfoLog(shader, 1024, NULL, infoLog);
+			std::cout << "ERROR::SHADER_COMPILATION_ERROR\n" << infoLog << std::endl;
+			glDeleteShader(shader);
+			return(0);
+		}
+		return(shader);
+	}
+
+	/***********************************************************
+	 *  DecodeDirection()
+	 *
+	 *  This function is used to unpack a direction from its
+	 *  octahedral coordinates, with the upper half of the
+	 *  sphere in the middle of the square.  It matches the
+	 *  function in the impostor fragment shader.
+	 ***********************************************************/
+	glm::vec3 DecodeDirection(const glm::vec2& coordinates)
+	{
+		glm::vec2 encoded = coordinates * 2.0f - 1.0f;
+		glm::vec3 direction(encoded.x, 1.0f - std::fabs(encoded.x) - std::fabs(encoded.y), encoded.y);
+		if (direction.y < 0.0f)
+		{
+			float signX = (direction.x >= 0.0f) ? 1.0f : -1.0f;
+			float signZ = (direction.z >= 0.0f) ? 1.0f : -1.0f;
+			float x = (1.0f - std::fabs(direction.z)) * signX;
+			float z = (1.0f - std::fabs(direction.x)) * signZ;
+			direction.x = x;
+			direction.z = z;
+		}
+		return(glm::normalize(direction));
+	}
+
+	/***********************************************************
+	 *  CreateArrayTexture()
+	 *
+	 *  This function is used to allocate an array texture with
+	 *  one atlas layer for each group.
+	 ***********************************************************/
+	GLuint CreateArrayTexture(GLenum internalFormat, GLenum format, GLenum type, int layers, const void* texels, bool bMipmaps)
+	{
+		GLuint texture = 0;
+		glGenTextures(1, &texture);
+		glBindTexture(GL_TEXTURE_2D_ARRAY, texture);
+		glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, internalFormat,
+			ImpostorAtlas::ATLAS_SIZE, ImpostorAtlas::ATLAS_SIZE, layers, 0, format, type, texels);
+		glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+		glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+		glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, (bMipmaps == true) ? GL_LINEAR : GL_NEAREST);
+		if (bMipmaps == true)
+		{
+			// the coarser levels stop while a frame still has a few
+			// pixels, so the frames do not run into each other
+			glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAX_LEVEL, MAX_MIPMAP_LEVEL);
+			glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+			glGenerateMipmap(GL_TEXTURE_2D_ARRAY);
+		}
+		else
+		{
+			glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+		}
+		glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+		return(texture);
+	}
+}
+
+/***********************************************************
+ *  ImpostorAtlas()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+ImpostorAtlas::ImpostorAtlas()
+{
+	m_groupKey = 0;
+	m_bakeFramebuffer = 0;
+	m_bakeColorTexture = 0;
+	m_bakeDepthTexture = 0;
+	for (int i = 0; i < 4; i++)
+	{
+		m_savedViewport[i] = 0;
+	}
+	m_savedFramebuffer = 0;
+	m_colorTexture = 0;
+	m_depthTexture = 0;
+	m_program = 0;
+	m_vertexArray = 0;
+	m_instanceBuffer = 0;
+}
+
+/***********************************************************
+ *  ~ImpostorAtlas()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+ImpostorAtlas::~ImpostorAtlas()
+{
+	DestroyBakeTargets();
+	if (m_colorTexture != 0)
+	{
+		glDeleteTextures(1, &m_colorTexture);
+		m_colorTexture = 0;
+	}
+	if (m_depthTexture != 0)
+	{
+		glDeleteTextures(1, &m_depthTexture);
+		m_depthTexture = 0;
+	}
+	if (m_instanceBuffer != 0)
+	{
+		glDeleteBuffers(1, &m_instanceBuffer);
+		m_instanceBuffer = 0;
+	}
+	if (m_vertexArray != 0)
+	{
+		glDeleteVertexArrays(1, &m_vertexArray);
+		m_vertexArray = 0;
+	}
+	if (m_program != 0)
+	{
+		glDeleteProgram(m_program);
+		m_program = 0;
+	}
+}
+
+/***********************************************************
+ *  Initialize()
+ *
+ *  This method is used for compiling the impostor shaders
+ *  and creating the vertex array that feeds one bounding
+ *  sphere and atlas layer to each quad.  The corners of the
+ *  quads come from the vertex index, so there is no vertex
+ *  buffer.
+ ***********************************************************/
+bool ImpostorAtlas::Initialize(const char* vertexShaderPath, const char* fragmentShaderPath)
+{
+	GLuint vertexShader = CompileShader(GL_VERTEX_SHADER, vertexShaderPath);
+	GLuint fragmentShader = CompileShader(GL_FRAGMENT_SHADER, fragmentShaderPath);
+	if ((vertexShader == 0) || (fragmentShader == 0))
+	{
+		glDeleteShader(vertexShader);
+		glDeleteShader(fragmentShader);
+		return(false);
+	}
+
+	m_program = glCreateProgram();
+	glAttachShader(m_program, vertexShader);
+	glAttachShader(m_program, fragmentShader);
+	glLinkProgram(m_program);
+	glDeleteShader(vertexShader);
+	glDeleteShader(fragmentShader);
+
+	GLint success = 0;
+	glGetProgramiv(m_program, GL_LINK_STATUS, &success);
+	if (!success)
+	{
+		char infoLog[1024];
+		glGetProgramInfoLog(m_program, 1024, NULL, infoLog);
+		std::cout << "ERROR::PROGRAM_LINKING_ERROR\n" << infoLog << std::endl;
+		glDeleteProgram(m_program);
+		m_program = 0;
+		return(false);
+	}
+
+	glGenVertexArrays(1, &m_vertexArray);
+	glGenBuffers(1, &m_instanceBuffer);
+	glBindVertexArray(m_vertexArray);
+	glBindBuffer(GL_ARRAY_BUFFER, m_instanceBuffer);
+	glEnableVertexAttribArray(0);
+	glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, INSTANCE_FLOATS * sizeof(float), (void*)0);
+	glVertexAttribDivisor(0, 1);
+	glEnableVertexAttribArray(1);
+	glVertexAttribPointer(1, 1, GL_FLOAT, GL_FALSE, INSTANCE_FLOATS * sizeof(float), (void*)(4 * sizeof(float)));
+	glVertexAttribDivisor(1, 1);
+	glBindVertexArray(0);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+	return(true);
+}
+
+/***********************************************************
+ *  SetGroups()
+ *
+ *  This method is used for setting the groups that are
+ *  baked or loaded.  The key of the cooked file is hashed
+ *  from their bounds and the values describing the objects
+ *  in them, so an edit to any grouped object bakes again.
+ ***********************************************************/
+void ImpostorAtlas::SetGroups(const std::vector<IMPOSTOR_GROUP>& groups, const std::vector<float>& description)
+{
+	m_groups = groups;
+	m_colorTexels.clear();
+	m_depthTexels.clear();
+
+	unsigned int version = IMPOSTOR_FILE_VERSION;
+	m_groupKey = HashBytes(HASH_OFFSET, &version, sizeof(version));
+	for (size_t i = 0; i < m_groups.size(); i++)
+	{
+		m_groupKey = HashBytes(m_groupKey, &m_groups[i].center[0], sizeof(float) * 3);
+		m_groupKey = HashBytes(m_groupKey, &m_groups[i].radius, sizeof(float));
+	}
+	if (description.empty() == false)
+	{
+		m_groupKey = HashBytes(m_groupKey, &description[0], description.size() * sizeof(float));
+	}
+}
+
+/***********************************************************
+ *  GetGroupCount()
+ *
+ *  This method is used for getting the number of groups.
+ ***********************************************************/
+int ImpostorAtlas::GetGroupCount() const
+{
+	return((int)m_groups.size());
+}
+
+/***********************************************************
+ *  GetFrameDirection()
+ *
+ *  This method is used for getting the direction from the
+ *  center of a group towards the camera of a frame.  The
+ *  frames are spread evenly over the octahedral square, so
+ *  the edges of the square are seen from below.
+ ***********************************************************/
+glm::vec3 ImpostorAtlas::GetFrameDirection(int frame)
+{
+	int column = frame % FRAME_GRID;
+	int row = frame / FRAME_GRID;
+	return(DecodeDirection(glm::vec2((float)column, (float)row) / (float)(FRAME_GRID - 1)));
+}
+
+/***********************************************************
+ *  GetFrameView()
+ *
+ *  This method is used for getting the camera of a frame,
+ *  which looks at the center of the group from the edge of
+ *  its bounding sphere.  The orthographic projection takes
+ *  in the whole sphere, so the depth runs linearly from its
+ *  near side to its far side.
+ ***********************************************************/
+void ImpostorAtlas::GetFrameView(
+	int group,
+	int frame,
+	glm::mat4& view,
+	glm::mat4& projection,
+	glm::vec3& viewPosition) const
+{
+	const IMPOSTOR_GROUP& impostor = m_groups[group];
+	glm::vec3 direction = GetFrameDirection(frame);
+	glm::vec3 up = (std::fabs(direction.y) > 0.999f) ? glm::vec3(0.0f, 0.0f, 1.0f) : glm::vec3(0.0f, 1.0f, 0.0f);
+
+	viewPosition = impostor.center + direction * impostor.radius;
+	view = glm::lookAt(viewPosition, impostor.center, up);
+	projection = glm::ortho(-impostor.radius, impostor.radius, -impostor.radius, impostor.radius,
+		0.0f, 2.0f * impostor.radius);
+}
+
+/***********************************************************
+ *  BeginBake()
+ *
+ *  This method is used for creating the framebuffer that the
+ *  frames are rendered into, with a color and a depth layer
+ *  for each group.
+ ***********************************************************/
+bool ImpostorAtlas::BeginBake()
+{
+	if (m_groups.empty() == true)
+	{
+		return(false);
+	}
+
+	DestroyBakeTargets();
+	glGetIntegerv(GL_VIEWPORT, m_savedViewport);
+	glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &m_savedFramebuffer);
+
+	int layers = (int)m_groups.size();
+	m_bakeColorTexture = CreateArrayTexture(GL_RGBA8, GL_RGBA, GL_UNSIGNED_BYTE, layers, NULL, false);
+	m_bakeDepthTexture = CreateArrayTexture(GL_DEPTH_COMPONENT16, GL_DEPTH_COMPONENT, GL_UNSIGNED_SHORT, layers, NULL, false);
+
+	glGenFramebuffers(1, &m_bakeFramebuffer);
+	glBindFramebuffer(GL_FRAMEBUFFER, m_bakeFramebuffer);
+	glFramebufferTextureLayer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, m_bakeColorTexture, 0, 0);
+	glFramebufferTextureLayer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, m_bakeDepthTexture, 0, 0);
+	if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+	{
+		std::cout << "ERROR::IMPOSTOR_FRAMEBUFFER_INCOMPLETE" << std::endl;
+		glBindFramebuffer(GL_FRAMEBUFFER, (GLuint)m_savedFramebuffer);
+		DestroyBakeTargets();
+		return(false);
+	}
+
+	return(true);
+}
+
+/***********************************************************
+ *  BeginFrame()
+ *
+ *  This method is used for directing the rendering into one
+ *  frame of a group's layer.  The layer is cleared to no
+ *  coverage and the far depth when its first frame begins.
+ ***********************************************************/
+void ImpostorAtlas::BeginFrame(int group, int frame)
+{
+	glBindFramebuffer(GL_FRAMEBUFFER, m_bakeFramebuffer);
+	glFramebufferTextureLayer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, m_bakeColorTexture, 0, group);
+	glFramebufferTextureLayer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, m_bakeDepthTexture, 0, group);
+
+	if (frame == 0)
+	{
+		const GLfloat clearColor[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+		const GLfloat clearDepth = 1.0f;
+		glClearBufferfv(GL_COLOR, 0, clearColor);
+		glClearBufferfv(GL_DEPTH, 0, &clearDepth);
+	}
+
+	glViewport((frame % FRAME_GRID) * FRAME_SIZE, (frame / FRAME_GRID) * FRAME_SIZE, FRAME_SIZE, FRAME_SIZE);
+}
+
+/***********************************************************
+ *  EndBake()
+ *
+ *  This method is used for reading the baked layers back,
+ *  so they can be saved and uploaded with mipmaps, and for
+ *  putting back the framebuffer and viewport.
+ ***********************************************************/
+void ImpostorAtlas::EndBake()
+{
+	if (m_bakeFramebuffer == 0)
+	{
+		return;
+	}
+
+	size_t layerTexels = (size_t)ATLAS_SIZE * ATLAS_SIZE;
+	m_colorTexels.resize(layerTexels * 4 * m_groups.size());
+	m_depthTexels.resize(layerTexels * m_groups.size());
+
+	glPixelStorei(GL_PACK_ALIGNMENT, 1);
+	glBindTexture(GL_TEXTURE_2D_ARRAY, m_bakeColorTexture);
+	glGetTexImage(GL_TEXTURE_2D_ARRAY, 0, GL_RGBA, GL_UNSIGNED_BYTE, &m_colorTexels[0]);
+	glBindTexture(GL_TEXTURE_2D_ARRAY, m_bakeDepthTexture);
+	glGetTexImage(GL_TEXTURE_2D_ARRAY, 0, GL_DEPTH_COMPONENT, GL_UNSIGNED_SHORT, &m_depthTexels[0]);
+	glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+	glPixelStorei(GL_PACK_ALIGNMENT, 4);
+
+	glBindFramebuffer(GL_FRAMEBUFFER, (GLuint)m_savedFramebuffer);
+	glViewport(m_savedViewport[0], m_savedViewport[1], m_savedViewport[2], m_savedViewport[3]);
+	DestroyBakeTargets();
+}
+
+/***********************************************************
+ *  DestroyBakeTargets()
+ *
+ *  This method is used for freeing the framebuffer and the
+ *  textures the frames were rendered into.
+ ***********************************************************/
+void ImpostorAtlas::DestroyBakeTargets()
+{
+	if (m_bakeFramebuffer != 0)
+	{
+		glDeleteFramebuffers(1, &m_bakeFramebuffer);
+		m_bakeFramebuffer = 0;
+	}
+	if (m_bakeColorTexture != 0)
+	{
+		glDeleteTextures(1, &m_bakeColorTexture);
+		m_bakeColorTexture = 0;
+	}
+	if (m_bakeDepthTexture != 0)
+	{
+		glDeleteTextures(1, &m_bakeDepthTexture);
+		m_bakeDepthTexture = 0;
+	}
+}
+
+/***********************************************************
+ *  Save()
+ *
+ *  This method is used for writing the baked layers to a
+ *  cooked file, along with the key of the groups they were
+ *  baked for.
+ ***********************************************************/
+bool ImpostorAtlas::Save(const char* filePath) const
+{
+	if ((m_groups.empty() == true) || (m_colorTexels.empty() == true))
+	{
+		return(false);
+	}
+
+	IMPOSTOR_FILE_HEADER header;
+	header.magic = IMPOSTOR_FILE_MAGIC;
+	header.version = IMPOSTOR_FILE_VERSION;
+	header.key = m_groupKey;
+	header.groupCount = (unsigned int)m_groups.size();
+	header.frameGrid = FRAME_GRID;
+	header.frameSize = FRAME_SIZE;
+	header.reserved = 0;
+
+	std::ofstream file(filePath, std::ios::binary | std::ios::trunc);
+	if (!file.is_open())
+	{
+		return(false);
+	}
+	file.write((const char*)&header, sizeof(header));
+	file.write((const char*)&m_colorTexels[0], m_colorTexels.size());
+	file.write((const char*)&m_depthTexels[0], m_depthTexels.size() * sizeof(unsigned short));
+	if (!file)
+	{
+		file.close();
+		std::remove(filePath);
+		return(false);
+	}
+
+	return(true);
+}
+
+/***********************************************************
+ *  Load()
+ *
+ *  This method is used for reading baked layers from a
+ *  cooked file.  Layers baked for different groups or with
+ *  a different frame layout are not used, so the impostors
+ *  never show objects that have since changed.
+ ***********************************************************/
+bool ImpostorAtlas::Load(const char* filePath)
+{
+	std::ifstream file(filePath, std::ios::binary);
+	if (!file.is_open())
+	{
+		return(false);
+	}
+
+	IMPOSTOR_FILE_HEADER header;
+	file.read((char*)&header, sizeof(header));
+	if (!file ||
+		(header.magic != IMPOSTOR_FILE_MAGIC) ||
+		(header.version != IMPOSTOR_FILE_VERSION) ||
+		(header.key != m_groupKey) ||
+		(header.groupCount != (unsigned int)m_groups.size()) ||
+		(header.frameGrid != (unsigned int)FRAME_GRID) ||
+		(header.frameSize != (unsigned int)FRAME_SIZE) ||
+		(header.groupCount == 0))
+	{
+		std::cout << "INFO: Baked impostors in " << filePath << " are out of date" << std::endl;
+		return(false);
+	}
+
+	size_t layerTexels = (size_t)ATLAS_SIZE * ATLAS_SIZE;
+	std::vector<unsigned char> colorTexels(layerTexels * 4 * header.groupCount);
+	std::vector<unsigned short> depthTexels(layerTexels * header.groupCount);
+	file.read((char*)&colorTexels[0], colorTexels.size());
+	file.read((char*)&depthTexels[0], depthTexels.size() * sizeof(unsigned short));
+	if (!file)
+	{
+		return(false);
+	}
+
+	m_colorTexels.swap(colorTexels);
+	m_depthTexels.swap(depthTexels);
+	return(true);
+}
+
+/***********************************************************
+ *  CreateTextures()
+ *
+ *  This method is used for uploading the baked layers into
+ *  the array textures the impostor shader samples.  Both
+ *  are filtered and mipmapped, since a distant group covers
+ *  fewer pixels than a frame has.
+ ***********************************************************/
+bool ImpostorAtlas::CreateTextures()
+{
+	if ((m_colorTexels.empty() == true) || (m_depthTexels.empty() == true))
+	{
+		return(false);
+	}
+
+	if (m_colorTexture != 0)
+	{
+		glDeleteTextures(1, &m_colorTexture);
+	}
+	if (m_depthTexture != 0)
+	{
+		glDeleteTextures(1, &m_depthTexture);
+	}
+
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+	int layers = (int)m_groups.size();
+	m_colorTexture = CreateArrayTexture(GL_RGBA8, GL_RGBA, GL_UNSIGNED_BYTE, layers, &m_colorTexels[0], true);
+	m_depthTexture = CreateArrayTexture(GL_R16, GL_RED, GL_UNSIGNED_SHORT, layers, &m_depthTexels[0], true);
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+
+	return((m_colorTexture != 0) && (m_depthTexture != 0));
+}
+
+/***********************************************************
+ *  IsDistant()
+ *
+ *  This method is used for checking whether a group's
+ *  bounding sphere covers no more pixels on the screen than
+ *  a baked frame has, at which point the impostor shows as
+ *  much detail as the objects would.
+ ***********************************************************/
+bool ImpostorAtlas::IsDistant(
+	int group,
+	const glm::vec3& viewPosition,
+	const glm::mat4& projection,
+	int viewportHeight) const
+{
+	const IMPOSTOR_GROUP& impostor = m_groups[group];
+	float pixelsPerUnit = projection[1][1] * 0.5f * (float)viewportHeight;
+
+	// the size does not change with distance in an orthographic
+	// projection
+	if (projection[3][3] == 0.0f)
+	{
+		float distance = glm::length(impostor.center - viewPosition);
+		if (distance <= impostor.radius)
+		{
+			return(false);
+		}
+		pixelsPerUnit /= distance;
+	}
+
+	return(2.0f * impostor.radius * pixelsPerUnit <= (float)FRAME_SIZE);
+}
+
+/***********************************************************
+ *  Draw()
+ *
+ *  This method is used for drawing the quads of the passed
+ *  in groups with a single instanced draw.  The program,
+ *  vertex array and active texture unit that were bound are
+ *  put back afterwards.
+ ***********************************************************/
+void ImpostorAtlas::Draw(
+	const std::vector<int>& groups,
+	const glm::mat4& view,
+	const glm::mat4& projection,
+	const glm::vec3& viewPosition)
+{
+	if ((groups.empty() == true) || (m_program == 0) || (m_colorTexture == 0))
+	{
+		return;
+	}
+
+	m_instanceData.resize(groups.size() * INSTANCE_FLOATS);
+	for (size_t i = 0; i < groups.size(); i++)
+	{
+		const IMPOSTOR_GROUP& impostor = m_groups[groups[i]];
+		float* instance = &m_instanceData[i * INSTANCE_FLOATS];
+		instance[0] = impostor.center.x;
+		instance[1] = impostor.center.y;
+		instance[2] = impostor.center.z;
+		instance[3] = impostor.radius;
+		instance[4] = (float)groups[i];
+	}
+
+	GLint previousProgram = 0;
+	GLint previousVertexArray = 0;
+	GLint previousTextureUnit = 0;
+	glGetIntegerv(GL_CURRENT_PROGRAM, &previousProgram);
+	glGetIntegerv(GL_VERTEX_ARRAY_BINDING, &previousVertexArray);
+	glGetIntegerv(GL_ACTIVE_TEXTURE, &previousTextureUnit);
+
+	glBindBuffer(GL_ARRAY_BUFFER, m_instanceBuffer);
+	glBufferData(GL_ARRAY_BUFFER, m_instanceData.size() * sizeof(float), &m_instanceData[0], GL_STREAM_DRAW);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+	glUseProgram(m_program);
+	glUniformMatrix4fv(glGetUniformLocation(m_program, "view"), 1, GL_FALSE, &view[0][0]);
+	glUniformMatrix4fv(glGetUniformLocation(m_program, "projection"), 1, GL_FALSE, &projection[0][0]);
+	glUniform3fv(glGetUniformLocation(m_program, "viewPosition"), 1, &viewPosition[0]);
+	glUniform1f(glGetUniformLocation(m_program, "frameGrid"), (float)FRAME_GRID);
+	glUniform1f(glGetUniformLocation(m_program, "frameSize"), (float)FRAME_SIZE);
+	glUniform1i(glGetUniformLocation(m_program, "impostorColor"), COLOR_TEXTURE_UNIT);
+	glUniform1i(glGetUniformLocation(m_program, "impostorDepth"), DEPTH_TEXTURE_UNIT);
+
+	glActiveTexture(GL_TEXTURE0 + COLOR_TEXTURE_UNIT);
+	glBindTexture(GL_TEXTURE_2D_ARRAY, m_colorTexture);
+	glActiveTexture(GL_TEXTURE0 + DEPTH_TEXTURE_UNIT);
+	glBindTexture(GL_TEXTURE_2D_ARRAY, m_depthTexture);
+
+	glBindVertexArray(m_vertexArray);
+	glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, (GLsizei)groups.size());
+
+	glBindVertexArray((GLuint)previousVertexArray);
+	glActiveTexture((GLenum)previousTextureUnit);
+	glUseProgram((GLuint)previousProgram);
+}
@@ -0,0 +1,138 @@
+///////////////////////////////////////////////////////////////////////////////
+// impostoratlas.h
+// ============
+// bake groups of objects into octahedral atlases of views, and draw each
+// distant group as a single camera facing quad
+//
+//  Created for CS-330-Computational Graphics and Visualization
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+#include <vector>
+
+/***********************************************************
+ *  ImpostorAtlas
+ *
+ *  This class contains the code for impostors, which stand
+ *  in for groups of objects that are too far away to show
+ *  their detail.  Each group is rendered from a grid of
+ *  FRAME_GRID x FRAME_GRID directions spread over the whole
+ *  sphere by an octahedral mapping, and the views are laid
+ *  out as frames in one layer of the atlas:
+ *
+ *    color       lit color, with the coverage in alpha
+ *    depth       depth of the surface in each frame, across
+ *                the group's bounding sphere
+ *
+ *  When drawn, the quad of a group faces the camera and
+ *  blends the three frames around the direction it is seen
+ *  from.  Each frame is sampled where the view ray crosses
+ *  its own plane, and the depth moves the fragment onto the
+ *  surface, so impostors meet the real objects correctly.
+ *  The baked atlas is written to a cooked file, keyed by a
+ *  hash of the grouped objects.
+ ***********************************************************/
+class ImpostorAtlas
+{
+public:
+	// a group of objects drawn as one impostor, bounded by a sphere
+	struct IMPOSTOR_GROUP
+	{
+		glm::vec3 center;
+		float radius;
+	};
+
+	// frames along each side of the octahedral grid
+	static const int FRAME_GRID = 8;
+	// pixels along each side of a frame
+	static const int FRAME_SIZE = 64;
+	// pixels along each side of an atlas layer
+	static const int ATLAS_SIZE = FRAME_GRID * FRAME_SIZE;
+
+	// constructor
+	ImpostorAtlas();
+	// destructor
+	~ImpostorAtlas();
+
+	// compile the shaders that draw the impostor quads
+	bool Initialize(const char* vertexShaderPath, const char* fragmentShaderPath);
+
+	// set the groups to bake or load, along with values that
+	// describe their objects, which key the cooked file
+	void SetGroups(const std::vector<IMPOSTOR_GROUP>& groups, const std::vector<float>& description);
+	// number of groups
+	int GetGroupCount() const;
+
+	// get the direction a frame of the grid is seen from
+	static glm::vec3 GetFrameDirection(int frame);
+	// get the view and orthographic projection that render a
+	// frame of a group, and the camera position
+	void GetFrameView(
+		int group,
+		int frame,
+		glm::mat4& view,
+		glm::mat4& projection,
+		glm::vec3& viewPosition) const;
+
+	// create the render targets for baking
+	bool BeginBake();
+	// direct the rendering into a frame of a group
+	void BeginFrame(int group, int frame);
+	// read the baked frames back and free the render targets
+	void EndBake();
+
+	// save the baked atlas to a cooked file
+	bool Save(const char* filePath) const;
+	// load a baked atlas, which fails when it was baked for
+	// different groups
+	bool Load(const char* filePath);
+	// upload the baked atlas into array textures
+	bool CreateTextures();
+
+	// check whether a group covers no more pixels on the screen
+	// than a baked frame has
+	bool IsDistant(
+		int group,
+		const glm::vec3& viewPosition,
+		const glm::mat4& projection,
+		int viewportHeight) const;
+	// draw the impostor quads of the passed in groups
+	void Draw(
+		const std::vector<int>& groups,
+		const glm::mat4& view,
+		const glm::mat4& projection,
+		const glm::vec3& viewPosition);
+
+private:
+	// the groups and the key of their objects
+	std::vector<IMPOSTOR_GROUP> m_groups;
+	unsigned long long m_groupKey;
+	// baked texels of every layer, one after another
+	std::vector<unsigned char> m_colorTexels;
+	std::vector<unsigned short> m_depthTexels;
+
+	// render targets used while baking
+	GLuint m_bakeFramebuffer;
+	GLuint m_bakeColorTexture;
+	GLuint m_bakeDepthTexture;
+	// viewport and framebuffer to put back after baking
+	GLint m_savedViewport[4];
+	GLint m_savedFramebuffer;
+
+	// atlas textures sampled by the impostor shader
+	GLuint m_colorTexture;
+	GLuint m_depthTexture;
+	// program, quad vertex array and per group instance buffer
+	GLuint m_program;
+	GLuint m_vertexArray;
+	GLuint m_instanceBuffer;
+	// instance values of the quads being drawn
+	std::vector<float> m_instanceData;
+
+	// free the render targets used while baking
+	void DestroyBakeTargets();
+};
@@ -0,0 +1,112 @@
+///////////////////////////////////////////////////////////////////////////////
+// inputqueue.h
+// ============
+// queue timestamped input events between the window callbacks and
+// the simulation
+//
+//  Created for CS-330-Computational Graphics and Visualization
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+
+/***********************************************************
+ *  INPUT_EVENT
+ *
+ *  A single input event received from GLFW along with the
+ *  time it was received.
+ ***********************************************************/
+struct INPUT_EVENT
+{
+	enum EVENT_TYPE
+	{
+		KEY_EVENT = 0,
+		MOUSE_MOVE_EVENT,
+		SCROLL_EVENT
+	};
+
+	EVENT_TYPE type;
+	// glfwGetTime() when the event was received
+	double time;
+	// key code and GLFW_PRESS, GLFW_RELEASE or GLFW_REPEAT
+	int key;
+	int action;
+	// the action the key was bound to when it was pressed, so a
+	// key rebound while held still releases what it pressed
+	int binding;
+	// cursor position or scroll offsets
+	double x;
+	double y;
+};
+
+/***********************************************************
+ *  InputQueue
+ *
+ *  A fixed size, lock-free ring buffer with a single
+ *  producer and a single consumer.  Events are pushed from
+ *  the GLFW callbacks and drained by the simulation steps.
+ ***********************************************************/
+template <size_t CAPACITY>
+class InputQueue
+{
+public:
+	// constructor
+	InputQueue()
+	{
+		m_head = 0;
+		m_tail = 0;
+	}
+
+	// add an event to the back of the queue, returns false
+	// when the queue is full and the event was dropped
+	bool Push(const INPUT_EVENT& inputEvent)
+	{
+		size_t tail = m_tail.load(std::memory_order_relaxed);
+		size_t next = (tail + 1) % CAPACITY;
+		if (next == m_head.load(std::memory_order_acquire))
+		{
+			return(false);
+		}
+		m_events[tail] = inputEvent;
+		m_tail.store(next, std::memory_order_release);
+		return(true);
+	}
+
+	// look at the event at the front of the queue without removing it
+	bool Peek(INPUT_EVENT& inputEvent) const
+	{
+		size_t head = m_head.load(std::memory_order_relaxed);
+		if (head == m_tail.load(std::memory_order_acquire))
+		{
+			return(false);
+		}
+		inputEvent = m_events[head];
+		return(true);
+	}
+
+	// remove the event at the front of the queue
+	void Pop()
+	{
+		size_t head = m_head.load(std::memory_order_relaxed);
+		if (head != m_tail.load(std::memory_order_acquire))
+		{
+			m_head.store((head + 1) % CAPACITY, std::memory_order_release);
+		}
+	}
+
+	// check whether there are no events waiting
+	bool IsEmpty() const
+	{
+		return(m_head.load(std::memory_order_acquire) ==
+			m_tail.load(std::memory_order_acquire));
+	}
+
+private:
+	INPUT_EVENT m_events[CAPACITY];
+	// index of the next event to read
+	std::atomic<size_t> m_head;
+	// index of the next free slot to write
+	std::atomic<size_t> m_tail;
+};
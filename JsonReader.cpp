@@ -0,0 +1,200 @@
+///////////////////////////////////////////////////////////////////////////////
+// jsonreader.cpp
+// ============
+// read JSON documents into a tree of values, for the glTF model files
+// and the scene authoring files
+//
+//  Created for CS-330-Computational Graphics and Visualization
+///////////////////////////////////////////////////////////////////////////////
+
+#include "JsonReader.h"
+
+#include <cstdlib>
+#include <cstring>
+
+// declaration of the global variables and defines
+namespace
+{
+	// deepest nesting of arrays and objects that is read
+	const int MAX_DEPTH = 64;
+}
+
+/***********************************************************
+ *  Parse()
+ *
+ *  This method is used for parsing a whole JSON document.
+ ***********************************************************/
+bool JsonReader::Parse(const char* text, size_t size, JSON_VALUE& document)
+{
+	const char* p = text;
+	return(ParseValue(p, text + size, document, 0));
+}
+
+/***********************************************************
+ *  ParseValue()
+ *
+ *  This method is used for reading one JSON value, and the
+ *  values nested inside it, moving p past its end.
+ ***********************************************************/
+bool JsonReader::ParseValue(const char*& p, const char* end, JSON_VALUE& value, int depth)
+{
+	while ((p < end) && ((*p == ' ') || (*p == '\t') || (*p == '\n') || (*p == '\r')))
+	{
+		p++;
+	}
+	if ((p >= end) || (depth > MAX_DEPTH))
+	{
+		return(false);
+	}
+
+	if ((*p == '{') || (*p == '['))
+	{
+		bool bObject = (*p == '{');
+		char closing = bObject ? '}' : ']';
+		value.type = bObject ? JSON_VALUE::JSON_OBJECT : JSON_VALUE::JSON_ARRAY;
+		p++;
+		while (p < end)
+		{
+			while ((p < end) && ((*p == ' ') || (*p == '\t') || (*p == '\n') || (*p == '\r') || (*p == ',')))
+			{
+				p++;
+			}
+			if ((p < end) && (*p == closing))
+			{
+				p++;
+				return(true);
+			}
+			if (bObject == true)
+			{
+				JSON_VALUE key;
+				if ((ParseValue(p, end, key, depth + 1) == false) || (key.type != JSON_VALUE::JSON_STRING))
+				{
+					return(false);
+				}
+				while ((p < end) && (*p != ':'))
+				{
+					p++;
+				}
+				p++;
+				value.keys.push_back(key.text);
+			}
+			value.items.push_back(JSON_VALUE());
+			if (ParseValue(p, end, value.items.back(), depth + 1) == false)
+			{
+				return(false);
+			}
+		}
+		return(false);
+	}
+	if (*p == '"')
+	{
+		value.type = JSON_VALUE::JSON_STRING;
+		p++;
+		const char* start = p;
+		while ((p < end) && (*p != '"'))
+		{
+			p += (*p == '\\') ? 2 : 1;
+		}
+		if (p >= end)
+		{
+			return(false);
+		}
+		value.text.assign(start, p);
+		p++;
+		return(true);
+	}
+	if ((*p == '-') || ((*p >= '0') && (*p <= '9')))
+	{
+		value.type = JSON_VALUE::JSON_NUMBER;
+		char* numberEnd = NULL;
+		value.number = strtod(p, &numberEnd);
+		p = numberEnd;
+		return(true);
+	}
+	if ((end - p >= 4) && (strncmp(p, "true", 4) == 0))
+	{
+		value.type = JSON_VALUE::JSON_BOOL;
+		value.number = 1.0;
+		p += 4;
+		return(true);
+	}
+	if ((end - p >= 5) && (strncmp(p, "false", 5) == 0))
+	{
+		value.type = JSON_VALUE::JSON_BOOL;
+		p += 5;
+		return(true);
+	}
+	if ((end - p >= 4) && (strncmp(p, "null", 4) == 0))
+	{
+		p += 4;
+		return(true);
+	}
+	return(false);
+}
+
+/***********************************************************
+ *  FindMember()
+ *
+ *  This method is used for finding a member of a JSON object
+ *  by name, returning NULL when there is none.
+ ***********************************************************/
+const JsonReader::JSON_VALUE* JsonReader::FindMember(const JSON_VALUE& object, const char* name)
+{
+	for (size_t i = 0; i < object.keys.size(); i++)
+	{
+		if (object.keys[i] == name)
+		{
+			return(&object.items[i]);
+		}
+	}
+	return(NULL);
+}
+
+/***********************************************************
+ *  GetElement()
+ *
+ *  This method is used for getting an element of a member
+ *  array, such as one of the glTF accessors, returning NULL when
+ *  the index is out of range.
+ ***********************************************************/
+const JsonReader::JSON_VALUE* JsonReader::GetElement(const JSON_VALUE& object, const char* name, int index)
+{
+	const JSON_VALUE* pArray = FindMember(object, name);
+	if ((pArray == NULL) || (index < 0) || (index >= (int)pArray->items.size()))
+	{
+		return(NULL);
+	}
+	return(&pArray->items[index]);
+}
+
+/***********************************************************
+ *  GetNumber()
+ *
+ *  This method is used for getting a number member of a JSON
+ *  object, or the default when it is missing.
+ ***********************************************************/
+double JsonReader::GetNumber(const JSON_VALUE& object, const char* name, double defaultValue)
+{
+	const JSON_VALUE* pValue = FindMember(object, name);
+	if ((pValue == NULL) || (pValue->type != JSON_VALUE::JSON_NUMBER))
+	{
+		return(defaultValue);
+	}
+	return(pValue->number);
+}
+
+/***********************************************************
+ *  GetString()
+ *
+ *  This method is used for getting a string member of a
+ *  JSON object, or the default when it is missing.
+ ***********************************************************/
+std::string JsonReader::GetString(const JSON_VALUE& object, const char* name, const char* defaultValue)
+{
+	const JSON_VALUE* pValue = FindMember(object, name);
+	if ((pValue == NULL) || (pValue->type != JSON_VALUE::JSON_STRING))
+	{
+		return(defaultValue);
+	}
+	return(pValue->text);
+}
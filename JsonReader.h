@@ -0,0 +1,66 @@
+///////////////////////////////////////////////////////////////////////////////
+// jsonreader.h
+// ============
+// read JSON documents into a tree of values, for the glTF model files
+// and the scene authoring files
+//
+//  Created for CS-330-Computational Graphics and Visualization
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+/***********************************************************
+ *  JsonReader
+ *
+ *  This class contains the code for parsing JSON text into
+ *  a tree of values and looking up their members.  Escaped
+ *  characters in strings are kept as plain characters,
+ *  which is enough for names, tags and file paths.
+ ***********************************************************/
+class JsonReader
+{
+public:
+	// a parsed JSON value.  object members keep their keys in
+	// a list beside the values, in the order they were read
+	struct JSON_VALUE
+	{
+		enum JSON_TYPE
+		{
+			JSON_NULL = 0,
+			JSON_BOOL,
+			JSON_NUMBER,
+			JSON_STRING,
+			JSON_ARRAY,
+			JSON_OBJECT
+		};
+
+		JSON_TYPE type;
+		double number;
+		std::string text;
+		std::vector<JSON_VALUE> items;
+		std::vector<std::string> keys;
+
+		JSON_VALUE() : type(JSON_NULL), number(0.0) {}
+	};
+
+	// parse a whole document
+	static bool Parse(const char* text, size_t size, JSON_VALUE& document);
+
+	// find a member of an object by name, or NULL when there is none
+	static const JSON_VALUE* FindMember(const JSON_VALUE& object, const char* name);
+	// get an element of a member array, or NULL when the index is
+	// out of range
+	static const JSON_VALUE* GetElement(const JSON_VALUE& object, const char* name, int index);
+	// get a number member, or the default when it is missing
+	static double GetNumber(const JSON_VALUE& object, const char* name, double defaultValue);
+	// get a string member, or the default when it is missing
+	static std::string GetString(const JSON_VALUE& object, const char* name, const char* defaultValue);
+
+private:
+	// read one value and everything nested in it
+	static bool ParseValue(const char*& p, const char* end, JSON_VALUE& value, int depth);
+};
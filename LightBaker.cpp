@@ -0,0 +1,1119 @@
+///////////////////////////////////////////////////////////////////////////////
+// lightbaker.cpp
+// ============
+// bake the lighting of the static scene into a volume of light probes
+// on the CPU, so static objects are shaded without a light loop
+//
+//  Created for CS-330-Computational Graphics and Visualization
+///////////////////////////////////////////////////////////////////////////////
+
+#include "LightBaker.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <thread>
+
+// declaration of the global variables and defines
+namespace
+{
+	// identifies a baked lighting file written by this class
+	const unsigned int BAKE_FILE_MAGIC = 0x454B4142;	// "BAKE"
+	// increase when the layout of the file or the bake changes
+	const unsigned int BAKE_FILE_VERSION = 1;
+
+	// FNV-1a hash constants
+	const unsigned long long HASH_OFFSET = 14695981039346656037ULL;
+	const unsigned long long HASH_PRIME = 1099511628211ULL;
+
+	// texture units the probe textures are bound to, after the
+	// ones used by the scene textures and the G-buffer
+	const GLuint FIRST_PROBE_TEXTURE_UNIT = 19;
+	const char* g_ProbeTextureNames[4] =
+	{
+		"bakedDirectDirection",
+		"bakedDirectColor",
+		"bakedIndirectColor",
+		"bakedIndirectDirection"
+	};
+
+	// distance rays start away from a surface, so they do not
+	// hit the surface they start on
+	const float RAY_OFFSET = 1.0e-3f;
+	// distance the indirect rays are traced to
+	const float INDIRECT_RAY_LENGTH = 1.0e4f;
+	// deepest bounding volume hierarchy that can be traversed
+	const int MAX_TRAVERSAL_DEPTH = 64;
+
+	// header written at the start of each baked lighting file
+	struct BAKE_FILE_HEADER
+	{
+		unsigned int magic;
+		unsigned int version;
+		unsigned long long key;
+		int dimensions[3];
+		float volumeMin[3];
+		float cellSize;
+		float focalStrength;
+		float specularIntensity;
+		unsigned int probeCount;
+	};
+
+	/***********************************************************
+	 *  HashBytes()
+	 *
+	 *  This function is used to add a block of memory into a
+	 *  running FNV-1a hash.
+	 ***********************************************************/
+	unsigned long long HashBytes(unsigned long long hash, const void* data, size_t size)
+	{
+		const unsigned char* bytes = (const unsigned char*)data;
+		for (size_t i = 0; i < size; i++)
+		{
+			hash ^= bytes[i];
+			hash *= HASH_PRIME;
+		}
+		return(hash);
+	}
+
+	/***********************************************************
+	 *  GetLuminance()
+	 *
+	 *  This function is used to get the brightness of a color.
+	 ***********************************************************/
+	float GetLuminance(const glm::vec3& color)
+	{
+		return(0.2126f * color.r + 0.7152f * color.g + 0.0722f * color.b);
+	}
+
+	/***********************************************************
+	 *  GetAttenuation()
+	 *
+	 *  This function is used to get how much of a light
+	 *  reaches a point, ignoring shadows.  It matches the range
+	 *  and spot cone falloff in the scene fragment shader.
+	 ***********************************************************/
+	float GetAttenuation(const LIGHT_SOURCE& light, const glm::vec3& position, glm::vec3& lightDirection, float& lightDistance)
+	{
+		glm::vec3 toLight = light.position - position;
+		lightDistance = glm::length(toLight);
+		if ((lightDistance >= light.range) || (lightDistance <= 0.0f))
+		{
+			return(0.0f);
+		}
+		lightDirection = toLight / lightDistance;
+
+		float falloff = lightDistance / light.range;
+		falloff = glm::clamp(1.0f - falloff * falloff * falloff * falloff, 0.0f, 1.0f);
+		float attenuation = falloff * falloff;
+		if (light.type == LIGHT_SOURCE::LIGHT_SPOT)
+		{
+			float spotCosine = glm::dot(-lightDirection, glm::normalize(light.direction));
+			float innerCosine = std::cos(glm::radians(light.innerConeAngle));
+			float outerCosine = std::cos(glm::radians(light.outerConeAngle));
+			float spot = glm::clamp((spotCosine - outerCosine) / std::max(innerCosine - outerCosine, 1.0e-4f), 0.0f, 1.0f);
+			attenuation *= spot * spot * (3.0f - 2.0f * spot);
+		}
+		return(attenuation);
+	}
+
+	/***********************************************************
+	 *  SolveQuadratic()
+	 *
+	 *  This function is used to find the two roots of a
+	 *  quadratic, in increasing order.
+	 ***********************************************************/
+	bool SolveQuadratic(float a, float b, float c, float& t0, float& t1)
+	{
+		if (std::fabs(a) < 1.0e-12f)
+		{
+			if (std::fabs(b) < 1.0e-12f)
+			{
+				return(false);
+			}
+			t0 = -c / b;
+			t1 = t0;
+			return(true);
+		}
+
+		float discriminant = b * b - 4.0f * a * c;
+		if (discriminant < 0.0f)
+		{
+			return(false);
+		}
+		float root = std::sqrt(discriminant);
+		t0 = (-b - root) / (2.0f * a);
+		t1 = (-b + root) / (2.0f * a);
+		if (t0 > t1)
+		{
+			std::swap(t0, t1);
+		}
+		return(true);
+	}
+
+	/***********************************************************
+	 *  IntersectBounds()
+	 *
+	 *  This function is used to find where a ray enters a box,
+	 *  or leaves it when the ray starts inside.  The normal is
+	 *  the one of the face that was crossed.
+	 ***********************************************************/
+	bool IntersectBounds(
+		const glm::vec3& origin, const glm::vec3& direction,
+		const glm::vec3& boundsMin, const glm::vec3& boundsMax,
+		float maxDistance, float& distance, glm::vec3& normal)
+	{
+		float nearDistance = -1.0e30f;
+		float farDistance = 1.0e30f;
+		int nearAxis = 0;
+		int farAxis = 0;
+		for (int axis = 0; axis < 3; axis++)
+		{
+			if (std::fabs(direction[axis]) < 1.0e-12f)
+			{
+				if ((origin[axis] < boundsMin[axis]) || (origin[axis] > boundsMax[axis]))
+				{
+					return(false);
+				}
+				continue;
+			}
+			float t0 = (boundsMin[axis] - origin[axis]) / direction[axis];
+			float t1 = (boundsMax[axis] - origin[axis]) / direction[axis];
+			if (t0 > t1)
+			{
+				std::swap(t0, t1);
+			}
+			if (t0 > nearDistance)
+			{
+				nearDistance = t0;
+				nearAxis = axis;
+			}
+			if (t1 < farDistance)
+			{
+				farDistance = t1;
+				farAxis = axis;
+			}
+		}
+		if (nearDistance > farDistance)
+		{
+			return(false);
+		}
+
+		int axis = nearAxis;
+		distance = nearDistance;
+		if (distance <= RAY_OFFSET)
+		{
+			axis = farAxis;
+			distance = farDistance;
+		}
+		if ((distance <= RAY_OFFSET) || (distance >= maxDistance))
+		{
+			return(false);
+		}
+
+		normal = glm::vec3(0.0f);
+		float hitPosition = origin[axis] + direction[axis] * distance;
+		normal[axis] = (std::fabs(hitPosition - boundsMax[axis]) < std::fabs(hitPosition - boundsMin[axis])) ? 1.0f : -1.0f;
+		return(true);
+	}
+
+	/***********************************************************
+	 *  GetShapeBounds()
+	 *
+	 *  This function is used to get the object space bounds of
+	 *  a shape.  The ShapeMeshes primitives are a unit box, a
+	 *  plane from -1 to 1, spheres of radius 1, cylinders and
+	 *  cones of radius 1 from 0 to 1 in y, and tori around the
+	 *  z axis with a main radius of 1.
+	 ***********************************************************/
+	void GetShapeBounds(LightBaker::BAKE_SHAPE shape, glm::vec3& boundsMin, glm::vec3& boundsMax)
+	{
+		switch (shape)
+		{
+		case LightBaker::SHAPE_PLANE:
+			boundsMin = glm::vec3(-1.0f, -RAY_OFFSET, -1.0f);
+			boundsMax = glm::vec3(1.0f, RAY_OFFSET, 1.0f);
+			break;
+		case LightBaker::SHAPE_BOX:
+			boundsMin = glm::vec3(-0.5f);
+			boundsMax = glm::vec3(0.5f);
+			break;
+		case LightBaker::SHAPE_CYLINDER:
+		case LightBaker::SHAPE_CONE:
+		case LightBaker::SHAPE_HALF_SPHERE:
+			boundsMin = glm::vec3(-1.0f, 0.0f, -1.0f);
+			boundsMax = glm::vec3(1.0f, 1.0f, 1.0f);
+			break;
+		case LightBaker::SHAPE_TORUS:
+			boundsMin = glm::vec3(-1.2f, -1.2f, -0.2f);
+			boundsMax = glm::vec3(1.2f, 1.2f, 0.2f);
+			break;
+		case LightBaker::SHAPE_HALF_TORUS:
+			boundsMin = glm::vec3(-1.2f, 0.0f, -0.2f);
+			boundsMax = glm::vec3(1.2f, 1.2f, 0.2f);
+			break;
+		case LightBaker::SHAPE_SPHERE:
+		default:
+			boundsMin = glm::vec3(-1.0f);
+			boundsMax = glm::vec3(1.0f);
+			break;
+		}
+	}
+}
+
+/***********************************************************
+ *  LightBaker()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+LightBaker::LightBaker()
+{
+	m_sceneKey = HASH_OFFSET;
+	m_dimensions = glm::ivec3(0);
+	m_volumeMin = glm::vec3(0.0f);
+	m_cellSize = 1.0f;
+	m_focalStrength = 32.0f;
+	m_specularIntensity = 0.0f;
+	for (int i = 0; i < 4; i++)
+	{
+		m_textures[i] = 0;
+	}
+	m_bakeTime = 0.0;
+}
+
+/***********************************************************
+ *  ~LightBaker()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+LightBaker::~LightBaker()
+{
+	if (0 != m_textures[0])
+	{
+		glDeleteTextures(4, m_textures);
+	}
+}
+
+/***********************************************************
+ *  SetScene()
+ *
+ *  This method is used for setting the static objects and
+ *  lights to bake.  It prepares the objects for tracing,
+ *  builds the bounding volume hierarchy and places the probe
+ *  grid around all of the objects.
+ ***********************************************************/
+void LightBaker::SetScene(
+	const std::vector<BAKE_OBJECT>& objects,
+	const std::vector<LIGHT_SOURCE>& lights)
+{
+	m_lights = lights;
+	m_objects.resize(objects.size());
+	m_objectOrder.resize(objects.size());
+	m_probes.clear();
+
+	unsigned int version = BAKE_FILE_VERSION;
+	m_sceneKey = HashBytes(HASH_OFFSET, &version, sizeof(version));
+
+	glm::vec3 sceneMin(1.0e30f);
+	glm::vec3 sceneMax(-1.0e30f);
+	for (size_t i = 0; i < objects.size(); i++)
+	{
+		const BAKE_OBJECT& source = objects[i];
+		TRACE_OBJECT& object = m_objects[i];
+		object.shape = source.shape;
+		object.worldToObject = glm::inverse(source.model);
+		object.normalMatrix = glm::transpose(glm::inverse(glm::mat3(source.model)));
+		object.albedo = source.albedo;
+
+		// world bounds around the corners of the shape's bounds
+		glm::vec3 shapeMin;
+		glm::vec3 shapeMax;
+		GetShapeBounds(source.shape, shapeMin, shapeMax);
+		object.boundsMin = glm::vec3(1.0e30f);
+		object.boundsMax = glm::vec3(-1.0e30f);
+		for (int corner = 0; corner < 8; corner++)
+		{
+			glm::vec3 point(
+				(corner & 1) ? shapeMax.x : shapeMin.x,
+				(corner & 2) ? shapeMax.y : shapeMin.y,
+				(corner & 4) ? shapeMax.z : shapeMin.z);
+			glm::vec3 worldPoint = glm::vec3(source.model * glm::vec4(point, 1.0f));
+			object.boundsMin = glm::min(object.boundsMin, worldPoint);
+			object.boundsMax = glm::max(object.boundsMax, worldPoint);
+		}
+		sceneMin = glm::min(sceneMin, object.boundsMin);
+		sceneMax = glm::max(sceneMax, object.boundsMax);
+
+		m_objectOrder[i] = (int)i;
+		m_sceneKey = HashBytes(m_sceneKey, &source.shape, sizeof(source.shape));
+		m_sceneKey = HashBytes(m_sceneKey, &source.model[0][0], sizeof(float) * 16);
+		m_sceneKey = HashBytes(m_sceneKey, &source.albedo[0], sizeof(float) * 3);
+	}
+
+	// the highlight of the dominant light uses the average of the
+	// scene lights' specular settings
+	m_focalStrength = 32.0f;
+	m_specularIntensity = 0.0f;
+	if (lights.empty() == false)
+	{
+		m_focalStrength = 0.0f;
+		for (size_t i = 0; i < lights.size(); i++)
+		{
+			m_focalStrength += lights[i].focalStrength / lights.size();
+			m_specularIntensity += lights[i].specularIntensity / lights.size();
+			m_sceneKey = HashBytes(m_sceneKey, &lights[i], sizeof(LIGHT_SOURCE));
+		}
+	}
+
+	// build the hierarchy, two child nodes per inner node
+	m_nodes.clear();
+	if (m_objects.empty() == false)
+	{
+		m_nodes.reserve(m_objects.size() * 2);
+		m_nodes.push_back(BVH_NODE());
+		BuildNode(0, 0, (int)m_objects.size());
+	}
+	else
+	{
+		sceneMin = glm::vec3(-1.0f);
+		sceneMax = glm::vec3(1.0f);
+	}
+
+	// cover the objects with cells of the same size on every axis,
+	// with a margin of one cell all around
+	glm::vec3 extent = sceneMax - sceneMin;
+	float longestSide = std::max(extent.x, std::max(extent.y, extent.z));
+	m_cellSize = std::max(longestSide / (MAX_VOLUME_RESOLUTION - 2), 1.0e-3f);
+	m_volumeMin = sceneMin - glm::vec3(m_cellSize);
+	for (int axis = 0; axis < 3; axis++)
+	{
+		m_dimensions[axis] = std::max(2, (int)std::ceil(extent[axis] / m_cellSize) + 2);
+	}
+
+	// spread the indirect rays evenly over the sphere
+	m_rayDirections.resize(INDIRECT_RAY_COUNT);
+	const float goldenAngle = 2.39996323f;
+	for (int i = 0; i < INDIRECT_RAY_COUNT; i++)
+	{
+		float y = 1.0f - (2.0f * i + 1.0f) / INDIRECT_RAY_COUNT;
+		float radius = std::sqrt(std::max(0.0f, 1.0f - y * y));
+		float angle = goldenAngle * i;
+		m_rayDirections[i] = glm::vec3(std::cos(angle) * radius, y, std::sin(angle) * radius);
+	}
+}
+
+/***********************************************************
+ *  Bake()
+ *
+ *  This method is used for baking every probe in the grid.
+ *  The layers of the grid are handed out to worker threads
+ *  one at a time, so the threads finish close together even
+ *  though some layers take longer than others.
+ ***********************************************************/
+void LightBaker::Bake()
+{
+	std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+
+	m_probes.resize((size_t)m_dimensions.x * m_dimensions.y * m_dimensions.z);
+
+	int threadCount = std::max(1, (int)std::thread::hardware_concurrency());
+	std::atomic<int> nextLayer(0);
+	std::vector<std::thread> workers;
+	for (int t = 1; t < threadCount; t++)
+	{
+		workers.push_back(std::thread(&LightBaker::BakeLayers, this, &nextLayer));
+	}
+	BakeLayers(&nextLayer);
+	for (size_t t = 0; t < workers.size(); t++)
+	{
+		workers[t].join();
+	}
+
+	FillInsideProbes();
+
+	m_bakeTime = std::chrono::duration<double, std::milli>(
+		std::chrono::steady_clock::now() - startTime).count();
+
+	std::cout << "INFO: Baked lighting: " << m_probes.size() << " probes ("
+		<< m_dimensions.x << "x" << m_dimensions.y << "x" << m_dimensions.z << ") for "
+		<< m_objects.size() << " objects and " << m_lights.size() << " lights in "
+		<< m_bakeTime << " ms on " << threadCount << " threads" << std::endl;
+}
+
+/***********************************************************
+ *  Save()
+ *
+ *  This method is used for writing the baked probes to a
+ *  cooked file, along with the key of the scene they were
+ *  baked for.
+ ***********************************************************/
+bool LightBaker::Save(const char* filePath) const
+{
+	if (m_probes.empty())
+	{
+		return(false);
+	}
+
+	BAKE_FILE_HEADER header;
+	header.magic = BAKE_FILE_MAGIC;
+	header.version = BAKE_FILE_VERSION;
+	header.key = m_sceneKey;
+	for (int axis = 0; axis < 3; axis++)
+	{
+		header.dimensions[axis] = m_dimensions[axis];
+		header.volumeMin[axis] = m_volumeMin[axis];
+	}
+	header.cellSize = m_cellSize;
+	header.focalStrength = m_focalStrength;
+	header.specularIntensity = m_specularIntensity;
+	header.probeCount = (unsigned int)m_probes.size();
+
+	std::ofstream file(filePath, std::ios::binary | std::ios::trunc);
+	if (!file.is_open())
+	{
+		return(false);
+	}
+	file.write((const char*)&header, sizeof(header));
+	file.write((const char*)&m_probes[0], m_probes.size() * sizeof(PROBE));
+	if (!file)
+	{
+		file.close();
+		std::remove(filePath);
+		return(false);
+	}
+
+	return(true);
+}
+
+/***********************************************************
+ *  Load()
+ *
+ *  This method is used for reading baked probes from a
+ *  cooked file.  Probes baked for different objects or
+ *  lights are not used, so the lighting is never stale.
+ ***********************************************************/
+bool LightBaker::Load(const char* filePath)
+{
+	std::ifstream file(filePath, std::ios::binary);
+	if (!file.is_open())
+	{
+		return(false);
+	}
+
+	BAKE_FILE_HEADER header;
+	file.read((char*)&header, sizeof(header));
+	if (!file ||
+		(header.magic != BAKE_FILE_MAGIC) ||
+		(header.version != BAKE_FILE_VERSION) ||
+		(header.key != m_sceneKey) ||
+		(header.probeCount != (unsigned int)header.dimensions[0] * header.dimensions[1] * header.dimensions[2]) ||
+		(header.probeCount == 0))
+	{
+		std::cout << "INFO: Baked lighting in " << filePath << " is out of date" << std::endl;
+		return(false);
+	}
+
+	std::vector<PROBE> probes(header.probeCount);
+	file.read((char*)&probes[0], probes.size() * sizeof(PROBE));
+	if (!file)
+	{
+		return(false);
+	}
+
+	for (int axis = 0; axis < 3; axis++)
+	{
+		m_dimensions[axis] = header.dimensions[axis];
+		m_volumeMin[axis] = header.volumeMin[axis];
+	}
+	m_cellSize = header.cellSize;
+	m_focalStrength = header.focalStrength;
+	m_specularIntensity = header.specularIntensity;
+	m_probes.swap(probes);
+
+	return(true);
+}
+
+/***********************************************************
+ *  CreateTextures()
+ *
+ *  This method is used for uploading the probes into four
+ *  3D textures, one for each vec4 of the probe, filtered
+ *  so that the light blends smoothly between probes.
+ ***********************************************************/
+bool LightBaker::CreateTextures()
+{
+	if (m_probes.empty())
+	{
+		return(false);
+	}
+
+	if (0 == m_textures[0])
+	{
+		glGenTextures(4, m_textures);
+	}
+
+	std::vector<glm::vec4> layer(m_probes.size());
+	for (int t = 0; t < 4; t++)
+	{
+		for (size_t i = 0; i < m_probes.size(); i++)
+		{
+			const glm::vec4* probeValues = &m_probes[i].directDirection;
+			layer[i] = probeValues[t];
+		}
+
+		glBindTexture(GL_TEXTURE_3D, m_textures[t]);
+		glTexImage3D(GL_TEXTURE_3D, 0, GL_RGBA16F,
+			m_dimensions.x, m_dimensions.y, m_dimensions.z,
+			0, GL_RGBA, GL_FLOAT, &layer[0]);
+		glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+		glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+		glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+		glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+		glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
+	}
+	glBindTexture(GL_TEXTURE_3D, 0);
+
+	return(true);
+}
+
+/***********************************************************
+ *  ApplyToProgram()
+ *
+ *  This method is used for binding the probe textures and
+ *  setting the uniforms that place the probe volume in the
+ *  world.  The program must be the one currently in use.
+ ***********************************************************/
+void LightBaker::ApplyToProgram(GLuint program) const
+{
+	if ((0 == m_textures[0]) || (program == 0))
+	{
+		return;
+	}
+
+	GLint activeTexture = GL_TEXTURE0;
+	glGetIntegerv(GL_ACTIVE_TEXTURE, &activeTexture);
+	for (int t = 0; t < 4; t++)
+	{
+		glActiveTexture(GL_TEXTURE0 + FIRST_PROBE_TEXTURE_UNIT + t);
+		glBindTexture(GL_TEXTURE_3D, m_textures[t]);
+		glUniform1i(glGetUniformLocation(program, g_ProbeTextureNames[t]), FIRST_PROBE_TEXTURE_UNIT + t);
+	}
+	glActiveTexture(activeTexture);
+
+	glm::vec3 volumeSize = glm::vec3(m_dimensions) * m_cellSize;
+	glUniform3f(glGetUniformLocation(program, "bakedVolumeMin"), m_volumeMin.x, m_volumeMin.y, m_volumeMin.z);
+	glUniform3f(glGetUniformLocation(program, "bakedVolumeSize"), volumeSize.x, volumeSize.y, volumeSize.z);
+	glUniform1f(glGetUniformLocation(program, "bakedCellSize"), m_cellSize);
+	glUniform1f(glGetUniformLocation(program, "bakedFocalStrength"), m_focalStrength);
+	glUniform1f(glGetUniformLocation(program, "bakedSpecularIntensity"), m_specularIntensity);
+}
+
+/***********************************************************
+ *  GetBakeTime()
+ *
+ *  This method returns the time taken by the last bake, in
+ *  milliseconds.
+ ***********************************************************/
+double LightBaker::GetBakeTime() const
+{
+	return(m_bakeTime);
+}
+
+/***********************************************************
+ *  BuildNode()
+ *
+ *  This method is used for filling in a node around a run
+ *  of objects.  Runs of more than two objects are split in
+ *  half along the longest side of their centers, with both
+ *  children stored next to each other.
+ ***********************************************************/
+void LightBaker::BuildNode(int nodeIndex, int first, int count)
+{
+	glm::vec3 boundsMin(1.0e30f);
+	glm::vec3 boundsMax(-1.0e30f);
+	glm::vec3 centerMin(1.0e30f);
+	glm::vec3 centerMax(-1.0e30f);
+	for (int i = first; i < first + count; i++)
+	{
+		const TRACE_OBJECT& object = m_objects[m_objectOrder[i]];
+		boundsMin = glm::min(boundsMin, object.boundsMin);
+		boundsMax = glm::max(boundsMax, object.boundsMax);
+		glm::vec3 center = (object.boundsMin + object.boundsMax) * 0.5f;
+		centerMin = glm::min(centerMin, center);
+		centerMax = glm::max(centerMax, center);
+	}
+	m_nodes[nodeIndex].boundsMin = boundsMin;
+	m_nodes[nodeIndex].boundsMax = boundsMax;
+
+	if (count <= 2)
+	{
+		m_nodes[nodeIndex].first = first;
+		m_nodes[nodeIndex].objectCount = count;
+		return;
+	}
+
+	glm::vec3 centerExtent = centerMax - centerMin;
+	int axis = 0;
+	if (centerExtent.y > centerExtent[axis])
+	{
+		axis = 1;
+	}
+	if (centerExtent.z > centerExtent[axis])
+	{
+		axis = 2;
+	}
+
+	int half = count / 2;
+	const std::vector<TRACE_OBJECT>& objects = m_objects;
+	std::nth_element(
+		m_objectOrder.begin() + first,
+		m_objectOrder.begin() + first + half,
+		m_objectOrder.begin() + first + count,
+		[&objects, axis](int a, int b)
+		{
+			return((objects[a].boundsMin[axis] + objects[a].boundsMax[axis]) <
+				(objects[b].boundsMin[axis] + objects[b].boundsMax[axis]));
+		});
+
+	int leftChild = (int)m_nodes.size();
+	m_nodes.push_back(BVH_NODE());
+	m_nodes.push_back(BVH_NODE());
+	m_nodes[nodeIndex].first = leftChild;
+	m_nodes[nodeIndex].objectCount = 0;
+
+	BuildNode(leftChild, first, half);
+	BuildNode(leftChild + 1, first + half, count - half);
+}
+
+/***********************************************************
+ *  TraceRay()
+ *
+ *  This method is used for finding the closest surface along
+ *  a ray, skipping the hierarchy nodes the ray misses.
+ ***********************************************************/
+bool LightBaker::TraceRay(const glm::vec3& origin, const glm::vec3& direction, float maxDistance, RAY_HIT& hit) const
+{
+	if (m_nodes.empty())
+	{
+		return(false);
+	}
+
+	bool bHit = false;
+	hit.distance = maxDistance;
+
+	int stack[MAX_TRAVERSAL_DEPTH];
+	int stackSize = 0;
+	stack[stackSize++] = 0;
+	while (stackSize > 0)
+	{
+		const BVH_NODE& node = m_nodes[stack[--stackSize]];
+
+		float distance = 0.0f;
+		glm::vec3 normal;
+		bool bInside = glm::all(glm::greaterThanEqual(origin, node.boundsMin)) &&
+			glm::all(glm::lessThanEqual(origin, node.boundsMax));
+		if ((bInside == false) &&
+			(IntersectBounds(origin, direction, node.boundsMin, node.boundsMax, hit.distance, distance, normal) == false))
+		{
+			continue;
+		}
+
+		if (node.objectCount > 0)
+		{
+			for (int i = node.first; i < node.first + node.objectCount; i++)
+			{
+				RAY_HIT objectHit;
+				if (IntersectObject(m_objects[m_objectOrder[i]], origin, direction, hit.distance, objectHit) == true)
+				{
+					hit = objectHit;
+					hit.object = m_objectOrder[i];
+					bHit = true;
+				}
+			}
+		}
+		else if (stackSize + 2 <= MAX_TRAVERSAL_DEPTH)
+		{
+			stack[stackSize++] = node.first;
+			stack[stackSize++] = node.first + 1;
+		}
+	}
+
+	return(bHit);
+}
+
+/***********************************************************
+ *  IsOccluded()
+ *
+ *  This method is used for checking whether any surface is
+ *  between a point and a light.
+ ***********************************************************/
+bool LightBaker::IsOccluded(const glm::vec3& origin, const glm::vec3& direction, float maxDistance) const
+{
+	RAY_HIT hit;
+	return(TraceRay(origin, direction, maxDistance, hit));
+}
+
+/***********************************************************
+ *  IntersectObject()
+ *
+ *  This method is used for intersecting a ray with one
+ *  object.  The ray is moved into object space without
+ *  normalizing its direction, so the distances along it stay
+ *  the same as in world space.  Shapes that are open shells
+ *  count as front facing from both sides, and the tori are
+ *  traced as their bounding boxes.
+ ***********************************************************/
+bool LightBaker::IntersectObject(const TRACE_OBJECT& object, const glm::vec3& origin, const glm::vec3& direction, float maxDistance, RAY_HIT& hit) const
+{
+	glm::vec3 o = glm::vec3(object.worldToObject * glm::vec4(origin, 1.0f));
+	glm::vec3 d = glm::mat3(object.worldToObject) * direction;
+
+	float bestDistance = maxDistance;
+	glm::vec3 bestNormal(0.0f);
+	bool bTwoSided = false;
+	float t0 = 0.0f;
+	float t1 = 0.0f;
+
+	switch (object.shape)
+	{
+	case SHAPE_PLANE:
+	{
+		bTwoSided = true;
+		if (std::fabs(d.y) > 1.0e-12f)
+		{
+			float t = -o.y / d.y;
+			glm::vec3 p = o + d * t;
+			if ((t > RAY_OFFSET) && (t < bestDistance) && (std::fabs(p.x) <= 1.0f) && (std::fabs(p.z) <= 1.0f))
+			{
+				bestDistance = t;
+				bestNormal = glm::vec3(0.0f, 1.0f, 0.0f);
+			}
+		}
+		break;
+	}
+	case SHAPE_BOX:
+	{
+		float t = 0.0f;
+		glm::vec3 normal;
+		if (IntersectBounds(o, d, glm::vec3(-0.5f), glm::vec3(0.5f), bestDistance, t, normal) == true)
+		{
+			bestDistance = t;
+			bestNormal = normal;
+		}
+		break;
+	}
+	case SHAPE_SPHERE:
+	case SHAPE_HALF_SPHERE:
+	{
+		bTwoSided = (object.shape == SHAPE_HALF_SPHERE);
+		if (SolveQuadratic(glm::dot(d, d), 2.0f * glm::dot(o, d), glm::dot(o, o) - 1.0f, t0, t1) == true)
+		{
+			float roots[2] = { t0, t1 };
+			for (int r = 0; r < 2; r++)
+			{
+				glm::vec3 p = o + d * roots[r];
+				if ((roots[r] > RAY_OFFSET) && (roots[r] < bestDistance) &&
+					((bTwoSided == false) || (p.y >= 0.0f)))
+				{
+					bestDistance = roots[r];
+					bestNormal = p;
+					break;
+				}
+			}
+		}
+		break;
+	}
+	case SHAPE_CYLINDER:
+	case SHAPE_CONE:
+	{
+		// side of the cylinder, x^2 + z^2 = 1, or of the cone with
+		// its tip at y = 1, x^2 + z^2 = (1 - y)^2
+		bool bCone = (object.shape == SHAPE_CONE);
+		float a = d.x * d.x + d.z * d.z;
+		float b = 2.0f * (o.x * d.x + o.z * d.z);
+		float c = o.x * o.x + o.z * o.z - 1.0f;
+		if (bCone == true)
+		{
+			float tip = 1.0f - o.y;
+			a -= d.y * d.y;
+			b += 2.0f * tip * d.y;
+			c = o.x * o.x + o.z * o.z - tip * tip;
+		}
+		if (SolveQuadratic(a, b, c, t0, t1) == true)
+		{
+			float roots[2] = { t0, t1 };
+			for (int r = 0; r < 2; r++)
+			{
+				glm::vec3 p = o + d * roots[r];
+				if ((roots[r] > RAY_OFFSET) && (roots[r] < bestDistance) && (p.y >= 0.0f) && (p.y <= 1.0f))
+				{
+					bestDistance = roots[r];
+					bestNormal = bCone ? glm::vec3(p.x, 1.0f - p.y, p.z) : glm::vec3(p.x, 0.0f, p.z);
+					break;
+				}
+			}
+		}
+
+		// the flat ends, only the bottom for the cone
+		if (std::fabs(d.y) > 1.0e-12f)
+		{
+			for (int end = 0; end < (bCone ? 1 : 2); end++)
+			{
+				float t = ((float)end - o.y) / d.y;
+				glm::vec3 p = o + d * t;
+				if ((t > RAY_OFFSET) && (t < bestDistance) && (p.x * p.x + p.z * p.z <= 1.0f))
+				{
+					bestDistance = t;
+					bestNormal = glm::vec3(0.0f, (end == 0) ? -1.0f : 1.0f, 0.0f);
+				}
+			}
+		}
+		break;
+	}
+	case SHAPE_TORUS:
+	case SHAPE_HALF_TORUS:
+	default:
+	{
+		glm::vec3 shapeMin;
+		glm::vec3 shapeMax;
+		GetShapeBounds(object.shape, shapeMin, shapeMax);
+		float t = 0.0f;
+		glm::vec3 normal;
+		if (IntersectBounds(o, d, shapeMin, shapeMax, bestDistance, t, normal) == true)
+		{
+			bestDistance = t;
+			bestNormal = normal;
+		}
+		break;
+	}
+	}
+
+	if (bestDistance >= maxDistance)
+	{
+		return(false);
+	}
+
+	hit.distance = bestDistance;
+	hit.normal = glm::normalize(object.normalMatrix * bestNormal);
+	hit.bFrontFace = (glm::dot(hit.normal, direction) < 0.0f);
+	if ((bTwoSided == true) && (hit.bFrontFace == false))
+	{
+		hit.normal = -hit.normal;
+		hit.bFrontFace = true;
+	}
+	hit.object = -1;
+	return(true);
+}
+
+/***********************************************************
+ *  GetLightArriving()
+ *
+ *  This method is used for getting the diffuse light of a
+ *  scene light that reaches a point, after the range and
+ *  spot falloff and the shadows of the static objects.
+ ***********************************************************/
+glm::vec3 LightBaker::GetLightArriving(const LIGHT_SOURCE& light, const glm::vec3& position, glm::vec3& lightDirection) const
+{
+	float lightDistance = 0.0f;
+	float attenuation = GetAttenuation(light, position, lightDirection, lightDistance);
+	if (attenuation <= 0.0f)
+	{
+		return(glm::vec3(0.0f));
+	}
+	if (IsOccluded(position, lightDirection, lightDistance - RAY_OFFSET) == true)
+	{
+		return(glm::vec3(0.0f));
+	}
+	return(light.diffuseColor * attenuation);
+}
+
+/***********************************************************
+ *  BakeLayers()
+ *
+ *  This method is used for baking the probes of one layer of
+ *  the grid after another until every layer is taken.  The
+ *  strongest direct light direction is kept sharp, and the
+ *  rest of the direct light and the bounced light are kept
+ *  as a color that fades with a direction.
+ ***********************************************************/
+void LightBaker::BakeLayers(std::atomic<int>* pNextLayer)
+{
+	std::vector<glm::vec3> lightColors(m_lights.size());
+	std::vector<glm::vec3> lightDirections(m_lights.size());
+
+	for (int z = (*pNextLayer)++; z < m_dimensions.z; z = (*pNextLayer)++)
+	{
+		for (int y = 0; y < m_dimensions.y; y++)
+		{
+			for (int x = 0; x < m_dimensions.x; x++)
+			{
+				glm::vec3 position = m_volumeMin + (glm::vec3((float)x, (float)y, (float)z) + 0.5f) * m_cellSize;
+
+				// ambient light of the scene lights, which is not shadowed
+				glm::vec3 ambient(0.0f);
+				glm::vec3 dominantDirection(0.0f);
+				for (size_t i = 0; i < m_lights.size(); i++)
+				{
+					float lightDistance = 0.0f;
+					glm::vec3 direction(0.0f);
+					ambient += m_lights[i].ambientColor *
+						GetAttenuation(m_lights[i], position, direction, lightDistance);
+
+					lightColors[i] = GetLightArriving(m_lights[i], position, lightDirections[i]);
+					dominantDirection += lightDirections[i] * GetLuminance(lightColors[i]);
+				}
+
+				float dominantLength = glm::length(dominantDirection);
+				dominantDirection = (dominantLength > 0.0f) ?
+					dominantDirection / dominantLength : glm::vec3(0.0f, 1.0f, 0.0f);
+
+				// the direct light along the dominant direction, with what
+				// is left over added to the softer indirect light
+				glm::vec3 directColor(0.0f);
+				glm::vec3 indirectColor(0.0f);
+				glm::vec3 indirectDirection(0.0f);
+				for (size_t i = 0; i < m_lights.size(); i++)
+				{
+					float alignment = std::max(glm::dot(lightDirections[i], dominantDirection), 0.0f);
+					directColor += lightColors[i] * alignment;
+					glm::vec3 remainder = lightColors[i] * (1.0f - alignment);
+					indirectColor += remainder * 0.25f;
+					indirectDirection += lightDirections[i] * (GetLuminance(remainder) * 0.5f);
+				}
+
+				// one bounce of the direct light off the surrounding objects
+				int insideCount = 0;
+				for (int r = 0; r < INDIRECT_RAY_COUNT; r++)
+				{
+					const glm::vec3& rayDirection = m_rayDirections[r];
+					RAY_HIT hit;
+					if (TraceRay(position, rayDirection, INDIRECT_RAY_LENGTH, hit) == false)
+					{
+						continue;
+					}
+					if (hit.bFrontFace == false)
+					{
+						insideCount++;
+						continue;
+					}
+
+					glm::vec3 hitPosition = position + rayDirection * hit.distance + hit.normal * RAY_OFFSET;
+					glm::vec3 irradiance(0.0f);
+					for (size_t i = 0; i < m_lights.size(); i++)
+					{
+						glm::vec3 direction(0.0f);
+						glm::vec3 color = GetLightArriving(m_lights[i], hitPosition, direction);
+						irradiance += color * std::max(glm::dot(hit.normal, direction), 0.0f);
+					}
+					glm::vec3 reflected = m_objects[hit.object].albedo * irradiance;
+
+					indirectColor += reflected / (float)INDIRECT_RAY_COUNT;
+					indirectDirection += rayDirection * (2.0f * GetLuminance(reflected) / INDIRECT_RAY_COUNT);
+				}
+
+				// the direction is stored relative to the brightness,
+				// so the shader scales the color by 1 + dot(direction, normal)
+				float indirectLuminance = GetLuminance(indirectColor);
+				if (indirectLuminance > 1.0e-6f)
+				{
+					indirectDirection /= indirectLuminance;
+				}
+				else
+				{
+					indirectDirection = glm::vec3(0.0f);
+				}
+
+				PROBE& probe = m_probes[((size_t)z * m_dimensions.y + y) * m_dimensions.x + x];
+				probe.directDirection = glm::vec4(dominantDirection, ambient.r);
+				probe.directColor = glm::vec4(directColor, ambient.g);
+				probe.indirectColor = glm::vec4(indirectColor, ambient.b);
+				// probes that mostly see the inside of an object are
+				// replaced by their neighbours afterwards
+				probe.indirectDirection = glm::vec4(indirectDirection,
+					(insideCount * 4 < INDIRECT_RAY_COUNT) ? 1.0f : 0.0f);
+			}
+		}
+	}
+}
+
+/***********************************************************
+ *  FillInsideProbes()
+ *
+ *  This method is used for replacing the probes that are
+ *  inside an object, which would darken the surfaces next
+ *  to them, with the average of their neighbours outside.
+ *  Two passes reach probes two cells deep.
+ ***********************************************************/
+void LightBaker::FillInsideProbes()
+{
+	const glm::ivec3 offsets[6] =
+	{
+		glm::ivec3(-1, 0, 0), glm::ivec3(1, 0, 0),
+		glm::ivec3(0, -1, 0), glm::ivec3(0, 1, 0),
+		glm::ivec3(0, 0, -1), glm::ivec3(0, 0, 1)
+	};
+
+	for (int pass = 0; pass < 2; pass++)
+	{
+		std::vector<PROBE> source = m_probes;
+		for (int z = 0; z < m_dimensions.z; z++)
+		{
+			for (int y = 0; y < m_dimensions.y; y++)
+			{
+				for (int x = 0; x < m_dimensions.x; x++)
+				{
+					size_t index = ((size_t)z * m_dimensions.y + y) * m_dimensions.x + x;
+					if (source[index].indirectDirection.w > 0.0f)
+					{
+						continue;
+					}
+
+					PROBE sum;
+					sum.directDirection = glm::vec4(0.0f);
+					sum.directColor = glm::vec4(0.0f);
+					sum.indirectColor = glm::vec4(0.0f);
+					sum.indirectDirection = glm::vec4(0.0f);
+					int count = 0;
+					for (int n = 0; n < 6; n++)
+					{
+						glm::ivec3 neighbour = glm::ivec3(x, y, z) + offsets[n];
+						if ((neighbour.x < 0) || (neighbour.y < 0) || (neighbour.z < 0) ||
+							(neighbour.x >= m_dimensions.x) || (neighbour.y >= m_dimensions.y) || (neighbour.z >= m_dimensions.z))
+						{
+							continue;
+						}
+						const PROBE& other = source[((size_t)neighbour.z * m_dimensions.y + neighbour.y) * m_dimensions.x + neighbour.x];
+						if (other.indirectDirection.w > 0.0f)
+						{
+							sum.directDirection += other.directDirection;
+							sum.directColor += other.directColor;
+							sum.indirectColor += other.indirectColor;
+							sum.indirectDirection += other.indirectDirection;
+							count++;
+						}
+					}
+
+					if (count > 0)
+					{
+						PROBE& probe = m_probes[index];
+						probe.directDirection = sum.directDirection / (float)count;
+						float directionLength = glm::length(glm::vec3(probe.directDirection));
+						if (directionLength > 0.0f)
+						{
+							probe.directDirection = glm::vec4(
+								glm::vec3(probe.directDirection) / directionLength,
+								probe.directDirection.w);
+						}
+						probe.directColor = sum.directColor / (float)count;
+						probe.indirectColor = sum.indirectColor / (float)count;
+						probe.indirectDirection = sum.indirectDirection / (float)count;
+						probe.indirectDirection.w = 1.0f;
+					}
+				}
+			}
+		}
+	}
+}
@@ -0,0 +1,185 @@
+///////////////////////////////////////////////////////////////////////////////
+// lightbaker.h
+// ============
+// bake the lighting of the static scene into a volume of light probes
+// on the CPU, so static objects are shaded without a light loop
+//
+//  Created for CS-330-Computational Graphics and Visualization
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "ClusteredLighting.h"
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+#include <atomic>
+#include <vector>
+
+/***********************************************************
+ *  LightBaker
+ *
+ *  This class contains the code for baking the light of the
+ *  scene lights into a grid of probes that covers the static
+ *  objects.  Each probe traces shadow rays to every light and
+ *  a set of rays that gather one bounce of indirect light,
+ *  against a bounding volume hierarchy of the objects.  The
+ *  probes are shared out between all of the CPU cores.
+ *
+ *  Each probe stores:
+ *
+ *    the direction and color of the dominant direct light
+ *    the unshadowed ambient light of the scene lights
+ *    the indirect light as a color and a direction
+ *
+ *  The result is written to a cooked file, keyed by a hash of
+ *  the objects and lights, and sampled by the baked lighting
+ *  shader variants from 3D textures.
+ ***********************************************************/
+class LightBaker
+{
+public:
+	// shapes the static objects are traced as, matching the
+	// ShapeMeshes primitives in object space
+	enum BAKE_SHAPE
+	{
+		SHAPE_PLANE = 0,
+		SHAPE_BOX,
+		SHAPE_CYLINDER,
+		SHAPE_CONE,
+		SHAPE_SPHERE,
+		SHAPE_HALF_SPHERE,
+		SHAPE_TORUS,
+		SHAPE_HALF_TORUS
+	};
+
+	// a static object that blocks and reflects light
+	struct BAKE_OBJECT
+	{
+		BAKE_SHAPE shape;
+		glm::mat4 model;
+		// diffuse color of the surface, for the reflected light
+		glm::vec3 albedo;
+	};
+
+	// most probes along the longest side of the volume
+	static const int MAX_VOLUME_RESOLUTION = 48;
+	// rays traced from each probe to gather the indirect light
+	static const int INDIRECT_RAY_COUNT = 64;
+
+	// constructor
+	LightBaker();
+	// destructor
+	~LightBaker();
+
+	// set the static objects and the lights that are baked
+	void SetScene(
+		const std::vector<BAKE_OBJECT>& objects,
+		const std::vector<LIGHT_SOURCE>& lights);
+
+	// bake the probes for the scene on all of the CPU cores
+	void Bake();
+	// save the baked probes to a cooked file
+	bool Save(const char* filePath) const;
+	// load baked probes, which fails when they were baked for
+	// a different scene
+	bool Load(const char* filePath);
+
+	// upload the baked probes into 3D textures
+	bool CreateTextures();
+	// bind the textures and set the volume uniforms into the
+	// passed in program
+	void ApplyToProgram(GLuint program) const;
+
+	// time taken by the last bake, in milliseconds
+	double GetBakeTime() const;
+
+private:
+	// an object prepared for tracing rays against
+	struct TRACE_OBJECT
+	{
+		BAKE_SHAPE shape;
+		glm::mat4 worldToObject;
+		glm::mat3 normalMatrix;
+		glm::vec3 albedo;
+		glm::vec3 boundsMin;
+		glm::vec3 boundsMax;
+	};
+
+	// a node of the bounding volume hierarchy, which holds
+	// either two child nodes or a run of objects
+	struct BVH_NODE
+	{
+		glm::vec3 boundsMin;
+		glm::vec3 boundsMax;
+		// first child node, or first object index for a leaf
+		int first;
+		// number of objects, zero for an inner node
+		int objectCount;
+	};
+
+	// the closest surface found along a ray
+	struct RAY_HIT
+	{
+		float distance;
+		glm::vec3 normal;
+		int object;
+		// true when the ray hit the outside of the surface
+		bool bFrontFace;
+	};
+
+	// light arriving at a probe
+	struct PROBE
+	{
+		// xyz dominant direct light direction, w ambient red
+		glm::vec4 directDirection;
+		// rgb dominant direct light color, w ambient green
+		glm::vec4 directColor;
+		// rgb indirect light color, w ambient blue
+		glm::vec4 indirectColor;
+		// xyz indirect light direction scaled by its strength,
+		// w one for a probe outside of every object
+		glm::vec4 indirectDirection;
+	};
+
+	std::vector<TRACE_OBJECT> m_objects;
+	// object indices in the order the leaf nodes refer to them
+	std::vector<int> m_objectOrder;
+	std::vector<BVH_NODE> m_nodes;
+	std::vector<LIGHT_SOURCE> m_lights;
+	// hash of the objects and lights the probes belong to
+	unsigned long long m_sceneKey;
+
+	// probe grid placement
+	glm::ivec3 m_dimensions;
+	glm::vec3 m_volumeMin;
+	float m_cellSize;
+	std::vector<PROBE> m_probes;
+	// directions of the indirect rays, spread evenly
+	std::vector<glm::vec3> m_rayDirections;
+
+	// specular highlight used for the dominant direct light
+	float m_focalStrength;
+	float m_specularIntensity;
+
+	// textures the probe values are uploaded into
+	GLuint m_textures[4];
+	double m_bakeTime;
+
+	// fill in a node of the bounding volume hierarchy over a run
+	// of objects, splitting it into child nodes
+	void BuildNode(int nodeIndex, int first, int count);
+	// find the closest surface along a ray, up to a distance
+	bool TraceRay(const glm::vec3& origin, const glm::vec3& direction, float maxDistance, RAY_HIT& hit) const;
+	// check whether any surface blocks a ray, up to a distance
+	bool IsOccluded(const glm::vec3& origin, const glm::vec3& direction, float maxDistance) const;
+	// intersect a ray with one object
+	bool IntersectObject(const TRACE_OBJECT& object, const glm::vec3& origin, const glm::vec3& direction, float maxDistance, RAY_HIT& hit) const;
+	// light from a scene light reaching a point, including shadows
+	glm::vec3 GetLightArriving(const LIGHT_SOURCE& light, const glm::vec3& position, glm::vec3& lightDirection) const;
+	// bake layers of the grid until none are left
+	void BakeLayers(std::atomic<int>* pNextLayer);
+	// replace the probes inside objects with their neighbours
+	void FillInsideProbes();
+};
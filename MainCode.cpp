@@ -1,5 +1,6 @@
 #include <iostream>         // error handling and output
 #include <cstdlib>          // EXIT_FAILURE
+#include <cstring>          // strcmp
 
 #include <GL/glew.h>        // GLEW library
 #include "GLFW/glfw3.h"     // GLFW library
@@ -13,6 +14,13 @@
 #include "ViewManager.h"
 #include "ShapeMeshes.h"
 #include "ShaderManager.h"
+#include "FramePacer.h"
+#include "DynamicResolution.h"
+#include "RenderGraph.h"
+#include "FrameCapture.h"
+#include "MeshImporter.h"
+#include "SceneFile.h"
+#include "SceneStreamer.h"
 
 // Namespace for declaring global variables
 namespace
@@ -29,6 +37,103 @@ namespace
 	ShaderManager* g_ShaderManager = nullptr;
 	// view manager object for managing the 3D view setup and projection to 2D
 	ViewManager* g_ViewManager = nullptr;
+	// frame pacer object for controlling the frame timing
+	FramePacer* g_FramePacer = nullptr;
+	// dynamic resolution object for holding a frame time target,
+	// only created when a target has been requested
+	DynamicResolution* g_DynamicResolution = nullptr;
+	// render graph object the passes of each frame are declared on
+	RenderGraph* g_RenderGraph = nullptr;
+	// frame capture object for screenshots and recording frames
+	FrameCapture* g_FrameCapture = nullptr;
+
+	// when true, frames are only rendered after something has changed
+	// and the render loop sleeps while the scene and camera are idle
+	bool bOnDemandRendering = true;
+	// the longest time to sleep waiting for events, in seconds
+	const double IDLE_WAIT_TIMEOUT = 0.5;
+	// the longest time to sleep while captured frames are still
+	// being read back, in seconds
+	const double CAPTURE_WAIT_TIMEOUT = 0.005;
+
+	// buffer swap mode and frame rate cap (zero for no cap)
+	FramePacer::SWAP_MODE swapMode = FramePacer::SWAP_VSYNC;
+	double frameRateCap = 0.0;
+
+	// GPU frame time target in milliseconds (zero to render at the
+	// full window resolution) and the filter used for upscaling
+	double targetFrameTime = 0.0;
+	DynamicResolution::UPSCALE_FILTER upscaleFilter = DynamicResolution::FILTER_BILINEAR;
+
+	// directory every frame is saved into, or NULL to only save
+	// screenshots, and the format the frames are saved in
+	const char* captureDirectory = NULL;
+	FrameCapture::CAPTURE_FORMAT captureFormat = FrameCapture::FORMAT_PNG;
+
+	// when true, the scene lighting is timed with 1 to 1000 lights
+	// before the render loop starts
+	bool bLightingBenchmark = false;
+
+	// when true, picking rays are timed against the scene objects
+	// before the render loop starts
+	bool bPickingBenchmark = false;
+
+	// when true, the four preset views drawn at once are timed
+	// before the render loop starts
+	bool bQuadViewBenchmark = false;
+
+	// when true, OpenGL and the software rasterizer are timed
+	// drawing the scene before the render loop starts
+	bool bRasterizerBenchmark = false;
+
+	// when true, generated grids of 10k to 1M objects are timed
+	// drawn one at a time and from recorded runs before the render
+	// loop starts
+	bool bSubmissionBenchmark = false;
+
+	// when true, the scene is drawn by the software rasterizer
+	// instead of OpenGL
+	bool bSoftwareRendering = false;
+
+	// when true, the opaque basic shapes are recorded on worker
+	// threads and drawn as instanced runs
+	bool bRecordedDraws = false;
+
+	// when true, the opaque objects are lit by a deferred pass
+	bool bDeferredShading = false;
+
+	// when true, the static lighting is baked and saved before the
+	// render loop starts, instead of loaded from the cooked file
+	bool bBakeLighting = false;
+
+	// when true, the impostors of the distant object groups are
+	// baked and saved with the window hidden, then the application
+	// exits
+	bool bBakeImpostors = false;
+
+	// image file to ray trace the starting camera view into with
+	// the window hidden, then exit, or NULL to run the application
+	const char* rayTracePath = NULL;
+	// samples added up for every pixel of the ray traced image
+	int rayTraceSamples = 16;
+
+	// model file to time the importing and cached loading of,
+	// or NULL to skip the mesh benchmark
+	const char* meshBenchmarkPath = NULL;
+
+	// cooked scene file to load instead of the built in scene,
+	// or NULL for the default path
+	const char* sceneFilePath = NULL;
+	// JSON scene layout to cook and the cooked file to write, or
+	// NULL to run the application
+	const char* cookSourcePath = NULL;
+	const char* cookTargetPath = NULL;
+	// cooked cell index to stream instead of loading a whole
+	// scene, or NULL to load the scene file
+	const char* streamIndexPath = NULL;
+	// size of the cells a JSON scene layout is split into when it
+	// is cooked for streaming, or zero to cook a single file
+	float cookCellSize = 0.0f;
 }
 
 // Function declarations - all functions that are called manually
@@ -45,6 +150,171 @@ bool InitializeGLEW();
  ***********************************************************/
 int main(int argc, char* argv[])
 {
+	// check the command line for rendering options
+	for (int i = 1; i < argc; i++)
+	{
+		// render every frame instead of only on changes
+		if (strcmp(argv[i], "--continuous") == 0)
+		{
+			bOnDemandRendering = false;
+		}
+		// buffer swap mode - off, on or adaptive
+		else if ((strcmp(argv[i], "--vsync") == 0) && (i + 1 < argc))
+		{
+			i++;
+			if (FramePacer::ParseSwapMode(argv[i], swapMode) == false)
+			{
+				std::cerr << "Unknown vsync mode: " << argv[i] << std::endl;
+			}
+		}
+		// frame rate cap in frames per second
+		else if ((strcmp(argv[i], "--fps") == 0) && (i + 1 < argc))
+		{
+			i++;
+			frameRateCap = atof(argv[i]);
+		}
+		// GPU frame time target in milliseconds
+		else if ((strcmp(argv[i], "--target-ms") == 0) && (i + 1 < argc))
+		{
+			i++;
+			targetFrameTime = atof(argv[i]);
+		}
+		// upscale filter - bilinear or sharpen
+		else if ((strcmp(argv[i], "--upscale") == 0) && (i + 1 < argc))
+		{
+			i++;
+			if (DynamicResolution::ParseUpscaleFilter(argv[i], upscaleFilter) == false)
+			{
+				std::cerr << "Unknown upscale filter: " << argv[i] << std::endl;
+			}
+		}
+		// save every frame into a directory
+		else if ((strcmp(argv[i], "--capture-frames") == 0) && (i + 1 < argc))
+		{
+			i++;
+			captureDirectory = argv[i];
+		}
+		// capture format - png or raw
+		else if ((strcmp(argv[i], "--capture-format") == 0) && (i + 1 < argc))
+		{
+			i++;
+			if (FrameCapture::ParseFormat(argv[i], captureFormat) == false)
+			{
+				std::cerr << "Unknown capture format: " << argv[i] << std::endl;
+			}
+		}
+		// time the scene lighting with increasing light counts
+		else if (strcmp(argv[i], "--light-benchmark") == 0)
+		{
+			bLightingBenchmark = true;
+		}
+		// time the picking rays with single rays and batches
+		else if (strcmp(argv[i], "--pick-benchmark") == 0)
+		{
+			bPickingBenchmark = true;
+		}
+		// time the four preset views in one pass and in four
+		else if (strcmp(argv[i], "--quad-benchmark") == 0)
+		{
+			bQuadViewBenchmark = true;
+		}
+		// time OpenGL against the software rasterizer
+		else if (strcmp(argv[i], "--raster-benchmark") == 0)
+		{
+			bRasterizerBenchmark = true;
+		}
+		// time drawing many objects one at a time and recorded
+		else if (strcmp(argv[i], "--submit-benchmark") == 0)
+		{
+			bSubmissionBenchmark = true;
+		}
+		// draw the scene on the CPU with the software rasterizer
+		else if (strcmp(argv[i], "--software") == 0)
+		{
+			bSoftwareRendering = true;
+		}
+		// record the opaque draws on worker threads
+		else if (strcmp(argv[i], "--record-draws") == 0)
+		{
+			bRecordedDraws = true;
+		}
+		// light the opaque objects with the deferred renderer
+		else if (strcmp(argv[i], "--deferred") == 0)
+		{
+			bDeferredShading = true;
+		}
+		// bake the static lighting again and save it
+		else if (strcmp(argv[i], "--bake-lighting") == 0)
+		{
+			bBakeLighting = true;
+		}
+		// bake the impostors of the distant object groups and exit
+		else if (strcmp(argv[i], "--bake-impostors") == 0)
+		{
+			bBakeImpostors = true;
+		}
+		// ray trace the starting camera view into an image and exit
+		else if ((strcmp(argv[i], "--ray-trace") == 0) && (i + 1 < argc))
+		{
+			i++;
+			rayTracePath = argv[i];
+		}
+		// samples for every pixel of the ray traced image
+		else if ((strcmp(argv[i], "--ray-samples") == 0) && (i + 1 < argc))
+		{
+			i++;
+			rayTraceSamples = atoi(argv[i]);
+			if (rayTraceSamples < 1)
+			{
+				rayTraceSamples = 1;
+			}
+		}
+		// time importing and loading the passed in model file
+		else if ((strcmp(argv[i], "--mesh-benchmark") == 0) && (i + 1 < argc))
+		{
+			i++;
+			meshBenchmarkPath = argv[i];
+		}
+		// load a cooked scene file instead of the built in scene
+		else if ((strcmp(argv[i], "--scene") == 0) && (i + 1 < argc))
+		{
+			i++;
+			sceneFilePath = argv[i];
+		}
+		// cook a JSON scene layout into a scene file and exit
+		else if ((strcmp(argv[i], "--cook-scene") == 0) && (i + 2 < argc))
+		{
+			cookSourcePath = argv[i + 1];
+			cookTargetPath = argv[i + 2];
+			i += 2;
+		}
+		// stream the cells of a cooked cell index around the camera
+		else if ((strcmp(argv[i], "--stream") == 0) && (i + 1 < argc))
+		{
+			i++;
+			streamIndexPath = argv[i];
+		}
+		// split a JSON scene layout into cells of the passed in size,
+		// write them with their index and exit
+		else if ((strcmp(argv[i], "--cook-cells") == 0) && (i + 3 < argc))
+		{
+			cookSourcePath = argv[i + 1];
+			cookTargetPath = argv[i + 2];
+			cookCellSize = (float)atof(argv[i + 3]);
+			i += 3;
+		}
+	}
+
+	// cooking a scene needs no window
+	if ((cookSourcePath != NULL) && (cookCellSize > 0.0f))
+	{
+		return((SceneStreamer::Cook(cookSourcePath, cookTargetPath, cookCellSize) == true) ? EXIT_SUCCESS : EXIT_FAILURE);
+	}
+	if (cookSourcePath != NULL)
+	{
+		return((SceneFile::Cook(cookSourcePath, cookTargetPath) == true) ? EXIT_SUCCESS : EXIT_FAILURE);
+	}
+
 	// if GLFW fails initialization, then terminate the application
 	if (InitializeGLFW() == false)
 	{
@@ -57,6 +327,13 @@ int main(int argc, char* argv[])
 	g_ViewManager = new ViewManager(
 		g_ShaderManager);
 
+	// baking and ray tracing need an OpenGL context but nothing on
+	// the screen
+	if ((bBakeImpostors == true) || (rayTracePath != NULL))
+	{
+		glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+	}
+
 	// try to create the main display window
 	g_Window = g_ViewManager->CreateDisplayWindow(WINDOW_TITLE);
 
@@ -66,6 +343,43 @@ int main(int argc, char* argv[])
 		return(EXIT_FAILURE);
 	}
 
+	// set up the buffer swap interval and the frame rate cap
+	g_FramePacer = new FramePacer();
+	g_FramePacer->SetSwapMode(swapMode);
+	g_FramePacer->SetFrameRateCap(frameRateCap);
+
+	// render offscreen at a varying resolution when a frame time
+	// target has been requested
+	if (targetFrameTime > 0.0)
+	{
+		g_DynamicResolution = new DynamicResolution();
+		if (g_DynamicResolution->Initialize(g_Window) == true)
+		{
+			g_DynamicResolution->SetTargetFrameTime(targetFrameTime);
+			g_DynamicResolution->SetUpscaleFilter(upscaleFilter);
+		}
+		else
+		{
+			delete g_DynamicResolution;
+			g_DynamicResolution = NULL;
+		}
+	}
+
+	// the frames are drawn as passes of the render graph
+	g_RenderGraph = new RenderGraph();
+
+	// screenshots and recorded frames are read back without
+	// waiting for the GPU.  a recording saves every frame, so the
+	// frames are drawn continuously instead of only on changes
+	g_FrameCapture = new FrameCapture();
+	g_FrameCapture->Initialize();
+	g_FrameCapture->SetFormat(captureFormat);
+	if (captureDirectory != NULL)
+	{
+		g_FrameCapture->StartContinuous(captureDirectory);
+		bOnDemandRendering = false;
+	}
+
 	// load the shader code from the external GLSL files
 	g_ShaderManager->LoadShaders(
 		"../../Utilities/shaders/vertexShader.glsl",
@@ -74,34 +388,267 @@ int main(int argc, char* argv[])
 
 	// try to create a new scene manager object and prepare the 3D scene
 	g_SceneManager = new SceneManager(g_ShaderManager);
+	g_SceneManager->SetDeferredShading(bDeferredShading);
+	// the benchmark prepares the scene for the software rasterizer,
+	// so both draw it with the same features
+	g_SceneManager->SetSoftwareRendering((bSoftwareRendering == true) || (bRasterizerBenchmark == true));
+	g_SceneManager->SetRecordedDraws((bRecordedDraws == true) || (bSubmissionBenchmark == true));
+	g_SceneManager->SetBakeLighting(bBakeLighting);
+	g_SceneManager->SetBakeImpostors(bBakeImpostors);
+	if (sceneFilePath != NULL)
+	{
+		g_SceneManager->SetSceneFile(sceneFilePath);
+	}
+	if (streamIndexPath != NULL)
+	{
+		g_SceneManager->SetStreamingIndex(streamIndexPath);
+	}
 	g_SceneManager->PrepareScene();
 
+	// the impostors were baked while the scene was prepared, so
+	// the render loop is skipped
+	if (bBakeImpostors == true)
+	{
+		glfwSetWindowShouldClose(g_Window, GLFW_TRUE);
+	}
+
+	// time the lighting from the starting camera view
+	if (bLightingBenchmark == true)
+	{
+		g_ViewManager->PrepareSceneView();
+		g_SceneManager->SetViewTransform(
+			g_ViewManager->GetViewMatrix(),
+			g_ViewManager->GetProjectionMatrix(),
+			g_ViewManager->GetViewPosition());
+		glEnable(GL_DEPTH_TEST);
+		g_SceneManager->RunLightingBenchmark();
+	}
+
+	// time the picking from the starting camera view
+	if (bPickingBenchmark == true)
+	{
+		g_ViewManager->PrepareSceneView();
+		g_SceneManager->SetViewTransform(
+			g_ViewManager->GetViewMatrix(),
+			g_ViewManager->GetProjectionMatrix(),
+			g_ViewManager->GetViewPosition());
+		g_SceneManager->RunPickingBenchmark();
+	}
+
+	// time the four preset views against the starting camera view
+	if (bQuadViewBenchmark == true)
+	{
+		glm::mat4 views[ShaderVariantCache::MULTI_VIEW_COUNT];
+		glm::mat4 projections[ShaderVariantCache::MULTI_VIEW_COUNT];
+		glm::vec3 viewPositions[ShaderVariantCache::MULTI_VIEW_COUNT];
+		g_ViewManager->PrepareSceneView();
+		g_SceneManager->SetViewTransform(
+			g_ViewManager->GetViewMatrix(),
+			g_ViewManager->GetProjectionMatrix(),
+			g_ViewManager->GetViewPosition());
+		g_ViewManager->GetQuadViews(views, projections, viewPositions);
+		g_SceneManager->SetQuadViews(views, projections, viewPositions);
+		glEnable(GL_DEPTH_TEST);
+		g_SceneManager->RunQuadViewBenchmark();
+		g_SceneManager->ClearQuadViews();
+	}
+
+	// time OpenGL and the software rasterizer from the starting
+	// camera view, then draw with the one that was asked for
+	if (bRasterizerBenchmark == true)
+	{
+		g_ViewManager->PrepareSceneView();
+		g_SceneManager->SetViewTransform(
+			g_ViewManager->GetViewMatrix(),
+			g_ViewManager->GetProjectionMatrix(),
+			g_ViewManager->GetViewPosition());
+		glEnable(GL_DEPTH_TEST);
+		g_SceneManager->RunRasterizerBenchmark();
+		g_SceneManager->SetSoftwareRendering(bSoftwareRendering);
+	}
+
+	// time many objects drawn one at a time and from recorded
+	// runs, then draw the way that was asked for
+	if (bSubmissionBenchmark == true)
+	{
+		g_ViewManager->PrepareSceneView();
+		g_SceneManager->SetViewTransform(
+			g_ViewManager->GetViewMatrix(),
+			g_ViewManager->GetProjectionMatrix(),
+			g_ViewManager->GetViewPosition());
+		glEnable(GL_DEPTH_TEST);
+		g_SceneManager->RunSubmissionBenchmark();
+		if (bRecordedDraws == false)
+		{
+			g_SceneManager->SetRecordedDraws(false);
+		}
+	}
+
+	// ray trace the starting camera view into the image file, and
+	// skip the render loop
+	if (rayTracePath != NULL)
+	{
+		g_ViewManager->PrepareSceneView();
+		g_SceneManager->SetViewTransform(
+			g_ViewManager->GetViewMatrix(),
+			g_ViewManager->GetProjectionMatrix(),
+			g_ViewManager->GetViewPosition());
+		g_SceneManager->RenderRayTracedImage(rayTracePath, rayTraceSamples);
+		glfwSetWindowShouldClose(g_Window, GLFW_TRUE);
+	}
+
+	// time the mesh importer with the requested model file
+	if (meshBenchmarkPath != NULL)
+	{
+		MeshImporter meshImporter;
+		meshImporter.RunBenchmark(meshBenchmarkPath);
+	}
+
 	// loop will keep running until the application is closed 
 	// or until an error has occurred
 	while (!glfwWindowShouldClose(g_Window))
 	{
-		// Enable z-depth
-		glEnable(GL_DEPTH_TEST);
+		// when nothing has changed, the last frame is left on the
+		// display and the loop sleeps until an event wakes it up
+		if ((bOnDemandRendering == true) &&
+			(g_ViewManager->IsRedrawNeeded() == false) &&
+			(g_SceneManager->IsRedrawNeeded() == false))
+		{
+			glfwWaitEventsTimeout((g_FrameCapture->HasPendingFrames() == true) ? CAPTURE_WAIT_TIMEOUT : IDLE_WAIT_TIMEOUT);
+			// don't count the idle time as camera movement time
+			g_ViewManager->ResetFrameTiming();
+			g_FramePacer->ResetTiming();
+			// keep handing the captured frames to the writers
+			g_FrameCapture->Update();
+			continue;
+		}
 
-		// Clear the frame and z buffers
-		glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
-		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+		// wait until the next frame is due
+		g_FramePacer->WaitForNextFrame();
 
-		// convert from 3D object space to 2D view
-		g_ViewManager->PrepareSceneView();
+		// query the latest GLFW events as late as possible, so
+		// the camera is updated with the freshest input
+		glfwPollEvents();
+
+		// declare the passes of the frame.  the scene is drawn into
+		// the window, or into offscreen targets at the window size
+		// that are upscaled into it
+		int windowWidth = 0;
+		int windowHeight = 0;
+		glfwGetFramebufferSize(g_Window, &windowWidth, &windowHeight);
+		bool bOffscreen = (NULL != g_DynamicResolution) && (windowWidth > 0) && (windowHeight > 0);
+		g_RenderGraph->Reset();
+		int window = g_RenderGraph->ImportFramebuffer("window", 0, windowWidth, windowHeight);
+		int sceneColor = window;
+		int sceneDepth = -1;
+		if (bOffscreen == true)
+		{
+			RenderGraph::TEXTURE_DESC colorDesc = { windowWidth, windowHeight, GL_RGBA8 };
+			RenderGraph::TEXTURE_DESC depthDesc = { windowWidth, windowHeight, GL_DEPTH24_STENCIL8 };
+			sceneColor = g_RenderGraph->CreateTexture("scene color", colorDesc);
+			sceneDepth = g_RenderGraph->CreateTexture("scene depth", depthDesc);
+		}
+
+		int scenePass = g_RenderGraph->AddPass("scene", [bOffscreen](const RenderGraph&)
+		{
+			// limit the rendering to the scaled part of the targets
+			if (bOffscreen == true)
+			{
+				g_DynamicResolution->BeginFrame();
+			}
+
+			// Enable z-depth
+			glEnable(GL_DEPTH_TEST);
+
+			// Clear the frame and z buffers
+			glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
+			glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+			// convert from 3D object space to 2D view
+			g_ViewManager->PrepareSceneView();
+			g_SceneManager->SetViewTransform(
+				g_ViewManager->GetViewMatrix(),
+				g_ViewManager->GetProjectionMatrix(),
+				g_ViewManager->GetViewPosition());
+
+			// show the four preset views at once, one in each quarter
+			if (g_ViewManager->IsQuadView() == true)
+			{
+				glm::mat4 views[ShaderVariantCache::MULTI_VIEW_COUNT];
+				glm::mat4 projections[ShaderVariantCache::MULTI_VIEW_COUNT];
+				glm::vec3 viewPositions[ShaderVariantCache::MULTI_VIEW_COUNT];
+				g_ViewManager->GetQuadViews(views, projections, viewPositions);
+				g_SceneManager->SetQuadViews(views, projections, viewPositions);
+			}
+			else
+			{
+				g_SceneManager->ClearQuadViews();
+			}
 
-		// refresh the 3D scene
-		g_SceneManager->RenderScene();
+			// refresh the 3D scene
+			g_SceneManager->RenderScene();
+		});
+		g_RenderGraph->WriteTexture(scenePass, sceneColor);
+		if (sceneDepth >= 0)
+		{
+			g_RenderGraph->WriteTexture(scenePass, sceneDepth);
+		}
 
+		// upscale the offscreen targets into the window
+		if (bOffscreen == true)
+		{
+			int upscalePass = g_RenderGraph->AddPass("upscale", [sceneColor](const RenderGraph& graph)
+			{
+				g_DynamicResolution->EndFrame(graph.GetTexture(sceneColor));
+			});
+			g_RenderGraph->ReadTexture(upscalePass, sceneColor);
+			g_RenderGraph->WriteTexture(upscalePass, window);
+		}
+
+		// read the finished window back when a screenshot has been
+		// asked for, by the key press the frame shows, or frames are
+		// being recorded
+		int capturePass = g_RenderGraph->AddPass("capture", [windowWidth, windowHeight](const RenderGraph&)
+		{
+			if (g_ViewManager->TakeScreenshotRequest() == true)
+			{
+				g_FrameCapture->RequestScreenshot();
+			}
+			glBindFramebuffer(GL_READ_FRAMEBUFFER, 0);
+			g_FrameCapture->CaptureFrame(windowWidth, windowHeight);
+		});
+		g_RenderGraph->ReadTexture(capturePass, window);
+		g_RenderGraph->KeepPass(capturePass);
+
+		if (g_RenderGraph->Compile() == true)
+		{
+			g_RenderGraph->Execute();
+		}
 
 		// Flips the the back buffer with the front buffer every frame.
 		glfwSwapBuffers(g_Window);
 
-		// query the latest GLFW events
-		glfwPollEvents();
+		// write the captured frames whose copies have finished
+		g_FrameCapture->Update();
 	}
 
-	// clear the allocated manager objects from memory
+	// clear the allocated manager objects from memory, writing
+	// the captured frames first
+	if (NULL != g_FrameCapture)
+	{
+		delete g_FrameCapture;
+		g_FrameCapture = NULL;
+	}
+	if (NULL != g_RenderGraph)
+	{
+		delete g_RenderGraph;
+		g_RenderGraph = NULL;
+	}
+	if (NULL != g_DynamicResolution)
+	{
+		delete g_DynamicResolution;
+		g_DynamicResolution = NULL;
+	}
 	if (NULL != g_SceneManager)
 	{
 		delete g_SceneManager;
@@ -117,6 +664,11 @@ int main(int argc, char* argv[])
 		delete g_ShaderManager;
 		g_ShaderManager = NULL;
 	}
+	if (NULL != g_FramePacer)
+	{
+		delete g_FramePacer;
+		g_FramePacer = NULL;
+	}
 
 	// Terminates the program successfully
 	exit(EXIT_SUCCESS); 
@@ -0,0 +1,201 @@
+///////////////////////////////////////////////////////////////////////////////
+// mappedfile.cpp
+// ============
+// map a whole file into memory read only, so its contents can be used
+// in place without reading them into a buffer first
+//
+//  Created for CS-330-Computational Graphics and Visualization
+///////////////////////////////////////////////////////////////////////////////
+
+#include "MappedFile.h"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+/***********************************************************
+ *  MappedFile()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+MappedFile::MappedFile()
+{
+	m_pData = NULL;
+	m_size = 0;
+	m_modifiedTime = 0;
+#ifdef _WIN32
+	m_fileHandle = INVALID_HANDLE_VALUE;
+	m_mappingHandle = NULL;
+#endif
+}
+
+/***********************************************************
+ *  ~MappedFile()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+MappedFile::~MappedFile()
+{
+	Close();
+}
+
+/***********************************************************
+ *  Open()
+ *
+ *  This method is used for mapping the passed in file into
+ *  memory.  Empty files cannot be mapped, and fail to open.
+ ***********************************************************/
+bool MappedFile::Open(const char* filePath)
+{
+	Close();
+
+#ifdef _WIN32
+	HANDLE fileHandle = CreateFileA(filePath, GENERIC_READ, FILE_SHARE_READ, NULL,
+		OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+	if (fileHandle == INVALID_HANDLE_VALUE)
+	{
+		return(false);
+	}
+
+	LARGE_INTEGER fileSize;
+	FILETIME writeTime;
+	if ((GetFileSizeEx(fileHandle, &fileSize) == FALSE) ||
+		(fileSize.QuadPart <= 0) ||
+		(GetFileTime(fileHandle, NULL, NULL, &writeTime) == FALSE))
+	{
+		CloseHandle(fileHandle);
+		return(false);
+	}
+
+	HANDLE mappingHandle = CreateFileMappingA(fileHandle, NULL, PAGE_READONLY, 0, 0, NULL);
+	if (mappingHandle == NULL)
+	{
+		CloseHandle(fileHandle);
+		return(false);
+	}
+
+	void* pView = MapViewOfFile(mappingHandle, FILE_MAP_READ, 0, 0, 0);
+	if (pView == NULL)
+	{
+		CloseHandle(mappingHandle);
+		CloseHandle(fileHandle);
+		return(false);
+	}
+
+	ULARGE_INTEGER writeTicks;
+	writeTicks.LowPart = writeTime.dwLowDateTime;
+	writeTicks.HighPart = writeTime.dwHighDateTime;
+
+	m_fileHandle = fileHandle;
+	m_mappingHandle = mappingHandle;
+	m_pData = (const unsigned char*)pView;
+	m_size = (size_t)fileSize.QuadPart;
+	// file times count 100 nanosecond ticks
+	m_modifiedTime = (long long)(writeTicks.QuadPart / 10000000ULL);
+#else
+	int fileDescriptor = open(filePath, O_RDONLY);
+	if (fileDescriptor < 0)
+	{
+		return(false);
+	}
+
+	struct stat fileStatus;
+	if ((fstat(fileDescriptor, &fileStatus) != 0) || (fileStatus.st_size <= 0))
+	{
+		close(fileDescriptor);
+		return(false);
+	}
+
+	void* pView = mmap(NULL, (size_t)fileStatus.st_size, PROT_READ, MAP_PRIVATE, fileDescriptor, 0);
+	// the mapping keeps the file open by itself
+	close(fileDescriptor);
+	if (pView == MAP_FAILED)
+	{
+		return(false);
+	}
+	madvise(pView, (size_t)fileStatus.st_size, MADV_SEQUENTIAL);
+
+	m_pData = (const unsigned char*)pView;
+	m_size = (size_t)fileStatus.st_size;
+	m_modifiedTime = (long long)fileStatus.st_mtime;
+#endif
+
+	return(true);
+}
+
+/***********************************************************
+ *  Close()
+ *
+ *  This method is used for releasing the mapping.  Pointers
+ *  into the mapped file are no longer valid afterwards.
+ ***********************************************************/
+void MappedFile::Close()
+{
+	if (NULL == m_pData)
+	{
+		return;
+	}
+
+#ifdef _WIN32
+	UnmapViewOfFile(m_pData);
+	CloseHandle(m_mappingHandle);
+	CloseHandle(m_fileHandle);
+	m_mappingHandle = NULL;
+	m_fileHandle = INVALID_HANDLE_VALUE;
+#else
+	munmap((void*)m_pData, m_size);
+#endif
+
+	m_pData = NULL;
+	m_size = 0;
+	m_modifiedTime = 0;
+}
+
+/***********************************************************
+ *  IsOpen()
+ *
+ *  This method returns whether a file is mapped.
+ ***********************************************************/
+bool MappedFile::IsOpen() const
+{
+	return(NULL != m_pData);
+}
+
+/***********************************************************
+ *  GetData()
+ *
+ *  This method returns the first byte of the mapped file.
+ ***********************************************************/
+const unsigned char* MappedFile::GetData() const
+{
+	return(m_pData);
+}
+
+/***********************************************************
+ *  GetSize()
+ *
+ *  This method returns the size of the mapped file.
+ ***********************************************************/
+size_t MappedFile::GetSize() const
+{
+	return(m_size);
+}
+
+/***********************************************************
+ *  GetModifiedTime()
+ *
+ *  This method returns when the mapped file was last
+ *  written, for telling whether it changed since a cooked
+ *  copy of it was made.
+ ***********************************************************/
+long long MappedFile::GetModifiedTime() const
+{
+	return(m_modifiedTime);
+}
@@ -0,0 +1,57 @@
+///////////////////////////////////////////////////////////////////////////////
+// mappedfile.h
+// ============
+// map a whole file into memory read only, so its contents can be used
+// in place without reading them into a buffer first
+//
+//  Created for CS-330-Computational Graphics and Visualization
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <cstddef>
+
+/***********************************************************
+ *  MappedFile
+ *
+ *  This class contains the code for mapping a file into the
+ *  address space of the process.  The pages are read by the
+ *  operating system as they are first touched, and stay in
+ *  the file cache between runs.  The mapping is released
+ *  when the object is closed or destroyed.
+ ***********************************************************/
+class MappedFile
+{
+public:
+	// constructor
+	MappedFile();
+	// destructor
+	~MappedFile();
+
+	// map the passed in file, closing any file mapped before
+	bool Open(const char* filePath);
+	// release the mapping
+	void Close();
+
+	// check whether a file is mapped
+	bool IsOpen() const;
+	// first byte of the mapped file
+	const unsigned char* GetData() const;
+	// size of the mapped file in bytes
+	size_t GetSize() const;
+	// last modification time of the mapped file, in seconds
+	long long GetModifiedTime() const;
+
+private:
+	const unsigned char* m_pData;
+	size_t m_size;
+	long long m_modifiedTime;
+#ifdef _WIN32
+	void* m_fileHandle;
+	void* m_mappingHandle;
+#endif
+
+	// the mapping cannot be shared between two objects
+	MappedFile(const MappedFile&);
+	MappedFile& operator=(const MappedFile&);
+};
@@ -0,0 +1,1908 @@
+///////////////////////////////////////////////////////////////////////////////
+// meshimporter.cpp
+// ============
+// import triangle meshes from OBJ and glTF 2.0 files, and keep the
+// converted meshes in a cooked binary cache that loads straight into
+// the vertex and index buffers
+//
+//  Created for CS-330-Computational Graphics and Visualization
+///////////////////////////////////////////////////////////////////////////////
+
+#include "MeshImporter.h"
+#include "JsonReader.h"
+#include "MeshSimplifier.h"
+#include "MeshletBuilder.h"
+
+#include <glm/gtx/transform.hpp>
+
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <thread>
+
+#ifdef _WIN32
+#include <direct.h>
+#else
+#include <sys/stat.h>
+#include <sys/types.h>
+#endif
+
+// declaration of the global variables and defines
+namespace
+{
+	// identifies a cooked mesh file written by this class
+	const unsigned int CACHE_FILE_MAGIC = 0x4853454D;	// "MESH"
+	// increase when the layout of the cooked files changes
+	const unsigned int CACHE_FILE_VERSION = 3;
+
+	// FNV-1a hash constants
+	const unsigned long long HASH_OFFSET = 14695981039346656037ULL;
+	const unsigned long long HASH_PRIME = 1099511628211ULL;
+
+	// smallest run of an OBJ file worth giving its own thread
+	const size_t MIN_OBJ_CHUNK_SIZE = 1 << 20;
+	// added to an OBJ index that counts back from the end of its
+	// chunk's elements, until the chunk's offset is known.  the
+	// index can reach back into the chunks before, so it may be
+	// negative, and absolute indices stay below RELATIVE_LIMIT
+	const int RELATIVE_INDEX = 1 << 30;
+	const int RELATIVE_LIMIT = 1 << 29;
+
+	// glTF binary container identifiers
+	const unsigned int GLB_MAGIC = 0x46546C67;		// "glTF"
+	const unsigned int GLB_CHUNK_JSON = 0x4E4F534A;	// "JSON"
+	const unsigned int GLB_CHUNK_BIN = 0x004E4942;	// "BIN"
+	// glTF accessor component types
+	const int GLTF_UNSIGNED_BYTE = 5121;
+	const int GLTF_UNSIGNED_SHORT = 5123;
+	const int GLTF_UNSIGNED_INT = 5125;
+	const int GLTF_FLOAT = 5126;
+	// glTF primitive mode for a triangle list
+	const int GLTF_TRIANGLES = 4;
+	// deepest node hierarchy that is followed
+	const int MAX_NODE_DEPTH = 64;
+
+	// parsed glTF JSON values
+	typedef JsonReader::JSON_VALUE JSON_VALUE;
+
+	// detail levels with fewer meshlets than this are drawn whole
+	const unsigned int MIN_CULLED_MESHLETS = 16;
+	// views the meshlet culling is timed from in the benchmark
+	const int CULLING_VIEW_COUNT = 6;
+
+	// header written at the start of each cooked mesh file,
+	// followed by the detail levels, the meshlets, the vertices
+	// and then the indices
+	struct CACHE_FILE_HEADER
+	{
+		unsigned int magic;
+		unsigned int version;
+		unsigned long long key;
+		unsigned int vertexCount;
+		unsigned int indexCount;
+		unsigned int lodCount;
+		unsigned int meshletCount;
+		float boundsMin[3];
+		float boundsMax[3];
+	};
+
+	// one corner of an OBJ face, as indices into the positions,
+	// texture coordinates and normals, or -1 when left out
+	struct OBJ_CORNER
+	{
+		int position;
+		int textureCoordinate;
+		int normal;
+	};
+
+	// a run of whole lines of an OBJ file and what was read from it
+	struct OBJ_CHUNK
+	{
+		const char* begin;
+		const char* end;
+		std::vector<glm::vec3> positions;
+		std::vector<glm::vec3> normals;
+		std::vector<glm::vec2> textureCoordinates;
+		// three corners for each triangle
+		std::vector<OBJ_CORNER> corners;
+	};
+
+	// a span of glTF buffer data
+	struct BUFFER_SPAN
+	{
+		const unsigned char* data;
+		size_t size;
+	};
+
+	// where the elements of a glTF accessor are in its buffer
+	struct ACCESSOR_VIEW
+	{
+		const unsigned char* data;
+		size_t count;
+		size_t stride;
+		int componentType;
+		int componentCount;
+		bool bNormalized;
+	};
+
+	/***********************************************************
+	 *  HashBytes()
+	 *
+	 *  This function is used to add a block of memory into a
+	 *  running FNV-1a hash.
+	 ***********************************************************/
+	unsigned long long HashBytes(unsigned long long hash, const void* data, size_t size)
+	{
+		const unsigned char* bytes = (const unsigned char*)data;
+		for (size_t i = 0; i < size; i++)
+		{
+			hash ^= bytes[i];
+			hash *= HASH_PRIME;
+		}
+		return(hash);
+	}
+
+	/***********************************************************
+	 *  SkipSpaces()
+	 *
+	 *  This function is used to move past spaces and tabs.
+	 ***********************************************************/
+	inline void SkipSpaces(const char*& p, const char* end)
+	{
+		while ((p < end) && ((*p == ' ') || (*p == '\t')))
+		{
+			p++;
+		}
+	}
+
+	/***********************************************************
+	 *  ParseInt()
+	 *
+	 *  This function is used to read a signed integer, which
+	 *  is zero when there are no digits.
+	 ***********************************************************/
+	inline int ParseInt(const char*& p, const char* end)
+	{
+		bool bNegative = false;
+		if ((p < end) && ((*p == '-') || (*p == '+')))
+		{
+			bNegative = (*p == '-');
+			p++;
+		}
+		int value = 0;
+		while ((p < end) && (*p >= '0') && (*p <= '9'))
+		{
+			value = value * 10 + (*p - '0');
+			p++;
+		}
+		return(bNegative ? -value : value);
+	}
+
+	/***********************************************************
+	 *  ParseFloat()
+	 *
+	 *  This function is used to read a decimal number.  It is
+	 *  much faster than strtof, which also depends on the
+	 *  locale, and is exact enough for vertex data.
+	 ***********************************************************/
+	inline float ParseFloat(const char*& p, const char* end)
+	{
+		SkipSpaces(p, end);
+
+		bool bNegative = false;
+		if ((p < end) && ((*p == '-') || (*p == '+')))
+		{
+			bNegative = (*p == '-');
+			p++;
+		}
+
+		double value = 0.0;
+		while ((p < end) && (*p >= '0') && (*p <= '9'))
+		{
+			value = value * 10.0 + (*p - '0');
+			p++;
+		}
+		if ((p < end) && (*p == '.'))
+		{
+			p++;
+			double scale = 0.1;
+			while ((p < end) && (*p >= '0') && (*p <= '9'))
+			{
+				value += (*p - '0') * scale;
+				scale *= 0.1;
+				p++;
+			}
+		}
+		if ((p < end) && ((*p == 'e') || (*p == 'E')))
+		{
+			p++;
+			int exponent = ParseInt(p, end);
+			value *= std::pow(10.0, exponent);
+		}
+
+		return((float)(bNegative ? -value : value));
+	}
+
+	/***********************************************************
+	 *  ResolveIndex()
+	 *
+	 *  This function is used to turn a one based OBJ index
+	 *  into a zero based one.  Negative indices count back
+	 *  from the elements read so far, and are marked to be
+	 *  moved by the chunk's offset later.
+	 ***********************************************************/
+	inline int ResolveIndex(int index, size_t localCount)
+	{
+		if (index > 0)
+		{
+			return(index - 1);
+		}
+		if (index < 0)
+		{
+			return(RELATIVE_INDEX + (int)localCount + index);
+		}
+		return(-1);
+	}
+
+	/***********************************************************
+	 *  ParseCorner()
+	 *
+	 *  This function is used to read one v, v/vt, v//vn or
+	 *  v/vt/vn corner of an OBJ face.
+	 ***********************************************************/
+	bool ParseCorner(const char*& p, const char* end, const OBJ_CHUNK& chunk, OBJ_CORNER& corner)
+	{
+		SkipSpaces(p, end);
+		if ((p >= end) || (*p == '\n') || (*p == '\r') || (*p == '#'))
+		{
+			return(false);
+		}
+
+		corner.position = ResolveIndex(ParseInt(p, end), chunk.positions.size());
+		corner.textureCoordinate = -1;
+		corner.normal = -1;
+		if ((p < end) && (*p == '/'))
+		{
+			p++;
+			if ((p < end) && (*p != '/'))
+			{
+				corner.textureCoordinate = ResolveIndex(ParseInt(p, end), chunk.textureCoordinates.size());
+			}
+			if ((p < end) && (*p == '/'))
+			{
+				p++;
+				corner.normal = ResolveIndex(ParseInt(p, end), chunk.normals.size());
+			}
+		}
+
+		// skip anything else up to the next corner
+		while ((p < end) && (*p != ' ') && (*p != '\t') && (*p != '\n') && (*p != '\r'))
+		{
+			p++;
+		}
+		return(true);
+	}
+
+	/***********************************************************
+	 *  ParseOBJChunk()
+	 *
+	 *  This function is used to read the vertex and face lines
+	 *  of a run of an OBJ file.  Faces with more than three
+	 *  corners are split into a fan of triangles.  Materials,
+	 *  groups and smoothing groups are ignored.
+	 ***********************************************************/
+	void ParseOBJChunk(OBJ_CHUNK* pChunk)
+	{
+		OBJ_CHUNK& chunk = *pChunk;
+		const char* p = chunk.begin;
+		const char* end = chunk.end;
+
+		// a rough guess at the counts, from typical line lengths
+		size_t estimatedLines = (size_t)(end - p) / 32;
+		chunk.positions.reserve(estimatedLines / 3);
+		chunk.corners.reserve(estimatedLines * 2);
+
+		while (p < end)
+		{
+			SkipSpaces(p, end);
+			if ((p + 1 < end) && (p[0] == 'v'))
+			{
+				if ((p[1] == ' ') || (p[1] == '\t'))
+				{
+					p++;
+					glm::vec3 position;
+					position.x = ParseFloat(p, end);
+					position.y = ParseFloat(p, end);
+					position.z = ParseFloat(p, end);
+					chunk.positions.push_back(position);
+				}
+				else if (p[1] == 'n')
+				{
+					p += 2;
+					glm::vec3 normal;
+					normal.x = ParseFloat(p, end);
+					normal.y = ParseFloat(p, end);
+					normal.z = ParseFloat(p, end);
+					chunk.normals.push_back(normal);
+				}
+				else if (p[1] == 't')
+				{
+					p += 2;
+					glm::vec2 textureCoordinate;
+					textureCoordinate.x = ParseFloat(p, end);
+					textureCoordinate.y = ParseFloat(p, end);
+					chunk.textureCoordinates.push_back(textureCoordinate);
+				}
+			}
+			else if ((p + 1 < end) && (p[0] == 'f') && ((p[1] == ' ') || (p[1] == '\t')))
+			{
+				p++;
+				OBJ_CORNER first;
+				OBJ_CORNER previous;
+				OBJ_CORNER corner;
+				int cornerCount = 0;
+				while (ParseCorner(p, end, chunk, corner) == true)
+				{
+					if (cornerCount == 0)
+					{
+						first = corner;
+					}
+					else if (cornerCount >= 2)
+					{
+						chunk.corners.push_back(first);
+						chunk.corners.push_back(previous);
+						chunk.corners.push_back(corner);
+					}
+					previous = corner;
+					cornerCount++;
+				}
+			}
+
+			// move on to the next line
+			const char* lineEnd = (const char*)memchr(p, '\n', (size_t)(end - p));
+			p = (lineEnd != NULL) ? lineEnd + 1 : end;
+		}
+	}
+
+	/***********************************************************
+	 *  OffsetIndex()
+	 *
+	 *  This function is used to turn an OBJ index into an
+	 *  index into the elements of the whole file, returning -1
+	 *  for an index that is out of range.
+	 ***********************************************************/
+	inline int OffsetIndex(int index, size_t chunkOffset, size_t totalCount)
+	{
+		if (index < 0)
+		{
+			return(-1);
+		}
+		if (index >= RELATIVE_INDEX - RELATIVE_LIMIT)
+		{
+			index = index - RELATIVE_INDEX + (int)chunkOffset;
+		}
+		return(((index >= 0) && (index < (int)totalCount)) ? index : -1);
+	}
+
+	/***********************************************************
+	 *  DecodeBase64()
+	 *
+	 *  This function is used to decode the data of a buffer
+	 *  embedded in a data URI.
+	 ***********************************************************/
+	void DecodeBase64(const std::string& text, std::vector<unsigned char>& data)
+	{
+		unsigned int bits = 0;
+		int bitCount = 0;
+		for (size_t i = 0; i < text.size(); i++)
+		{
+			char c = text[i];
+			int value = -1;
+			if ((c >= 'A') && (c <= 'Z')) value = c - 'A';
+			else if ((c >= 'a') && (c <= 'z')) value = c - 'a' + 26;
+			else if ((c >= '0') && (c <= '9')) value = c - '0' + 52;
+			else if (c == '+') value = 62;
+			else if (c == '/') value = 63;
+			if (value < 0)
+			{
+				continue;
+			}
+			bits = (bits << 6) | (unsigned int)value;
+			bitCount += 6;
+			if (bitCount >= 8)
+			{
+				bitCount -= 8;
+				data.push_back((unsigned char)((bits >> bitCount) & 0xFF));
+			}
+		}
+	}
+
+	/***********************************************************
+	 *  GetAccessor()
+	 *
+	 *  This function is used to find the data of a glTF
+	 *  accessor, checking that all of its elements are inside
+	 *  the buffer.
+	 ***********************************************************/
+	bool GetAccessor(
+		const JSON_VALUE& document,
+		int accessorIndex,
+		const std::vector<BUFFER_SPAN>& buffers,
+		ACCESSOR_VIEW& view)
+	{
+		const JSON_VALUE* pAccessor = JsonReader::GetElement(document, "accessors", accessorIndex);
+		if (pAccessor == NULL)
+		{
+			return(false);
+		}
+		const JSON_VALUE* pBufferView = JsonReader::GetElement(document, "bufferViews", (int)JsonReader::GetNumber(*pAccessor, "bufferView", -1));
+		if (pBufferView == NULL)
+		{
+			return(false);
+		}
+		int bufferIndex = (int)JsonReader::GetNumber(*pBufferView, "buffer", -1);
+		if ((bufferIndex < 0) || (bufferIndex >= (int)buffers.size()) || (buffers[bufferIndex].data == NULL))
+		{
+			return(false);
+		}
+
+		const JSON_VALUE* pType = JsonReader::FindMember(*pAccessor, "type");
+		view.componentCount = 1;
+		if (pType != NULL)
+		{
+			if (pType->text == "VEC2") view.componentCount = 2;
+			else if (pType->text == "VEC3") view.componentCount = 3;
+			else if (pType->text == "VEC4") view.componentCount = 4;
+		}
+		view.componentType = (int)JsonReader::GetNumber(*pAccessor, "componentType", 0);
+		size_t componentSize = 0;
+		switch (view.componentType)
+		{
+		case GLTF_UNSIGNED_BYTE: componentSize = 1; break;
+		case GLTF_UNSIGNED_SHORT: componentSize = 2; break;
+		case GLTF_UNSIGNED_INT:
+		case GLTF_FLOAT: componentSize = 4; break;
+		default: return(false);
+		}
+		const JSON_VALUE* pNormalized = JsonReader::FindMember(*pAccessor, "normalized");
+		view.bNormalized = (pNormalized != NULL) && (pNormalized->number != 0.0);
+
+		size_t elementSize = componentSize * view.componentCount;
+		size_t viewOffset = (size_t)JsonReader::GetNumber(*pBufferView, "byteOffset", 0);
+		size_t viewLength = (size_t)JsonReader::GetNumber(*pBufferView, "byteLength", 0);
+		size_t accessorOffset = (size_t)JsonReader::GetNumber(*pAccessor, "byteOffset", 0);
+		view.count = (size_t)JsonReader::GetNumber(*pAccessor, "count", 0);
+		view.stride = (size_t)JsonReader::GetNumber(*pBufferView, "byteStride", 0);
+		if (view.stride == 0)
+		{
+			view.stride = elementSize;
+		}
+
+		if ((view.count == 0) ||
+			(viewOffset + viewLength > buffers[bufferIndex].size) ||
+			(accessorOffset + view.stride * (view.count - 1) + elementSize > viewLength))
+		{
+			return(false);
+		}
+		view.data = buffers[bufferIndex].data + viewOffset + accessorOffset;
+		return(true);
+	}
+
+	/***********************************************************
+	 *  ReadComponents()
+	 *
+	 *  This function is used to read up to four float values
+	 *  of an accessor element, straight from the buffer.
+	 ***********************************************************/
+	void ReadComponents(const ACCESSOR_VIEW& view, size_t index, float* values, int count)
+	{
+		const unsigned char* element = view.data + index * view.stride;
+		for (int c = 0; c < count; c++)
+		{
+			values[c] = 0.0f;
+			if (c >= view.componentCount)
+			{
+				continue;
+			}
+			switch (view.componentType)
+			{
+			case GLTF_FLOAT:
+				memcpy(&values[c], element + c * 4, 4);
+				break;
+			case GLTF_UNSIGNED_BYTE:
+				values[c] = element[c] / (view.bNormalized ? 255.0f : 1.0f);
+				break;
+			case GLTF_UNSIGNED_SHORT:
+			{
+				unsigned short value;
+				memcpy(&value, element + c * 2, 2);
+				values[c] = value / (view.bNormalized ? 65535.0f : 1.0f);
+				break;
+			}
+			default:
+				break;
+			}
+		}
+	}
+
+	/***********************************************************
+	 *  ReadIndex()
+	 *
+	 *  This function is used to read one element of an index
+	 *  accessor.
+	 ***********************************************************/
+	unsigned int ReadIndex(const ACCESSOR_VIEW& view, size_t index)
+	{
+		const unsigned char* element = view.data + index * view.stride;
+		switch (view.componentType)
+		{
+		case GLTF_UNSIGNED_BYTE:
+			return(element[0]);
+		case GLTF_UNSIGNED_SHORT:
+		{
+			unsigned short value;
+			memcpy(&value, element, 2);
+			return(value);
+		}
+		case GLTF_UNSIGNED_INT:
+		{
+			unsigned int value;
+			memcpy(&value, element, 4);
+			return(value);
+		}
+		default:
+			return(0);
+		}
+	}
+
+	/***********************************************************
+	 *  GetNodeMatrix()
+	 *
+	 *  This function is used to get the local transform of a
+	 *  glTF node, from its matrix or from its translation,
+	 *  rotation quaternion and scale.
+	 ***********************************************************/
+	glm::mat4 GetNodeMatrix(const JSON_VALUE& node)
+	{
+		glm::mat4 matrix(1.0f);
+
+		const JSON_VALUE* pMatrix = JsonReader::FindMember(node, "matrix");
+		if ((pMatrix != NULL) && (pMatrix->items.size() == 16))
+		{
+			for (int i = 0; i < 16; i++)
+			{
+				matrix[i / 4][i % 4] = (float)pMatrix->items[i].number;
+			}
+			return(matrix);
+		}
+
+		glm::vec3 translation(0.0f);
+		glm::vec4 rotation(0.0f, 0.0f, 0.0f, 1.0f);
+		glm::vec3 scale(1.0f);
+		const JSON_VALUE* pValue = JsonReader::FindMember(node, "translation");
+		if ((pValue != NULL) && (pValue->items.size() == 3))
+		{
+			for (int i = 0; i < 3; i++)
+			{
+				translation[i] = (float)pValue->items[i].number;
+			}
+		}
+		pValue = JsonReader::FindMember(node, "rotation");
+		if ((pValue != NULL) && (pValue->items.size() == 4))
+		{
+			for (int i = 0; i < 4; i++)
+			{
+				rotation[i] = (float)pValue->items[i].number;
+			}
+		}
+		pValue = JsonReader::FindMember(node, "scale");
+		if ((pValue != NULL) && (pValue->items.size() == 3))
+		{
+			for (int i = 0; i < 3; i++)
+			{
+				scale[i] = (float)pValue->items[i].number;
+			}
+		}
+
+		// rotation matrix of the unit quaternion x, y, z, w
+		float x = rotation.x;
+		float y = rotation.y;
+		float z = rotation.z;
+		float w = rotation.w;
+		matrix[0] = glm::vec4(1.0f - 2.0f * (y * y + z * z), 2.0f * (x * y + z * w), 2.0f * (x * z - y * w), 0.0f) * scale.x;
+		matrix[1] = glm::vec4(2.0f * (x * y - z * w), 1.0f - 2.0f * (x * x + z * z), 2.0f * (y * z + x * w), 0.0f) * scale.y;
+		matrix[2] = glm::vec4(2.0f * (x * z + y * w), 2.0f * (y * z - x * w), 1.0f - 2.0f * (x * x + y * y), 0.0f) * scale.z;
+		matrix[3] = glm::vec4(translation, 1.0f);
+		return(matrix);
+	}
+
+	/***********************************************************
+	 *  AppendGLTFMesh()
+	 *
+	 *  This function is used to add the triangle primitives of
+	 *  a glTF mesh to the imported mesh, moved by the node's
+	 *  transform.  Returns false when a primitive had no
+	 *  normals, so they need to be computed.
+	 ***********************************************************/
+	bool AppendGLTFMesh(
+		const JSON_VALUE& document,
+		int meshIndex,
+		const glm::mat4& transform,
+		const std::vector<BUFFER_SPAN>& buffers,
+		MeshImporter::MESH_DATA& mesh)
+	{
+		bool bHasNormals = true;
+		const JSON_VALUE* pMesh = JsonReader::GetElement(document, "meshes", meshIndex);
+		const JSON_VALUE* pPrimitives = (pMesh != NULL) ? JsonReader::FindMember(*pMesh, "primitives") : NULL;
+		if (pPrimitives == NULL)
+		{
+			return(bHasNormals);
+		}
+
+		glm::mat3 normalMatrix = glm::transpose(glm::inverse(glm::mat3(transform)));
+		for (size_t p = 0; p < pPrimitives->items.size(); p++)
+		{
+			const JSON_VALUE& primitive = pPrimitives->items[p];
+			const JSON_VALUE* pAttributes = JsonReader::FindMember(primitive, "attributes");
+			if ((pAttributes == NULL) ||
+				((int)JsonReader::GetNumber(primitive, "mode", GLTF_TRIANGLES) != GLTF_TRIANGLES))
+			{
+				continue;
+			}
+
+			ACCESSOR_VIEW positions;
+			ACCESSOR_VIEW normals;
+			ACCESSOR_VIEW textureCoordinates;
+			if (GetAccessor(document, (int)JsonReader::GetNumber(*pAttributes, "POSITION", -1), buffers, positions) == false)
+			{
+				continue;
+			}
+			bool bNormals = GetAccessor(document, (int)JsonReader::GetNumber(*pAttributes, "NORMAL", -1), buffers, normals) &&
+				(normals.count == positions.count);
+			bool bTextureCoordinates = GetAccessor(document, (int)JsonReader::GetNumber(*pAttributes, "TEXCOORD_0", -1), buffers, textureCoordinates) &&
+				(textureCoordinates.count == positions.count);
+			if (bNormals == false)
+			{
+				bHasNormals = false;
+			}
+
+			size_t baseVertex = mesh.vertices.size();
+			mesh.vertices.resize(baseVertex + positions.count);
+			for (size_t i = 0; i < positions.count; i++)
+			{
+				MeshImporter::MESH_VERTEX& vertex = mesh.vertices[baseVertex + i];
+				float values[4];
+				ReadComponents(positions, i, values, 3);
+				vertex.position = glm::vec3(transform * glm::vec4(values[0], values[1], values[2], 1.0f));
+				vertex.normal = glm::vec3(0.0f);
+				if (bNormals == true)
+				{
+					ReadComponents(normals, i, values, 3);
+					vertex.normal = glm::normalize(normalMatrix * glm::vec3(values[0], values[1], values[2]));
+				}
+				vertex.textureCoordinate = glm::vec2(0.0f);
+				if (bTextureCoordinates == true)
+				{
+					// glTF puts the texture origin at the top left
+					ReadComponents(textureCoordinates, i, values, 2);
+					vertex.textureCoordinate = glm::vec2(values[0], 1.0f - values[1]);
+				}
+			}
+
+			ACCESSOR_VIEW indices;
+			if (GetAccessor(document, (int)JsonReader::GetNumber(primitive, "indices", -1), buffers, indices) == true)
+			{
+				size_t triangleIndexCount = indices.count - indices.count % 3;
+				for (size_t i = 0; i < triangleIndexCount; i++)
+				{
+					unsigned int index = ReadIndex(indices, i);
+					mesh.indices.push_back((unsigned int)baseVertex + std::min(index, (unsigned int)positions.count - 1));
+				}
+			}
+			else
+			{
+				for (size_t i = 0; i + 2 < positions.count; i += 3)
+				{
+					mesh.indices.push_back((unsigned int)(baseVertex + i));
+					mesh.indices.push_back((unsigned int)(baseVertex + i + 1));
+					mesh.indices.push_back((unsigned int)(baseVertex + i + 2));
+				}
+			}
+		}
+
+		return(bHasNormals);
+	}
+
+	/***********************************************************
+	 *  AppendGLTFNode()
+	 *
+	 *  This function is used to add the meshes of a glTF node
+	 *  and of all of its children.
+	 ***********************************************************/
+	bool AppendGLTFNode(
+		const JSON_VALUE& document,
+		int nodeIndex,
+		const glm::mat4& parentTransform,
+		const std::vector<BUFFER_SPAN>& buffers,
+		MeshImporter::MESH_DATA& mesh,
+		int depth)
+	{
+		const JSON_VALUE* pNode = JsonReader::GetElement(document, "nodes", nodeIndex);
+		if ((pNode == NULL) || (depth > MAX_NODE_DEPTH))
+		{
+			return(true);
+		}
+
+		bool bHasNormals = true;
+		glm::mat4 transform = parentTransform * GetNodeMatrix(*pNode);
+		int meshIndex = (int)JsonReader::GetNumber(*pNode, "mesh", -1);
+		if (meshIndex >= 0)
+		{
+			bHasNormals = AppendGLTFMesh(document, meshIndex, transform, buffers, mesh);
+		}
+
+		const JSON_VALUE* pChildren = JsonReader::FindMember(*pNode, "children");
+		if (pChildren != NULL)
+		{
+			for (size_t i = 0; i < pChildren->items.size(); i++)
+			{
+				if (AppendGLTFNode(document, (int)pChildren->items[i].number, transform, buffers, mesh, depth + 1) == false)
+				{
+					bHasNormals = false;
+				}
+			}
+		}
+		return(bHasNormals);
+	}
+
+	/***********************************************************
+	 *  CheckCacheFile()
+	 *
+	 *  This function is used to check that a mapped cooked mesh
+	 *  was written for the passed in cache key by this version,
+	 *  has the size its header gives, and has detail levels
+	 *  within its indices and meshlets.
+	 ***********************************************************/
+	bool CheckCacheFile(const MappedFile& file, unsigned long long key, CACHE_FILE_HEADER& header)
+	{
+		if (file.GetSize() < sizeof(header))
+		{
+			return(false);
+		}
+		memcpy(&header, file.GetData(), sizeof(header));
+		size_t lodBytes = (size_t)header.lodCount * sizeof(MeshImporter::MESH_LOD);
+		size_t meshletBytes = (size_t)header.meshletCount * sizeof(MeshImporter::MESHLET);
+		size_t vertexBytes = (size_t)header.vertexCount * sizeof(MeshImporter::MESH_VERTEX);
+		size_t indexBytes = (size_t)header.indexCount * sizeof(unsigned int);
+		if ((header.magic != CACHE_FILE_MAGIC) ||
+			(header.version != CACHE_FILE_VERSION) ||
+			(header.key != key) ||
+			(file.GetSize() != sizeof(header) + lodBytes + meshletBytes + vertexBytes + indexBytes))
+		{
+			return(false);
+		}
+
+		const unsigned char* lods = file.GetData() + sizeof(header);
+		for (unsigned int i = 0; i < header.lodCount; i++)
+		{
+			MeshImporter::MESH_LOD lod;
+			memcpy(&lod, lods + i * sizeof(lod), sizeof(lod));
+			if (((unsigned long long)lod.indexOffset + lod.indexCount > header.indexCount) ||
+				((unsigned long long)lod.meshletOffset + lod.meshletCount > header.meshletCount))
+			{
+				return(false);
+			}
+		}
+		return(true);
+	}
+}
+
+/***********************************************************
+ *  MeshImporter()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+MeshImporter::MeshImporter()
+{
+	m_commandBuffer = 0;
+}
+
+/***********************************************************
+ *  ~MeshImporter()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+MeshImporter::~MeshImporter()
+{
+	if (m_commandBuffer != 0)
+	{
+		glDeleteBuffers(1, &m_commandBuffer);
+		m_commandBuffer = 0;
+	}
+}
+
+/***********************************************************
+ *  SetCacheDirectory()
+ *
+ *  This method is used for setting the directory that the
+ *  cooked meshes are stored in, creating it when needed.
+ ***********************************************************/
+void MeshImporter::SetCacheDirectory(const char* directory)
+{
+	m_cacheDirectory = directory;
+#ifdef _WIN32
+	_mkdir(directory);
+#else
+	mkdir(directory, 0755);
+#endif
+}
+
+/***********************************************************
+ *  LoadMesh()
+ *
+ *  This method is used for loading a model file into OpenGL
+ *  buffers.  The cooked copy is used when the model file has
+ *  the same size and modification time as when it was
+ *  cooked, otherwise the file is imported and cooked again.
+ ***********************************************************/
+bool MeshImporter::LoadMesh(const char* filePath, GPU_MESH& mesh)
+{
+	MappedFile file;
+	if (file.Open(filePath) == false)
+	{
+		return(false);
+	}
+
+	unsigned long long key = MakeKey(filePath, file);
+	if ((m_cacheDirectory.empty() == false) && (LoadCachedMesh(key, mesh) == true))
+	{
+		return(true);
+	}
+
+	MESH_DATA meshData;
+	if (ConvertMesh(filePath, file, key, meshData) == false)
+	{
+		return(false);
+	}
+	UploadMeshData(meshData, mesh);
+	return(true);
+}
+
+/***********************************************************
+ *  ReadMesh()
+ *
+ *  This method is used for loading a model file into system
+ *  memory, from the cooked copy when the model file has not
+ *  changed, or by importing and cooking it again.  It makes
+ *  no OpenGL calls, so it can run on a worker thread, and
+ *  the mesh is handed to OpenGL with UploadMeshData().
+ ***********************************************************/
+bool MeshImporter::ReadMesh(const char* filePath, MESH_DATA& mesh) const
+{
+	MappedFile file;
+	if (file.Open(filePath) == false)
+	{
+		return(false);
+	}
+
+	unsigned long long key = MakeKey(filePath, file);
+	if ((m_cacheDirectory.empty() == false) && (ReadCachedMesh(key, mesh) == true))
+	{
+		return(true);
+	}
+	return(ConvertMesh(filePath, file, key, mesh));
+}
+
+/***********************************************************
+ *  ConvertMesh()
+ *
+ *  This method is used for importing a mapped model file,
+ *  building its detail levels and their meshlets, and
+ *  writing the result to the cache.
+ ***********************************************************/
+bool MeshImporter::ConvertMesh(const char* filePath, const MappedFile& file, unsigned long long key, MESH_DATA& mesh) const
+{
+	std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+	if (ImportMappedMesh(filePath, file, mesh, 0) == false)
+	{
+		return(false);
+	}
+	double importTime = std::chrono::duration<double, std::milli>(
+		std::chrono::steady_clock::now() - startTime).count();
+	std::cout << "INFO: Imported " << filePath << ", " << mesh.indices.size() / 3
+		<< " triangles in " << importTime << " ms" << std::endl;
+
+	// the detail levels and their meshlets are cooked along with
+	// the mesh, so they are only built when the model file changes
+	MeshSimplifier::BuildLODChain(mesh, 0);
+	MeshletBuilder::BuildMeshlets(mesh);
+
+	if (m_cacheDirectory.empty() == false)
+	{
+		StoreCachedMesh(key, mesh);
+	}
+	return(true);
+}
+
+/***********************************************************
+ *  UploadMeshData()
+ *
+ *  This method is used for creating the OpenGL buffers of
+ *  a mesh read by ReadMesh(), along with its detail levels,
+ *  meshlets and bounds.
+ ***********************************************************/
+void MeshImporter::UploadMeshData(const MESH_DATA& meshData, GPU_MESH& mesh)
+{
+	UploadMesh(
+		meshData.vertices.empty() ? NULL : &meshData.vertices[0], meshData.vertices.size(),
+		meshData.indices.empty() ? NULL : &meshData.indices[0], meshData.indices.size(),
+		mesh);
+	mesh.lods = meshData.lods;
+	mesh.meshlets = meshData.meshlets;
+	mesh.boundsMin = meshData.boundsMin;
+	mesh.boundsMax = meshData.boundsMax;
+}
+
+/***********************************************************
+ *  DrawMesh()
+ *
+ *  This method is used for drawing the triangles of one
+ *  detail level of a mesh with the current shader program.
+ *  Every level indexes the same vertices, so only the range
+ *  of the index buffer that is drawn changes.
+ ***********************************************************/
+void MeshImporter::DrawMesh(const GPU_MESH& mesh, int level)
+{
+	if (mesh.vertexArray == 0)
+	{
+		return;
+	}
+
+	GLsizei indexCount = mesh.indexCount;
+	size_t indexOffset = 0;
+	if ((level >= 0) && (level < (int)mesh.lods.size()))
+	{
+		indexCount = (GLsizei)mesh.lods[level].indexCount;
+		indexOffset = mesh.lods[level].indexOffset;
+	}
+
+	glBindVertexArray(mesh.vertexArray);
+	glDrawElements(GL_TRIANGLES, indexCount, GL_UNSIGNED_INT,
+		(void*)(indexOffset * sizeof(unsigned int)));
+	glBindVertexArray(0);
+}
+
+/***********************************************************
+ *  DrawMeshClusters()
+ *
+ *  This method is used for drawing only the meshlets of a
+ *  detail level that can be seen.  Levels with few meshlets
+ *  are drawn whole, since culling them saves too little.
+ *  The remaining meshlets become draw commands in an
+ *  indirect buffer, or counts and offsets for
+ *  glMultiDrawElements() when indirect drawing is missing.
+ *  Back faces are culled while the meshlets are drawn, so
+ *  triangles of a visible meshlet look the same as those
+ *  of a meshlet culled by its normal cone.
+ ***********************************************************/
+void MeshImporter::DrawMeshClusters(
+	const GPU_MESH& mesh,
+	int level,
+	const glm::mat4* modelViewProjections,
+	int viewCount,
+	const glm::vec3& viewPosition,
+	bool bCullBackfaces)
+{
+	if ((mesh.vertexArray == 0) || (level < 0) || (level >= (int)mesh.lods.size()) ||
+		(mesh.lods[level].meshletCount < MIN_CULLED_MESHLETS))
+	{
+		DrawMesh(mesh, level);
+		return;
+	}
+
+	const MESH_LOD& lod = mesh.lods[level];
+	m_drawCommands.clear();
+	MeshletBuilder::CullMeshlets(&mesh.meshlets[lod.meshletOffset], lod.meshletCount,
+		modelViewProjections, viewCount, viewPosition, bCullBackfaces, m_drawCommands);
+	if (m_drawCommands.empty() == true)
+	{
+		return;
+	}
+
+	if (bCullBackfaces == true)
+	{
+		glEnable(GL_CULL_FACE);
+	}
+	glBindVertexArray(mesh.vertexArray);
+	if (GLEW_VERSION_4_3 || GLEW_ARB_multi_draw_indirect)
+	{
+		if (m_commandBuffer == 0)
+		{
+			glGenBuffers(1, &m_commandBuffer);
+		}
+		glBindBuffer(GL_DRAW_INDIRECT_BUFFER, m_commandBuffer);
+		glBufferData(GL_DRAW_INDIRECT_BUFFER, m_drawCommands.size() * sizeof(DRAW_COMMAND),
+			&m_drawCommands[0], GL_STREAM_DRAW);
+		glMultiDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT, (void*)0,
+			(GLsizei)m_drawCommands.size(), 0);
+		glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+	}
+	else
+	{
+		m_drawCounts.resize(m_drawCommands.size());
+		m_drawOffsets.resize(m_drawCommands.size());
+		for (size_t i = 0; i < m_drawCommands.size(); i++)
+		{
+			m_drawCounts[i] = (GLsizei)m_drawCommands[i].count;
+			m_drawOffsets[i] = (const void*)((size_t)m_drawCommands[i].firstIndex * sizeof(unsigned int));
+		}
+		glMultiDrawElements(GL_TRIANGLES, &m_drawCounts[0], GL_UNSIGNED_INT,
+			&m_drawOffsets[0], (GLsizei)m_drawCommands.size());
+	}
+	glBindVertexArray(0);
+	if (bCullBackfaces == true)
+	{
+		glDisable(GL_CULL_FACE);
+	}
+}
+
+/***********************************************************
+ *  SelectLOD()
+ *
+ *  This method is used for picking the detail level of a
+ *  mesh to draw.  The error of each level is how far its
+ *  surface may be from the full mesh, so the coarsest level
+ *  whose error covers no more than the allowed number of
+ *  pixels looks the same as the full mesh.
+ ***********************************************************/
+int MeshImporter::SelectLOD(const GPU_MESH& mesh, float pixelsPerUnit, float maxPixelError)
+{
+	int level = 0;
+	for (int i = 1; i < (int)mesh.lods.size(); i++)
+	{
+		if (mesh.lods[i].error * pixelsPerUnit > maxPixelError)
+		{
+			break;
+		}
+		level = i;
+	}
+	return(level);
+}
+
+/***********************************************************
+ *  DestroyMesh()
+ *
+ *  This method is used for freeing the OpenGL buffers of a
+ *  mesh.
+ ***********************************************************/
+void MeshImporter::DestroyMesh(GPU_MESH& mesh)
+{
+	if (mesh.vertexArray != 0)
+	{
+		glDeleteVertexArrays(1, &mesh.vertexArray);
+		glDeleteBuffers(1, &mesh.vertexBuffer);
+		glDeleteBuffers(1, &mesh.indexBuffer);
+	}
+	mesh.vertexArray = 0;
+	mesh.vertexBuffer = 0;
+	mesh.indexBuffer = 0;
+	mesh.indexCount = 0;
+	mesh.lods.clear();
+	mesh.meshlets.clear();
+}
+
+/***********************************************************
+ *  ReadMeshTriangles()
+ *
+ *  This method is used for reading the positions and the
+ *  triangles of a mesh back from its OpenGL buffers, for
+ *  work on the CPU such as picking.
+ ***********************************************************/
+bool MeshImporter::ReadMeshTriangles(const GPU_MESH& mesh, std::vector<glm::vec3>& positions, std::vector<unsigned int>& indices)
+{
+	std::vector<MESH_VERTEX> vertices;
+	bool bRead = ReadMeshVertices(mesh, vertices, indices);
+	positions.resize(vertices.size());
+	for (size_t i = 0; i < vertices.size(); i++)
+	{
+		positions[i] = vertices[i].position;
+	}
+	return(bRead);
+}
+
+/***********************************************************
+ *  ReadMeshVertices()
+ *
+ *  This method is used for reading a mesh back from its
+ *  OpenGL buffers, for work on the CPU such as picking or
+ *  software rendering.  The cooked meshes go straight into
+ *  the buffers, so only the buffers hold them once they are
+ *  loaded.  The buffers are bound to the copy target, which
+ *  leaves the vertex array bindings as they are.
+ ***********************************************************/
+bool MeshImporter::ReadMeshVertices(const GPU_MESH& mesh, std::vector<MESH_VERTEX>& vertices, std::vector<unsigned int>& indices)
+{
+	if (mesh.vertexArray == 0)
+	{
+		return(false);
+	}
+
+	unsigned int indexOffset = 0;
+	unsigned int indexCount = (unsigned int)mesh.indexCount;
+	if (mesh.lods.empty() == false)
+	{
+		indexOffset = mesh.lods[0].indexOffset;
+		indexCount = mesh.lods[0].indexCount;
+	}
+
+	GLint vertexBytes = 0;
+	glBindBuffer(GL_COPY_READ_BUFFER, mesh.vertexBuffer);
+	glGetBufferParameteriv(GL_COPY_READ_BUFFER, GL_BUFFER_SIZE, &vertexBytes);
+	vertices.resize(vertexBytes / sizeof(MESH_VERTEX));
+	if (vertices.empty() == false)
+	{
+		glGetBufferSubData(GL_COPY_READ_BUFFER, 0, vertices.size() * sizeof(MESH_VERTEX), &vertices[0]);
+	}
+
+	indices.resize(indexCount);
+	glBindBuffer(GL_COPY_READ_BUFFER, mesh.indexBuffer);
+	if (indexCount > 0)
+	{
+		glGetBufferSubData(GL_COPY_READ_BUFFER, indexOffset * sizeof(unsigned int),
+			indexCount * sizeof(unsigned int), &indices[0]);
+	}
+	glBindBuffer(GL_COPY_READ_BUFFER, 0);
+
+	// indices past the vertices mean the buffers were not laid out
+	// as expected
+	for (size_t i = 0; i < indices.size(); i++)
+	{
+		if (indices[i] >= vertices.size())
+		{
+			indices.clear();
+			break;
+		}
+	}
+	return(indices.size() >= 3);
+}
+
+/***********************************************************
+ *  ImportMesh()
+ *
+ *  This method is used for importing a model file into
+ *  system memory without using the cache.
+ ***********************************************************/
+bool MeshImporter::ImportMesh(const char* filePath, MESH_DATA& mesh, int threadCount)
+{
+	MappedFile file;
+	if (file.Open(filePath) == false)
+	{
+		std::cout << "ERROR::MESH_FILE_NOT_FOUND: " << filePath << std::endl;
+		return(false);
+	}
+	return(ImportMappedMesh(filePath, file, mesh, threadCount));
+}
+
+/***********************************************************
+ *  ImportMappedMesh()
+ *
+ *  This method is used for choosing the parser for a model
+ *  file from its extension.
+ ***********************************************************/
+bool MeshImporter::ImportMappedMesh(const char* filePath, const MappedFile& file, MESH_DATA& mesh, int threadCount)
+{
+	std::string extension = filePath;
+	size_t dot = extension.find_last_of('.');
+	extension = (dot == std::string::npos) ? std::string() : extension.substr(dot + 1);
+	std::transform(extension.begin(), extension.end(), extension.begin(), ::tolower);
+
+	mesh.vertices.clear();
+	mesh.indices.clear();
+
+	bool bResult = false;
+	if (extension == "obj")
+	{
+		bResult = ParseOBJ(file, mesh, threadCount);
+	}
+	else if ((extension == "gltf") || (extension == "glb"))
+	{
+		bResult = ParseGLTF(filePath, file, mesh);
+	}
+	else
+	{
+		std::cout << "ERROR::MESH_FORMAT_NOT_SUPPORTED: " << filePath << std::endl;
+		return(false);
+	}
+
+	if ((bResult == false) || (mesh.indices.empty() == true))
+	{
+		std::cout << "ERROR::MESH_NOT_IMPORTED: " << filePath << std::endl;
+		return(false);
+	}
+
+	// the full mesh is the only detail level until a chain is built
+	MESH_LOD fullLevel;
+	fullLevel.indexOffset = 0;
+	fullLevel.indexCount = (unsigned int)mesh.indices.size();
+	fullLevel.error = 0.0f;
+	fullLevel.meshletOffset = 0;
+	fullLevel.meshletCount = 0;
+	mesh.lods.assign(1, fullLevel);
+	mesh.meshlets.clear();
+	return(true);
+}
+
+/***********************************************************
+ *  ParseOBJ()
+ *
+ *  This method is used for parsing an OBJ file in parallel.
+ *  The file is split into runs of whole lines, one for each
+ *  thread.  Once every run is read, the indices of each run
+ *  are moved by the number of elements in the runs before
+ *  it, and the corners are merged into shared vertices with
+ *  a chain of the vertices made from each position.
+ ***********************************************************/
+bool MeshImporter::ParseOBJ(const MappedFile& file, MESH_DATA& mesh, int threadCount)
+{
+	if (threadCount <= 0)
+	{
+		threadCount = std::max(1, (int)std::thread::hardware_concurrency());
+	}
+	const char* data = (const char*)file.GetData();
+	size_t size = file.GetSize();
+	size_t chunkCount = std::min((size_t)threadCount, std::max((size_t)1, size / MIN_OBJ_CHUNK_SIZE));
+
+	// split at line ends, so no line is shared by two runs
+	std::vector<OBJ_CHUNK> chunks(chunkCount);
+	const char* chunkStart = data;
+	for (size_t c = 0; c < chunkCount; c++)
+	{
+		const char* chunkEnd = data + size;
+		if (c + 1 < chunkCount)
+		{
+			chunkEnd = std::max(chunkStart, data + size * (c + 1) / chunkCount);
+			const char* lineEnd = (const char*)memchr(chunkEnd, '\n', (size_t)(data + size - chunkEnd));
+			chunkEnd = (lineEnd != NULL) ? lineEnd + 1 : data + size;
+		}
+		chunks[c].begin = chunkStart;
+		chunks[c].end = chunkEnd;
+		chunkStart = chunkEnd;
+	}
+
+	std::vector<std::thread> workers;
+	for (size_t c = 1; c < chunkCount; c++)
+	{
+		workers.push_back(std::thread(ParseOBJChunk, &chunks[c]));
+	}
+	ParseOBJChunk(&chunks[0]);
+	for (size_t t = 0; t < workers.size(); t++)
+	{
+		workers[t].join();
+	}
+
+	// join the elements of all of the runs
+	std::vector<glm::vec3> positions;
+	std::vector<glm::vec3> normals;
+	std::vector<glm::vec2> textureCoordinates;
+	std::vector<size_t> positionOffsets(chunkCount);
+	std::vector<size_t> normalOffsets(chunkCount);
+	std::vector<size_t> textureOffsets(chunkCount);
+	size_t cornerCount = 0;
+	for (size_t c = 0; c < chunkCount; c++)
+	{
+		positionOffsets[c] = positions.size();
+		normalOffsets[c] = normals.size();
+		textureOffsets[c] = textureCoordinates.size();
+		positions.insert(positions.end(), chunks[c].positions.begin(), chunks[c].positions.end());
+		normals.insert(normals.end(), chunks[c].normals.begin(), chunks[c].normals.end());
+		textureCoordinates.insert(textureCoordinates.end(), chunks[c].textureCoordinates.begin(), chunks[c].textureCoordinates.end());
+		cornerCount += chunks[c].corners.size();
+		std::vector<glm::vec3>().swap(chunks[c].positions);
+		std::vector<glm::vec3>().swap(chunks[c].normals);
+		std::vector<glm::vec2>().swap(chunks[c].textureCoordinates);
+	}
+
+	// each position starts a chain of the vertices made from it,
+	// which differ in their normal or texture coordinate
+	struct VERTEX_LINK
+	{
+		int textureCoordinate;
+		int normal;
+		int next;
+	};
+	std::vector<int> firstVertex(positions.size(), -1);
+	std::vector<VERTEX_LINK> links;
+	links.reserve(positions.size());
+	mesh.vertices.reserve(positions.size());
+	mesh.indices.reserve(cornerCount);
+
+	for (size_t c = 0; c < chunkCount; c++)
+	{
+		const std::vector<OBJ_CORNER>& corners = chunks[c].corners;
+		for (size_t i = 0; i + 2 < corners.size(); i += 3)
+		{
+			unsigned int triangle[3];
+			bool bValid = true;
+			for (int k = 0; (k < 3) && (bValid == true); k++)
+			{
+				int position = OffsetIndex(corners[i + k].position, positionOffsets[c], positions.size());
+				int textureCoordinate = OffsetIndex(corners[i + k].textureCoordinate, textureOffsets[c], textureCoordinates.size());
+				int normal = OffsetIndex(corners[i + k].normal, normalOffsets[c], normals.size());
+				if (position < 0)
+				{
+					bValid = false;
+					continue;
+				}
+
+				int vertex = firstVertex[position];
+				while ((vertex >= 0) &&
+					((links[vertex].textureCoordinate != textureCoordinate) || (links[vertex].normal != normal)))
+				{
+					vertex = links[vertex].next;
+				}
+				if (vertex < 0)
+				{
+					vertex = (int)mesh.vertices.size();
+					MESH_VERTEX newVertex;
+					newVertex.position = positions[position];
+					newVertex.normal = (normal >= 0) ? normals[normal] : glm::vec3(0.0f);
+					newVertex.textureCoordinate = (textureCoordinate >= 0) ?
+						textureCoordinates[textureCoordinate] : glm::vec2(0.0f);
+					mesh.vertices.push_back(newVertex);
+
+					VERTEX_LINK link;
+					link.textureCoordinate = textureCoordinate;
+					link.normal = normal;
+					link.next = firstVertex[position];
+					links.push_back(link);
+					firstVertex[position] = vertex;
+				}
+				triangle[k] = (unsigned int)vertex;
+			}
+			if (bValid == true)
+			{
+				mesh.indices.push_back(triangle[0]);
+				mesh.indices.push_back(triangle[1]);
+				mesh.indices.push_back(triangle[2]);
+			}
+		}
+	}
+
+	FinishMesh(mesh, normals.empty());
+	return(true);
+}
+
+/***********************************************************
+ *  ParseGLTF()
+ *
+ *  This method is used for reading the triangle meshes of a
+ *  glTF 2.0 file.  The JSON is read from the .gltf file or
+ *  from the first chunk of a .glb file.  Buffers are the
+ *  binary chunk of the .glb file, separate files that are
+ *  mapped beside it, or data URIs, and the vertex data is
+ *  read from them in place.  Every mesh in the default
+ *  scene is added with its node's transform applied.
+ ***********************************************************/
+bool MeshImporter::ParseGLTF(const char* filePath, const MappedFile& file, MESH_DATA& mesh)
+{
+	const unsigned char* data = file.GetData();
+	size_t size = file.GetSize();
+
+	// find the JSON and the binary chunk of a .glb file
+	const char* json = (const char*)data;
+	size_t jsonSize = size;
+	BUFFER_SPAN binaryChunk = { NULL, 0 };
+	unsigned int magic = 0;
+	if (size >= 12)
+	{
+		memcpy(&magic, data, 4);
+	}
+	if (magic == GLB_MAGIC)
+	{
+		size_t offset = 12;
+		json = NULL;
+		while (offset + 8 <= size)
+		{
+			unsigned int chunkLength = 0;
+			unsigned int chunkType = 0;
+			memcpy(&chunkLength, data + offset, 4);
+			memcpy(&chunkType, data + offset + 4, 4);
+			if (offset + 8 + chunkLength > size)
+			{
+				break;
+			}
+			if ((chunkType == GLB_CHUNK_JSON) && (json == NULL))
+			{
+				json = (const char*)(data + offset + 8);
+				jsonSize = chunkLength;
+			}
+			else if ((chunkType == GLB_CHUNK_BIN) && (binaryChunk.data == NULL))
+			{
+				binaryChunk.data = data + offset + 8;
+				binaryChunk.size = chunkLength;
+			}
+			offset += 8 + chunkLength;
+		}
+		if (json == NULL)
+		{
+			return(false);
+		}
+	}
+
+	JSON_VALUE document;
+	if ((JsonReader::Parse(json, jsonSize, document) == false) ||
+		(document.type != JSON_VALUE::JSON_OBJECT))
+	{
+		return(false);
+	}
+
+	// buffer files are found beside the glTF file
+	std::string directory = filePath;
+	size_t slash = directory.find_last_of("/\\");
+	directory = (slash == std::string::npos) ? std::string() : directory.substr(0, slash + 1);
+
+	std::vector<BUFFER_SPAN> buffers;
+	std::vector<std::unique_ptr<MappedFile> > bufferFiles;
+	std::vector<std::vector<unsigned char> > embeddedBuffers;
+	const JSON_VALUE* pBuffers = JsonReader::FindMember(document, "buffers");
+	if (pBuffers != NULL)
+	{
+		embeddedBuffers.reserve(pBuffers->items.size());
+		for (size_t i = 0; i < pBuffers->items.size(); i++)
+		{
+			BUFFER_SPAN span = { NULL, 0 };
+			const JSON_VALUE* pUri = JsonReader::FindMember(pBuffers->items[i], "uri");
+			if (pUri == NULL)
+			{
+				// the buffer without a URI is the .glb binary chunk
+				span = binaryChunk;
+			}
+			else if (pUri->text.compare(0, 5, "data:") == 0)
+			{
+				size_t comma = pUri->text.find(',');
+				embeddedBuffers.push_back(std::vector<unsigned char>());
+				if (comma != std::string::npos)
+				{
+					DecodeBase64(pUri->text.substr(comma + 1), embeddedBuffers.back());
+				}
+				if (embeddedBuffers.back().empty() == false)
+				{
+					span.data = &embeddedBuffers.back()[0];
+					span.size = embeddedBuffers.back().size();
+				}
+			}
+			else
+			{
+				std::unique_ptr<MappedFile> pBufferFile(new MappedFile());
+				if (pBufferFile->Open((directory + pUri->text).c_str()) == true)
+				{
+					span.data = pBufferFile->GetData();
+					span.size = pBufferFile->GetSize();
+					bufferFiles.push_back(std::move(pBufferFile));
+				}
+				else
+				{
+					std::cout << "ERROR::MESH_BUFFER_NOT_FOUND: " << directory + pUri->text << std::endl;
+				}
+			}
+			buffers.push_back(span);
+		}
+	}
+
+	// add the meshes of the default scene, or every mesh when
+	// the file has no scenes
+	bool bHasNormals = true;
+	const JSON_VALUE* pScene = JsonReader::GetElement(document, "scenes", (int)JsonReader::GetNumber(document, "scene", 0));
+	const JSON_VALUE* pSceneNodes = (pScene != NULL) ? JsonReader::FindMember(*pScene, "nodes") : NULL;
+	if (pSceneNodes != NULL)
+	{
+		for (size_t i = 0; i < pSceneNodes->items.size(); i++)
+		{
+			if (AppendGLTFNode(document, (int)pSceneNodes->items[i].number, glm::mat4(1.0f), buffers, mesh, 0) == false)
+			{
+				bHasNormals = false;
+			}
+		}
+	}
+	else
+	{
+		const JSON_VALUE* pMeshes = JsonReader::FindMember(document, "meshes");
+		int meshCount = (pMeshes != NULL) ? (int)pMeshes->items.size() : 0;
+		for (int i = 0; i < meshCount; i++)
+		{
+			if (AppendGLTFMesh(document, i, glm::mat4(1.0f), buffers, mesh) == false)
+			{
+				bHasNormals = false;
+			}
+		}
+	}
+
+	FinishMesh(mesh, bHasNormals == false);
+	return(true);
+}
+
+/***********************************************************
+ *  FinishMesh()
+ *
+ *  This method is used for computing the bounds of a mesh,
+ *  and smooth normals from the triangles, weighted by their
+ *  area, when the file did not have any.
+ ***********************************************************/
+void MeshImporter::FinishMesh(MESH_DATA& mesh, bool bComputeNormals)
+{
+	mesh.boundsMin = glm::vec3(0.0f);
+	mesh.boundsMax = glm::vec3(0.0f);
+	if (mesh.vertices.empty() == false)
+	{
+		mesh.boundsMin = mesh.vertices[0].position;
+		mesh.boundsMax = mesh.vertices[0].position;
+	}
+	for (size_t i = 1; i < mesh.vertices.size(); i++)
+	{
+		mesh.boundsMin = glm::min(mesh.boundsMin, mesh.vertices[i].position);
+		mesh.boundsMax = glm::max(mesh.boundsMax, mesh.vertices[i].position);
+	}
+
+	if (bComputeNormals == false)
+	{
+		return;
+	}
+
+	for (size_t i = 0; i < mesh.vertices.size(); i++)
+	{
+		mesh.vertices[i].normal = glm::vec3(0.0f);
+	}
+	for (size_t i = 0; i + 2 < mesh.indices.size(); i += 3)
+	{
+		MESH_VERTEX& a = mesh.vertices[mesh.indices[i]];
+		MESH_VERTEX& b = mesh.vertices[mesh.indices[i + 1]];
+		MESH_VERTEX& c = mesh.vertices[mesh.indices[i + 2]];
+		glm::vec3 faceNormal = glm::cross(b.position - a.position, c.position - a.position);
+		a.normal += faceNormal;
+		b.normal += faceNormal;
+		c.normal += faceNormal;
+	}
+	for (size_t i = 0; i < mesh.vertices.size(); i++)
+	{
+		float normalLength = glm::length(mesh.vertices[i].normal);
+		mesh.vertices[i].normal = (normalLength > 0.0f) ?
+			mesh.vertices[i].normal / normalLength : glm::vec3(0.0f, 1.0f, 0.0f);
+	}
+}
+
+/***********************************************************
+ *  MakeKey()
+ *
+ *  This method is used for building the cache key of a
+ *  model file.  Editing or replacing the file changes its
+ *  size or modification time, which misses the cache.
+ ***********************************************************/
+unsigned long long MeshImporter::MakeKey(const char* filePath, const MappedFile& file)
+{
+	unsigned int version = CACHE_FILE_VERSION;
+	unsigned long long size = (unsigned long long)file.GetSize();
+	long long modifiedTime = file.GetModifiedTime();
+
+	unsigned long long key = HashBytes(HASH_OFFSET, &version, sizeof(version));
+	key = HashBytes(key, filePath, strlen(filePath));
+	key = HashBytes(key, &size, sizeof(size));
+	key = HashBytes(key, &modifiedTime, sizeof(modifiedTime));
+	return(key);
+}
+
+/***********************************************************
+ *  GetCachePath()
+ *
+ *  This method is used for building the path of the cooked
+ *  file for a cache key.
+ ***********************************************************/
+std::string MeshImporter::GetCachePath(unsigned long long key) const
+{
+	std::ostringstream path;
+	path << m_cacheDirectory << "/" << std::hex << key << ".mesh";
+	return(path.str());
+}
+
+/***********************************************************
+ *  StoreCachedMesh()
+ *
+ *  This method is used for writing a converted mesh to the
+ *  cache, laid out exactly as it is uploaded.
+ ***********************************************************/
+bool MeshImporter::StoreCachedMesh(unsigned long long key, const MESH_DATA& mesh) const
+{
+	CACHE_FILE_HEADER header;
+	header.magic = CACHE_FILE_MAGIC;
+	header.version = CACHE_FILE_VERSION;
+	header.key = key;
+	header.vertexCount = (unsigned int)mesh.vertices.size();
+	header.indexCount = (unsigned int)mesh.indices.size();
+	header.lodCount = (unsigned int)mesh.lods.size();
+	header.meshletCount = (unsigned int)mesh.meshlets.size();
+	for (int axis = 0; axis < 3; axis++)
+	{
+		header.boundsMin[axis] = mesh.boundsMin[axis];
+		header.boundsMax[axis] = mesh.boundsMax[axis];
+	}
+
+	std::string filePath = GetCachePath(key);
+	std::ofstream file(filePath.c_str(), std::ios::binary | std::ios::trunc);
+	if (!file.is_open())
+	{
+		return(false);
+	}
+	file.write((const char*)&header, sizeof(header));
+	if (mesh.lods.empty() == false)
+	{
+		file.write((const char*)&mesh.lods[0], mesh.lods.size() * sizeof(MESH_LOD));
+	}
+	if (mesh.meshlets.empty() == false)
+	{
+		file.write((const char*)&mesh.meshlets[0], mesh.meshlets.size() * sizeof(MESHLET));
+	}
+	if (mesh.vertices.empty() == false)
+	{
+		file.write((const char*)&mesh.vertices[0], mesh.vertices.size() * sizeof(MESH_VERTEX));
+	}
+	if (mesh.indices.empty() == false)
+	{
+		file.write((const char*)&mesh.indices[0], mesh.indices.size() * sizeof(unsigned int));
+	}
+	if (!file)
+	{
+		file.close();
+		std::remove(filePath.c_str());
+		return(false);
+	}
+
+	return(true);
+}
+
+/***********************************************************
+ *  LoadCachedMesh()
+ *
+ *  This method is used for loading a cooked mesh.  The file
+ *  is mapped, and the vertices and indices are uploaded
+ *  straight from the mapping without being copied first.
+ ***********************************************************/
+bool MeshImporter::LoadCachedMesh(unsigned long long key, GPU_MESH& mesh) const
+{
+	MappedFile file;
+	CACHE_FILE_HEADER header;
+	if ((file.Open(GetCachePath(key).c_str()) == false) ||
+		(CheckCacheFile(file, key, header) == false))
+	{
+		return(false);
+	}
+	size_t lodBytes = (size_t)header.lodCount * sizeof(MESH_LOD);
+	size_t meshletBytes = (size_t)header.meshletCount * sizeof(MESHLET);
+	size_t vertexBytes = (size_t)header.vertexCount * sizeof(MESH_VERTEX);
+
+	const unsigned char* lods = file.GetData() + sizeof(header);
+	mesh.lods.resize(header.lodCount);
+	if (lodBytes > 0)
+	{
+		memcpy(&mesh.lods[0], lods, lodBytes);
+	}
+	const unsigned char* meshlets = lods + lodBytes;
+	mesh.meshlets.resize(header.meshletCount);
+	if (meshletBytes > 0)
+	{
+		memcpy(&mesh.meshlets[0], meshlets, meshletBytes);
+	}
+	const unsigned char* vertices = meshlets + meshletBytes;
+	UploadMesh(vertices, header.vertexCount, vertices + vertexBytes, header.indexCount, mesh);
+	for (int axis = 0; axis < 3; axis++)
+	{
+		mesh.boundsMin[axis] = header.boundsMin[axis];
+		mesh.boundsMax[axis] = header.boundsMax[axis];
+	}
+	return(true);
+}
+
+/***********************************************************
+ *  ReadCachedMesh()
+ *
+ *  This method is used for copying a cooked mesh into
+ *  system memory, for uploading later.
+ ***********************************************************/
+bool MeshImporter::ReadCachedMesh(unsigned long long key, MESH_DATA& mesh) const
+{
+	MappedFile file;
+	CACHE_FILE_HEADER header;
+	if ((file.Open(GetCachePath(key).c_str()) == false) ||
+		(CheckCacheFile(file, key, header) == false))
+	{
+		return(false);
+	}
+
+	const MESH_LOD* lods = (const MESH_LOD*)(file.GetData() + sizeof(header));
+	const MESHLET* meshlets = (const MESHLET*)(lods + header.lodCount);
+	const MESH_VERTEX* vertices = (const MESH_VERTEX*)(meshlets + header.meshletCount);
+	const unsigned int* indices = (const unsigned int*)(vertices + header.vertexCount);
+	mesh.lods.assign(lods, lods + header.lodCount);
+	mesh.meshlets.assign(meshlets, meshlets + header.meshletCount);
+	mesh.vertices.assign(vertices, vertices + header.vertexCount);
+	mesh.indices.assign(indices, indices + header.indexCount);
+	for (int axis = 0; axis < 3; axis++)
+	{
+		mesh.boundsMin[axis] = header.boundsMin[axis];
+		mesh.boundsMax[axis] = header.boundsMax[axis];
+	}
+	return(true);
+}
+
+/***********************************************************
+ *  UploadMesh()
+ *
+ *  This method is used for creating the vertex array and
+ *  buffers of a mesh, with the attributes at the locations
+ *  the scene shaders read them from.
+ ***********************************************************/
+void MeshImporter::UploadMesh(
+	const void* vertices,
+	size_t vertexCount,
+	const void* indices,
+	size_t indexCount,
+	GPU_MESH& mesh)
+{
+	glGenVertexArrays(1, &mesh.vertexArray);
+	glGenBuffers(1, &mesh.vertexBuffer);
+	glGenBuffers(1, &mesh.indexBuffer);
+	mesh.indexCount = (GLsizei)indexCount;
+
+	glBindVertexArray(mesh.vertexArray);
+	glBindBuffer(GL_ARRAY_BUFFER, mesh.vertexBuffer);
+	glBufferData(GL_ARRAY_BUFFER, vertexCount * sizeof(MESH_VERTEX), vertices, GL_STATIC_DRAW);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mesh.indexBuffer);
+	glBufferData(GL_ELEMENT_ARRAY_BUFFER, indexCount * sizeof(unsigned int), indices, GL_STATIC_DRAW);
+
+	GLsizei stride = (GLsizei)sizeof(MESH_VERTEX);
+	glEnableVertexAttribArray(0);
+	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, stride, (void*)offsetof(MESH_VERTEX, position));
+	glEnableVertexAttribArray(1);
+	glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, stride, (void*)offsetof(MESH_VERTEX, normal));
+	glEnableVertexAttribArray(2);
+	glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, stride, (void*)offsetof(MESH_VERTEX, textureCoordinate));
+
+	glBindVertexArray(0);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+/***********************************************************
+ *  RunBenchmark()
+ *
+ *  This method is used for timing the import of a model
+ *  file and the building of its detail levels on one thread
+ *  and on every core, the building and culling of its
+ *  meshlets, and the loading of its cooked copy.  The parse rate is given in megabytes of
+ *  the source file per second, and the cache load includes
+ *  the upload into the OpenGL buffers.
+ ***********************************************************/
+void MeshImporter::RunBenchmark(const char* filePath)
+{
+	const int LOAD_REPEATS = 5;
+
+	MappedFile file;
+	if (file.Open(filePath) == false)
+	{
+		std::cout << "ERROR::MESH_FILE_NOT_FOUND: " << filePath << std::endl;
+		return;
+	}
+	double megabytes = file.GetSize() / (1024.0 * 1024.0);
+	std::cout << "INFO: Mesh benchmark, " << filePath << " (" << megabytes << " MB)" << std::endl;
+
+	int coreCount = std::max(1, (int)std::thread::hardware_concurrency());
+	int threadCounts[2] = { 1, coreCount };
+	MESH_DATA mesh;
+	for (int t = 0; t < ((coreCount > 1) ? 2 : 1); t++)
+	{
+		std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+		if (ImportMappedMesh(filePath, file, mesh, threadCounts[t]) == false)
+		{
+			return;
+		}
+		double parseTime = std::chrono::duration<double>(
+			std::chrono::steady_clock::now() - startTime).count();
+		std::cout << "INFO: Threads: " << threadCounts[t]
+			<< ", import: " << parseTime * 1000.0 << " ms"
+			<< ", " << megabytes / std::max(parseTime, 1.0e-9) << " MB/s"
+			<< ", " << mesh.indices.size() / 3 << " triangles, "
+			<< mesh.vertices.size() << " vertices" << std::endl;
+	}
+
+	// each detail level is simplified on its own thread
+	for (int t = 0; t < ((coreCount > 1) ? 2 : 1); t++)
+	{
+		std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+		MeshSimplifier::BuildLODChain(mesh, threadCounts[t]);
+		double simplifyTime = std::chrono::duration<double, std::milli>(
+			std::chrono::steady_clock::now() - startTime).count();
+		std::cout << "INFO: Threads: " << threadCounts[t]
+			<< ", detail levels: " << simplifyTime << " ms" << std::endl;
+	}
+	for (size_t level = 0; level < mesh.lods.size(); level++)
+	{
+		std::cout << "INFO: Level " << level << ": " << mesh.lods[level].indexCount / 3
+			<< " triangles, error " << mesh.lods[level].error << std::endl;
+	}
+
+	// split the levels into meshlets, then cull the full level from
+	// a camera close to the mesh looking at it along each axis
+	std::chrono::steady_clock::time_point meshletStartTime = std::chrono::steady_clock::now();
+	MeshletBuilder::BuildMeshlets(mesh);
+	double meshletTime = std::chrono::duration<double, std::milli>(
+		std::chrono::steady_clock::now() - meshletStartTime).count();
+
+	glm::vec3 center = (mesh.boundsMin + mesh.boundsMax) * 0.5f;
+	float radius = std::max(glm::length(mesh.boundsMax - mesh.boundsMin) * 0.5f, 1.0e-6f);
+	glm::mat4 projection = glm::perspective(glm::radians(45.0f), 16.0f / 9.0f, radius * 0.01f, radius * 10.0f);
+	std::vector<DRAW_COMMAND> commands;
+	size_t keptTriangles = 0;
+	size_t commandCount = 0;
+	double cullTime = 0.0;
+	for (int view = 0; view < CULLING_VIEW_COUNT; view++)
+	{
+		glm::vec3 direction(0.0f);
+		direction[view / 2] = (view % 2 == 0) ? 1.0f : -1.0f;
+		glm::vec3 up = (view / 2 == 1) ? glm::vec3(0.0f, 0.0f, 1.0f) : glm::vec3(0.0f, 1.0f, 0.0f);
+		glm::vec3 eye = center + direction * radius * 1.2f;
+		glm::mat4 viewProjection = projection * glm::lookAt(eye, center, up);
+
+		commands.clear();
+		std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+		keptTriangles += MeshletBuilder::CullMeshlets(&mesh.meshlets[mesh.lods[0].meshletOffset],
+			mesh.lods[0].meshletCount, &viewProjection, 1, eye, true, commands);
+		cullTime += std::chrono::duration<double, std::micro>(
+			std::chrono::steady_clock::now() - startTime).count();
+		commandCount += commands.size();
+	}
+	std::cout << "INFO: Meshlets: " << mesh.lods[0].meshletCount << " in the full level, "
+		<< mesh.meshlets.size() << " in all levels, built in " << meshletTime << " ms" << std::endl;
+	std::cout << "INFO: Meshlet culling keeps "
+		<< 100.0 * keptTriangles / std::max((size_t)1, (size_t)mesh.lods[0].indexCount / 3 * CULLING_VIEW_COUNT)
+		<< "% of the triangles in " << commandCount / CULLING_VIEW_COUNT << " draws, "
+		<< cullTime / CULLING_VIEW_COUNT << " us per view" << std::endl;
+
+	// cook the mesh, then time loading the cooked copy
+	std::string savedDirectory = m_cacheDirectory;
+	if (m_cacheDirectory.empty() == true)
+	{
+		SetCacheDirectory("meshcache");
+	}
+	unsigned long long key = MakeKey(filePath, file);
+	if (StoreCachedMesh(key, mesh) == false)
+	{
+		std::cout << "ERROR::MESH_CACHE_NOT_WRITTEN: " << GetCachePath(key) << std::endl;
+		m_cacheDirectory = savedDirectory;
+		return;
+	}
+
+	double bestLoadTime = 1.0e30;
+	for (int i = 0; i < LOAD_REPEATS; i++)
+	{
+		GPU_MESH gpuMesh;
+		std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+		bool bLoaded = LoadCachedMesh(key, gpuMesh);
+		glFinish();
+		double loadTime = std::chrono::duration<double, std::milli>(
+			std::chrono::steady_clock::now() - startTime).count();
+		if (bLoaded == false)
+		{
+			break;
+		}
+		bestLoadTime = std::min(bestLoadTime, loadTime);
+		DestroyMesh(gpuMesh);
+	}
+	std::cout << "INFO: Cooked mesh load and upload: " << bestLoadTime << " ms" << std::endl;
+
+	m_cacheDirectory = savedDirectory;
+}
@@ -0,0 +1,209 @@
+///////////////////////////////////////////////////////////////////////////////
+// meshimporter.h
+// ============
+// import triangle meshes from OBJ and glTF 2.0 files, and keep the
+// converted meshes in a cooked binary cache that loads straight into
+// the vertex and index buffers
+//
+//  Created for CS-330-Computational Graphics and Visualization
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "MappedFile.h"
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+#include <string>
+#include <vector>
+
+/***********************************************************
+ *  MeshImporter
+ *
+ *  This class contains the code for turning model files into
+ *  indexed triangle meshes with the same vertex layout as
+ *  the basic shape meshes:
+ *
+ *    location 0   position
+ *    location 1   normal
+ *    location 2   texture coordinate
+ *
+ *  OBJ files are parsed in parallel, each thread taking a
+ *  run of whole lines from the memory mapped file.  glTF
+ *  files, both .gltf with separate buffers and single .glb
+ *  files, read their vertex data straight out of the mapped
+ *  buffers.  Each imported mesh gets a chain of simplified
+ *  detail levels in the same index buffer, with each level
+ *  split into meshlets that are culled before they are
+ *  drawn.  Converted meshes
+ *  are written to the cache directory, and a cached mesh is
+ *  loaded by mapping its file and handing the mapped
+ *  vertices and indices to OpenGL.
+ ***********************************************************/
+class MeshImporter
+{
+public:
+	// a vertex of an imported mesh
+	struct MESH_VERTEX
+	{
+		glm::vec3 position;
+		glm::vec3 normal;
+		glm::vec2 textureCoordinate;
+	};
+
+	// a detail level of a mesh, as a range of its indices
+	struct MESH_LOD
+	{
+		unsigned int indexOffset;
+		unsigned int indexCount;
+		// largest distance the simplified surface is from the
+		// full mesh, in the units of the model file
+		float error;
+		// range of the meshlets the level's triangles are split into
+		unsigned int meshletOffset;
+		unsigned int meshletCount;
+	};
+
+	// a small cluster of neighbouring triangles, stored as a range
+	// of the index buffer, with the bounds used to cull it
+	struct MESHLET
+	{
+		unsigned int indexOffset;
+		unsigned int indexCount;
+		// bounding sphere of the triangles
+		glm::vec3 center;
+		float radius;
+		// every triangle faces within the cone around the axis, and
+		// the cutoff is the sine of the cone's half angle, or one
+		// when the triangles face too many ways to be culled
+		glm::vec3 coneAxis;
+		float coneCutoff;
+	};
+
+	// the layout of a glMultiDrawElementsIndirect() command
+	struct DRAW_COMMAND
+	{
+		GLuint count;
+		GLuint instanceCount;
+		GLuint firstIndex;
+		GLint baseVertex;
+		GLuint baseInstance;
+	};
+
+	// an imported mesh in system memory
+	struct MESH_DATA
+	{
+		std::vector<MESH_VERTEX> vertices;
+		// indices of every detail level, the full mesh first
+		std::vector<unsigned int> indices;
+		std::vector<MESH_LOD> lods;
+		std::vector<MESHLET> meshlets;
+		glm::vec3 boundsMin;
+		glm::vec3 boundsMax;
+	};
+
+	// an imported mesh in OpenGL buffers
+	struct GPU_MESH
+	{
+		GLuint vertexArray;
+		GLuint vertexBuffer;
+		GLuint indexBuffer;
+		GLsizei indexCount;
+		std::vector<MESH_LOD> lods;
+		std::vector<MESHLET> meshlets;
+		glm::vec3 boundsMin;
+		glm::vec3 boundsMax;
+	};
+
+	// constructor
+	MeshImporter();
+	// destructor
+	~MeshImporter();
+
+	// set the directory the cooked meshes are stored in
+	void SetCacheDirectory(const char* directory);
+
+	// load a model file into OpenGL buffers, from the cooked
+	// cache when the file has not changed since it was cooked
+	bool LoadMesh(const char* filePath, GPU_MESH& mesh);
+	// load a model file into system memory the same way, without
+	// using OpenGL, so it can be called from a worker thread
+	bool ReadMesh(const char* filePath, MESH_DATA& mesh) const;
+	// create the OpenGL buffers for a mesh read by ReadMesh()
+	static void UploadMeshData(const MESH_DATA& meshData, GPU_MESH& mesh);
+	// draw a detail level of a mesh loaded by LoadMesh()
+	static void DrawMesh(const GPU_MESH& mesh, int level);
+	// draw the meshlets of a detail level that are inside any of
+	// the views and facing the camera.  the view position is in the
+	// mesh's own space, and is only used when bCullBackfaces is true
+	void DrawMeshClusters(
+		const GPU_MESH& mesh,
+		int level,
+		const glm::mat4* modelViewProjections,
+		int viewCount,
+		const glm::vec3& viewPosition,
+		bool bCullBackfaces);
+	// pick the coarsest detail level whose error covers no more
+	// than maxPixelError pixels, given how many pixels one unit
+	// of the mesh covers on the screen
+	static int SelectLOD(const GPU_MESH& mesh, float pixelsPerUnit, float maxPixelError);
+	// free the buffers of a mesh loaded by LoadMesh() or UploadMesh()
+	static void DestroyMesh(GPU_MESH& mesh);
+	// read the positions and the full detail triangles of a mesh
+	// back from its OpenGL buffers
+	static bool ReadMeshTriangles(const GPU_MESH& mesh, std::vector<glm::vec3>& positions, std::vector<unsigned int>& indices);
+	// read the vertices and the full detail triangles of a mesh
+	// back from its OpenGL buffers
+	static bool ReadMeshVertices(const GPU_MESH& mesh, std::vector<MESH_VERTEX>& vertices, std::vector<unsigned int>& indices);
+	// create the OpenGL buffers for a mesh from vertices laid out
+	// like MESH_VERTEX and 32 bit indices
+	static void UploadMesh(
+		const void* vertices,
+		size_t vertexCount,
+		const void* indices,
+		size_t indexCount,
+		GPU_MESH& mesh);
+
+	// import a model file, choosing the parser by its extension.
+	// zero threads uses one thread per CPU core
+	static bool ImportMesh(const char* filePath, MESH_DATA& mesh, int threadCount);
+
+	// time parsing, simplifying and cache loading for a model file
+	void RunBenchmark(const char* filePath);
+
+private:
+	// directory the cooked meshes are stored in
+	std::string m_cacheDirectory;
+	// commands for the visible meshlets of the mesh being drawn
+	std::vector<DRAW_COMMAND> m_drawCommands;
+	// buffer the draw commands are uploaded into
+	GLuint m_commandBuffer;
+	// counts and offsets for drawing without indirect commands
+	std::vector<GLsizei> m_drawCounts;
+	std::vector<const void*> m_drawOffsets;
+
+	// import a model file that has already been mapped
+	static bool ImportMappedMesh(const char* filePath, const MappedFile& file, MESH_DATA& mesh, int threadCount);
+	// parse an OBJ file on the passed in number of threads
+	static bool ParseOBJ(const MappedFile& file, MESH_DATA& mesh, int threadCount);
+	// read the triangle meshes of a glTF file
+	static bool ParseGLTF(const char* filePath, const MappedFile& file, MESH_DATA& mesh);
+	// compute the bounds, and the normals when the file had none
+	static void FinishMesh(MESH_DATA& mesh, bool bComputeNormals);
+
+	// build the cache key of a model file from its path, size
+	// and modification time
+	static unsigned long long MakeKey(const char* filePath, const MappedFile& file);
+	// get the path of the cooked file for a cache key
+	std::string GetCachePath(unsigned long long key) const;
+	// write a converted mesh to the cache
+	bool StoreCachedMesh(unsigned long long key, const MESH_DATA& mesh) const;
+	// load a cooked mesh into OpenGL buffers
+	bool LoadCachedMesh(unsigned long long key, GPU_MESH& mesh) const;
+	// copy a cooked mesh into system memory
+	bool ReadCachedMesh(unsigned long long key, MESH_DATA& mesh) const;
+	// import a mapped model file, build its detail levels and
+	// meshlets, and write it to the cache
+	bool ConvertMesh(const char* filePath, const MappedFile& file, unsigned long long key, MESH_DATA& mesh) const;
+};
@@ -0,0 +1,909 @@
+///////////////////////////////////////////////////////////////////////////////
+// meshsimplifier.cpp
+// ============
+// reduce the triangles of imported meshes with quadric error metrics,
+// building the chain of detail levels that are drawn at a distance
+//
+//  Created for CS-330-Computational Graphics and Visualization
+///////////////////////////////////////////////////////////////////////////////
+
+#include "MeshSimplifier.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+#include <thread>
+#include <utility>
+
+// declaration of the global variables and defines
+namespace
+{
+	// each detail level aims for this fraction of the triangles
+	// of the level before it
+	const float LOD_REDUCTION = 0.5f;
+	// a detail level is only kept when it has no more than this
+	// fraction of the triangles of the level before it
+	const float MIN_LOD_REDUCTION = 0.85f;
+	// meshes are not reduced below this number of triangles
+	const size_t MIN_LOD_TRIANGLES = 64;
+	// largest error of a collapse, as a fraction of the size of
+	// the mesh, beyond which a detail level stops reducing
+	const float MAX_LOD_ERROR = 0.05f;
+	// distance that a full difference in normal or texture
+	// coordinate costs as much as, as a fraction of mesh size
+	const float ATTRIBUTE_WEIGHT = 0.02f;
+	// smallest cosine between the normal of a triangle before
+	// and after a collapse, which stops triangles folding over
+	const double MIN_NORMAL_COSINE = 0.2;
+	// marks a vertex without a partner in a collapse
+	const unsigned int NO_VERTEX = 0xFFFFFFFF;
+	// levels with fewer triangles than this are simplified on
+	// one thread
+	const size_t MIN_PARALLEL_TRIANGLES = 20000;
+	// extra fraction of triangles the chunks of a level keep,
+	// for the last pass to remove along the seams between them
+	const float CHUNK_SLACK = 0.1f;
+
+	// sum of the squared distances to a set of planes, weighted
+	// by the area of the triangle each plane came from
+	struct QUADRIC
+	{
+		double a2, b2, c2;
+		double ab, ac, bc;
+		double ad, bd, cd;
+		double d2;
+		double weight;
+	};
+
+	// an edge collapse waiting in the queue, which is stale when
+	// either vertex changed since it was queued
+	struct COLLAPSE
+	{
+		double cost;
+		unsigned int from;
+		unsigned int to;
+		unsigned int fromVersion;
+		unsigned int toVersion;
+	};
+
+	/***********************************************************
+	 *  SIMPLIFY_STATE
+	 *
+	 *  The working copy of a mesh being simplified.  Vertices
+	 *  with the same position form a group, named by its first
+	 *  vertex, and the quadrics, triangle lists and collapses
+	 *  belong to the groups rather than to single vertices.
+	 ***********************************************************/
+	struct SIMPLIFY_STATE
+	{
+		const std::vector<MeshImporter::MESH_VERTEX>* pVertices;
+		// three vertices for each triangle
+		std::vector<unsigned int> triangles;
+		std::vector<char> triangleAlive;
+		// position group of each vertex
+		std::vector<unsigned int> group;
+		// next vertex of the same group, in a circular list
+		std::vector<unsigned int> nextWedge;
+		// triangles that use each group, which may include
+		// triangles that have since been removed
+		std::vector<std::vector<unsigned int> > groupTriangles;
+		std::vector<QUADRIC> quadrics;
+		std::vector<unsigned int> versions;
+		// groups on an open border or a non-manifold edge
+		std::vector<char> locked;
+		// groups that were collapsed into a neighbour
+		std::vector<char> removed;
+		double attributeWeight;
+		// vertex pairs of the collapse being checked
+		std::vector<std::pair<unsigned int, unsigned int> > wedgeMap;
+	};
+
+	// the chunks of a detail level being simplified, shared by
+	// the worker threads
+	struct CHUNK_JOB
+	{
+		const std::vector<MeshImporter::MESH_VERTEX>* pVertices;
+		const std::vector<unsigned int>* pIndices;
+		// triangles in the order they are cut into chunks
+		std::vector<unsigned int> triangleOrder;
+		// first triangle of each chunk, and the end of the last
+		std::vector<size_t> chunkStarts;
+		// fraction of the triangles each chunk is reduced to
+		float reduction;
+		float maxError;
+		double attributeWeight;
+		std::vector<std::vector<unsigned int> > chunkIndices;
+		std::vector<float> chunkErrors;
+		std::atomic<int> nextChunk;
+	};
+
+	/***********************************************************
+	 *  AddPlaneQuadric()
+	 *
+	 *  This function is used to add the squared distance to a
+	 *  plane into a quadric.
+	 ***********************************************************/
+	void AddPlaneQuadric(QUADRIC& quadric, const glm::dvec3& normal, double distance, double weight)
+	{
+		quadric.a2 += weight * normal.x * normal.x;
+		quadric.b2 += weight * normal.y * normal.y;
+		quadric.c2 += weight * normal.z * normal.z;
+		quadric.ab += weight * normal.x * normal.y;
+		quadric.ac += weight * normal.x * normal.z;
+		quadric.bc += weight * normal.y * normal.z;
+		quadric.ad += weight * normal.x * distance;
+		quadric.bd += weight * normal.y * distance;
+		quadric.cd += weight * normal.z * distance;
+		quadric.d2 += weight * distance * distance;
+		quadric.weight += weight;
+	}
+
+	/***********************************************************
+	 *  AddQuadric()
+	 *
+	 *  This function is used to add one quadric into another.
+	 ***********************************************************/
+	void AddQuadric(QUADRIC& target, const QUADRIC& source)
+	{
+		target.a2 += source.a2;
+		target.b2 += source.b2;
+		target.c2 += source.c2;
+		target.ab += source.ab;
+		target.ac += source.ac;
+		target.bc += source.bc;
+		target.ad += source.ad;
+		target.bd += source.bd;
+		target.cd += source.cd;
+		target.d2 += source.d2;
+		target.weight += source.weight;
+	}
+
+	/***********************************************************
+	 *  EvaluateQuadric()
+	 *
+	 *  This function is used to get the weighted sum of the
+	 *  squared distances from a point to the planes of a
+	 *  quadric.
+	 ***********************************************************/
+	double EvaluateQuadric(const QUADRIC& quadric, const glm::vec3& point)
+	{
+		double x = point.x;
+		double y = point.y;
+		double z = point.z;
+		double error =
+			quadric.a2 * x * x + quadric.b2 * y * y + quadric.c2 * z * z +
+			2.0 * (quadric.ab * x * y + quadric.ac * x * z + quadric.bc * y * z) +
+			2.0 * (quadric.ad * x + quadric.bd * y + quadric.cd * z) +
+			quadric.d2;
+		return(std::max(error, 0.0));
+	}
+
+	/***********************************************************
+	 *  CollapseGreater()
+	 *
+	 *  This function is used to order the collapse queue so
+	 *  the cheapest collapse is taken first.
+	 ***********************************************************/
+	bool CollapseGreater(const COLLAPSE& a, const COLLAPSE& b)
+	{
+		return(a.cost > b.cost);
+	}
+
+	/***********************************************************
+	 *  MortonCode()
+	 *
+	 *  This function is used to interleave the bits of three
+	 *  10 bit cell coordinates, so that sorting by the code
+	 *  keeps nearby cells together.
+	 ***********************************************************/
+	unsigned int MortonCode(unsigned int x, unsigned int y, unsigned int z)
+	{
+		unsigned int code = 0;
+		for (int bit = 0; bit < 10; bit++)
+		{
+			code |= ((x >> bit) & 1) << (bit * 3);
+			code |= ((y >> bit) & 1) << (bit * 3 + 1);
+			code |= ((z >> bit) & 1) << (bit * 3 + 2);
+		}
+		return(code);
+	}
+
+	/***********************************************************
+	 *  FindWedgeMap()
+	 *
+	 *  This function is used to pair each vertex of a group
+	 *  with the vertex of the target group that it shares a
+	 *  triangle with.  A vertex without such a partner would
+	 *  have to take attributes from across a seam, so the
+	 *  collapse is not allowed.
+	 ***********************************************************/
+	bool FindWedgeMap(SIMPLIFY_STATE& state, unsigned int from, unsigned int to)
+	{
+		state.wedgeMap.clear();
+		const std::vector<unsigned int>& triangleList = state.groupTriangles[from];
+
+		unsigned int wedge = from;
+		do
+		{
+			bool bUsed = false;
+			unsigned int partner = NO_VERTEX;
+			for (size_t i = 0; (i < triangleList.size()) && (partner == NO_VERTEX); i++)
+			{
+				unsigned int triangle = triangleList[i];
+				if (state.triangleAlive[triangle] == 0)
+				{
+					continue;
+				}
+				const unsigned int* corners = &state.triangles[(size_t)triangle * 3];
+				if ((corners[0] != wedge) && (corners[1] != wedge) && (corners[2] != wedge))
+				{
+					continue;
+				}
+				bUsed = true;
+				for (int k = 0; k < 3; k++)
+				{
+					if (state.group[corners[k]] == to)
+					{
+						partner = corners[k];
+					}
+				}
+			}
+
+			if (partner != NO_VERTEX)
+			{
+				state.wedgeMap.push_back(std::make_pair(wedge, partner));
+			}
+			else if (bUsed == true)
+			{
+				return(false);
+			}
+			wedge = state.nextWedge[wedge];
+		} while (wedge != from);
+
+		return(state.wedgeMap.empty() == false);
+	}
+
+	/***********************************************************
+	 *  CollapseFolds()
+	 *
+	 *  This function is used to check whether moving a group
+	 *  onto the target group would turn any of its remaining
+	 *  triangles over or squash it flat.
+	 ***********************************************************/
+	bool CollapseFolds(const SIMPLIFY_STATE& state, unsigned int from, unsigned int to)
+	{
+		const std::vector<MeshImporter::MESH_VERTEX>& vertices = *state.pVertices;
+		const glm::vec3& target = vertices[to].position;
+		const std::vector<unsigned int>& triangleList = state.groupTriangles[from];
+
+		for (size_t i = 0; i < triangleList.size(); i++)
+		{
+			unsigned int triangle = triangleList[i];
+			if (state.triangleAlive[triangle] == 0)
+			{
+				continue;
+			}
+			const unsigned int* corners = &state.triangles[(size_t)triangle * 3];
+			glm::dvec3 before[3];
+			glm::dvec3 after[3];
+			bool bRemoved = false;
+			for (int k = 0; k < 3; k++)
+			{
+				unsigned int cornerGroup = state.group[corners[k]];
+				bRemoved = bRemoved || (cornerGroup == to);
+				before[k] = glm::dvec3(vertices[corners[k]].position);
+				after[k] = (cornerGroup == from) ? glm::dvec3(target) : before[k];
+			}
+			if (bRemoved == true)
+			{
+				continue;
+			}
+
+			glm::dvec3 normalBefore = glm::cross(before[1] - before[0], before[2] - before[0]);
+			glm::dvec3 normalAfter = glm::cross(after[1] - after[0], after[2] - after[0]);
+			double lengths = glm::length(normalBefore) * glm::length(normalAfter);
+			if (glm::dot(normalBefore, normalAfter) <= MIN_NORMAL_COSINE * lengths)
+			{
+				return(true);
+			}
+		}
+		return(false);
+	}
+
+	/***********************************************************
+	 *  CollapseCost()
+	 *
+	 *  This function is used to get the cost of collapsing one
+	 *  group onto another, from the distance error of the moved
+	 *  group and the attribute differences of its vertices.  It
+	 *  returns false when the collapse is not allowed.
+	 ***********************************************************/
+	bool CollapseCost(SIMPLIFY_STATE& state, unsigned int from, unsigned int to, double& cost)
+	{
+		if ((state.locked[from] != 0) || (FindWedgeMap(state, from, to) == false))
+		{
+			return(false);
+		}
+
+		const std::vector<MeshImporter::MESH_VERTEX>& vertices = *state.pVertices;
+		double attributeError = 0.0;
+		for (size_t i = 0; i < state.wedgeMap.size(); i++)
+		{
+			const MeshImporter::MESH_VERTEX& a = vertices[state.wedgeMap[i].first];
+			const MeshImporter::MESH_VERTEX& b = vertices[state.wedgeMap[i].second];
+			glm::vec3 normalOffset = a.normal - b.normal;
+			glm::vec2 textureOffset = a.textureCoordinate - b.textureCoordinate;
+			attributeError += glm::dot(normalOffset, normalOffset) + glm::dot(textureOffset, textureOffset);
+		}
+
+		const QUADRIC& quadric = state.quadrics[from];
+		cost = EvaluateQuadric(quadric, vertices[to].position) +
+			state.attributeWeight * quadric.weight * attributeError;
+		return(true);
+	}
+
+	/***********************************************************
+	 *  QueueEdge()
+	 *
+	 *  This function is used to add the cheaper direction of
+	 *  collapsing an edge to the queue.
+	 ***********************************************************/
+	void QueueEdge(SIMPLIFY_STATE& state, std::vector<COLLAPSE>& queue, unsigned int a, unsigned int b)
+	{
+		double costAB = 0.0;
+		double costBA = 0.0;
+		bool bCollapseAB = CollapseCost(state, a, b, costAB);
+		bool bCollapseBA = CollapseCost(state, b, a, costBA);
+		if ((bCollapseAB == false) && (bCollapseBA == false))
+		{
+			return;
+		}
+
+		COLLAPSE collapse;
+		if ((bCollapseAB == true) && ((bCollapseBA == false) || (costAB <= costBA)))
+		{
+			collapse.cost = costAB;
+			collapse.from = a;
+			collapse.to = b;
+		}
+		else
+		{
+			collapse.cost = costBA;
+			collapse.from = b;
+			collapse.to = a;
+		}
+		collapse.fromVersion = state.versions[collapse.from];
+		collapse.toVersion = state.versions[collapse.to];
+		queue.push_back(collapse);
+		std::push_heap(queue.begin(), queue.end(), CollapseGreater);
+	}
+
+	/***********************************************************
+	 *  SimplifyMesh()
+	 *
+	 *  This function is used to simplify a mesh that uses every
+	 *  one of its vertices.  The vertices are grouped by
+	 *  position and each group gets the quadric of the planes
+	 *  of its triangles.  Then the cheapest edge collapse is
+	 *  taken from the queue over and over, skipping collapses
+	 *  that have gone stale, that would fold a triangle over,
+	 *  or that cross a seam, until the mesh is small enough or
+	 *  the queue runs out.
+	 ***********************************************************/
+	float SimplifyMesh(
+		const std::vector<MeshImporter::MESH_VERTEX>& vertices,
+		const std::vector<unsigned int>& indices,
+		size_t targetIndexCount,
+		float maxError,
+		double attributeWeight,
+		std::vector<unsigned int>& result)
+	{
+		size_t vertexCount = vertices.size();
+		size_t triangleCount = indices.size() / 3;
+
+		SIMPLIFY_STATE state;
+		state.pVertices = &vertices;
+		state.triangles.assign(indices.begin(), indices.begin() + triangleCount * 3);
+		state.triangleAlive.assign(triangleCount, 1);
+
+		// group the vertices that share a position, by sorting them
+		// on their position
+		std::vector<unsigned int> order(vertexCount);
+		for (size_t i = 0; i < vertexCount; i++)
+		{
+			order[i] = (unsigned int)i;
+		}
+		std::sort(order.begin(), order.end(),
+			[&vertices](unsigned int a, unsigned int b)
+			{
+				const glm::vec3& pa = vertices[a].position;
+				const glm::vec3& pb = vertices[b].position;
+				if (pa.x != pb.x) return(pa.x < pb.x);
+				if (pa.y != pb.y) return(pa.y < pb.y);
+				if (pa.z != pb.z) return(pa.z < pb.z);
+				return(a < b);
+			});
+		state.group.resize(vertexCount);
+		state.nextWedge.resize(vertexCount);
+		for (size_t first = 0; first < vertexCount; )
+		{
+			size_t last = first + 1;
+			while ((last < vertexCount) &&
+				(vertices[order[last]].position == vertices[order[first]].position))
+			{
+				last++;
+			}
+			for (size_t i = first; i < last; i++)
+			{
+				state.group[order[i]] = order[first];
+				state.nextWedge[order[i]] = order[(i + 1 < last) ? i + 1 : first];
+			}
+			first = last;
+		}
+
+		// the quadric of each group is made from the planes of the
+		// triangles around it, weighted by their area
+		QUADRIC emptyQuadric;
+		memset(&emptyQuadric, 0, sizeof(emptyQuadric));
+		state.quadrics.assign(vertexCount, emptyQuadric);
+		state.groupTriangles.resize(vertexCount);
+		std::vector<unsigned long long> edges;
+		edges.reserve(triangleCount * 3);
+		for (size_t t = 0; t < triangleCount; t++)
+		{
+			const unsigned int* corners = &state.triangles[t * 3];
+			unsigned int groups[3];
+			for (int k = 0; k < 3; k++)
+			{
+				groups[k] = state.group[corners[k]];
+			}
+
+			glm::dvec3 p0(vertices[corners[0]].position);
+			glm::dvec3 normal = glm::cross(
+				glm::dvec3(vertices[corners[1]].position) - p0,
+				glm::dvec3(vertices[corners[2]].position) - p0);
+			double normalLength = glm::length(normal);
+			for (int k = 0; k < 3; k++)
+			{
+				if ((k > 0 && groups[k] == groups[0]) || (k > 1 && groups[k] == groups[1]))
+				{
+					continue;
+				}
+				state.groupTriangles[groups[k]].push_back((unsigned int)t);
+				if (normalLength > 0.0)
+				{
+					glm::dvec3 unitNormal = normal / normalLength;
+					AddPlaneQuadric(state.quadrics[groups[k]], unitNormal, -glm::dot(unitNormal, p0), normalLength * 0.5);
+				}
+			}
+
+			for (int k = 0; k < 3; k++)
+			{
+				unsigned int a = groups[k];
+				unsigned int b = groups[(k + 1) % 3];
+				if (a != b)
+				{
+					edges.push_back(((unsigned long long)std::min(a, b) << 32) | std::max(a, b));
+				}
+			}
+		}
+
+		// an edge with one triangle is on an open border, and one with
+		// more than two joins separate sheets, and neither moves
+		state.locked.assign(vertexCount, 0);
+		std::sort(edges.begin(), edges.end());
+		size_t uniqueEdgeCount = 0;
+		for (size_t first = 0; first < edges.size(); )
+		{
+			size_t last = first + 1;
+			while ((last < edges.size()) && (edges[last] == edges[first]))
+			{
+				last++;
+			}
+			if (last - first != 2)
+			{
+				state.locked[(unsigned int)(edges[first] >> 32)] = 1;
+				state.locked[(unsigned int)(edges[first] & 0xFFFFFFFF)] = 1;
+			}
+			edges[uniqueEdgeCount++] = edges[first];
+			first = last;
+		}
+		edges.resize(uniqueEdgeCount);
+
+		state.attributeWeight = attributeWeight;
+		state.versions.assign(vertexCount, 0);
+		state.removed.assign(vertexCount, 0);
+
+		std::vector<COLLAPSE> queue;
+		queue.reserve(edges.size() * 2);
+		for (size_t i = 0; i < edges.size(); i++)
+		{
+			QueueEdge(state, queue, (unsigned int)(edges[i] >> 32), (unsigned int)(edges[i] & 0xFFFFFFFF));
+		}
+
+		size_t indexCount = triangleCount * 3;
+		double largestError = 0.0;
+		std::vector<unsigned int> neighbours;
+		while ((indexCount > targetIndexCount) && (queue.empty() == false))
+		{
+			std::pop_heap(queue.begin(), queue.end(), CollapseGreater);
+			COLLAPSE collapse = queue.back();
+			queue.pop_back();
+
+			unsigned int from = collapse.from;
+			unsigned int to = collapse.to;
+			if ((state.removed[from] != 0) || (state.removed[to] != 0) ||
+				(state.versions[from] != collapse.fromVersion) ||
+				(state.versions[to] != collapse.toVersion))
+			{
+				continue;
+			}
+
+			const QUADRIC& quadric = state.quadrics[from];
+			double error = (quadric.weight > 0.0) ?
+				sqrt(EvaluateQuadric(quadric, vertices[to].position) / quadric.weight) : 0.0;
+			if ((error > maxError) ||
+				(FindWedgeMap(state, from, to) == false) ||
+				(CollapseFolds(state, from, to) == true))
+			{
+				continue;
+			}
+
+			// triangles on the collapsed edge disappear, and the rest
+			// move their vertices onto the partners in the target group
+			std::vector<unsigned int>& targetList = state.groupTriangles[to];
+			std::vector<unsigned int>::iterator end = std::remove_if(targetList.begin(), targetList.end(),
+				[&state, from](unsigned int triangle)
+				{
+					return((state.triangleAlive[triangle] == 0) ||
+						(state.group[state.triangles[(size_t)triangle * 3]] == from) ||
+						(state.group[state.triangles[(size_t)triangle * 3 + 1]] == from) ||
+						(state.group[state.triangles[(size_t)triangle * 3 + 2]] == from));
+				});
+			targetList.erase(end, targetList.end());
+
+			const std::vector<unsigned int>& sourceList = state.groupTriangles[from];
+			for (size_t i = 0; i < sourceList.size(); i++)
+			{
+				unsigned int triangle = sourceList[i];
+				if (state.triangleAlive[triangle] == 0)
+				{
+					continue;
+				}
+				unsigned int* corners = &state.triangles[(size_t)triangle * 3];
+				if ((state.group[corners[0]] == to) ||
+					(state.group[corners[1]] == to) ||
+					(state.group[corners[2]] == to))
+				{
+					state.triangleAlive[triangle] = 0;
+					indexCount -= 3;
+					continue;
+				}
+				for (int k = 0; k < 3; k++)
+				{
+					for (size_t w = 0; w < state.wedgeMap.size(); w++)
+					{
+						if (corners[k] == state.wedgeMap[w].first)
+						{
+							corners[k] = state.wedgeMap[w].second;
+							break;
+						}
+					}
+				}
+				targetList.push_back(triangle);
+			}
+			state.groupTriangles[from].clear();
+
+			AddQuadric(state.quadrics[to], state.quadrics[from]);
+			state.removed[from] = 1;
+			state.versions[from]++;
+			state.versions[to]++;
+			largestError = std::max(largestError, error);
+
+			// the target group has a new quadric and new neighbours, so
+			// its collapses are queued again
+			neighbours.clear();
+			for (size_t i = 0; i < targetList.size(); i++)
+			{
+				const unsigned int* corners = &state.triangles[(size_t)targetList[i] * 3];
+				for (int k = 0; k < 3; k++)
+				{
+					unsigned int cornerGroup = state.group[corners[k]];
+					if (cornerGroup != to)
+					{
+						neighbours.push_back(cornerGroup);
+					}
+				}
+			}
+			std::sort(neighbours.begin(), neighbours.end());
+			neighbours.erase(std::unique(neighbours.begin(), neighbours.end()), neighbours.end());
+			for (size_t i = 0; i < neighbours.size(); i++)
+			{
+				QueueEdge(state, queue, to, neighbours[i]);
+			}
+		}
+
+		result.clear();
+		result.reserve(indexCount);
+		for (size_t t = 0; t < triangleCount; t++)
+		{
+			if (state.triangleAlive[t] != 0)
+			{
+				result.insert(result.end(), &state.triangles[t * 3], &state.triangles[t * 3] + 3);
+			}
+		}
+		return((float)largestError);
+	}
+
+	/***********************************************************
+	 *  SimplifyUsedVertices()
+	 *
+	 *  This function is used to simplify a set of triangles
+	 *  that may only use some of the vertices.  The vertices
+	 *  they use are copied out first, so the working state is
+	 *  sized by the triangles rather than by the whole mesh.
+	 ***********************************************************/
+	float SimplifyUsedVertices(
+		const std::vector<MeshImporter::MESH_VERTEX>& vertices,
+		const std::vector<unsigned int>& indices,
+		size_t targetIndexCount,
+		float maxError,
+		double attributeWeight,
+		std::vector<unsigned int>& result)
+	{
+		if (indices.size() <= targetIndexCount)
+		{
+			result = indices;
+			return(0.0f);
+		}
+
+		std::vector<unsigned int> usedVertices(indices);
+		std::sort(usedVertices.begin(), usedVertices.end());
+		usedVertices.erase(std::unique(usedVertices.begin(), usedVertices.end()), usedVertices.end());
+
+		std::vector<MeshImporter::MESH_VERTEX> localVertices(usedVertices.size());
+		for (size_t i = 0; i < usedVertices.size(); i++)
+		{
+			localVertices[i] = vertices[usedVertices[i]];
+		}
+		std::vector<unsigned int> localIndices(indices.size());
+		for (size_t i = 0; i < indices.size(); i++)
+		{
+			localIndices[i] = (unsigned int)(std::lower_bound(
+				usedVertices.begin(), usedVertices.end(), indices[i]) - usedVertices.begin());
+		}
+
+		float error = SimplifyMesh(localVertices, localIndices, targetIndexCount, maxError, attributeWeight, result);
+		for (size_t i = 0; i < result.size(); i++)
+		{
+			result[i] = usedVertices[result[i]];
+		}
+		return(error);
+	}
+
+	/***********************************************************
+	 *  SimplifyChunks()
+	 *
+	 *  This function is used to simplify one chunk of a level
+	 *  after another until every chunk of the job is taken.
+	 ***********************************************************/
+	void SimplifyChunks(CHUNK_JOB* pJob)
+	{
+		std::vector<unsigned int> chunkIndices;
+		int chunkCount = (int)pJob->chunkStarts.size() - 1;
+		for (int chunk = pJob->nextChunk++; chunk < chunkCount; chunk = pJob->nextChunk++)
+		{
+			chunkIndices.clear();
+			for (size_t i = pJob->chunkStarts[chunk]; i < pJob->chunkStarts[chunk + 1]; i++)
+			{
+				const unsigned int* corners = &(*pJob->pIndices)[(size_t)pJob->triangleOrder[i] * 3];
+				chunkIndices.insert(chunkIndices.end(), corners, corners + 3);
+			}
+			size_t targetIndexCount = (size_t)(chunkIndices.size() * pJob->reduction) / 3 * 3;
+			pJob->chunkErrors[chunk] = SimplifyUsedVertices(
+				*pJob->pVertices,
+				chunkIndices,
+				targetIndexCount,
+				pJob->maxError,
+				pJob->attributeWeight,
+				pJob->chunkIndices[chunk]);
+		}
+	}
+
+	/***********************************************************
+	 *  SimplifyLevel()
+	 *
+	 *  This function is used to simplify a detail level on the
+	 *  passed in number of threads.  The triangles are sorted
+	 *  along a Morton curve through their centers and cut into
+	 *  one compact chunk for each thread.  Each chunk sees the
+	 *  edges it shares with the other chunks as an open border
+	 *  and leaves them in place, so the chunks are simplified a
+	 *  little less than asked, and a last pass over the joined
+	 *  chunks collapses along their seams.
+	 ***********************************************************/
+	float SimplifyLevel(
+		const std::vector<MeshImporter::MESH_VERTEX>& vertices,
+		const std::vector<unsigned int>& indices,
+		size_t targetIndexCount,
+		float maxError,
+		double attributeWeight,
+		int threadCount,
+		std::vector<unsigned int>& result)
+	{
+		size_t triangleCount = indices.size() / 3;
+		if ((threadCount <= 1) || (triangleCount < MIN_PARALLEL_TRIANGLES))
+		{
+			return(SimplifyUsedVertices(vertices, indices, targetIndexCount, maxError, attributeWeight, result));
+		}
+
+		glm::vec3 boundsMin = vertices[indices[0]].position;
+		glm::vec3 boundsMax = boundsMin;
+		for (size_t i = 1; i < triangleCount * 3; i++)
+		{
+			boundsMin = glm::min(boundsMin, vertices[indices[i]].position);
+			boundsMax = glm::max(boundsMax, vertices[indices[i]].position);
+		}
+		glm::vec3 scale = glm::vec3(1023.0f) / glm::max(boundsMax - boundsMin, glm::vec3(1.0e-20f));
+
+		std::vector<std::pair<unsigned int, unsigned int> > codes(triangleCount);
+		for (size_t t = 0; t < triangleCount; t++)
+		{
+			glm::vec3 center = (vertices[indices[t * 3]].position +
+				vertices[indices[t * 3 + 1]].position +
+				vertices[indices[t * 3 + 2]].position) / 3.0f;
+			glm::vec3 cell = (center - boundsMin) * scale;
+			codes[t].first = MortonCode((unsigned int)cell.x, (unsigned int)cell.y, (unsigned int)cell.z);
+			codes[t].second = (unsigned int)t;
+		}
+		std::sort(codes.begin(), codes.end());
+
+		CHUNK_JOB job;
+		job.pVertices = &vertices;
+		job.pIndices = &indices;
+		job.triangleOrder.resize(triangleCount);
+		for (size_t t = 0; t < triangleCount; t++)
+		{
+			job.triangleOrder[t] = codes[t].second;
+		}
+		for (int chunk = 0; chunk <= threadCount; chunk++)
+		{
+			job.chunkStarts.push_back(triangleCount * chunk / threadCount);
+		}
+		job.reduction = std::min(1.0f, (float)targetIndexCount / indices.size() * (1.0f + CHUNK_SLACK));
+		job.maxError = maxError;
+		job.attributeWeight = attributeWeight;
+		job.chunkIndices.resize(threadCount);
+		job.chunkErrors.resize(threadCount);
+		job.nextChunk = 0;
+
+		std::vector<std::thread> workers;
+		for (int t = 1; t < threadCount; t++)
+		{
+			workers.push_back(std::thread(SimplifyChunks, &job));
+		}
+		SimplifyChunks(&job);
+		for (size_t t = 0; t < workers.size(); t++)
+		{
+			workers[t].join();
+		}
+
+		float error = 0.0f;
+		std::vector<unsigned int> joined;
+		for (int chunk = 0; chunk < threadCount; chunk++)
+		{
+			joined.insert(joined.end(), job.chunkIndices[chunk].begin(), job.chunkIndices[chunk].end());
+			error = std::max(error, job.chunkErrors[chunk]);
+		}
+		return(std::max(error, SimplifyUsedVertices(
+			vertices, joined, targetIndexCount, maxError, attributeWeight, result)));
+	}
+}
+
+/***********************************************************
+ *  Simplify()
+ *
+ *  This method is used for simplifying a triangle mesh on
+ *  the calling thread.
+ ***********************************************************/
+float MeshSimplifier::Simplify(
+	const std::vector<MeshImporter::MESH_VERTEX>& vertices,
+	const std::vector<unsigned int>& indices,
+	size_t targetIndexCount,
+	float maxError,
+	std::vector<unsigned int>& result)
+{
+	if (indices.empty() == true)
+	{
+		result.clear();
+		return(0.0f);
+	}
+
+	glm::vec3 boundsMin = vertices[indices[0]].position;
+	glm::vec3 boundsMax = boundsMin;
+	for (size_t i = 1; i < indices.size(); i++)
+	{
+		boundsMin = glm::min(boundsMin, vertices[indices[i]].position);
+		boundsMax = glm::max(boundsMax, vertices[indices[i]].position);
+	}
+	double attributeDistance = ATTRIBUTE_WEIGHT * glm::length(boundsMax - boundsMin);
+	return(SimplifyUsedVertices(vertices, indices, targetIndexCount, maxError,
+		attributeDistance * attributeDistance, result));
+}
+
+/***********************************************************
+ *  BuildLODChain()
+ *
+ *  This method is used for building the detail levels of a
+ *  mesh.  Each level is simplified from the level before it,
+ *  with the large levels split across the worker threads.
+ *  The indices of the levels are added after the full mesh's
+ *  indices, and the error of each level adds the errors of
+ *  the levels it was made from, so the errors only grow
+ *  along the chain.  The chain ends when a level no longer
+ *  shrinks enough or its error would be too large.
+ ***********************************************************/
+void MeshSimplifier::BuildLODChain(MeshImporter::MESH_DATA& mesh, int threadCount)
+{
+	// start again from the full mesh when it already has levels
+	if (mesh.lods.empty() == false)
+	{
+		mesh.indices.resize(mesh.lods[0].indexCount);
+	}
+	mesh.lods.clear();
+	MeshImporter::MESH_LOD fullLevel;
+	fullLevel.indexOffset = 0;
+	fullLevel.indexCount = (unsigned int)mesh.indices.size();
+	fullLevel.error = 0.0f;
+	fullLevel.meshletOffset = 0;
+	fullLevel.meshletCount = 0;
+	mesh.lods.push_back(fullLevel);
+
+	if (threadCount <= 0)
+	{
+		threadCount = std::max(1, (int)std::thread::hardware_concurrency());
+	}
+	float maxError = MAX_LOD_ERROR * glm::length(mesh.boundsMax - mesh.boundsMin);
+	double attributeDistance = ATTRIBUTE_WEIGHT * glm::length(mesh.boundsMax - mesh.boundsMin);
+	double attributeWeight = attributeDistance * attributeDistance;
+
+	std::vector<unsigned int> levelIndices(mesh.indices);
+	std::vector<unsigned int> simplified;
+	while ((int)mesh.lods.size() < MAX_LOD_COUNT)
+	{
+		const MeshImporter::MESH_LOD previous = mesh.lods.back();
+		size_t targetIndexCount = (size_t)(previous.indexCount * LOD_REDUCTION) / 3 * 3;
+		if ((targetIndexCount / 3 < MIN_LOD_TRIANGLES) || (previous.error >= maxError))
+		{
+			break;
+		}
+
+		float levelError = SimplifyLevel(mesh.vertices, levelIndices, targetIndexCount,
+			maxError - previous.error, attributeWeight, threadCount, simplified);
+		if ((simplified.empty() == true) ||
+			(simplified.size() > previous.indexCount * MIN_LOD_REDUCTION))
+		{
+			break;
+		}
+
+		MeshImporter::MESH_LOD lod;
+		lod.indexOffset = (unsigned int)mesh.indices.size();
+		lod.indexCount = (unsigned int)simplified.size();
+		lod.error = previous.error + levelError;
+		lod.meshletOffset = 0;
+		lod.meshletCount = 0;
+		mesh.indices.insert(mesh.indices.end(), simplified.begin(), simplified.end());
+		mesh.lods.push_back(lod);
+		levelIndices.swap(simplified);
+	}
+
+	std::cout << "INFO: Built " << mesh.lods.size() << " detail levels from "
+		<< fullLevel.indexCount / 3 << " triangles:";
+	for (size_t level = 1; level < mesh.lods.size(); level++)
+	{
+		std::cout << " " << mesh.lods[level].indexCount / 3;
+	}
+	std::cout << std::endl;
+}
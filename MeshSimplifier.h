@@ -0,0 +1,54 @@
+///////////////////////////////////////////////////////////////////////////////
+// meshsimplifier.h
+// ============
+// reduce the triangles of imported meshes with quadric error metrics,
+// building the chain of detail levels that are drawn at a distance
+//
+//  Created for CS-330-Computational Graphics and Visualization
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "MeshImporter.h"
+
+#include <vector>
+
+/***********************************************************
+ *  MeshSimplifier
+ *
+ *  This class contains the code for simplifying an indexed
+ *  triangle mesh by collapsing edges in the order of their
+ *  quadric error.  Each collapse moves one vertex onto a
+ *  neighbour that it shares an edge with, so the simplified
+ *  triangles only index vertices of the original mesh and
+ *  every detail level shares one vertex buffer.
+ *
+ *  Vertices split along a seam, with the same position but
+ *  different normals or texture coordinates, are collapsed
+ *  together and only along the seam, and vertices on an open
+ *  border are never moved, which keeps the outline and the
+ *  texture mapping of the mesh in place.  Large meshes are
+ *  cut into compact chunks that are simplified on separate
+ *  threads before a last pass joins them.
+ ***********************************************************/
+class MeshSimplifier
+{
+public:
+	// most detail levels built for a mesh, including the full one
+	static const int MAX_LOD_COUNT = 6;
+
+	// simplify the triangles until no more than the target number
+	// of indices are left, collapsing no edge with a larger error
+	// than maxError.  returns the largest error of the collapses
+	static float Simplify(
+		const std::vector<MeshImporter::MESH_VERTEX>& vertices,
+		const std::vector<unsigned int>& indices,
+		size_t targetIndexCount,
+		float maxError,
+		std::vector<unsigned int>& result);
+
+	// add the chain of detail levels to the indices of a mesh, each
+	// with about half the triangles of the one before.  zero
+	// threads uses one thread per CPU core
+	static void BuildLODChain(MeshImporter::MESH_DATA& mesh, int threadCount);
+};
@@ -0,0 +1,338 @@
+///////////////////////////////////////////////////////////////////////////////
+// meshletbuilder.cpp
+// ============
+// split the detail levels of imported meshes into small clusters of
+// triangles, and cull the clusters against the view before drawing
+//
+//  Created for CS-330-Computational Graphics and Visualization
+///////////////////////////////////////////////////////////////////////////////
+
+#include "MeshletBuilder.h"
+
+#include <algorithm>
+#include <cmath>
+
+// declaration of the global variables and defines
+namespace
+{
+	// marks a vertex that is not in the meshlet being built
+	const unsigned int NO_MESHLET = 0xFFFFFFFF;
+
+	/***********************************************************
+	 *  ComputeMeshletBounds()
+	 *
+	 *  This function is used to fit the bounding sphere and the
+	 *  normal cone of a meshlet.  The sphere is centered on the
+	 *  box around the vertices.  The cone axis is the average of
+	 *  the triangle normals, and the cone cannot cull anything
+	 *  when a triangle faces 90 degrees or more from the axis.
+	 ***********************************************************/
+	void ComputeMeshletBounds(
+		const std::vector<MeshImporter::MESH_VERTEX>& vertices,
+		const unsigned int* indices,
+		MeshImporter::MESHLET& meshlet)
+	{
+		glm::vec3 boundsMin = vertices[indices[0]].position;
+		glm::vec3 boundsMax = boundsMin;
+		for (unsigned int i = 1; i < meshlet.indexCount; i++)
+		{
+			boundsMin = glm::min(boundsMin, vertices[indices[i]].position);
+			boundsMax = glm::max(boundsMax, vertices[indices[i]].position);
+		}
+		meshlet.center = (boundsMin + boundsMax) * 0.5f;
+		float radiusSquared = 0.0f;
+		for (unsigned int i = 0; i < meshlet.indexCount; i++)
+		{
+			glm::vec3 offset = vertices[indices[i]].position - meshlet.center;
+			radiusSquared = std::max(radiusSquared, glm::dot(offset, offset));
+		}
+		meshlet.radius = sqrt(radiusSquared);
+
+		std::vector<glm::vec3> normals;
+		normals.reserve(meshlet.indexCount / 3);
+		glm::vec3 axis(0.0f);
+		for (unsigned int i = 0; i + 2 < meshlet.indexCount; i += 3)
+		{
+			const glm::vec3& a = vertices[indices[i]].position;
+			glm::vec3 normal = glm::cross(
+				vertices[indices[i + 1]].position - a,
+				vertices[indices[i + 2]].position - a);
+			float normalLength = glm::length(normal);
+			if (normalLength > 0.0f)
+			{
+				normals.push_back(normal / normalLength);
+				axis += normals.back();
+			}
+		}
+
+		meshlet.coneAxis = glm::vec3(0.0f, 1.0f, 0.0f);
+		meshlet.coneCutoff = 1.0f;
+		float axisLength = glm::length(axis);
+		if ((normals.empty() == true) || (axisLength <= 0.0f))
+		{
+			return;
+		}
+		axis /= axisLength;
+
+		float minimumCosine = 1.0f;
+		for (size_t i = 0; i < normals.size(); i++)
+		{
+			minimumCosine = std::min(minimumCosine, glm::dot(axis, normals[i]));
+		}
+		meshlet.coneAxis = axis;
+		if (minimumCosine > 0.0f)
+		{
+			meshlet.coneCutoff = sqrt(1.0f - minimumCosine * minimumCosine);
+		}
+	}
+
+	/***********************************************************
+	 *  BuildLevelMeshlets()
+	 *
+	 *  This function is used to split a range of triangles into
+	 *  meshlets and reorder the range to match.  Each meshlet
+	 *  grows from a seed triangle by taking the neighbouring
+	 *  triangle that adds the fewest new vertices, until it is
+	 *  full.  The next meshlet is seeded from a neighbour left
+	 *  over by the last one, so consecutive meshlets stay close
+	 *  together.
+	 ***********************************************************/
+	void BuildLevelMeshlets(
+		const std::vector<MeshImporter::MESH_VERTEX>& vertices,
+		unsigned int* indices,
+		unsigned int indexOffset,
+		unsigned int indexCount,
+		std::vector<MeshImporter::MESHLET>& meshlets)
+	{
+		size_t triangleCount = indexCount / 3;
+		size_t vertexCount = vertices.size();
+
+		// triangles around each vertex, stored one vertex after another
+		std::vector<unsigned int> adjacencyStart(vertexCount + 1, 0);
+		for (size_t i = 0; i < triangleCount * 3; i++)
+		{
+			adjacencyStart[indices[i] + 1]++;
+		}
+		for (size_t v = 0; v < vertexCount; v++)
+		{
+			adjacencyStart[v + 1] += adjacencyStart[v];
+		}
+		std::vector<unsigned int> adjacency(triangleCount * 3);
+		std::vector<unsigned int> fill(adjacencyStart.begin(), adjacencyStart.end() - 1);
+		for (size_t i = 0; i < triangleCount * 3; i++)
+		{
+			adjacency[fill[indices[i]]++] = (unsigned int)(i / 3);
+		}
+
+		std::vector<char> triangleUsed(triangleCount, 0);
+		std::vector<unsigned int> vertexMeshlet(vertexCount, NO_MESHLET);
+		std::vector<unsigned int> reordered;
+		reordered.reserve(triangleCount * 3);
+		std::vector<unsigned int> candidates;
+		size_t nextSeed = 0;
+		unsigned int meshletId = 0;
+
+		while (reordered.size() < triangleCount * 3)
+		{
+			// seed from a leftover neighbour of the last meshlet, or
+			// from the first unused triangle
+			size_t seed = triangleCount;
+			for (size_t i = 0; i < candidates.size(); i++)
+			{
+				if (triangleUsed[candidates[i]] == 0)
+				{
+					seed = candidates[i];
+					break;
+				}
+			}
+			if (seed == triangleCount)
+			{
+				while (triangleUsed[nextSeed] != 0)
+				{
+					nextSeed++;
+				}
+				seed = nextSeed;
+			}
+
+			MeshImporter::MESHLET meshlet;
+			meshlet.indexOffset = indexOffset + (unsigned int)reordered.size();
+			unsigned int meshletVertices = 0;
+			unsigned int meshletTriangles = 0;
+			candidates.clear();
+
+			size_t triangle = seed;
+			while (triangle != triangleCount)
+			{
+				triangleUsed[triangle] = 1;
+				meshletTriangles++;
+				for (int k = 0; k < 3; k++)
+				{
+					unsigned int vertex = indices[triangle * 3 + k];
+					reordered.push_back(vertex);
+					if (vertexMeshlet[vertex] != meshletId)
+					{
+						vertexMeshlet[vertex] = meshletId;
+						meshletVertices++;
+						candidates.insert(candidates.end(),
+							adjacency.begin() + adjacencyStart[vertex],
+							adjacency.begin() + adjacencyStart[vertex + 1]);
+					}
+				}
+				if (meshletTriangles >= MeshletBuilder::MAX_TRIANGLES)
+				{
+					break;
+				}
+
+				// take the unused neighbour that adds the fewest vertices,
+				// dropping the used triangles from the candidates
+				triangle = triangleCount;
+				unsigned int fewestNewVertices = 4;
+				size_t kept = 0;
+				for (size_t i = 0; i < candidates.size(); i++)
+				{
+					unsigned int candidate = candidates[i];
+					if (triangleUsed[candidate] != 0)
+					{
+						continue;
+					}
+					candidates[kept++] = candidate;
+
+					unsigned int newVertices = 0;
+					for (int k = 0; k < 3; k++)
+					{
+						newVertices += (vertexMeshlet[indices[candidate * 3 + k]] != meshletId) ? 1 : 0;
+					}
+					if ((newVertices < fewestNewVertices) &&
+						(meshletVertices + newVertices <= MeshletBuilder::MAX_VERTICES))
+					{
+						fewestNewVertices = newVertices;
+						triangle = candidate;
+					}
+				}
+				candidates.resize(kept);
+			}
+
+			meshlet.indexCount = indexOffset + (unsigned int)reordered.size() - meshlet.indexOffset;
+			ComputeMeshletBounds(vertices, &reordered[meshlet.indexOffset - indexOffset], meshlet);
+			meshlets.push_back(meshlet);
+			meshletId++;
+		}
+
+		std::copy(reordered.begin(), reordered.end(), indices);
+	}
+}
+
+/***********************************************************
+ *  BuildMeshlets()
+ *
+ *  This method is used for splitting each detail level of a
+ *  mesh into meshlets.  The meshlets of all the levels are
+ *  kept in one list, and each level records its range.
+ ***********************************************************/
+void MeshletBuilder::BuildMeshlets(MeshImporter::MESH_DATA& mesh)
+{
+	mesh.meshlets.clear();
+	for (size_t level = 0; level < mesh.lods.size(); level++)
+	{
+		MeshImporter::MESH_LOD& lod = mesh.lods[level];
+		lod.meshletOffset = (unsigned int)mesh.meshlets.size();
+		if (lod.indexCount >= 3)
+		{
+			BuildLevelMeshlets(mesh.vertices, &mesh.indices[lod.indexOffset],
+				lod.indexOffset, lod.indexCount / 3 * 3, mesh.meshlets);
+		}
+		lod.meshletCount = (unsigned int)mesh.meshlets.size() - lod.meshletOffset;
+	}
+}
+
+/***********************************************************
+ *  CullMeshlets()
+ *
+ *  This method is used for building the draw commands for
+ *  the visible meshlets.  The frustum planes are taken from
+ *  the rows of the combined matrix, so they are in the same
+ *  space as the meshlets and no bounds have to be moved.  A
+ *  meshlet faces away when the camera is far enough behind
+ *  its normal cone that every triangle in its bounding
+ *  sphere is seen from the back.  When several views are
+ *  drawn at once, a meshlet is kept when it is inside any
+ *  one of their frustums.
+ ***********************************************************/
+size_t MeshletBuilder::CullMeshlets(
+	const MeshImporter::MESHLET* meshlets,
+	size_t meshletCount,
+	const glm::mat4* modelViewProjections,
+	int viewCount,
+	const glm::vec3& viewPosition,
+	bool bCullBackfaces,
+	std::vector<MeshImporter::DRAW_COMMAND>& commands)
+{
+	std::vector<glm::vec4> planes(viewCount * 6);
+	for (int view = 0; view < viewCount; view++)
+	{
+		const glm::mat4& modelViewProjection = modelViewProjections[view];
+		glm::vec4* viewPlanes = &planes[view * 6];
+		for (int axis = 0; axis < 3; axis++)
+		{
+			glm::vec4 row(modelViewProjection[0][axis], modelViewProjection[1][axis],
+				modelViewProjection[2][axis], modelViewProjection[3][axis]);
+			glm::vec4 rowW(modelViewProjection[0][3], modelViewProjection[1][3],
+				modelViewProjection[2][3], modelViewProjection[3][3]);
+			viewPlanes[axis * 2] = rowW + row;
+			viewPlanes[axis * 2 + 1] = rowW - row;
+		}
+	}
+	for (size_t i = 0; i < planes.size(); i++)
+	{
+		float normalLength = glm::length(glm::vec3(planes[i]));
+		if (normalLength > 0.0f)
+		{
+			planes[i] /= normalLength;
+		}
+	}
+
+	size_t triangleCount = 0;
+	for (size_t i = 0; i < meshletCount; i++)
+	{
+		const MeshImporter::MESHLET& meshlet = meshlets[i];
+
+		bool bVisible = false;
+		for (int view = 0; (view < viewCount) && (bVisible == false); view++)
+		{
+			const glm::vec4* viewPlanes = &planes[view * 6];
+			bVisible = true;
+			for (int p = 0; (p < 6) && (bVisible == true); p++)
+			{
+				bVisible = (glm::dot(glm::vec3(viewPlanes[p]), meshlet.center) + viewPlanes[p].w >= -meshlet.radius);
+			}
+		}
+		if ((bVisible == true) && (bCullBackfaces == true))
+		{
+			glm::vec3 offset = meshlet.center - viewPosition;
+			bVisible = (glm::dot(offset, meshlet.coneAxis) <
+				meshlet.coneCutoff * glm::length(offset) + meshlet.radius);
+		}
+		if (bVisible == false)
+		{
+			continue;
+		}
+
+		// meshlets that follow each other in the index buffer are
+		// drawn with one command
+		triangleCount += meshlet.indexCount / 3;
+		if ((commands.empty() == false) &&
+			(commands.back().firstIndex + commands.back().count == meshlet.indexOffset))
+		{
+			commands.back().count += meshlet.indexCount;
+			continue;
+		}
+		MeshImporter::DRAW_COMMAND command;
+		command.count = meshlet.indexCount;
+		command.instanceCount = 1;
+		command.firstIndex = meshlet.indexOffset;
+		command.baseVertex = 0;
+		command.baseInstance = 0;
+		commands.push_back(command);
+	}
+	return(triangleCount);
+}
@@ -0,0 +1,54 @@
+///////////////////////////////////////////////////////////////////////////////
+// meshletbuilder.h
+// ============
+// split the detail levels of imported meshes into small clusters of
+// triangles, and cull the clusters against the view before drawing
+//
+//  Created for CS-330-Computational Graphics and Visualization
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "MeshImporter.h"
+
+#include <vector>
+
+/***********************************************************
+ *  MeshletBuilder
+ *
+ *  This class contains the code for grouping the triangles
+ *  of a mesh into meshlets of neighbouring triangles, each
+ *  using no more than MAX_VERTICES vertices and holding no
+ *  more than MAX_TRIANGLES triangles.  The indices of each
+ *  detail level are reordered so every meshlet is one range
+ *  of the index buffer.
+ *
+ *  Each meshlet keeps a bounding sphere for culling against
+ *  the view frustum, and a cone around the normals of its
+ *  triangles for culling the meshlets that face away from
+ *  the camera.  The visible meshlets become indirect draw
+ *  commands, with neighbouring ranges joined into one.
+ ***********************************************************/
+class MeshletBuilder
+{
+public:
+	// most vertices and triangles in one meshlet
+	static const unsigned int MAX_VERTICES = 64;
+	static const unsigned int MAX_TRIANGLES = 124;
+
+	// split every detail level of a mesh into meshlets
+	static void BuildMeshlets(MeshImporter::MESH_DATA& mesh);
+
+	// add draw commands for the meshlets that are inside any of
+	// the views and, when bCullBackfaces is true, that face the
+	// camera.  the view position is in the same space as the
+	// meshlets.  returns the number of triangles in the commands
+	static size_t CullMeshlets(
+		const MeshImporter::MESHLET* meshlets,
+		size_t meshletCount,
+		const glm::mat4* modelViewProjections,
+		int viewCount,
+		const glm::vec3& viewPosition,
+		bool bCullBackfaces,
+		std::vector<MeshImporter::DRAW_COMMAND>& commands);
+};
@@ -0,0 +1,277 @@
+///////////////////////////////////////////////////////////////////////////////
+// primitivemeshes.cpp
+// ============
+// generate the vertices and indices of the round basic shapes at compile
+// time, and draw them from buffers filled straight from that data
+//
+//  Created for CS-330-Computational Graphics and Visualization
+///////////////////////////////////////////////////////////////////////////////
+
+#include "PrimitiveMeshes.h"
+
+#include <cstddef>
+
+// declaration of the global variables and defines
+namespace
+{
+	// tessellation of each shape, more slices give rounder
+	// outlines and more stacks or sides give smoother shading
+	typedef SphereShape<48, 24> SPHERE;
+	typedef CylinderShape<48> CYLINDER;
+	typedef ConeShape<48> CONE;
+	typedef TorusShape<48, 16> TORUS;
+
+	// the shapes are built by the compiler and stored in the
+	// read only data of the executable
+	constexpr SPHERE::ARRAYS g_SphereArrays = SPHERE::Build();
+	constexpr CYLINDER::ARRAYS g_CylinderArrays = CYLINDER::Build();
+	constexpr CONE::ARRAYS g_ConeArrays = CONE::Build();
+	constexpr TORUS::ARRAYS g_TorusArrays = TORUS::Build();
+
+	static_assert(sizeof(ShapeTessellation::VERTEX) == sizeof(MeshImporter::MESH_VERTEX),
+		"the shape vertices must match the imported mesh vertices");
+	static_assert(offsetof(ShapeTessellation::VERTEX, normal) == offsetof(MeshImporter::MESH_VERTEX, normal),
+		"the shape normals must match the imported mesh normals");
+	static_assert(offsetof(ShapeTessellation::VERTEX, textureCoordinate) ==
+		offsetof(MeshImporter::MESH_VERTEX, textureCoordinate),
+		"the shape texture coordinates must match the imported mesh texture coordinates");
+
+	/***********************************************************
+	 *  ClearMesh()
+	 *
+	 *  This function is used to mark a mesh as having no
+	 *  OpenGL buffers.
+	 ***********************************************************/
+	void ClearMesh(MeshImporter::GPU_MESH& mesh)
+	{
+		mesh.vertexArray = 0;
+		mesh.vertexBuffer = 0;
+		mesh.indexBuffer = 0;
+		mesh.indexCount = 0;
+	}
+}
+
+/***********************************************************
+ *  PrimitiveMeshes()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+PrimitiveMeshes::PrimitiveMeshes()
+{
+	ClearMesh(m_sphere);
+	ClearMesh(m_cylinder);
+	ClearMesh(m_cone);
+	ClearMesh(m_torus);
+}
+
+/***********************************************************
+ *  ~PrimitiveMeshes()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+PrimitiveMeshes::~PrimitiveMeshes()
+{
+	MeshImporter::DestroyMesh(m_sphere);
+	MeshImporter::DestroyMesh(m_cylinder);
+	MeshImporter::DestroyMesh(m_cone);
+	MeshImporter::DestroyMesh(m_torus);
+}
+
+/***********************************************************
+ *  LoadMeshes()
+ *
+ *  This method is used for creating the OpenGL buffers of
+ *  every shape.  Nothing is computed here, the buffers are
+ *  filled straight from the compiled arrays.
+ ***********************************************************/
+void PrimitiveMeshes::LoadMeshes()
+{
+	if (m_sphere.vertexArray != 0)
+	{
+		return;
+	}
+
+	MeshImporter::UploadMesh(
+		g_SphereArrays.vertices, SPHERE::VERTEX_COUNT,
+		g_SphereArrays.indices, SPHERE::INDEX_COUNT,
+		m_sphere);
+	MeshImporter::UploadMesh(
+		g_CylinderArrays.vertices, CYLINDER::VERTEX_COUNT,
+		g_CylinderArrays.indices, CYLINDER::INDEX_COUNT,
+		m_cylinder);
+	MeshImporter::UploadMesh(
+		g_ConeArrays.vertices, CONE::VERTEX_COUNT,
+		g_ConeArrays.indices, CONE::INDEX_COUNT,
+		m_cone);
+	MeshImporter::UploadMesh(
+		g_TorusArrays.vertices, TORUS::VERTEX_COUNT,
+		g_TorusArrays.indices, TORUS::INDEX_COUNT,
+		m_torus);
+}
+
+/***********************************************************
+ *  DrawSphereMesh()
+ *
+ *  This method is used for drawing the whole sphere, which
+ *  skips the disc at the start of its indices.
+ ***********************************************************/
+void PrimitiveMeshes::DrawSphereMesh() const
+{
+	DrawRange(m_sphere, SPHERE::DISC_INDEX_COUNT,
+		SPHERE::INDEX_COUNT - SPHERE::DISC_INDEX_COUNT);
+}
+
+/***********************************************************
+ *  DrawHalfSphereMesh()
+ *
+ *  This method is used for drawing the upper half of the
+ *  sphere, closed by the disc at the equator.
+ ***********************************************************/
+void PrimitiveMeshes::DrawHalfSphereMesh() const
+{
+	DrawRange(m_sphere, 0, SPHERE::HALF_INDEX_COUNT);
+}
+
+/***********************************************************
+ *  DrawCylinderMesh()
+ *
+ *  This method is used for drawing the cylinder with both
+ *  of its ends.
+ ***********************************************************/
+void PrimitiveMeshes::DrawCylinderMesh() const
+{
+	DrawRange(m_cylinder, 0, CYLINDER::INDEX_COUNT);
+}
+
+/***********************************************************
+ *  DrawConeMesh()
+ *
+ *  This method is used for drawing the cone with its base.
+ ***********************************************************/
+void PrimitiveMeshes::DrawConeMesh() const
+{
+	DrawRange(m_cone, 0, CONE::INDEX_COUNT);
+}
+
+/***********************************************************
+ *  DrawTorusMesh()
+ *
+ *  This method is used for drawing the whole torus.
+ ***********************************************************/
+void PrimitiveMeshes::DrawTorusMesh() const
+{
+	DrawRange(m_torus, 0, TORUS::INDEX_COUNT);
+}
+
+/***********************************************************
+ *  DrawHalfTorusMesh()
+ *
+ *  This method is used for drawing the half of the torus
+ *  above the X axis.
+ ***********************************************************/
+void PrimitiveMeshes::DrawHalfTorusMesh() const
+{
+	DrawRange(m_torus, 0, TORUS::HALF_INDEX_COUNT);
+}
+
+/***********************************************************
+ *  DrawRange()
+ *
+ *  This method is used for drawing a range of the indices
+ *  of a shape with the current shader program.
+ ***********************************************************/
+void PrimitiveMeshes::DrawRange(const MeshImporter::GPU_MESH& mesh, unsigned int indexOffset, unsigned int indexCount)
+{
+	if (mesh.vertexArray == 0)
+	{
+		return;
+	}
+
+	glBindVertexArray(mesh.vertexArray);
+	glDrawElements(GL_TRIANGLES, (GLsizei)indexCount, GL_UNSIGNED_INT,
+		(void*)(indexOffset * sizeof(unsigned int)));
+	glBindVertexArray(0);
+}
+
+/***********************************************************
+ *  GetShapeTriangles()
+ *
+ *  This method is used for copying the triangles of a shape
+ *  from the compiled arrays, covering the same range of
+ *  indices that the shape is drawn with.
+ ***********************************************************/
+void PrimitiveMeshes::GetShapeTriangles(SHAPE shape, std::vector<glm::vec3>& positions, std::vector<unsigned int>& indices)
+{
+	std::vector<MeshImporter::MESH_VERTEX> vertices;
+	GetShapeVertices(shape, vertices, indices);
+	positions.resize(vertices.size());
+	for (size_t i = 0; i < vertices.size(); i++)
+	{
+		positions[i] = vertices[i].position;
+	}
+}
+
+/***********************************************************
+ *  GetShapeVertices()
+ *
+ *  This method is used for copying the vertices and the
+ *  triangles of a shape from the compiled arrays, covering
+ *  the same range of indices that the shape is drawn with.
+ ***********************************************************/
+void PrimitiveMeshes::GetShapeVertices(SHAPE shape, std::vector<MeshImporter::MESH_VERTEX>& vertices, std::vector<unsigned int>& indices)
+{
+	switch (shape)
+	{
+	case SHAPE_SPHERE:
+		CopyRange(g_SphereArrays.vertices, SPHERE::VERTEX_COUNT, g_SphereArrays.indices,
+			SPHERE::DISC_INDEX_COUNT, SPHERE::INDEX_COUNT - SPHERE::DISC_INDEX_COUNT, vertices, indices);
+		break;
+	case SHAPE_HALF_SPHERE:
+		CopyRange(g_SphereArrays.vertices, SPHERE::VERTEX_COUNT, g_SphereArrays.indices,
+			0, SPHERE::HALF_INDEX_COUNT, vertices, indices);
+		break;
+	case SHAPE_CYLINDER:
+		CopyRange(g_CylinderArrays.vertices, CYLINDER::VERTEX_COUNT, g_CylinderArrays.indices,
+			0, CYLINDER::INDEX_COUNT, vertices, indices);
+		break;
+	case SHAPE_CONE:
+		CopyRange(g_ConeArrays.vertices, CONE::VERTEX_COUNT, g_ConeArrays.indices,
+			0, CONE::INDEX_COUNT, vertices, indices);
+		break;
+	case SHAPE_TORUS:
+		CopyRange(g_TorusArrays.vertices, TORUS::VERTEX_COUNT, g_TorusArrays.indices,
+			0, TORUS::INDEX_COUNT, vertices, indices);
+		break;
+	case SHAPE_HALF_TORUS:
+	default:
+		CopyRange(g_TorusArrays.vertices, TORUS::VERTEX_COUNT, g_TorusArrays.indices,
+			0, TORUS::HALF_INDEX_COUNT, vertices, indices);
+		break;
+	}
+}
+
+/***********************************************************
+ *  CopyRange()
+ *
+ *  This method is used for copying every vertex of a
+ *  shape and a range of its indices.  The vertices outside
+ *  the range are kept, so the indices need no remapping.
+ ***********************************************************/
+void PrimitiveMeshes::CopyRange(
+	const ShapeTessellation::VERTEX* vertices,
+	unsigned int vertexCount,
+	const unsigned int* indices,
+	unsigned int indexOffset,
+	unsigned int indexCount,
+	std::vector<MeshImporter::MESH_VERTEX>& rangeVertices,
+	std::vector<unsigned int>& rangeIndices)
+{
+	rangeVertices.resize(vertexCount);
+	for (unsigned int i = 0; i < vertexCount; i++)
+	{
+		rangeVertices[i].position = glm::vec3(vertices[i].position[0], vertices[i].position[1], vertices[i].position[2]);
+		rangeVertices[i].normal = glm::vec3(vertices[i].normal[0], vertices[i].normal[1], vertices[i].normal[2]);
+		rangeVertices[i].textureCoordinate = glm::vec2(vertices[i].textureCoordinate[0], vertices[i].textureCoordinate[1]);
+	}
+	rangeIndices.assign(indices + indexOffset, indices + indexOffset + indexCount);
+}
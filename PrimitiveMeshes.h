@@ -0,0 +1,464 @@
+///////////////////////////////////////////////////////////////////////////////
+// primitivemeshes.h
+// ============
+// generate the vertices and indices of the round basic shapes at compile
+// time, and draw them from buffers filled straight from that data
+//
+//  Created for CS-330-Computational Graphics and Visualization
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "MeshImporter.h"
+
+/***********************************************************
+ *  ShapeTessellation
+ *
+ *  This class contains the constexpr helpers shared by the
+ *  shape templates below.  The standard sin() and cos() are
+ *  not constexpr, so the angles are evaluated with a Taylor
+ *  series after moving them into -pi..pi.  Each template
+ *  evaluates one sine and cosine per slice, stack or ring,
+ *  not per vertex, which keeps the compile time evaluation
+ *  well inside the compiler's step limits.
+ ***********************************************************/
+class ShapeTessellation
+{
+public:
+	// a vertex with the same layout as an imported mesh vertex,
+	// built from plain arrays so it can be filled in a constexpr
+	// function
+	struct VERTEX
+	{
+		float position[3];
+		float normal[3];
+		float textureCoordinate[2];
+	};
+
+	static constexpr double PI = 3.14159265358979323846;
+
+	// sine of an angle in radians
+	static constexpr double Sine(double angle)
+	{
+		while (angle > PI)
+		{
+			angle -= 2.0 * PI;
+		}
+		while (angle < -PI)
+		{
+			angle += 2.0 * PI;
+		}
+		double term = angle;
+		double sum = angle;
+		for (int n = 1; n <= 11; n++)
+		{
+			term *= -angle * angle / ((2 * n) * (2 * n + 1));
+			sum += term;
+		}
+		return(sum);
+	}
+
+	// cosine of an angle in radians
+	static constexpr double Cosine(double angle)
+	{
+		return(Sine(angle + PI * 0.5));
+	}
+
+	// square root, for normalizing the slanted cone normals
+	static constexpr double SquareRoot(double value)
+	{
+		double root = (value > 1.0) ? value : 1.0;
+		for (int i = 0; i < 32; i++)
+		{
+			root = 0.5 * (root + value / root);
+		}
+		return(root);
+	}
+
+	// fill in every attribute of a vertex
+	static constexpr void SetVertex(
+		VERTEX& vertex,
+		double x, double y, double z,
+		double nx, double ny, double nz,
+		double u, double v)
+	{
+		vertex.position[0] = (float)x;
+		vertex.position[1] = (float)y;
+		vertex.position[2] = (float)z;
+		vertex.normal[0] = (float)nx;
+		vertex.normal[1] = (float)ny;
+		vertex.normal[2] = (float)nz;
+		vertex.textureCoordinate[0] = (float)u;
+		vertex.textureCoordinate[1] = (float)v;
+	}
+
+	// add the two triangles of a quad, with a b c d going
+	// counter clockwise around it seen from the front
+	static constexpr unsigned int AddQuad(
+		unsigned int* indices,
+		unsigned int count,
+		unsigned int a, unsigned int b, unsigned int c, unsigned int d)
+	{
+		indices[count++] = a;
+		indices[count++] = b;
+		indices[count++] = c;
+		indices[count++] = a;
+		indices[count++] = c;
+		indices[count++] = d;
+		return(count);
+	}
+
+	// add a flat disc of radius 1 at the height y, made from a
+	// center vertex and a ring of slices + 1 vertices, facing up
+	// or down.  returns the new index count
+	static constexpr unsigned int AddDisc(
+		VERTEX* vertices,
+		unsigned int firstVertex,
+		unsigned int* indices,
+		unsigned int count,
+		unsigned int slices,
+		double y,
+		bool bFacingUp)
+	{
+		double normalY = (bFacingUp == true) ? 1.0 : -1.0;
+		SetVertex(vertices[firstVertex], 0.0, y, 0.0, 0.0, normalY, 0.0, 0.5, 0.5);
+		for (unsigned int i = 0; i <= slices; i++)
+		{
+			double angle = 2.0 * PI * i / slices;
+			double x = Cosine(angle);
+			double z = -Sine(angle);
+			SetVertex(vertices[firstVertex + 1 + i], x, y, z,
+				0.0, normalY, 0.0, 0.5 + 0.5 * x, 0.5 - 0.5 * z * normalY);
+		}
+		for (unsigned int i = 0; i < slices; i++)
+		{
+			unsigned int ring = firstVertex + 1 + i;
+			indices[count++] = firstVertex;
+			indices[count++] = (bFacingUp == true) ? ring : ring + 1;
+			indices[count++] = (bFacingUp == true) ? ring + 1 : ring;
+		}
+		return(count);
+	}
+};
+
+/***********************************************************
+ *  SphereShape
+ *
+ *  A sphere of radius 1 around the origin, split into
+ *  SLICES around the Y axis and STACKS from the top pole to
+ *  the bottom one.  The indices start with a disc closing
+ *  the equator, then the upper half and the lower half, so
+ *  the half sphere and the whole sphere are each one range.
+ ***********************************************************/
+template<unsigned int SLICES, unsigned int STACKS>
+class SphereShape
+{
+public:
+	static_assert(SLICES >= 3, "a sphere needs at least 3 slices");
+	static_assert((STACKS >= 2) && (STACKS % 2 == 0), "a sphere needs an even number of stacks");
+
+	static const unsigned int GRID_VERTICES = (SLICES + 1) * (STACKS + 1);
+	static const unsigned int VERTEX_COUNT = GRID_VERTICES + SLICES + 2;
+	static const unsigned int DISC_INDEX_COUNT = 3 * SLICES;
+	static const unsigned int HALF_INDEX_COUNT = DISC_INDEX_COUNT + 3 * SLICES * (STACKS - 1);
+	static const unsigned int INDEX_COUNT = DISC_INDEX_COUNT + 6 * SLICES * (STACKS - 1);
+
+	struct ARRAYS
+	{
+		ShapeTessellation::VERTEX vertices[VERTEX_COUNT];
+		unsigned int indices[INDEX_COUNT];
+	};
+
+	static constexpr ARRAYS Build()
+	{
+		ARRAYS shape = {};
+		double sliceCosine[SLICES + 1] = {};
+		double sliceSine[SLICES + 1] = {};
+		for (unsigned int i = 0; i <= SLICES; i++)
+		{
+			sliceCosine[i] = ShapeTessellation::Cosine(2.0 * ShapeTessellation::PI * i / SLICES);
+			sliceSine[i] = -ShapeTessellation::Sine(2.0 * ShapeTessellation::PI * i / SLICES);
+		}
+		for (unsigned int j = 0; j <= STACKS; j++)
+		{
+			double angle = ShapeTessellation::PI * j / STACKS;
+			double y = ShapeTessellation::Cosine(angle);
+			double ring = ShapeTessellation::Sine(angle);
+			for (unsigned int i = 0; i <= SLICES; i++)
+			{
+				double x = ring * sliceCosine[i];
+				double z = ring * sliceSine[i];
+				ShapeTessellation::SetVertex(shape.vertices[j * (SLICES + 1) + i],
+					x, y, z, x, y, z, (double)i / SLICES, 1.0 - (double)j / STACKS);
+			}
+		}
+
+		unsigned int count = ShapeTessellation::AddDisc(
+			shape.vertices, GRID_VERTICES, shape.indices, 0, SLICES, 0.0, false);
+		for (unsigned int j = 0; j < STACKS; j++)
+		{
+			for (unsigned int i = 0; i < SLICES; i++)
+			{
+				unsigned int top = j * (SLICES + 1) + i;
+				unsigned int bottom = top + SLICES + 1;
+				// the quads touching a pole are single triangles
+				if (j != 0)
+				{
+					shape.indices[count++] = top;
+					shape.indices[count++] = bottom;
+					shape.indices[count++] = top + 1;
+				}
+				if (j != STACKS - 1)
+				{
+					shape.indices[count++] = top + 1;
+					shape.indices[count++] = bottom;
+					shape.indices[count++] = bottom + 1;
+				}
+			}
+		}
+		return(shape);
+	}
+};
+
+/***********************************************************
+ *  CylinderShape
+ *
+ *  A cylinder of radius 1 standing on the origin, 1 unit
+ *  high along the Y axis, split into SLICES around it.  The
+ *  sides and both ends are separate rings of vertices, so
+ *  each has its own normals.
+ ***********************************************************/
+template<unsigned int SLICES>
+class CylinderShape
+{
+public:
+	static_assert(SLICES >= 3, "a cylinder needs at least 3 slices");
+
+	static const unsigned int VERTEX_COUNT = 4 * (SLICES + 1) + 2;
+	static const unsigned int INDEX_COUNT = 12 * SLICES;
+
+	struct ARRAYS
+	{
+		ShapeTessellation::VERTEX vertices[VERTEX_COUNT];
+		unsigned int indices[INDEX_COUNT];
+	};
+
+	static constexpr ARRAYS Build()
+	{
+		ARRAYS shape = {};
+		for (unsigned int i = 0; i <= SLICES; i++)
+		{
+			double angle = 2.0 * ShapeTessellation::PI * i / SLICES;
+			double x = ShapeTessellation::Cosine(angle);
+			double z = -ShapeTessellation::Sine(angle);
+			double u = (double)i / SLICES;
+			ShapeTessellation::SetVertex(shape.vertices[i], x, 0.0, z, x, 0.0, z, u, 0.0);
+			ShapeTessellation::SetVertex(shape.vertices[SLICES + 1 + i], x, 1.0, z, x, 0.0, z, u, 1.0);
+		}
+
+		unsigned int count = ShapeTessellation::AddDisc(
+			shape.vertices, 2 * (SLICES + 1), shape.indices, 0, SLICES, 0.0, false);
+		for (unsigned int i = 0; i < SLICES; i++)
+		{
+			count = ShapeTessellation::AddQuad(shape.indices, count,
+				i, i + 1, SLICES + 2 + i, SLICES + 1 + i);
+		}
+		ShapeTessellation::AddDisc(
+			shape.vertices, 3 * (SLICES + 1) + 1, shape.indices, count, SLICES, 1.0, true);
+		return(shape);
+	}
+};
+
+/***********************************************************
+ *  ConeShape
+ *
+ *  A cone with a base of radius 1 on the origin and its tip
+ *  1 unit up the Y axis, split into SLICES around it.  The
+ *  tip has one vertex per slice, so the side normals stay
+ *  smooth up to the tip.  The indices start with the side
+ *  and end with the base.
+ ***********************************************************/
+template<unsigned int SLICES>
+class ConeShape
+{
+public:
+	static_assert(SLICES >= 3, "a cone needs at least 3 slices");
+
+	static const unsigned int VERTEX_COUNT = SLICES + 2 * (SLICES + 1) + 1;
+	static const unsigned int SIDE_INDEX_COUNT = 3 * SLICES;
+	static const unsigned int INDEX_COUNT = 6 * SLICES;
+
+	struct ARRAYS
+	{
+		ShapeTessellation::VERTEX vertices[VERTEX_COUNT];
+		unsigned int indices[INDEX_COUNT];
+	};
+
+	static constexpr ARRAYS Build()
+	{
+		ARRAYS shape = {};
+		// the side leans 45 degrees, so every normal is the
+		// outward direction and up in equal parts
+		const double normalScale = 1.0 / ShapeTessellation::SquareRoot(2.0);
+		for (unsigned int i = 0; i <= SLICES; i++)
+		{
+			double angle = 2.0 * ShapeTessellation::PI * i / SLICES;
+			double x = ShapeTessellation::Cosine(angle);
+			double z = -ShapeTessellation::Sine(angle);
+			ShapeTessellation::SetVertex(shape.vertices[SLICES + i], x, 0.0, z,
+				x * normalScale, normalScale, z * normalScale, (double)i / SLICES, 0.0);
+			if (i < SLICES)
+			{
+				double tipAngle = 2.0 * ShapeTessellation::PI * (i + 0.5) / SLICES;
+				ShapeTessellation::SetVertex(shape.vertices[i], 0.0, 1.0, 0.0,
+					ShapeTessellation::Cosine(tipAngle) * normalScale, normalScale,
+					-ShapeTessellation::Sine(tipAngle) * normalScale, (i + 0.5) / SLICES, 1.0);
+			}
+		}
+
+		unsigned int count = 0;
+		for (unsigned int i = 0; i < SLICES; i++)
+		{
+			shape.indices[count++] = SLICES + i;
+			shape.indices[count++] = SLICES + i + 1;
+			shape.indices[count++] = i;
+		}
+		ShapeTessellation::AddDisc(
+			shape.vertices, 2 * SLICES + 1, shape.indices, count, SLICES, 0.0, false);
+		return(shape);
+	}
+};
+
+/***********************************************************
+ *  TorusShape
+ *
+ *  A torus lying in the XY plane around the origin, with a
+ *  ring of radius 1 and a tube of radius 0.2.  RINGS split
+ *  the ring and SIDES split the tube.  The ring starts on
+ *  the X axis and goes up through Y first, so the upper
+ *  half of the torus is the first half of the indices.
+ ***********************************************************/
+template<unsigned int RINGS, unsigned int SIDES>
+class TorusShape
+{
+public:
+	static_assert((RINGS >= 4) && (RINGS % 2 == 0), "a torus needs an even number of rings");
+	static_assert(SIDES >= 3, "a torus needs at least 3 sides");
+
+	static const unsigned int VERTEX_COUNT = (RINGS + 1) * (SIDES + 1);
+	static const unsigned int HALF_INDEX_COUNT = 3 * RINGS * SIDES;
+	static const unsigned int INDEX_COUNT = 6 * RINGS * SIDES;
+
+	struct ARRAYS
+	{
+		ShapeTessellation::VERTEX vertices[VERTEX_COUNT];
+		unsigned int indices[INDEX_COUNT];
+	};
+
+	static constexpr ARRAYS Build()
+	{
+		const double tubeRadius = 0.2;
+		ARRAYS shape = {};
+		double sideCosine[SIDES + 1] = {};
+		double sideSine[SIDES + 1] = {};
+		for (unsigned int j = 0; j <= SIDES; j++)
+		{
+			sideCosine[j] = ShapeTessellation::Cosine(2.0 * ShapeTessellation::PI * j / SIDES);
+			sideSine[j] = ShapeTessellation::Sine(2.0 * ShapeTessellation::PI * j / SIDES);
+		}
+		for (unsigned int i = 0; i <= RINGS; i++)
+		{
+			double angle = 2.0 * ShapeTessellation::PI * i / RINGS;
+			double ringX = ShapeTessellation::Cosine(angle);
+			double ringY = ShapeTessellation::Sine(angle);
+			for (unsigned int j = 0; j <= SIDES; j++)
+			{
+				double nx = ringX * sideCosine[j];
+				double ny = ringY * sideCosine[j];
+				double nz = sideSine[j];
+				ShapeTessellation::SetVertex(shape.vertices[i * (SIDES + 1) + j],
+					ringX + nx * tubeRadius, ringY + ny * tubeRadius, nz * tubeRadius,
+					nx, ny, nz, (double)i / RINGS, (double)j / SIDES);
+			}
+		}
+
+		unsigned int count = 0;
+		for (unsigned int i = 0; i < RINGS; i++)
+		{
+			for (unsigned int j = 0; j < SIDES; j++)
+			{
+				unsigned int a = i * (SIDES + 1) + j;
+				count = ShapeTessellation::AddQuad(shape.indices, count,
+					a, a + SIDES + 1, a + SIDES + 2, a + 1);
+			}
+		}
+		return(shape);
+	}
+};
+
+/***********************************************************
+ *  PrimitiveMeshes
+ *
+ *  This class contains the code for drawing the sphere,
+ *  cylinder, cone and torus basic shapes from the arrays the
+ *  shape templates built at compile time.  The arrays are
+ *  constant data in the executable, so loading a shape only
+ *  copies them into its OpenGL buffers.  The tessellation of
+ *  each shape is set by the template arguments in the source
+ *  file.
+ ***********************************************************/
+class PrimitiveMeshes
+{
+public:
+	// the shapes that can be drawn
+	enum SHAPE
+	{
+		SHAPE_SPHERE = 0,
+		SHAPE_HALF_SPHERE,
+		SHAPE_CYLINDER,
+		SHAPE_CONE,
+		SHAPE_TORUS,
+		SHAPE_HALF_TORUS
+	};
+
+	// constructor
+	PrimitiveMeshes();
+	// destructor
+	~PrimitiveMeshes();
+
+	// create the OpenGL buffers for every shape
+	void LoadMeshes();
+
+	// draw the shapes with the current shader program
+	void DrawSphereMesh() const;
+	void DrawHalfSphereMesh() const;
+	void DrawCylinderMesh() const;
+	void DrawConeMesh() const;
+	void DrawTorusMesh() const;
+	void DrawHalfTorusMesh() const;
+
+	// copy the positions and triangle indices of the part of a
+	// shape that is drawn, for work on the CPU such as picking
+	static void GetShapeTriangles(SHAPE shape, std::vector<glm::vec3>& positions, std::vector<unsigned int>& indices);
+	// copy the vertices and triangle indices of the part of a shape
+	// that is drawn, for drawing it on the CPU
+	static void GetShapeVertices(SHAPE shape, std::vector<MeshImporter::MESH_VERTEX>& vertices, std::vector<unsigned int>& indices);
+
+private:
+	MeshImporter::GPU_MESH m_sphere;
+	MeshImporter::GPU_MESH m_cylinder;
+	MeshImporter::GPU_MESH m_cone;
+	MeshImporter::GPU_MESH m_torus;
+
+	// draw a range of the indices of a shape
+	static void DrawRange(const MeshImporter::GPU_MESH& mesh, unsigned int indexOffset, unsigned int indexCount);
+	// copy a range of the indices of a shape and its vertices
+	static void CopyRange(
+		const ShapeTessellation::VERTEX* vertices,
+		unsigned int vertexCount,
+		const unsigned int* indices,
+		unsigned int indexOffset,
+		unsigned int indexCount,
+		std::vector<MeshImporter::MESH_VERTEX>& rangeVertices,
+		std::vector<unsigned int>& rangeIndices);
+};
@@ -0,0 +1,308 @@
+///////////////////////////////////////////////////////////////////////////////
+// programbinarycache.cpp
+// ============
+// store linked shader programs on disk and reload them on the next
+// start instead of compiling the GLSL source again
+//
+//  Created for CS-330-Computational Graphics and Visualization
+///////////////////////////////////////////////////////////////////////////////
+
+#include "ProgramBinaryCache.h"
+
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <vector>
+
+#ifdef _WIN32
+#include <direct.h>
+#else
+#include <sys/stat.h>
+#include <sys/types.h>
+#endif
+
+// declaration of the global variables and defines
+namespace
+{
+	// identifies a program binary file written by this class
+	const unsigned int BINARY_FILE_MAGIC = 0x42505347;	// "GSPB"
+	// increase when the layout of the binary files changes
+	const unsigned int BINARY_FILE_VERSION = 1;
+
+	// FNV-1a hash constants
+	const unsigned long long HASH_OFFSET = 14695981039346656037ULL;
+	const unsigned long long HASH_PRIME = 1099511628211ULL;
+
+	// header written at the start of each binary file
+	struct BINARY_FILE_HEADER
+	{
+		unsigned int magic;
+		unsigned int version;
+		unsigned long long key;
+		unsigned int format;
+		unsigned int length;
+	};
+
+	/***********************************************************
+	 *  HashString()
+	 *
+	 *  This function is used to add a string into a running
+	 *  FNV-1a hash.
+	 ***********************************************************/
+	unsigned long long HashString(unsigned long long hash, const std::string& text)
+	{
+		for (size_t i = 0; i < text.size(); i++)
+		{
+			hash ^= (unsigned char)text[i];
+			hash *= HASH_PRIME;
+		}
+		// separate consecutive strings so that moving characters
+		// between them changes the hash
+		hash ^= 0xFF;
+		hash *= HASH_PRIME;
+		return(hash);
+	}
+
+	/***********************************************************
+	 *  GetDriverString()
+	 *
+	 *  This function is used to read one of the driver
+	 *  identification strings.
+	 ***********************************************************/
+	std::string GetDriverString(GLenum name)
+	{
+		const GLubyte* value = glGetString(name);
+		if (value == NULL)
+		{
+			return(std::string());
+		}
+		return(std::string((const char*)value));
+	}
+}
+
+/***********************************************************
+ *  ProgramBinaryCache()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+ProgramBinaryCache::ProgramBinaryCache()
+{
+	m_driverHash = HASH_OFFSET;
+	m_bAvailable = false;
+}
+
+/***********************************************************
+ *  ~ProgramBinaryCache()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+ProgramBinaryCache::~ProgramBinaryCache()
+{
+}
+
+/***********************************************************
+ *  Initialize()
+ *
+ *  This method is used for setting the directory that the
+ *  program binaries are stored in.  The cache is disabled
+ *  when the driver offers no binary formats, which is
+ *  allowed even when the extension is supported.
+ ***********************************************************/
+bool ProgramBinaryCache::Initialize(const char* directory)
+{
+	m_bAvailable = false;
+
+	if (!GLEW_ARB_get_program_binary)
+	{
+		std::cout << "INFO: Program binaries are not supported, shaders are compiled from source" << std::endl;
+		return(false);
+	}
+
+	GLint formatCount = 0;
+	glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formatCount);
+	if (formatCount <= 0)
+	{
+		std::cout << "INFO: No program binary formats, shaders are compiled from source" << std::endl;
+		return(false);
+	}
+
+	m_directory = directory;
+#ifdef _WIN32
+	_mkdir(directory);
+#else
+	mkdir(directory, 0755);
+#endif
+
+	// a binary is only valid for the driver that created it
+	m_driverHash = HASH_OFFSET;
+	m_driverHash = HashString(m_driverHash, GetDriverString(GL_VENDOR));
+	m_driverHash = HashString(m_driverHash, GetDriverString(GL_RENDERER));
+	m_driverHash = HashString(m_driverHash, GetDriverString(GL_VERSION));
+
+	m_bAvailable = true;
+	return(true);
+}
+
+/***********************************************************
+ *  IsAvailable()
+ *
+ *  This method is used for checking whether program
+ *  binaries can be loaded and stored.
+ ***********************************************************/
+bool ProgramBinaryCache::IsAvailable() const
+{
+	return(m_bAvailable);
+}
+
+/***********************************************************
+ *  MakeKey()
+ *
+ *  This method is used for building the cache key for a
+ *  program from its complete shader source and the driver.
+ ***********************************************************/
+unsigned long long ProgramBinaryCache::MakeKey(
+	const std::string& vertexSource,
+	const std::string& fragmentSource) const
+{
+	unsigned long long key = m_driverHash;
+	key = HashString(key, vertexSource);
+	key = HashString(key, fragmentSource);
+	return(key);
+}
+
+/***********************************************************
+ *  LoadProgram()
+ *
+ *  This method is used for creating a program from the
+ *  binary stored for the passed in key.  A binary that the
+ *  driver rejects is removed, so it gets replaced by a
+ *  freshly compiled one.
+ ***********************************************************/
+GLuint ProgramBinaryCache::LoadProgram(unsigned long long key)
+{
+	if (m_bAvailable == false)
+	{
+		return(0);
+	}
+
+	std::string filePath = GetFilePath(key);
+	std::ifstream file(filePath.c_str(), std::ios::binary);
+	if (!file.is_open())
+	{
+		return(0);
+	}
+
+	BINARY_FILE_HEADER header;
+	file.read((char*)&header, sizeof(header));
+	if (!file ||
+		(header.magic != BINARY_FILE_MAGIC) ||
+		(header.version != BINARY_FILE_VERSION) ||
+		(header.key != key) ||
+		(header.length == 0))
+	{
+		return(0);
+	}
+
+	std::vector<char> binary(header.length);
+	file.read(&binary[0], header.length);
+	if (!file)
+	{
+		return(0);
+	}
+	file.close();
+
+	GLuint program = glCreateProgram();
+	glProgramBinary(program, (GLenum)header.format, &binary[0], (GLsizei)header.length);
+
+	GLint success = 0;
+	glGetProgramiv(program, GL_LINK_STATUS, &success);
+	if (!success)
+	{
+		glDeleteProgram(program);
+		std::remove(filePath.c_str());
+		return(0);
+	}
+
+	return(program);
+}
+
+/***********************************************************
+ *  StoreProgram()
+ *
+ *  This method is used for saving the binary of a linked
+ *  program under the passed in key.
+ ***********************************************************/
+bool ProgramBinaryCache::StoreProgram(unsigned long long key, GLuint program)
+{
+	if ((m_bAvailable == false) || (program == 0))
+	{
+		return(false);
+	}
+
+	GLint length = 0;
+	glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+	if (length <= 0)
+	{
+		return(false);
+	}
+
+	std::vector<char> binary(length);
+	GLenum format = 0;
+	GLsizei written = 0;
+	glGetProgramBinary(program, length, &written, &format, &binary[0]);
+	if (written <= 0)
+	{
+		return(false);
+	}
+
+	BINARY_FILE_HEADER header;
+	header.magic = BINARY_FILE_MAGIC;
+	header.version = BINARY_FILE_VERSION;
+	header.key = key;
+	header.format = format;
+	header.length = (unsigned int)written;
+
+	std::string filePath = GetFilePath(key);
+	std::ofstream file(filePath.c_str(), std::ios::binary | std::ios::trunc);
+	if (!file.is_open())
+	{
+		return(false);
+	}
+	file.write((const char*)&header, sizeof(header));
+	file.write(&binary[0], written);
+	if (!file)
+	{
+		file.close();
+		std::remove(filePath.c_str());
+		return(false);
+	}
+
+	return(true);
+}
+
+/***********************************************************
+ *  PrepareProgram()
+ *
+ *  This method is used for telling the driver that the
+ *  binary of a program will be read after it is linked.
+ ***********************************************************/
+void ProgramBinaryCache::PrepareProgram(GLuint program)
+{
+	if (m_bAvailable == true)
+	{
+		glProgramParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+	}
+}
+
+/***********************************************************
+ *  GetFilePath()
+ *
+ *  This method is used for getting the path of the binary
+ *  file for a cache key.
+ ***********************************************************/
+std::string ProgramBinaryCache::GetFilePath(unsigned long long key) const
+{
+	char fileName[32];
+	snprintf(fileName, sizeof(fileName), "%016llx.bin", key);
+	return(m_directory + "/" + fileName);
+}
@@ -0,0 +1,64 @@
+///////////////////////////////////////////////////////////////////////////////
+// programbinarycache.h
+// ============
+// store linked shader programs on disk and reload them on the next
+// start instead of compiling the GLSL source again
+//
+//  Created for CS-330-Computational Graphics and Visualization
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <GL/glew.h>
+
+#include <string>
+
+/***********************************************************
+ *  ProgramBinaryCache
+ *
+ *  This class contains the code for saving linked programs
+ *  with glGetProgramBinary and loading them back with
+ *  glProgramBinary.  Each program is stored in its own file
+ *  named by a hash of its source and of the driver strings,
+ *  so a changed shader or a driver update misses the cache.
+ ***********************************************************/
+class ProgramBinaryCache
+{
+public:
+	// constructor
+	ProgramBinaryCache();
+	// destructor
+	~ProgramBinaryCache();
+
+	// set the directory the binaries are stored in, and check
+	// that the driver can save program binaries
+	bool Initialize(const char* directory);
+	// check whether binaries can be loaded and stored
+	bool IsAvailable() const;
+
+	// build the cache key for a program from its shader source
+	unsigned long long MakeKey(
+		const std::string& vertexSource,
+		const std::string& fragmentSource) const;
+
+	// create a program from a stored binary, returns zero when
+	// there is no usable binary for the key
+	GLuint LoadProgram(unsigned long long key);
+	// save the binary of a linked program under the key
+	bool StoreProgram(unsigned long long key, GLuint program);
+
+	// request that a program's binary can be read once linked,
+	// which must be set before the program is linked
+	void PrepareProgram(GLuint program);
+
+private:
+	// directory the binary files are stored in
+	std::string m_directory;
+	// hash of the driver vendor, renderer and version strings
+	unsigned long long m_driverHash;
+	// true when the driver supports program binaries
+	bool m_bAvailable;
+
+	// get the file path for a cache key
+	std::string GetFilePath(unsigned long long key) const;
+};
@@ -0,0 +1,1506 @@
+///////////////////////////////////////////////////////////////////////////////
+// raytracer.cpp
+// ============
+// render high quality stills of the scene on the CPU by tracing rays,
+// with shadows and antialiasing, and save them as image files
+//
+//  Created for CS-330-Computational Graphics and Visualization
+///////////////////////////////////////////////////////////////////////////////
+
+#include "RayTracer.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <thread>
+
+// the bounds of a node are tested against the four rays of a
+// packet at once wherever SSE2 is available, which every x64
+// processor has
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && (_M_IX86_FP >= 2))
+#define RAY_TRACER_SSE2
+#include <emmintrin.h>
+#endif
+
+// declaration of the global variables and defines
+namespace
+{
+	// deepest bounding volume hierarchy that can be traversed
+	const int MAX_TRAVERSAL_DEPTH = 64;
+	// most instances and triangles in a leaf node, and the number
+	// below which a run becomes a leaf whatever its cost
+	const int INSTANCE_LEAF_SIZE = 2;
+	const int TRIANGLE_LEAF_SIZE = 4;
+	const int MAX_LEAF_SIZE = 16;
+	// buckets the centers are sorted into when looking for the
+	// cheapest split, and the cost of visiting a node compared to
+	// testing one item
+	const int SPLIT_BUCKETS = 12;
+	const float TRAVERSAL_COST = 1.0f;
+	// smallest direction component, which keeps the inverse of a
+	// direction along an axis finite
+	const float MIN_DIRECTION = 1.0e-30f;
+	// transparent surfaces a camera ray passes through before it
+	// stops, and the light left at which it stops early
+	const int MAX_SURFACE_LAYERS = 8;
+	const float MIN_THROUGHPUT = 1.0f / 512.0f;
+	// distance rays start away from the surface they leave, for
+	// each unit of distance from the origin
+	const float SURFACE_OFFSET = 1.0e-4f;
+	const float PI = 3.14159265358979323846f;
+
+	/***********************************************************
+	 *  GetInverse()
+	 *
+	 *  This function is used to get the inverse of a direction
+	 *  component, for the slab tests of the bounds.
+	 ***********************************************************/
+	float GetInverse(float value)
+	{
+		if (std::fabs(value) < MIN_DIRECTION)
+		{
+			value = (value < 0.0f) ? -MIN_DIRECTION : MIN_DIRECTION;
+		}
+		return(1.0f / value);
+	}
+
+	/***********************************************************
+	 *  GetSurfaceArea()
+	 *
+	 *  This function is used to get the surface area of an
+	 *  axis aligned box.
+	 ***********************************************************/
+	float GetSurfaceArea(const glm::vec3& boundsMin, const glm::vec3& boundsMax)
+	{
+		glm::vec3 extent = glm::max(boundsMax - boundsMin, glm::vec3(0.0f));
+		return(2.0f * (extent.x * extent.y + extent.y * extent.z + extent.z * extent.x));
+	}
+
+	/***********************************************************
+	 *  IntersectTriangle()
+	 *
+	 *  This function is used to get the distance along a ray to
+	 *  a triangle, from either side, and the barycentric
+	 *  coordinates of the point it reaches.  Returns false when
+	 *  the ray misses it or reaches it outside the distances.
+	 ***********************************************************/
+	bool IntersectTriangle(
+		const glm::vec3& origin,
+		const glm::vec3& direction,
+		const glm::vec3& a,
+		const glm::vec3& b,
+		const glm::vec3& c,
+		float minDistance,
+		float maxDistance,
+		float& distance,
+		float& u,
+		float& v)
+	{
+		glm::vec3 edge1 = b - a;
+		glm::vec3 edge2 = c - a;
+		glm::vec3 p = glm::cross(direction, edge2);
+		float determinant = glm::dot(edge1, p);
+		if (std::fabs(determinant) < 1.0e-20f)
+		{
+			return(false);
+		}
+
+		float inverseDeterminant = 1.0f / determinant;
+		glm::vec3 s = origin - a;
+		u = glm::dot(s, p) * inverseDeterminant;
+		if ((u < 0.0f) || (u > 1.0f))
+		{
+			return(false);
+		}
+		glm::vec3 q = glm::cross(s, edge1);
+		v = glm::dot(direction, q) * inverseDeterminant;
+		if ((v < 0.0f) || (u + v > 1.0f))
+		{
+			return(false);
+		}
+
+		float t = glm::dot(edge2, q) * inverseDeterminant;
+		if ((t <= minDistance) || (t >= maxDistance))
+		{
+			return(false);
+		}
+		distance = t;
+		return(true);
+	}
+
+	/***********************************************************
+	 *  GetRadicalInverse()
+	 *
+	 *  This function is used to mirror the digits of an index
+	 *  in a base around the point, giving the Halton sequence
+	 *  the sample positions inside a pixel are taken from.
+	 ***********************************************************/
+	float GetRadicalInverse(int index, int base)
+	{
+		float result = 0.0f;
+		float fraction = 1.0f / (float)base;
+		while (index > 0)
+		{
+			result += (float)(index % base) * fraction;
+			index /= base;
+			fraction /= (float)base;
+		}
+		return(result);
+	}
+
+	/***********************************************************
+	 *  GetPixelHash()
+	 *
+	 *  This function is used to get a value from 0 to 1 that
+	 *  looks random for each pixel, which shifts the sample
+	 *  positions so that neighboring pixels do not line up.
+	 ***********************************************************/
+	float GetPixelHash(int x, int y, unsigned int seed)
+	{
+		unsigned int hash = (unsigned int)x * 73856093u ^ (unsigned int)y * 19349663u ^ seed * 83492791u;
+		hash ^= hash >> 16;
+		hash *= 0x7FEB352Du;
+		hash ^= hash >> 15;
+		hash *= 0x846CA68Bu;
+		hash ^= hash >> 16;
+		return((float)(hash >> 8) / 16777216.0f);
+	}
+
+	/***********************************************************
+	 *  SmoothStep()
+	 *
+	 *  This function is used to fade smoothly from 0 to 1
+	 *  between two edges, the same as GLSL smoothstep().
+	 ***********************************************************/
+	float SmoothStep(float edge0, float edge1, float x)
+	{
+		float t = glm::clamp((x - edge0) / (edge1 - edge0), 0.0f, 1.0f);
+		return(t * t * (3.0f - 2.0f * t));
+	}
+
+	/***********************************************************
+	 *  GetAroundYAxis()
+	 *
+	 *  This function is used to get how far around the Y axis
+	 *  a point is, from 0 to 1, the same way the round shapes
+	 *  lay out their texture coordinates.
+	 ***********************************************************/
+	float GetAroundYAxis(const glm::vec3& point)
+	{
+		float around = std::atan2(-point.z, point.x) / (2.0f * PI);
+		return((around < 0.0f) ? around + 1.0f : around);
+	}
+
+	/***********************************************************
+	 *  PutLittleEndian()
+	 *
+	 *  This function is used to add a value to a file header
+	 *  with its lowest byte first.
+	 ***********************************************************/
+	void PutLittleEndian(std::vector<unsigned char>& bytes, unsigned int value, int byteCount)
+	{
+		for (int i = 0; i < byteCount; i++)
+		{
+			bytes.push_back((unsigned char)((value >> (i * 8)) & 0xFF));
+		}
+	}
+}
+
+/***********************************************************
+ *  RayTracer()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+RayTracer::RayTracer()
+{
+	m_ambientLight = glm::vec3(0.0f);
+	m_inverseViewProjection = glm::mat4(1.0f);
+	m_viewPosition = glm::vec3(0.0f);
+	m_width = 0;
+	m_height = 0;
+	m_sampleCount = 0;
+	m_backgroundColor = glm::vec3(0.0f);
+	m_rayCount = 0;
+	m_renderTime = 0.0;
+}
+
+/***********************************************************
+ *  ~RayTracer()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+RayTracer::~RayTracer()
+{
+}
+
+/***********************************************************
+ *  AddMesh()
+ *
+ *  This method is used for adding the vertices and triangles
+ *  of a mesh and building the hierarchy over them.  The
+ *  triangles are stored in the order the leaves refer to
+ *  them, so a leaf reads one run of indices.  A mesh with
+ *  indices past its vertices is left out, returning -1.
+ ***********************************************************/
+int RayTracer::AddMesh(const std::vector<MeshImporter::MESH_VERTEX>& vertices, const std::vector<unsigned int>& indices)
+{
+	int triangleCount = (int)(indices.size() / 3);
+	std::vector<glm::vec3> triangleMin(triangleCount);
+	std::vector<glm::vec3> triangleMax(triangleCount);
+	std::vector<int> order(triangleCount);
+	for (int i = 0; i < triangleCount; i++)
+	{
+		if ((indices[i * 3] >= vertices.size()) ||
+			(indices[i * 3 + 1] >= vertices.size()) ||
+			(indices[i * 3 + 2] >= vertices.size()))
+		{
+			return(-1);
+		}
+		const glm::vec3& a = vertices[indices[i * 3]].position;
+		const glm::vec3& b = vertices[indices[i * 3 + 1]].position;
+		const glm::vec3& c = vertices[indices[i * 3 + 2]].position;
+		triangleMin[i] = glm::min(a, glm::min(b, c));
+		triangleMax[i] = glm::max(a, glm::max(b, c));
+		order[i] = i;
+	}
+
+	m_meshes.push_back(TRACE_MESH());
+	TRACE_MESH& mesh = m_meshes.back();
+	mesh.vertices = vertices;
+	if (triangleCount > 0)
+	{
+		mesh.nodes.reserve(triangleCount * 2);
+		mesh.nodes.push_back(BVH_NODE());
+		BuildNode(triangleMin, triangleMax, order, mesh.nodes, 0, 0, triangleCount, TRIANGLE_LEAF_SIZE);
+	}
+	mesh.indices.resize(triangleCount * 3);
+	for (int i = 0; i < triangleCount; i++)
+	{
+		mesh.indices[i * 3] = indices[order[i] * 3];
+		mesh.indices[i * 3 + 1] = indices[order[i] * 3 + 1];
+		mesh.indices[i * 3 + 2] = indices[order[i] * 3 + 2];
+	}
+	return((int)m_meshes.size() - 1);
+}
+
+/***********************************************************
+ *  AddTexture()
+ *
+ *  This method is used for adding a texture from its RGBA
+ *  pixels, with the first row at the bottom like OpenGL.
+ *  The samples of a pixel already cover its footprint, so
+ *  no mipmap levels are needed.
+ ***********************************************************/
+int RayTracer::AddTexture(const unsigned char* pixels, int width, int height)
+{
+	if ((pixels == NULL) || (width <= 0) || (height <= 0))
+	{
+		return(-1);
+	}
+	m_textures.push_back(TRACE_TEXTURE());
+	m_textures.back().width = width;
+	m_textures.back().height = height;
+	m_textures.back().texels.assign(pixels, pixels + (size_t)width * height * 4);
+	return((int)m_textures.size() - 1);
+}
+
+/***********************************************************
+ *  SetInstances()
+ *
+ *  This method is used for setting the objects to trace and
+ *  building the hierarchy over their world space bounds.
+ *  Objects with a mesh that was not added, or a transform
+ *  that flattens them, are left out.
+ ***********************************************************/
+void RayTracer::SetInstances(const std::vector<TRACE_INSTANCE>& instances)
+{
+	m_instances.clear();
+	m_instanceOrder.clear();
+	m_nodes.clear();
+
+	std::vector<glm::vec3> instanceMin;
+	std::vector<glm::vec3> instanceMax;
+	for (size_t i = 0; i < instances.size(); i++)
+	{
+		const TRACE_INSTANCE& instance = instances[i];
+		glm::vec3 shapeMin(-1.0f);
+		glm::vec3 shapeMax(1.0f);
+		if (instance.shape == SHAPE_MESH)
+		{
+			if ((instance.mesh < 0) || (instance.mesh >= (int)m_meshes.size()) ||
+				(m_meshes[instance.mesh].nodes.empty() == true))
+			{
+				continue;
+			}
+			shapeMin = m_meshes[instance.mesh].nodes[0].boundsMin;
+			shapeMax = m_meshes[instance.mesh].nodes[0].boundsMax;
+		}
+		else if (instance.shape == SHAPE_CYLINDER)
+		{
+			shapeMin.y = 0.0f;
+		}
+		if (glm::determinant(glm::mat3(instance.model)) == 0.0f)
+		{
+			continue;
+		}
+
+		PREPARED_INSTANCE prepared;
+		prepared.instance = instance;
+		prepared.worldToObject = glm::inverse(instance.model);
+		prepared.normalMatrix = glm::transpose(glm::mat3(prepared.worldToObject));
+		if ((instance.surface.texture < 0) || (instance.surface.texture >= (int)m_textures.size()))
+		{
+			prepared.instance.surface.texture = -1;
+		}
+
+		// the world bounds around the corners of the shape bounds
+		for (int corner = 0; corner < 8; corner++)
+		{
+			glm::vec3 point(
+				((corner & 1) != 0) ? shapeMax.x : shapeMin.x,
+				((corner & 2) != 0) ? shapeMax.y : shapeMin.y,
+				((corner & 4) != 0) ? shapeMax.z : shapeMin.z);
+			point = glm::vec3(instance.model * glm::vec4(point, 1.0f));
+			prepared.boundsMin = (corner == 0) ? point : glm::min(prepared.boundsMin, point);
+			prepared.boundsMax = (corner == 0) ? point : glm::max(prepared.boundsMax, point);
+		}
+
+		m_instances.push_back(prepared);
+		instanceMin.push_back(prepared.boundsMin);
+		instanceMax.push_back(prepared.boundsMax);
+	}
+	if (m_instances.empty() == true)
+	{
+		return;
+	}
+
+	m_instanceOrder.resize(m_instances.size());
+	for (size_t i = 0; i < m_instanceOrder.size(); i++)
+	{
+		m_instanceOrder[i] = (int)i;
+	}
+	m_nodes.reserve(m_instances.size() * 2);
+	m_nodes.push_back(BVH_NODE());
+	BuildNode(instanceMin, instanceMax, m_instanceOrder, m_nodes, 0, 0, (int)m_instances.size(), INSTANCE_LEAF_SIZE);
+}
+
+/***********************************************************
+ *  SetLights()
+ *
+ *  This method is used for setting the light sources.  The
+ *  values the fragment shader gets from uniforms, such as
+ *  the cone cosines, are worked out here once.
+ ***********************************************************/
+void RayTracer::SetLights(
+	const std::vector<LIGHT_SOURCE>& lights,
+	const glm::vec3& ambientColor,
+	float ambientIntensity)
+{
+	m_lights = lights;
+	m_lightDirections.resize(lights.size());
+	m_innerConeCosines.resize(lights.size());
+	m_outerConeCosines.resize(lights.size());
+	for (size_t i = 0; i < lights.size(); i++)
+	{
+		m_lightDirections[i] = glm::normalize(lights[i].direction);
+		m_innerConeCosines[i] = cos(glm::radians(lights[i].innerConeAngle));
+		m_outerConeCosines[i] = cos(glm::radians(lights[i].outerConeAngle));
+	}
+	m_ambientLight = ambientColor * ambientIntensity;
+}
+
+/***********************************************************
+ *  SetViewTransform()
+ *
+ *  This method is used for setting the view and projection
+ *  the camera rays are cast with.  Each ray runs from the
+ *  near plane to the far plane through its pixel, so the
+ *  image shows what OpenGL would draw.
+ ***********************************************************/
+void RayTracer::SetViewTransform(
+	const glm::mat4& view,
+	const glm::mat4& projection,
+	const glm::vec3& viewPosition)
+{
+	m_inverseViewProjection = glm::inverse(projection * view);
+	m_viewPosition = viewPosition;
+}
+
+/***********************************************************
+ *  Render()
+ *
+ *  This method is used for rendering an image, one sample
+ *  for every pixel in each pass.  Each pass shares out its
+ *  tiles between one thread per CPU core.
+ ***********************************************************/
+void RayTracer::Render(int width, int height, int sampleCount, const glm::vec3& backgroundColor)
+{
+	m_width = std::max(width, 0);
+	m_height = std::max(height, 0);
+	m_accumulation.assign((size_t)m_width * m_height, glm::vec3(0.0f));
+	m_sampleCount = 0;
+	m_backgroundColor = backgroundColor;
+	m_rayCount = 0;
+
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	int tileCountX = (m_width + TILE_SIZE - 1) / TILE_SIZE;
+	int tileCount = tileCountX * ((m_height + TILE_SIZE - 1) / TILE_SIZE);
+	int threadCount = std::min(tileCount, std::max(1, (int)std::thread::hardware_concurrency()));
+	for (int pass = 0; pass < sampleCount; pass++)
+	{
+		std::atomic<int> nextTile(0);
+		std::vector<std::thread> workers;
+		for (int i = 1; i < threadCount; i++)
+		{
+			workers.push_back(std::thread(&RayTracer::RenderTiles, this, &nextTile, tileCount, tileCountX));
+		}
+		RenderTiles(&nextTile, tileCount, tileCountX);
+		for (size_t i = 0; i < workers.size(); i++)
+		{
+			workers[i].join();
+		}
+		m_sampleCount++;
+	}
+	m_renderTime = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+/***********************************************************
+ *  SaveImage()
+ *
+ *  This method is used for writing the average of each
+ *  pixel's samples into a 24 bit BMP file, which stores its
+ *  rows from the bottom up like the image.
+ ***********************************************************/
+bool RayTracer::SaveImage(const char* filePath) const
+{
+	if ((m_width <= 0) || (m_height <= 0) || (m_sampleCount <= 0))
+	{
+		return(false);
+	}
+
+	unsigned int rowBytes = ((unsigned int)m_width * 3 + 3) & ~3u;
+	unsigned int imageBytes = rowBytes * (unsigned int)m_height;
+	std::vector<unsigned char> bytes;
+	bytes.reserve(54 + imageBytes);
+
+	// file header and info header
+	bytes.push_back('B');
+	bytes.push_back('M');
+	PutLittleEndian(bytes, 54 + imageBytes, 4);
+	PutLittleEndian(bytes, 0, 4);
+	PutLittleEndian(bytes, 54, 4);
+	PutLittleEndian(bytes, 40, 4);
+	PutLittleEndian(bytes, (unsigned int)m_width, 4);
+	PutLittleEndian(bytes, (unsigned int)m_height, 4);
+	PutLittleEndian(bytes, 1, 2);
+	PutLittleEndian(bytes, 24, 2);
+	PutLittleEndian(bytes, 0, 4);
+	PutLittleEndian(bytes, imageBytes, 4);
+	PutLittleEndian(bytes, 2835, 4);
+	PutLittleEndian(bytes, 2835, 4);
+	PutLittleEndian(bytes, 0, 4);
+	PutLittleEndian(bytes, 0, 4);
+
+	float scale = 1.0f / (float)m_sampleCount;
+	for (int y = 0; y < m_height; y++)
+	{
+		for (int x = 0; x < m_width; x++)
+		{
+			glm::vec3 color = glm::clamp(m_accumulation[(size_t)y * m_width + x] * scale, 0.0f, 1.0f);
+			bytes.push_back((unsigned char)(color.b * 255.0f + 0.5f));
+			bytes.push_back((unsigned char)(color.g * 255.0f + 0.5f));
+			bytes.push_back((unsigned char)(color.r * 255.0f + 0.5f));
+		}
+		for (unsigned int i = (unsigned int)m_width * 3; i < rowBytes; i++)
+		{
+			bytes.push_back(0);
+		}
+	}
+
+	std::ofstream file(filePath, std::ios::binary | std::ios::trunc);
+	if (!file.is_open())
+	{
+		return(false);
+	}
+	file.write((const char*)&bytes[0], bytes.size());
+	if (!file)
+	{
+		file.close();
+		std::remove(filePath);
+		return(false);
+	}
+	return(true);
+}
+
+/***********************************************************
+ *  GetRayCount()
+ *
+ *  This method is used for getting the number of rays the
+ *  last image was rendered with.
+ ***********************************************************/
+long long RayTracer::GetRayCount() const
+{
+	return(m_rayCount);
+}
+
+/***********************************************************
+ *  GetRenderTime()
+ *
+ *  This method is used for getting the time in seconds the
+ *  last image took to render.
+ ***********************************************************/
+double RayTracer::GetRenderTime() const
+{
+	return(m_renderTime);
+}
+
+/***********************************************************
+ *  BuildNode()
+ *
+ *  This method is used for filling in a node around a run
+ *  of items.  The centers are sorted into buckets along the
+ *  longest side of their bounds, and the run is split
+ *  between the buckets where the areas of the two halves
+ *  times their item counts are smallest.  A run stays a
+ *  leaf when no split is cheaper than testing every item,
+ *  and a run whose centers all meet is split in half.
+ ***********************************************************/
+void RayTracer::BuildNode(
+	const std::vector<glm::vec3>& itemMin,
+	const std::vector<glm::vec3>& itemMax,
+	std::vector<int>& order,
+	std::vector<BVH_NODE>& nodes,
+	int nodeIndex,
+	int first,
+	int count,
+	int leafSize)
+{
+	glm::vec3 boundsMin(1.0e30f);
+	glm::vec3 boundsMax(-1.0e30f);
+	glm::vec3 centerMin(1.0e30f);
+	glm::vec3 centerMax(-1.0e30f);
+	for (int i = first; i < first + count; i++)
+	{
+		boundsMin = glm::min(boundsMin, itemMin[order[i]]);
+		boundsMax = glm::max(boundsMax, itemMax[order[i]]);
+		glm::vec3 center = (itemMin[order[i]] + itemMax[order[i]]) * 0.5f;
+		centerMin = glm::min(centerMin, center);
+		centerMax = glm::max(centerMax, center);
+	}
+	nodes[nodeIndex].boundsMin = boundsMin;
+	nodes[nodeIndex].boundsMax = boundsMax;
+	nodes[nodeIndex].first = first;
+	nodes[nodeIndex].itemCount = count;
+	nodes[nodeIndex].axis = 0;
+	if (count <= leafSize)
+	{
+		return;
+	}
+
+	glm::vec3 centerExtent = centerMax - centerMin;
+	int axis = 0;
+	if (centerExtent.y > centerExtent[axis])
+	{
+		axis = 1;
+	}
+	if (centerExtent.z > centerExtent[axis])
+	{
+		axis = 2;
+	}
+
+	int split = first;
+	if (centerExtent[axis] > 0.0f)
+	{
+		// the bounds and item counts of each bucket
+		int bucketCounts[SPLIT_BUCKETS] = {};
+		glm::vec3 bucketMin[SPLIT_BUCKETS];
+		glm::vec3 bucketMax[SPLIT_BUCKETS];
+		for (int b = 0; b < SPLIT_BUCKETS; b++)
+		{
+			bucketMin[b] = glm::vec3(1.0e30f);
+			bucketMax[b] = glm::vec3(-1.0e30f);
+		}
+		float bucketScale = (float)SPLIT_BUCKETS / centerExtent[axis];
+		for (int i = first; i < first + count; i++)
+		{
+			float center = (itemMin[order[i]][axis] + itemMax[order[i]][axis]) * 0.5f;
+			int bucket = std::min((int)((center - centerMin[axis]) * bucketScale), SPLIT_BUCKETS - 1);
+			bucketCounts[bucket]++;
+			bucketMin[bucket] = glm::min(bucketMin[bucket], itemMin[order[i]]);
+			bucketMax[bucket] = glm::max(bucketMax[bucket], itemMax[order[i]]);
+		}
+
+		// the cost of splitting after each bucket, summed from the
+		// right and then the left
+		float rightCosts[SPLIT_BUCKETS] = {};
+		glm::vec3 sideMin(1.0e30f);
+		glm::vec3 sideMax(-1.0e30f);
+		int sideCount = 0;
+		for (int b = SPLIT_BUCKETS - 1; b > 0; b--)
+		{
+			sideMin = glm::min(sideMin, bucketMin[b]);
+			sideMax = glm::max(sideMax, bucketMax[b]);
+			sideCount += bucketCounts[b];
+			rightCosts[b - 1] = (sideCount > 0) ? GetSurfaceArea(sideMin, sideMax) * sideCount : 0.0f;
+		}
+		int bestBucket = -1;
+		float bestCost = 1.0e30f;
+		sideMin = glm::vec3(1.0e30f);
+		sideMax = glm::vec3(-1.0e30f);
+		sideCount = 0;
+		for (int b = 0; b < SPLIT_BUCKETS - 1; b++)
+		{
+			sideMin = glm::min(sideMin, bucketMin[b]);
+			sideMax = glm::max(sideMax, bucketMax[b]);
+			sideCount += bucketCounts[b];
+			if ((sideCount == 0) || (sideCount == count))
+			{
+				continue;
+			}
+			float cost = GetSurfaceArea(sideMin, sideMax) * sideCount + rightCosts[b];
+			if (cost < bestCost)
+			{
+				bestCost = cost;
+				bestBucket = b;
+			}
+		}
+
+		// the split is worth it when visiting the children costs
+		// less than testing every item of the run
+		float area = GetSurfaceArea(boundsMin, boundsMax);
+		float splitCost = TRAVERSAL_COST + ((area > 0.0f) ? bestCost / area : (float)count);
+		if (((bestBucket < 0) || (splitCost >= (float)count)) && (count <= MAX_LEAF_SIZE))
+		{
+			return;
+		}
+		if (bestBucket >= 0)
+		{
+			split = (int)(std::partition(
+				order.begin() + first,
+				order.begin() + first + count,
+				[&itemMin, &itemMax, axis, centerMin, bucketScale, bestBucket](int item)
+				{
+					float center = (itemMin[item][axis] + itemMax[item][axis]) * 0.5f;
+					int bucket = std::min((int)((center - centerMin[axis]) * bucketScale), SPLIT_BUCKETS - 1);
+					return(bucket <= bestBucket);
+				}) - order.begin());
+		}
+	}
+
+	// the centers meet, or no split was found, so the run is cut
+	// in half
+	if ((split <= first) || (split >= first + count) || (centerExtent[axis] <= 0.0f))
+	{
+		split = first + count / 2;
+		std::nth_element(
+			order.begin() + first,
+			order.begin() + split,
+			order.begin() + first + count,
+			[&itemMin, &itemMax, axis](int a, int b)
+			{
+				return((itemMin[a][axis] + itemMax[a][axis]) < (itemMin[b][axis] + itemMax[b][axis]));
+			});
+	}
+
+	int leftChild = (int)nodes.size();
+	nodes.push_back(BVH_NODE());
+	nodes.push_back(BVH_NODE());
+	nodes[nodeIndex].first = leftChild;
+	nodes[nodeIndex].itemCount = 0;
+	nodes[nodeIndex].axis = axis;
+
+	BuildNode(itemMin, itemMax, order, nodes, leftChild, first, split - first, leafSize);
+	BuildNode(itemMin, itemMax, order, nodes, leftChild + 1, split, first + count - split, leafSize);
+}
+
+/***********************************************************
+ *  IntersectPacketBounds()
+ *
+ *  This method is used for finding which of the active
+ *  lanes of a packet pass through an axis aligned box
+ *  within the part of the ray that is searched.
+ ***********************************************************/
+int RayTracer::IntersectPacketBounds(
+	const RAY_PACKET& packet,
+	const glm::vec3& boundsMin,
+	const glm::vec3& boundsMax)
+{
+#ifdef RAY_TRACER_SSE2
+	__m128 originX = _mm_loadu_ps(packet.originX);
+	__m128 originY = _mm_loadu_ps(packet.originY);
+	__m128 originZ = _mm_loadu_ps(packet.originZ);
+	__m128 inverseX = _mm_loadu_ps(packet.inverseX);
+	__m128 inverseY = _mm_loadu_ps(packet.inverseY);
+	__m128 inverseZ = _mm_loadu_ps(packet.inverseZ);
+
+	__m128 t0 = _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(boundsMin.x), originX), inverseX);
+	__m128 t1 = _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(boundsMax.x), originX), inverseX);
+	__m128 enter = _mm_max_ps(_mm_min_ps(t0, t1), _mm_loadu_ps(packet.minDistance));
+	__m128 exit = _mm_min_ps(_mm_max_ps(t0, t1), _mm_loadu_ps(packet.maxDistance));
+	t0 = _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(boundsMin.y), originY), inverseY);
+	t1 = _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(boundsMax.y), originY), inverseY);
+	enter = _mm_max_ps(enter, _mm_min_ps(t0, t1));
+	exit = _mm_min_ps(exit, _mm_max_ps(t0, t1));
+	t0 = _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(boundsMin.z), originZ), inverseZ);
+	t1 = _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(boundsMax.z), originZ), inverseZ);
+	enter = _mm_max_ps(enter, _mm_min_ps(t0, t1));
+	exit = _mm_min_ps(exit, _mm_max_ps(t0, t1));
+	return(_mm_movemask_ps(_mm_cmple_ps(enter, exit)) & packet.activeMask);
+#else
+	int mask = 0;
+	for (int lane = 0; lane < 4; lane++)
+	{
+		if ((packet.activeMask & (1 << lane)) == 0)
+		{
+			continue;
+		}
+		float t0 = (boundsMin.x - packet.originX[lane]) * packet.inverseX[lane];
+		float t1 = (boundsMax.x - packet.originX[lane]) * packet.inverseX[lane];
+		float enter = std::max(std::min(t0, t1), packet.minDistance[lane]);
+		float exit = std::min(std::max(t0, t1), packet.maxDistance[lane]);
+		t0 = (boundsMin.y - packet.originY[lane]) * packet.inverseY[lane];
+		t1 = (boundsMax.y - packet.originY[lane]) * packet.inverseY[lane];
+		enter = std::max(enter, std::min(t0, t1));
+		exit = std::min(exit, std::max(t0, t1));
+		t0 = (boundsMin.z - packet.originZ[lane]) * packet.inverseZ[lane];
+		t1 = (boundsMax.z - packet.originZ[lane]) * packet.inverseZ[lane];
+		enter = std::max(enter, std::min(t0, t1));
+		exit = std::min(exit, std::max(t0, t1));
+		if (enter <= exit)
+		{
+			mask |= 1 << lane;
+		}
+	}
+	return(mask);
+#endif
+}
+
+/***********************************************************
+ *  IntersectMesh()
+ *
+ *  This method is used for finding the closest triangles of
+ *  a mesh along the lanes of a packet in the mesh's own
+ *  space.  A node is visited while any lane reaches it, the
+ *  nearer child first for the direction of the first lane.
+ *  For shadow rays, a lane stops at the first triangle it
+ *  finds, and the search ends once every lane has stopped.
+ ***********************************************************/
+void RayTracer::IntersectMesh(const TRACE_MESH& mesh, int instance, RAY_PACKET& packet, bool bAnyHit)
+{
+	int stack[MAX_TRAVERSAL_DEPTH];
+	int stackSize = 0;
+	stack[stackSize++] = 0;
+	while ((stackSize > 0) && (packet.activeMask != 0))
+	{
+		const BVH_NODE& node = mesh.nodes[stack[--stackSize]];
+		int mask = IntersectPacketBounds(packet, node.boundsMin, node.boundsMax);
+		if (mask == 0)
+		{
+			continue;
+		}
+
+		if (node.itemCount > 0)
+		{
+			for (int i = node.first; i < node.first + node.itemCount; i++)
+			{
+				const glm::vec3& a = mesh.vertices[mesh.indices[i * 3]].position;
+				const glm::vec3& b = mesh.vertices[mesh.indices[i * 3 + 1]].position;
+				const glm::vec3& c = mesh.vertices[mesh.indices[i * 3 + 2]].position;
+				for (int lane = 0; lane < 4; lane++)
+				{
+					if ((mask & packet.activeMask & (1 << lane)) == 0)
+					{
+						continue;
+					}
+					float distance = 0.0f;
+					float u = 0.0f;
+					float v = 0.0f;
+					if (IntersectTriangle(
+						glm::vec3(packet.originX[lane], packet.originY[lane], packet.originZ[lane]),
+						glm::vec3(packet.directionX[lane], packet.directionY[lane], packet.directionZ[lane]),
+						a, b, c, packet.minDistance[lane], packet.maxDistance[lane], distance, u, v) == true)
+					{
+						packet.maxDistance[lane] = distance;
+						packet.instance[lane] = instance;
+						packet.triangle[lane] = i;
+						packet.u[lane] = u;
+						packet.v[lane] = v;
+						if (bAnyHit == true)
+						{
+							packet.activeMask &= ~(1 << lane);
+						}
+					}
+				}
+			}
+		}
+		else if (stackSize + 2 <= MAX_TRAVERSAL_DEPTH)
+		{
+			// the first lane that reaches the node picks the order
+			int lane = 0;
+			while ((mask & (1 << lane)) == 0)
+			{
+				lane++;
+			}
+			const float* directions[3] = { packet.directionX, packet.directionY, packet.directionZ };
+			bool bLeftFirst = (directions[node.axis][lane] >= 0.0f);
+			stack[stackSize++] = (bLeftFirst == true) ? node.first + 1 : node.first;
+			stack[stackSize++] = (bLeftFirst == true) ? node.first : node.first + 1;
+		}
+	}
+}
+
+/***********************************************************
+ *  IntersectShape()
+ *
+ *  This method is used for finding the closest point of an
+ *  exact sphere or cylinder along a ray in the shape's own
+ *  space.  The distance passed in limits the search, and is
+ *  replaced with the distance of the point found.
+ ***********************************************************/
+bool RayTracer::IntersectShape(
+	SHAPE_TYPE shape,
+	const glm::vec3& origin,
+	const glm::vec3& direction,
+	float minDistance,
+	float& distance)
+{
+	bool bHit = false;
+	if (shape == SHAPE_SPHERE)
+	{
+		float a = glm::dot(direction, direction);
+		float b = glm::dot(origin, direction);
+		float c = glm::dot(origin, origin) - 1.0f;
+		float discriminant = b * b - a * c;
+		if (discriminant < 0.0f)
+		{
+			return(false);
+		}
+		float root = std::sqrt(discriminant);
+		float roots[2] = { (-b - root) / a, (-b + root) / a };
+		for (int i = 0; i < 2; i++)
+		{
+			if ((roots[i] > minDistance) && (roots[i] < distance))
+			{
+				distance = roots[i];
+				return(true);
+			}
+		}
+		return(false);
+	}
+
+	// the side of the cylinder, between its ends
+	float a = direction.x * direction.x + direction.z * direction.z;
+	float b = origin.x * direction.x + origin.z * direction.z;
+	float c = origin.x * origin.x + origin.z * origin.z - 1.0f;
+	float discriminant = b * b - a * c;
+	if ((a > 0.0f) && (discriminant >= 0.0f))
+	{
+		float root = std::sqrt(discriminant);
+		float roots[2] = { (-b - root) / a, (-b + root) / a };
+		for (int i = 0; i < 2; i++)
+		{
+			float y = origin.y + direction.y * roots[i];
+			if ((roots[i] > minDistance) && (roots[i] < distance) && (y >= 0.0f) && (y <= 1.0f))
+			{
+				distance = roots[i];
+				bHit = true;
+				break;
+			}
+		}
+	}
+
+	// the discs closing both ends
+	if (direction.y != 0.0f)
+	{
+		for (int end = 0; end < 2; end++)
+		{
+			float t = ((float)end - origin.y) / direction.y;
+			float x = origin.x + direction.x * t;
+			float z = origin.z + direction.z * t;
+			if ((t > minDistance) && (t < distance) && (x * x + z * z <= 1.0f))
+			{
+				distance = t;
+				bHit = true;
+			}
+		}
+	}
+	return(bHit);
+}
+
+/***********************************************************
+ *  TracePacket()
+ *
+ *  This method is used for finding the closest surface along
+ *  each active lane of a packet.  Each instance a lane
+ *  reaches is tested with the packet moved into its space,
+ *  without normalizing the directions, so the distances stay
+ *  in world units.  For shadow rays, transparent objects let
+ *  the light through, and a lane stops at the first opaque
+ *  surface, leaving the active mask with the lanes that
+ *  found none.
+ ***********************************************************/
+void RayTracer::TracePacket(RAY_PACKET& packet, bool bAnyHit) const
+{
+	for (int lane = 0; lane < 4; lane++)
+	{
+		packet.instance[lane] = -1;
+		packet.triangle[lane] = -1;
+	}
+	if (m_nodes.empty() == true)
+	{
+		return;
+	}
+
+	int stack[MAX_TRAVERSAL_DEPTH];
+	int stackSize = 0;
+	stack[stackSize++] = 0;
+	while ((stackSize > 0) && (packet.activeMask != 0))
+	{
+		const BVH_NODE& node = m_nodes[stack[--stackSize]];
+		int mask = IntersectPacketBounds(packet, node.boundsMin, node.boundsMax);
+		if (mask == 0)
+		{
+			continue;
+		}
+
+		if (node.itemCount > 0)
+		{
+			for (int i = node.first; (i < node.first + node.itemCount) && (packet.activeMask != 0); i++)
+			{
+				int instanceIndex = m_instanceOrder[i];
+				const PREPARED_INSTANCE& prepared = m_instances[instanceIndex];
+				if ((bAnyHit == true) && (prepared.instance.surface.bTransparent == true))
+				{
+					continue;
+				}
+				int instanceMask = IntersectPacketBounds(packet, prepared.boundsMin, prepared.boundsMax);
+				if (instanceMask == 0)
+				{
+					continue;
+				}
+
+				// move the lanes that reach the instance into its space
+				RAY_PACKET local = packet;
+				local.activeMask = instanceMask;
+				for (int lane = 0; lane < 4; lane++)
+				{
+					if ((instanceMask & (1 << lane)) == 0)
+					{
+						continue;
+					}
+					glm::vec3 origin = glm::vec3(prepared.worldToObject *
+						glm::vec4(packet.originX[lane], packet.originY[lane], packet.originZ[lane], 1.0f));
+					glm::vec3 direction = glm::mat3(prepared.worldToObject) *
+						glm::vec3(packet.directionX[lane], packet.directionY[lane], packet.directionZ[lane]);
+					local.originX[lane] = origin.x;
+					local.originY[lane] = origin.y;
+					local.originZ[lane] = origin.z;
+					local.directionX[lane] = direction.x;
+					local.directionY[lane] = direction.y;
+					local.directionZ[lane] = direction.z;
+					local.inverseX[lane] = GetInverse(direction.x);
+					local.inverseY[lane] = GetInverse(direction.y);
+					local.inverseZ[lane] = GetInverse(direction.z);
+					local.instance[lane] = -1;
+				}
+
+				if (prepared.instance.shape == SHAPE_MESH)
+				{
+					IntersectMesh(m_meshes[prepared.instance.mesh], instanceIndex, local, bAnyHit);
+				}
+				else
+				{
+					for (int lane = 0; lane < 4; lane++)
+					{
+						if ((instanceMask & (1 << lane)) == 0)
+						{
+							continue;
+						}
+						float distance = local.maxDistance[lane];
+						if (IntersectShape(
+							prepared.instance.shape,
+							glm::vec3(local.originX[lane], local.originY[lane], local.originZ[lane]),
+							glm::vec3(local.directionX[lane], local.directionY[lane], local.directionZ[lane]),
+							local.minDistance[lane], distance) == true)
+						{
+							local.maxDistance[lane] = distance;
+							local.instance[lane] = instanceIndex;
+							local.triangle[lane] = -1;
+						}
+					}
+				}
+
+				// keep what the lanes found
+				for (int lane = 0; lane < 4; lane++)
+				{
+					if (((instanceMask & (1 << lane)) == 0) || (local.instance[lane] != instanceIndex))
+					{
+						continue;
+					}
+					packet.maxDistance[lane] = local.maxDistance[lane];
+					packet.instance[lane] = instanceIndex;
+					packet.triangle[lane] = local.triangle[lane];
+					packet.u[lane] = local.u[lane];
+					packet.v[lane] = local.v[lane];
+					if (bAnyHit == true)
+					{
+						packet.activeMask &= ~(1 << lane);
+					}
+				}
+			}
+		}
+		else if (stackSize + 2 <= MAX_TRAVERSAL_DEPTH)
+		{
+			int lane = 0;
+			while ((mask & (1 << lane)) == 0)
+			{
+				lane++;
+			}
+			const float* directions[3] = { packet.directionX, packet.directionY, packet.directionZ };
+			bool bLeftFirst = (directions[node.axis][lane] >= 0.0f);
+			stack[stackSize++] = (bLeftFirst == true) ? node.first + 1 : node.first;
+			stack[stackSize++] = (bLeftFirst == true) ? node.first : node.first + 1;
+		}
+	}
+}
+
+/***********************************************************
+ *  GetSurfacePoint()
+ *
+ *  This method is used for getting the world position, the
+ *  normal and the texture coordinate of the surface found
+ *  in a lane.  Triangles interpolate their vertices, and
+ *  the exact shapes work them out the same way the round
+ *  shapes were tessellated.  The offset normal faces back
+ *  along the ray, for starting the rays that leave the
+ *  surface.
+ ***********************************************************/
+void RayTracer::GetSurfacePoint(const RAY_PACKET& packet, int lane, SURFACE_POINT& point) const
+{
+	const PREPARED_INSTANCE& prepared = m_instances[packet.instance[lane]];
+	glm::vec3 direction(packet.directionX[lane], packet.directionY[lane], packet.directionZ[lane]);
+	point.position = glm::vec3(packet.originX[lane], packet.originY[lane], packet.originZ[lane]) +
+		direction * packet.maxDistance[lane];
+
+	glm::vec3 objectNormal(0.0f, 1.0f, 0.0f);
+	glm::vec3 geometricNormal(0.0f, 1.0f, 0.0f);
+	if (prepared.instance.shape == SHAPE_MESH)
+	{
+		const TRACE_MESH& mesh = m_meshes[prepared.instance.mesh];
+		int triangle = packet.triangle[lane];
+		const MeshImporter::MESH_VERTEX& a = mesh.vertices[mesh.indices[triangle * 3]];
+		const MeshImporter::MESH_VERTEX& b = mesh.vertices[mesh.indices[triangle * 3 + 1]];
+		const MeshImporter::MESH_VERTEX& c = mesh.vertices[mesh.indices[triangle * 3 + 2]];
+		float w = 1.0f - packet.u[lane] - packet.v[lane];
+		objectNormal = a.normal * w + b.normal * packet.u[lane] + c.normal * packet.v[lane];
+		geometricNormal = glm::cross(b.position - a.position, c.position - a.position);
+		point.textureCoordinate = a.textureCoordinate * w +
+			b.textureCoordinate * packet.u[lane] + c.textureCoordinate * packet.v[lane];
+	}
+	else
+	{
+		glm::vec3 local = glm::vec3(prepared.worldToObject * glm::vec4(point.position, 1.0f));
+		if (prepared.instance.shape == SHAPE_SPHERE)
+		{
+			objectNormal = local;
+			point.textureCoordinate = glm::vec2(GetAroundYAxis(local),
+				1.0f - std::acos(glm::clamp(local.y, -1.0f, 1.0f)) / PI);
+		}
+		else
+		{
+			// the ends are told from the side by which they are
+			// closer to
+			float sideDistance = std::fabs(1.0f - std::sqrt(local.x * local.x + local.z * local.z));
+			if ((std::fabs(local.y) < sideDistance) || (std::fabs(local.y - 1.0f) < sideDistance))
+			{
+				float normalY = (local.y > 0.5f) ? 1.0f : -1.0f;
+				objectNormal = glm::vec3(0.0f, normalY, 0.0f);
+				point.textureCoordinate = glm::vec2(0.5f + 0.5f * local.x, 0.5f - 0.5f * local.z * normalY);
+			}
+			else
+			{
+				objectNormal = glm::vec3(local.x, 0.0f, local.z);
+				point.textureCoordinate = glm::vec2(GetAroundYAxis(local), local.y);
+			}
+		}
+		geometricNormal = objectNormal;
+	}
+
+	point.normal = glm::normalize(prepared.normalMatrix * objectNormal);
+	point.offsetNormal = glm::normalize(prepared.normalMatrix * geometricNormal);
+	if (glm::dot(point.offsetNormal, direction) > 0.0f)
+	{
+		point.offsetNormal = -point.offsetNormal;
+	}
+}
+
+/***********************************************************
+ *  GetBaseColor()
+ *
+ *  This method is used for getting the color of a surface
+ *  before it is lit, from its texture or its color.
+ ***********************************************************/
+glm::vec4 RayTracer::GetBaseColor(const TRACE_SURFACE& surface, const glm::vec2& textureCoordinate) const
+{
+	if (surface.texture < 0)
+	{
+		return(surface.color);
+	}
+	return(SampleTexture(surface.texture, textureCoordinate * surface.UVscale));
+}
+
+/***********************************************************
+ *  SampleTexture()
+ *
+ *  This method is used for sampling a texture with the
+ *  coordinates repeating, like the scene textures, blending
+ *  the four texels around the coordinate.
+ ***********************************************************/
+glm::vec4 RayTracer::SampleTexture(int texture, const glm::vec2& coordinate) const
+{
+	const TRACE_TEXTURE& image = m_textures[texture];
+	float texelX = coordinate.x * (float)image.width - 0.5f;
+	float texelY = coordinate.y * (float)image.height - 0.5f;
+	float floorX = std::floor(texelX);
+	float floorY = std::floor(texelY);
+	float fractionX = texelX - floorX;
+	float fractionY = texelY - floorY;
+
+	// wrap the four texels into the image
+	int x0 = (int)std::fmod(floorX, (float)image.width);
+	int y0 = (int)std::fmod(floorY, (float)image.height);
+	x0 = (x0 < 0) ? x0 + image.width : x0;
+	y0 = (y0 < 0) ? y0 + image.height : y0;
+	int x1 = (x0 + 1 == image.width) ? 0 : x0 + 1;
+	int y1 = (y0 + 1 == image.height) ? 0 : y0 + 1;
+
+	const int cornerX[4] = { x0, x1, x0, x1 };
+	const int cornerY[4] = { y0, y0, y1, y1 };
+	const float cornerWeight[4] = {
+		(1.0f - fractionX) * (1.0f - fractionY),
+		fractionX * (1.0f - fractionY),
+		(1.0f - fractionX) * fractionY,
+		fractionX * fractionY };
+	glm::vec4 sample(0.0f);
+	for (int i = 0; i < 4; i++)
+	{
+		const unsigned char* texel = &image.texels[((size_t)cornerY[i] * image.width + cornerX[i]) * 4];
+		sample += glm::vec4(texel[0], texel[1], texel[2], texel[3]) * cornerWeight[i];
+	}
+	return(sample / 255.0f);
+}
+
+/***********************************************************
+ *  ShadePacket()
+ *
+ *  This method is used for lighting the surfaces found by
+ *  the active lanes of a packet, the same way as the scene
+ *  fragment shader.  For each light, the lanes it reaches
+ *  cast their shadow rays together as one packet, and the
+ *  diffuse and specular light is left out where an opaque
+ *  object is in the way.  The ambient part of each light
+ *  reaches every surface, as it does in the shader.  Returns
+ *  the number of shadow rays traced.
+ ***********************************************************/
+int RayTracer::ShadePacket(
+	const RAY_PACKET& packet,
+	const SURFACE_POINT* points,
+	const glm::vec4* baseColors,
+	glm::vec3* colors) const
+{
+	glm::vec3 lighting[4];
+	int litMask = 0;
+	int shadowRayCount = 0;
+	for (int lane = 0; lane < 4; lane++)
+	{
+		if ((packet.activeMask & (1 << lane)) == 0)
+		{
+			continue;
+		}
+		if (m_instances[packet.instance[lane]].instance.surface.bUseLighting == true)
+		{
+			lighting[lane] = m_ambientLight;
+			litMask |= 1 << lane;
+		}
+		else
+		{
+			lighting[lane] = glm::vec3(1.0f);
+		}
+	}
+
+	for (size_t i = 0; (i < m_lights.size()) && (litMask != 0); i++)
+	{
+		const LIGHT_SOURCE& light = m_lights[i];
+		glm::vec3 direct[4];
+		RAY_PACKET shadow;
+		shadow.activeMask = 0;
+		for (int lane = 0; lane < 4; lane++)
+		{
+			shadow.minDistance[lane] = 0.0f;
+			shadow.maxDistance[lane] = 0.0f;
+			shadow.originX[lane] = shadow.originY[lane] = shadow.originZ[lane] = 0.0f;
+			shadow.directionX[lane] = shadow.directionY[lane] = shadow.directionZ[lane] = 1.0f;
+			shadow.inverseX[lane] = shadow.inverseY[lane] = shadow.inverseZ[lane] = 1.0f;
+			if ((litMask & (1 << lane)) == 0)
+			{
+				continue;
+			}
+
+			// phong lighting from one light source, faded out smoothly
+			// to nothing at the light's range and outside a spot
+			// light's cone
+			const SURFACE_POINT& point = points[lane];
+			const TRACE_SURFACE& surface = m_instances[packet.instance[lane]].instance.surface;
+			glm::vec3 toLight = light.position - point.position;
+			float lightDistance = glm::length(toLight);
+			if (lightDistance >= light.range)
+			{
+				continue;
+			}
+			glm::vec3 lightDirection = toLight / lightDistance;
+
+			float falloff = lightDistance / light.range;
+			falloff = glm::clamp(1.0f - falloff * falloff * falloff * falloff, 0.0f, 1.0f);
+			float attenuation = falloff * falloff;
+			if (light.type == LIGHT_SOURCE::LIGHT_SPOT)
+			{
+				float spotCosine = glm::dot(-lightDirection, m_lightDirections[i]);
+				attenuation *= SmoothStep(m_outerConeCosines[i], m_innerConeCosines[i], spotCosine);
+			}
+
+			glm::vec3 ambient = light.ambientColor * surface.ambientColor * surface.ambientStrength;
+			lighting[lane] += ambient * attenuation;
+
+			glm::vec3 viewDirection = glm::normalize(m_viewPosition - point.position);
+			float diffuseImpact = std::max(glm::dot(point.normal, lightDirection), 0.0f);
+			glm::vec3 diffuse = diffuseImpact * light.diffuseColor * surface.diffuseColor;
+
+			glm::vec3 reflectDirection = glm::reflect(-lightDirection, point.normal);
+			float reflectCosine = glm::dot(viewDirection, reflectDirection);
+			float specularComponent = (reflectCosine > 0.0f) ? std::pow(reflectCosine, light.focalStrength) : 0.0f;
+			glm::vec3 specular = light.specularIntensity * specularComponent * light.specularColor * surface.specularColor;
+
+			direct[lane] = (diffuse + specular) * attenuation;
+			if ((direct[lane].x <= 0.0f) && (direct[lane].y <= 0.0f) && (direct[lane].z <= 0.0f))
+			{
+				continue;
+			}
+
+			// the shadow ray leaves from just above the surface and
+			// stops just short of the light
+			float offset = SURFACE_OFFSET * std::max(1.0f,
+				std::max(std::fabs(point.position.x), std::max(std::fabs(point.position.y), std::fabs(point.position.z))));
+			glm::vec3 origin = point.position + point.offsetNormal * offset;
+			shadow.originX[lane] = origin.x;
+			shadow.originY[lane] = origin.y;
+			shadow.originZ[lane] = origin.z;
+			shadow.directionX[lane] = lightDirection.x;
+			shadow.directionY[lane] = lightDirection.y;
+			shadow.directionZ[lane] = lightDirection.z;
+			shadow.inverseX[lane] = GetInverse(lightDirection.x);
+			shadow.inverseY[lane] = GetInverse(lightDirection.y);
+			shadow.inverseZ[lane] = GetInverse(lightDirection.z);
+			shadow.maxDistance[lane] = lightDistance - offset;
+			shadow.activeMask |= 1 << lane;
+		}
+		if (shadow.activeMask == 0)
+		{
+			continue;
+		}
+
+		for (int lane = 0; lane < 4; lane++)
+		{
+			shadowRayCount += (shadow.activeMask >> lane) & 1;
+		}
+		TracePacket(shadow, true);
+		for (int lane = 0; lane < 4; lane++)
+		{
+			if ((shadow.activeMask & (1 << lane)) != 0)
+			{
+				lighting[lane] += direct[lane];
+			}
+		}
+	}
+
+	for (int lane = 0; lane < 4; lane++)
+	{
+		if ((packet.activeMask & (1 << lane)) != 0)
+		{
+			colors[lane] = lighting[lane] * glm::vec3(baseColors[lane]);
+		}
+	}
+	return(shadowRayCount);
+}
+
+/***********************************************************
+ *  RenderTile()
+ *
+ *  This method is used for adding one sample to every pixel
+ *  of a tile.  The pixels are traced two by two as packets.
+ *  Each sample is placed inside its pixel by the Halton
+ *  sequence, shifted by a different amount for each pixel.
+ *  A ray that reaches a transparent surface carries on
+ *  behind it with the light the surface lets through.
+ ***********************************************************/
+void RayTracer::RenderTile(int tile, int tileCountX)
+{
+	int tileX = (tile % tileCountX) * TILE_SIZE;
+	int tileY = (tile / tileCountX) * TILE_SIZE;
+	float jitterX = GetRadicalInverse(m_sampleCount + 1, 2);
+	float jitterY = GetRadicalInverse(m_sampleCount + 1, 3);
+	long long rayCount = 0;
+
+	for (int quadY = tileY; quadY < std::min(tileY + TILE_SIZE, m_height); quadY += 2)
+	{
+		for (int quadX = tileX; quadX < std::min(tileX + TILE_SIZE, m_width); quadX += 2)
+		{
+			RAY_PACKET packet;
+			packet.activeMask = 0;
+			float rayLength[4];
+			glm::vec3 color[4];
+			glm::vec3 throughput[4];
+			for (int lane = 0; lane < 4; lane++)
+			{
+				int x = quadX + (lane & 1);
+				int y = quadY + (lane >> 1);
+				color[lane] = glm::vec3(0.0f);
+				throughput[lane] = glm::vec3(1.0f);
+				if ((x >= m_width) || (y >= m_height))
+				{
+					packet.originX[lane] = packet.originY[lane] = packet.originZ[lane] = 0.0f;
+					packet.directionX[lane] = packet.directionY[lane] = packet.directionZ[lane] = 1.0f;
+					packet.inverseX[lane] = packet.inverseY[lane] = packet.inverseZ[lane] = 1.0f;
+					packet.minDistance[lane] = 0.0f;
+					packet.maxDistance[lane] = 0.0f;
+					rayLength[lane] = 0.0f;
+					continue;
+				}
+
+				// the ray runs from the near plane to the far plane
+				// through the sample position
+				float sampleX = x + std::fmod(jitterX + GetPixelHash(x, y, 1), 1.0f);
+				float sampleY = y + std::fmod(jitterY + GetPixelHash(x, y, 2), 1.0f);
+				float ndcX = sampleX / (float)m_width * 2.0f - 1.0f;
+				float ndcY = sampleY / (float)m_height * 2.0f - 1.0f;
+				glm::vec4 nearPoint = m_inverseViewProjection * glm::vec4(ndcX, ndcY, -1.0f, 1.0f);
+				glm::vec4 farPoint = m_inverseViewProjection * glm::vec4(ndcX, ndcY, 1.0f, 1.0f);
+				glm::vec3 origin = glm::vec3(nearPoint) / nearPoint.w;
+				glm::vec3 toFar = glm::vec3(farPoint) / farPoint.w - origin;
+				rayLength[lane] = glm::length(toFar);
+				glm::vec3 direction = toFar / rayLength[lane];
+
+				packet.originX[lane] = origin.x;
+				packet.originY[lane] = origin.y;
+				packet.originZ[lane] = origin.z;
+				packet.directionX[lane] = direction.x;
+				packet.directionY[lane] = direction.y;
+				packet.directionZ[lane] = direction.z;
+				packet.inverseX[lane] = GetInverse(direction.x);
+				packet.inverseY[lane] = GetInverse(direction.y);
+				packet.inverseZ[lane] = GetInverse(direction.z);
+				packet.minDistance[lane] = 0.0f;
+				packet.maxDistance[lane] = rayLength[lane];
+				packet.activeMask |= 1 << lane;
+			}
+			int pixelMask = packet.activeMask;
+
+			for (int layer = 0; (layer < MAX_SURFACE_LAYERS) && (packet.activeMask != 0); layer++)
+			{
+				for (int lane = 0; lane < 4; lane++)
+				{
+					rayCount += (packet.activeMask >> lane) & 1;
+				}
+				TracePacket(packet, false);
+
+				SURFACE_POINT points[4];
+				glm::vec4 baseColors[4];
+				glm::vec3 shaded[4];
+				RAY_PACKET hits = packet;
+				for (int lane = 0; lane < 4; lane++)
+				{
+					if ((packet.activeMask & (1 << lane)) == 0)
+					{
+						continue;
+					}
+					if (packet.instance[lane] < 0)
+					{
+						color[lane] += throughput[lane] * m_backgroundColor;
+						hits.activeMask &= ~(1 << lane);
+						continue;
+					}
+					const TRACE_SURFACE& surface = m_instances[packet.instance[lane]].instance.surface;
+					GetSurfacePoint(packet, lane, points[lane]);
+					baseColors[lane] = GetBaseColor(surface, points[lane].textureCoordinate);
+					if (surface.bTransparent == false)
+					{
+						baseColors[lane].a = 1.0f;
+					}
+				}
+				rayCount += ShadePacket(hits, points, baseColors, shaded);
+
+				// carry on behind the transparent surfaces
+				packet.activeMask = 0;
+				for (int lane = 0; lane < 4; lane++)
+				{
+					if ((hits.activeMask & (1 << lane)) == 0)
+					{
+						continue;
+					}
+					float alpha = glm::clamp(baseColors[lane].a, 0.0f, 1.0f);
+					color[lane] += throughput[lane] * shaded[lane] * alpha;
+					throughput[lane] *= (1.0f - alpha);
+					if (std::max(throughput[lane].x, std::max(throughput[lane].y, throughput[lane].z)) < MIN_THROUGHPUT)
+					{
+						continue;
+					}
+					float offset = SURFACE_OFFSET * std::max(1.0f, packet.maxDistance[lane]);
+					packet.minDistance[lane] = packet.maxDistance[lane] + offset;
+					packet.maxDistance[lane] = rayLength[lane];
+					if (packet.minDistance[lane] < packet.maxDistance[lane])
+					{
+						packet.activeMask |= 1 << lane;
+					}
+				}
+			}
+
+			// rays that ran out of layers show the background
+			for (int lane = 0; lane < 4; lane++)
+			{
+				if ((pixelMask & (1 << lane)) == 0)
+				{
+					continue;
+				}
+				if ((packet.activeMask & (1 << lane)) != 0)
+				{
+					color[lane] += throughput[lane] * m_backgroundColor;
+				}
+				int x = quadX + (lane & 1);
+				int y = quadY + (lane >> 1);
+				m_accumulation[(size_t)y * m_width + x] += color[lane];
+			}
+		}
+	}
+	m_rayCount += rayCount;
+}
+
+/***********************************************************
+ *  RenderTiles()
+ *
+ *  This method is run by each thread rendering a pass.  It
+ *  takes the next tile until every tile has been taken.
+ ***********************************************************/
+void RayTracer::RenderTiles(std::atomic<int>* pNextTile, int tileCount, int tileCountX)
+{
+	while (true)
+	{
+		int tile = pNextTile->fetch_add(1);
+		if (tile >= tileCount)
+		{
+			break;
+		}
+		RenderTile(tile, tileCountX);
+	}
+}
@@ -0,0 +1,285 @@
+///////////////////////////////////////////////////////////////////////////////
+// raytracer.h
+// ============
+// render high quality stills of the scene on the CPU by tracing rays,
+// with shadows and antialiasing, and save them as image files
+//
+//  Created for CS-330-Computational Graphics and Visualization
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "ClusteredLighting.h"
+#include "MeshImporter.h"
+
+#include <glm/glm.hpp>
+
+#include <atomic>
+#include <vector>
+
+/***********************************************************
+ *  RayTracer
+ *
+ *  This class contains the code for ray tracing the scene
+ *  objects into an image.  Objects are drawn either with a
+ *  triangle mesh or with an exact sphere or cylinder, which
+ *  keeps their outlines round however close the camera is.
+ *  It uses two levels of bounding volume hierarchies, both
+ *  split with the surface area heuristic:
+ *
+ *    instances   the world space bounds of every object
+ *    meshes      the triangles of each mesh in its own space
+ *
+ *  Rays are traced in packets of four, one for each pixel of
+ *  a two by two square, with the bounds of a node tested
+ *  against the whole packet at once with SSE2.  The shadow
+ *  rays of a packet towards each light are traced together
+ *  in the same way.
+ *
+ *  The image is built up over passes, each adding one more
+ *  sample to every pixel at a different place inside it.
+ *  The screen is split into tiles that worker threads take
+ *  until every tile of the pass is done.  The lighting is
+ *  the same Phong lighting as the scene fragment shader,
+ *  with the diffuse and specular light of each light source
+ *  blocked by the opaque objects in the way.
+ ***********************************************************/
+class RayTracer
+{
+public:
+	// the surface an object is drawn with, matching the uniforms
+	// of the scene shader
+	struct TRACE_SURFACE
+	{
+		// texture index, or -1 to draw with the color
+		int texture;
+		glm::vec2 UVscale;
+		glm::vec4 color;
+		bool bUseLighting;
+		// keep the alpha of the color or texture, letting the
+		// objects behind show through
+		bool bTransparent;
+		glm::vec3 ambientColor;
+		float ambientStrength;
+		glm::vec3 diffuseColor;
+		glm::vec3 specularColor;
+	};
+
+	// the shape an object is traced with
+	enum SHAPE_TYPE
+	{
+		// a mesh added with AddMesh()
+		SHAPE_MESH = 0,
+		// a sphere of radius 1 around the origin
+		SHAPE_SPHERE,
+		// a cylinder of radius 1 standing on the origin, 1 unit
+		// high along the Y axis, with both ends closed
+		SHAPE_CYLINDER
+	};
+
+	// an object to trace
+	struct TRACE_INSTANCE
+	{
+		SHAPE_TYPE shape;
+		// mesh index for SHAPE_MESH
+		int mesh;
+		glm::mat4 model;
+		TRACE_SURFACE surface;
+	};
+
+	// pixels along each side of the tiles the threads take
+	static const int TILE_SIZE = 16;
+
+	// constructor
+	RayTracer();
+	// destructor
+	~RayTracer();
+
+	// add a mesh, returning the index instances refer to it by
+	int AddMesh(const std::vector<MeshImporter::MESH_VERTEX>& vertices, const std::vector<unsigned int>& indices);
+	// add a texture from RGBA pixels, with the first row at the
+	// bottom, returning the index surfaces refer to it by
+	int AddTexture(const unsigned char* pixels, int width, int height);
+
+	// set the objects, building the hierarchy over them
+	void SetInstances(const std::vector<TRACE_INSTANCE>& instances);
+	// set the light sources and ambient light
+	void SetLights(
+		const std::vector<LIGHT_SOURCE>& lights,
+		const glm::vec3& ambientColor,
+		float ambientIntensity);
+	// set the view and projection the image is rendered with
+	void SetViewTransform(
+		const glm::mat4& view,
+		const glm::mat4& projection,
+		const glm::vec3& viewPosition);
+
+	// render an image of the passed in size, adding up the passed
+	// in number of samples for every pixel
+	void Render(int width, int height, int sampleCount, const glm::vec3& backgroundColor);
+	// save the rendered image as an uncompressed BMP file
+	bool SaveImage(const char* filePath) const;
+
+	// number of rays traced by the last Render(), counting the
+	// camera rays, the rays through transparent surfaces and the
+	// shadow rays
+	long long GetRayCount() const;
+	// time in seconds the last Render() took
+	double GetRenderTime() const;
+
+private:
+	// a node of a bounding volume hierarchy, which holds either
+	// two child nodes or a run of items
+	struct BVH_NODE
+	{
+		glm::vec3 boundsMin;
+		glm::vec3 boundsMax;
+		// first child node, or first item for a leaf
+		int first;
+		// number of items, zero for an inner node
+		int itemCount;
+		// axis the children were split along, for visiting the
+		// nearer child first
+		int axis;
+	};
+
+	// the triangles of a mesh, in the order the leaves refer to
+	// them, with the vertices they are shaded with
+	struct TRACE_MESH
+	{
+		std::vector<MeshImporter::MESH_VERTEX> vertices;
+		std::vector<unsigned int> indices;
+		std::vector<BVH_NODE> nodes;
+	};
+
+	// an object prepared for tracing
+	struct PREPARED_INSTANCE
+	{
+		TRACE_INSTANCE instance;
+		glm::mat4 worldToObject;
+		glm::mat3 normalMatrix;
+		glm::vec3 boundsMin;
+		glm::vec3 boundsMax;
+	};
+
+	struct TRACE_TEXTURE
+	{
+		int width;
+		int height;
+		std::vector<unsigned char> texels;
+	};
+
+	// four rays traced together, one in each lane, with the
+	// closest surface found so far along each
+	struct RAY_PACKET
+	{
+		float originX[4];
+		float originY[4];
+		float originZ[4];
+		float directionX[4];
+		float directionY[4];
+		float directionZ[4];
+		float inverseX[4];
+		float inverseY[4];
+		float inverseZ[4];
+		// the part of each ray that is searched
+		float minDistance[4];
+		float maxDistance[4];
+		// lanes that are traced
+		int activeMask;
+		// the surface found in each lane, as the instance, the
+		// triangle or -1 for an exact shape, and the barycentric
+		// coordinates on the triangle
+		int instance[4];
+		int triangle[4];
+		float u[4];
+		float v[4];
+	};
+
+	// the values a surface is lit with at a hit
+	struct SURFACE_POINT
+	{
+		glm::vec3 position;
+		glm::vec3 normal;
+		glm::vec3 offsetNormal;
+		glm::vec2 textureCoordinate;
+	};
+
+	std::vector<TRACE_MESH> m_meshes;
+	std::vector<TRACE_TEXTURE> m_textures;
+	std::vector<PREPARED_INSTANCE> m_instances;
+	// instance indices in the order the leaf nodes refer to them
+	std::vector<int> m_instanceOrder;
+	std::vector<BVH_NODE> m_nodes;
+
+	std::vector<LIGHT_SOURCE> m_lights;
+	std::vector<glm::vec3> m_lightDirections;
+	std::vector<float> m_innerConeCosines;
+	std::vector<float> m_outerConeCosines;
+	glm::vec3 m_ambientLight;
+
+	glm::mat4 m_inverseViewProjection;
+	glm::vec3 m_viewPosition;
+
+	// image size, the sums of the samples of every pixel with the
+	// bottom row first, and the samples added so far
+	int m_width;
+	int m_height;
+	std::vector<glm::vec3> m_accumulation;
+	int m_sampleCount;
+	glm::vec3 m_backgroundColor;
+
+	std::atomic<long long> m_rayCount;
+	double m_renderTime;
+
+	// fill in a node of a hierarchy over a run of items, splitting
+	// it where the surface area heuristic finds it cheapest
+	static void BuildNode(
+		const std::vector<glm::vec3>& itemMin,
+		const std::vector<glm::vec3>& itemMax,
+		std::vector<int>& order,
+		std::vector<BVH_NODE>& nodes,
+		int nodeIndex,
+		int first,
+		int count,
+		int leafSize);
+	// test the bounds of a node against the active lanes of a
+	// packet, returning the lanes that reach it
+	static int IntersectPacketBounds(
+		const RAY_PACKET& packet,
+		const glm::vec3& boundsMin,
+		const glm::vec3& boundsMax);
+	// find the closest surfaces of a mesh along a packet in the
+	// mesh's space, or any surface at all for shadow rays
+	static void IntersectMesh(const TRACE_MESH& mesh, int instance, RAY_PACKET& packet, bool bAnyHit);
+	// find the closest surface of an exact shape along one lane
+	static bool IntersectShape(
+		SHAPE_TYPE shape,
+		const glm::vec3& origin,
+		const glm::vec3& direction,
+		float minDistance,
+		float& distance);
+
+	// trace a packet through the objects, finding the closest
+	// surface of each lane, or any opaque surface for shadow rays
+	void TracePacket(RAY_PACKET& packet, bool bAnyHit) const;
+	// get the position, normal and texture coordinate of the
+	// surface found in a lane
+	void GetSurfacePoint(const RAY_PACKET& packet, int lane, SURFACE_POINT& point) const;
+	// get the color of a surface at a texture coordinate
+	glm::vec4 GetBaseColor(const TRACE_SURFACE& surface, const glm::vec2& textureCoordinate) const;
+	// sample a texture bilinearly
+	glm::vec4 SampleTexture(int texture, const glm::vec2& coordinate) const;
+	// light the surfaces found by a packet, tracing the shadow
+	// rays of each light as a packet of their own, and return the
+	// number of shadow rays
+	int ShadePacket(
+		const RAY_PACKET& packet,
+		const SURFACE_POINT* points,
+		const glm::vec4* baseColors,
+		glm::vec3* colors) const;
+	// add one sample to every pixel of a tile
+	void RenderTile(int tile, int tileCountX);
+	// take tiles of the pass until none are left
+	void RenderTiles(std::atomic<int>* pNextTile, int tileCount, int tileCountX);
+};
@@ -0,0 +1,755 @@
+///////////////////////////////////////////////////////////////////////////////
+// rendergraph.cpp
+// ============
+// declare the passes of a frame with the targets they read and write, then
+// cull, order and run them, sharing one pool of transient targets
+//
+//  Created for CS-330-Computational Graphics and Visualization
+///////////////////////////////////////////////////////////////////////////////
+
+#include "RenderGraph.h"
+
+#include <algorithm>
+#include <iostream>
+#include <sstream>
+
+// declaration of the global variables and defines
+namespace
+{
+	// frames a pool texture is kept without being used, so a
+	// target that is only skipped for a moment is not recreated
+	const int POOL_KEEP_FRAMES = 60;
+
+	// how a texture format is allocated and attached
+	struct FORMAT_INFO
+	{
+		GLenum internalFormat;
+		GLenum format;
+		GLenum type;
+		int bytesPerPixel;
+		GLenum attachment;
+	};
+
+	// the formats transient targets can be created with
+	const FORMAT_INFO g_Formats[] =
+	{
+		{ GL_RGBA8, GL_RGBA, GL_UNSIGNED_BYTE, 4, GL_COLOR_ATTACHMENT0 },
+		{ GL_RG16, GL_RG, GL_UNSIGNED_SHORT, 4, GL_COLOR_ATTACHMENT0 },
+		{ GL_R32F, GL_RED, GL_FLOAT, 4, GL_COLOR_ATTACHMENT0 },
+		{ GL_RGBA16F, GL_RGBA, GL_HALF_FLOAT, 8, GL_COLOR_ATTACHMENT0 },
+		{ GL_RGBA32F, GL_RGBA, GL_FLOAT, 16, GL_COLOR_ATTACHMENT0 },
+		{ GL_DEPTH_COMPONENT24, GL_DEPTH_COMPONENT, GL_UNSIGNED_INT, 4, GL_DEPTH_ATTACHMENT },
+		{ GL_DEPTH_COMPONENT32F, GL_DEPTH_COMPONENT, GL_FLOAT, 4, GL_DEPTH_ATTACHMENT },
+		{ GL_DEPTH24_STENCIL8, GL_DEPTH_STENCIL, GL_UNSIGNED_INT_24_8, 4, GL_DEPTH_STENCIL_ATTACHMENT }
+	};
+	const int FORMAT_COUNT = sizeof(g_Formats) / sizeof(g_Formats[0]);
+
+	/***********************************************************
+	 *  FindFormat()
+	 *
+	 *  This function is used to look up how a texture format
+	 *  is allocated, returning NULL for an unknown format.
+	 ***********************************************************/
+	const FORMAT_INFO* FindFormat(GLenum internalFormat)
+	{
+		for (int i = 0; i < FORMAT_COUNT; i++)
+		{
+			if (g_Formats[i].internalFormat == internalFormat)
+			{
+				return(&g_Formats[i]);
+			}
+		}
+		return(NULL);
+	}
+
+	/***********************************************************
+	 *  GetTextureBytes()
+	 *
+	 *  This function is used to get the memory a transient
+	 *  target takes up.
+	 ***********************************************************/
+	size_t GetTextureBytes(const RenderGraph::TEXTURE_DESC& desc)
+	{
+		const FORMAT_INFO* pFormat = FindFormat(desc.internalFormat);
+		return((size_t)desc.width * (size_t)desc.height * ((pFormat != NULL) ? pFormat->bytesPerPixel : 4));
+	}
+
+	/***********************************************************
+	 *  IsSameDesc()
+	 *
+	 *  This function is used to check whether two transient
+	 *  targets can share one texture.
+	 ***********************************************************/
+	bool IsSameDesc(const RenderGraph::TEXTURE_DESC& a, const RenderGraph::TEXTURE_DESC& b)
+	{
+		return((a.width == b.width) && (a.height == b.height) && (a.internalFormat == b.internalFormat));
+	}
+}
+
+/***********************************************************
+ *  RenderGraph()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+RenderGraph::RenderGraph()
+{
+	m_bCompiled = false;
+	m_culledPassCount = 0;
+	m_aliasedMemory = 0;
+	m_unaliasedMemory = 0;
+}
+
+/***********************************************************
+ *  ~RenderGraph()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+RenderGraph::~RenderGraph()
+{
+	for (size_t i = 0; i < m_pool.size(); i++)
+	{
+		DestroyPoolEntry(m_pool[i]);
+	}
+	m_pool.clear();
+}
+
+/***********************************************************
+ *  Reset()
+ *
+ *  This method is used for starting the declaration of a new
+ *  frame.  The pool textures and framebuffers are kept.
+ ***********************************************************/
+void RenderGraph::Reset()
+{
+	m_resources.clear();
+	m_passes.clear();
+	m_order.clear();
+	m_bCompiled = false;
+}
+
+/***********************************************************
+ *  CreateTexture()
+ *
+ *  This method is used for declaring a target that only
+ *  lives within the frame.  Its texture is given to it when
+ *  the frame is compiled.
+ ***********************************************************/
+int RenderGraph::CreateTexture(const char* name, const TEXTURE_DESC& desc)
+{
+	RESOURCE resource;
+	resource.name = name;
+	resource.bImported = false;
+	resource.desc = desc;
+	resource.framebuffer = 0;
+	resource.firstStep = -1;
+	resource.lastStep = -1;
+	resource.poolEntry = -1;
+	m_resources.push_back(resource);
+	return((int)m_resources.size() - 1);
+}
+
+/***********************************************************
+ *  ImportFramebuffer()
+ *
+ *  This method is used for declaring a framebuffer made
+ *  outside the graph.  The passes that write an imported
+ *  framebuffer, and the passes they need, are never culled.
+ ***********************************************************/
+int RenderGraph::ImportFramebuffer(const char* name, GLuint framebuffer, int width, int height)
+{
+	RESOURCE resource;
+	resource.name = name;
+	resource.bImported = true;
+	resource.desc.width = width;
+	resource.desc.height = height;
+	resource.desc.internalFormat = GL_NONE;
+	resource.framebuffer = framebuffer;
+	resource.firstStep = -1;
+	resource.lastStep = -1;
+	resource.poolEntry = -1;
+	m_resources.push_back(resource);
+	return((int)m_resources.size() - 1);
+}
+
+/***********************************************************
+ *  AddPass()
+ *
+ *  This method is used for declaring a pass of the frame.
+ *  The passes can be declared in any order that keeps the
+ *  writers of each target in the order they draw it.
+ ***********************************************************/
+int RenderGraph::AddPass(const char* name, const EXECUTE_FUNCTION& execute)
+{
+	PASS pass;
+	pass.name = name;
+	pass.execute = execute;
+	pass.bKeep = false;
+	pass.bCulled = false;
+	m_passes.push_back(pass);
+	return((int)m_passes.size() - 1);
+}
+
+/***********************************************************
+ *  ReadTexture()
+ *
+ *  This method is used for declaring a target a pass reads.
+ ***********************************************************/
+void RenderGraph::ReadTexture(int pass, int resource)
+{
+	m_passes[pass].reads.push_back(resource);
+}
+
+/***********************************************************
+ *  WriteTexture()
+ *
+ *  This method is used for declaring a target a pass draws
+ *  into.  Transient targets are attached in the order they
+ *  are declared, the color targets to the color attachments
+ *  and a depth target to the depth attachment.
+ ***********************************************************/
+void RenderGraph::WriteTexture(int pass, int resource)
+{
+	m_passes[pass].writes.push_back(resource);
+}
+
+/***********************************************************
+ *  KeepPass()
+ *
+ *  This method is used for keeping a pass that does not
+ *  write an imported framebuffer, but whose results are used
+ *  outside the graph, from being culled.
+ ***********************************************************/
+void RenderGraph::KeepPass(int pass)
+{
+	m_passes[pass].bKeep = true;
+}
+
+/***********************************************************
+ *  Compile()
+ *
+ *  This method is used for finding the order the passes run
+ *  in, culling the ones that are not needed, and giving the
+ *  transient targets their textures.  A message is shown
+ *  and false returned when a target is read before anything
+ *  writes it, a pass draws into targets that cannot be bound
+ *  together, or the passes depend on each other in a cycle.
+ ***********************************************************/
+bool RenderGraph::Compile()
+{
+	m_bCompiled = false;
+	m_order.clear();
+
+	if (FindDependencies() == false)
+	{
+		return(false);
+	}
+	CullPasses();
+	if (SortPasses() == false)
+	{
+		return(false);
+	}
+	AllocateTextures();
+	ReportFrame();
+
+	m_bCompiled = true;
+	return(true);
+}
+
+/***********************************************************
+ *  Execute()
+ *
+ *  This method is used for running the compiled passes.
+ *  Each pass is called with the framebuffer it draws into
+ *  bound and the viewport covering it.  The window
+ *  framebuffer is bound again afterwards.
+ ***********************************************************/
+void RenderGraph::Execute()
+{
+	if (m_bCompiled == false)
+	{
+		return;
+	}
+
+	for (size_t i = 0; i < m_order.size(); i++)
+	{
+		const PASS& pass = m_passes[m_order[i]];
+		BindTarget(pass);
+		pass.execute(*this);
+	}
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
+
+/***********************************************************
+ *  GetTexture()
+ *
+ *  This method returns the texture a transient target was
+ *  given, or zero for an imported or culled target.
+ ***********************************************************/
+GLuint RenderGraph::GetTexture(int resource) const
+{
+	const RESOURCE& target = m_resources[resource];
+	if ((target.bImported == true) || (target.poolEntry < 0))
+	{
+		return(0);
+	}
+	return(m_pool[target.poolEntry].texture);
+}
+
+/***********************************************************
+ *  GetCulledPassCount()
+ *
+ *  This method returns the number of passes culled from the
+ *  compiled frame.
+ ***********************************************************/
+int RenderGraph::GetCulledPassCount() const
+{
+	return(m_culledPassCount);
+}
+
+/***********************************************************
+ *  GetAliasedMemory()
+ *
+ *  This method returns the bytes of the pool textures the
+ *  compiled frame uses.
+ ***********************************************************/
+size_t RenderGraph::GetAliasedMemory() const
+{
+	return(m_aliasedMemory);
+}
+
+/***********************************************************
+ *  GetUnaliasedMemory()
+ *
+ *  This method returns the bytes the transient targets of
+ *  the compiled frame would use with a texture each.
+ ***********************************************************/
+size_t RenderGraph::GetUnaliasedMemory() const
+{
+	return(m_unaliasedMemory);
+}
+
+/***********************************************************
+ *  FindDependencies()
+ *
+ *  This method is used for finding the passes each pass must
+ *  run after.  The writers of a target follow each other in
+ *  the order they were declared, and a pass that only reads
+ *  a target follows its last writer.
+ ***********************************************************/
+bool RenderGraph::FindDependencies()
+{
+	for (size_t p = 0; p < m_passes.size(); p++)
+	{
+		PASS& pass = m_passes[p];
+		pass.dependencies.clear();
+		pass.bCulled = false;
+
+		// a pass draws into one framebuffer, either an imported one
+		// or the one made for its transient targets
+		int importedWrites = 0;
+		for (size_t i = 0; i < pass.writes.size(); i++)
+		{
+			if (m_resources[pass.writes[i]].bImported == true)
+			{
+				importedWrites++;
+			}
+			else if (FindFormat(m_resources[pass.writes[i]].desc.internalFormat) == NULL)
+			{
+				std::cout << "ERROR::RENDER_GRAPH_UNKNOWN_FORMAT: " << m_resources[pass.writes[i]].name << std::endl;
+				return(false);
+			}
+		}
+		if ((importedWrites > 1) || ((importedWrites == 1) && (pass.writes.size() > 1)))
+		{
+			std::cout << "ERROR::RENDER_GRAPH_MIXED_TARGETS: " << pass.name << std::endl;
+			return(false);
+		}
+	}
+
+	for (int r = 0; r < (int)m_resources.size(); r++)
+	{
+		int lastWriter = -1;
+		for (int p = 0; p < (int)m_passes.size(); p++)
+		{
+			PASS& pass = m_passes[p];
+			if (std::find(pass.writes.begin(), pass.writes.end(), r) == pass.writes.end())
+			{
+				continue;
+			}
+			if (lastWriter >= 0)
+			{
+				pass.dependencies.push_back(lastWriter);
+			}
+			lastWriter = p;
+		}
+
+		for (int p = 0; p < (int)m_passes.size(); p++)
+		{
+			PASS& pass = m_passes[p];
+			if ((std::find(pass.reads.begin(), pass.reads.end(), r) == pass.reads.end()) ||
+				(std::find(pass.writes.begin(), pass.writes.end(), r) != pass.writes.end()))
+			{
+				continue;
+			}
+			if (lastWriter >= 0)
+			{
+				pass.dependencies.push_back(lastWriter);
+			}
+			else if (m_resources[r].bImported == false)
+			{
+				std::cout << "ERROR::RENDER_GRAPH_UNWRITTEN_TARGET: " << m_resources[r].name
+					<< " read by " << pass.name << std::endl;
+				return(false);
+			}
+		}
+	}
+	return(true);
+}
+
+/***********************************************************
+ *  CullPasses()
+ *
+ *  This method is used for culling the passes that neither
+ *  write an imported framebuffer nor were kept, and that no
+ *  such pass needs.
+ ***********************************************************/
+void RenderGraph::CullPasses()
+{
+	std::vector<int> needed;
+	for (size_t p = 0; p < m_passes.size(); p++)
+	{
+		PASS& pass = m_passes[p];
+		pass.bCulled = true;
+		bool bRoot = pass.bKeep;
+		for (size_t i = 0; i < pass.writes.size(); i++)
+		{
+			if (m_resources[pass.writes[i]].bImported == true)
+			{
+				bRoot = true;
+			}
+		}
+		if (bRoot == true)
+		{
+			pass.bCulled = false;
+			needed.push_back((int)p);
+		}
+	}
+
+	// walk back from the kept passes through what they depend on
+	while (needed.empty() == false)
+	{
+		int p = needed.back();
+		needed.pop_back();
+		const std::vector<int>& dependencies = m_passes[p].dependencies;
+		for (size_t i = 0; i < dependencies.size(); i++)
+		{
+			if (m_passes[dependencies[i]].bCulled == true)
+			{
+				m_passes[dependencies[i]].bCulled = false;
+				needed.push_back(dependencies[i]);
+			}
+		}
+	}
+
+	m_culledPassCount = 0;
+	for (size_t p = 0; p < m_passes.size(); p++)
+	{
+		if (m_passes[p].bCulled == true)
+		{
+			m_culledPassCount++;
+		}
+	}
+}
+
+/***********************************************************
+ *  SortPasses()
+ *
+ *  This method is used for ordering the passes that are not
+ *  culled so each runs after the passes it depends on.  Of
+ *  the passes that are ready, the one declared first runs
+ *  next.
+ ***********************************************************/
+bool RenderGraph::SortPasses()
+{
+	int passCount = (int)m_passes.size() - m_culledPassCount;
+	std::vector<bool> bScheduled(m_passes.size(), false);
+	while ((int)m_order.size() < passCount)
+	{
+		int next = -1;
+		for (size_t p = 0; (p < m_passes.size()) && (next < 0); p++)
+		{
+			if ((m_passes[p].bCulled == true) || (bScheduled[p] == true))
+			{
+				continue;
+			}
+			bool bReady = true;
+			const std::vector<int>& dependencies = m_passes[p].dependencies;
+			for (size_t i = 0; i < dependencies.size(); i++)
+			{
+				if (bScheduled[dependencies[i]] == false)
+				{
+					bReady = false;
+				}
+			}
+			if (bReady == true)
+			{
+				next = (int)p;
+			}
+		}
+
+		if (next < 0)
+		{
+			std::cout << "ERROR::RENDER_GRAPH_CYCLE: passes depend on each other" << std::endl;
+			m_order.clear();
+			return(false);
+		}
+		bScheduled[next] = true;
+		m_order.push_back(next);
+	}
+	return(true);
+}
+
+/***********************************************************
+ *  AllocateTextures()
+ *
+ *  This method is used for giving each transient target that
+ *  a pass uses a texture from the pool.  The targets are
+ *  taken in the order they are first used, and each takes
+ *  a free texture of its size and format, or a new one, and
+ *  keeps it until its last use.  Pool textures that have
+ *  gone unused for a while are freed first.
+ ***********************************************************/
+void RenderGraph::AllocateTextures()
+{
+	for (size_t i = 0; i < m_pool.size(); )
+	{
+		if (m_pool[i].unusedFrames > POOL_KEEP_FRAMES)
+		{
+			DestroyPoolEntry(m_pool[i]);
+			m_pool.erase(m_pool.begin() + i);
+		}
+		else
+		{
+			m_pool[i].busyUntil = -1;
+			i++;
+		}
+	}
+
+	// find the steps each target is used in
+	std::vector<int> transients;
+	for (size_t step = 0; step < m_order.size(); step++)
+	{
+		const PASS& pass = m_passes[m_order[step]];
+		for (int list = 0; list < 2; list++)
+		{
+			const std::vector<int>& resources = (list == 0) ? pass.reads : pass.writes;
+			for (size_t i = 0; i < resources.size(); i++)
+			{
+				RESOURCE& resource = m_resources[resources[i]];
+				if (resource.firstStep < 0)
+				{
+					resource.firstStep = (int)step;
+					if (resource.bImported == false)
+					{
+						transients.push_back(resources[i]);
+					}
+				}
+				resource.lastStep = (int)step;
+			}
+		}
+	}
+
+	std::vector<bool> bUsed(m_pool.size(), false);
+	m_unaliasedMemory = 0;
+	for (size_t i = 0; i < transients.size(); i++)
+	{
+		RESOURCE& resource = m_resources[transients[i]];
+		m_unaliasedMemory += GetTextureBytes(resource.desc);
+
+		for (size_t entry = 0; (entry < m_pool.size()) && (resource.poolEntry < 0); entry++)
+		{
+			if ((IsSameDesc(m_pool[entry].desc, resource.desc) == true) &&
+				(m_pool[entry].busyUntil < resource.firstStep))
+			{
+				resource.poolEntry = (int)entry;
+			}
+		}
+
+		if (resource.poolEntry < 0)
+		{
+			const FORMAT_INFO* pFormat = FindFormat(resource.desc.internalFormat);
+			GLenum filter = (pFormat->attachment == GL_COLOR_ATTACHMENT0) ? GL_LINEAR : GL_NEAREST;
+
+			POOL_ENTRY entry;
+			entry.desc = resource.desc;
+			entry.busyUntil = -1;
+			entry.unusedFrames = 0;
+			glGenTextures(1, &entry.texture);
+			glBindTexture(GL_TEXTURE_2D, entry.texture);
+			glTexImage2D(GL_TEXTURE_2D, 0, pFormat->internalFormat, resource.desc.width, resource.desc.height, 0,
+				pFormat->format, pFormat->type, NULL);
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, filter);
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, filter);
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+			glBindTexture(GL_TEXTURE_2D, 0);
+			m_pool.push_back(entry);
+			bUsed.push_back(false);
+			resource.poolEntry = (int)m_pool.size() - 1;
+		}
+
+		m_pool[resource.poolEntry].busyUntil = resource.lastStep;
+		bUsed[resource.poolEntry] = true;
+	}
+
+	m_aliasedMemory = 0;
+	for (size_t i = 0; i < m_pool.size(); i++)
+	{
+		if (bUsed[i] == true)
+		{
+			m_aliasedMemory += GetTextureBytes(m_pool[i].desc);
+			m_pool[i].unusedFrames = 0;
+		}
+		else
+		{
+			m_pool[i].unusedFrames++;
+		}
+	}
+}
+
+/***********************************************************
+ *  DestroyPoolEntry()
+ *
+ *  This method is used for freeing a pool texture, and the
+ *  framebuffers it is attached to.
+ ***********************************************************/
+void RenderGraph::DestroyPoolEntry(POOL_ENTRY& entry)
+{
+	std::map<std::vector<GLuint>, GLuint>::iterator it = m_framebuffers.begin();
+	while (it != m_framebuffers.end())
+	{
+		if (std::find(it->first.begin(), it->first.end(), entry.texture) != it->first.end())
+		{
+			glDeleteFramebuffers(1, &it->second);
+			it = m_framebuffers.erase(it);
+		}
+		else
+		{
+			++it;
+		}
+	}
+
+	if (0 != entry.texture)
+	{
+		glDeleteTextures(1, &entry.texture);
+		entry.texture = 0;
+	}
+}
+
+/***********************************************************
+ *  BindTarget()
+ *
+ *  This method is used for binding the framebuffer a pass
+ *  draws into and setting the viewport to its size.  The
+ *  framebuffer for a set of transient textures is made the
+ *  first time it is needed and kept with the pool.  A pass
+ *  that writes nothing is left with whatever is bound.
+ ***********************************************************/
+void RenderGraph::BindTarget(const PASS& pass)
+{
+	if (pass.writes.empty() == true)
+	{
+		return;
+	}
+
+	const RESOURCE& first = m_resources[pass.writes[0]];
+	if (first.bImported == true)
+	{
+		glBindFramebuffer(GL_FRAMEBUFFER, first.framebuffer);
+		glViewport(0, 0, first.desc.width, first.desc.height);
+		return;
+	}
+
+	std::vector<GLuint> textures;
+	for (size_t i = 0; i < pass.writes.size(); i++)
+	{
+		textures.push_back(GetTexture(pass.writes[i]));
+	}
+
+	std::map<std::vector<GLuint>, GLuint>::iterator it = m_framebuffers.find(textures);
+	if (it != m_framebuffers.end())
+	{
+		glBindFramebuffer(GL_FRAMEBUFFER, it->second);
+	}
+	else
+	{
+		GLuint framebuffer = 0;
+		glGenFramebuffers(1, &framebuffer);
+		glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+
+		std::vector<GLenum> drawBuffers;
+		for (size_t i = 0; i < pass.writes.size(); i++)
+		{
+			const FORMAT_INFO* pFormat = FindFormat(m_resources[pass.writes[i]].desc.internalFormat);
+			GLenum attachment = pFormat->attachment;
+			if (attachment == GL_COLOR_ATTACHMENT0)
+			{
+				attachment = GL_COLOR_ATTACHMENT0 + (GLenum)drawBuffers.size();
+				drawBuffers.push_back(attachment);
+			}
+			glFramebufferTexture2D(GL_FRAMEBUFFER, attachment, GL_TEXTURE_2D, textures[i], 0);
+		}
+		if (drawBuffers.empty() == true)
+		{
+			glDrawBuffer(GL_NONE);
+		}
+		else
+		{
+			glDrawBuffers((GLsizei)drawBuffers.size(), &drawBuffers[0]);
+		}
+
+		GLenum status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+		if (status != GL_FRAMEBUFFER_COMPLETE)
+		{
+			std::cout << "ERROR::RENDER_GRAPH_INCOMPLETE_FRAMEBUFFER: " << pass.name << ", " << status << std::endl;
+		}
+		m_framebuffers[textures] = framebuffer;
+	}
+	glViewport(0, 0, first.desc.width, first.desc.height);
+}
+
+/***********************************************************
+ *  ReportFrame()
+ *
+ *  This method is used for printing the order of the passes,
+ *  the culled passes and the transient memory with and
+ *  without sharing textures, whenever any of them changes.
+ ***********************************************************/
+void RenderGraph::ReportFrame()
+{
+	std::ostringstream report;
+	report << "INFO: Render graph: ";
+	for (size_t i = 0; i < m_order.size(); i++)
+	{
+		report << ((i > 0) ? " -> " : "") << m_passes[m_order[i]].name;
+	}
+	if (m_culledPassCount > 0)
+	{
+		report << ", culled:";
+		for (size_t p = 0; p < m_passes.size(); p++)
+		{
+			if (m_passes[p].bCulled == true)
+			{
+				report << " " << m_passes[p].name;
+			}
+		}
+	}
+	report << ", transient memory: " << m_aliasedMemory / (1024.0 * 1024.0) << " MB aliased, "
+		<< m_unaliasedMemory / (1024.0 * 1024.0) << " MB without aliasing";
+
+	if (report.str() != m_lastReport)
+	{
+		m_lastReport = report.str();
+		std::cout << m_lastReport << std::endl;
+	}
+}
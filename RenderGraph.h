@@ -0,0 +1,169 @@
+///////////////////////////////////////////////////////////////////////////////
+// rendergraph.h
+// ============
+// declare the passes of a frame with the targets they read and write, then
+// cull, order and run them, sharing one pool of transient targets
+//
+//  Created for CS-330-Computational Graphics and Visualization
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <GL/glew.h>
+
+#include <functional>
+#include <map>
+#include <string>
+#include <vector>
+
+/***********************************************************
+ *  RenderGraph
+ *
+ *  This class contains the code for building each frame out
+ *  of passes instead of binding framebuffers by hand.  Every
+ *  frame the passes are declared again, each with the
+ *  targets it reads and writes:
+ *
+ *    transient   a texture that only lives within the frame,
+ *                described by its size and format
+ *    imported    a framebuffer made outside the graph, such
+ *                as the window, whose contents are kept
+ *
+ *  Compiling the frame orders the passes so that the writers
+ *  of a target run in the order they were declared, before
+ *  any pass that only reads it.  Passes whose results never
+ *  reach an imported target are culled.  The transient
+ *  targets are then given textures from a pool kept between
+ *  frames, with targets of the same size and format sharing
+ *  one texture when their lifetimes do not overlap, so the
+ *  contents of a transient target are undefined when the
+ *  first pass that writes it starts.  Running the frame
+ *  binds a framebuffer with the targets each pass writes
+ *  attached, and calls the pass.
+ ***********************************************************/
+class RenderGraph
+{
+public:
+	// the size and format of a transient target
+	struct TEXTURE_DESC
+	{
+		int width;
+		int height;
+		GLenum internalFormat;
+	};
+
+	// draws a pass, looking its targets up in the passed in graph
+	typedef std::function<void(const RenderGraph& graph)> EXECUTE_FUNCTION;
+
+	// constructor
+	RenderGraph();
+	// destructor
+	~RenderGraph();
+
+	// forget the passes and targets of the last frame
+	void Reset();
+	// declare a target that only lives within the frame.  the
+	// name must stay valid until the next Reset()
+	int CreateTexture(const char* name, const TEXTURE_DESC& desc);
+	// declare a framebuffer made outside the graph
+	int ImportFramebuffer(const char* name, GLuint framebuffer, int width, int height);
+
+	// declare a pass, returning the index its targets are
+	// declared with
+	int AddPass(const char* name, const EXECUTE_FUNCTION& execute);
+	// declare a target the pass samples from
+	void ReadTexture(int pass, int resource);
+	// declare a target the pass draws into.  a pass draws into
+	// either one imported framebuffer or transient targets
+	void WriteTexture(int pass, int resource);
+	// keep a pass whose results are used outside the graph
+	void KeepPass(int pass);
+
+	// cull and order the passes and give the transient targets
+	// their textures, returning false when the frame is invalid
+	bool Compile();
+	// run the passes in the compiled order
+	void Execute();
+
+	// get the texture of a transient target
+	GLuint GetTexture(int resource) const;
+
+	// number of passes that were culled from the frame
+	int GetCulledPassCount() const;
+	// bytes of the transient targets, as allocated from the pool
+	// and as they would be with one texture for each target
+	size_t GetAliasedMemory() const;
+	size_t GetUnaliasedMemory() const;
+
+private:
+	// a target declared for the frame
+	struct RESOURCE
+	{
+		const char* name;
+		bool bImported;
+		TEXTURE_DESC desc;
+		// framebuffer of an imported target
+		GLuint framebuffer;
+		// first and last steps of the frame that use it, and the
+		// pool texture it was given
+		int firstStep;
+		int lastStep;
+		int poolEntry;
+	};
+
+	// a pass declared for the frame
+	struct PASS
+	{
+		const char* name;
+		EXECUTE_FUNCTION execute;
+		std::vector<int> reads;
+		std::vector<int> writes;
+		bool bKeep;
+		bool bCulled;
+		// passes that must run before this one
+		std::vector<int> dependencies;
+	};
+
+	// a texture of the transient pool
+	struct POOL_ENTRY
+	{
+		TEXTURE_DESC desc;
+		GLuint texture;
+		// last step of the frame it is in use until, or -1
+		int busyUntil;
+		// frames in a row it has not been used
+		int unusedFrames;
+	};
+
+	std::vector<RESOURCE> m_resources;
+	std::vector<PASS> m_passes;
+	// the passes that are run, in order
+	std::vector<int> m_order;
+	bool m_bCompiled;
+
+	// textures shared by the transient targets, and framebuffers
+	// made for each set of textures a pass writes
+	std::vector<POOL_ENTRY> m_pool;
+	std::map<std::vector<GLuint>, GLuint> m_framebuffers;
+
+	int m_culledPassCount;
+	size_t m_aliasedMemory;
+	size_t m_unaliasedMemory;
+	// the last report printed, so it is only printed on a change
+	std::string m_lastReport;
+
+	// find the passes each pass must run after
+	bool FindDependencies();
+	// mark the passes that do not reach an imported target
+	void CullPasses();
+	// order the passes that are left
+	bool SortPasses();
+	// give the transient targets textures from the pool
+	void AllocateTextures();
+	// free a pool texture and the framebuffers it is attached to
+	void DestroyPoolEntry(POOL_ENTRY& entry);
+	// bind the framebuffer a pass draws into
+	void BindTarget(const PASS& pass);
+	// print the order and memory of the frame when it has changed
+	void ReportFrame();
+};
@@ -0,0 +1,687 @@
+///////////////////////////////////////////////////////////////////////////////
+// scenefile.cpp
+// ============
+// read the cooked binary scene files that hold the textures, model files,
+// materials and objects of a scene, and cook them from JSON layouts
+//
+//  Created for CS-330-Computational Graphics and Visualization
+///////////////////////////////////////////////////////////////////////////////
+
+#include "SceneFile.h"
+#include "JsonReader.h"
+
+#include <glm/glm.hpp>
+#include <glm/gtx/transform.hpp>
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <string>
+#include <vector>
+
+#include <sys/stat.h>
+#include <sys/types.h>
+
+// declaration of the global variables and defines
+namespace
+{
+	// identifies a cooked scene file written by Cook()
+	const unsigned int SCENE_FILE_MAGIC = 0x454E4353;	// "SCNE"
+	// increase when the layout of the cooked files changes
+	const unsigned int SCENE_FILE_VERSION = 1;
+
+	// names of the basic shapes in the JSON layouts, in the
+	// order of SceneFile::SHAPE
+	const char* const SHAPE_NAMES[SceneFile::SHAPE_COUNT] =
+	{
+		"plane",
+		"box",
+		"cylinder",
+		"cone",
+		"sphere",
+		"halfSphere",
+		"torus",
+		"halfTorus"
+	};
+
+	// extensions of a cooked file and of the layout beside it
+	const char* const SCENE_EXTENSION = ".scene";
+	const char* const LAYOUT_EXTENSION = ".json";
+
+	typedef JsonReader::JSON_VALUE JSON_VALUE;
+
+	/***********************************************************
+	 *  GetModifiedTime()
+	 *
+	 *  This function is used to get the time a file was last
+	 *  written, in seconds, or -1 when it is missing.
+	 ***********************************************************/
+	long long GetModifiedTime(const std::string& filePath)
+	{
+		struct stat fileStatus;
+		if (stat(filePath.c_str(), &fileStatus) != 0)
+		{
+			return(-1);
+		}
+		return((long long)fileStatus.st_mtime);
+	}
+
+	/***********************************************************
+	 *  STRING_TABLE
+	 *
+	 *  The strings of a file being cooked.  Each string is
+	 *  stored once, and the empty string is at offset zero.
+	 ***********************************************************/
+	struct STRING_TABLE
+	{
+		std::vector<char> bytes;
+		std::map<std::string, unsigned int> offsets;
+
+		STRING_TABLE() : bytes(1, '\0') {}
+
+		unsigned int Add(const std::string& text)
+		{
+			if (text.empty() == true)
+			{
+				return(0);
+			}
+			std::map<std::string, unsigned int>::const_iterator found = offsets.find(text);
+			if (found != offsets.end())
+			{
+				return(found->second);
+			}
+			unsigned int offset = (unsigned int)bytes.size();
+			bytes.insert(bytes.end(), text.begin(), text.end());
+			bytes.push_back('\0');
+			offsets[text] = offset;
+			return(offset);
+		}
+	};
+
+	/***********************************************************
+	 *  GetFloats()
+	 *
+	 *  This function is used to read a member array of numbers
+	 *  into floats, leaving the defaults in place when it is
+	 *  missing.  Returns false when the member has the wrong
+	 *  type or length.
+	 ***********************************************************/
+	bool GetFloats(const JSON_VALUE& object, const char* name, float* values, size_t count)
+	{
+		const JSON_VALUE* pArray = JsonReader::FindMember(object, name);
+		if (pArray == NULL)
+		{
+			return(true);
+		}
+		if ((pArray->type != JSON_VALUE::JSON_ARRAY) || (pArray->items.size() != count))
+		{
+			return(false);
+		}
+		for (size_t i = 0; i < count; i++)
+		{
+			if (pArray->items[i].type != JSON_VALUE::JSON_NUMBER)
+			{
+				return(false);
+			}
+			values[i] = (float)pArray->items[i].number;
+		}
+		return(true);
+	}
+
+	/***********************************************************
+	 *  FindTag()
+	 *
+	 *  This function is used to find the index of the record
+	 *  with the passed in tag, or -1 when there is none.
+	 ***********************************************************/
+	int FindTag(const std::vector<std::string>& tags, const std::string& tag)
+	{
+		for (size_t i = 0; i < tags.size(); i++)
+		{
+			if (tags[i] == tag)
+			{
+				return((int)i);
+			}
+		}
+		return(-1);
+	}
+
+	/***********************************************************
+	 *  ReadAssets()
+	 *
+	 *  This function is used to read the texture or model file
+	 *  list of a JSON layout, keeping the tags for looking up
+	 *  the references of the objects.
+	 ***********************************************************/
+	bool ReadAssets(
+		const JSON_VALUE& document,
+		const char* name,
+		std::vector<std::string>& tags,
+		std::vector<std::string>& paths)
+	{
+		const JSON_VALUE* pList = JsonReader::FindMember(document, name);
+		if (pList == NULL)
+		{
+			return(true);
+		}
+		for (size_t i = 0; i < pList->items.size(); i++)
+		{
+			std::string tag = JsonReader::GetString(pList->items[i], "tag", "");
+			std::string path = JsonReader::GetString(pList->items[i], "path", "");
+			if ((tag.empty() == true) || (path.empty() == true))
+			{
+				std::cout << "ERROR::SCENE_FILE::" << name << " entry " << i
+					<< " needs a tag and a path" << std::endl;
+				return(false);
+			}
+			tags.push_back(tag);
+			paths.push_back(path);
+		}
+		return(true);
+	}
+
+	/***********************************************************
+	 *  WriteAssets()
+	 *
+	 *  This function is used to turn the tags and paths of a
+	 *  texture or model file list into records.
+	 ***********************************************************/
+	void WriteAssets(
+		const std::vector<std::string>& tags,
+		const std::vector<std::string>& paths,
+		STRING_TABLE& strings,
+		std::vector<SceneFile::ASSET_RECORD>& records)
+	{
+		records.resize(tags.size());
+		for (size_t i = 0; i < tags.size(); i++)
+		{
+			records[i].tagOffset = strings.Add(tags[i]);
+			records[i].pathOffset = strings.Add(paths[i]);
+		}
+	}
+
+	/***********************************************************
+	 *  CookObject()
+	 *
+	 *  This function is used to cook one object of a JSON
+	 *  layout.  The transform is either a whole matrix, or a
+	 *  scale, rotation in degrees and position that are put
+	 *  together like SceneManager::SetTransformations() does.
+	 ***********************************************************/
+	bool CookObject(
+		const JSON_VALUE& object,
+		const std::vector<std::string>& textureTags,
+		const std::vector<std::string>& meshTags,
+		const std::vector<std::string>& materialTags,
+		SceneFile::OBJECT_RECORD& record)
+	{
+		float scale[3] = { 1.0f, 1.0f, 1.0f };
+		float rotation[3] = { 0.0f, 0.0f, 0.0f };
+		float position[3] = { 0.0f, 0.0f, 0.0f };
+		float matrix[16] = {};
+		record.color[0] = record.color[1] = record.color[2] = record.color[3] = 1.0f;
+		record.UVscale[0] = record.UVscale[1] = 1.0f;
+		if ((GetFloats(object, "scale", scale, 3) == false) ||
+			(GetFloats(object, "rotation", rotation, 3) == false) ||
+			(GetFloats(object, "position", position, 3) == false) ||
+			(GetFloats(object, "color", record.color, 4) == false) ||
+			(GetFloats(object, "uvScale", record.UVscale, 2) == false) ||
+			(GetFloats(object, "matrix", matrix, 16) == false))
+		{
+			return(false);
+		}
+
+		glm::mat4 model;
+		if (JsonReader::FindMember(object, "matrix") != NULL)
+		{
+			for (int i = 0; i < 16; i++)
+			{
+				model[i / 4][i % 4] = matrix[i];
+			}
+		}
+		else
+		{
+			model = glm::translate(glm::vec3(position[0], position[1], position[2])) *
+				glm::rotate(glm::radians(rotation[0]), glm::vec3(1.0f, 0.0f, 0.0f)) *
+				glm::rotate(glm::radians(rotation[1]), glm::vec3(0.0f, 1.0f, 0.0f)) *
+				glm::rotate(glm::radians(rotation[2]), glm::vec3(0.0f, 0.0f, 1.0f)) *
+				glm::scale(glm::vec3(scale[0], scale[1], scale[2]));
+		}
+		glm::mat3 normalMatrix = glm::mat3(glm::transpose(glm::inverse(model)));
+		for (int i = 0; i < 16; i++)
+		{
+			record.model[i] = model[i / 4][i % 4];
+		}
+		for (int i = 0; i < 9; i++)
+		{
+			record.normalMatrix[i] = normalMatrix[i / 3][i % 3];
+		}
+		for (int axis = 0; axis < 3; axis++)
+		{
+			record.position[axis] = model[3][axis];
+		}
+
+		std::string shape = JsonReader::GetString(object, "shape", "box");
+		record.shape = SceneFile::SHAPE_COUNT;
+		for (unsigned int i = 0; i < SceneFile::SHAPE_COUNT; i++)
+		{
+			if (shape == SHAPE_NAMES[i])
+			{
+				record.shape = i;
+			}
+		}
+		if (record.shape == SceneFile::SHAPE_COUNT)
+		{
+			std::cout << "ERROR::SCENE_FILE::Unknown shape " << shape << std::endl;
+			return(false);
+		}
+
+		// references are by tag in the layout and by index in the
+		// cooked file
+		std::string texture = JsonReader::GetString(object, "texture", "");
+		std::string mesh = JsonReader::GetString(object, "mesh", "");
+		std::string material = JsonReader::GetString(object, "material", "");
+		record.texture = texture.empty() ? -1 : FindTag(textureTags, texture);
+		record.mesh = mesh.empty() ? -1 : FindTag(meshTags, mesh);
+		record.material = material.empty() ? -1 : FindTag(materialTags, material);
+		if (((texture.empty() == false) && (record.texture < 0)) ||
+			((mesh.empty() == false) && (record.mesh < 0)) ||
+			((material.empty() == false) && (record.material < 0)))
+		{
+			std::cout << "ERROR::SCENE_FILE::Unknown texture, mesh or material tag in an object"
+				<< std::endl;
+			return(false);
+		}
+		return(true);
+	}
+}
+
+/***********************************************************
+ *  SceneFile()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+SceneFile::SceneFile()
+{
+	memset(&m_header, 0, sizeof(m_header));
+	m_pTextures = NULL;
+	m_pMeshes = NULL;
+	m_pMaterials = NULL;
+	m_pObjects = NULL;
+	m_pStrings = NULL;
+}
+
+/***********************************************************
+ *  Open()
+ *
+ *  This method is used for mapping a cooked scene file.
+ *  Every reference and string offset is checked once here,
+ *  so the records can be used without checks afterwards.
+ ***********************************************************/
+bool SceneFile::Open(const char* filePath)
+{
+	Close();
+	if (m_file.Open(filePath) == false)
+	{
+		return(false);
+	}
+
+	FILE_HEADER header;
+	if (m_file.GetSize() < sizeof(header))
+	{
+		Close();
+		return(false);
+	}
+	memcpy(&header, m_file.GetData(), sizeof(header));
+	unsigned long long textureBytes = (unsigned long long)header.textureCount * sizeof(ASSET_RECORD);
+	unsigned long long meshBytes = (unsigned long long)header.meshCount * sizeof(ASSET_RECORD);
+	unsigned long long materialBytes = (unsigned long long)header.materialCount * sizeof(MATERIAL_RECORD);
+	unsigned long long objectBytes = (unsigned long long)header.objectCount * sizeof(OBJECT_RECORD);
+	if ((header.magic != SCENE_FILE_MAGIC) ||
+		(header.version != SCENE_FILE_VERSION) ||
+		(header.stringBytes == 0) ||
+		(m_file.GetSize() != sizeof(header) + textureBytes + meshBytes + materialBytes +
+			objectBytes + header.stringBytes))
+	{
+		std::cout << "ERROR::SCENE_FILE::" << filePath << " is not a cooked scene of this version"
+			<< std::endl;
+		Close();
+		return(false);
+	}
+
+	const unsigned char* data = m_file.GetData() + sizeof(header);
+	const ASSET_RECORD* pTextures = (const ASSET_RECORD*)data;
+	const ASSET_RECORD* pMeshes = (const ASSET_RECORD*)(data + textureBytes);
+	const MATERIAL_RECORD* pMaterials = (const MATERIAL_RECORD*)(data + textureBytes + meshBytes);
+	const OBJECT_RECORD* pObjects = (const OBJECT_RECORD*)(data + textureBytes + meshBytes + materialBytes);
+	const char* pStrings = (const char*)(data + textureBytes + meshBytes + materialBytes + objectBytes);
+
+	// every string offset has a terminating zero after it as long
+	// as the table ends in one
+	bool bValid = (pStrings[header.stringBytes - 1] == '\0');
+	for (unsigned int i = 0; (i < header.textureCount) && (bValid == true); i++)
+	{
+		bValid = (pTextures[i].tagOffset < header.stringBytes) &&
+			(pTextures[i].pathOffset < header.stringBytes);
+	}
+	for (unsigned int i = 0; (i < header.meshCount) && (bValid == true); i++)
+	{
+		bValid = (pMeshes[i].tagOffset < header.stringBytes) &&
+			(pMeshes[i].pathOffset < header.stringBytes);
+	}
+	for (unsigned int i = 0; (i < header.materialCount) && (bValid == true); i++)
+	{
+		bValid = (pMaterials[i].tagOffset < header.stringBytes);
+	}
+	for (unsigned int i = 0; (i < header.objectCount) && (bValid == true); i++)
+	{
+		const OBJECT_RECORD& object = pObjects[i];
+		bValid = (object.shape < SHAPE_COUNT) &&
+			(object.mesh >= -1) && (object.mesh < (int)header.meshCount) &&
+			(object.texture >= -1) && (object.texture < (int)header.textureCount) &&
+			(object.material >= -1) && (object.material < (int)header.materialCount);
+	}
+	if (bValid == false)
+	{
+		std::cout << "ERROR::SCENE_FILE::" << filePath << " has references out of range" << std::endl;
+		Close();
+		return(false);
+	}
+
+	m_header = header;
+	m_pTextures = pTextures;
+	m_pMeshes = pMeshes;
+	m_pMaterials = pMaterials;
+	m_pObjects = pObjects;
+	m_pStrings = pStrings;
+	return(true);
+}
+
+/***********************************************************
+ *  Close()
+ *
+ *  This method is used for releasing the mapped file.
+ ***********************************************************/
+void SceneFile::Close()
+{
+	m_file.Close();
+	memset(&m_header, 0, sizeof(m_header));
+	m_pTextures = NULL;
+	m_pMeshes = NULL;
+	m_pMaterials = NULL;
+	m_pObjects = NULL;
+	m_pStrings = NULL;
+}
+
+/***********************************************************
+ *  GetHeader()
+ *
+ *  This method is used for getting the record counts of the
+ *  mapped file, which are all zero when none is open.
+ ***********************************************************/
+const SceneFile::FILE_HEADER& SceneFile::GetHeader() const
+{
+	return(m_header);
+}
+
+/***********************************************************
+ *  GetTextures()
+ *
+ *  This method is used for getting the texture records.
+ ***********************************************************/
+const SceneFile::ASSET_RECORD* SceneFile::GetTextures() const
+{
+	return(m_pTextures);
+}
+
+/***********************************************************
+ *  GetMeshes()
+ *
+ *  This method is used for getting the model file records.
+ ***********************************************************/
+const SceneFile::ASSET_RECORD* SceneFile::GetMeshes() const
+{
+	return(m_pMeshes);
+}
+
+/***********************************************************
+ *  GetMaterials()
+ *
+ *  This method is used for getting the material records.
+ ***********************************************************/
+const SceneFile::MATERIAL_RECORD* SceneFile::GetMaterials() const
+{
+	return(m_pMaterials);
+}
+
+/***********************************************************
+ *  GetObjects()
+ *
+ *  This method is used for getting the object records.
+ ***********************************************************/
+const SceneFile::OBJECT_RECORD* SceneFile::GetObjects() const
+{
+	return(m_pObjects);
+}
+
+/***********************************************************
+ *  GetString()
+ *
+ *  This method is used for getting a string of the string
+ *  table by its offset, or an empty string when the offset
+ *  is out of range.
+ ***********************************************************/
+const char* SceneFile::GetString(unsigned int offset) const
+{
+	if ((m_pStrings == NULL) || (offset >= m_header.stringBytes))
+	{
+		return("");
+	}
+	return(m_pStrings + offset);
+}
+
+/***********************************************************
+ *  Cook()
+ *
+ *  This method is used for converting a JSON scene layout
+ *  into a cooked file.
+ ***********************************************************/
+bool SceneFile::Cook(const char* jsonPath, const char* scenePath)
+{
+	SCENE_LAYOUT layout;
+	if (ReadLayout(jsonPath, layout) == false)
+	{
+		return(false);
+	}
+	if (Write(scenePath, layout) == false)
+	{
+		return(false);
+	}
+
+	std::cout << "INFO: Cooked " << scenePath << " with " << layout.objects.size() << " objects, "
+		<< layout.materials.size() << " materials, " << layout.textureTags.size() << " textures and "
+		<< layout.meshTags.size() << " model files" << std::endl;
+	return(true);
+}
+
+/***********************************************************
+ *  CookIfChanged()
+ *
+ *  This method is used for cooking a JSON scene layout when
+ *  the cooked file is missing or older than the layout, so
+ *  an edited layout is used without cooking it by hand.
+ *  Returns true when the cooked file is up to date.
+ ***********************************************************/
+bool SceneFile::CookIfChanged(const char* jsonPath, const char* scenePath)
+{
+	long long layoutTime = GetModifiedTime(jsonPath);
+	if (layoutTime < 0)
+	{
+		return(false);
+	}
+	if (GetModifiedTime(scenePath) >= layoutTime)
+	{
+		return(true);
+	}
+	std::cout << "INFO: Cooking " << scenePath << " from " << jsonPath << std::endl;
+	return(Cook(jsonPath, scenePath));
+}
+
+/***********************************************************
+ *  GetLayoutPath()
+ *
+ *  This method is used for getting the path of the JSON
+ *  layout a cooked file is cooked from, which sits beside
+ *  it with ".json" in place of ".scene".  Returns an empty
+ *  string for a file without the ".scene" extension.
+ ***********************************************************/
+std::string SceneFile::GetLayoutPath(const std::string& scenePath)
+{
+	size_t extensionLength = strlen(SCENE_EXTENSION);
+	if ((scenePath.size() <= extensionLength) ||
+		(scenePath.compare(scenePath.size() - extensionLength, extensionLength, SCENE_EXTENSION) != 0))
+	{
+		return(std::string());
+	}
+	return(scenePath.substr(0, scenePath.size() - extensionLength) + LAYOUT_EXTENSION);
+}
+
+/***********************************************************
+ *  ReadLayout()
+ *
+ *  This method is used for reading a JSON scene layout.
+ *  The layout has the lists "textures" and "meshes" of tags
+ *  and paths, "materials" with their lighting values, and
+ *  "objects" that name their shape and refer to the other
+ *  lists by tag.  Members that are not used, such as the
+ *  names of the objects, are skipped.
+ ***********************************************************/
+bool SceneFile::ReadLayout(const char* jsonPath, SCENE_LAYOUT& layout)
+{
+	MappedFile jsonFile;
+	JSON_VALUE document;
+	if ((jsonFile.Open(jsonPath) == false) ||
+		(JsonReader::Parse((const char*)jsonFile.GetData(), jsonFile.GetSize(), document) == false) ||
+		(document.type != JSON_VALUE::JSON_OBJECT))
+	{
+		std::cout << "ERROR::SCENE_FILE::Could not read the scene layout " << jsonPath << std::endl;
+		return(false);
+	}
+
+	if ((ReadAssets(document, "textures", layout.textureTags, layout.texturePaths) == false) ||
+		(ReadAssets(document, "meshes", layout.meshTags, layout.meshPaths) == false))
+	{
+		return(false);
+	}
+
+	const JSON_VALUE* pMaterials = JsonReader::FindMember(document, "materials");
+	for (size_t i = 0; (pMaterials != NULL) && (i < pMaterials->items.size()); i++)
+	{
+		const JSON_VALUE& material = pMaterials->items[i];
+		MATERIAL_RECORD record;
+		memset(&record, 0, sizeof(record));
+		std::string tag = JsonReader::GetString(material, "tag", "");
+		record.ambientStrength = (float)JsonReader::GetNumber(material, "ambientStrength", 0.0);
+		record.shininess = (float)JsonReader::GetNumber(material, "shininess", 1.0);
+		if ((tag.empty() == true) ||
+			(GetFloats(material, "ambientColor", record.ambientColor, 3) == false) ||
+			(GetFloats(material, "diffuseColor", record.diffuseColor, 3) == false) ||
+			(GetFloats(material, "specularColor", record.specularColor, 3) == false))
+		{
+			std::cout << "ERROR::SCENE_FILE::Material " << i << " is not valid" << std::endl;
+			return(false);
+		}
+		layout.materials.push_back(record);
+		layout.materialTags.push_back(tag);
+	}
+
+	const JSON_VALUE* pObjects = JsonReader::FindMember(document, "objects");
+	if (pObjects != NULL)
+	{
+		layout.objects.resize(pObjects->items.size());
+		for (size_t i = 0; i < layout.objects.size(); i++)
+		{
+			if (CookObject(pObjects->items[i], layout.textureTags, layout.meshTags,
+				layout.materialTags, layout.objects[i]) == false)
+			{
+				std::cout << "ERROR::SCENE_FILE::Object " << i << " is not valid" << std::endl;
+				return(false);
+			}
+		}
+	}
+	return(true);
+}
+
+/***********************************************************
+ *  Write()
+ *
+ *  This method is used for writing a scene layout as a
+ *  cooked file.  The string table is built here, so the
+ *  tag offsets of the layout's materials are not used.
+ ***********************************************************/
+bool SceneFile::Write(const char* scenePath, const SCENE_LAYOUT& layout)
+{
+	STRING_TABLE strings;
+	std::vector<ASSET_RECORD> textures;
+	std::vector<ASSET_RECORD> meshes;
+	WriteAssets(layout.textureTags, layout.texturePaths, strings, textures);
+	WriteAssets(layout.meshTags, layout.meshPaths, strings, meshes);
+
+	std::vector<MATERIAL_RECORD> materials = layout.materials;
+	for (size_t i = 0; i < materials.size(); i++)
+	{
+		materials[i].tagOffset = strings.Add(layout.materialTags[i]);
+	}
+	const std::vector<OBJECT_RECORD>& objects = layout.objects;
+
+	// keep the arrays that follow the strings four byte aligned
+	while (strings.bytes.size() % 4 != 0)
+	{
+		strings.bytes.push_back('\0');
+	}
+
+	FILE_HEADER header;
+	header.magic = SCENE_FILE_MAGIC;
+	header.version = SCENE_FILE_VERSION;
+	header.textureCount = (unsigned int)textures.size();
+	header.meshCount = (unsigned int)meshes.size();
+	header.materialCount = (unsigned int)materials.size();
+	header.objectCount = (unsigned int)objects.size();
+	header.stringBytes = (unsigned int)strings.bytes.size();
+	header.reserved = 0;
+
+	std::ofstream file(scenePath, std::ios::binary | std::ios::trunc);
+	if (!file.is_open())
+	{
+		std::cout << "ERROR::SCENE_FILE::Could not write " << scenePath << std::endl;
+		return(false);
+	}
+	file.write((const char*)&header, sizeof(header));
+	if (textures.empty() == false)
+	{
+		file.write((const char*)&textures[0], textures.size() * sizeof(ASSET_RECORD));
+	}
+	if (meshes.empty() == false)
+	{
+		file.write((const char*)&meshes[0], meshes.size() * sizeof(ASSET_RECORD));
+	}
+	if (materials.empty() == false)
+	{
+		file.write((const char*)&materials[0], materials.size() * sizeof(MATERIAL_RECORD));
+	}
+	if (objects.empty() == false)
+	{
+		file.write((const char*)&objects[0], objects.size() * sizeof(OBJECT_RECORD));
+	}
+	file.write(&strings.bytes[0], strings.bytes.size());
+	if (!file)
+	{
+		file.close();
+		std::remove(scenePath);
+		std::cout << "ERROR::SCENE_FILE::Could not write " << scenePath << std::endl;
+		return(false);
+	}
+	return(true);
+}
@@ -0,0 +1,154 @@
+///////////////////////////////////////////////////////////////////////////////
+// scenefile.h
+// ============
+// read the cooked binary scene files that hold the textures, model files,
+// materials and objects of a scene, and cook them from JSON layouts
+//
+//  Created for CS-330-Computational Graphics and Visualization
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "MappedFile.h"
+
+#include <string>
+#include <vector>
+
+/***********************************************************
+ *  SceneFile
+ *
+ *  This class contains the code for the cooked scene files.
+ *  A cooked file is a header followed by flat arrays of
+ *  fixed size records, one after another:
+ *
+ *    textures    tag and path of each texture image
+ *    meshes      tag and path of each model file
+ *    materials   lighting values of each material
+ *    objects     transform, shape and references of each
+ *                object drawn in the scene
+ *    strings     the tags and paths, each ending in a zero
+ *
+ *  Records refer to each other by their index in an array,
+ *  and to strings by their offset in the string table, so
+ *  the arrays are used straight from the mapped file.  The
+ *  scene is authored as JSON and turned into a cooked file
+ *  by Cook().
+ ***********************************************************/
+class SceneFile
+{
+public:
+	// basic shapes an object can be drawn with, in the same order
+	// as the meshes of the scene manager
+	enum SHAPE
+	{
+		SHAPE_PLANE = 0,
+		SHAPE_BOX,
+		SHAPE_CYLINDER,
+		SHAPE_CONE,
+		SHAPE_SPHERE,
+		SHAPE_HALF_SPHERE,
+		SHAPE_TORUS,
+		SHAPE_HALF_TORUS,
+		SHAPE_COUNT
+	};
+
+	// start of a cooked file
+	struct FILE_HEADER
+	{
+		unsigned int magic;
+		unsigned int version;
+		unsigned int textureCount;
+		unsigned int meshCount;
+		unsigned int materialCount;
+		unsigned int objectCount;
+		unsigned int stringBytes;
+		unsigned int reserved;
+	};
+
+	// a texture image or model file, and the tag it is found by
+	struct ASSET_RECORD
+	{
+		unsigned int tagOffset;
+		unsigned int pathOffset;
+	};
+
+	// the lighting values of a material
+	struct MATERIAL_RECORD
+	{
+		unsigned int tagOffset;
+		float ambientStrength;
+		float ambientColor[3];
+		float diffuseColor[3];
+		float specularColor[3];
+		float shininess;
+	};
+
+	// an object drawn in the scene.  the matrices are column
+	// major, and the references are -1 when they are not used
+	struct OBJECT_RECORD
+	{
+		float model[16];
+		float normalMatrix[9];
+		float position[3];
+		float color[4];
+		float UVscale[2];
+		unsigned int shape;
+		// model file fitted into the space of the shape
+		int mesh;
+		// texture drawn instead of the color
+		int texture;
+		int material;
+	};
+
+	// a scene layout read from JSON, with the references of the
+	// objects already turned into indices
+	struct SCENE_LAYOUT
+	{
+		std::vector<std::string> textureTags;
+		std::vector<std::string> texturePaths;
+		std::vector<std::string> meshTags;
+		std::vector<std::string> meshPaths;
+		std::vector<std::string> materialTags;
+		std::vector<MATERIAL_RECORD> materials;
+		std::vector<OBJECT_RECORD> objects;
+	};
+
+	// constructor
+	SceneFile();
+
+	// map a cooked file and check that all of its arrays and
+	// references are in range
+	bool Open(const char* filePath);
+	// release the mapped file
+	void Close();
+
+	// the arrays of the mapped file
+	const FILE_HEADER& GetHeader() const;
+	const ASSET_RECORD* GetTextures() const;
+	const ASSET_RECORD* GetMeshes() const;
+	const MATERIAL_RECORD* GetMaterials() const;
+	const OBJECT_RECORD* GetObjects() const;
+	// a string from the string table
+	const char* GetString(unsigned int offset) const;
+
+	// convert a JSON scene layout into a cooked file
+	static bool Cook(const char* jsonPath, const char* scenePath);
+	// cook a JSON scene layout when it is newer than the cooked
+	// file, or the cooked file is missing
+	static bool CookIfChanged(const char* jsonPath, const char* scenePath);
+	// get the path of the JSON layout beside a cooked file
+	static std::string GetLayoutPath(const std::string& scenePath);
+	// read a JSON scene layout
+	static bool ReadLayout(const char* jsonPath, SCENE_LAYOUT& layout);
+	// write a scene layout as a cooked file
+	static bool Write(const char* scenePath, const SCENE_LAYOUT& layout);
+
+private:
+	MappedFile m_file;
+	FILE_HEADER m_header;
+	const ASSET_RECORD* m_pTextures;
+	const ASSET_RECORD* m_pMeshes;
+	const MATERIAL_RECORD* m_pMaterials;
+	const OBJECT_RECORD* m_pObjects;
+	const char* m_pStrings;
+};
@@ -16,6 +16,17 @@
 
 #include <glm/gtx/transform.hpp>
 
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <future>
+#include <random>
+#include <set>
+
+// GLFW library
+#include "GLFW/glfw3.h"
+
 // declaration of global variables and defines
 namespace
 {
@@ -24,6 +35,245 @@ namespace
 	const char* g_TextureValueName = "objectTexture";
 	const char* g_UseTextureName = "bUseTexture";
 	const char* g_UseLightingName = "bUseLighting";
+	const char* g_NormalMatrixName = "normalMatrix";
+	const char* g_ViewName = "view";
+	const char* g_ProjectionName = "projection";
+	const char* g_ViewPositionName = "viewPosition";
+	const char* g_MaterialIndexName = "materialIndex";
+
+	// GLSL source for the specialized scene shader variants
+	const char* g_VariantVertexShaderPath = "Source/shaders/sceneVertex.glsl";
+	const char* g_VariantFragmentShaderPath = "Source/shaders/sceneFragment.glsl";
+	// GLSL source for the deferred lighting compute shader
+	const char* g_DeferredLightingShaderPath = "Source/shaders/deferredLighting.glsl";
+	// directory the linked shader variants are stored in
+	const char* g_ShaderCacheDirectory = "shadercache";
+	// cooked file the baked light probes are stored in
+	const char* g_BakedLightingPath = "scenelighting.bake";
+	// GLSL source for the impostor quads
+	const char* g_ImpostorVertexShaderPath = "Source/shaders/impostorVertex.glsl";
+	const char* g_ImpostorFragmentShaderPath = "Source/shaders/impostorFragment.glsl";
+	// cooked file the baked impostor atlas is stored in
+	const char* g_BakedImpostorsPath = "sceneimpostors.bake";
+	// size of the squares on the floor that static objects are
+	// grouped by for impostors.  objects larger than a square
+	// stay as they are, and a group needs at least two objects
+	const float g_ImpostorGroupSize = 8.0f;
+	const int g_ImpostorMinObjects = 2;
+	// directory the converted model files are stored in
+	const char* g_MeshCacheDirectory = "meshcache";
+	// largest error of an imported mesh detail level, in pixels
+	const float g_MaxLODPixelError = 1.0f;
+	// cooked scene file loaded instead of the built in scene,
+	// cooked from the JSON layout beside it when that is newer
+	const char* g_SceneFilePath = "Source/scenes/desk.scene";
+	// most bytes of textures and meshes of streamed cells handed
+	// to OpenGL in one frame
+	const long long g_StreamUploadBudget = 4 * 1024 * 1024;
+	// share of a new camera velocity measurement mixed into the
+	// smoothed velocity the streaming looks ahead with
+	const float g_StreamVelocitySmoothing = 0.25f;
+
+	/***********************************************************
+	 *  GetShapeBounds()
+	 *
+	 *  This function is used to get the object space bounds of
+	 *  a basic shape mesh.
+	 ***********************************************************/
+	void GetShapeBounds(SceneManager::MESH_TYPE mesh, glm::vec3& boundsMin, glm::vec3& boundsMax)
+	{
+		switch (mesh)
+		{
+		case SceneManager::MESH_PLANE:
+			boundsMin = glm::vec3(-1.0f, 0.0f, -1.0f);
+			boundsMax = glm::vec3(1.0f, 0.0f, 1.0f);
+			break;
+		case SceneManager::MESH_CYLINDER:
+		case SceneManager::MESH_CONE:
+		case SceneManager::MESH_HALF_SPHERE:
+			boundsMin = glm::vec3(-1.0f, 0.0f, -1.0f);
+			boundsMax = glm::vec3(1.0f, 1.0f, 1.0f);
+			break;
+		case SceneManager::MESH_SPHERE:
+			boundsMin = glm::vec3(-1.0f);
+			boundsMax = glm::vec3(1.0f);
+			break;
+		case SceneManager::MESH_TORUS:
+			boundsMin = glm::vec3(-1.2f, -1.2f, -0.2f);
+			boundsMax = glm::vec3(1.2f, 1.2f, 0.2f);
+			break;
+		case SceneManager::MESH_HALF_TORUS:
+			boundsMin = glm::vec3(-1.2f, 0.0f, -0.2f);
+			boundsMax = glm::vec3(1.2f, 1.2f, 0.2f);
+			break;
+		case SceneManager::MESH_BOX:
+		default:
+			boundsMin = glm::vec3(-0.5f);
+			boundsMax = glm::vec3(0.5f);
+			break;
+		}
+	}
+
+	/***********************************************************
+	 *  GetMeshFitTransform()
+	 *
+	 *  This function is used to get the transform that scales
+	 *  an imported mesh evenly to fit into the space the basic
+	 *  shape would take up, standing on its bottom.
+	 ***********************************************************/
+	glm::mat4 GetMeshFitTransform(SceneManager::MESH_TYPE mesh, const MeshImporter::GPU_MESH& importedMesh)
+	{
+		glm::vec3 shapeMin;
+		glm::vec3 shapeMax;
+		GetShapeBounds(mesh, shapeMin, shapeMax);
+		glm::vec3 shapeExtent = shapeMax - shapeMin;
+		glm::vec3 meshExtent = importedMesh.boundsMax - importedMesh.boundsMin;
+
+		// flat shapes such as the plane only limit the other sides
+		float scale = 0.0f;
+		for (int axis = 0; axis < 3; axis++)
+		{
+			if ((shapeExtent[axis] > 0.0f) && (meshExtent[axis] > 0.0f))
+			{
+				float axisScale = shapeExtent[axis] / meshExtent[axis];
+				scale = (scale == 0.0f) ? axisScale : std::min(scale, axisScale);
+			}
+		}
+		if (scale == 0.0f)
+		{
+			scale = 1.0f;
+		}
+
+		glm::vec3 shapeCenter = (shapeMin + shapeMax) * 0.5f;
+		glm::vec3 meshCenter = (importedMesh.boundsMin + importedMesh.boundsMax) * 0.5f;
+		glm::vec3 offset(
+			shapeCenter.x - meshCenter.x * scale,
+			shapeMin.y - importedMesh.boundsMin.y * scale,
+			shapeCenter.z - meshCenter.z * scale);
+		return(glm::translate(offset) * glm::scale(glm::vec3(scale)));
+	}
+
+	/***********************************************************
+	 *  IsBoxInFrustum()
+	 *
+	 *  This function is used to check whether any part of a
+	 *  world space box may be inside the view of a combined
+	 *  view and projection matrix.  The frustum planes are the
+	 *  sums and differences of the matrix rows, and the box is
+	 *  outside when its corner furthest along the inside of
+	 *  any plane is still behind it.
+	 ***********************************************************/
+	bool IsBoxInFrustum(const glm::mat4& viewProjection, const glm::vec3& boundsMin, const glm::vec3& boundsMax)
+	{
+		glm::vec4 rowW(viewProjection[0][3], viewProjection[1][3], viewProjection[2][3], viewProjection[3][3]);
+		for (int plane = 0; plane < 6; plane++)
+		{
+			int axis = plane / 2;
+			glm::vec4 row(viewProjection[0][axis], viewProjection[1][axis],
+				viewProjection[2][axis], viewProjection[3][axis]);
+			glm::vec4 equation = (plane % 2 == 0) ? rowW + row : rowW - row;
+
+			glm::vec3 corner(
+				(equation.x >= 0.0f) ? boundsMax.x : boundsMin.x,
+				(equation.y >= 0.0f) ? boundsMax.y : boundsMin.y,
+				(equation.z >= 0.0f) ? boundsMax.z : boundsMin.z);
+			if (glm::dot(glm::vec3(equation), corner) + equation.w < 0.0f)
+			{
+				return(false);
+			}
+		}
+		return(true);
+	}
+
+	/***********************************************************
+	 *  GetBasicShapeVertices()
+	 *
+	 *  This function is used to get the vertices and triangles
+	 *  of the box and plane meshes, which are drawn by the
+	 *  shape meshes class, for work on the CPU.  Each face of
+	 *  the box has its own corners, so it keeps a flat normal,
+	 *  and the texture covers each face once.
+	 ***********************************************************/
+	void GetBasicShapeVertices(
+		SceneManager::MESH_TYPE mesh,
+		std::vector<MeshImporter::MESH_VERTEX>& vertices,
+		std::vector<unsigned int>& indices)
+	{
+		vertices.clear();
+		indices.clear();
+		const glm::vec2 cornerUVs[4] = {
+			glm::vec2(0.0f, 0.0f), glm::vec2(1.0f, 0.0f),
+			glm::vec2(1.0f, 1.0f), glm::vec2(0.0f, 1.0f) };
+		if (mesh == SceneManager::MESH_PLANE)
+		{
+			const glm::vec3 planeCorners[4] = {
+				glm::vec3(-1.0f, 0.0f, 1.0f), glm::vec3(1.0f, 0.0f, 1.0f),
+				glm::vec3(1.0f, 0.0f, -1.0f), glm::vec3(-1.0f, 0.0f, -1.0f) };
+			for (int corner = 0; corner < 4; corner++)
+			{
+				MeshImporter::MESH_VERTEX vertex;
+				vertex.position = planeCorners[corner];
+				vertex.normal = glm::vec3(0.0f, 1.0f, 0.0f);
+				vertex.textureCoordinate = cornerUVs[corner];
+				vertices.push_back(vertex);
+			}
+			const unsigned int planeIndices[] = { 0, 1, 2, 0, 2, 3 };
+			indices.assign(planeIndices, planeIndices + 6);
+			return;
+		}
+
+		// each face of the box, as its normal and the directions its
+		// texture coordinates run along
+		const glm::vec3 faceAxes[6][3] = {
+			{ glm::vec3(0.0f, 0.0f, 1.0f), glm::vec3(1.0f, 0.0f, 0.0f), glm::vec3(0.0f, 1.0f, 0.0f) },
+			{ glm::vec3(0.0f, 0.0f, -1.0f), glm::vec3(-1.0f, 0.0f, 0.0f), glm::vec3(0.0f, 1.0f, 0.0f) },
+			{ glm::vec3(1.0f, 0.0f, 0.0f), glm::vec3(0.0f, 0.0f, -1.0f), glm::vec3(0.0f, 1.0f, 0.0f) },
+			{ glm::vec3(-1.0f, 0.0f, 0.0f), glm::vec3(0.0f, 0.0f, 1.0f), glm::vec3(0.0f, 1.0f, 0.0f) },
+			{ glm::vec3(0.0f, 1.0f, 0.0f), glm::vec3(1.0f, 0.0f, 0.0f), glm::vec3(0.0f, 0.0f, -1.0f) },
+			{ glm::vec3(0.0f, -1.0f, 0.0f), glm::vec3(1.0f, 0.0f, 0.0f), glm::vec3(0.0f, 0.0f, 1.0f) } };
+		for (int face = 0; face < 6; face++)
+		{
+			unsigned int first = (unsigned int)vertices.size();
+			for (int corner = 0; corner < 4; corner++)
+			{
+				MeshImporter::MESH_VERTEX vertex;
+				vertex.position = (faceAxes[face][0] +
+					faceAxes[face][1] * (cornerUVs[corner].x * 2.0f - 1.0f) +
+					faceAxes[face][2] * (cornerUVs[corner].y * 2.0f - 1.0f)) * 0.5f;
+				vertex.normal = faceAxes[face][0];
+				vertex.textureCoordinate = cornerUVs[corner];
+				vertices.push_back(vertex);
+			}
+			const unsigned int faceIndices[] = { 0, 1, 2, 0, 2, 3 };
+			for (int i = 0; i < 6; i++)
+			{
+				indices.push_back(first + faceIndices[i]);
+			}
+		}
+	}
+
+	/***********************************************************
+	 *  GetSceneFileMaterial()
+	 *
+	 *  This function is used to convert a material record of a
+	 *  cooked scene file into an object material.
+	 ***********************************************************/
+	SceneManager::OBJECT_MATERIAL GetSceneFileMaterial(
+		const SceneFile& sceneFile,
+		const SceneFile::MATERIAL_RECORD& record)
+	{
+		SceneManager::OBJECT_MATERIAL material;
+		material.ambientStrength = record.ambientStrength;
+		material.ambientColor = glm::vec3(record.ambientColor[0],
+			record.ambientColor[1], record.ambientColor[2]);
+		material.diffuseColor = glm::vec3(record.diffuseColor[0],
+			record.diffuseColor[1], record.diffuseColor[2]);
+		material.specularColor = glm::vec3(record.specularColor[0],
+			record.specularColor[1], record.specularColor[2]);
+		material.shininess = record.shininess;
+		material.tag = sceneFile.GetString(record.tagOffset);
+		return(material);
+	}
 }
 
 /***********************************************************
@@ -36,14 +286,104 @@ SceneManager::SceneManager(ShaderManager* pShaderManager)
 	m_pShaderManager = pShaderManager;
 	// create the shape meshes object
 	m_basicMeshes = new ShapeMeshes();
+	// create the round shapes that are built at compile time
+	m_pPrimitiveMeshes = new PrimitiveMeshes();
 
 	// initialize the texture collection
 	for (int i = 0; i < 16; i++)
 	{
 		m_textureIDs[i].tag = "/0";
 		m_textureIDs[i].ID = -1;
+		m_textureIDs[i].bTransparent = false;
+		m_textureIDs[i].averageColor = glm::vec3(1.0f);
 	}
 	m_loadedTextures = 0;
+	m_bSceneChanged = true;
+
+	// create the mesh importer for loading model files
+	m_pMeshImporter = new MeshImporter();
+
+	// initialize the properties for the first scene object
+	m_pendingObject.mesh = MESH_BOX;
+	m_pendingObject.importedMesh = -1;
+	m_pendingObject.model = glm::mat4(1.0f);
+	m_pendingObject.normalMatrix = glm::mat3(1.0f);
+	m_pendingObject.position = glm::vec3(0.0f);
+	m_pendingObject.bUseTexture = false;
+	m_pendingObject.textureSlot = -1;
+	m_pendingObject.color = glm::vec4(1.0f);
+	m_pendingObject.UVscale = glm::vec2(1.0f, 1.0f);
+	m_pendingObject.materialIndex = -1;
+	m_pendingObject.bTransparent = false;
+	m_pendingObject.variantKey = 0;
+	m_pendingObject.streamCell = -1;
+	m_pendingObject.impostorGroup = -1;
+
+	m_ambientLightColor = glm::vec3(0.0f);
+	m_ambientLightIntensity = 0.0f;
+	m_bUseLighting = false;
+
+	m_viewMatrix = glm::mat4(1.0f);
+	m_projectionMatrix = glm::mat4(1.0f);
+	m_viewPosition = glm::vec3(0.0f);
+	m_viewportHeight = 0;
+	m_bQuadView = false;
+	m_bDrawingQuadViews = false;
+	m_bSeparateQuadViews = false;
+
+	// create the shader variant cache
+	m_pShaderVariants = new ShaderVariantCache(pShaderManager);
+	m_bUseShaderVariants = false;
+
+	// create the light cluster grid
+	m_pClusteredLighting = new ClusteredLighting();
+	m_bUseClusteredLighting = false;
+
+	// create the deferred renderer, used only when requested
+	m_pDeferredRenderer = new DeferredRenderer();
+	m_bUseDeferredShading = false;
+
+	// create the light baker, used when baked lighting is available
+	m_pLightBaker = new LightBaker();
+	m_bUseBakedLighting = false;
+	m_bBakeLighting = false;
+
+	// create the impostor atlas, used when impostors are available
+	m_pImpostors = new ImpostorAtlas();
+	m_bUseImpostors = false;
+	m_bBakeImpostors = false;
+
+	// create the picker, which is given the objects when a ray is
+	// first cast
+	m_pScenePicker = new ScenePicker();
+	m_bPickerChanged = true;
+
+	// create the software rasterizer, used only when requested
+	m_pSoftwareRasterizer = new SoftwareRasterizer();
+	m_bUseSoftwareRasterizer = false;
+	for (int i = 0; i < 16; i++)
+	{
+		m_softwareTextures[i] = -1;
+	}
+
+	// create the draw recorder, used only when requested
+	m_pDrawRecorder = new DrawRecorder();
+	m_bUseRecordedDraws = false;
+	for (int i = 0; i < MESH_IMPORTED; i++)
+	{
+		m_recordedMeshes[i] = -1;
+	}
+
+	m_sceneFilePath = g_SceneFilePath;
+
+	// create the watcher for the files the scene is loaded from
+	m_pAssetWatcher = new AssetWatcher();
+
+	// create the streamer, used when a cell index is set
+	m_pSceneStreamer = new SceneStreamer();
+	m_streamViewPosition = glm::vec3(0.0f);
+	m_streamTime = 0.0;
+	m_streamVelocity = glm::vec3(0.0f);
 }
 
 /***********************************************************
@@ -53,6 +393,26 @@ SceneManager::SceneManager(ShaderManager* pShaderManager)
  ***********************************************************/
 SceneManager::~SceneManager()
 {
+	// stop watching and wait for any files still being read
+	if (NULL != m_pAssetWatcher)
+	{
+		delete m_pAssetWatcher;
+		m_pAssetWatcher = NULL;
+	}
+	m_assetReloads.clear();
+	m_sceneTextureReads.clear();
+	// wait for any cells and model files still being read, which
+	// use the mesh importer
+	m_sceneMeshReads.clear();
+	m_cellLoads.clear();
+	m_textureReads.clear();
+	m_meshReads.clear();
+	if (NULL != m_pSceneStreamer)
+	{
+		delete m_pSceneStreamer;
+		m_pSceneStreamer = NULL;
+	}
+
 	// free the allocated objects
 	m_pShaderManager = NULL;
 	if (NULL != m_basicMeshes)
@@ -60,6 +420,59 @@ SceneManager::~SceneManager()
 		delete m_basicMeshes;
 		m_basicMeshes = NULL;
 	}
+	if (NULL != m_pPrimitiveMeshes)
+	{
+		delete m_pPrimitiveMeshes;
+		m_pPrimitiveMeshes = NULL;
+	}
+	if (NULL != m_pShaderVariants)
+	{
+		delete m_pShaderVariants;
+		m_pShaderVariants = NULL;
+	}
+	if (NULL != m_pClusteredLighting)
+	{
+		delete m_pClusteredLighting;
+		m_pClusteredLighting = NULL;
+	}
+	if (NULL != m_pDeferredRenderer)
+	{
+		delete m_pDeferredRenderer;
+		m_pDeferredRenderer = NULL;
+	}
+	if (NULL != m_pLightBaker)
+	{
+		delete m_pLightBaker;
+		m_pLightBaker = NULL;
+	}
+	if (NULL != m_pImpostors)
+	{
+		delete m_pImpostors;
+		m_pImpostors = NULL;
+	}
+	if (NULL != m_pScenePicker)
+	{
+		delete m_pScenePicker;
+		m_pScenePicker = NULL;
+	}
+	if (NULL != m_pSoftwareRasterizer)
+	{
+		delete m_pSoftwareRasterizer;
+		m_pSoftwareRasterizer = NULL;
+	}
+	if (NULL != m_pDrawRecorder)
+	{
+		delete m_pDrawRecorder;
+		m_pDrawRecorder = NULL;
+	}
+
+	// free the imported meshes
+	DestroyImportedMeshes();
+	if (NULL != m_pMeshImporter)
+	{
+		delete m_pMeshImporter;
+		m_pMeshImporter = NULL;
+	}
 
 	// free the allocated OpenGL textures
 	DestroyGLTextures();
@@ -75,68 +488,193 @@ SceneManager::~SceneManager()
  ***********************************************************/
 bool SceneManager::CreateGLTexture(const char* filename, std::string tag)
 {
-	int width = 0;
-	int height = 0;
-	int colorChannels = 0;
+	if (GetFreeTextureSlot() < 0)
+	{
+		std::cout << "ERROR::NO_FREE_TEXTURE_SLOT: " << filename << std::endl;
+		return false;
+	}
+
+	TEXTURE_IMAGE image;
+	if (DecodeTextureImage(filename, image) == false)
+	{
+		std::cout << "Could not load image:" << filename << std::endl;
+
+		// Error loading the image
+		return false;
+	}
+
+	std::cout << "Successfully loaded image:" << filename << ", width:" << image.width << ", height:" << image.height << ", channels:" << image.colorChannels << std::endl;
+
+	return(AddGLTexture(filename, tag, image));
+}
+
+/***********************************************************
+ *  AddGLTexture()
+ *
+ *  This method is used for creating an OpenGL texture from
+ *  a decoded image and loading it into the next available
+ *  texture slot.
+ ***********************************************************/
+bool SceneManager::AddGLTexture(const char* filename, std::string tag, const TEXTURE_IMAGE& image)
+{
+	int textureSlot = GetFreeTextureSlot();
+	if (textureSlot < 0)
+	{
+		std::cout << "ERROR::NO_FREE_TEXTURE_SLOT: " << filename << std::endl;
+		return false;
+	}
+
 	GLuint textureID = 0;
+	glGenTextures(1, &textureID);
+	if (UploadTextureImage(textureID, image) == false)
+	{
+		glDeleteTextures(1, &textureID);
+		return false;
+	}
+
+	// register the loaded texture and associate it with the special tag string
+	m_textureIDs[textureSlot].ID = textureID;
+	m_textureIDs[textureSlot].tag = tag;
+	m_textureIDs[textureSlot].filename = filename;
+	m_textureIDs[textureSlot].bTransparent = image.bTransparent;
+	m_textureIDs[textureSlot].averageColor = image.averageColor;
+	m_textureIDs[textureSlot].bStreamed = false;
+	m_textureIDs[textureSlot].cellReferences = 0;
+	if (textureSlot == m_loadedTextures)
+	{
+		m_loadedTextures++;
+	}
+
+	return true;
+}
+
+/***********************************************************
+ *  GetFreeTextureSlot()
+ *
+ *  This method is used for getting the slot the next
+ *  texture is loaded into.  The slot of a streamed texture
+ *  that has been freed is reused first, so the slots of the
+ *  other textures do not change.
+ ***********************************************************/
+int SceneManager::GetFreeTextureSlot()
+{
+	int textureSlot = FindTextureSlot("");
+	if ((textureSlot < 0) && (m_loadedTextures < 16))
+	{
+		textureSlot = m_loadedTextures;
+	}
+	return(textureSlot);
+}
+
+/***********************************************************
+ *  DecodeTextureImage()
+ *
+ *  This method is used for reading the pixels of an image
+ *  file, and checking whether any of them need blending and
+ *  what their average color is.  It does not use OpenGL, so
+ *  changed images can be read on a worker thread.
+ ***********************************************************/
+bool SceneManager::DecodeTextureImage(const char* filename, TEXTURE_IMAGE& image)
+{
+	image.width = 0;
+	image.height = 0;
+	image.colorChannels = 0;
+	image.bTransparent = false;
+	image.averageColor = glm::vec3(1.0f);
 
 	// indicate to always flip images vertically when loaded
 	stbi_set_flip_vertically_on_load(true);
 
 	// try to parse the image data from the specified image file
-	unsigned char* image = stbi_load(
+	unsigned char* pixels = stbi_load(
 		filename,
-		&width,
-		&height,
-		&colorChannels,
+		&image.width,
+		&image.height,
+		&image.colorChannels,
 		0);
-
-	// if the image was successfully read from the image file
-	if (image)
+	if (!pixels)
 	{
-		std::cout << "Successfully loaded image:" << filename << ", width:" << width << ", height:" << height << ", channels:" << colorChannels << std::endl;
+		return false;
+	}
 
-		glGenTextures(1, &textureID);
-		glBindTexture(GL_TEXTURE_2D, textureID);
+	int pixelCount = image.width * image.height;
+	image.pixels.assign(pixels, pixels + pixelCount * image.colorChannels);
+	// free the image data from local memory
+	stbi_image_free(pixels);
 
-		// set the texture wrapping parameters
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-		// set texture filtering parameters
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	if ((image.colorChannels != 3) && (image.colorChannels != 4))
+	{
+		std::cout << "Not implemented to handle image with " << image.colorChannels << " channels" << std::endl;
+		return false;
+	}
 
-		// if the loaded image is in RGB format
-		if (colorChannels == 3)
-			glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB8, width, height, 0, GL_RGB, GL_UNSIGNED_BYTE, image);
-		// if the loaded image is in RGBA format - it supports transparency
-		else if (colorChannels == 4)
-			glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, image);
-		else
+	// check for pixels that need blending, so that objects using
+	// this texture are drawn with the transparent objects
+	if (image.colorChannels == 4)
+	{
+		for (int i = 0; (i < pixelCount) && (image.bTransparent == false); i++)
 		{
-			std::cout << "Not implemented to handle image with " << colorChannels << " channels" << std::endl;
-			return false;
+			if (image.pixels[i * 4 + 3] < 255)
+			{
+				image.bTransparent = true;
+			}
 		}
+	}
 
-		// generate the texture mipmaps for mapping textures to lower resolutions
-		glGenerateMipmap(GL_TEXTURE_2D);
-
-		// free the image data from local memory
-		stbi_image_free(image);
-		glBindTexture(GL_TEXTURE_2D, 0); // Unbind the texture
+	// average the color of the image, which the light baker
+	// uses for the light reflected off objects with this texture
+	glm::dvec3 colorSum(0.0);
+	for (int i = 0; i < pixelCount; i++)
+	{
+		colorSum += glm::dvec3(
+			image.pixels[i * image.colorChannels],
+			image.pixels[i * image.colorChannels + 1],
+			image.pixels[i * image.colorChannels + 2]);
+	}
+	if (pixelCount > 0)
+	{
+		image.averageColor = glm::vec3(colorSum / (255.0 * pixelCount));
+	}
 
-		// register the loaded texture and associate it with the special tag string
-		m_textureIDs[m_loadedTextures].ID = textureID;
-		m_textureIDs[m_loadedTextures].tag = tag;
-		m_loadedTextures++;
+	return true;
+}
 
-		return true;
+/***********************************************************
+ *  UploadTextureImage()
+ *
+ *  This method is used for filling an OpenGL texture with a
+ *  decoded image and generating its mipmaps.  Filling an
+ *  existing texture replaces its image, and the texture
+ *  stays bound to the same slot.
+ ***********************************************************/
+bool SceneManager::UploadTextureImage(GLuint textureID, const TEXTURE_IMAGE& image)
+{
+	glBindTexture(GL_TEXTURE_2D, textureID);
+
+	// set the texture wrapping parameters
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+	// set texture filtering parameters
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+	// if the loaded image is in RGB format
+	if (image.colorChannels == 3)
+		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB8, image.width, image.height, 0, GL_RGB, GL_UNSIGNED_BYTE, &image.pixels[0]);
+	// if the loaded image is in RGBA format - it supports transparency
+	else if (image.colorChannels == 4)
+		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, image.width, image.height, 0, GL_RGBA, GL_UNSIGNED_BYTE, &image.pixels[0]);
+	else
+	{
+		glBindTexture(GL_TEXTURE_2D, 0);
+		return false;
 	}
 
-	std::cout << "Could not load image:" << filename << std::endl;
+	// generate the texture mipmaps for mapping textures to lower resolutions
+	glGenerateMipmap(GL_TEXTURE_2D);
+	glBindTexture(GL_TEXTURE_2D, 0); // Unbind the texture
 
-	// Error loading the image
-	return false;
+	return true;
 }
 
 /***********************************************************
@@ -221,6 +759,106 @@ int SceneManager::FindTextureSlot(std::string tag)
 	return(textureSlot);
 }
 
+/***********************************************************
+ *  LoadImportedMesh()
+ *
+ *  This method is used for loading a model file into an
+ *  imported mesh, and associating it with the passed in tag.
+ *  Objects that refer to a mesh that is not loaded are drawn
+ *  with their basic shape instead.
+ ***********************************************************/
+bool SceneManager::LoadImportedMesh(const char* filename, std::string tag)
+{
+	MeshImporter::GPU_MESH mesh;
+	if (m_pMeshImporter->LoadMesh(filename, mesh) == false)
+	{
+		std::cout << "INFO: Could not load model " << filename
+			<< ", drawing the basic shapes instead" << std::endl;
+		return(false);
+	}
+	AddImportedMesh(mesh, tag);
+	return(true);
+}
+
+/***********************************************************
+ *  AddImportedMesh()
+ *
+ *  This method is used for adding a mesh that has been
+ *  handed to OpenGL to the imported meshes, associated with
+ *  the passed in tag.  Returns the index of the mesh.
+ ***********************************************************/
+int SceneManager::AddImportedMesh(const MeshImporter::GPU_MESH& mesh, std::string tag)
+{
+	MESH_INFO meshInfo;
+	meshInfo.tag = tag;
+	meshInfo.mesh = mesh;
+	meshInfo.bStreamed = false;
+	meshInfo.cellReferences = 0;
+
+	// reuse the entry of a streamed mesh that has been freed, so
+	// the indices held by the objects stay the same
+	int index = FindImportedMesh("");
+	if (index >= 0)
+	{
+		m_importedMeshes[index] = meshInfo;
+	}
+	else
+	{
+		index = (int)m_importedMeshes.size();
+		m_importedMeshes.push_back(meshInfo);
+	}
+	return(index);
+}
+
+/***********************************************************
+ *  DestroyImportedMeshes()
+ *
+ *  This method is used for freeing the buffers of all of
+ *  the imported meshes.
+ ***********************************************************/
+void SceneManager::DestroyImportedMeshes()
+{
+	for (size_t i = 0; i < m_importedMeshes.size(); i++)
+	{
+		MeshImporter::DestroyMesh(m_importedMeshes[i].mesh);
+	}
+	m_importedMeshes.clear();
+
+	// the picker meshes of the basic shapes are kept
+	std::map<int, int>::iterator pickMesh = m_pickMeshes.lower_bound(MESH_COUNT);
+	while (pickMesh != m_pickMeshes.end())
+	{
+		m_pScenePicker->RemoveMesh(pickMesh->second);
+		pickMesh = m_pickMeshes.erase(pickMesh);
+	}
+	std::map<int, int>::iterator softwareMesh = m_softwareMeshes.lower_bound(MESH_COUNT);
+	while (softwareMesh != m_softwareMeshes.end())
+	{
+		m_pSoftwareRasterizer->RemoveMesh(softwareMesh->second);
+		softwareMesh = m_softwareMeshes.erase(softwareMesh);
+	}
+	m_bPickerChanged = true;
+}
+
+/***********************************************************
+ *  FindImportedMesh()
+ *
+ *  This method is used for getting the index of the loaded
+ *  imported mesh associated with the passed in tag, or -1
+ *  when it was not loaded.
+ ***********************************************************/
+int SceneManager::FindImportedMesh(std::string tag)
+{
+	for (int index = 0; index < (int)m_importedMeshes.size(); index++)
+	{
+		if (m_importedMeshes[index].tag.compare(tag) == 0)
+		{
+			return(index);
+		}
+	}
+	return(-1);
+}
+
 /***********************************************************
  *  FindMaterial()
  *
@@ -256,11 +894,31 @@ bool SceneManager::FindMaterial(std::string tag, OBJECT_MATERIAL& material)
 	return(true);
 }
 
+/***********************************************************
+ *  FindMaterialIndex()
+ *
+ *  This method is used for getting the index of the defined
+ *  material associated with the passed in tag, or -1 when
+ *  there is none.
+ ***********************************************************/
+int SceneManager::FindMaterialIndex(std::string tag)
+{
+	for (int index = 0; index < (int)m_objectMaterials.size(); index++)
+	{
+		if (m_objectMaterials[index].tag.compare(tag) == 0)
+		{
+			return(index);
+		}
+	}
+	return(-1);
+}
+
 /***********************************************************
  *  SetTransformations()
  *
- *  This method is used for setting the transform buffer
- *  using the passed in transformation values.
+ *  This method is used for setting the transform of the
+ *  next scene object using the passed in transformation
+ *  values.
  ***********************************************************/
 void SceneManager::SetTransformations(
 	glm::vec3 scaleXYZ,
@@ -288,285 +946,3863 @@ void SceneManager::SetTransformations(
 
 	modelView = translation * rotationX * rotationY * rotationZ * scale;
 
-	if (NULL != m_pShaderManager)
-	{
-		m_pShaderManager->setMat4Value(g_ModelName, modelView);
-	}
+	m_pendingObject.model = modelView;
+	m_pendingObject.normalMatrix = glm::mat3(glm::transpose(glm::inverse(modelView)));
+	m_pendingObject.position = positionXYZ;
 }
 
 /***********************************************************
- *  SetShaderColor()
+ *  SetObjectColor()
  *
  *  This method is used for setting the passed in color
- *  into the shader for the next draw command
+ *  for the next scene object, which is drawn untextured.
  ***********************************************************/
-void SceneManager::SetShaderColor(
+void SceneManager::SetObjectColor(
 	float redColorValue,
 	float greenColorValue,
 	float blueColorValue,
 	float alphaValue)
 {
-	// variables for this method
-	glm::vec4 currentColor;
-
-	currentColor.r = redColorValue;
-	currentColor.g = greenColorValue;
-	currentColor.b = blueColorValue;
-	currentColor.a = alphaValue;
-
-	if (NULL != m_pShaderManager)
-	{
-		m_pShaderManager->setIntValue(g_UseTextureName, false);
-		m_pShaderManager->setVec4Value(g_ColorValueName, currentColor);
-	}
+	m_pendingObject.bUseTexture = false;
+	m_pendingObject.color = glm::vec4(
+		redColorValue,
+		greenColorValue,
+		blueColorValue,
+		alphaValue);
 }
 
 /***********************************************************
- *  SetShaderTexture()
+ *  SetObjectTexture()
  *
- *  This method is used for setting the texture data
- *  associated with the passed in ID into the shader.
+ *  This method is used for setting the texture associated
+ *  with the passed in tag for the next scene object.
  ***********************************************************/
-void SceneManager::SetShaderTexture(
+void SceneManager::SetObjectTexture(
 	std::string textureTag)
 {
-	if (NULL != m_pShaderManager)
-	{
-		m_pShaderManager->setIntValue(g_UseTextureName, true);
-
-		int textureID = -1;
-		textureID = FindTextureSlot(textureTag);
-		m_pShaderManager->setSampler2DValue(g_TextureValueName, textureID);
-	}
+	m_pendingObject.bUseTexture = true;
+	m_pendingObject.textureSlot = FindTextureSlot(textureTag);
 }
 
 /***********************************************************
  *  SetTextureUVScale()
  *
  *  This method is used for setting the texture UV scale
- *  values into the shader.
+ *  values for the next scene object.
  ***********************************************************/
 void SceneManager::SetTextureUVScale(float u, float v)
 {
-	if (NULL != m_pShaderManager)
-	{
-		m_pShaderManager->setVec2Value("UVscale", glm::vec2(u, v));
-	}
+	m_pendingObject.UVscale = glm::vec2(u, v);
 }
 
 /***********************************************************
- *  SetShaderMaterial()
+ *  SetObjectMaterial()
  *
- *  This method is used for passing the material values
- *  into the shader.
+ *  This method is used for setting the material associated
+ *  with the passed in tag for the next scene object.
  ***********************************************************/
-void SceneManager::SetShaderMaterial(
+void SceneManager::SetObjectMaterial(
 	std::string materialTag)
 {
-	if (m_objectMaterials.size() > 0)
+	for (int index = 0; index < (int)m_objectMaterials.size(); index++)
 	{
-		OBJECT_MATERIAL material;
-		bool bReturn = false;
-
-		bReturn = FindMaterial(materialTag, material);
-		if (bReturn == true)
+		if (m_objectMaterials[index].tag.compare(materialTag) == 0)
 		{
-			m_pShaderManager->setVec3Value("material.ambientColor", material.ambientColor);
-			m_pShaderManager->setFloatValue("material.ambientStrength", material.ambientStrength);
-			m_pShaderManager->setVec3Value("material.diffuseColor", material.diffuseColor);
-			m_pShaderManager->setVec3Value("material.specularColor", material.specularColor);
-			m_pShaderManager->setFloatValue("material.shininess", material.shininess);
+			m_pendingObject.materialIndex = index;
+			return;
 		}
 	}
 }
 
-/**************************************************************/
-/*** The code in the methods BELOW is for preparing and     ***/
-/*** rendering the 3D replicated scenes.                    ***/
-/**************************************************************/
 /***********************************************************
- *  DefineObjectMaterials()
+ *  AddSceneObject()
  *
- *  This method is used for configuring the various material
- *  settings for all of the objects within the 3D scene.
+ *  This method is used for adding an object to the scene,
+ *  drawn with the passed in mesh and the transform, color,
+ *  texture and material set since the previous object.
+ *  Properties that are not set again carry over to the
+ *  following objects.
  ***********************************************************/
-void SceneManager::DefineObjectMaterials()
+void SceneManager::AddSceneObject(MESH_TYPE mesh)
 {
-	OBJECT_MATERIAL goldMaterial;
-	goldMaterial.ambientColor = glm::vec3(0.2f, 0.2f, 0.2f);
-	goldMaterial.ambientStrength = 0.3f;
-	goldMaterial.diffuseColor = glm::vec3(0.2f, 0.2f, 0.2f);
-	goldMaterial.specularColor = glm::vec3(0.5f, 0.5f, 0.5f);
-	goldMaterial.shininess = 22.0;
-	goldMaterial.tag = "metal";
+	SCENE_OBJECT object = m_pendingObject;
+	object.mesh = mesh;
+	FinishSceneObject(object);
 
-	m_objectMaterials.push_back(goldMaterial);
+	m_sceneObjects.push_back(object);
+}
 
-	OBJECT_MATERIAL woodMaterial;
-	woodMaterial.ambientColor = glm::vec3(0.1f, 0.1f, 0.1f);
-	woodMaterial.ambientStrength = 0.2f;
-	woodMaterial.diffuseColor = glm::vec3(0.3f, 0.3f, 0.3f);
-	woodMaterial.specularColor = glm::vec3(0.1f, 0.1f, 0.1f);
-	woodMaterial.shininess = 0.3;
-	woodMaterial.tag = "wood";
+/***********************************************************
+ *  AddSceneObject()
+ *
+ *  This method is used for adding an object drawn with the
+ *  imported mesh associated with the passed in tag.  The
+ *  mesh is scaled evenly to fit into the space the basic
+ *  shape would take up, standing on its bottom, so the same
+ *  transformations place either of them in the scene.
+ ***********************************************************/
+void SceneManager::AddSceneObject(MESH_TYPE mesh, std::string importedMeshTag)
+{
+	int meshIndex = FindImportedMesh(importedMeshTag);
+	if (meshIndex < 0)
+	{
+		AddSceneObject(mesh);
+		return;
+	}
 
-	m_objectMaterials.push_back(woodMaterial);
+	glm::mat4 savedModel = m_pendingObject.model;
+	glm::mat3 savedNormalMatrix = m_pendingObject.normalMatrix;
+	m_pendingObject.model = savedModel * GetMeshFitTransform(mesh, m_importedMeshes[meshIndex].mesh);
+	m_pendingObject.normalMatrix = glm::mat3(glm::transpose(glm::inverse(m_pendingObject.model)));
+	m_pendingObject.importedMesh = meshIndex;
 
-	OBJECT_MATERIAL glassMaterial;
-	glassMaterial.ambientColor = glm::vec3(0.4f, 0.4f, 0.4f);
-	glassMaterial.ambientStrength = 0.3f;
-	glassMaterial.diffuseColor = glm::vec3(0.3f, 0.3f, 0.3f);
-	glassMaterial.specularColor = glm::vec3(0.6f, 0.6f, 0.6f);
-	glassMaterial.shininess = 85.0;
-	glassMaterial.tag = "glass";
+	AddSceneObject(MESH_IMPORTED);
 
-	m_objectMaterials.push_back(glassMaterial);
+	m_pendingObject.model = savedModel;
+	m_pendingObject.normalMatrix = savedNormalMatrix;
+	m_pendingObject.importedMesh = -1;
+}
 
-	OBJECT_MATERIAL plasticMaterial;
-	plasticMaterial.ambientColor = glm::vec3(0.2f, 0.2f, 0.2f);
-	plasticMaterial.ambientStrength = 0.5f;
-	plasticMaterial.diffuseColor = glm::vec3(0.4f, 0.4f, 0.4f);
-	plasticMaterial.specularColor = glm::vec3(0.7f, 0.7f, 0.7f);
-	plasticMaterial.shininess =60.0;
-	plasticMaterial.tag = "plastic";
+/***********************************************************
+ *  FinishSceneObject()
+ *
+ *  This method is used for setting the properties of a new
+ *  object that follow from the others, which are whether it
+ *  is drawn with blending and the shader variant it needs.
+ ***********************************************************/
+void SceneManager::FinishSceneObject(SCENE_OBJECT& object) const
+{
+	// objects that need blending are drawn after the opaque ones
+	if (object.bUseTexture == true)
+	{
+		object.bTransparent = (object.textureSlot >= 0) &&
+			(m_textureIDs[object.textureSlot].bTransparent == true);
+	}
+	else
+	{
+		object.bTransparent = (object.color.a < 1.0f);
+	}
 
-	m_objectMaterials.push_back(plasticMaterial);
+	object.variantKey = GetVariantKey(object);
+}
 
-	OBJECT_MATERIAL clothMaterial;
-	clothMaterial.ambientColor = glm::vec3(0.3f, 0.3f, 0.3f);
-	clothMaterial.ambientStrength = 0.7f;
-	clothMaterial.diffuseColor = glm::vec3(0.5f, 0.5f, 0.5f);
-	clothMaterial.specularColor = glm::vec3(0.1f, 0.1f, 0.1f); // Cloth is less shiny
+/***********************************************************
+ *  LoadSceneFileAssets()
+ *
+ *  This method is used for loading the textures and model
+ *  files listed in a cooked scene file, and adding its
+ *  materials.  Textures and model files whose tags are
+ *  already loaded are kept.
+ ***********************************************************/
+void SceneManager::LoadSceneFileAssets(const SceneFile& sceneFile)
+{
+	const SceneFile::FILE_HEADER& header = sceneFile.GetHeader();
+
+	const SceneFile::ASSET_RECORD* textures = sceneFile.GetTextures();
+	for (unsigned int i = 0; i < header.textureCount; i++)
+	{
+		if (FindTextureSlot(sceneFile.GetString(textures[i].tagOffset)) >= 0)
+		{
+			continue;
+		}
+		CreateGLTexture(
+			sceneFile.GetString(textures[i].pathOffset),
+			sceneFile.GetString(textures[i].tagOffset));
+	}
+	BindGLTextures();
+
+	m_pMeshImporter->SetCacheDirectory(g_MeshCacheDirectory);
+	const SceneFile::ASSET_RECORD* meshes = sceneFile.GetMeshes();
+	for (unsigned int i = 0; i < header.meshCount; i++)
+	{
+		if (FindImportedMesh(sceneFile.GetString(meshes[i].tagOffset)) >= 0)
+		{
+			continue;
+		}
+		LoadImportedMesh(
+			sceneFile.GetString(meshes[i].pathOffset),
+			sceneFile.GetString(meshes[i].tagOffset));
+	}
+
+	LoadSceneFileMaterials(sceneFile);
+}
+
+/***********************************************************
+ *  LoadSceneFileMaterials()
+ *
+ *  This method is used for replacing the materials with
+ *  those of a cooked scene file.  The materials of the file
+ *  are the whole material list, so the objects can use their
+ *  indices unchanged.
+ ***********************************************************/
+void SceneManager::LoadSceneFileMaterials(const SceneFile& sceneFile)
+{
+	const SceneFile::MATERIAL_RECORD* materials = sceneFile.GetMaterials();
+	m_objectMaterials.clear();
+	for (unsigned int i = 0; i < sceneFile.GetHeader().materialCount; i++)
+	{
+		m_objectMaterials.push_back(GetSceneFileMaterial(sceneFile, materials[i]));
+	}
+}
+
+/***********************************************************
+ *  MergeSceneFileMaterials()
+ *
+ *  This method is used for adding the materials of a cooked
+ *  scene file whose tags are not defined yet, for streamed
+ *  cells that each list only the materials they use.
+ ***********************************************************/
+void SceneManager::MergeSceneFileMaterials(const SceneFile& sceneFile)
+{
+	bool bAdded = false;
+	const SceneFile::MATERIAL_RECORD* materials = sceneFile.GetMaterials();
+	for (unsigned int i = 0; i < sceneFile.GetHeader().materialCount; i++)
+	{
+		if (FindMaterialIndex(sceneFile.GetString(materials[i].tagOffset)) < 0)
+		{
+			m_objectMaterials.push_back(GetSceneFileMaterial(sceneFile, materials[i]));
+			bAdded = true;
+		}
+	}
+	if ((bAdded == true) && (m_bUseDeferredShading == true))
+	{
+		UpdateDeferredMaterials();
+	}
+}
+
+/***********************************************************
+ *  AddSceneFileObjects()
+ *
+ *  This method is used for adding the objects of a cooked
+ *  scene file.  The records are read straight from the
+ *  mapped file into the scene objects.  Textures and model
+ *  files are looked up by tag once each, not once for every
+ *  object, and objects whose model file did not load are
+ *  drawn with their basic shape.  The materials of a whole
+ *  scene file are the material list, while those of a
+ *  streamed cell are looked up by tag as well.
+ ***********************************************************/
+void SceneManager::AddSceneFileObjects(const SceneFile& sceneFile, int streamCell)
+{
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	const SceneFile::FILE_HEADER& header = sceneFile.GetHeader();
+
+	std::vector<int> textureSlots(header.textureCount);
+	for (unsigned int i = 0; i < header.textureCount; i++)
+	{
+		textureSlots[i] = FindTextureSlot(sceneFile.GetString(sceneFile.GetTextures()[i].tagOffset));
+	}
+	std::vector<int> meshIndices(header.meshCount);
+	for (unsigned int i = 0; i < header.meshCount; i++)
+	{
+		meshIndices[i] = FindImportedMesh(sceneFile.GetString(sceneFile.GetMeshes()[i].tagOffset));
+	}
+	std::vector<int> materialIndices(header.materialCount);
+	for (unsigned int i = 0; i < header.materialCount; i++)
+	{
+		materialIndices[i] = (streamCell < 0) ? (int)i :
+			FindMaterialIndex(sceneFile.GetString(sceneFile.GetMaterials()[i].tagOffset));
+	}
+
+	const SceneFile::OBJECT_RECORD* records = sceneFile.GetObjects();
+	size_t firstObject = m_sceneObjects.size();
+	m_sceneObjects.resize(firstObject + header.objectCount);
+	for (unsigned int i = 0; i < header.objectCount; i++)
+	{
+		const SceneFile::OBJECT_RECORD& record = records[i];
+		SCENE_OBJECT& object = m_sceneObjects[firstObject + i];
+
+		memcpy(&object.model[0][0], record.model, sizeof(record.model));
+		memcpy(&object.normalMatrix[0][0], record.normalMatrix, sizeof(record.normalMatrix));
+		object.position = glm::vec3(record.position[0], record.position[1], record.position[2]);
+		object.mesh = (MESH_TYPE)record.shape;
+		object.importedMesh = -1;
+		object.color = glm::vec4(record.color[0], record.color[1], record.color[2], record.color[3]);
+		object.UVscale = glm::vec2(record.UVscale[0], record.UVscale[1]);
+		object.bUseTexture = (record.texture >= 0);
+		object.textureSlot = (record.texture >= 0) ? textureSlots[record.texture] : -1;
+		object.materialIndex = (record.material >= 0) ? materialIndices[record.material] : -1;
+		object.streamCell = streamCell;
+		object.impostorGroup = -1;
+
+		if ((record.mesh >= 0) && (meshIndices[record.mesh] >= 0))
+		{
+			// the fit is an even scale and a move, so the normal
+			// matrix only needs dividing by the scale
+			glm::mat4 fit = GetMeshFitTransform(object.mesh, m_importedMeshes[meshIndices[record.mesh]].mesh);
+			object.model = object.model * fit;
+			object.normalMatrix = object.normalMatrix * (1.0f / fit[0][0]);
+			object.mesh = MESH_IMPORTED;
+			object.importedMesh = meshIndices[record.mesh];
+		}
+
+		FinishSceneObject(object);
+	}
+
+	if (streamCell < 0)
+	{
+		double elapsed = std::chrono::duration<double, std::milli>(
+			std::chrono::steady_clock::now() - start).count();
+		std::cout << "INFO: Loaded " << header.objectCount << " objects from "
+			<< m_sceneFilePath << " in " << elapsed << " ms" << std::endl;
+	}
+}
+
+/***********************************************************
+ *  GetVariantKey()
+ *
+ *  This method is used for getting the key of the cheapest
+ *  shader variant that can draw the passed in object with
+ *  the current lights, or with the baked lighting.
+ ***********************************************************/
+unsigned int SceneManager::GetVariantKey(const SCENE_OBJECT& object) const
+{
+	if ((m_bUseBakedLighting == true) && (m_bUseLighting == true))
+	{
+		return(ShaderVariantCache::MakeBakedKey(object.bUseTexture, object.bTransparent));
+	}
+	return(ShaderVariantCache::MakeKey(
+		object.bUseTexture,
+		m_bUseLighting,
+		object.bTransparent,
+		(int)m_lightSources.size(),
+		m_bUseClusteredLighting));
+}
+
+/***********************************************************
+ *  SortSceneObjects()
+ *
+ *  This method is used for sorting the opaque objects by
+ *  shader variant, so each variant is bound once per frame,
+ *  and collecting the transparent objects that are sorted
+ *  by distance every frame.
+ ***********************************************************/
+void SceneManager::SortSceneObjects()
+{
+	m_opaqueDrawOrder.clear();
+	m_transparentDrawOrder.clear();
+
+	for (int i = 0; i < (int)m_sceneObjects.size(); i++)
+	{
+		if (m_sceneObjects[i].bTransparent == true)
+		{
+			m_transparentDrawOrder.push_back(i);
+		}
+		else
+		{
+			m_opaqueDrawOrder.push_back(i);
+		}
+	}
+
+	const std::vector<SCENE_OBJECT>& objects = m_sceneObjects;
+	std::stable_sort(m_opaqueDrawOrder.begin(), m_opaqueDrawOrder.end(),
+		[&objects](int a, int b)
+		{
+			return(objects[a].variantKey < objects[b].variantKey);
+		});
+
+	// the recorded objects are also sorted by the mesh, texture and
+	// material that split their runs
+	m_recordedDrawOrder.clear();
+	if (m_bUseRecordedDraws == true)
+	{
+		for (size_t i = 0; i < m_opaqueDrawOrder.size(); i++)
+		{
+			if (m_sceneObjects[m_opaqueDrawOrder[i]].mesh != MESH_IMPORTED)
+			{
+				m_recordedDrawOrder.push_back(m_opaqueDrawOrder[i]);
+			}
+		}
+		std::stable_sort(m_recordedDrawOrder.begin(), m_recordedDrawOrder.end(),
+			[&objects](int a, int b)
+			{
+				const SCENE_OBJECT& objectA = objects[a];
+				const SCENE_OBJECT& objectB = objects[b];
+				if (objectA.variantKey != objectB.variantKey)
+				{
+					return(objectA.variantKey < objectB.variantKey);
+				}
+				if (objectA.mesh != objectB.mesh)
+				{
+					return(objectA.mesh < objectB.mesh);
+				}
+				int textureA = (objectA.bUseTexture == true) ? objectA.textureSlot : -1;
+				int textureB = (objectB.bUseTexture == true) ? objectB.textureSlot : -1;
+				if (textureA != textureB)
+				{
+					return(textureA < textureB);
+				}
+				return(objectA.materialIndex < objectB.materialIndex);
+			});
+	}
+
+	// every change to the objects comes through here
+	m_bPickerChanged = true;
+}
+
+/***********************************************************
+ *  PrecompileSceneVariants()
+ *
+ *  This method is used for starting to build the shader
+ *  variants used by all of the scene objects at once.
+ ***********************************************************/
+void SceneManager::PrecompileSceneVariants()
+{
+	std::vector<unsigned int> variantKeys;
+	for (size_t i = 0; i < m_sceneObjects.size(); i++)
+	{
+		if (std::find(variantKeys.begin(), variantKeys.end(),
+			m_sceneObjects[i].variantKey) == variantKeys.end())
+		{
+			variantKeys.push_back(m_sceneObjects[i].variantKey);
+		}
+
+		// the opaque basic shapes are drawn from records
+		if ((m_bUseRecordedDraws == true) && (m_sceneObjects[i].bTransparent == false) &&
+			(m_sceneObjects[i].mesh != MESH_IMPORTED))
+		{
+			unsigned int recordedKey = ShaderVariantCache::MakeRecordedKey(m_sceneObjects[i].variantKey);
+			if (std::find(variantKeys.begin(), variantKeys.end(), recordedKey) == variantKeys.end())
+			{
+				variantKeys.push_back(recordedKey);
+			}
+		}
+
+		// the opaque objects are also drawn into the G-buffer
+		if ((m_bUseDeferredShading == true) && (m_sceneObjects[i].bTransparent == false))
+		{
+			unsigned int gbufferKey = ShaderVariantCache::MakeGBufferKey(m_sceneObjects[i].bUseTexture);
+			if (std::find(variantKeys.begin(), variantKeys.end(), gbufferKey) == variantKeys.end())
+			{
+				variantKeys.push_back(gbufferKey);
+			}
+		}
+	}
+	m_pShaderVariants->PrecompileVariants(variantKeys);
+}
+
+/***********************************************************
+ *  UpdateVariantKeys()
+ *
+ *  This method is used for picking the shader variants of
+ *  the scene objects again after the lights have changed.
+ ***********************************************************/
+void SceneManager::UpdateVariantKeys()
+{
+	for (size_t i = 0; i < m_sceneObjects.size(); i++)
+	{
+		m_sceneObjects[i].variantKey = GetVariantKey(m_sceneObjects[i]);
+	}
+	SortSceneObjects();
+
+	if (m_bUseShaderVariants == true)
+	{
+		PrecompileSceneVariants();
+	}
+}
+
+/***********************************************************
+ *  SetViewTransform()
+ *
+ *  This method is used for setting the view and projection
+ *  that the next frame is rendered with.
+ ***********************************************************/
+void SceneManager::SetViewTransform(
+	const glm::mat4& view,
+	const glm::mat4& projection,
+	const glm::vec3& viewPosition)
+{
+	m_viewMatrix = view;
+	m_projectionMatrix = projection;
+	m_viewPosition = viewPosition;
+}
+
+/***********************************************************
+ *  SetQuadViews()
+ *
+ *  This method is used for showing four views at once, one
+ *  in each quarter of the viewport, in the order top left,
+ *  top right, bottom left and bottom right.  The view set by
+ *  SetViewTransform() is still followed by the streaming.
+ ***********************************************************/
+void SceneManager::SetQuadViews(
+	const glm::mat4* views,
+	const glm::mat4* projections,
+	const glm::vec3* viewPositions)
+{
+	for (int i = 0; i < ShaderVariantCache::MULTI_VIEW_COUNT; i++)
+	{
+		m_quadViewMatrices[i] = views[i];
+		m_quadProjectionMatrices[i] = projections[i];
+		m_quadViewPositions[i] = viewPositions[i];
+	}
+	m_bQuadView = true;
+}
+
+/***********************************************************
+ *  ClearQuadViews()
+ *
+ *  This method is used for going back to showing only the
+ *  view set by SetViewTransform().
+ ***********************************************************/
+void SceneManager::ClearQuadViews()
+{
+	m_bQuadView = false;
+}
+
+/***********************************************************
+ *  SetFrameUniforms()
+ *
+ *  This method is used for passing the view, projection and
+ *  light source values into the active shader program.  It
+ *  is called whenever a different shader variant is bound.
+ ***********************************************************/
+void SceneManager::SetFrameUniforms()
+{
+	if (NULL == m_pShaderManager)
+	{
+		return;
+	}
+
+	m_pShaderManager->setMat4Value(g_ViewName, m_viewMatrix);
+	m_pShaderManager->setMat4Value(g_ProjectionName, m_projectionMatrix);
+	m_pShaderManager->setVec3Value(g_ViewPositionName, m_viewPosition);
+
+	// the multi view variants apply every quad view themselves
+	if (m_bDrawingQuadViews == true)
+	{
+		for (int i = 0; i < ShaderVariantCache::MULTI_VIEW_COUNT; i++)
+		{
+			std::string index = "[" + std::to_string(i) + "]";
+			m_pShaderManager->setMat4Value("views" + index, m_quadViewMatrices[i]);
+			m_pShaderManager->setMat4Value("projections" + index, m_quadProjectionMatrices[i]);
+			m_pShaderManager->setVec3Value("viewPositions" + index, m_quadViewPositions[i]);
+		}
+	}
+
+	m_pShaderManager->setBoolValue(g_UseLightingName, m_bUseLighting);
+
+	// the baked variants read the light from the probe volume,
+	// the clustered variants read the lights from the cluster
+	// grid, everything else gets a fixed number of light uniforms
+	if ((m_bUseBakedLighting == true) &&
+		(m_bUseShaderVariants == true) &&
+		(m_pShaderVariants->IsBaseProgramActive() == false))
+	{
+		m_pLightBaker->ApplyToProgram(m_pShaderManager->m_programID);
+	}
+	else if ((m_bUseClusteredLighting == true) &&
+		(m_bDrawingQuadViews == false) &&
+		(m_bUseShaderVariants == true) &&
+		(m_pShaderVariants->IsBaseProgramActive() == false))
+	{
+		m_pClusteredLighting->ApplyToProgram(m_pShaderManager->m_programID);
+	}
+	else
+	{
+		int lightCount = std::min((int)m_lightSources.size(), ShaderVariantCache::MAX_LIGHT_COUNT);
+		for (int i = 0; i < lightCount; i++)
+		{
+			const LIGHT_SOURCE& light = m_lightSources[i];
+			std::string name = "lightSources[" + std::to_string(i) + "].";
+			m_pShaderManager->setIntValue(name + "type", (int)light.type);
+			m_pShaderManager->setVec3Value(name + "position", light.position);
+			m_pShaderManager->setVec3Value(name + "direction", glm::normalize(light.direction));
+			m_pShaderManager->setFloatValue(name + "range", light.range);
+			m_pShaderManager->setFloatValue(name + "innerConeCosine", cos(glm::radians(light.innerConeAngle)));
+			m_pShaderManager->setFloatValue(name + "outerConeCosine", cos(glm::radians(light.outerConeAngle)));
+			m_pShaderManager->setVec3Value(name + "ambientColor", light.ambientColor);
+			m_pShaderManager->setVec3Value(name + "diffuseColor", light.diffuseColor);
+			m_pShaderManager->setVec3Value(name + "specularColor", light.specularColor);
+			m_pShaderManager->setFloatValue(name + "focalStrength", light.focalStrength);
+			m_pShaderManager->setFloatValue(name + "specularIntensity", light.specularIntensity);
+		}
+	}
+	m_pShaderManager->setVec3Value("ambientLight.color", m_ambientLightColor);
+	m_pShaderManager->setFloatValue("ambientLight.intensity", m_ambientLightIntensity);
+}
+
+/***********************************************************
+ *  SetObjectUniforms()
+ *
+ *  This method is used for passing the transform, color,
+ *  texture and material of a scene object into the shader.
+ ***********************************************************/
+void SceneManager::SetObjectUniforms(const SCENE_OBJECT& object)
+{
+	if (NULL == m_pShaderManager)
+	{
+		return;
+	}
+
+	m_pShaderManager->setMat4Value(g_ModelName, object.model);
+	m_pShaderManager->setMat3Value(g_NormalMatrixName, object.normalMatrix);
+
+	if (object.bUseTexture == true)
+	{
+		m_pShaderManager->setIntValue(g_UseTextureName, true);
+		m_pShaderManager->setSampler2DValue(g_TextureValueName, object.textureSlot);
+		m_pShaderManager->setVec2Value("UVscale", object.UVscale);
+	}
+	else
+	{
+		m_pShaderManager->setIntValue(g_UseTextureName, false);
+		m_pShaderManager->setVec4Value(g_ColorValueName, object.color);
+	}
+
+	SetMaterialUniforms(object.materialIndex);
+}
+
+/***********************************************************
+ *  SetMaterialUniforms()
+ *
+ *  This method is used for passing the lighting values of a
+ *  material into the shader.  Objects without a material
+ *  leave the values as they are.
+ ***********************************************************/
+void SceneManager::SetMaterialUniforms(int materialIndex)
+{
+	if ((NULL == m_pShaderManager) || (materialIndex < 0))
+	{
+		return;
+	}
+
+	const OBJECT_MATERIAL& material = m_objectMaterials[materialIndex];
+	m_pShaderManager->setVec3Value("material.ambientColor", material.ambientColor);
+	m_pShaderManager->setFloatValue("material.ambientStrength", material.ambientStrength);
+	m_pShaderManager->setVec3Value("material.diffuseColor", material.diffuseColor);
+	m_pShaderManager->setVec3Value("material.specularColor", material.specularColor);
+	m_pShaderManager->setFloatValue("material.shininess", material.shininess);
+}
+
+/***********************************************************
+ *  DrawRecordedObjects()
+ *
+ *  This method is used for drawing the opaque basic shapes
+ *  from records.  The objects are recorded on the worker
+ *  threads of the draw recorder, and each run is drawn with
+ *  one instanced draw, setting only the variant, texture
+ *  and material that change from the run before it.
+ *  Returns false, leaving the objects to be drawn one at a
+ *  time, when the records do not fit into the buffer.
+ ***********************************************************/
+bool SceneManager::DrawRecordedObjects()
+{
+	m_pDrawRecorder->Record(m_recordedDrawOrder,
+		[this](int item, DrawRecorder::OBJECT_RECORD& record, DrawRecorder::DRAW_RUN& state)
+		{
+			const SCENE_OBJECT& object = m_sceneObjects[item];
+			if (IsDrawnAsImpostor(object) == true)
+			{
+				return(false);
+			}
+
+			record.model = object.model;
+			for (int column = 0; column < 3; column++)
+			{
+				record.normalMatrix[column] = glm::vec4(object.normalMatrix[column], 0.0f);
+			}
+			record.color = (object.bUseTexture == true) ? glm::vec4(object.UVscale.x, object.UVscale.y, 0.0f, 0.0f) : object.color;
+
+			state.variantKey = ShaderVariantCache::MakeRecordedKey(object.variantKey);
+			state.mesh = m_recordedMeshes[object.mesh];
+			state.textureSlot = (object.bUseTexture == true) ? object.textureSlot : -1;
+			state.materialIndex = object.materialIndex;
+			return(true);
+		});
+	if (m_pDrawRecorder->Upload() == false)
+	{
+		return(false);
+	}
+
+	int textureSlot = -1;
+	int materialIndex = -1;
+	for (int i = 0; i < m_pDrawRecorder->GetRunCount(); i++)
+	{
+		const DrawRecorder::DRAW_RUN& run = m_pDrawRecorder->GetRun(i);
+
+		// bind the variant for the run, and pass the frame values
+		// and the records into it when it is a different program
+		bool bNewProgram = (m_pShaderVariants->UseVariant(run.variantKey) == true) || (i == 0);
+		if (bNewProgram == true)
+		{
+			SetFrameUniforms();
+			m_pDrawRecorder->ApplyToProgram(m_pShaderManager->m_programID);
+		}
+		if ((run.textureSlot >= 0) && ((bNewProgram == true) || (run.textureSlot != textureSlot)))
+		{
+			m_pShaderManager->setSampler2DValue(g_TextureValueName, run.textureSlot);
+			textureSlot = run.textureSlot;
+		}
+		if ((run.materialIndex >= 0) && ((bNewProgram == true) || (run.materialIndex != materialIndex)))
+		{
+			SetMaterialUniforms(run.materialIndex);
+			materialIndex = run.materialIndex;
+		}
+		m_pDrawRecorder->DrawRun(i);
+	}
+	return(true);
+}
+
+/***********************************************************
+ *  DrawDeferredObjects()
+ *
+ *  This method is used for drawing the opaque objects into
+ *  the G-buffer with their G-buffer variants, then lighting
+ *  every covered pixel once in the deferred lighting pass.
+ ***********************************************************/
+void SceneManager::DrawDeferredObjects()
+{
+	for (size_t i = 0; i < m_opaqueDrawOrder.size(); i++)
+	{
+		const SCENE_OBJECT& object = m_sceneObjects[m_opaqueDrawOrder[i]];
+		if (IsDrawnAsImpostor(object) == true)
+		{
+			continue;
+		}
+
+		// the G-buffer variants only need the view and projection
+		if (m_pShaderVariants->UseVariant(
+			ShaderVariantCache::MakeGBufferKey(object.bUseTexture)) == true)
+		{
+			m_pShaderManager->setMat4Value(g_ViewName, m_viewMatrix);
+			m_pShaderManager->setMat4Value(g_ProjectionName, m_projectionMatrix);
+		}
+
+		m_pShaderManager->setIntValue(g_MaterialIndexName, object.materialIndex + 1);
+		SetObjectUniforms(object);
+		DrawObjectMesh(object);
+	}
+
+	m_pDeferredRenderer->EndGeometryPass(
+		m_lightSources,
+		m_viewMatrix,
+		m_projectionMatrix,
+		m_viewPosition,
+		m_ambientLightColor * m_ambientLightIntensity,
+		m_bUseLighting);
+}
+
+/***********************************************************
+ *  DrawObjectMesh()
+ *
+ *  This method is used for drawing the basic shape mesh
+ *  used by a scene object, or the visible meshlets of its
+ *  imported mesh.
+ ***********************************************************/
+void SceneManager::DrawObjectMesh(const SCENE_OBJECT& object)
+{
+	switch (object.mesh)
+	{
+	case MESH_PLANE:
+		m_basicMeshes->DrawPlaneMesh();
+		break;
+	case MESH_BOX:
+		m_basicMeshes->DrawBoxMesh();
+		break;
+	case MESH_CYLINDER:
+		m_pPrimitiveMeshes->DrawCylinderMesh();
+		break;
+	case MESH_CONE:
+		m_pPrimitiveMeshes->DrawConeMesh();
+		break;
+	case MESH_SPHERE:
+		m_pPrimitiveMeshes->DrawSphereMesh();
+		break;
+	case MESH_HALF_SPHERE:
+		m_pPrimitiveMeshes->DrawHalfSphereMesh();
+		break;
+	case MESH_TORUS:
+		m_pPrimitiveMeshes->DrawTorusMesh();
+		break;
+	case MESH_HALF_TORUS:
+		m_pPrimitiveMeshes->DrawHalfTorusMesh();
+		break;
+	case MESH_IMPORTED:
+		if ((object.importedMesh >= 0) && (object.importedMesh < (int)m_importedMeshes.size()))
+		{
+			const MeshImporter::GPU_MESH& mesh = m_importedMeshes[object.importedMesh].mesh;
+
+			// the meshlets are culled in the mesh's own space.  facing
+			// away needs a camera position, and a mirrored transform
+			// would swap which side the triangles face
+			bool bCullBackfaces = (m_projectionMatrix[3][3] == 0.0f) &&
+				(glm::determinant(glm::mat3(object.model)) > 0.0f);
+			glm::vec3 viewPosition = glm::vec3(glm::inverse(object.model) * glm::vec4(m_viewPosition, 1.0f));
+
+			// a meshlet drawn into all of the quad views at once is kept
+			// when any one of them can see it, from either side
+			glm::mat4 modelViewProjections[ShaderVariantCache::MULTI_VIEW_COUNT];
+			int viewCount = 1;
+			modelViewProjections[0] = m_projectionMatrix * m_viewMatrix * object.model;
+			if (m_bDrawingQuadViews == true)
+			{
+				viewCount = ShaderVariantCache::MULTI_VIEW_COUNT;
+				for (int i = 0; i < viewCount; i++)
+				{
+					modelViewProjections[i] = m_quadProjectionMatrices[i] * m_quadViewMatrices[i] * object.model;
+				}
+				bCullBackfaces = false;
+			}
+			m_pMeshImporter->DrawMeshClusters(
+				mesh,
+				SelectMeshLOD(object, mesh),
+				modelViewProjections,
+				viewCount,
+				viewPosition,
+				bCullBackfaces);
+		}
+		break;
+	default:
+		break;
+	}
+}
+
+/***********************************************************
+ *  SelectMeshLOD()
+ *
+ *  This method is used for picking the detail level of an
+ *  imported mesh from how large its error would appear on
+ *  the screen.  The distance is taken to the nearest point
+ *  of the mesh's bounding sphere, so a large mesh is drawn
+ *  in full detail when the camera is close to any part of it.
+ ***********************************************************/
+int SceneManager::SelectMeshLOD(const SCENE_OBJECT& object, const MeshImporter::GPU_MESH& mesh) const
+{
+	if ((mesh.lods.size() < 2) || (m_viewportHeight <= 0))
+	{
+		return(0);
+	}
+
+	float scale = std::max(glm::length(glm::vec3(object.model[0])),
+		std::max(glm::length(glm::vec3(object.model[1])), glm::length(glm::vec3(object.model[2]))));
+	glm::vec3 center = glm::vec3(object.model * glm::vec4((mesh.boundsMin + mesh.boundsMax) * 0.5f, 1.0f));
+	float radius = glm::length(mesh.boundsMax - mesh.boundsMin) * 0.5f * scale;
+
+	// pixels covered by one unit of the mesh, which does not change
+	// with distance in an orthographic projection
+	float pixelsPerUnit = m_projectionMatrix[1][1] * 0.5f * (float)m_viewportHeight * scale;
+	if (m_projectionMatrix[3][3] == 0.0f)
+	{
+		float distance = glm::length(center - m_viewPosition) - radius;
+		if (distance <= 0.0f)
+		{
+			return(0);
+		}
+		pixelsPerUnit /= distance;
+	}
+
+	return(MeshImporter::SelectLOD(mesh, pixelsPerUnit, g_MaxLODPixelError));
+}
+
+/**************************************************************/
+/*** The code in the methods BELOW is for preparing and     ***/
+/*** rendering the 3D replicated scenes.                    ***/
+/**************************************************************/
+/***********************************************************
+ *  DefineObjectMaterials()
+ *
+ *  This method is used for configuring the various material
+ *  settings for all of the objects within the 3D scene.
+ ***********************************************************/
+void SceneManager::DefineObjectMaterials()
+{
+	OBJECT_MATERIAL goldMaterial;
+	goldMaterial.ambientColor = glm::vec3(0.2f, 0.2f, 0.2f);
+	goldMaterial.ambientStrength = 0.3f;
+	goldMaterial.diffuseColor = glm::vec3(0.2f, 0.2f, 0.2f);
+	goldMaterial.specularColor = glm::vec3(0.5f, 0.5f, 0.5f);
+	goldMaterial.shininess = 22.0;
+	goldMaterial.tag = "metal";
+
+	m_objectMaterials.push_back(goldMaterial);
+
+	OBJECT_MATERIAL woodMaterial;
+	woodMaterial.ambientColor = glm::vec3(0.1f, 0.1f, 0.1f);
+	woodMaterial.ambientStrength = 0.2f;
+	woodMaterial.diffuseColor = glm::vec3(0.3f, 0.3f, 0.3f);
+	woodMaterial.specularColor = glm::vec3(0.1f, 0.1f, 0.1f);
+	woodMaterial.shininess = 0.3;
+	woodMaterial.tag = "wood";
+
+	m_objectMaterials.push_back(woodMaterial);
+
+	OBJECT_MATERIAL glassMaterial;
+	glassMaterial.ambientColor = glm::vec3(0.4f, 0.4f, 0.4f);
+	glassMaterial.ambientStrength = 0.3f;
+	glassMaterial.diffuseColor = glm::vec3(0.3f, 0.3f, 0.3f);
+	glassMaterial.specularColor = glm::vec3(0.6f, 0.6f, 0.6f);
+	glassMaterial.shininess = 85.0;
+	glassMaterial.tag = "glass";
+
+	m_objectMaterials.push_back(glassMaterial);
+
+	OBJECT_MATERIAL plasticMaterial;
+	plasticMaterial.ambientColor = glm::vec3(0.2f, 0.2f, 0.2f);
+	plasticMaterial.ambientStrength = 0.5f;
+	plasticMaterial.diffuseColor = glm::vec3(0.4f, 0.4f, 0.4f);
+	plasticMaterial.specularColor = glm::vec3(0.7f, 0.7f, 0.7f);
+	plasticMaterial.shininess =60.0;
+	plasticMaterial.tag = "plastic";
+
+	m_objectMaterials.push_back(plasticMaterial);
+
+	OBJECT_MATERIAL clothMaterial;
+	clothMaterial.ambientColor = glm::vec3(0.3f, 0.3f, 0.3f);
+	clothMaterial.ambientStrength = 0.7f;
+	clothMaterial.diffuseColor = glm::vec3(0.5f, 0.5f, 0.5f);
+	clothMaterial.specularColor = glm::vec3(0.1f, 0.1f, 0.1f); // Cloth is less shiny
 	clothMaterial.shininess = 10.0;
 	clothMaterial.tag = "cloth";
 
-	m_objectMaterials.push_back(clothMaterial);
+	m_objectMaterials.push_back(clothMaterial);
+
+	OBJECT_MATERIAL aluminumMaterial;
+	aluminumMaterial.ambientColor = glm::vec3(0.3f, 0.3f, 0.3f);
+	aluminumMaterial.ambientStrength = 0.5f;
+	aluminumMaterial.diffuseColor = glm::vec3(0.5f, 0.5f, 0.5f);
+	aluminumMaterial.specularColor = glm::vec3(0.8f, 0.8f, 0.8f);
+	aluminumMaterial.shininess = 90.0;
+	aluminumMaterial.tag = "aluminum";
+
+	m_objectMaterials.push_back(aluminumMaterial);
+
+}
+/***********************************************************
+ *  LoadSceneTextures()
+ *
+ *  This method is used for preparing the 3D scene by loading
+ *  the shapes, textures in memory to support the 3D scene
+ *  rendering
+ ***********************************************************/
+void SceneManager::LoadSceneTextures()
+{
+	bool bReturn = false;
+
+	bReturn = CreateGLTexture(
+		"C:/Users/katel/Downloads/CS330Content/CS330Content/Projects/7-1_FinalProjectMilestones/Debug/Texture/Glass.png", "Frog");
+	bReturn = CreateGLTexture(
+		"C:/Users/katel/Downloads/CS330Content/CS330Content/Projects/7-1_FinalProjectMilestones/Debug/Texture/Keyboard.jpg", "Base");
+	bReturn = CreateGLTexture(
+		"C:/Users/katel/Downloads/CS330Content/CS330Content/Projects/7-1_FinalProjectMilestones/Debug/Texture/Body.jpg", "Body");
+	bReturn = CreateGLTexture(
+		"C:/Users/katel/Downloads/CS330Content/CS330Content/Projects/7-1_FinalProjectMilestones/Debug/Texture/Screen.png", "Screen");
+	bReturn = CreateGLTexture(
+		"C:/Users/katel/Downloads/CS330Content/CS330Content/Projects/7-1_FinalProjectMilestones/Debug/Texture/Wood.jpg", "Desk");
+	bReturn = CreateGLTexture(
+		"C:/Users/katel/Downloads/CS330Content/CS330Content/Projects/7-1_FinalProjectMilestones/Debug/Texture/Redbull.png", "Can");
+	bReturn = CreateGLTexture(
+		"C:/Users/katel/Downloads/CS330Content/CS330Content/Projects/7-1_FinalProjectMilestones/Debug/Texture/mouse.jpg", "Mouse");
+	bReturn = CreateGLTexture(
+		"C:/Users/katel/Downloads/CS330Content/CS330Content/Projects/7-1_FinalProjectMilestones/Debug/Texture/headphone.jpg", "Headphone");
+	bReturn = CreateGLTexture(
+		"C:/Users/katel/Downloads/CS330Content/CS330Content/Projects/7-1_FinalProjectMilestones/Debug/Texture/Cushion.jpg", "Cushion");
+	bReturn = CreateGLTexture(
+		"C:/Users/katel/Downloads/CS330Content/CS330Content/Projects/7-1_FinalProjectMilestones/Debug/Texture/Buttons.jpg", "Buttons");
+	bReturn = CreateGLTexture(
+		"C:/Users/katel/Downloads/CS330Content/CS330Content/Projects/7-1_FinalProjectMilestones/Debug/Texture/cantop.jpg", "Top");
+	bReturn = CreateGLTexture(
+		"C:/Users/katel/Downloads/CS330Content/CS330Content/Projects/7-1_FinalProjectMilestones/Debug/Texture/Wheel.jpg", "Wheel");
+
+	
+	// after the texture image data is loaded into memory, the
+	// loaded textures need to be bound to texture slots - there
+	// are a total of 16 available slots for scene textures
+	BindGLTextures();
+}
+/***********************************************************
+ *  LoadSceneMeshes()
+ *
+ *  This method is used for loading the model files of the
+ *  objects that are better drawn with a real mesh than with
+ *  the basic shapes.  Any file that is missing leaves the
+ *  basic shapes in its place.
+ ***********************************************************/
+void SceneManager::LoadSceneMeshes()
+{
+	m_pMeshImporter->SetCacheDirectory(g_MeshCacheDirectory);
+
+	LoadImportedMesh("Source/meshes/keyboard.glb", "Keyboard");
+	LoadImportedMesh("Source/meshes/mouse.obj", "Mouse");
+}
+/***********************************************************
+ *  SetupSceneLights()
+ *
+ *  This method is called to add and configure the light
+ *  sources for the 3D scene.  There are up to 4 light sources.
+ ***********************************************************/
+void SceneManager::SetupSceneLights()
+{
+	LIGHT_SOURCE lightSource;
+
+	// Enable custom lighting
+	m_bUseLighting = true;
+
+	// both lights reach the whole desk and fade out well beyond it
+	lightSource.type = LIGHT_SOURCE::LIGHT_POINT;
+	lightSource.direction = glm::vec3(0.0f, -1.0f, 0.0f);
+	lightSource.range = 100.0f;
+	lightSource.innerConeAngle = 0.0f;
+	lightSource.outerConeAngle = 0.0f;
+
+	// Sunlight from the right window
+	lightSource.position = glm::vec3(10.0f, 15.0f, -5.0f); // Positioned high and to the right
+	lightSource.ambientColor = glm::vec3(0.6f, 0.55f, 0.5f); // Slightly warm ambient light
+	lightSource.diffuseColor = glm::vec3(1.0f, 0.95f, 0.85f); // Warm and bright diffuse light
+	lightSource.specularColor = glm::vec3(1.0f, 1.0f, 0.9f);
+	lightSource.focalStrength = 64.0f;
+	lightSource.specularIntensity = 0.7f; // High specular intensity
+	m_lightSources.push_back(lightSource);
+
+	// Overhead light (Overhead light)
+	lightSource.position = glm::vec3(0.0f, 10.0f, 0.0f); // Positioned directly above
+	lightSource.ambientColor = glm::vec3(0.5f, 0.5f, 0.5f); // Neutral ambient light
+	lightSource.diffuseColor = glm::vec3(0.7f, 0.7f, 0.8f);
+	lightSource.specularColor = glm::vec3(0.6f, 0.6f, 0.7f);
+	lightSource.focalStrength = 32.0f;
+	lightSource.specularIntensity = 0.5f;
+	m_lightSources.push_back(lightSource);
+
+	// General ambient light for overall brightness
+	m_ambientLightColor = glm::vec3(0.5f, 0.5f, 0.55f); // Slightly cool ambient light
+	m_ambientLightIntensity = 1.0f; // Moderate intensity 
+
+	// pass the lights into the shader manager program, which
+	// is used when the shader variants are not available
+	SetFrameUniforms();
+}
+
+/***********************************************************
+ *  PrepareScene()
+ *
+ *  This method is used for preparing the 3D scene by loading
+ *  the shapes, textures in memory to support the 3D scene 
+ *  rendering
+ ***********************************************************/
+void SceneManager::PrepareScene()
+{
+	// only one instance of a particular mesh needs to be
+	// loaded in memory no matter how many times it is drawn
+	// in the rendered 3D scene
+
+	// a streamed scene loads its textures, model files, materials
+	// and objects with the cells around the camera.  otherwise the
+	// cooked scene file, when there is one, replaces the built in
+	// ones.  it is cooked first when its layout has been edited
+	bool bStreaming = (m_streamIndexPath.empty() == false) &&
+		(m_pSceneStreamer->Open(m_streamIndexPath.c_str()) == true);
+	std::string layoutPath = SceneFile::GetLayoutPath(m_sceneFilePath);
+	if ((bStreaming == false) && (layoutPath.empty() == false))
+	{
+		SceneFile::CookIfChanged(layoutPath.c_str(), m_sceneFilePath.c_str());
+	}
+	SceneFile sceneFile;
+	bool bSceneFile = (bStreaming == false) && (sceneFile.Open(m_sceneFilePath.c_str()) == true);
+	if (bSceneFile == true)
+	{
+		LoadSceneFileAssets(sceneFile);
+	}
+	else if (bStreaming == false)
+	{
+		// load the texture image files for the textures applied
+		// to objects in the 3D scene
+		LoadSceneTextures();
+		// load the model files that replace some of the basic shapes
+		LoadSceneMeshes();
+		// define the materials that will be used for the objects
+		// in the 3D scene
+		DefineObjectMaterials();
+	}
+	else
+	{
+		// the model files of the cells are converted once and then
+		// read back from the cache each time a cell comes back
+		m_pMeshImporter->SetCacheDirectory(g_MeshCacheDirectory);
+	}
+	// the variants read the lights from a light cluster grid
+	// when the driver has shader storage buffers
+	m_bUseClusteredLighting = m_pClusteredLighting->Initialize();
+	// add and defile the light sources for the 3D scene
+	SetupSceneLights();
+
+
+	m_basicMeshes->LoadPlaneMesh();
+	m_basicMeshes->LoadBoxMesh();
+	// the round shapes were tessellated by the compiler, so
+	// they only need their buffers filled
+	m_pPrimitiveMeshes->LoadMeshes();
+
+	// define the objects in the 3D scene and sort them into the
+	// order they are drawn
+	if (bSceneFile == true)
+	{
+		AddSceneFileObjects(sceneFile, -1);
+		sceneFile.Close();
+	}
+	else if (bStreaming == false)
+	{
+		DefineSceneObjects();
+	}
+	SortSceneObjects();
+
+	// draw with the specialized shader variants when their source
+	// is available, otherwise with the shader manager program
+	m_bUseShaderVariants = m_pShaderVariants->LoadSource(
+		g_VariantVertexShaderPath,
+		g_VariantFragmentShaderPath);
+
+	// the software rasterizer lights every object from the light
+	// sources, the same as the forward shaded variants
+	if ((m_bUseSoftwareRasterizer == true) && (m_bUseDeferredShading == true))
+	{
+		std::cout << "INFO: Deferred shading is not used with the software rasterizer" << std::endl;
+		m_bUseDeferredShading = false;
+	}
+
+	// light the static objects from the baked probes when they
+	// can be loaded or baked for the current objects and lights.
+	// the objects of a streamed scene come and go, so they are
+	// lit by the light sources
+	if ((m_bUseShaderVariants == true) && (m_bUseLighting == true) &&
+		(bStreaming == false) && (m_bUseSoftwareRasterizer == false) &&
+		(PrepareBakedLighting() == true))
+	{
+		m_bUseBakedLighting = true;
+		for (size_t i = 0; i < m_sceneObjects.size(); i++)
+		{
+			m_sceneObjects[i].variantKey = GetVariantKey(m_sceneObjects[i]);
+		}
+		SortSceneObjects();
+		if (m_bUseDeferredShading == true)
+		{
+			std::cout << "INFO: Deferred shading is not used with baked lighting" << std::endl;
+			m_bUseDeferredShading = false;
+		}
+	}
+
+	// the deferred path draws the G-buffer with the variants
+	if ((m_bUseDeferredShading == true) &&
+		((m_bUseShaderVariants == false) ||
+		(m_pDeferredRenderer->Initialize(g_DeferredLightingShaderPath) == false)))
+	{
+		m_bUseDeferredShading = false;
+	}
+	if (m_bUseDeferredShading == true)
+	{
+		UpdateDeferredMaterials();
+		std::cout << "INFO: Deferred shading enabled" << std::endl;
+	}
+
+	// the recorded runs are drawn with the forward shaded variants,
+	// from copies of the basic shapes made up front
+	if ((m_bUseRecordedDraws == true) && (m_bUseDeferredShading == true))
+	{
+		std::cout << "INFO: Recorded draws are not used with deferred shading" << std::endl;
+		m_bUseRecordedDraws = false;
+	}
+	if ((m_bUseRecordedDraws == true) &&
+		((m_bUseShaderVariants == false) || (m_bUseSoftwareRasterizer == true) ||
+		(m_pDrawRecorder->Initialize() == false)))
+	{
+		m_bUseRecordedDraws = false;
+	}
+	if (m_bUseRecordedDraws == true)
+	{
+		for (int mesh = 0; mesh < MESH_IMPORTED; mesh++)
+		{
+			SCENE_OBJECT object = m_pendingObject;
+			object.mesh = (MESH_TYPE)mesh;
+			std::vector<MeshImporter::MESH_VERTEX> vertices;
+			std::vector<unsigned int> indices;
+			if (ReadObjectMesh(object, vertices, indices) == true)
+			{
+				m_recordedMeshes[mesh] = m_pDrawRecorder->AddMesh(vertices, indices);
+			}
+		}
+		std::cout << "INFO: Recorded draws enabled, " << m_pDrawRecorder->GetThreadCount()
+			<< " recording threads" << std::endl;
+	}
+	SortSceneObjects();
+
+	// start building every variant the scene uses, loading the
+	// ones that were linked on an earlier run from disk
+	if (m_bUseShaderVariants == true)
+	{
+		m_pShaderVariants->EnableBinaryCache(g_ShaderCacheDirectory);
+		PrecompileSceneVariants();
+	}
+
+	// draw distant groups of static objects as impostors, which are
+	// baked with the variants.  the objects of a streamed scene
+	// come and go, so they are always drawn as they are
+	if ((m_bUseShaderVariants == true) && (bStreaming == false) &&
+		(m_bUseSoftwareRasterizer == false))
+	{
+		m_bUseImpostors = PrepareImpostors();
+	}
+
+	// reload the files the scene came from when they are edited
+	WatchSceneAssets();
+
+	// the newly prepared scene needs to be displayed
+	InvalidateScene();
+}
+
+/***********************************************************
+ *  UpdateDeferredMaterials()
+ *
+ *  This method is used for handing the lighting values of
+ *  the object materials to the deferred lighting pass.
+ ***********************************************************/
+void SceneManager::UpdateDeferredMaterials()
+{
+	std::vector<DeferredRenderer::DEFERRED_MATERIAL> materials(m_objectMaterials.size());
+	for (size_t i = 0; i < m_objectMaterials.size(); i++)
+	{
+		materials[i].ambientColor = m_objectMaterials[i].ambientColor;
+		materials[i].ambientStrength = m_objectMaterials[i].ambientStrength;
+		materials[i].diffuseColor = m_objectMaterials[i].diffuseColor;
+		materials[i].specularColor = m_objectMaterials[i].specularColor;
+		materials[i].shininess = m_objectMaterials[i].shininess;
+	}
+	m_pDeferredRenderer->SetMaterials(materials);
+}
+
+/***********************************************************
+ *  PrepareBakedLighting()
+ *
+ *  This method is used for handing the opaque scene objects
+ *  and the lights to the light baker, then either baking
+ *  the probes and saving them or loading the probes baked
+ *  on an earlier run.  Returns false when there is no baked
+ *  lighting for the current objects and lights.
+ ***********************************************************/
+bool SceneManager::PrepareBakedLighting()
+{
+	std::vector<LightBaker::BAKE_OBJECT> bakeObjects;
+	for (size_t i = 0; i < m_sceneObjects.size(); i++)
+	{
+		const SCENE_OBJECT& object = m_sceneObjects[i];
+
+		// light passes through the transparent objects
+		if (object.bTransparent == true)
+		{
+			continue;
+		}
+
+		LightBaker::BAKE_OBJECT bakeObject;
+		// the mesh types are listed in the same order as the shapes,
+		// and imported meshes are traced as their bounding box
+		bakeObject.shape = (LightBaker::BAKE_SHAPE)object.mesh;
+		bakeObject.model = object.model;
+		if (object.mesh == MESH_IMPORTED)
+		{
+			const MeshImporter::GPU_MESH& importedMesh = m_importedMeshes[object.importedMesh].mesh;
+			glm::vec3 center = (importedMesh.boundsMin + importedMesh.boundsMax) * 0.5f;
+			glm::vec3 size = glm::max(importedMesh.boundsMax - importedMesh.boundsMin, glm::vec3(1.0e-3f));
+			bakeObject.shape = LightBaker::SHAPE_BOX;
+			bakeObject.model = object.model * glm::translate(center) * glm::scale(size);
+		}
+		bakeObject.albedo = glm::vec3(object.color);
+		if ((object.bUseTexture == true) && (object.textureSlot >= 0))
+		{
+			bakeObject.albedo = m_textureIDs[object.textureSlot].averageColor;
+		}
+		if (object.materialIndex >= 0)
+		{
+			bakeObject.albedo *= m_objectMaterials[object.materialIndex].diffuseColor;
+		}
+		bakeObjects.push_back(bakeObject);
+	}
+	m_pLightBaker->SetScene(bakeObjects, m_lightSources);
+
+	if (m_bBakeLighting == true)
+	{
+		m_pLightBaker->Bake();
+		if (m_pLightBaker->Save(g_BakedLightingPath) == false)
+		{
+			std::cout << "ERROR::BAKED_LIGHTING_NOT_SAVED: " << g_BakedLightingPath << std::endl;
+		}
+	}
+	else if (m_pLightBaker->Load(g_BakedLightingPath) == false)
+	{
+		return(false);
+	}
+
+	if (m_pLightBaker->CreateTextures() == false)
+	{
+		return(false);
+	}
+	std::cout << "INFO: Baked lighting enabled" << std::endl;
+	return(true);
+}
+
+/***********************************************************
+ *  GetObjectBounds()
+ *
+ *  This method is used for getting the world space box
+ *  around a scene object, from the bounds of its basic
+ *  shape or imported mesh.
+ ***********************************************************/
+void SceneManager::GetObjectBounds(const SCENE_OBJECT& object, glm::vec3& boundsMin, glm::vec3& boundsMax) const
+{
+	glm::vec3 localMin;
+	glm::vec3 localMax;
+	if ((object.mesh == MESH_IMPORTED) &&
+		(object.importedMesh >= 0) && (object.importedMesh < (int)m_importedMeshes.size()))
+	{
+		localMin = m_importedMeshes[object.importedMesh].mesh.boundsMin;
+		localMax = m_importedMeshes[object.importedMesh].mesh.boundsMax;
+	}
+	else
+	{
+		GetShapeBounds(object.mesh, localMin, localMax);
+	}
+
+	for (int corner = 0; corner < 8; corner++)
+	{
+		glm::vec3 point(
+			((corner & 1) != 0) ? localMax.x : localMin.x,
+			((corner & 2) != 0) ? localMax.y : localMin.y,
+			((corner & 4) != 0) ? localMax.z : localMin.z);
+		point = glm::vec3(object.model * glm::vec4(point, 1.0f));
+		boundsMin = (corner == 0) ? point : glm::min(boundsMin, point);
+		boundsMax = (corner == 0) ? point : glm::max(boundsMax, point);
+	}
+}
+
+/***********************************************************
+ *  PrepareImpostors()
+ *
+ *  This method is used for grouping the static opaque
+ *  objects by the square of the floor they stand in, then
+ *  either baking the impostors of the groups and saving
+ *  them or loading the ones baked on an earlier run.  The
+ *  groups are keyed by everything that shows in the baked
+ *  frames, so an impostor never shows a stale object.
+ *  Returns false when there are no impostors to draw.
+ ***********************************************************/
+bool SceneManager::PrepareImpostors()
+{
+	// the objects small enough to share a group, by the square of
+	// the floor their center is in
+	std::map<std::pair<int, int>, std::vector<int>> squares;
+	for (size_t i = 0; i < m_sceneObjects.size(); i++)
+	{
+		SCENE_OBJECT& object = m_sceneObjects[i];
+		object.impostorGroup = -1;
+		if ((object.bTransparent == true) || (object.streamCell >= 0))
+		{
+			continue;
+		}
+
+		glm::vec3 boundsMin;
+		glm::vec3 boundsMax;
+		GetObjectBounds(object, boundsMin, boundsMax);
+		if (glm::length(boundsMax - boundsMin) > g_ImpostorGroupSize)
+		{
+			continue;
+		}
+		glm::vec3 center = (boundsMin + boundsMax) * 0.5f;
+		std::pair<int, int> square(
+			(int)std::floor(center.x / g_ImpostorGroupSize),
+			(int)std::floor(center.z / g_ImpostorGroupSize));
+		squares[square].push_back((int)i);
+	}
+
+	std::vector<ImpostorAtlas::IMPOSTOR_GROUP> groups;
+	std::vector<float> description;
+	int groupedObjects = 0;
+	std::map<std::pair<int, int>, std::vector<int>>::const_iterator it;
+	for (it = squares.begin(); it != squares.end(); ++it)
+	{
+		const std::vector<int>& members = it->second;
+		if ((int)members.size() < g_ImpostorMinObjects)
+		{
+			continue;
+		}
+
+		glm::vec3 groupMin;
+		glm::vec3 groupMax;
+		for (size_t i = 0; i < members.size(); i++)
+		{
+			SCENE_OBJECT& object = m_sceneObjects[members[i]];
+			object.impostorGroup = (int)groups.size();
+
+			glm::vec3 boundsMin;
+			glm::vec3 boundsMax;
+			GetObjectBounds(object, boundsMin, boundsMax);
+			groupMin = (i == 0) ? boundsMin : glm::min(groupMin, boundsMin);
+			groupMax = (i == 0) ? boundsMax : glm::max(groupMax, boundsMax);
+
+			// everything about the object that shows in the frames
+			const float* model = &object.model[0][0];
+			description.insert(description.end(), model, model + 16);
+			description.push_back((float)object.impostorGroup);
+			description.push_back((float)object.mesh);
+			description.push_back((float)object.importedMesh);
+			description.push_back((float)object.textureSlot);
+			description.push_back((object.bUseTexture == true) ? 1.0f : 0.0f);
+			description.push_back(object.color.r);
+			description.push_back(object.color.g);
+			description.push_back(object.color.b);
+			description.push_back(object.color.a);
+			description.push_back(object.UVscale.x);
+			description.push_back(object.UVscale.y);
+			description.push_back((float)object.materialIndex);
+			if (object.materialIndex >= 0)
+			{
+				const OBJECT_MATERIAL& material = m_objectMaterials[object.materialIndex];
+				description.push_back(material.ambientStrength);
+				description.push_back(material.shininess);
+				for (int c = 0; c < 3; c++)
+				{
+					description.push_back(material.ambientColor[c]);
+					description.push_back(material.diffuseColor[c]);
+					description.push_back(material.specularColor[c]);
+				}
+			}
+		}
+
+		ImpostorAtlas::IMPOSTOR_GROUP group;
+		group.center = (groupMin + groupMax) * 0.5f;
+		group.radius = std::max(glm::length(groupMax - groupMin) * 0.5f, 1.0e-3f);
+		groups.push_back(group);
+		groupedObjects += (int)members.size();
+	}
+	if (groups.empty() == true)
+	{
+		return(false);
+	}
+
+	// the frames are lit, so the lights are part of the key too
+	for (size_t i = 0; i < m_lightSources.size(); i++)
+	{
+		const LIGHT_SOURCE& light = m_lightSources[i];
+		description.push_back((float)light.type);
+		for (int c = 0; c < 3; c++)
+		{
+			description.push_back(light.position[c]);
+			description.push_back(light.direction[c]);
+			description.push_back(light.ambientColor[c]);
+			description.push_back(light.diffuseColor[c]);
+			description.push_back(light.specularColor[c]);
+		}
+		description.push_back(light.range);
+		description.push_back(light.innerConeAngle);
+		description.push_back(light.outerConeAngle);
+		description.push_back(light.focalStrength);
+		description.push_back(light.specularIntensity);
+	}
+	description.push_back(m_ambientLightColor.r * m_ambientLightIntensity);
+	description.push_back(m_ambientLightColor.g * m_ambientLightIntensity);
+	description.push_back(m_ambientLightColor.b * m_ambientLightIntensity);
+	description.push_back((m_bUseLighting == true) ? 1.0f : 0.0f);
+	description.push_back((m_bUseBakedLighting == true) ? 1.0f : 0.0f);
+
+	m_pImpostors->SetGroups(groups, description);
+	m_groupIsDistant.assign(groups.size(), 0);
+	if (m_pImpostors->Initialize(g_ImpostorVertexShaderPath, g_ImpostorFragmentShaderPath) == false)
+	{
+		return(false);
+	}
+
+	if (m_bBakeImpostors == true)
+	{
+		BakeImpostors();
+		if (m_pImpostors->Save(g_BakedImpostorsPath) == false)
+		{
+			std::cout << "ERROR::BAKED_IMPOSTORS_NOT_SAVED: " << g_BakedImpostorsPath << std::endl;
+		}
+	}
+	else if (m_pImpostors->Load(g_BakedImpostorsPath) == false)
+	{
+		return(false);
+	}
+
+	if (m_pImpostors->CreateTextures() == false)
+	{
+		return(false);
+	}
+	std::cout << "INFO: Impostors enabled for " << groups.size() << " groups of "
+		<< groupedObjects << " objects" << std::endl;
+	return(true);
+}
+
+/***********************************************************
+ *  BakeImpostors()
+ *
+ *  This method is used for rendering each impostor group
+ *  from every frame direction into the atlas, with the same
+ *  shader variants that draw the objects.  The frames are
+ *  lit with the light uniforms, since the cluster grid is
+ *  built for the perspective view of the camera.
+ ***********************************************************/
+void SceneManager::BakeImpostors()
+{
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+	bool bClusteredLighting = m_bUseClusteredLighting;
+	m_bUseClusteredLighting = false;
+
+	std::vector<std::vector<int>> groupObjects(m_pImpostors->GetGroupCount());
+	std::vector<unsigned int> variantKeys;
+	for (size_t i = 0; i < m_sceneObjects.size(); i++)
+	{
+		const SCENE_OBJECT& object = m_sceneObjects[i];
+		if (object.impostorGroup < 0)
+		{
+			continue;
+		}
+		groupObjects[object.impostorGroup].push_back((int)i);
+		unsigned int key = GetVariantKey(object);
+		if (std::find(variantKeys.begin(), variantKeys.end(), key) == variantKeys.end())
+		{
+			variantKeys.push_back(key);
+		}
+	}
+	// every frame must be drawn with its variant, not the shader
+	// manager program used while a variant is compiling
+	m_pShaderVariants->PrecompileVariants(variantKeys);
+	m_pShaderVariants->FinishVariants();
+
+	glm::mat4 viewMatrix = m_viewMatrix;
+	glm::mat4 projectionMatrix = m_projectionMatrix;
+	glm::vec3 viewPosition = m_viewPosition;
+	int viewportHeight = m_viewportHeight;
+
+	if (m_pImpostors->BeginBake() == true)
+	{
+		glEnable(GL_DEPTH_TEST);
+		for (int group = 0; group < (int)groupObjects.size(); group++)
+		{
+			for (int frame = 0; frame < ImpostorAtlas::FRAME_GRID * ImpostorAtlas::FRAME_GRID; frame++)
+			{
+				m_pImpostors->BeginFrame(group, frame);
+
+				glm::mat4 frameView;
+				glm::mat4 frameProjection;
+				glm::vec3 framePosition;
+				m_pImpostors->GetFrameView(group, frame, frameView, frameProjection, framePosition);
+				SetViewTransform(frameView, frameProjection, framePosition);
+				m_viewportHeight = ImpostorAtlas::FRAME_SIZE;
+
+				// the first variant bound in each frame is given the
+				// frame's view
+				m_pShaderVariants->UseBaseProgram();
+				for (size_t i = 0; i < groupObjects[group].size(); i++)
+				{
+					const SCENE_OBJECT& object = m_sceneObjects[groupObjects[group][i]];
+					if (m_pShaderVariants->UseVariant(GetVariantKey(object)) == true)
+					{
+						SetFrameUniforms();
+					}
+					SetObjectUniforms(object);
+					DrawObjectMesh(object);
+				}
+			}
+		}
+		m_pShaderVariants->UseBaseProgram();
+		m_pImpostors->EndBake();
+	}
+
+	SetViewTransform(viewMatrix, projectionMatrix, viewPosition);
+	m_viewportHeight = viewportHeight;
+	m_bUseClusteredLighting = bClusteredLighting;
+
+	double elapsed = std::chrono::duration<double, std::milli>(
+		std::chrono::steady_clock::now() - start).count();
+	std::cout << "INFO: Baked impostors: " << groupObjects.size() << " groups of "
+		<< ImpostorAtlas::FRAME_GRID * ImpostorAtlas::FRAME_GRID << " frames in "
+		<< elapsed << " ms" << std::endl;
+}
+
+/***********************************************************
+ *  FindDistantGroups()
+ *
+ *  This method is used for choosing the impostor groups that
+ *  are small enough on the screen to be drawn as quads in
+ *  the frame being rendered.
+ ***********************************************************/
+void SceneManager::FindDistantGroups()
+{
+	m_distantGroups.clear();
+	if (m_bUseImpostors == false)
+	{
+		return;
+	}
+
+	for (int group = 0; group < m_pImpostors->GetGroupCount(); group++)
+	{
+		bool bDistant = m_pImpostors->IsDistant(group, m_viewPosition, m_projectionMatrix, m_viewportHeight);
+		m_groupIsDistant[group] = (bDistant == true) ? 1 : 0;
+		if (bDistant == true)
+		{
+			m_distantGroups.push_back(group);
+		}
+	}
+}
+
+/***********************************************************
+ *  IsDrawnAsImpostor()
+ *
+ *  This method is used for checking whether an object is
+ *  left out of the frame because its group is drawn as an
+ *  impostor.
+ ***********************************************************/
+bool SceneManager::IsDrawnAsImpostor(const SCENE_OBJECT& object) const
+{
+	return((m_bUseImpostors == true) &&
+		(object.impostorGroup >= 0) &&
+		(m_groupIsDistant[object.impostorGroup] != 0));
+}
+
+/***********************************************************
+ *  SetDeferredShading()
+ *
+ *  This method is used for choosing whether the opaque
+ *  objects are lit by the deferred lighting pass.  It must
+ *  be called before PrepareScene(), which falls back to
+ *  forward shading when the driver cannot run the pass.
+ ***********************************************************/
+void SceneManager::SetDeferredShading(bool bEnable)
+{
+	m_bUseDeferredShading = bEnable;
+}
+
+/***********************************************************
+ *  SetBakeLighting()
+ *
+ *  This method is used for choosing whether the lighting of
+ *  the static objects is baked while the scene is prepared
+ *  and written to the cooked file.  Otherwise the cooked
+ *  file is loaded when it matches the scene.  It must be
+ *  called before PrepareScene().
+ ***********************************************************/
+void SceneManager::SetBakeLighting(bool bEnable)
+{
+	m_bBakeLighting = bEnable;
+}
+
+/***********************************************************
+ *  SetBakeImpostors()
+ *
+ *  This method is used for choosing whether the impostors of
+ *  the distant object groups are baked while the scene is
+ *  prepared and written to the cooked file.  Otherwise the
+ *  cooked file is loaded when it matches the groups.  It
+ *  must be called before PrepareScene().
+ ***********************************************************/
+void SceneManager::SetBakeImpostors(bool bEnable)
+{
+	m_bBakeImpostors = bEnable;
+}
+
+/***********************************************************
+ *  SetSceneFile()
+ *
+ *  This method is used for choosing the cooked scene file
+ *  that is loaded instead of the built in scene.  When the
+ *  file cannot be loaded the built in scene is used.  It
+ *  must be called before PrepareScene().
+ ***********************************************************/
+void SceneManager::SetSceneFile(const char* filePath)
+{
+	m_sceneFilePath = filePath;
+}
+
+/***********************************************************
+ *  SetSoftwareRendering()
+ *
+ *  This method is used for choosing whether the scene is
+ *  drawn by the software rasterizer instead of OpenGL, for
+ *  hosts without graphics hardware.  The objects are lit by
+ *  the light sources, so the baked lighting, the impostors
+ *  and the deferred pass are left out.  It must be turned
+ *  on before PrepareScene(), and can be turned off at any
+ *  time to draw the same scene with OpenGL.
+ ***********************************************************/
+void SceneManager::SetSoftwareRendering(bool bEnable)
+{
+	m_bUseSoftwareRasterizer = bEnable;
+}
+
+/***********************************************************
+ *  SetRecordedDraws()
+ *
+ *  This method is used for choosing whether the opaque basic
+ *  shapes are drawn from draw lists recorded on worker
+ *  threads, instead of one at a time.  It must be turned on
+ *  before PrepareScene(), which leaves it off when the
+ *  shader variants are missing or the deferred pass is
+ *  used, and can be turned off at any time.
+ ***********************************************************/
+void SceneManager::SetRecordedDraws(bool bEnable)
+{
+	m_bUseRecordedDraws = bEnable;
+	if (bEnable == false)
+	{
+		m_recordedDrawOrder.clear();
+	}
+}
+
+/***********************************************************
+ *  WatchSceneAssets()
+ *
+ *  This method is used for starting to watch the texture
+ *  images, the shader variant source and the cooked scene
+ *  file with its layout, so they are reloaded when they are
+ *  saved.
+ ***********************************************************/
+void SceneManager::WatchSceneAssets()
+{
+	for (int i = 0; i < m_loadedTextures; i++)
+	{
+		m_pAssetWatcher->WatchFile(m_textureIDs[i].filename);
+	}
+	if (m_bUseShaderVariants == true)
+	{
+		m_pAssetWatcher->WatchFile(g_VariantVertexShaderPath);
+		m_pAssetWatcher->WatchFile(g_VariantFragmentShaderPath);
+	}
+	// the scene file is watched even when it did not load, so the
+	// scene appears once it has been cooked, unless the scene is
+	// streamed instead.  its layout is watched to cook it again
+	if (m_pSceneStreamer->IsOpen() == false)
+	{
+		m_pAssetWatcher->WatchFile(m_sceneFilePath);
+		std::string layoutPath = SceneFile::GetLayoutPath(m_sceneFilePath);
+		if (layoutPath.empty() == false)
+		{
+			m_pAssetWatcher->WatchFile(layoutPath);
+		}
+	}
+	m_pAssetWatcher->Start();
+}
+
+/***********************************************************
+ *  ReadChangedAsset()
+ *
+ *  This method is run on a worker thread to read a changed
+ *  file into memory, decoding images, reading shader source,
+ *  mapping and checking scene files and cooking edited scene
+ *  layouts, so the render loop only has to hand the results
+ *  to OpenGL.
+ ***********************************************************/
+SceneManager::RELOADED_ASSET SceneManager::ReadChangedAsset(ASSET_TYPE type, std::string filePath)
+{
+	RELOADED_ASSET asset;
+	asset.type = type;
+	asset.filePath = filePath;
+	asset.bLoaded = false;
+
+	switch (type)
+	{
+	case ASSET_TEXTURE:
+		asset.bLoaded = DecodeTextureImage(filePath.c_str(), asset.image);
+		break;
+	case ASSET_SHADER:
+		// the variants are built from both stages, so both are
+		// read whichever one changed
+		asset.bLoaded = ShaderVariantCache::ReadSource(
+			g_VariantVertexShaderPath,
+			g_VariantFragmentShaderPath,
+			asset.vertexSource,
+			asset.fragmentSource);
+		break;
+	case ASSET_SCENE:
+		asset.pSceneFile.reset(new SceneFile());
+		asset.bLoaded = asset.pSceneFile->Open(filePath.c_str());
+		break;
+	case ASSET_LAYOUT:
+		// the passed in path is the cooked file, written here from
+		// the layout beside it
+		asset.bLoaded = SceneFile::Cook(SceneFile::GetLayoutPath(filePath).c_str(), filePath.c_str());
+		break;
+	}
+	return(asset);
+}
+
+/***********************************************************
+ *  ApplyAssetReloads()
+ *
+ *  This method is used for reloading the watched files that
+ *  have changed.  Each changed file is read on a worker
+ *  thread, and once it has been read the textures, shader
+ *  variants or scene records made from it are replaced at
+ *  the start of the next frame.  Only what was made from the
+ *  changed file is replaced, and a file that fails to read
+ *  leaves the old version in place.
+ ***********************************************************/
+void SceneManager::ApplyAssetReloads()
+{
+	if (m_pAssetWatcher->HasChanges() == true)
+	{
+		std::vector<std::string> changedFiles;
+		m_pAssetWatcher->TakeChangedFiles(changedFiles);
+
+		bool bShaderChanged = false;
+		for (size_t i = 0; i < changedFiles.size(); i++)
+		{
+			const std::string& filePath = changedFiles[i];
+			if ((filePath == g_VariantVertexShaderPath) || (filePath == g_VariantFragmentShaderPath))
+			{
+				// saving both stages only rebuilds the variants once
+				if (bShaderChanged == false)
+				{
+					bShaderChanged = true;
+					m_assetReloads.push_back(std::async(std::launch::async,
+						&SceneManager::ReadChangedAsset, ASSET_SHADER, filePath));
+				}
+			}
+			else if (filePath == m_sceneFilePath)
+			{
+				m_assetReloads.push_back(std::async(std::launch::async,
+					&SceneManager::ReadChangedAsset, ASSET_SCENE, filePath));
+			}
+			else if (filePath == SceneFile::GetLayoutPath(m_sceneFilePath))
+			{
+				m_assetReloads.push_back(std::async(std::launch::async,
+					&SceneManager::ReadChangedAsset, ASSET_LAYOUT, m_sceneFilePath));
+			}
+			else
+			{
+				m_assetReloads.push_back(std::async(std::launch::async,
+					&SceneManager::ReadChangedAsset, ASSET_TEXTURE, filePath));
+			}
+			std::cout << "INFO: Reloading changed file " << filePath << std::endl;
+		}
+	}
+
+	// replace what has finished reading, in the order the files
+	// changed, and leave the rest for a later frame.  a changed
+	// scene file holds back the files that changed after it until
+	// what it adds has been read
+	size_t pending = 0;
+	bool bReadyInOrder = (!m_pReloadedSceneFile) || (FinishSceneReload() == true);
+	for (size_t i = 0; i < m_assetReloads.size(); i++)
+	{
+		if ((bReadyInOrder == false) ||
+			(m_assetReloads[i].wait_for(std::chrono::seconds(0)) != std::future_status::ready))
+		{
+			bReadyInOrder = false;
+			m_assetReloads[pending++] = std::move(m_assetReloads[i]);
+			continue;
+		}
+
+		RELOADED_ASSET asset = m_assetReloads[i].get();
+		if (asset.bLoaded == false)
+		{
+			std::cout << "ERROR::ASSET_RELOAD_FAILED: " << asset.filePath << std::endl;
+			continue;
+		}
+		switch (asset.type)
+		{
+		case ASSET_TEXTURE:
+			ReloadTexture(asset);
+			break;
+		case ASSET_SHADER:
+			m_pShaderVariants->ReloadSource(asset.vertexSource, asset.fragmentSource);
+			break;
+		case ASSET_SCENE:
+			BeginSceneReload(std::move(asset.pSceneFile));
+			bReadyInOrder = FinishSceneReload();
+			break;
+		case ASSET_LAYOUT:
+			// writing the cooked file reloads it once it is seen
+			break;
+		}
+		InvalidateScene();
+	}
+	m_assetReloads.resize(pending);
+
+	// the rebuilt shader variants replace the old ones together
+	// once the driver has finished all of them
+	if ((m_bUseShaderVariants == true) && (m_pShaderVariants->UpdateReload() == true))
+	{
+		InvalidateScene();
+	}
+}
+
+/***********************************************************
+ *  ReloadTexture()
+ *
+ *  This method is used for replacing the image of every
+ *  texture loaded from a changed file.  The OpenGL texture
+ *  keeps its name and slot, so the objects drawn with it
+ *  are unchanged, apart from moving between the opaque and
+ *  transparent objects when the image gains or loses its
+ *  transparent pixels.
+ ***********************************************************/
+void SceneManager::ReloadTexture(const RELOADED_ASSET& asset)
+{
+	bool bTransparencyChanged = false;
+	for (int i = 0; i < m_loadedTextures; i++)
+	{
+		TEXTURE_INFO& texture = m_textureIDs[i];
+		if ((texture.filename != asset.filePath) ||
+			(UploadTextureImage(texture.ID, asset.image) == false))
+		{
+			continue;
+		}
+		bTransparencyChanged = bTransparencyChanged || (texture.bTransparent != asset.image.bTransparent);
+		texture.bTransparent = asset.image.bTransparent;
+		texture.averageColor = asset.image.averageColor;
+
+		// the software copy is read back again when next drawn
+		m_pSoftwareRasterizer->RemoveTexture(m_softwareTextures[i]);
+		m_softwareTextures[i] = -1;
+	}
+	// uploading used the active slot, so the slots are bound again
+	BindGLTextures();
+
+	if (bTransparencyChanged == true)
+	{
+		for (size_t i = 0; i < m_sceneObjects.size(); i++)
+		{
+			FinishSceneObject(m_sceneObjects[i]);
+		}
+		SortSceneObjects();
+		if (m_bUseShaderVariants == true)
+		{
+			PrecompileSceneVariants();
+		}
+	}
+}
+
+/***********************************************************
+ *  BeginSceneReload()
+ *
+ *  This method is used for starting to read, on worker
+ *  threads, the textures of a changed scene file whose tags
+ *  are new or now name a different image, and the model
+ *  files whose tags are new.  Textures and model files that
+ *  are already loaded are kept.
+ ***********************************************************/
+void SceneManager::BeginSceneReload(std::unique_ptr<SceneFile> pSceneFile)
+{
+	const SceneFile& sceneFile = *pSceneFile;
+	const SceneFile::FILE_HEADER& header = sceneFile.GetHeader();
+
+	const SceneFile::ASSET_RECORD* textures = sceneFile.GetTextures();
+	for (unsigned int i = 0; i < header.textureCount; i++)
+	{
+		std::string tag = sceneFile.GetString(textures[i].tagOffset);
+		std::string filePath = sceneFile.GetString(textures[i].pathOffset);
+		int textureSlot = FindTextureSlot(tag);
+		if ((textureSlot < 0) || (m_textureIDs[textureSlot].filename != filePath))
+		{
+			m_sceneTextureReads.push_back(std::async(std::launch::async,
+				&SceneManager::ReadChangedAsset, ASSET_TEXTURE, filePath));
+			m_sceneTextureTags.push_back(tag);
+		}
+	}
+
+	// the scene may have had no scene file to load at startup
+	m_pMeshImporter->SetCacheDirectory(g_MeshCacheDirectory);
+	const SceneFile::ASSET_RECORD* meshes = sceneFile.GetMeshes();
+	for (unsigned int i = 0; i < header.meshCount; i++)
+	{
+		std::string tag = sceneFile.GetString(meshes[i].tagOffset);
+		if (FindImportedMesh(tag) < 0)
+		{
+			m_sceneMeshReads.push_back(std::async(std::launch::async, &SceneManager::ReadStreamedMesh,
+				m_pMeshImporter, std::string(sceneFile.GetString(meshes[i].pathOffset))));
+			m_sceneMeshTags.push_back(tag);
+		}
+	}
+	m_pReloadedSceneFile = std::move(pSceneFile);
+}
+
+/***********************************************************
+ *  FinishSceneReload()
+ *
+ *  This method is used for loading what a changed scene
+ *  file added, once all of it has been read, and replacing
+ *  the scene with it.  A texture whose tag now names a
+ *  different image is replaced in its slot, and the images
+ *  of the scene are watched from then on.  Returns false
+ *  while anything is still being read.
+ ***********************************************************/
+bool SceneManager::FinishSceneReload()
+{
+	for (size_t i = 0; i < m_sceneTextureReads.size(); i++)
+	{
+		if (m_sceneTextureReads[i].wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+		{
+			return(false);
+		}
+	}
+	for (size_t i = 0; i < m_sceneMeshReads.size(); i++)
+	{
+		if (m_sceneMeshReads[i].wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+		{
+			return(false);
+		}
+	}
+
+	for (size_t i = 0; i < m_sceneTextureReads.size(); i++)
+	{
+		RELOADED_ASSET asset = m_sceneTextureReads[i].get();
+		if (asset.bLoaded == false)
+		{
+			std::cout << "ERROR::ASSET_RELOAD_FAILED: " << asset.filePath << std::endl;
+			continue;
+		}
+		int textureSlot = FindTextureSlot(m_sceneTextureTags[i]);
+		if (textureSlot < 0)
+		{
+			AddGLTexture(asset.filePath.c_str(), m_sceneTextureTags[i], asset.image);
+		}
+		else if (UploadTextureImage(m_textureIDs[textureSlot].ID, asset.image) == true)
+		{
+			TEXTURE_INFO& texture = m_textureIDs[textureSlot];
+			texture.filename = asset.filePath;
+			texture.bTransparent = asset.image.bTransparent;
+			texture.averageColor = asset.image.averageColor;
+
+			// the software copy is read back again when next drawn
+			m_pSoftwareRasterizer->RemoveTexture(m_softwareTextures[textureSlot]);
+			m_softwareTextures[textureSlot] = -1;
+		}
+		m_pAssetWatcher->WatchFile(asset.filePath);
+	}
+	BindGLTextures();
+
+	for (size_t i = 0; i < m_sceneMeshReads.size(); i++)
+	{
+		STREAMED_MESH streamedMesh = m_sceneMeshReads[i].get();
+		if (streamedMesh.bLoaded == false)
+		{
+			std::cout << "INFO: Could not load model " << streamedMesh.filePath
+				<< ", drawing the basic shapes instead" << std::endl;
+			continue;
+		}
+		MeshImporter::GPU_MESH mesh;
+		MeshImporter::UploadMeshData(streamedMesh.mesh, mesh);
+		AddImportedMesh(mesh, m_sceneMeshTags[i]);
+	}
+
+	m_sceneTextureReads.clear();
+	m_sceneTextureTags.clear();
+	m_sceneMeshReads.clear();
+	m_sceneMeshTags.clear();
+
+	ReloadSceneFile(*m_pReloadedSceneFile);
+	m_pReloadedSceneFile.reset();
+	InvalidateScene();
+	return(true);
+}
+
+/***********************************************************
+ *  ReloadSceneFile()
+ *
+ *  This method is used for replacing the materials and the
+ *  objects with those of a changed scene file, once the
+ *  textures and model files it adds have been loaded.  The
+ *  lights and the baked lighting are left as they are,
+ *  since the scene file holds neither.
+ ***********************************************************/
+void SceneManager::ReloadSceneFile(const SceneFile& sceneFile)
+{
+	LoadSceneFileMaterials(sceneFile);
+	m_sceneObjects.clear();
+	AddSceneFileObjects(sceneFile, -1);
+	SortSceneObjects();
+
+	// the impostors show the objects as they were, so the groups
+	// are drawn as they are until the impostors are baked again
+	if (m_bUseImpostors == true)
+	{
+		std::cout << "INFO: Impostors are out of date and are not used" << std::endl;
+		m_bUseImpostors = false;
+		m_distantGroups.clear();
+	}
+
+	if (m_bUseDeferredShading == true)
+	{
+		UpdateDeferredMaterials();
+	}
+	if (m_bUseShaderVariants == true)
+	{
+		PrecompileSceneVariants();
+	}
+}
+
+/***********************************************************
+ *  SetStreamingIndex()
+ *
+ *  This method is used for choosing a cooked cell index to
+ *  stream instead of loading a whole scene.  Only the cells
+ *  around the camera are loaded, so scenes far larger than
+ *  memory can be flown through.  It must be called before
+ *  PrepareScene().
+ ***********************************************************/
+void SceneManager::SetStreamingIndex(const char* indexPath)
+{
+	m_streamIndexPath = indexPath;
+}
+
+/***********************************************************
+ *  UpdateStreaming()
+ *
+ *  This method is used for keeping the cells around the
+ *  camera loaded.  The camera velocity is measured from its
+ *  movement between frames, so the streamer can read the
+ *  cells ahead of it.  Evicted cells are unloaded straight
+ *  away, and the cells that have been read are loaded a
+ *  piece at a time, with no more than the upload budget of
+ *  textures and meshes given to OpenGL each frame, so the
+ *  frame time stays even while new cells arrive.
+ ***********************************************************/
+void SceneManager::UpdateStreaming()
+{
+	if (m_pSceneStreamer->IsOpen() == false)
+	{
+		return;
+	}
+
+	double now = glfwGetTime();
+	double elapsed = now - m_streamTime;
+	if ((m_streamTime > 0.0) && (elapsed > 0.0))
+	{
+		glm::vec3 velocity = (m_viewPosition - m_streamViewPosition) / (float)elapsed;
+		m_streamVelocity += (velocity - m_streamVelocity) * g_StreamVelocitySmoothing;
+	}
+	m_streamViewPosition = m_viewPosition;
+	m_streamTime = now;
+	m_pSceneStreamer->Update(m_viewPosition, m_streamVelocity);
+
+	bool bChanged = false;
+	std::vector<int> evictedCells;
+	m_pSceneStreamer->TakeEvictedCells(evictedCells);
+	if (evictedCells.empty() == false)
+	{
+		UnloadCells(evictedCells);
+		bChanged = true;
+	}
+
+	int cell = -1;
+	std::unique_ptr<SceneFile> pSceneFile;
+	while (m_pSceneStreamer->TakeReadCell(cell, pSceneFile) == true)
+	{
+		BeginCellLoad(cell, std::move(pSceneFile));
+	}
+
+	// load the cells in the order they arrived until the budget
+	// of this frame is used up
+	long long uploadBudget = g_StreamUploadBudget;
+	size_t pending = 0;
+	for (size_t i = 0; i < m_cellLoads.size(); i++)
+	{
+		if ((uploadBudget > 0) && (ContinueCellLoad(m_cellLoads[i], uploadBudget) == true))
+		{
+			m_pSceneStreamer->SetCellLoaded(m_cellLoads[i].cell);
+			bChanged = true;
+			continue;
+		}
+		if (pending != i)
+		{
+			m_cellLoads[pending] = std::move(m_cellLoads[i]);
+		}
+		pending++;
+	}
+	m_cellLoads.resize(pending);
+	DropUnusedReads();
+
+	if (bChanged == true)
+	{
+		SortSceneObjects();
+		if (m_bUseShaderVariants == true)
+		{
+			PrecompileSceneVariants();
+		}
+		InvalidateScene();
+	}
+}
+
+/***********************************************************
+ *  BeginCellLoad()
+ *
+ *  This method is used for starting to load a cell whose
+ *  file has been read.  The images of the textures that are
+ *  not loaded or being decoded yet start decoding on worker
+ *  threads, while there are texture slots left for them,
+ *  and the model files that are not loaded or being read
+ *  yet start being read on worker threads.
+ ***********************************************************/
+void SceneManager::BeginCellLoad(int cell, std::unique_ptr<SceneFile> pSceneFile)
+{
+	CELL_LOAD load;
+	load.cell = cell;
+	load.pSceneFile = std::move(pSceneFile);
+	load.nextTexture = 0;
+	load.nextMesh = 0;
+
+	if (load.pSceneFile)
+	{
+		const SceneFile& sceneFile = *load.pSceneFile;
+		const SceneFile::ASSET_RECORD* textures = sceneFile.GetTextures();
+		for (unsigned int i = 0; i < sceneFile.GetHeader().textureCount; i++)
+		{
+			std::string tag = sceneFile.GetString(textures[i].tagOffset);
+			if ((GetFreeTextureSlot() >= 0) && (FindTextureSlot(tag) < 0) &&
+				(m_textureReads.find(tag) == m_textureReads.end()))
+			{
+				m_textureReads[tag] = std::async(std::launch::async, &SceneManager::ReadChangedAsset,
+					ASSET_TEXTURE, std::string(sceneFile.GetString(textures[i].pathOffset))).share();
+			}
+		}
+
+		const SceneFile::ASSET_RECORD* meshes = sceneFile.GetMeshes();
+		for (unsigned int i = 0; i < sceneFile.GetHeader().meshCount; i++)
+		{
+			std::string tag = sceneFile.GetString(meshes[i].tagOffset);
+			if ((FindImportedMesh(tag) < 0) && (m_meshReads.find(tag) == m_meshReads.end()))
+			{
+				m_meshReads[tag] = std::async(std::launch::async, &SceneManager::ReadStreamedMesh,
+					m_pMeshImporter, std::string(sceneFile.GetString(meshes[i].pathOffset))).share();
+			}
+		}
+	}
+	m_cellLoads.push_back(std::move(load));
+}
+
+/***********************************************************
+ *  ContinueCellLoad()
+ *
+ *  This method is used for loading the next pieces of a
+ *  cell: its decoded textures, then its model files, then
+ *  its materials and objects.  Each texture and mesh given
+ *  to OpenGL is taken off the upload budget, and the cell
+ *  stops for the frame once the budget is used up or a
+ *  texture or model file is still being read.  A mesh that
+ *  does not fit in what is left of the budget waits for the
+ *  next frame, unless nothing else was uploaded this frame.
+ *  Textures and model files that other cells already loaded
+ *  are shared by tag.
+ ***********************************************************/
+bool SceneManager::ContinueCellLoad(CELL_LOAD& load, long long& uploadBudget)
+{
+	if (!load.pSceneFile)
+	{
+		return(true);
+	}
+	const SceneFile& sceneFile = *load.pSceneFile;
+	const SceneFile::FILE_HEADER& header = sceneFile.GetHeader();
+
+	while (load.nextTexture < header.textureCount)
+	{
+		const SceneFile::ASSET_RECORD& record = sceneFile.GetTextures()[load.nextTexture];
+		std::string tag = sceneFile.GetString(record.tagOffset);
+		if (FindTextureSlot(tag) < 0)
+		{
+			std::map<std::string, std::shared_future<RELOADED_ASSET>>::iterator read = m_textureReads.find(tag);
+			if (read == m_textureReads.end())
+			{
+				// the texture was loaded when the cell arrived and has
+				// been freed since, or there was no slot left for it
+				if (GetFreeTextureSlot() < 0)
+				{
+					std::cout << "INFO: No free texture slot for " << tag << " ("
+						<< sceneFile.GetString(record.pathOffset) << "), cell "
+						<< load.cell << " is drawn without it" << std::endl;
+				}
+				else
+				{
+					m_textureReads[tag] = std::async(std::launch::async, &SceneManager::ReadChangedAsset,
+						ASSET_TEXTURE, std::string(sceneFile.GetString(record.pathOffset))).share();
+					return(false);
+				}
+			}
+			else
+			{
+				if (read->second.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+				{
+					return(false);
+				}
+				const RELOADED_ASSET& asset = read->second.get();
+				if ((asset.bLoaded == true) && (GetFreeTextureSlot() < 0))
+				{
+					// the slots filled up while the image was decoded
+					std::cout << "INFO: No free texture slot for " << tag << " ("
+						<< asset.filePath << "), cell " << load.cell
+						<< " is drawn without it" << std::endl;
+				}
+				else if ((asset.bLoaded == true) &&
+					(AddGLTexture(asset.filePath.c_str(), tag, asset.image) == true))
+				{
+					m_textureIDs[FindTextureSlot(tag)].bStreamed = true;
+					BindGLTextures();
+					uploadBudget -= (long long)asset.image.pixels.size();
+				}
+				m_textureReads.erase(read);
+			}
+		}
+		int textureSlot = FindTextureSlot(tag);
+		if (textureSlot >= 0)
+		{
+			m_textureIDs[textureSlot].cellReferences++;
+			load.textureSlots.push_back(textureSlot);
+		}
+		load.nextTexture++;
+		if (uploadBudget <= 0)
+		{
+			return(false);
+		}
+	}
+
+	while (load.nextMesh < header.meshCount)
+	{
+		const SceneFile::ASSET_RECORD& record = sceneFile.GetMeshes()[load.nextMesh];
+		std::string tag = sceneFile.GetString(record.tagOffset);
+		int meshIndex = FindImportedMesh(tag);
+		if (meshIndex < 0)
+		{
+			std::map<std::string, std::shared_future<STREAMED_MESH>>::iterator read = m_meshReads.find(tag);
+			if (read == m_meshReads.end())
+			{
+				// the mesh was loaded when the cell arrived and has
+				// been freed since
+				m_meshReads[tag] = std::async(std::launch::async, &SceneManager::ReadStreamedMesh,
+					m_pMeshImporter, std::string(sceneFile.GetString(record.pathOffset))).share();
+				return(false);
+			}
+			if (read->second.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+			{
+				return(false);
+			}
+
+			const STREAMED_MESH& streamedMesh = read->second.get();
+			if (streamedMesh.bLoaded == true)
+			{
+				long long meshBytes = (long long)(streamedMesh.mesh.vertices.size() * sizeof(MeshImporter::MESH_VERTEX) +
+					streamedMesh.mesh.indices.size() * sizeof(unsigned int));
+				if ((meshBytes > uploadBudget) && (uploadBudget < g_StreamUploadBudget))
+				{
+					return(false);
+				}
+				MeshImporter::GPU_MESH mesh;
+				MeshImporter::UploadMeshData(streamedMesh.mesh, mesh);
+				meshIndex = AddImportedMesh(mesh, tag);
+				m_importedMeshes[meshIndex].bStreamed = true;
+				uploadBudget -= meshBytes;
+			}
+			else
+			{
+				std::cout << "INFO: Could not load model " << streamedMesh.filePath
+					<< ", drawing the basic shapes instead" << std::endl;
+			}
+			m_meshReads.erase(read);
+		}
+		if (meshIndex >= 0)
+		{
+			m_importedMeshes[meshIndex].cellReferences++;
+			load.meshIndices.push_back(meshIndex);
+		}
+		load.nextMesh++;
+		if (uploadBudget <= 0)
+		{
+			return(false);
+		}
+	}
+
+	MergeSceneFileMaterials(sceneFile);
+	AddSceneFileObjects(sceneFile, load.cell);
+	m_cellTextures[load.cell] = load.textureSlots;
+	m_cellMeshes[load.cell] = load.meshIndices;
+	return(true);
+}
+
+/***********************************************************
+ *  UnloadCells()
+ *
+ *  This method is used for removing the objects of cells
+ *  that the camera has left behind, in one pass over the
+ *  scene objects, and releasing the textures and meshes
+ *  they held.  Cells that were still loading are dropped.
+ *  Materials stay defined, since there are few of them.
+ ***********************************************************/
+void SceneManager::UnloadCells(const std::vector<int>& cells)
+{
+	for (size_t i = 0; i < cells.size(); i++)
+	{
+		std::map<int, std::vector<int>>::iterator loadedTextures = m_cellTextures.find(cells[i]);
+		if (loadedTextures != m_cellTextures.end())
+		{
+			for (size_t j = 0; j < loadedTextures->second.size(); j++)
+			{
+				ReleaseCellTexture(loadedTextures->second[j]);
+			}
+			m_cellTextures.erase(loadedTextures);
+		}
+		std::map<int, std::vector<int>>::iterator loaded = m_cellMeshes.find(cells[i]);
+		if (loaded != m_cellMeshes.end())
+		{
+			for (size_t j = 0; j < loaded->second.size(); j++)
+			{
+				ReleaseCellMesh(loaded->second[j]);
+			}
+			m_cellMeshes.erase(loaded);
+		}
+
+		for (size_t j = 0; j < m_cellLoads.size(); j++)
+		{
+			if (m_cellLoads[j].cell == cells[i])
+			{
+				for (size_t k = 0; k < m_cellLoads[j].textureSlots.size(); k++)
+				{
+					ReleaseCellTexture(m_cellLoads[j].textureSlots[k]);
+				}
+				for (size_t k = 0; k < m_cellLoads[j].meshIndices.size(); k++)
+				{
+					ReleaseCellMesh(m_cellLoads[j].meshIndices[k]);
+				}
+				m_cellLoads.erase(m_cellLoads.begin() + j);
+				break;
+			}
+		}
+	}
+
+	m_sceneObjects.erase(std::remove_if(m_sceneObjects.begin(), m_sceneObjects.end(),
+		[&cells](const SCENE_OBJECT& object)
+		{
+			return((object.streamCell >= 0) &&
+				(std::find(cells.begin(), cells.end(), object.streamCell) != cells.end()));
+		}), m_sceneObjects.end());
+}
+
+/***********************************************************
+ *  ReleaseCellTexture()
+ *
+ *  This method is used for releasing a streamed cell's hold
+ *  on a texture, and freeing the texture once no loaded cell
+ *  uses it.  The slot is kept with no tag, so the slots of
+ *  the other textures do not change, and the next texture
+ *  loaded takes it.
+ ***********************************************************/
+void SceneManager::ReleaseCellTexture(int textureSlot)
+{
+	TEXTURE_INFO& texture = m_textureIDs[textureSlot];
+	texture.cellReferences--;
+	if ((texture.bStreamed == true) && (texture.cellReferences <= 0))
+	{
+		glDeleteTextures(1, &texture.ID);
+		texture.ID = 0;
+		texture.tag.clear();
+		texture.filename.clear();
+		texture.bStreamed = false;
+		texture.cellReferences = 0;
+
+		// the slot may be reused for a different texture
+		m_pSoftwareRasterizer->RemoveTexture(m_softwareTextures[textureSlot]);
+		m_softwareTextures[textureSlot] = -1;
+	}
+}
+
+/***********************************************************
+ *  ReleaseCellMesh()
+ *
+ *  This method is used for releasing a streamed cell's hold
+ *  on an imported mesh, and freeing the mesh once no loaded
+ *  cell uses it.  The entry is kept with no tag, so the
+ *  indices of the other meshes do not change.
+ ***********************************************************/
+void SceneManager::ReleaseCellMesh(int meshIndex)
+{
+	MESH_INFO& meshInfo = m_importedMeshes[meshIndex];
+	meshInfo.cellReferences--;
+	if ((meshInfo.bStreamed == true) && (meshInfo.cellReferences <= 0))
+	{
+		MeshImporter::DestroyMesh(meshInfo.mesh);
+		meshInfo.tag.clear();
+		meshInfo.bStreamed = false;
+		meshInfo.cellReferences = 0;
+
+		// the entry may be reused for a different mesh
+		std::map<int, int>::iterator pickMesh = m_pickMeshes.find(MESH_COUNT + meshIndex);
+		if (pickMesh != m_pickMeshes.end())
+		{
+			m_pScenePicker->RemoveMesh(pickMesh->second);
+			m_pickMeshes.erase(pickMesh);
+		}
+		std::map<int, int>::iterator softwareMesh = m_softwareMeshes.find(MESH_COUNT + meshIndex);
+		if (softwareMesh != m_softwareMeshes.end())
+		{
+			m_pSoftwareRasterizer->RemoveMesh(softwareMesh->second);
+			m_softwareMeshes.erase(softwareMesh);
+		}
+		m_bPickerChanged = true;
+	}
+}
+
+/***********************************************************
+ *  ReadStreamedMesh()
+ *
+ *  This method is run on a worker thread to read a model
+ *  file of a streamed cell into system memory, from the
+ *  mesh cache or by importing it, so the render loop only
+ *  has to hand the mesh to OpenGL.
+ ***********************************************************/
+SceneManager::STREAMED_MESH SceneManager::ReadStreamedMesh(const MeshImporter* pMeshImporter, std::string filePath)
+{
+	STREAMED_MESH streamedMesh;
+	streamedMesh.filePath = filePath;
+	streamedMesh.bLoaded = pMeshImporter->ReadMesh(filePath.c_str(), streamedMesh.mesh);
+	return(streamedMesh);
+}
+
+/***********************************************************
+ *  DropUnusedReads()
+ *
+ *  This method is used for freeing the images and model
+ *  files that were read for cells which were unloaded
+ *  before they used them.  A read that is still running is
+ *  kept until a later frame finds it finished, since freeing
+ *  it would wait for the worker thread, so the render loop
+ *  never waits for one.
+ ***********************************************************/
+void SceneManager::DropUnusedReads()
+{
+	std::set<std::string> textureTags;
+	std::set<std::string> meshTags;
+	for (size_t i = 0; i < m_cellLoads.size(); i++)
+	{
+		const SceneFile* pSceneFile = m_cellLoads[i].pSceneFile.get();
+		for (unsigned int j = 0; (pSceneFile != NULL) && (j < pSceneFile->GetHeader().textureCount); j++)
+		{
+			textureTags.insert(pSceneFile->GetString(pSceneFile->GetTextures()[j].tagOffset));
+		}
+		for (unsigned int j = 0; (pSceneFile != NULL) && (j < pSceneFile->GetHeader().meshCount); j++)
+		{
+			meshTags.insert(pSceneFile->GetString(pSceneFile->GetMeshes()[j].tagOffset));
+		}
+	}
+
+	std::map<std::string, std::shared_future<RELOADED_ASSET>>::iterator textureRead = m_textureReads.begin();
+	while (textureRead != m_textureReads.end())
+	{
+		if ((textureTags.count(textureRead->first) == 0) &&
+			(textureRead->second.wait_for(std::chrono::seconds(0)) == std::future_status::ready))
+		{
+			textureRead = m_textureReads.erase(textureRead);
+		}
+		else
+		{
+			++textureRead;
+		}
+	}
+
+	std::map<std::string, std::shared_future<STREAMED_MESH>>::iterator meshRead = m_meshReads.begin();
+	while (meshRead != m_meshReads.end())
+	{
+		if ((meshTags.count(meshRead->first) == 0) &&
+			(meshRead->second.wait_for(std::chrono::seconds(0)) == std::future_status::ready))
+		{
+			meshRead = m_meshReads.erase(meshRead);
+		}
+		else
+		{
+			++meshRead;
+		}
+	}
+}
+
+/***********************************************************
+ *  InvalidateScene()
+ *
+ *  This method is used for marking the scene contents as
+ *  changed, such as when an animation advances or a loaded
+ *  asset arrives.  It may be called from any thread, and it
+ *  wakes the render loop if it is waiting for events.
+ ***********************************************************/
+void SceneManager::InvalidateScene()
+{
+	m_bSceneChanged = true;
+	glfwPostEmptyEvent();
+}
+
+/***********************************************************
+ *  IsRedrawNeeded()
+ *
+ *  This method is used for checking whether the scene has
+ *  changed since it was last rendered.  While shader variants
+ *  are compiling, some objects are drawn with the shader
+ *  manager program, so frames keep coming until they are
+ *  all ready.  Frames also keep coming while changed asset
+ *  files are waiting to be reloaded.
+ ***********************************************************/
+bool SceneManager::IsRedrawNeeded() const
+{
+	if ((m_bUseShaderVariants == true) &&
+		((m_pShaderVariants->IsCompiling() == true) || (m_pShaderVariants->IsReloading() == true)))
+	{
+		return(true);
+	}
+	// changed files are read and applied at the start of a frame
+	if ((m_pAssetWatcher->HasChanges() == true) || (m_assetReloads.empty() == false) ||
+		(m_pReloadedSceneFile))
+	{
+		return(true);
+	}
+	// streamed cells are read and loaded a little every frame
+	if ((m_pSceneStreamer->IsBusy() == true) || (m_cellLoads.empty() == false))
+	{
+		return(true);
+	}
+	return(m_bSceneChanged);
+}
+
+/***********************************************************
+ *  GetMeshKey()
+ *
+ *  This method is used for getting the key that the CPU
+ *  copies of the mesh an object is drawn with are stored
+ *  by, which is the mesh type for a basic shape, or
+ *  MESH_COUNT plus the index of an imported mesh.  An
+ *  object with no valid imported mesh gives -1.
+ ***********************************************************/
+int SceneManager::GetMeshKey(const SCENE_OBJECT& object) const
+{
+	if (object.mesh != MESH_IMPORTED)
+	{
+		return(object.mesh);
+	}
+	if ((object.importedMesh < 0) || (object.importedMesh >= (int)m_importedMeshes.size()))
+	{
+		return(-1);
+	}
+	return(MESH_COUNT + object.importedMesh);
+}
+
+/***********************************************************
+ *  ReadObjectMesh()
+ *
+ *  This method is used for copying the vertices and the
+ *  triangles of the mesh an object is drawn with, from the
+ *  compiled shape arrays or, for an imported mesh, from its
+ *  OpenGL buffers.  A message is shown when the mesh cannot
+ *  be read.
+ ***********************************************************/
+bool SceneManager::ReadObjectMesh(
+	const SCENE_OBJECT& object,
+	std::vector<MeshImporter::MESH_VERTEX>& vertices,
+	std::vector<unsigned int>& indices)
+{
+	bool bRead = true;
+	switch (object.mesh)
+	{
+	case MESH_PLANE:
+	case MESH_BOX:
+		GetBasicShapeVertices(object.mesh, vertices, indices);
+		break;
+	case MESH_CYLINDER:
+		PrimitiveMeshes::GetShapeVertices(PrimitiveMeshes::SHAPE_CYLINDER, vertices, indices);
+		break;
+	case MESH_CONE:
+		PrimitiveMeshes::GetShapeVertices(PrimitiveMeshes::SHAPE_CONE, vertices, indices);
+		break;
+	case MESH_SPHERE:
+		PrimitiveMeshes::GetShapeVertices(PrimitiveMeshes::SHAPE_SPHERE, vertices, indices);
+		break;
+	case MESH_HALF_SPHERE:
+		PrimitiveMeshes::GetShapeVertices(PrimitiveMeshes::SHAPE_HALF_SPHERE, vertices, indices);
+		break;
+	case MESH_TORUS:
+		PrimitiveMeshes::GetShapeVertices(PrimitiveMeshes::SHAPE_TORUS, vertices, indices);
+		break;
+	case MESH_HALF_TORUS:
+		PrimitiveMeshes::GetShapeVertices(PrimitiveMeshes::SHAPE_HALF_TORUS, vertices, indices);
+		break;
+	case MESH_IMPORTED:
+		bRead = MeshImporter::ReadMeshVertices(m_importedMeshes[object.importedMesh].mesh, vertices, indices);
+		break;
+	default:
+		bRead = false;
+		break;
+	}
+
+	if (bRead == false)
+	{
+		std::cout << "ERROR::MESH_NOT_READ: "
+			<< ((object.mesh == MESH_IMPORTED) ? m_importedMeshes[object.importedMesh].tag : std::string("basic shape"))
+			<< std::endl;
+	}
+	return(bRead);
+}
+
+/***********************************************************
+ *  GetPickMesh()
+ *
+ *  This method is used for getting the picker mesh that an
+ *  object is drawn with.  The triangles of each basic shape
+ *  and imported mesh are handed to the picker the first time
+ *  an object uses them, and a mesh that cannot be read is
+ *  remembered as -1 so it is not read again.
+ ***********************************************************/
+int SceneManager::GetPickMesh(const SCENE_OBJECT& object)
+{
+	int key = GetMeshKey(object);
+	if (key < 0)
+	{
+		return(-1);
+	}
+
+	std::map<int, int>::const_iterator found = m_pickMeshes.find(key);
+	if (found != m_pickMeshes.end())
+	{
+		return(found->second);
+	}
+
+	int pickMesh = -1;
+	std::vector<MeshImporter::MESH_VERTEX> vertices;
+	std::vector<unsigned int> indices;
+	if (ReadObjectMesh(object, vertices, indices) == true)
+	{
+		std::vector<glm::vec3> positions(vertices.size());
+		for (size_t i = 0; i < vertices.size(); i++)
+		{
+			positions[i] = vertices[i].position;
+		}
+		pickMesh = m_pScenePicker->AddMesh(positions, indices);
+	}
+	m_pickMeshes[key] = pickMesh;
+	return(pickMesh);
+}
+
+/***********************************************************
+ *  UpdatePicker()
+ *
+ *  This method is used for handing the scene objects to the
+ *  picker when they have changed since the last ray, so the
+ *  object hierarchy is only rebuilt when it is needed.  The
+ *  picked object index is the index of the scene object.
+ ***********************************************************/
+void SceneManager::UpdatePicker()
+{
+	if (m_bPickerChanged == false)
+	{
+		return;
+	}
+
+	std::vector<ScenePicker::PICK_OBJECT> objects(m_sceneObjects.size());
+	for (size_t i = 0; i < m_sceneObjects.size(); i++)
+	{
+		objects[i].mesh = GetPickMesh(m_sceneObjects[i]);
+		objects[i].model = m_sceneObjects[i].model;
+	}
+	m_pScenePicker->SetObjects(objects);
+	m_bPickerChanged = false;
+}
+
+/***********************************************************
+ *  PickObject()
+ *
+ *  This method is used for finding the closest scene object
+ *  under a point of the viewport, given from -1 to 1 across
+ *  each side.  The ray runs from the near plane to the far
+ *  plane of the current view, so it works the same for the
+ *  perspective and orthographic projections.
+ ***********************************************************/
+bool SceneManager::PickObject(float viewportX, float viewportY, ScenePicker::PICK_HIT& hit)
+{
+	glm::mat4 clipToWorld = glm::inverse(m_projectionMatrix * m_viewMatrix);
+	glm::vec4 nearPoint = clipToWorld * glm::vec4(viewportX, viewportY, -1.0f, 1.0f);
+	glm::vec4 farPoint = clipToWorld * glm::vec4(viewportX, viewportY, 1.0f, 1.0f);
+
+	ScenePicker::PICK_RAY ray;
+	ray.origin = glm::vec3(nearPoint) / nearPoint.w;
+	ray.direction = glm::vec3(farPoint) / farPoint.w - ray.origin;
+	ray.maxDistance = glm::length(ray.direction);
+	if (ray.maxDistance <= 0.0f)
+	{
+		hit.object = -1;
+		return(false);
+	}
+	ray.direction /= ray.maxDistance;
+	return(CastPickRay(ray, hit));
+}
+
+/***********************************************************
+ *  CastPickRay()
+ *
+ *  This method is used for finding the closest scene object
+ *  along a ray, with the index of the scene object, the
+ *  distance and the world space position of the hit.
+ ***********************************************************/
+bool SceneManager::CastPickRay(const ScenePicker::PICK_RAY& ray, ScenePicker::PICK_HIT& hit)
+{
+	UpdatePicker();
+	return(m_pScenePicker->CastRay(ray, hit));
+}
+
+/***********************************************************
+ *  CastPickRays()
+ *
+ *  This method is used for finding the closest scene object
+ *  along each of many rays at once, such as for gameplay
+ *  queries or sampling the scene, spread over the CPU cores.
+ ***********************************************************/
+void SceneManager::CastPickRays(const std::vector<ScenePicker::PICK_RAY>& rays, std::vector<ScenePicker::PICK_HIT>& hits)
+{
+	UpdatePicker();
+	m_pScenePicker->CastRays(rays, hits);
+}
+
+/***********************************************************
+ *  RunPickingBenchmark()
+ *
+ *  This method is used for timing the picking of the scene
+ *  objects with random rays through the current view.  The
+ *  hierarchies are built first and timed on their own, then
+ *  single rays are cast one after another, and last all of
+ *  them as one batch across the CPU cores.
+ ***********************************************************/
+void SceneManager::RunPickingBenchmark()
+{
+	const int SINGLE_RAYS = 10000;
+	const int BATCH_RAYS = 100000;
+
+	std::mt19937 random(330);
+	std::uniform_real_distribution<float> viewportSide(-1.0f, 1.0f);
+	glm::mat4 clipToWorld = glm::inverse(m_projectionMatrix * m_viewMatrix);
+	std::vector<ScenePicker::PICK_RAY> rays(BATCH_RAYS);
+	for (int i = 0; i < BATCH_RAYS; i++)
+	{
+		float x = viewportSide(random);
+		float y = viewportSide(random);
+		glm::vec4 nearPoint = clipToWorld * glm::vec4(x, y, -1.0f, 1.0f);
+		glm::vec4 farPoint = clipToWorld * glm::vec4(x, y, 1.0f, 1.0f);
+		rays[i].origin = glm::vec3(nearPoint) / nearPoint.w;
+		rays[i].direction = glm::vec3(farPoint) / farPoint.w - rays[i].origin;
+		rays[i].maxDistance = glm::length(rays[i].direction);
+		rays[i].direction /= rays[i].maxDistance;
+	}
+
+	std::cout << "INFO: Picking benchmark, " << m_sceneObjects.size() << " objects" << std::endl;
+
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	m_bPickerChanged = true;
+	UpdatePicker();
+	double buildTime = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+	std::cout << "INFO: Picking hierarchy built in " << buildTime << " ms" << std::endl;
+
+	int hitCount = 0;
+	start = std::chrono::steady_clock::now();
+	for (int i = 0; i < SINGLE_RAYS; i++)
+	{
+		ScenePicker::PICK_HIT hit;
+		if (m_pScenePicker->CastRay(rays[i], hit) == true)
+		{
+			hitCount++;
+		}
+	}
+	double singleTime = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+	std::cout << "INFO: Single rays: " << SINGLE_RAYS
+		<< ", " << singleTime / SINGLE_RAYS << " us per ray"
+		<< ", hits: " << hitCount << std::endl;
+
+	std::vector<ScenePicker::PICK_HIT> hits;
+	start = std::chrono::steady_clock::now();
+	m_pScenePicker->CastRays(rays, hits);
+	double batchTime = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+	hitCount = 0;
+	for (size_t i = 0; i < hits.size(); i++)
+	{
+		if (hits[i].object >= 0)
+		{
+			hitCount++;
+		}
+	}
+	std::cout << "INFO: Batched rays: " << BATCH_RAYS
+		<< ", " << batchTime << " ms"
+		<< ", " << batchTime * 1000.0 / BATCH_RAYS << " us per ray"
+		<< ", hits: " << hitCount << std::endl;
+}
+
+/***********************************************************
+ *  RunLightingBenchmark()
+ *
+ *  This method is used for timing the scene rendering with
+ *  1 to 1000 randomly placed point and spot lights.  The GPU
+ *  time of each frame is measured with a timer query, and
+ *  the time taken to assign the lights to the clusters is
+ *  reported alongside it.  The random lights are applied
+ *  directly rather than baked, and the scene lights are put
+ *  back afterwards.
+ ***********************************************************/
+void SceneManager::RunLightingBenchmark()
+{
+	const int lightCounts[] = { 1, 10, 100, 250, 500, 1000 };
+	const int lightCountTotal = sizeof(lightCounts) / sizeof(lightCounts[0]);
+	const int BENCHMARK_FRAMES = 60;
+	// frames rendered before timing, giving new variants time to build
+	const int WARMUP_FRAMES = 100;
+
+	std::vector<LIGHT_SOURCE> sceneLights = m_lightSources;
+	bool bBakedLighting = m_bUseBakedLighting;
+	m_bUseBakedLighting = false;
+	std::mt19937 random(330);
+	std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+
+	GLuint timerQuery = 0;
+	glGenQueries(1, &timerQuery);
+
+	const char* lightingMode = "per fragment";
+	if (m_bUseDeferredShading == true)
+	{
+		lightingMode = "deferred";
+	}
+	else if (m_bUseClusteredLighting == true)
+	{
+		lightingMode = "clustered";
+	}
+	std::cout << "INFO: Lighting benchmark, " << lightingMode << " lighting" << std::endl;
+
+	for (int c = 0; c < lightCountTotal; c++)
+	{
+		int lightCount = lightCounts[c];
+		if ((m_bUseClusteredLighting == false) &&
+			(m_bUseDeferredShading == false) &&
+			(lightCount > ShaderVariantCache::MAX_LIGHT_COUNT))
+		{
+			std::cout << "INFO: Lights: " << lightCount
+				<< ", skipped without clustered or deferred lighting" << std::endl;
+			continue;
+		}
+
+		// scatter the lights over the desk, alternating between
+		// point lights and spot lights shining down
+		m_lightSources.clear();
+		for (int i = 0; i < lightCount; i++)
+		{
+			LIGHT_SOURCE light;
+			light.type = (i % 2 == 0) ? LIGHT_SOURCE::LIGHT_POINT : LIGHT_SOURCE::LIGHT_SPOT;
+			light.position = glm::vec3(
+				-20.0f + 40.0f * unit(random),
+				1.0f + 14.0f * unit(random),
+				-10.0f + 20.0f * unit(random));
+			light.direction = glm::vec3(0.0f, -1.0f, 0.0f);
+			light.range = 3.0f + 5.0f * unit(random);
+			light.innerConeAngle = 20.0f;
+			light.outerConeAngle = 35.0f;
+			light.diffuseColor = glm::vec3(
+				0.2f + 0.8f * unit(random),
+				0.2f + 0.8f * unit(random),
+				0.2f + 0.8f * unit(random));
+			light.ambientColor = light.diffuseColor * 0.05f;
+			light.specularColor = light.diffuseColor;
+			light.focalStrength = 32.0f;
+			light.specularIntensity = 0.5f;
+			m_lightSources.push_back(light);
+		}
+		UpdateVariantKeys();
+
+		for (int frame = 0; frame < WARMUP_FRAMES; frame++)
+		{
+			glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+			RenderScene();
+			glFinish();
+			if ((m_bUseShaderVariants == false) || (m_pShaderVariants->IsCompiling() == false))
+			{
+				break;
+			}
+		}
+
+		double gpuTime = 0.0;
+		double assignTime = 0.0;
+		for (int frame = 0; frame < BENCHMARK_FRAMES; frame++)
+		{
+			glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+			glBeginQuery(GL_TIME_ELAPSED, timerQuery);
+			RenderScene();
+			glEndQuery(GL_TIME_ELAPSED);
+
+			GLuint64 elapsed = 0;
+			glGetQueryObjectui64v(timerQuery, GL_QUERY_RESULT, &elapsed);
+			gpuTime += elapsed / 1.0e6;
+			assignTime += m_pClusteredLighting->GetAssignTime();
+		}
+
+		std::cout << "INFO: Lights: " << lightCount
+			<< ", GPU: " << gpuTime / BENCHMARK_FRAMES << " ms";
+		if ((m_bUseClusteredLighting == true) && (m_bUseDeferredShading == false))
+		{
+			std::cout << ", light assignment: " << assignTime / BENCHMARK_FRAMES << " ms"
+				<< ", lights per cluster: " << m_pClusteredLighting->GetAverageLightsPerCluster();
+		}
+		std::cout << std::endl;
+	}
+
+	glDeleteQueries(1, &timerQuery);
+
+	// put the scene lights back
+	m_lightSources = sceneLights;
+	m_bUseBakedLighting = bBakedLighting;
+	UpdateVariantKeys();
+	InvalidateScene();
+}
+
+/***********************************************************
+ *  RunQuadViewBenchmark()
+ *
+ *  This method is used for timing the quad views drawn in
+ *  one pass against drawing the scene four times, once for
+ *  each view, with the single camera view as the baseline.
+ *  The GPU time of each frame is measured with a timer
+ *  query, and the CPU time of submitting it alongside.  The
+ *  quad views must have been set before it is called.
+ ***********************************************************/
+void SceneManager::RunQuadViewBenchmark()
+{
+	const char* modeNames[] = { "single view", "four passes", "one pass" };
+	const int MODE_COUNT = 3;
+	const int BENCHMARK_FRAMES = 60;
+	// frames rendered before timing, giving new variants time to build
+	const int WARMUP_FRAMES = 100;
+
+	bool bQuadView = m_bQuadView;
+	GLuint timerQuery = 0;
+	glGenQueries(1, &timerQuery);
+	std::cout << "INFO: Quad view benchmark, " << m_sceneObjects.size() << " objects" << std::endl;
+
+	for (int mode = 0; mode < MODE_COUNT; mode++)
+	{
+		if ((mode == 2) &&
+			((m_bUseShaderVariants == false) || (ShaderVariantCache::IsMultiViewSupported() == false)))
+		{
+			std::cout << "INFO: Quad view, " << modeNames[mode]
+				<< ", skipped without multi view shader variants" << std::endl;
+			continue;
+		}
+		m_bQuadView = (mode != 0);
+		m_bSeparateQuadViews = (mode == 1);
+
+		for (int frame = 0; frame < WARMUP_FRAMES; frame++)
+		{
+			glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+			RenderScene();
+			glFinish();
+			if ((m_bUseShaderVariants == false) || (m_pShaderVariants->IsCompiling() == false))
+			{
+				break;
+			}
+		}
 
-	OBJECT_MATERIAL aluminumMaterial;
-	aluminumMaterial.ambientColor = glm::vec3(0.3f, 0.3f, 0.3f);
-	aluminumMaterial.ambientStrength = 0.5f;
-	aluminumMaterial.diffuseColor = glm::vec3(0.5f, 0.5f, 0.5f);
-	aluminumMaterial.specularColor = glm::vec3(0.8f, 0.8f, 0.8f);
-	aluminumMaterial.shininess = 90.0;
-	aluminumMaterial.tag = "aluminum";
+		double gpuTime = 0.0;
+		double cpuTime = 0.0;
+		for (int frame = 0; frame < BENCHMARK_FRAMES; frame++)
+		{
+			glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+			std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+			glBeginQuery(GL_TIME_ELAPSED, timerQuery);
+			RenderScene();
+			glEndQuery(GL_TIME_ELAPSED);
+			cpuTime += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+			GLuint64 elapsed = 0;
+			glGetQueryObjectui64v(timerQuery, GL_QUERY_RESULT, &elapsed);
+			gpuTime += elapsed / 1.0e6;
+		}
 
-	m_objectMaterials.push_back(aluminumMaterial);
+		std::cout << "INFO: Quad view, " << modeNames[mode]
+			<< ", GPU: " << gpuTime / BENCHMARK_FRAMES << " ms"
+			<< ", CPU: " << cpuTime / BENCHMARK_FRAMES << " ms" << std::endl;
+	}
 
+	glDeleteQueries(1, &timerQuery);
+
+	m_bQuadView = bQuadView;
+	m_bSeparateQuadViews = false;
+	InvalidateScene();
 }
+
 /***********************************************************
- *  LoadSceneTextures()
+ *  RunRasterizerBenchmark()
  *
- *  This method is used for preparing the 3D scene by loading
- *  the shapes, textures in memory to support the 3D scene
- *  rendering
+ *  This method is used for timing the scene drawn from the
+ *  current view by OpenGL and by the software rasterizer.
+ *  Each frame is waited on with glFinish(), so the OpenGL
+ *  time is the whole frame, which on a host without
+ *  graphics hardware is the time of the driver's own CPU
+ *  rasterizer.
  ***********************************************************/
-void SceneManager::LoadSceneTextures()
+void SceneManager::RunRasterizerBenchmark()
 {
-	bool bReturn = false;
+	const char* modeNames[] = { "OpenGL", "software" };
+	const int MODE_COUNT = 2;
+	const int BENCHMARK_FRAMES = 30;
+	// frames rendered before timing, giving new variants time to
+	// build and the meshes and textures time to be read back
+	const int WARMUP_FRAMES = 100;
+
+	bool bSoftware = m_bUseSoftwareRasterizer;
+	const GLubyte* renderer = glGetString(GL_RENDERER);
+	std::cout << "INFO: Rasterizer benchmark, " << m_sceneObjects.size() << " objects, OpenGL renderer: "
+		<< ((renderer != NULL) ? (const char*)renderer : "unknown") << ", "
+		<< m_pSoftwareRasterizer->GetThreadCount() << " software threads" << std::endl;
+
+	for (int mode = 0; mode < MODE_COUNT; mode++)
+	{
+		m_bUseSoftwareRasterizer = (mode == 1);
 
-	bReturn = CreateGLTexture(
-		"C:/Users/katel/Downloads/CS330Content/CS330Content/Projects/7-1_FinalProjectMilestones/Debug/Texture/Glass.png", "Frog");
-	bReturn = CreateGLTexture(
-		"C:/Users/katel/Downloads/CS330Content/CS330Content/Projects/7-1_FinalProjectMilestones/Debug/Texture/Keyboard.jpg", "Base");
-	bReturn = CreateGLTexture(
-		"C:/Users/katel/Downloads/CS330Content/CS330Content/Projects/7-1_FinalProjectMilestones/Debug/Texture/Body.jpg", "Body");
-	bReturn = CreateGLTexture(
-		"C:/Users/katel/Downloads/CS330Content/CS330Content/Projects/7-1_FinalProjectMilestones/Debug/Texture/Screen.png", "Screen");
-	bReturn = CreateGLTexture(
-		"C:/Users/katel/Downloads/CS330Content/CS330Content/Projects/7-1_FinalProjectMilestones/Debug/Texture/Wood.jpg", "Desk");
-	bReturn = CreateGLTexture(
-		"C:/Users/katel/Downloads/CS330Content/CS330Content/Projects/7-1_FinalProjectMilestones/Debug/Texture/Redbull.png", "Can");
-	bReturn = CreateGLTexture(
-		"C:/Users/katel/Downloads/CS330Content/CS330Content/Projects/7-1_FinalProjectMilestones/Debug/Texture/mouse.jpg", "Mouse");
-	bReturn = CreateGLTexture(
-		"C:/Users/katel/Downloads/CS330Content/CS330Content/Projects/7-1_FinalProjectMilestones/Debug/Texture/headphone.jpg", "Headphone");
-	bReturn = CreateGLTexture(
-		"C:/Users/katel/Downloads/CS330Content/CS330Content/Projects/7-1_FinalProjectMilestones/Debug/Texture/Cushion.jpg", "Cushion");
-	bReturn = CreateGLTexture(
-		"C:/Users/katel/Downloads/CS330Content/CS330Content/Projects/7-1_FinalProjectMilestones/Debug/Texture/Buttons.jpg", "Buttons");
-	bReturn = CreateGLTexture(
-		"C:/Users/katel/Downloads/CS330Content/CS330Content/Projects/7-1_FinalProjectMilestones/Debug/Texture/cantop.jpg", "Top");
-	bReturn = CreateGLTexture(
-		"C:/Users/katel/Downloads/CS330Content/CS330Content/Projects/7-1_FinalProjectMilestones/Debug/Texture/Wheel.jpg", "Wheel");
+		for (int frame = 0; frame < WARMUP_FRAMES; frame++)
+		{
+			glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+			RenderScene();
+			glFinish();
+			if ((m_bUseSoftwareRasterizer == true) ||
+				(m_bUseShaderVariants == false) || (m_pShaderVariants->IsCompiling() == false))
+			{
+				break;
+			}
+		}
 
-	
-	// after the texture image data is loaded into memory, the
-	// loaded textures need to be bound to texture slots - there
-	// are a total of 16 available slots for scene textures
-	BindGLTextures();
+		double frameTime = 0.0;
+		double rasterTime = 0.0;
+		for (int frame = 0; frame < BENCHMARK_FRAMES; frame++)
+		{
+			glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+			std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+			RenderScene();
+			glFinish();
+			frameTime += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+			rasterTime += m_pSoftwareRasterizer->GetFrameTime();
+		}
+
+		std::cout << "INFO: Rasterizer, " << modeNames[mode]
+			<< ": " << frameTime / BENCHMARK_FRAMES << " ms per frame";
+		if (mode == 1)
+		{
+			std::cout << ", " << rasterTime / BENCHMARK_FRAMES << " ms drawing";
+		}
+		std::cout << std::endl;
+	}
+
+	m_bUseSoftwareRasterizer = bSoftware;
+	InvalidateScene();
 }
+
 /***********************************************************
- *  SetupSceneLights()
+ *  RenderScene()
  *
- *  This method is called to add and configure the light
- *  sources for the 3D scene.  There are up to 4 light sources.
+ *  This method is used for rendering the 3D scene by 
+ *  drawing the defined scene objects, from the camera view
+ *  or from each of the quad views, or with the software
+ *  rasterizer from the camera view.
  ***********************************************************/
-void SceneManager::SetupSceneLights()
+void SceneManager::RenderScene()
+{
+	// swap in any changed assets before anything is drawn, so the
+	// whole frame uses either the old or the new ones
+	ApplyAssetReloads();
+	// bring in the streamed cells around the camera
+	UpdateStreaming();
+
+	// the current scene contents are being displayed
+	m_bSceneChanged = false;
+
+	if (m_bUseSoftwareRasterizer == true)
+	{
+		RenderSoftwareView();
+	}
+	else if (m_bQuadView == true)
+	{
+		RenderQuadViews();
+	}
+	else
+	{
+		RenderSceneView();
+	}
+}
+
+/***********************************************************
+ *  SortTransparentObjects()
+ *
+ *  This method is used for sorting the transparent objects
+ *  from the furthest to the closest to the camera.
+ ***********************************************************/
+void SceneManager::SortTransparentObjects()
+{
+	const std::vector<SCENE_OBJECT>& objects = m_sceneObjects;
+	glm::vec3 viewPosition = m_viewPosition;
+	std::sort(m_transparentDrawOrder.begin(), m_transparentDrawOrder.end(),
+		[&objects, &viewPosition](int a, int b)
+		{
+			glm::vec3 offsetA = objects[a].position - viewPosition;
+			glm::vec3 offsetB = objects[b].position - viewPosition;
+			return(glm::dot(offsetA, offsetA) > glm::dot(offsetB, offsetB));
+		});
+}
+
+/***********************************************************
+ *  RenderSceneView()
+ *
+ *  This method is used for drawing the scene objects from
+ *  the current view into the viewport.  Opaque objects are
+ *  drawn first, grouped by shader variant or into the
+ *  G-buffer with deferred shading, then the impostors of the
+ *  distant groups, then transparent objects from back to
+ *  front.
+ ***********************************************************/
+void SceneManager::RenderSceneView()
 {
-    // Enable custom lighting
-    m_pShaderManager->setBoolValue(g_UseLightingName, true);
+	// the viewport height sets how large the imported mesh detail
+	// level errors appear
+	GLint viewport[4];
+	glGetIntegerv(GL_VIEWPORT, viewport);
+	m_viewportHeight = viewport[3];
+
+	// leave out the objects of the groups that are far enough away
+	// to be drawn as impostors
+	FindDistantGroups();
+
+	// sort the transparent objects by distance from the camera
+	SortTransparentObjects();
 
-		// Sunlight from the right window
-		m_pShaderManager->setVec3Value("lightSources[0].position", 10.0f, 15.0f, -5.0f); // Positioned high and to the right
-		m_pShaderManager->setVec3Value("lightSources[0].ambientColor", 0.6f, 0.55f, 0.5f); // Slightly warm ambient light
-		m_pShaderManager->setVec3Value("lightSources[0].diffuseColor", 1.0f, 0.95f, 0.85f); // Warm and bright diffuse light
-		m_pShaderManager->setVec3Value("lightSources[0].specularColor", 1.0f, 1.0f, 0.9f); 
-		m_pShaderManager->setFloatValue("lightSources[0].focalStrength", 64.0f);
-		m_pShaderManager->setFloatValue("lightSources[0].specularIntensity", 0.7f); // High specular intensity
+	if (m_bUseShaderVariants == false)
+	{
+		SetFrameUniforms();
+	}
 
-		// Overhead light (Overhead light)
-		m_pShaderManager->setVec3Value("lightSources[1].position", 0.0f, 10.0f, 0.0f); // Positioned directly above
-		m_pShaderManager->setVec3Value("lightSources[1].ambientColor", 0.5f, 0.5f, 0.5f); // Neutral ambient light
-		m_pShaderManager->setVec3Value("lightSources[1].diffuseColor", 0.7f, 0.7f, 0.8f); 
-		m_pShaderManager->setVec3Value("lightSources[1].specularColor", 0.6f, 0.6f, 0.7f);
-		m_pShaderManager->setFloatValue("lightSources[1].focalStrength", 32.0f);
-		m_pShaderManager->setFloatValue("lightSources[1].specularIntensity", 0.5f); 
+	// the opaque objects are lit by the deferred pass once all of
+	// their G-buffer variants have been built
+	bool bDeferred = (m_bUseDeferredShading == true) &&
+		(m_bUseShaderVariants == true) &&
+		(m_pShaderVariants->IsCompiling() == false);
+
+	// assign the lights to the clusters of this frame's view, which
+	// the deferred path only needs for the transparent objects
+	if ((m_bUseShaderVariants == true) && (m_bUseClusteredLighting == true) &&
+		((bDeferred == false) || (m_transparentDrawOrder.empty() == false)))
+	{
+		m_pClusteredLighting->Update(m_lightSources, m_viewMatrix, m_projectionMatrix);
+	}
 
-		// General ambient light for overall brightness
-		m_pShaderManager->setVec3Value("ambientLight.color", 0.5f, 0.5f, 0.55f); // Slightly cool ambient light
-		m_pShaderManager->setFloatValue("ambientLight.intensity", 1.0f); // Moderate intensity 
+	int firstPass = 0;
+	if ((bDeferred == true) && (m_pDeferredRenderer->BeginGeometryPass() == true))
+	{
+		DrawDeferredObjects();
+		firstPass = 1;
 	}
 
+	// the opaque basic shapes are drawn from records once their
+	// recorded variants have been built
+	bool bRecorded = (m_bUseRecordedDraws == true) &&
+		(m_pShaderVariants->IsCompiling() == false) &&
+		(DrawRecordedObjects() == true);
+
+	for (int pass = firstPass; pass < 2; pass++)
+	{
+		const std::vector<int>& drawOrder =
+			(pass == 0) ? m_opaqueDrawOrder : m_transparentDrawOrder;
+
+		// the impostors are opaque, so they are drawn before the
+		// transparent objects that may be in front of them
+		if (pass == 1)
+		{
+			m_pImpostors->Draw(m_distantGroups, m_viewMatrix, m_projectionMatrix, m_viewPosition);
+		}
+
+		for (size_t i = 0; i < drawOrder.size(); i++)
+		{
+			const SCENE_OBJECT& object = m_sceneObjects[drawOrder[i]];
+			if ((IsDrawnAsImpostor(object) == true) ||
+				((pass == 0) && (bRecorded == true) && (object.mesh != MESH_IMPORTED)))
+			{
+				continue;
+			}
+
+			// bind the variant for the object, and pass the frame
+			// values into it when it is a different program
+			if ((m_bUseShaderVariants == true) &&
+				(m_pShaderVariants->UseVariant(object.variantKey) == true))
+			{
+				SetFrameUniforms();
+			}
+
+			SetObjectUniforms(object);
+			DrawObjectMesh(object);
+		}
+	}
 
+	// leave the shader manager program bound for the next frame
+	if (m_bUseShaderVariants == true)
+	{
+		m_pShaderVariants->UseBaseProgram();
+	}
+}
 
 /***********************************************************
- *  PrepareScene()
+ *  RenderQuadViews()
  *
- *  This method is used for preparing the 3D scene by loading
- *  the shapes, textures in memory to support the 3D scene 
- *  rendering
+ *  This method is used for drawing the scene from each of
+ *  the quad views into its quarter of the viewport.  When
+ *  the driver supports it, every object is submitted once,
+ *  with one viewport per view, and its geometry stage copies
+ *  the triangles into each of them.  The objects and the
+ *  meshlets are culled against all of the views together,
+ *  keeping whatever any one view can see.  Otherwise, the
+ *  scene is drawn once for each view, lit without the
+ *  deferred pass, which covers the whole G-buffer.
  ***********************************************************/
-void SceneManager::PrepareScene()
+void SceneManager::RenderQuadViews()
 {
-	// only one instance of a particular mesh needs to be
-	// loaded in memory no matter how many times it is drawn
-	// in the rendered 3D scene
+	GLint viewport[4];
+	glGetIntegerv(GL_VIEWPORT, viewport);
+	int tileWidth = viewport[2] / 2;
+	int tileHeight = viewport[3] / 2;
+
+	// the camera view is put back afterwards, since the streaming
+	// follows it
+	glm::mat4 cameraView = m_viewMatrix;
+	glm::mat4 cameraProjection = m_projectionMatrix;
+	glm::vec3 cameraPosition = m_viewPosition;
+
+	bool bOnePass = (m_bSeparateQuadViews == false) &&
+		(m_bUseShaderVariants == true) &&
+		(ShaderVariantCache::IsMultiViewSupported() == true);
+	if (bOnePass == false)
+	{
+		bool bDeferredShading = m_bUseDeferredShading;
+		m_bUseDeferredShading = false;
+		for (int view = 0; view < ShaderVariantCache::MULTI_VIEW_COUNT; view++)
+		{
+			glViewport(
+				viewport[0] + (view % 2) * tileWidth,
+				viewport[1] + (1 - view / 2) * tileHeight,
+				tileWidth,
+				tileHeight);
+			SetViewTransform(m_quadViewMatrices[view], m_quadProjectionMatrices[view], m_quadViewPositions[view]);
+			RenderSceneView();
+		}
+		m_bUseDeferredShading = bDeferredShading;
+	}
+	else
+	{
+		for (int view = 0; view < ShaderVariantCache::MULTI_VIEW_COUNT; view++)
+		{
+			glViewportIndexedf(
+				(GLuint)view,
+				(GLfloat)(viewport[0] + (view % 2) * tileWidth),
+				(GLfloat)(viewport[1] + (1 - view / 2) * tileHeight),
+				(GLfloat)tileWidth,
+				(GLfloat)tileHeight);
+		}
 
-	// load the texture image files for the textures applied
-	// to objects in the 3D scene
-	LoadSceneTextures();
-	// define the materials that will be used for the objects
-	// in the 3D scene
-	DefineObjectMaterials();
-	// add and defile the light sources for the 3D scene
-	SetupSceneLights();
+		// the detail levels and the transparent drawing order follow
+		// the first view, which shares its projection with the others
+		SetViewTransform(m_quadViewMatrices[0], m_quadProjectionMatrices[0], m_quadViewPositions[0]);
+		m_viewportHeight = tileHeight;
+		SortTransparentObjects();
 
+		// the impostors are chosen for one view, so every object is
+		// drawn as itself
+		bool bUseImpostors = m_bUseImpostors;
+		m_bUseImpostors = false;
+		m_bDrawingQuadViews = true;
 
-	m_basicMeshes->LoadPlaneMesh();
-	m_basicMeshes->LoadCylinderMesh();
-	m_basicMeshes->LoadSphereMesh();
-	m_basicMeshes->LoadBoxMesh();
-	m_basicMeshes->LoadConeMesh();
-	m_basicMeshes->LoadTorusMesh();
+		int lightCount = std::min((int)m_lightSources.size(), ShaderVariantCache::MAX_LIGHT_COUNT);
+		for (int pass = 0; pass < 2; pass++)
+		{
+			const std::vector<int>& drawOrder =
+				(pass == 0) ? m_opaqueDrawOrder : m_transparentDrawOrder;
+
+			for (size_t i = 0; i < drawOrder.size(); i++)
+			{
+				const SCENE_OBJECT& object = m_sceneObjects[drawOrder[i]];
+				if (IsInQuadViews(object) == false)
+				{
+					continue;
+				}
+
+				if (m_pShaderVariants->UseVariant(
+					ShaderVariantCache::MakeMultiViewKey(object.variantKey, lightCount)) == true)
+				{
+					SetFrameUniforms();
+				}
+
+				SetObjectUniforms(object);
+				DrawObjectMesh(object);
+			}
+		}
+
+		m_bDrawingQuadViews = false;
+		m_bUseImpostors = bUseImpostors;
+		m_pShaderVariants->UseBaseProgram();
+	}
+
+	// setting the viewport sets every viewport of the array
+	glViewport(viewport[0], viewport[1], viewport[2], viewport[3]);
+	SetViewTransform(cameraView, cameraProjection, cameraPosition);
 }
 
 /***********************************************************
- *  RenderScene()
+ *  IsInQuadViews()
  *
- *  This method is used for rendering the 3D scene by 
- *  transforming and drawing the basic 3D shapes
+ *  This method is used for checking whether any part of a
+ *  scene object's bounds is inside the frustum of at least
+ *  one of the quad views.
  ***********************************************************/
-void SceneManager::RenderScene()
+bool SceneManager::IsInQuadViews(const SCENE_OBJECT& object) const
+{
+	glm::vec3 boundsMin;
+	glm::vec3 boundsMax;
+	GetObjectBounds(object, boundsMin, boundsMax);
+	for (int view = 0; view < ShaderVariantCache::MULTI_VIEW_COUNT; view++)
+	{
+		if (IsBoxInFrustum(m_quadProjectionMatrices[view] * m_quadViewMatrices[view], boundsMin, boundsMax) == true)
+		{
+			return(true);
+		}
+	}
+	return(false);
+}
+
+/***********************************************************
+ *  RenderSoftwareView()
+ *
+ *  This method is used for drawing the scene objects from
+ *  the current view with the software rasterizer, in the
+ *  same order as OpenGL, and copying the frame into the
+ *  viewport.  Objects without a material are left unlit,
+ *  as in the deferred lighting pass.
+ ***********************************************************/
+void SceneManager::RenderSoftwareView()
+{
+	GLint viewport[4];
+	glGetIntegerv(GL_VIEWPORT, viewport);
+	m_viewportHeight = viewport[3];
+
+	// sort the transparent objects by distance from the camera
+	SortTransparentObjects();
+
+	GLfloat clearColor[4];
+	glGetFloatv(GL_COLOR_CLEAR_VALUE, clearColor);
+	m_pSoftwareRasterizer->SetViewTransform(m_viewMatrix, m_projectionMatrix, m_viewPosition);
+	m_pSoftwareRasterizer->SetLights(m_lightSources, m_ambientLightColor, m_ambientLightIntensity);
+	m_pSoftwareRasterizer->BeginFrame(viewport[2], viewport[3],
+		glm::vec4(clearColor[0], clearColor[1], clearColor[2], clearColor[3]));
+
+	for (int pass = 0; pass < 2; pass++)
+	{
+		const std::vector<int>& drawOrder =
+			(pass == 0) ? m_opaqueDrawOrder : m_transparentDrawOrder;
+		for (size_t i = 0; i < drawOrder.size(); i++)
+		{
+			const SCENE_OBJECT& object = m_sceneObjects[drawOrder[i]];
+			int mesh = GetSoftwareMesh(object);
+			if (mesh < 0)
+			{
+				continue;
+			}
+
+			SoftwareRasterizer::DRAW_STATE state;
+			state.texture = (object.bUseTexture == true) ? GetSoftwareTexture(object.textureSlot) : -1;
+			state.UVscale = object.UVscale;
+			state.color = object.color;
+			state.bTransparent = object.bTransparent;
+			state.bUseLighting = (m_bUseLighting == true) && (object.materialIndex >= 0);
+			state.ambientColor = glm::vec3(0.0f);
+			state.ambientStrength = 0.0f;
+			state.diffuseColor = glm::vec3(0.0f);
+			state.specularColor = glm::vec3(0.0f);
+			if (object.materialIndex >= 0)
+			{
+				const OBJECT_MATERIAL& material = m_objectMaterials[object.materialIndex];
+				state.ambientColor = material.ambientColor;
+				state.ambientStrength = material.ambientStrength;
+				state.diffuseColor = material.diffuseColor;
+				state.specularColor = material.specularColor;
+			}
+			m_pSoftwareRasterizer->DrawMesh(mesh, object.model, object.normalMatrix, state);
+		}
+	}
+
+	m_pSoftwareRasterizer->EndFrame();
+	m_pSoftwareRasterizer->Present(viewport[0], viewport[1], viewport[2], viewport[3]);
+}
+
+/***********************************************************
+ *  GetSoftwareMesh()
+ *
+ *  This method is used for getting the software rasterizer
+ *  mesh that an object is drawn with.  Each basic shape and
+ *  imported mesh is handed to the rasterizer the first time
+ *  an object uses it, and a mesh that cannot be read is
+ *  remembered as -1 so it is not read again.
+ ***********************************************************/
+int SceneManager::GetSoftwareMesh(const SCENE_OBJECT& object)
+{
+	int key = GetMeshKey(object);
+	if (key < 0)
+	{
+		return(-1);
+	}
+
+	std::map<int, int>::const_iterator found = m_softwareMeshes.find(key);
+	if (found != m_softwareMeshes.end())
+	{
+		return(found->second);
+	}
+
+	int softwareMesh = -1;
+	std::vector<MeshImporter::MESH_VERTEX> vertices;
+	std::vector<unsigned int> indices;
+	if (ReadObjectMesh(object, vertices, indices) == true)
+	{
+		softwareMesh = m_pSoftwareRasterizer->AddMesh(vertices, indices);
+	}
+	m_softwareMeshes[key] = softwareMesh;
+	return(softwareMesh);
+}
+
+/***********************************************************
+ *  GetSoftwareTexture()
+ *
+ *  This method is used for getting the software rasterizer
+ *  texture of a texture slot.  The image is read back from
+ *  the OpenGL texture bound to the slot the first time it
+ *  is drawn, which also covers the textures of streamed
+ *  cells and reloaded images.
+ ***********************************************************/
+int SceneManager::GetSoftwareTexture(int textureSlot)
+{
+	if ((textureSlot < 0) || (textureSlot >= m_loadedTextures))
+	{
+		return(-1);
+	}
+	if (m_softwareTextures[textureSlot] >= 0)
+	{
+		return(m_softwareTextures[textureSlot]);
+	}
+
+	std::vector<unsigned char> pixels;
+	int width = 0;
+	int height = 0;
+	if (ReadTexturePixels(textureSlot, pixels, width, height) == false)
+	{
+		return(-1);
+	}
+	m_softwareTextures[textureSlot] = m_pSoftwareRasterizer->AddTexture(&pixels[0], width, height);
+	return(m_softwareTextures[textureSlot]);
+}
+
+/***********************************************************
+ *  ReadTexturePixels()
+ *
+ *  This method is used for reading the RGBA pixels of the
+ *  OpenGL texture in a texture slot back to the CPU, with
+ *  the first row at the bottom.
+ ***********************************************************/
+bool SceneManager::ReadTexturePixels(
+	int textureSlot,
+	std::vector<unsigned char>& pixels,
+	int& width,
+	int& height)
+{
+	if ((textureSlot < 0) || (textureSlot >= m_loadedTextures))
+	{
+		return(false);
+	}
+
+	GLint textureWidth = 0;
+	GLint textureHeight = 0;
+	glActiveTexture(GL_TEXTURE0 + textureSlot);
+	glBindTexture(GL_TEXTURE_2D, m_textureIDs[textureSlot].ID);
+	glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_WIDTH, &textureWidth);
+	glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_HEIGHT, &textureHeight);
+	if ((textureWidth <= 0) || (textureHeight <= 0))
+	{
+		return(false);
+	}
+
+	width = textureWidth;
+	height = textureHeight;
+	pixels.resize((size_t)width * height * 4);
+	glPixelStorei(GL_PACK_ALIGNMENT, 1);
+	glGetTexImage(GL_TEXTURE_2D, 0, GL_RGBA, GL_UNSIGNED_BYTE, &pixels[0]);
+	return(true);
+}
+
+/***********************************************************
+ *  RenderRayTracedImage()
+ *
+ *  This method is used for ray tracing the scene from the
+ *  current view into an image file, at the size of the
+ *  viewport.  Spheres and cylinders are traced as exact
+ *  shapes, and every other mesh and texture is copied into
+ *  the ray tracer once, however many objects use it.
+ *  Objects without a material are left unlit, as in the
+ *  deferred lighting pass.
+ ***********************************************************/
+bool SceneManager::RenderRayTracedImage(const char* filePath, int sampleCount)
+{
+	GLint viewport[4];
+	glGetIntegerv(GL_VIEWPORT, viewport);
+	GLfloat clearColor[4];
+	glGetFloatv(GL_COLOR_CLEAR_VALUE, clearColor);
+
+	RayTracer rayTracer;
+	std::map<int, int> traceMeshes;
+	int traceTextures[16];
+	for (int i = 0; i < 16; i++)
+	{
+		traceTextures[i] = -2;
+	}
+
+	std::vector<RayTracer::TRACE_INSTANCE> instances;
+	for (int pass = 0; pass < 2; pass++)
+	{
+		const std::vector<int>& drawOrder =
+			(pass == 0) ? m_opaqueDrawOrder : m_transparentDrawOrder;
+		for (size_t i = 0; i < drawOrder.size(); i++)
+		{
+			const SCENE_OBJECT& object = m_sceneObjects[drawOrder[i]];
+			RayTracer::TRACE_INSTANCE instance;
+			instance.mesh = -1;
+			instance.model = object.model;
+			if (object.mesh == MESH_SPHERE)
+			{
+				instance.shape = RayTracer::SHAPE_SPHERE;
+			}
+			else if (object.mesh == MESH_CYLINDER)
+			{
+				instance.shape = RayTracer::SHAPE_CYLINDER;
+			}
+			else
+			{
+				int key = GetMeshKey(object);
+				if (key < 0)
+				{
+					continue;
+				}
+				std::map<int, int>::const_iterator found = traceMeshes.find(key);
+				if (found == traceMeshes.end())
+				{
+					std::vector<MeshImporter::MESH_VERTEX> vertices;
+					std::vector<unsigned int> indices;
+					int traceMesh = -1;
+					if (ReadObjectMesh(object, vertices, indices) == true)
+					{
+						traceMesh = rayTracer.AddMesh(vertices, indices);
+					}
+					found = traceMeshes.insert(std::make_pair(key, traceMesh)).first;
+				}
+				if (found->second < 0)
+				{
+					continue;
+				}
+				instance.shape = RayTracer::SHAPE_MESH;
+				instance.mesh = found->second;
+			}
+
+			RayTracer::TRACE_SURFACE& surface = instance.surface;
+			surface.texture = -1;
+			if ((object.bUseTexture == true) && (object.textureSlot >= 0) && (object.textureSlot < 16))
+			{
+				if (traceTextures[object.textureSlot] == -2)
+				{
+					std::vector<unsigned char> pixels;
+					int width = 0;
+					int height = 0;
+					traceTextures[object.textureSlot] = -1;
+					if (ReadTexturePixels(object.textureSlot, pixels, width, height) == true)
+					{
+						traceTextures[object.textureSlot] = rayTracer.AddTexture(&pixels[0], width, height);
+					}
+				}
+				surface.texture = traceTextures[object.textureSlot];
+			}
+			surface.UVscale = object.UVscale;
+			surface.color = object.color;
+			surface.bTransparent = object.bTransparent;
+			surface.bUseLighting = (m_bUseLighting == true) && (object.materialIndex >= 0);
+			surface.ambientColor = glm::vec3(0.0f);
+			surface.ambientStrength = 0.0f;
+			surface.diffuseColor = glm::vec3(0.0f);
+			surface.specularColor = glm::vec3(0.0f);
+			if (object.materialIndex >= 0)
+			{
+				const OBJECT_MATERIAL& material = m_objectMaterials[object.materialIndex];
+				surface.ambientColor = material.ambientColor;
+				surface.ambientStrength = material.ambientStrength;
+				surface.diffuseColor = material.diffuseColor;
+				surface.specularColor = material.specularColor;
+			}
+			instances.push_back(instance);
+		}
+	}
+
+	rayTracer.SetInstances(instances);
+	rayTracer.SetLights(m_lightSources, m_ambientLightColor, m_ambientLightIntensity);
+	rayTracer.SetViewTransform(m_viewMatrix, m_projectionMatrix, m_viewPosition);
+
+	std::cout << "INFO: Ray tracing " << viewport[2] << "x" << viewport[3] << " with "
+		<< sampleCount << " samples per pixel, " << instances.size() << " objects" << std::endl;
+	rayTracer.Render(viewport[2], viewport[3], sampleCount,
+		glm::vec3(clearColor[0], clearColor[1], clearColor[2]));
+
+	double renderTime = rayTracer.GetRenderTime();
+	long long rayCount = rayTracer.GetRayCount();
+	std::cout << "INFO: Ray traced in " << renderTime << " s, " << rayCount << " rays, "
+		<< ((renderTime > 0.0) ? (double)rayCount / renderTime / 1000000.0 : 0.0) << " Mrays/s" << std::endl;
+
+	if (rayTracer.SaveImage(filePath) == false)
+	{
+		std::cout << "ERROR::IMAGE_NOT_SAVED: " << filePath << std::endl;
+		return(false);
+	}
+	std::cout << "INFO: Saved ray traced image: " << filePath << std::endl;
+	return(true);
+}
+
+/***********************************************************
+ *  RunSubmissionBenchmark()
+ *
+ *  This method is used for timing a generated grid of basic
+ *  shapes, at several object counts, drawn one at a time
+ *  against drawn from recorded runs.  The GPU time of each
+ *  frame is measured with a timer query, and the CPU time
+ *  of submitting it alongside, with the time the worker
+ *  threads spent recording.  The scene's own objects are put
+ *  back afterwards.  Recorded draws must have been turned on
+ *  before PrepareScene().
+ ***********************************************************/
+void SceneManager::RunSubmissionBenchmark()
+{
+	const char* modeNames[] = { "one at a time", "recorded" };
+	const int MODE_COUNT = 2;
+	const int OBJECT_COUNTS[] = { 10000, 100000, 1000000 };
+	const int COUNT_STEPS = 3;
+	const int BENCHMARK_FRAMES = 10;
+	// frames rendered before timing, giving new variants time to build
+	const int WARMUP_FRAMES = 100;
+	const MESH_TYPE meshes[] = { MESH_BOX, MESH_SPHERE, MESH_CYLINDER, MESH_CONE };
+	const int MESH_CHOICES = 4;
+
+	if (m_bUseRecordedDraws == false)
+	{
+		std::cout << "INFO: Submission benchmark skipped without recorded draws" << std::endl;
+		return;
+	}
+
+	// the generated objects use only the textures that are drawn
+	// without blending, so every object is in the opaque pass
+	std::vector<int> textureSlots;
+	for (int i = 0; i < m_loadedTextures; i++)
+	{
+		if (m_textureIDs[i].bTransparent == false)
+		{
+			textureSlots.push_back(i);
+		}
+	}
+
+	std::vector<SCENE_OBJECT> sceneObjects;
+	sceneObjects.swap(m_sceneObjects);
+	GLuint timerQuery = 0;
+	glGenQueries(1, &timerQuery);
+	std::cout << "INFO: Submission benchmark, " << m_pDrawRecorder->GetThreadCount()
+		<< " recording threads" << std::endl;
+
+	for (int step = 0; step < COUNT_STEPS; step++)
+	{
+		// lay the objects out in rows going away from the origin
+		int objectCount = OBJECT_COUNTS[step];
+		int rowLength = (int)std::ceil(std::sqrt((double)objectCount));
+		m_sceneObjects.clear();
+		m_sceneObjects.reserve(objectCount);
+		for (int i = 0; i < objectCount; i++)
+		{
+			SCENE_OBJECT object = m_pendingObject;
+			object.mesh = meshes[i % MESH_CHOICES];
+			object.importedMesh = -1;
+			object.position = glm::vec3(
+				((i % rowLength) - rowLength * 0.5f) * 0.5f,
+				0.0f,
+				(i / rowLength) * -0.5f);
+			object.model = glm::translate(object.position) * glm::scale(glm::vec3(0.2f));
+			object.normalMatrix = glm::mat3(glm::transpose(glm::inverse(object.model)));
+			object.bUseTexture = (textureSlots.empty() == false) && ((i % 3) == 2);
+			object.textureSlot = (object.bUseTexture == true) ? textureSlots[(i / 3) % textureSlots.size()] : -1;
+			object.color = glm::vec4(
+				0.25f + 0.75f * ((i * 7) % 11) / 10.0f,
+				0.25f + 0.75f * ((i * 5) % 13) / 12.0f,
+				0.25f + 0.75f * ((i * 3) % 17) / 16.0f,
+				1.0f);
+			object.UVscale = glm::vec2(1.0f);
+			object.materialIndex = m_objectMaterials.empty() ? -1 : (int)((i / MESH_CHOICES) % m_objectMaterials.size());
+			object.streamCell = -1;
+			object.impostorGroup = -1;
+			FinishSceneObject(object);
+			m_sceneObjects.push_back(object);
+		}
+		SortSceneObjects();
+		PrecompileSceneVariants();
+
+		for (int mode = 0; mode < MODE_COUNT; mode++)
+		{
+			m_bUseRecordedDraws = (mode == 1);
+
+			for (int frame = 0; frame < WARMUP_FRAMES; frame++)
+			{
+				glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+				RenderScene();
+				glFinish();
+				if (m_pShaderVariants->IsCompiling() == false)
+				{
+					break;
+				}
+			}
+
+			double gpuTime = 0.0;
+			double cpuTime = 0.0;
+			double recordTime = 0.0;
+			for (int frame = 0; frame < BENCHMARK_FRAMES; frame++)
+			{
+				glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+				std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+				glBeginQuery(GL_TIME_ELAPSED, timerQuery);
+				RenderScene();
+				glEndQuery(GL_TIME_ELAPSED);
+				cpuTime += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+				if (m_bUseRecordedDraws == true)
+				{
+					recordTime += m_pDrawRecorder->GetRecordTime();
+				}
+
+				GLuint64 elapsed = 0;
+				glGetQueryObjectui64v(timerQuery, GL_QUERY_RESULT, &elapsed);
+				gpuTime += elapsed / 1.0e6;
+			}
+
+			std::cout << "INFO: Submission, " << objectCount << " objects, " << modeNames[mode]
+				<< ", GPU: " << gpuTime / BENCHMARK_FRAMES << " ms"
+				<< ", CPU: " << cpuTime / BENCHMARK_FRAMES << " ms";
+			if (m_bUseRecordedDraws == true)
+			{
+				std::cout << ", recording: " << recordTime / BENCHMARK_FRAMES << " ms, "
+					<< m_pDrawRecorder->GetRunCount() << " runs";
+			}
+			std::cout << std::endl;
+		}
+	}
+
+	glDeleteQueries(1, &timerQuery);
+
+	m_sceneObjects.swap(sceneObjects);
+	m_bUseRecordedDraws = true;
+	SortSceneObjects();
+	InvalidateScene();
+}
+
+/***********************************************************
+ *  DefineSceneObjects()
+ *
+ *  This method is used for defining the objects in the 3D
+ *  scene by transforming the basic 3D shapes.
+ ***********************************************************/
+void SceneManager::DefineSceneObjects()
 {
 	// declare the variables for the transformations
 	glm::vec3 scaleXYZ;
@@ -598,14 +4834,14 @@ void SceneManager::RenderScene()
 		ZrotationDegrees,
 		positionXYZ);
 
-	//SetShaderColor(0.0f, 0.5f, 0.4f, 1.0f); // Dark forest green/teal color for the desk surface
+	//SetObjectColor(0.0f, 0.5f, 0.4f, 1.0f); // Dark forest green/teal color for the desk surface
 
-	SetShaderTexture("Desk");
+	SetObjectTexture("Desk");
 	SetTextureUVScale(1.0, 1.0);
-	SetShaderMaterial("wood");
+	SetObjectMaterial("wood");
 	
 	// Draw the mesh with transformation values
-	m_basicMeshes->DrawPlaneMesh();
+	AddSceneObject(MESH_PLANE);
 	/****************************************************************/
 	/******************************************************************/
 	// Desk Side L
@@ -627,14 +4863,14 @@ void SceneManager::RenderScene()
 		ZrotationDegrees,
 		positionXYZ);
 
-	//SetShaderColor(0.0f, 0.5f, 0.4f, 1.0f); // Dark forest green/teal color for the desk surface
+	//SetObjectColor(0.0f, 0.5f, 0.4f, 1.0f); // Dark forest green/teal color for the desk surface
 
-	SetShaderTexture("Desk");
+	SetObjectTexture("Desk");
 	SetTextureUVScale(1.0, 1.0);
-	SetShaderMaterial("wood");
+	SetObjectMaterial("wood");
 
 	// Draw the mesh with transformation values
-	m_basicMeshes->DrawBoxMesh();
+	AddSceneObject(MESH_BOX);
 	/****************************************************************/
 	/******************************************************************/
 	// Desk Side R
@@ -656,14 +4892,14 @@ void SceneManager::RenderScene()
 		ZrotationDegrees,
 		positionXYZ);
 
-	//SetShaderColor(0.0f, 0.5f, 0.4f, 1.0f); // Dark forest green/teal color for the desk surface
+	//SetObjectColor(0.0f, 0.5f, 0.4f, 1.0f); // Dark forest green/teal color for the desk surface
 
-	SetShaderTexture("Desk");
+	SetObjectTexture("Desk");
 	SetTextureUVScale(1.0, 1.0);
-	SetShaderMaterial("wood");
+	SetObjectMaterial("wood");
 
 	// Draw the mesh with transformation values
-	m_basicMeshes->DrawBoxMesh();
+	AddSceneObject(MESH_BOX);
 	/****************************************************************/
 	/******************************************************************/
 	// Desk Side BackBoard
@@ -685,14 +4921,14 @@ void SceneManager::RenderScene()
 		ZrotationDegrees,
 		positionXYZ);
 
-	//SetShaderColor(0.0f, 0.5f, 0.4f, 1.0f); // Dark forest green/teal color for the desk surface
+	//SetObjectColor(0.0f, 0.5f, 0.4f, 1.0f); // Dark forest green/teal color for the desk surface
 
-	SetShaderTexture("Desk");
+	SetObjectTexture("Desk");
 	SetTextureUVScale(1.0, 1.0);
-	SetShaderMaterial("wood");
+	SetObjectMaterial("wood");
 
 	// Draw the mesh with transformation values
-	m_basicMeshes->DrawBoxMesh();
+	AddSceneObject(MESH_BOX);
 	/****************************************************************/
 	/****************************************************************/
 	// Base of the Laptop
@@ -714,13 +4950,13 @@ void SceneManager::RenderScene()
 		ZrotationDegrees,
 		positionXYZ);
 
-	//SetShaderColor(1.0f, 0.75f, 0.8f, 1.0f); // Pink color for the laptop base
+	//SetObjectColor(1.0f, 0.75f, 0.8f, 1.0f); // Pink color for the laptop base
 
-	SetShaderTexture("Body");
+	SetObjectTexture("Body");
 	SetTextureUVScale(1.0, 1.0);
 
 	// Draw the mesh with transformation values
-	m_basicMeshes->DrawBoxMesh();
+	AddSceneObject(MESH_BOX);
 	/****************************************************************/
 	/****************************************************************/
 	// Keyboard base
@@ -742,11 +4978,11 @@ void SceneManager::RenderScene()
 		ZrotationDegrees,
 		positionXYZ);
 
-	//SetShaderColor(2.0f, 2.75f, 0.8f, 2.0f); // Pink color for the laptop base
-	SetShaderTexture("Base");
+	//SetObjectColor(2.0f, 2.75f, 0.8f, 2.0f); // Pink color for the laptop base
+	SetObjectTexture("Base");
 	SetTextureUVScale(1.0, 1.0);
 	// Draw the mesh with transformation values
-	m_basicMeshes->DrawPlaneMesh();
+	AddSceneObject(MESH_PLANE, "Keyboard");
 	/****************************************************************/
 	// Screen of the Laptop (base)
 	scaleXYZ = glm::vec3(12.0f, 8.0f, 0.1f); // Width, height, depth
@@ -767,13 +5003,13 @@ void SceneManager::RenderScene()
 		ZrotationDegrees,
 		positionXYZ);
 
-	//SetShaderColor(1.0f, 0.75f, 0.8f, 1.0f); // Pink color for the laptop screen
+	//SetObjectColor(1.0f, 0.75f, 0.8f, 1.0f); // Pink color for the laptop screen
 
-	SetShaderTexture("Body");
+	SetObjectTexture("Body");
 	SetTextureUVScale(1.0, 1.0);
 
 	// Draw the mesh with transformation values
-	m_basicMeshes->DrawBoxMesh();
+	AddSceneObject(MESH_BOX);
 	/****************************************************************/
 	/****************************************************************/
 	// Desktop Screen
@@ -795,11 +5031,11 @@ void SceneManager::RenderScene()
 		ZrotationDegrees,
 		positionXYZ);
 
-	//SetShaderColor(1.0f, 0.75f, 0.8f, 1.0f); // Pink color for the laptop screen
-	SetShaderTexture("Screen");
+	//SetObjectColor(1.0f, 0.75f, 0.8f, 1.0f); // Pink color for the laptop screen
+	SetObjectTexture("Screen");
 	SetTextureUVScale(1.0, 1.0);
 	// Draw the mesh with transformation values
-	m_basicMeshes->DrawBoxMesh();
+	AddSceneObject(MESH_BOX);
 	/****************************************************************/
 	// Frog planter body
 	scaleXYZ = glm::vec3(2.3f, 2.0f, 2.0f);
@@ -821,13 +5057,13 @@ void SceneManager::RenderScene()
 		positionXYZ);
 
 	// set the color values into the shader
-	//SetShaderColor(0.2745f, 1.0f, 0.4392f, 1.0f); // Green color for frog body
-	SetShaderTexture("Frog");
+	//SetObjectColor(0.2745f, 1.0f, 0.4392f, 1.0f); // Green color for frog body
+	SetObjectTexture("Frog");
 	SetTextureUVScale(1.0, 1.0);
-	SetShaderMaterial("glass");
+	SetObjectMaterial("glass");
 
 	// draw the mesh with transformation values
-	m_basicMeshes->DrawCylinderMesh();
+	AddSceneObject(MESH_CYLINDER);
 	/****************************************************************/
 	// Left Eye
 	scaleXYZ = glm::vec3(0.3f, 0.3f, 0.3f);
@@ -849,14 +5085,14 @@ void SceneManager::RenderScene()
 		positionXYZ);
 
 	// set the color values into the shader
-	//ShaderColor(0.2745f, 1.0f, 0.4392f, 1.0f); // Same green color for continuity
+	//SetObjectColor(0.2745f, 1.0f, 0.4392f, 1.0f); // Same green color for continuity
 
 
-	SetShaderTexture("Frog");
+	SetObjectTexture("Frog");
 	SetTextureUVScale(1.0, 1.0);
 
 	// draw the mesh with transformation values
-	m_basicMeshes->DrawSphereMesh();
+	AddSceneObject(MESH_SPHERE);
 	/****************************************************************/
 	// Right Eye
 	scaleXYZ = glm::vec3(0.3f, 0.3f, 0.3f);
@@ -878,13 +5114,13 @@ void SceneManager::RenderScene()
 		positionXYZ);
 
 	// set the color values into the shader
-	//SetShaderColor(0.2745f, 1.0f, 0.4392f, 1.0f); // Same green color for continuity
+	//SetObjectColor(0.2745f, 1.0f, 0.4392f, 1.0f); // Same green color for continuity
 
-	SetShaderTexture("Frog");
+	SetObjectTexture("Frog");
 	SetTextureUVScale(1.0, 1.0);
 
 	// draw the mesh with transformation values
-	m_basicMeshes->DrawSphereMesh();
+	AddSceneObject(MESH_SPHERE);
 	/****************************************************************/
 	// Left Eye Pupil
 	scaleXYZ = glm::vec3(0.15f, 0.15f, -0.1f);
@@ -906,10 +5142,10 @@ void SceneManager::RenderScene()
 		positionXYZ);
 
 	// set the color values into the shader
-	SetShaderColor(0.0f, 0.0f, 0.0f, 1.0f); // Black (for pupils)
+	SetObjectColor(0.0f, 0.0f, 0.0f, 1.0f); // Black (for pupils)
 
 	// draw the mesh with transformation values
-	m_basicMeshes->DrawSphereMesh();
+	AddSceneObject(MESH_SPHERE);
 	/****************************************************************/
 	// Right Eye Pupil
 	scaleXYZ = glm::vec3(0.15f, 0.15f, -0.1f);
@@ -931,10 +5167,10 @@ void SceneManager::RenderScene()
 		positionXYZ);
 
 	// set the color values into the shader
-	SetShaderColor(0.0f, 0.0f, 0.0f, 1.0f); //Black(for pupils)
+	SetObjectColor(0.0f, 0.0f, 0.0f, 1.0f); //Black(for pupils)
 
 	// draw the mesh with transformation values
-	m_basicMeshes->DrawSphereMesh();
+	AddSceneObject(MESH_SPHERE);
 	/****************************************************************/
 	// Left Blush
 	scaleXYZ = glm::vec3(0.5f, 0.5f, 0.1f);
@@ -956,10 +5192,10 @@ void SceneManager::RenderScene()
 		positionXYZ);
 
 	// set the color values into the shader
-	SetShaderColor(1.0f, 0.8f, 0.8f, 1.0f);
+	SetObjectColor(1.0f, 0.8f, 0.8f, 1.0f);
 
 	// draw the mesh with transformation values
-	m_basicMeshes->DrawSphereMesh();
+	AddSceneObject(MESH_SPHERE);
 	/****************************************************************/
 	// Right Blush
 	scaleXYZ = glm::vec3(0.5f, 0.5f, 0.1f);
@@ -981,10 +5217,10 @@ void SceneManager::RenderScene()
 		positionXYZ);
 
 	// set the color values into the shader
-	SetShaderColor(1.0f, 0.8f, 0.8f, 1.0f);
+	SetObjectColor(1.0f, 0.8f, 0.8f, 1.0f);
 
 	// draw the mesh with transformation values
-	m_basicMeshes->DrawSphereMesh();
+	AddSceneObject(MESH_SPHERE);
 	/****************************************************************/
 	/****************************************************************/
 	// Red Bull Can
@@ -1007,12 +5243,12 @@ void SceneManager::RenderScene()
 		positionXYZ);
 
 	// Set the color to match the Red Bull can
-	//SetShaderColor(0.65f, 0.16f, 0.16f, 1.0f); // Red color for the can
-	SetShaderTexture("Can");
+	//SetObjectColor(0.65f, 0.16f, 0.16f, 1.0f); // Red color for the can
+	SetObjectTexture("Can");
 	SetTextureUVScale(1.0, 1.0);
-	SetShaderMaterial("aluminum");
+	SetObjectMaterial("aluminum");
 	// Draw the mesh with transformation values
-	m_basicMeshes->DrawCylinderMesh();
+	AddSceneObject(MESH_CYLINDER);
 	/****************************************************************/
 	/****************************************************************/
 	//Red bull top
@@ -1035,12 +5271,12 @@ void SceneManager::RenderScene()
 		positionXYZ);
 
 	// Set the color to match the Red Bull can (or adjust as needed)
-	//SetShaderColor(0.65f, 0.16f, 0.16f, 1.0f); // Red color for the can
-	SetShaderTexture("Top");
+	//SetObjectColor(0.65f, 0.16f, 0.16f, 1.0f); // Red color for the can
+	SetObjectTexture("Top");
 	SetTextureUVScale(1.0, 1.0);
-	SetShaderMaterial("aluminum");
+	SetObjectMaterial("aluminum");
 	// Draw the mesh with transformation values
-	m_basicMeshes->DrawCylinderMesh();
+	AddSceneObject(MESH_CYLINDER);
 	/****************************************************************/
 
 	/****************************************************************/
@@ -1064,12 +5300,12 @@ void SceneManager::RenderScene()
 		positionXYZ);
 
 	// set the color values into the shader
-	//SetShaderColor(1.0f, 0.75f, 0.8f, 1.0f); // Pink color for headband
-	SetShaderTexture("Headphone");
+	//SetObjectColor(1.0f, 0.75f, 0.8f, 1.0f); // Pink color for headband
+	SetObjectTexture("Headphone");
 	SetTextureUVScale(1.0, 1.0);
-	SetShaderMaterial("plastic");
+	SetObjectMaterial("plastic");
 	// draw the torus mesh with transformation values
-	m_basicMeshes->DrawHalfTorusMesh();
+	AddSceneObject(MESH_HALF_TORUS);
 	/****************************************************************/
 	/****************************************************************/
 	// Cat Ear (Left)
@@ -1092,12 +5328,12 @@ void SceneManager::RenderScene()
 		positionXYZ);
 
 	// set the color values into the shader
-	//SetShaderColor(1.0f, 0.75f, 0.8f, 1.0f); // Pink color for headband
-	SetShaderTexture("Headphone");
+	//SetObjectColor(1.0f, 0.75f, 0.8f, 1.0f); // Pink color for headband
+	SetObjectTexture("Headphone");
 	SetTextureUVScale(1.0, 1.0);
-	SetShaderMaterial("plastic");
+	SetObjectMaterial("plastic");
 	// draw the torus mesh with transformation values
-	m_basicMeshes->DrawConeMesh();
+	AddSceneObject(MESH_CONE);
 	/****************************************************************/
 	/****************************************************************/
 	// Headband cup (Left)
@@ -1120,12 +5356,12 @@ void SceneManager::RenderScene()
 		positionXYZ);
 
 	// set the color values into the shader
-	//SetShaderColor(1.0f, 0.75f, 0.8f, 1.0f); // Pink color for headband
-	SetShaderTexture("Headphone");
+	//SetObjectColor(1.0f, 0.75f, 0.8f, 1.0f); // Pink color for headband
+	SetObjectTexture("Headphone");
 	SetTextureUVScale(1.0, 1.0);
-	SetShaderMaterial("plastic");
+	SetObjectMaterial("plastic");
 	// draw the torus mesh with transformation values
-	m_basicMeshes->DrawHalfSphereMesh();
+	AddSceneObject(MESH_HALF_SPHERE);
 	/****************************************************************/
 	/****************************************************************/
 	// Cushion (Left)
@@ -1148,12 +5384,12 @@ void SceneManager::RenderScene()
 		positionXYZ);
 
 	// set the color values into the shader
-	//SetShaderColor(3.0f, 2.75f, 0.8f, 3.0f); // Pink color for headband
-	SetShaderTexture("Cushion");
+	//SetObjectColor(3.0f, 2.75f, 0.8f, 3.0f); // Pink color for headband
+	SetObjectTexture("Cushion");
 	SetTextureUVScale(1.0, 1.0);
-	SetShaderMaterial("cloth");
+	SetObjectMaterial("cloth");
 	// draw the torus mesh with transformation values
-	m_basicMeshes->DrawSphereMesh();
+	AddSceneObject(MESH_SPHERE);
 	/****************************************************************/
 	/****************************************************************/
 	// Cat Ear (Right Side)
@@ -1176,12 +5412,12 @@ void SceneManager::RenderScene()
 		positionXYZ);
 
 	// set the color values into the shader
-	//SetShaderColor(1.0f, 0.75f, 0.8f, 1.0f); // Pink color for ear
-	SetShaderTexture("Headphone");
+	//SetObjectColor(1.0f, 0.75f, 0.8f, 1.0f); // Pink color for ear
+	SetObjectTexture("Headphone");
 	SetTextureUVScale(1.0, 1.0);
-	SetShaderMaterial("plastic");
+	SetObjectMaterial("plastic");
 	// draw the cone mesh with transformation values
-	m_basicMeshes->DrawConeMesh();
+	AddSceneObject(MESH_CONE);
 	/****************************************************************/
 	/****************************************************************/
 	// Headband Cup (Right Side)
@@ -1204,12 +5440,12 @@ void SceneManager::RenderScene()
 		positionXYZ);
 
 	// set the color values into the shader
-	//SetShaderColor(1.0f, 0.75f, 0.8f, 1.0f); // Pink color for cup
-	SetShaderTexture("Headphone");
+	//SetObjectColor(1.0f, 0.75f, 0.8f, 1.0f); // Pink color for cup
+	SetObjectTexture("Headphone");
 	SetTextureUVScale(1.0, 1.0);
-	SetShaderMaterial("plastic");
+	SetObjectMaterial("plastic");
 	// draw the half sphere mesh with transformation values
-	m_basicMeshes->DrawHalfSphereMesh();
+	AddSceneObject(MESH_HALF_SPHERE);
 	/****************************************************************/
 	/****************************************************************/
 	// Cushion (Right Side)
@@ -1232,12 +5468,12 @@ void SceneManager::RenderScene()
 		positionXYZ);
 
 	// set the color values into the shader
-	//SetShaderColor(3.0f, 2.75f, 0.8f, 3.0f); // Adjusted color for cushion
-	SetShaderTexture("Cushion");
+	//SetObjectColor(3.0f, 2.75f, 0.8f, 3.0f); // Adjusted color for cushion
+	SetObjectTexture("Cushion");
 	SetTextureUVScale(1.0, 1.0);
-	SetShaderMaterial("cloth");
+	SetObjectMaterial("cloth");
 	// draw the sphere mesh with transformation values
-	m_basicMeshes->DrawSphereMesh();
+	AddSceneObject(MESH_SPHERE);
 	/****************************************************************/
 	/****************************************************************/
 	// Mousepad Surface
@@ -1255,10 +5491,10 @@ void SceneManager::RenderScene()
 	SetTransformations(scaleXYZ, XrotationDegrees, YrotationDegrees, ZrotationDegrees, positionXYZ);
 
 	// set the color values into the shader
-	SetShaderColor(0.1f, 0.1f, 0.1f, 1.0f); // Dark color for the mousepad
-	SetShaderMaterial("cloth");
+	SetObjectColor(0.1f, 0.1f, 0.1f, 1.0f); // Dark color for the mousepad
+	SetObjectMaterial("cloth");
 	// draw the box mesh for the mousepad surface
-	m_basicMeshes->DrawSphereMesh();
+	AddSceneObject(MESH_SPHERE);
 	/****************************************************************/
 	/****************************************************************/
 	// Wrist Rest
@@ -1276,10 +5512,10 @@ void SceneManager::RenderScene()
 	SetTransformations(scaleXYZ, XrotationDegrees, YrotationDegrees, ZrotationDegrees, positionXYZ);
 
 	// set the color values into the shader
-	SetShaderColor(0.1f, 0.1f, 0.1f, 1.0f); // Same dark color as the mousepad
-	SetShaderMaterial("cloth");
+	SetObjectColor(0.1f, 0.1f, 0.1f, 1.0f); // Same dark color as the mousepad
+	SetObjectMaterial("cloth");
 	// draw the cylinder mesh for the wrist rest
-	m_basicMeshes->DrawSphereMesh();
+	AddSceneObject(MESH_SPHERE);
 	/****************************************************************/
 	/****************************************************************/
 	// Mouse Body
@@ -1297,12 +5533,12 @@ void SceneManager::RenderScene()
 	SetTransformations(scaleXYZ, XrotationDegrees, YrotationDegrees, ZrotationDegrees, positionXYZ);
 
 	// set the color values into the shader
-	//SetShaderColor(3.0f, 2.75f, 0.8f, 3.0f); // Slightly lighter black for the mouse
-	SetShaderTexture("Mouse");
+	//SetObjectColor(3.0f, 2.75f, 0.8f, 3.0f); // Slightly lighter black for the mouse
+	SetObjectTexture("Mouse");
 	SetTextureUVScale(1.0, 1.0);
-	SetShaderMaterial("plastic");
+	SetObjectMaterial("plastic");
 	// draw the half-sphere mesh for the mouse body
-	m_basicMeshes->DrawHalfSphereMesh();
+	AddSceneObject(MESH_HALF_SPHERE, "Mouse");
 	/****************************************************************/
 	/****************************************************************/
 	// Mouse Buttons
@@ -1320,12 +5556,12 @@ void SceneManager::RenderScene()
 	SetTransformations(scaleXYZ, XrotationDegrees, YrotationDegrees, ZrotationDegrees, positionXYZ);
 
 	// set the color values into the shader
-	//SetShaderColor(0.0f, 0.0f, 0.0f, 1.0f); // Dark color for the buttons
-	SetShaderTexture("Buttons");
+	//SetObjectColor(0.0f, 0.0f, 0.0f, 1.0f); // Dark color for the buttons
+	SetObjectTexture("Buttons");
 	SetTextureUVScale(1.0, 1.0);
-	SetShaderMaterial("plastic");
+	SetObjectMaterial("plastic");
 	// draw the box mesh for the mouse buttons
-	m_basicMeshes->DrawBoxMesh();
+	AddSceneObject(MESH_BOX);
 	/****************************************************************/
 	/****************************************************************/
 	// Mouse Scroll Wheel
@@ -1343,11 +5579,11 @@ void SceneManager::RenderScene()
 	SetTransformations(scaleXYZ, XrotationDegrees, YrotationDegrees, ZrotationDegrees, positionXYZ);
 
 	// set the color values into the shader
-	//SetShaderColor(0.0f, 0.0f, 0.0f, 1.0f); // Dark color for the scroll wheel
-	SetShaderTexture("Wheel");
+	//SetObjectColor(0.0f, 0.0f, 0.0f, 1.0f); // Dark color for the scroll wheel
+	SetObjectTexture("Wheel");
 	SetTextureUVScale(2.0, 2.0);
-	SetShaderMaterial("plastic");
+	SetObjectMaterial("plastic");
 	// draw the cylinder mesh for the scroll wheel
-	m_basicMeshes->DrawHalfSphereMesh();
+	AddSceneObject(MESH_HALF_SPHERE);
 	/****************************************************************/	
 }
@@ -9,9 +9,27 @@
 
 #pragma once
 
+#include "AssetWatcher.h"
+#include "ClusteredLighting.h"
+#include "DeferredRenderer.h"
+#include "DrawRecorder.h"
+#include "ImpostorAtlas.h"
+#include "LightBaker.h"
+#include "MeshImporter.h"
+#include "PrimitiveMeshes.h"
+#include "RayTracer.h"
+#include "SceneFile.h"
+#include "ScenePicker.h"
+#include "SceneStreamer.h"
 #include "ShaderManager.h"
+#include "ShaderVariantCache.h"
 #include "ShapeMeshes.h"
+#include "SoftwareRasterizer.h"
 
+#include <atomic>
+#include <future>
+#include <map>
+#include <memory>
 #include <string>
 #include <vector>
 
@@ -34,6 +52,30 @@ public:
 	{
 		std::string tag;
 		uint32_t ID;
+		// image file the texture was loaded from
+		std::string filename;
+		// true when the image has pixels that are not fully opaque
+		bool bTransparent;
+		// average color of the image, for the light it reflects
+		glm::vec3 averageColor;
+		// true when the texture was loaded for streamed cells, and
+		// the number of loaded cells that use it.  the texture is
+		// freed when no cell uses it, leaving a slot with no tag
+		// to reuse
+		bool bStreamed;
+		int cellReferences;
+	};
+
+	// properties for imported mesh access
+	struct MESH_INFO
+	{
+		std::string tag;
+		MeshImporter::GPU_MESH mesh;
+		// true when the mesh was loaded for streamed cells, and the
+		// number of loaded cells that use it.  the mesh is freed when
+		// no cell uses it, leaving an entry with no tag to reuse
+		bool bStreamed;
+		int cellReferences;
 	};
 
 	// properties for object materials
@@ -47,20 +89,279 @@ public:
 		std::string tag;
 	};
 
+	// basic shape meshes that scene objects can be drawn with
+	enum MESH_TYPE
+	{
+		MESH_PLANE = 0,
+		MESH_BOX,
+		MESH_CYLINDER,
+		MESH_CONE,
+		MESH_SPHERE,
+		MESH_HALF_SPHERE,
+		MESH_TORUS,
+		MESH_HALF_TORUS,
+		// a mesh loaded from a model file
+		MESH_IMPORTED,
+		MESH_COUNT
+	};
+
+	// properties recorded for each object drawn in the scene
+	struct SCENE_OBJECT
+	{
+		MESH_TYPE mesh;
+		// index of the imported mesh, or -1 for a basic shape
+		int importedMesh;
+		glm::mat4 model;
+		glm::mat3 normalMatrix;
+		glm::vec3 position;
+		bool bUseTexture;
+		int textureSlot;
+		glm::vec4 color;
+		glm::vec2 UVscale;
+		int materialIndex;
+		bool bTransparent;
+		unsigned int variantKey;
+		// streamed cell the object belongs to, or -1
+		int streamCell;
+		// impostor group the object is drawn with when it is far
+		// away, or -1
+		int impostorGroup;
+	};
+
 private:
+	// pixels of a decoded texture image and the values found in
+	// them, ready to be given to OpenGL
+	struct TEXTURE_IMAGE
+	{
+		std::vector<unsigned char> pixels;
+		int width;
+		int height;
+		int colorChannels;
+		bool bTransparent;
+		glm::vec3 averageColor;
+	};
+
+	// kinds of files that are reloaded when they change
+	enum ASSET_TYPE
+	{
+		ASSET_TEXTURE = 0,
+		ASSET_SHADER,
+		ASSET_SCENE,
+		// a JSON layout, which is cooked into the scene file
+		ASSET_LAYOUT
+	};
+
+	// a changed file read on a worker thread, waiting for the
+	// start of a frame to replace what was loaded from it
+	struct RELOADED_ASSET
+	{
+		ASSET_TYPE type;
+		std::string filePath;
+		bool bLoaded;
+		TEXTURE_IMAGE image;
+		std::string vertexSource;
+		std::string fragmentSource;
+		std::unique_ptr<SceneFile> pSceneFile;
+	};
+
+	// a streamed cell that has been read and is being loaded over
+	// several frames
+	struct CELL_LOAD
+	{
+		int cell;
+		std::unique_ptr<SceneFile> pSceneFile;
+		// next texture and model file to load
+		size_t nextTexture;
+		size_t nextMesh;
+		// texture slots and imported meshes the cell holds a
+		// reference to
+		std::vector<int> textureSlots;
+		std::vector<int> meshIndices;
+	};
+
+	// a model file of a streamed cell read into system memory on
+	// a worker thread, waiting to be handed to OpenGL
+	struct STREAMED_MESH
+	{
+		std::string filePath;
+		bool bLoaded;
+		MeshImporter::MESH_DATA mesh;
+	};
+
 	// pointer to shader manager object
 	ShaderManager* m_pShaderManager;
 	// pointer to basic shapes object
 	ShapeMeshes* m_basicMeshes;
+	// pointer to the compile time sphere, cylinder, cone and torus
+	PrimitiveMeshes* m_pPrimitiveMeshes;
 	// total number of loaded textures
 	int m_loadedTextures;
 	// loaded textures info
 	TEXTURE_INFO m_textureIDs[16];
+	// loaded model files
+	MeshImporter* m_pMeshImporter;
+	std::vector<MESH_INFO> m_importedMeshes;
 	// defined object materials
 	std::vector<OBJECT_MATERIAL> m_objectMaterials;
+	// true when the scene contents have changed since the last render
+	std::atomic<bool> m_bSceneChanged;
+
+	// objects drawn in the scene
+	std::vector<SCENE_OBJECT> m_sceneObjects;
+	// the object being defined, which the Set methods below fill
+	// in and AddSceneObject() appends to the scene
+	SCENE_OBJECT m_pendingObject;
+	// indices of the opaque objects in the order they are drawn,
+	// grouped by shader variant
+	std::vector<int> m_opaqueDrawOrder;
+	// indices of the transparent objects, drawn back to front
+	std::vector<int> m_transparentDrawOrder;
+
+	// scene light sources and general ambient light
+	std::vector<LIGHT_SOURCE> m_lightSources;
+	glm::vec3 m_ambientLightColor;
+	float m_ambientLightIntensity;
+	bool m_bUseLighting;
+
+	// view and projection for the frame being rendered
+	glm::mat4 m_viewMatrix;
+	glm::mat4 m_projectionMatrix;
+	glm::vec3 m_viewPosition;
+	// height in pixels of the viewport being rendered
+	int m_viewportHeight;
+
+	// views shown in the four quarters of the viewport, in place of
+	// the camera view, while the quad view is on
+	bool m_bQuadView;
+	glm::mat4 m_quadViewMatrices[ShaderVariantCache::MULTI_VIEW_COUNT];
+	glm::mat4 m_quadProjectionMatrices[ShaderVariantCache::MULTI_VIEW_COUNT];
+	glm::vec3 m_quadViewPositions[ShaderVariantCache::MULTI_VIEW_COUNT];
+	// true while all of the quad views are drawn in one pass
+	bool m_bDrawingQuadViews;
+	// true when the quad views are drawn one after another even
+	// though the driver can draw them in one pass
+	bool m_bSeparateQuadViews;
+
+	// specialized shader programs for each combination of features
+	ShaderVariantCache* m_pShaderVariants;
+	// true when the scene is drawn with the shader variants instead
+	// of the single program in the shader manager
+	bool m_bUseShaderVariants;
+
+	// light cluster grid for shading with many lights
+	ClusteredLighting* m_pClusteredLighting;
+	// true when the variants read the lights from the cluster grid
+	// instead of looping over a fixed number of light uniforms
+	bool m_bUseClusteredLighting;
+
+	// G-buffer and tiled lighting pass for deferred shading
+	DeferredRenderer* m_pDeferredRenderer;
+	// true when the opaque objects are lit by the deferred pass
+	// instead of in their own fragment shaders
+	bool m_bUseDeferredShading;
+
+	// light probe volume baked from the static objects and lights
+	LightBaker* m_pLightBaker;
+	// true when the variants read the light from the baked probes
+	// instead of applying the light sources
+	bool m_bUseBakedLighting;
+	// true when the lighting is baked again rather than loaded
+	// from the cooked file
+	bool m_bBakeLighting;
+
+	// distant groups of static objects drawn as single quads
+	ImpostorAtlas* m_pImpostors;
+	// true when the impostors have been baked or loaded for the
+	// current objects
+	bool m_bUseImpostors;
+	// true when the impostors are baked again rather than loaded
+	// from the cooked file
+	bool m_bBakeImpostors;
+	// groups drawn as impostors in the frame being rendered, and
+	// whether each group is one of them
+	std::vector<int> m_distantGroups;
+	std::vector<char> m_groupIsDistant;
+
+	// hierarchies over the objects and their meshes for picking
+	ScenePicker* m_pScenePicker;
+	// picker mesh of each basic shape and imported mesh, by the
+	// mesh type, or MESH_COUNT plus the imported mesh index
+	std::map<int, int> m_pickMeshes;
+	// true when the objects have changed since they were last
+	// handed to the picker
+	bool m_bPickerChanged;
+
+	// CPU rasterizer that draws the scene in place of OpenGL
+	SoftwareRasterizer* m_pSoftwareRasterizer;
+	// true when the scene is drawn by the software rasterizer
+	bool m_bUseSoftwareRasterizer;
+	// software rasterizer mesh of each basic shape and imported
+	// mesh, by the same keys as the picker meshes
+	std::map<int, int> m_softwareMeshes;
+	// software rasterizer texture of each texture slot, or -1 when
+	// it has not been read back yet
+	int m_softwareTextures[16];
+
+	// records the opaque basic shapes on worker threads, and draws
+	// them as instanced runs
+	DrawRecorder* m_pDrawRecorder;
+	// true when the opaque basic shapes are drawn from records
+	bool m_bUseRecordedDraws;
+	// recorder mesh of each basic shape, or -1
+	int m_recordedMeshes[MESH_IMPORTED];
+	// the opaque basic shapes, sorted by the state they are drawn
+	// with so the runs are as long as possible
+	std::vector<int> m_recordedDrawOrder;
+
+	// cooked scene file that replaces the built in scene when it
+	// can be loaded
+	std::string m_sceneFilePath;
+
+	// watches the loaded texture, shader and scene files
+	AssetWatcher* m_pAssetWatcher;
+	// changed files being read on worker threads
+	std::vector<std::future<RELOADED_ASSET>> m_assetReloads;
+	// a changed scene file waiting for the textures and model
+	// files it adds to be read on worker threads, with their tags
+	std::unique_ptr<SceneFile> m_pReloadedSceneFile;
+	std::vector<std::future<RELOADED_ASSET>> m_sceneTextureReads;
+	std::vector<std::string> m_sceneTextureTags;
+	std::vector<std::future<STREAMED_MESH>> m_sceneMeshReads;
+	std::vector<std::string> m_sceneMeshTags;
+
+	// cells of a large scene read in around the camera
+	SceneStreamer* m_pSceneStreamer;
+	// cooked cell index, when the scene is streamed
+	std::string m_streamIndexPath;
+	// cells that are being loaded
+	std::vector<CELL_LOAD> m_cellLoads;
+	// texture slots and imported meshes held by each loaded cell
+	std::map<int, std::vector<int>> m_cellTextures;
+	std::map<int, std::vector<int>> m_cellMeshes;
+	// images and model files of the cells being read on worker
+	// threads, by tag, so cells that share one read it once.  the
+	// cells do not own the reads, so dropping a cell never waits
+	// for one to finish
+	std::map<std::string, std::shared_future<RELOADED_ASSET>> m_textureReads;
+	std::map<std::string, std::shared_future<STREAMED_MESH>> m_meshReads;
+	// camera position and time of the last streaming update, and
+	// the smoothed camera velocity
+	glm::vec3 m_streamViewPosition;
+	double m_streamTime;
+	glm::vec3 m_streamVelocity;
 
 	// load texture images and convert to OpenGL texture data
 	bool CreateGLTexture(const char* filename, std::string tag);
+	// read an image file and check its pixels, without OpenGL
+	static bool DecodeTextureImage(const char* filename, TEXTURE_IMAGE& image);
+	// create an OpenGL texture from a decoded image in the next
+	// available texture slot
+	bool AddGLTexture(const char* filename, std::string tag, const TEXTURE_IMAGE& image);
+	// get the slot the next texture is loaded into, or -1 when
+	// all of them are used
+	int GetFreeTextureSlot();
+	// fill an OpenGL texture with a decoded image
+	static bool UploadTextureImage(GLuint textureID, const TEXTURE_IMAGE& image);
 	// bind loaded OpenGL textures to slots in memory
 	void BindGLTextures();
 	// free the loaded OpenGL textures
@@ -68,11 +369,20 @@ private:
 	// find a loaded texture by tag
 	int FindTextureID(std::string tag);
 	int FindTextureSlot(std::string tag);
+	// load a model file into an imported mesh
+	bool LoadImportedMesh(const char* filename, std::string tag);
+	// add a loaded mesh with its tag, returning its index
+	int AddImportedMesh(const MeshImporter::GPU_MESH& mesh, std::string tag);
+	// free the loaded imported meshes
+	void DestroyImportedMeshes();
+	// find a loaded imported mesh by tag
+	int FindImportedMesh(std::string tag);
 	// find a defined material by tag
 	bool FindMaterial(std::string tag, OBJECT_MATERIAL& material);
+	int FindMaterialIndex(std::string tag);
 
 	// set the transformation values 
-	// into the transform buffer
+	// for the next scene object
 	void SetTransformations(
 		glm::vec3 scaleXYZ,
 		float XrotationDegrees,
@@ -80,25 +390,159 @@ private:
 		float ZrotationDegrees,
 		glm::vec3 positionXYZ);
 
-	// set the color values into the shader
-	void SetShaderColor(
+	// set the color values for the next scene object
+	void SetObjectColor(
 		float redColorValue,
 		float greenColorValue,
 		float blueColorValue,
 		float alphaValue);
 
-	// set the texture data into the shader
-	void SetShaderTexture(
+	// set the texture for the next scene object
+	void SetObjectTexture(
 		std::string textureTag);
 
 	// set the UV scale for the texture mapping
 	void SetTextureUVScale(
 		float u, float v);
 
-	// set the object material into the shader
-	void SetShaderMaterial(
+	// set the material for the next scene object
+	void SetObjectMaterial(
 		std::string materialTag);
 
+	// add the next scene object, drawn with the passed in mesh
+	void AddSceneObject(MESH_TYPE mesh);
+	// add the next scene object, drawn with an imported mesh fitted
+	// into the space of the basic shape, or with the basic shape
+	// when the mesh was not loaded
+	void AddSceneObject(MESH_TYPE mesh, std::string importedMeshTag);
+	// set the transparency and shader variant of a new object
+	void FinishSceneObject(SCENE_OBJECT& object) const;
+	// load the textures, model files and materials of a scene file
+	void LoadSceneFileAssets(const SceneFile& sceneFile);
+	// replace the materials with those of a scene file
+	void LoadSceneFileMaterials(const SceneFile& sceneFile);
+	// add the objects of a scene file after its assets are loaded,
+	// marked with the streamed cell they belong to or -1
+	void AddSceneFileObjects(const SceneFile& sceneFile, int streamCell);
+	// add the materials of a scene file that are not defined yet
+	void MergeSceneFileMaterials(const SceneFile& sceneFile);
+	// hand the object materials to the deferred lighting pass
+	void UpdateDeferredMaterials();
+	// get the cheapest shader variant that can draw an object
+	unsigned int GetVariantKey(const SCENE_OBJECT& object) const;
+	// sort the scene objects into their drawing order
+	void SortSceneObjects();
+	// start building the shader variants the scene objects use
+	void PrecompileSceneVariants();
+	// pick the variants again after the lights have changed
+	void UpdateVariantKeys();
+
+	// sort the transparent objects from back to front
+	void SortTransparentObjects();
+	// draw the scene from the current view into the viewport
+	void RenderSceneView();
+	// draw the scene from each of the quad views into a quarter
+	// of the viewport
+	void RenderQuadViews();
+	// check whether an object's bounds reach into any quad view
+	bool IsInQuadViews(const SCENE_OBJECT& object) const;
+	// draw the scene from the current view with the software
+	// rasterizer and copy it into the viewport
+	void RenderSoftwareView();
+	// get the software rasterizer mesh an object is drawn with,
+	// adding it the first time
+	int GetSoftwareMesh(const SCENE_OBJECT& object);
+	// get the software rasterizer texture of a texture slot,
+	// reading it back from OpenGL the first time
+	int GetSoftwareTexture(int textureSlot);
+	// read the RGBA pixels of the texture in a texture slot
+	bool ReadTexturePixels(
+		int textureSlot,
+		std::vector<unsigned char>& pixels,
+		int& width,
+		int& height);
+
+	// set the view, projection and light values into the shader
+	void SetFrameUniforms();
+	// set the properties of one scene object into the shader
+	void SetObjectUniforms(const SCENE_OBJECT& object);
+	// set the values of a material into the shader
+	void SetMaterialUniforms(int materialIndex);
+	// record the opaque basic shapes and draw their runs,
+	// returning false when they are drawn one at a time instead
+	bool DrawRecordedObjects();
+	// draw the opaque objects into the G-buffer and light them
+	void DrawDeferredObjects();
+	// bake or load the light probes for the scene objects
+	bool PrepareBakedLighting();
+	// get the world space bounds of a scene object
+	void GetObjectBounds(const SCENE_OBJECT& object, glm::vec3& boundsMin, glm::vec3& boundsMax) const;
+	// group the static objects and bake or load their impostors
+	bool PrepareImpostors();
+	// render every group from each frame direction into the atlas
+	void BakeImpostors();
+	// choose the groups drawn as impostors from the current view
+	void FindDistantGroups();
+	// check whether an object is left out for its group's impostor
+	bool IsDrawnAsImpostor(const SCENE_OBJECT& object) const;
+	// get the key of the mesh an object is drawn with, the mesh
+	// type or MESH_COUNT plus the imported mesh index, or -1
+	int GetMeshKey(const SCENE_OBJECT& object) const;
+	// copy the vertices and triangles of the mesh an object is
+	// drawn with, reading an imported mesh back from its buffers
+	bool ReadObjectMesh(
+		const SCENE_OBJECT& object,
+		std::vector<MeshImporter::MESH_VERTEX>& vertices,
+		std::vector<unsigned int>& indices);
+	// get the picker mesh an object is drawn with, adding it the
+	// first time
+	int GetPickMesh(const SCENE_OBJECT& object);
+	// hand the objects to the picker when they have changed
+	void UpdatePicker();
+	// draw the basic shape or imported mesh for a scene object
+	void DrawObjectMesh(const SCENE_OBJECT& object);
+	// pick the detail level an imported mesh is drawn with
+	int SelectMeshLOD(const SCENE_OBJECT& object, const MeshImporter::GPU_MESH& mesh) const;
+
+	// start watching the files the scene was loaded from
+	void WatchSceneAssets();
+	// read a changed file on a worker thread
+	static RELOADED_ASSET ReadChangedAsset(ASSET_TYPE type, std::string filePath);
+	// start reading the changed files and replace the ones that
+	// have been read, between frames
+	void ApplyAssetReloads();
+	// replace a texture image in place
+	void ReloadTexture(const RELOADED_ASSET& asset);
+	// start reading the textures and model files a changed scene
+	// file adds or moves
+	void BeginSceneReload(std::unique_ptr<SceneFile> pSceneFile);
+	// load what the changed scene file added and replace the scene
+	// with it, once all of it has been read
+	bool FinishSceneReload();
+	// replace the materials and objects with a changed scene file
+	void ReloadSceneFile(const SceneFile& sceneFile);
+
+	// read in and load the cells around the camera, and unload
+	// the ones left behind
+	void UpdateStreaming();
+	// start loading a cell that has been read
+	void BeginCellLoad(int cell, std::unique_ptr<SceneFile> pSceneFile);
+	// load more of a cell within the upload budget of the frame,
+	// returning true once the cell is fully loaded
+	bool ContinueCellLoad(CELL_LOAD& load, long long& uploadBudget);
+	// remove the objects of cells and release their textures and
+	// meshes
+	void UnloadCells(const std::vector<int>& cells);
+	// release a streamed cell's reference to a texture
+	void ReleaseCellTexture(int textureSlot);
+	// release a streamed cell's reference to an imported mesh
+	void ReleaseCellMesh(int meshIndex);
+	// read a model file of a streamed cell on a worker thread
+	static STREAMED_MESH ReadStreamedMesh(const MeshImporter* pMeshImporter, std::string filePath);
+	// forget the images and model files that were read for cells
+	// which have since been unloaded
+	void DropUnusedReads();
+
 public:
 
 	// prepare the 3D scene for rendering
@@ -108,9 +552,81 @@ public:
 
 	// load all of the needed textures before rendering
 	void LoadSceneTextures();
+	// load all of the model files before rendering
+	void LoadSceneMeshes();
 	// define all the object materials before rendering
 	void DefineObjectMaterials();
 	// add and define the light sources before rendering
 	void SetupSceneLights();
+	// define all the objects drawn in the 3D scene
+	void DefineSceneObjects();
+
+	// set the view and projection used to render the next frame
+	void SetViewTransform(
+		const glm::mat4& view,
+		const glm::mat4& projection,
+		const glm::vec3& viewPosition);
+	// show four views at once, one in each quarter of the viewport,
+	// instead of the view set by SetViewTransform()
+	void SetQuadViews(
+		const glm::mat4* views,
+		const glm::mat4* projections,
+		const glm::vec3* viewPositions);
+	// go back to showing the single view
+	void ClearQuadViews();
+
+	// mark the scene contents as changed so a new frame is rendered
+	void InvalidateScene();
+	// check whether the scene has changed since the last render
+	bool IsRedrawNeeded() const;
+
+	// light the opaque objects with a deferred pass, which must
+	// be chosen before the scene is prepared
+	void SetDeferredShading(bool bEnable);
+	// bake the static lighting and save it, instead of loading the
+	// lighting baked on an earlier run, before the scene is prepared
+	void SetBakeLighting(bool bEnable);
+	// bake the impostors of the distant object groups and save
+	// them, instead of loading the ones baked on an earlier run,
+	// before the scene is prepared
+	void SetBakeImpostors(bool bEnable);
+	// set the cooked scene file loaded instead of the built in
+	// scene, before the scene is prepared
+	void SetSceneFile(const char* filePath);
+	// set the cooked cell index streamed in around the camera
+	// instead of loading a whole scene, before the scene is prepared
+	void SetStreamingIndex(const char* indexPath);
+	// draw the scene with the software rasterizer instead of
+	// OpenGL, before the scene is prepared
+	void SetSoftwareRendering(bool bEnable);
+	// draw the opaque basic shapes from draw lists recorded on
+	// worker threads, before the scene is prepared
+	void SetRecordedDraws(bool bEnable);
+
+	// find the closest scene object along a ray from the camera
+	// through a point of the viewport, from -1 to 1 on each side
+	// with 0, 0 at the crosshair in the middle
+	bool PickObject(float viewportX, float viewportY, ScenePicker::PICK_HIT& hit);
+	// find the closest scene object along a ray
+	bool CastPickRay(const ScenePicker::PICK_RAY& ray, ScenePicker::PICK_HIT& hit);
+	// find the closest scene object along each of many rays
+	void CastPickRays(const std::vector<ScenePicker::PICK_RAY>& rays, std::vector<ScenePicker::PICK_HIT>& hits);
+
+	// time the scene rendering with 1 to 1000 lights
+	void RunLightingBenchmark();
+	// time picking with single rays and with batches of rays
+	void RunPickingBenchmark();
+	// time the quad views drawn in one pass against drawing them
+	// one after another
+	void RunQuadViewBenchmark();
+	// time the scene drawn by OpenGL against the software
+	// rasterizer
+	void RunRasterizerBenchmark();
+	// ray trace the scene from the current view into an image file,
+	// adding up the passed in number of samples for every pixel
+	bool RenderRayTracedImage(const char* filePath, int sampleCount);
+	// time submitting 10 thousand to 1 million objects one at a time
+	// against recording them on worker threads
+	void RunSubmissionBenchmark();
 	
 };
\ No newline at end of file
@@ -0,0 +1,602 @@
+///////////////////////////////////////////////////////////////////////////////
+// scenepicker.cpp
+// ============
+// find the scene object along a ray, such as the one under the cursor,
+// with a hierarchy over the objects and one over each mesh's triangles
+//
+//  Created for CS-330-Computational Graphics and Visualization
+///////////////////////////////////////////////////////////////////////////////
+
+#include "ScenePicker.h"
+
+#include <algorithm>
+#include <cmath>
+#include <thread>
+
+// declaration of the global variables and defines
+namespace
+{
+	// deepest bounding volume hierarchy that can be traversed
+	const int MAX_TRAVERSAL_DEPTH = 64;
+	// most objects and triangles in a leaf node
+	const int OBJECT_LEAF_SIZE = 2;
+	const int TRIANGLE_LEAF_SIZE = 4;
+	// rays cast by a worker thread before it takes more
+	const int RAYS_PER_RUN = 64;
+	// smallest direction component, which keeps the inverse of a
+	// direction along an axis finite
+	const float MIN_DIRECTION = 1.0e-30f;
+
+	/***********************************************************
+	 *  GetInverseDirection()
+	 *
+	 *  This function is used to get the inverse of each part of
+	 *  a ray direction, for the slab tests of the bounds.
+	 ***********************************************************/
+	glm::vec3 GetInverseDirection(const glm::vec3& direction)
+	{
+		glm::vec3 inverse;
+		for (int axis = 0; axis < 3; axis++)
+		{
+			float value = direction[axis];
+			if (std::fabs(value) < MIN_DIRECTION)
+			{
+				value = (value < 0.0f) ? -MIN_DIRECTION : MIN_DIRECTION;
+			}
+			inverse[axis] = 1.0f / value;
+		}
+		return(inverse);
+	}
+
+	/***********************************************************
+	 *  IntersectBounds()
+	 *
+	 *  This function is used to get the distance a ray enters
+	 *  an axis aligned box, which is zero when it starts inside.
+	 *  Returns false when the ray misses the box before the
+	 *  maximum distance.
+	 ***********************************************************/
+	bool IntersectBounds(
+		const glm::vec3& origin,
+		const glm::vec3& inverseDirection,
+		const glm::vec3& boundsMin,
+		const glm::vec3& boundsMax,
+		float maxDistance,
+		float& distance)
+	{
+		glm::vec3 t0 = (boundsMin - origin) * inverseDirection;
+		glm::vec3 t1 = (boundsMax - origin) * inverseDirection;
+		glm::vec3 tNear = glm::min(t0, t1);
+		glm::vec3 tFar = glm::max(t0, t1);
+		float enter = std::max(std::max(tNear.x, tNear.y), std::max(tNear.z, 0.0f));
+		float exit = std::min(std::min(tFar.x, tFar.y), std::min(tFar.z, maxDistance));
+		distance = enter;
+		return(enter <= exit);
+	}
+
+	/***********************************************************
+	 *  IntersectTriangle()
+	 *
+	 *  This function is used to get the distance along a ray to
+	 *  a triangle, from either side.  Returns false when the
+	 *  ray misses it or reaches it after the maximum distance.
+	 ***********************************************************/
+	bool IntersectTriangle(
+		const glm::vec3& origin,
+		const glm::vec3& direction,
+		const glm::vec3& a,
+		const glm::vec3& b,
+		const glm::vec3& c,
+		float maxDistance,
+		float& distance)
+	{
+		glm::vec3 edge1 = b - a;
+		glm::vec3 edge2 = c - a;
+		glm::vec3 p = glm::cross(direction, edge2);
+		float determinant = glm::dot(edge1, p);
+		if (std::fabs(determinant) < 1.0e-20f)
+		{
+			return(false);
+		}
+
+		float inverseDeterminant = 1.0f / determinant;
+		glm::vec3 s = origin - a;
+		float u = glm::dot(s, p) * inverseDeterminant;
+		if ((u < 0.0f) || (u > 1.0f))
+		{
+			return(false);
+		}
+		glm::vec3 q = glm::cross(s, edge1);
+		float v = glm::dot(direction, q) * inverseDeterminant;
+		if ((v < 0.0f) || (u + v > 1.0f))
+		{
+			return(false);
+		}
+
+		float t = glm::dot(edge2, q) * inverseDeterminant;
+		if ((t < 0.0f) || (t >= maxDistance))
+		{
+			return(false);
+		}
+		distance = t;
+		return(true);
+	}
+}
+
+/***********************************************************
+ *  ScenePicker()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+ScenePicker::ScenePicker()
+{
+}
+
+/***********************************************************
+ *  ~ScenePicker()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+ScenePicker::~ScenePicker()
+{
+}
+
+/***********************************************************
+ *  AddMesh()
+ *
+ *  This method is used for adding the triangles of a mesh
+ *  and building the hierarchy over them.  The triangles are
+ *  stored in the order the leaves refer to them, so a leaf
+ *  reads one run of indices.
+ ***********************************************************/
+int ScenePicker::AddMesh(const std::vector<glm::vec3>& positions, const std::vector<unsigned int>& indices)
+{
+	int triangleCount = (int)(indices.size() / 3);
+	std::vector<glm::vec3> triangleMin(triangleCount);
+	std::vector<glm::vec3> triangleMax(triangleCount);
+	std::vector<int> order(triangleCount);
+	for (int i = 0; i < triangleCount; i++)
+	{
+		const glm::vec3& a = positions[indices[i * 3]];
+		const glm::vec3& b = positions[indices[i * 3 + 1]];
+		const glm::vec3& c = positions[indices[i * 3 + 2]];
+		triangleMin[i] = glm::min(a, glm::min(b, c));
+		triangleMax[i] = glm::max(a, glm::max(b, c));
+		order[i] = i;
+	}
+
+	PICK_MESH mesh;
+	mesh.positions = positions;
+	if (triangleCount > 0)
+	{
+		mesh.nodes.reserve(triangleCount * 2);
+		mesh.nodes.push_back(BVH_NODE());
+		BuildNode(triangleMin, triangleMax, order, mesh.nodes, 0, 0, triangleCount, TRIANGLE_LEAF_SIZE);
+	}
+	mesh.indices.resize(triangleCount * 3);
+	for (int i = 0; i < triangleCount; i++)
+	{
+		mesh.indices[i * 3] = indices[order[i] * 3];
+		mesh.indices[i * 3 + 1] = indices[order[i] * 3 + 1];
+		mesh.indices[i * 3 + 2] = indices[order[i] * 3 + 2];
+	}
+
+	// reuse the place of a removed mesh
+	for (size_t i = 0; i < m_meshes.size(); i++)
+	{
+		if (m_meshes[i].nodes.empty() == true)
+		{
+			m_meshes[i].positions.swap(mesh.positions);
+			m_meshes[i].indices.swap(mesh.indices);
+			m_meshes[i].nodes.swap(mesh.nodes);
+			return((int)i);
+		}
+	}
+	m_meshes.push_back(PICK_MESH());
+	m_meshes.back().positions.swap(mesh.positions);
+	m_meshes.back().indices.swap(mesh.indices);
+	m_meshes.back().nodes.swap(mesh.nodes);
+	return((int)m_meshes.size() - 1);
+}
+
+/***********************************************************
+ *  RemoveMesh()
+ *
+ *  This method is used for freeing the triangles of a mesh.
+ *  Objects still referring to it can no longer be picked,
+ *  and its place is reused by the next mesh added.
+ ***********************************************************/
+void ScenePicker::RemoveMesh(int mesh)
+{
+	if ((mesh < 0) || (mesh >= (int)m_meshes.size()))
+	{
+		return;
+	}
+	std::vector<glm::vec3>().swap(m_meshes[mesh].positions);
+	std::vector<unsigned int>().swap(m_meshes[mesh].indices);
+	std::vector<BVH_NODE>().swap(m_meshes[mesh].nodes);
+}
+
+/***********************************************************
+ *  SetObjects()
+ *
+ *  This method is used for setting the objects to pick and
+ *  building the hierarchy over their world space bounds.
+ *  Only the objects themselves are gone through, since the
+ *  hierarchies of their meshes are already built.
+ ***********************************************************/
+void ScenePicker::SetObjects(const std::vector<PICK_OBJECT>& objects)
+{
+	m_objects.clear();
+	m_objectOrder.clear();
+	m_nodes.clear();
+	m_objects.resize(objects.size());
+
+	std::vector<glm::vec3> objectMin;
+	std::vector<glm::vec3> objectMax;
+	for (size_t i = 0; i < objects.size(); i++)
+	{
+		TRACE_OBJECT& object = m_objects[i];
+		object.mesh = objects[i].mesh;
+		if ((object.mesh < 0) || (object.mesh >= (int)m_meshes.size()) ||
+			(m_meshes[object.mesh].nodes.empty() == true) ||
+			(glm::determinant(glm::mat3(objects[i].model)) == 0.0f))
+		{
+			object.mesh = -1;
+			continue;
+		}
+		object.worldToObject = glm::inverse(objects[i].model);
+
+		// the world bounds around the corners of the mesh bounds
+		const BVH_NODE& root = m_meshes[object.mesh].nodes[0];
+		for (int corner = 0; corner < 8; corner++)
+		{
+			glm::vec3 point(
+				((corner & 1) != 0) ? root.boundsMax.x : root.boundsMin.x,
+				((corner & 2) != 0) ? root.boundsMax.y : root.boundsMin.y,
+				((corner & 4) != 0) ? root.boundsMax.z : root.boundsMin.z);
+			point = glm::vec3(objects[i].model * glm::vec4(point, 1.0f));
+			object.boundsMin = (corner == 0) ? point : glm::min(object.boundsMin, point);
+			object.boundsMax = (corner == 0) ? point : glm::max(object.boundsMax, point);
+		}
+
+		m_objectOrder.push_back((int)i);
+		objectMin.push_back(object.boundsMin);
+		objectMax.push_back(object.boundsMax);
+	}
+	if (m_objectOrder.empty() == true)
+	{
+		return;
+	}
+
+	// the hierarchy is built over the pickable objects, then their
+	// positions in that list are turned back into object indices
+	std::vector<int> order(m_objectOrder.size());
+	for (size_t i = 0; i < order.size(); i++)
+	{
+		order[i] = (int)i;
+	}
+	m_nodes.reserve(order.size() * 2);
+	m_nodes.push_back(BVH_NODE());
+	BuildNode(objectMin, objectMax, order, m_nodes, 0, 0, (int)order.size(), OBJECT_LEAF_SIZE);
+	for (size_t i = 0; i < order.size(); i++)
+	{
+		order[i] = m_objectOrder[order[i]];
+	}
+	m_objectOrder.swap(order);
+}
+
+/***********************************************************
+ *  BuildNode()
+ *
+ *  This method is used for filling in a node around a run
+ *  of items.  Runs larger than a leaf are split in half
+ *  along the longest side of their centers, with both
+ *  children stored next to each other.
+ ***********************************************************/
+void ScenePicker::BuildNode(
+	const std::vector<glm::vec3>& itemMin,
+	const std::vector<glm::vec3>& itemMax,
+	std::vector<int>& order,
+	std::vector<BVH_NODE>& nodes,
+	int nodeIndex,
+	int first,
+	int count,
+	int leafSize)
+{
+	glm::vec3 boundsMin(1.0e30f);
+	glm::vec3 boundsMax(-1.0e30f);
+	glm::vec3 centerMin(1.0e30f);
+	glm::vec3 centerMax(-1.0e30f);
+	for (int i = first; i < first + count; i++)
+	{
+		boundsMin = glm::min(boundsMin, itemMin[order[i]]);
+		boundsMax = glm::max(boundsMax, itemMax[order[i]]);
+		glm::vec3 center = (itemMin[order[i]] + itemMax[order[i]]) * 0.5f;
+		centerMin = glm::min(centerMin, center);
+		centerMax = glm::max(centerMax, center);
+	}
+	nodes[nodeIndex].boundsMin = boundsMin;
+	nodes[nodeIndex].boundsMax = boundsMax;
+
+	if (count <= leafSize)
+	{
+		nodes[nodeIndex].first = first;
+		nodes[nodeIndex].itemCount = count;
+		return;
+	}
+
+	glm::vec3 centerExtent = centerMax - centerMin;
+	int axis = 0;
+	if (centerExtent.y > centerExtent[axis])
+	{
+		axis = 1;
+	}
+	if (centerExtent.z > centerExtent[axis])
+	{
+		axis = 2;
+	}
+
+	int half = count / 2;
+	std::nth_element(
+		order.begin() + first,
+		order.begin() + first + half,
+		order.begin() + first + count,
+		[&itemMin, &itemMax, axis](int a, int b)
+		{
+			return((itemMin[a][axis] + itemMax[a][axis]) < (itemMin[b][axis] + itemMax[b][axis]));
+		});
+
+	int leftChild = (int)nodes.size();
+	nodes.push_back(BVH_NODE());
+	nodes.push_back(BVH_NODE());
+	nodes[nodeIndex].first = leftChild;
+	nodes[nodeIndex].itemCount = 0;
+
+	BuildNode(itemMin, itemMax, order, nodes, leftChild, first, half, leafSize);
+	BuildNode(itemMin, itemMax, order, nodes, leftChild + 1, first + half, count - half, leafSize);
+}
+
+/***********************************************************
+ *  CastRay()
+ *
+ *  This method is used for finding the closest object along
+ *  a ray.  The nearer child of each node is visited first,
+ *  so once an object has been hit most of the farther nodes
+ *  are skipped by their distance.
+ ***********************************************************/
+bool ScenePicker::CastRay(const PICK_RAY& ray, PICK_HIT& hit) const
+{
+	hit.object = -1;
+	hit.distance = ray.maxDistance;
+	hit.position = glm::vec3(0.0f);
+	hit.normal = glm::vec3(0.0f);
+	if ((m_nodes.empty() == true) || (glm::dot(ray.direction, ray.direction) <= 0.0f))
+	{
+		return(false);
+	}
+
+	glm::vec3 direction = glm::normalize(ray.direction);
+	glm::vec3 inverseDirection = GetInverseDirection(direction);
+	glm::vec3 objectNormal(0.0f);
+
+	int stack[MAX_TRAVERSAL_DEPTH];
+	int stackSize = 0;
+	stack[stackSize++] = 0;
+	while (stackSize > 0)
+	{
+		const BVH_NODE& node = m_nodes[stack[--stackSize]];
+		float distance = 0.0f;
+		if (IntersectBounds(ray.origin, inverseDirection, node.boundsMin, node.boundsMax, hit.distance, distance) == false)
+		{
+			continue;
+		}
+
+		if (node.itemCount > 0)
+		{
+			for (int i = node.first; i < node.first + node.itemCount; i++)
+			{
+				int objectIndex = m_objectOrder[i];
+				const TRACE_OBJECT& object = m_objects[objectIndex];
+				if (IntersectBounds(ray.origin, inverseDirection, object.boundsMin, object.boundsMax, hit.distance, distance) == false)
+				{
+					continue;
+				}
+
+				// the direction is not normalized in object space, so
+				// the distances along it stay in world units
+				glm::vec3 origin = glm::vec3(object.worldToObject * glm::vec4(ray.origin, 1.0f));
+				glm::vec3 localDirection = glm::mat3(object.worldToObject) * direction;
+				float meshDistance = hit.distance;
+				glm::vec3 normal;
+				if (IntersectMesh(m_meshes[object.mesh], origin, localDirection, meshDistance, normal) == true)
+				{
+					hit.object = objectIndex;
+					hit.distance = meshDistance;
+					objectNormal = normal;
+				}
+			}
+		}
+		else if (stackSize + 2 <= MAX_TRAVERSAL_DEPTH)
+		{
+			float leftDistance = 0.0f;
+			float rightDistance = 0.0f;
+			const BVH_NODE& left = m_nodes[node.first];
+			const BVH_NODE& right = m_nodes[node.first + 1];
+			bool bLeft = IntersectBounds(ray.origin, inverseDirection, left.boundsMin, left.boundsMax, hit.distance, leftDistance);
+			bool bRight = IntersectBounds(ray.origin, inverseDirection, right.boundsMin, right.boundsMax, hit.distance, rightDistance);
+			if ((bLeft == true) && (bRight == true) && (rightDistance < leftDistance))
+			{
+				stack[stackSize++] = node.first;
+				stack[stackSize++] = node.first + 1;
+			}
+			else
+			{
+				if (bRight == true)
+				{
+					stack[stackSize++] = node.first + 1;
+				}
+				if (bLeft == true)
+				{
+					stack[stackSize++] = node.first;
+				}
+			}
+		}
+	}
+
+	if (hit.object < 0)
+	{
+		return(false);
+	}
+
+	// normals move by the inverse transpose of the model matrix,
+	// and face back along the ray
+	const TRACE_OBJECT& object = m_objects[hit.object];
+	hit.position = ray.origin + direction * hit.distance;
+	hit.normal = glm::normalize(glm::transpose(glm::mat3(object.worldToObject)) * objectNormal);
+	if (glm::dot(hit.normal, direction) > 0.0f)
+	{
+		hit.normal = -hit.normal;
+	}
+	return(true);
+}
+
+/***********************************************************
+ *  IntersectMesh()
+ *
+ *  This method is used for finding the closest triangle of a
+ *  mesh along a ray in the mesh's own space.  The distance
+ *  passed in limits the search, and is replaced with the
+ *  distance of the triangle found.
+ ***********************************************************/
+bool ScenePicker::IntersectMesh(
+	const PICK_MESH& mesh,
+	const glm::vec3& origin,
+	const glm::vec3& direction,
+	float& distance,
+	glm::vec3& normal)
+{
+	if (mesh.nodes.empty() == true)
+	{
+		return(false);
+	}
+
+	glm::vec3 inverseDirection = GetInverseDirection(direction);
+	bool bHit = false;
+
+	int stack[MAX_TRAVERSAL_DEPTH];
+	int stackSize = 0;
+	stack[stackSize++] = 0;
+	while (stackSize > 0)
+	{
+		const BVH_NODE& node = mesh.nodes[stack[--stackSize]];
+		float boundsDistance = 0.0f;
+		if (IntersectBounds(origin, inverseDirection, node.boundsMin, node.boundsMax, distance, boundsDistance) == false)
+		{
+			continue;
+		}
+
+		if (node.itemCount > 0)
+		{
+			for (int i = node.first; i < node.first + node.itemCount; i++)
+			{
+				const glm::vec3& a = mesh.positions[mesh.indices[i * 3]];
+				const glm::vec3& b = mesh.positions[mesh.indices[i * 3 + 1]];
+				const glm::vec3& c = mesh.positions[mesh.indices[i * 3 + 2]];
+				float triangleDistance = 0.0f;
+				if (IntersectTriangle(origin, direction, a, b, c, distance, triangleDistance) == true)
+				{
+					distance = triangleDistance;
+					normal = glm::cross(b - a, c - a);
+					bHit = true;
+				}
+			}
+		}
+		else if (stackSize + 2 <= MAX_TRAVERSAL_DEPTH)
+		{
+			float leftDistance = 0.0f;
+			float rightDistance = 0.0f;
+			const BVH_NODE& left = mesh.nodes[node.first];
+			const BVH_NODE& right = mesh.nodes[node.first + 1];
+			bool bLeft = IntersectBounds(origin, inverseDirection, left.boundsMin, left.boundsMax, distance, leftDistance);
+			bool bRight = IntersectBounds(origin, inverseDirection, right.boundsMin, right.boundsMax, distance, rightDistance);
+			if ((bLeft == true) && (bRight == true) && (rightDistance < leftDistance))
+			{
+				stack[stackSize++] = node.first;
+				stack[stackSize++] = node.first + 1;
+			}
+			else
+			{
+				if (bRight == true)
+				{
+					stack[stackSize++] = node.first + 1;
+				}
+				if (bLeft == true)
+				{
+					stack[stackSize++] = node.first;
+				}
+			}
+		}
+	}
+
+	return(bHit);
+}
+
+/***********************************************************
+ *  CastRays()
+ *
+ *  This method is used for casting many rays at once.  The
+ *  rays are taken in runs by one worker thread per CPU
+ *  core, and each hit is written to the same place in the
+ *  list as its ray.
+ ***********************************************************/
+void ScenePicker::CastRays(const std::vector<PICK_RAY>& rays, std::vector<PICK_HIT>& hits) const
+{
+	hits.resize(rays.size());
+	if (rays.empty() == true)
+	{
+		return;
+	}
+
+	int runCount = ((int)rays.size() + RAYS_PER_RUN - 1) / RAYS_PER_RUN;
+	int threadCount = std::min(runCount, std::max(1, (int)std::thread::hardware_concurrency()));
+	std::atomic<int> nextRun(0);
+
+	std::vector<std::thread> workers;
+	for (int i = 1; i < threadCount; i++)
+	{
+		workers.push_back(std::thread(&ScenePicker::CastRayRuns, this, &rays, &hits, &nextRun));
+	}
+	CastRayRuns(&rays, &hits, &nextRun);
+	for (size_t i = 0; i < workers.size(); i++)
+	{
+		workers[i].join();
+	}
+}
+
+/***********************************************************
+ *  CastRayRuns()
+ *
+ *  This method is run by each thread casting rays.  It takes
+ *  the next run of rays until every run has been taken.
+ ***********************************************************/
+void ScenePicker::CastRayRuns(
+	const std::vector<PICK_RAY>* pRays,
+	std::vector<PICK_HIT>* pHits,
+	std::atomic<int>* pNextRun) const
+{
+	int rayCount = (int)pRays->size();
+	while (true)
+	{
+		int first = pNextRun->fetch_add(1) * RAYS_PER_RUN;
+		if (first >= rayCount)
+		{
+			break;
+		}
+		int last = std::min(first + RAYS_PER_RUN, rayCount);
+		for (int i = first; i < last; i++)
+		{
+			CastRay((*pRays)[i], (*pHits)[i]);
+		}
+	}
+}
@@ -0,0 +1,142 @@
+///////////////////////////////////////////////////////////////////////////////
+// scenepicker.h
+// ============
+// find the scene object along a ray, such as the one under the cursor,
+// with a hierarchy over the objects and one over each mesh's triangles
+//
+//  Created for CS-330-Computational Graphics and Visualization
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <atomic>
+#include <vector>
+
+/***********************************************************
+ *  ScenePicker
+ *
+ *  This class contains the code for casting picking rays
+ *  against the scene.  It uses two levels of bounding
+ *  volume hierarchies:
+ *
+ *    objects     the world space bounds of every object,
+ *                which lead a ray to the few objects it
+ *                passes near
+ *    meshes      the triangles of each mesh in its own
+ *                space, shared by every object drawn with it
+ *
+ *  A ray is moved into the space of each object it reaches
+ *  without being normalized, so the distances found against
+ *  the mesh triangles are the world space distances.  Many
+ *  rays can be cast at once, spread over worker threads.
+ ***********************************************************/
+class ScenePicker
+{
+public:
+	// a ray to cast, which is ignored past the maximum distance
+	struct PICK_RAY
+	{
+		glm::vec3 origin;
+		glm::vec3 direction;
+		float maxDistance;
+	};
+
+	// the closest object found along a ray, with an object index
+	// of -1 when the ray hit nothing
+	struct PICK_HIT
+	{
+		int object;
+		float distance;
+		glm::vec3 position;
+		glm::vec3 normal;
+	};
+
+	// an object to pick, with the mesh it is drawn with, or -1 for
+	// an object that cannot be picked
+	struct PICK_OBJECT
+	{
+		int mesh;
+		glm::mat4 model;
+	};
+
+	// constructor
+	ScenePicker();
+	// destructor
+	~ScenePicker();
+
+	// add the triangles of a mesh in its own space, returning the
+	// index the objects refer to it by
+	int AddMesh(const std::vector<glm::vec3>& positions, const std::vector<unsigned int>& indices);
+	// free the triangles of a mesh that is no longer drawn
+	void RemoveMesh(int mesh);
+	// set the objects, which are found by their index in the list
+	void SetObjects(const std::vector<PICK_OBJECT>& objects);
+
+	// find the closest object along a ray
+	bool CastRay(const PICK_RAY& ray, PICK_HIT& hit) const;
+	// find the closest object along each of many rays, on one
+	// thread per CPU core
+	void CastRays(const std::vector<PICK_RAY>& rays, std::vector<PICK_HIT>& hits) const;
+
+private:
+	// a node of a bounding volume hierarchy, which holds either
+	// two child nodes or a run of items
+	struct BVH_NODE
+	{
+		glm::vec3 boundsMin;
+		glm::vec3 boundsMax;
+		// first child node, or first item for a leaf
+		int first;
+		// number of items, zero for an inner node
+		int itemCount;
+	};
+
+	// the triangles of a mesh, in the order the leaves refer to them
+	struct PICK_MESH
+	{
+		std::vector<glm::vec3> positions;
+		std::vector<unsigned int> indices;
+		std::vector<BVH_NODE> nodes;
+	};
+
+	// an object prepared for casting rays against
+	struct TRACE_OBJECT
+	{
+		int mesh;
+		glm::mat4 worldToObject;
+		glm::vec3 boundsMin;
+		glm::vec3 boundsMax;
+	};
+
+	std::vector<PICK_MESH> m_meshes;
+	std::vector<TRACE_OBJECT> m_objects;
+	// object indices in the order the leaf nodes refer to them
+	std::vector<int> m_objectOrder;
+	std::vector<BVH_NODE> m_nodes;
+
+	// fill in a node of a hierarchy over a run of items, splitting
+	// it into child nodes
+	static void BuildNode(
+		const std::vector<glm::vec3>& itemMin,
+		const std::vector<glm::vec3>& itemMax,
+		std::vector<int>& order,
+		std::vector<BVH_NODE>& nodes,
+		int nodeIndex,
+		int first,
+		int count,
+		int leafSize);
+	// find the closest triangle of a mesh along a ray in its space
+	static bool IntersectMesh(
+		const PICK_MESH& mesh,
+		const glm::vec3& origin,
+		const glm::vec3& direction,
+		float& distance,
+		glm::vec3& normal);
+	// cast runs of rays until none are left
+	void CastRayRuns(
+		const std::vector<PICK_RAY>* pRays,
+		std::vector<PICK_HIT>* pHits,
+		std::atomic<int>* pNextRun) const;
+};
@@ -0,0 +1,588 @@
+///////////////////////////////////////////////////////////////////////////////
+// scenestreamer.cpp
+// ============
+// split large scene layouts into a grid of cooked cells, and choose which
+// cells are read in and which are dropped as the camera moves
+//
+//  Created for CS-330-Computational Graphics and Visualization
+///////////////////////////////////////////////////////////////////////////////
+
+#include "SceneStreamer.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+// declaration of the global variables and defines
+namespace
+{
+	// identifies a cooked cell index written by Cook()
+	const unsigned int CELL_INDEX_MAGIC = 0x4C4C4543;	// "CELL"
+	// increase when the layout of the cell index changes
+	const unsigned int CELL_INDEX_VERSION = 1;
+
+	// how far ahead the camera's path is followed when choosing
+	// the cells to read, in seconds
+	const float PREFETCH_TIME = 1.5f;
+	// most cell files read on worker threads at the same time
+	const int MAX_READ_JOBS = 2;
+	// default distances within which cells are read and kept
+	const float DEFAULT_LOAD_RADIUS = 30.0f;
+	const float DEFAULT_EVICT_RADIUS = 45.0f;
+	// half the size of the largest basic shape, which bounds every
+	// object of a cell around its position
+	const float SHAPE_EXTENT = 1.2f;
+
+	/***********************************************************
+	 *  AddIndex()
+	 *
+	 *  This function is used to get the index of an entry in a
+	 *  cell's own list, adding it the first time the cell uses
+	 *  it.  The map holds the cell's index for each entry of
+	 *  the whole layout, or -1 when it has none yet.
+	 ***********************************************************/
+	int AddIndex(int layoutIndex, std::vector<int>& map, std::vector<int>& used)
+	{
+		if (layoutIndex < 0)
+		{
+			return(-1);
+		}
+		if (map[layoutIndex] < 0)
+		{
+			map[layoutIndex] = (int)used.size();
+			used.push_back(layoutIndex);
+		}
+		return(map[layoutIndex]);
+	}
+}
+
+/***********************************************************
+ *  SceneStreamer()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+SceneStreamer::SceneStreamer()
+{
+	memset(&m_header, 0, sizeof(m_header));
+	m_pCells = NULL;
+	m_pStrings = NULL;
+	m_loadRadius = DEFAULT_LOAD_RADIUS;
+	m_evictRadius = DEFAULT_EVICT_RADIUS;
+}
+
+/***********************************************************
+ *  ~SceneStreamer()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+SceneStreamer::~SceneStreamer()
+{
+	Close();
+}
+
+/***********************************************************
+ *  Open()
+ *
+ *  This method is used for mapping a cooked cell index and
+ *  checking its records.  The cell files themselves are not
+ *  opened until the camera comes near them.
+ ***********************************************************/
+bool SceneStreamer::Open(const char* indexPath)
+{
+	Close();
+	if (m_file.Open(indexPath) == false)
+	{
+		return(false);
+	}
+
+	INDEX_HEADER header;
+	if (m_file.GetSize() < sizeof(header))
+	{
+		Close();
+		return(false);
+	}
+	memcpy(&header, m_file.GetData(), sizeof(header));
+	unsigned long long cellBytes = (unsigned long long)header.cellCount * sizeof(CELL_RECORD);
+	if ((header.magic != CELL_INDEX_MAGIC) ||
+		(header.version != CELL_INDEX_VERSION) ||
+		(header.stringBytes == 0) ||
+		(header.cellSize <= 0.0f) ||
+		(m_file.GetSize() != sizeof(header) + cellBytes + header.stringBytes))
+	{
+		std::cout << "ERROR::SCENE_STREAMER::" << indexPath << " is not a cell index of this version"
+			<< std::endl;
+		Close();
+		return(false);
+	}
+
+	const CELL_RECORD* pCells = (const CELL_RECORD*)(m_file.GetData() + sizeof(header));
+	const char* pStrings = (const char*)(m_file.GetData() + sizeof(header) + cellBytes);
+	bool bValid = (pStrings[header.stringBytes - 1] == '\0');
+	for (unsigned int i = 0; (i < header.cellCount) && (bValid == true); i++)
+	{
+		bValid = (pCells[i].pathOffset < header.stringBytes) &&
+			(m_cellGrid.insert(std::make_pair(std::make_pair(pCells[i].cellX, pCells[i].cellZ), (int)i)).second == true);
+	}
+	if (bValid == false)
+	{
+		std::cout << "ERROR::SCENE_STREAMER::" << indexPath << " has cells that are not valid" << std::endl;
+		Close();
+		return(false);
+	}
+
+	m_header = header;
+	m_pCells = pCells;
+	m_pStrings = pStrings;
+	m_cellStates.assign(header.cellCount, CELL_UNLOADED);
+	std::cout << "INFO: Streaming " << header.cellCount << " cells of " << header.cellSize
+		<< " units from " << indexPath << std::endl;
+	return(true);
+}
+
+/***********************************************************
+ *  Close()
+ *
+ *  This method is used for waiting for the cells that are
+ *  being read and releasing the mapped index.
+ ***********************************************************/
+void SceneStreamer::Close()
+{
+	m_readJobs.clear();
+	m_residentCells.clear();
+	m_evictedCells.clear();
+	m_cellStates.clear();
+	m_cellGrid.clear();
+	m_file.Close();
+	memset(&m_header, 0, sizeof(m_header));
+	m_pCells = NULL;
+	m_pStrings = NULL;
+}
+
+/***********************************************************
+ *  IsOpen()
+ *
+ *  This method is used for checking whether a cell index is
+ *  open.
+ ***********************************************************/
+bool SceneStreamer::IsOpen() const
+{
+	return(m_pCells != NULL);
+}
+
+/***********************************************************
+ *  SetRadius()
+ *
+ *  This method is used for setting how near a cell must be
+ *  to be read, and how far it must be to be dropped.  The
+ *  gap between them keeps a cell on the edge from being
+ *  read and dropped over and over.
+ ***********************************************************/
+void SceneStreamer::SetRadius(float loadRadius, float evictRadius)
+{
+	m_loadRadius = loadRadius;
+	m_evictRadius = std::max(evictRadius, loadRadius);
+}
+
+/***********************************************************
+ *  Update()
+ *
+ *  This method is used for choosing which cells to read and
+ *  which to drop.  The cells near the camera and near the
+ *  point it is heading for are wanted, and the nearest of
+ *  them that are not in memory start reading, a few at a
+ *  time.  Cells that are beyond the eviction radius of both
+ *  points are dropped, or handed back to be unloaded when
+ *  they have been taken.
+ ***********************************************************/
+void SceneStreamer::Update(const glm::vec3& viewPosition, const glm::vec3& velocity)
+{
+	if (IsOpen() == false)
+	{
+		return;
+	}
+
+	// follow the camera's path, but not so far ahead that the
+	// cells around the camera itself are crowded out
+	glm::vec3 lookAhead = velocity * PREFETCH_TIME;
+	float lookAheadLength = glm::length(lookAhead);
+	if (lookAheadLength > m_loadRadius)
+	{
+		lookAhead *= m_loadRadius / lookAheadLength;
+	}
+	glm::vec3 aheadPosition = viewPosition + lookAhead;
+
+	// collect the cells that have finished reading
+	int readingCount = 0;
+	for (size_t i = 0; i < m_readJobs.size(); i++)
+	{
+		CELL_READ_JOB& job = m_readJobs[i];
+		if ((m_cellStates[job.cell] == CELL_READING) &&
+			(job.result.wait_for(std::chrono::seconds(0)) == std::future_status::ready))
+		{
+			job.pSceneFile = job.result.get();
+			m_cellStates[job.cell] = CELL_READ;
+		}
+		if (m_cellStates[job.cell] == CELL_READING)
+		{
+			readingCount++;
+		}
+	}
+
+	// drop the cells that have fallen behind
+	size_t keptJobs = 0;
+	for (size_t i = 0; i < m_readJobs.size(); i++)
+	{
+		int cell = m_readJobs[i].cell;
+		if ((m_cellStates[cell] == CELL_READ) &&
+			(GetCellDistance(cell, viewPosition) > m_evictRadius) &&
+			(GetCellDistance(cell, aheadPosition) > m_evictRadius))
+		{
+			m_cellStates[cell] = CELL_UNLOADED;
+			continue;
+		}
+		if (keptJobs != i)
+		{
+			m_readJobs[keptJobs] = std::move(m_readJobs[i]);
+		}
+		keptJobs++;
+	}
+	m_readJobs.resize(keptJobs);
+
+	size_t keptCells = 0;
+	for (size_t i = 0; i < m_residentCells.size(); i++)
+	{
+		int cell = m_residentCells[i];
+		if ((GetCellDistance(cell, viewPosition) > m_evictRadius) &&
+			(GetCellDistance(cell, aheadPosition) > m_evictRadius))
+		{
+			m_cellStates[cell] = CELL_UNLOADED;
+			m_evictedCells.push_back(cell);
+			continue;
+		}
+		m_residentCells[keptCells++] = cell;
+	}
+	m_residentCells.resize(keptCells);
+
+	// start reading the nearest wanted cells
+	if (readingCount >= MAX_READ_JOBS)
+	{
+		return;
+	}
+	std::vector<int> wantedCells;
+	FindNearCells(viewPosition, wantedCells);
+	FindNearCells(aheadPosition, wantedCells);
+	std::vector<std::pair<float, int>> candidates;
+	for (size_t i = 0; i < wantedCells.size(); i++)
+	{
+		int cell = wantedCells[i];
+		if (m_cellStates[cell] == CELL_UNLOADED)
+		{
+			float distance = std::min(GetCellDistance(cell, viewPosition), GetCellDistance(cell, aheadPosition));
+			candidates.push_back(std::make_pair(distance, cell));
+		}
+	}
+	std::sort(candidates.begin(), candidates.end());
+	for (size_t i = 0; (i < candidates.size()) && (readingCount < MAX_READ_JOBS); i++)
+	{
+		int cell = candidates[i].second;
+		if (m_cellStates[cell] != CELL_UNLOADED)
+		{
+			continue;
+		}
+		CELL_READ_JOB job;
+		job.cell = cell;
+		job.result = std::async(std::launch::async, &SceneStreamer::ReadCell,
+			std::string(m_pStrings + m_pCells[cell].pathOffset));
+		m_readJobs.push_back(std::move(job));
+		m_cellStates[cell] = CELL_READING;
+		readingCount++;
+	}
+}
+
+/***********************************************************
+ *  TakeReadCell()
+ *
+ *  This method is used for taking a cell whose file has
+ *  been read, so it can be loaded.  A cell whose file could
+ *  not be read is taken with no file.
+ ***********************************************************/
+bool SceneStreamer::TakeReadCell(int& cell, std::unique_ptr<SceneFile>& pSceneFile)
+{
+	for (size_t i = 0; i < m_readJobs.size(); i++)
+	{
+		if (m_cellStates[m_readJobs[i].cell] != CELL_READ)
+		{
+			continue;
+		}
+		cell = m_readJobs[i].cell;
+		pSceneFile = std::move(m_readJobs[i].pSceneFile);
+		m_readJobs.erase(m_readJobs.begin() + i);
+		m_cellStates[cell] = CELL_LOADING;
+		m_residentCells.push_back(cell);
+		return(true);
+	}
+	return(false);
+}
+
+/***********************************************************
+ *  SetCellLoaded()
+ *
+ *  This method is used for recording that a taken cell has
+ *  been fully loaded.
+ ***********************************************************/
+void SceneStreamer::SetCellLoaded(int cell)
+{
+	if ((cell >= 0) && (cell < (int)m_cellStates.size()) && (m_cellStates[cell] == CELL_LOADING))
+	{
+		m_cellStates[cell] = CELL_LOADED;
+	}
+}
+
+/***********************************************************
+ *  TakeEvictedCells()
+ *
+ *  This method is used for collecting the taken cells that
+ *  are now too far away and should be unloaded.
+ ***********************************************************/
+void SceneStreamer::TakeEvictedCells(std::vector<int>& cells)
+{
+	cells.insert(cells.end(), m_evictedCells.begin(), m_evictedCells.end());
+	m_evictedCells.clear();
+}
+
+/***********************************************************
+ *  IsBusy()
+ *
+ *  This method is used for checking whether any cell files
+ *  are being read or waiting to be taken.
+ ***********************************************************/
+bool SceneStreamer::IsBusy() const
+{
+	return(m_readJobs.empty() == false);
+}
+
+/***********************************************************
+ *  GetResidentCount()
+ *
+ *  This method is used for getting the number of cells that
+ *  have been taken and not evicted.
+ ***********************************************************/
+int SceneStreamer::GetResidentCount() const
+{
+	return((int)m_residentCells.size());
+}
+
+/***********************************************************
+ *  GetCellDistance()
+ *
+ *  This method is used for getting the distance across the
+ *  floor from a point to the bounds of a cell, which is
+ *  zero inside them.
+ ***********************************************************/
+float SceneStreamer::GetCellDistance(int cell, const glm::vec3& point) const
+{
+	const CELL_RECORD& record = m_pCells[cell];
+	float dx = std::max(std::max(record.boundsMin[0] - point.x, point.x - record.boundsMax[0]), 0.0f);
+	float dz = std::max(std::max(record.boundsMin[2] - point.z, point.z - record.boundsMax[2]), 0.0f);
+	return(std::sqrt(dx * dx + dz * dz));
+}
+
+/***********************************************************
+ *  FindNearCells()
+ *
+ *  This method is used for adding the cells within the load
+ *  radius of a point to a list.  Only the grid squares the
+ *  radius covers are looked up, so the cost does not grow
+ *  with the size of the scene.  Objects can reach a little
+ *  past their own square, so one more square is looked at
+ *  on each side.
+ ***********************************************************/
+void SceneStreamer::FindNearCells(const glm::vec3& point, std::vector<int>& cells) const
+{
+	int minX = (int)std::floor((point.x - m_loadRadius) / m_header.cellSize) - 1;
+	int maxX = (int)std::floor((point.x + m_loadRadius) / m_header.cellSize) + 1;
+	int minZ = (int)std::floor((point.z - m_loadRadius) / m_header.cellSize) - 1;
+	int maxZ = (int)std::floor((point.z + m_loadRadius) / m_header.cellSize) + 1;
+	for (int z = minZ; z <= maxZ; z++)
+	{
+		for (int x = minX; x <= maxX; x++)
+		{
+			std::map<std::pair<int, int>, int>::const_iterator found = m_cellGrid.find(std::make_pair(x, z));
+			if ((found != m_cellGrid.end()) &&
+				(GetCellDistance(found->second, point) <= m_loadRadius) &&
+				(std::find(cells.begin(), cells.end(), found->second) == cells.end()))
+			{
+				cells.push_back(found->second);
+			}
+		}
+	}
+}
+
+/***********************************************************
+ *  ReadCell()
+ *
+ *  This method is run on a worker thread to map a cell file
+ *  and check its records.  Returns NULL when the file could
+ *  not be read.
+ ***********************************************************/
+std::unique_ptr<SceneFile> SceneStreamer::ReadCell(std::string filePath)
+{
+	std::unique_ptr<SceneFile> pSceneFile(new SceneFile());
+	if (pSceneFile->Open(filePath.c_str()) == false)
+	{
+		std::cout << "ERROR::SCENE_STREAMER::Could not read the cell " << filePath << std::endl;
+		pSceneFile.reset();
+	}
+	return(pSceneFile);
+}
+
+/***********************************************************
+ *  Cook()
+ *
+ *  This method is used for splitting a JSON scene layout
+ *  into cells.  Each object goes into the grid square its
+ *  position is in, and each square with objects is written
+ *  as a cooked scene file next to the index, holding only
+ *  the textures, model files and materials its objects use.
+ *  The bounds of a cell cover the whole of its objects, so
+ *  they can reach into the neighbouring squares.
+ ***********************************************************/
+bool SceneStreamer::Cook(const char* jsonPath, const char* indexPath, float cellSize)
+{
+	if (cellSize <= 0.0f)
+	{
+		std::cout << "ERROR::SCENE_STREAMER::The cell size must be above zero" << std::endl;
+		return(false);
+	}
+
+	SceneFile::SCENE_LAYOUT layout;
+	if (SceneFile::ReadLayout(jsonPath, layout) == false)
+	{
+		return(false);
+	}
+
+	// sort the objects into the grid squares
+	std::map<std::pair<int, int>, std::vector<size_t>> cellObjects;
+	for (size_t i = 0; i < layout.objects.size(); i++)
+	{
+		const SceneFile::OBJECT_RECORD& object = layout.objects[i];
+		int cellX = (int)std::floor(object.position[0] / cellSize);
+		int cellZ = (int)std::floor(object.position[2] / cellSize);
+		cellObjects[std::make_pair(cellX, cellZ)].push_back(i);
+	}
+
+	// the cell files are named after the index and their square
+	std::string basePath = indexPath;
+	size_t extension = basePath.find_last_of('.');
+	if ((extension != std::string::npos) && (basePath.find_first_of("/\\", extension) == std::string::npos))
+	{
+		basePath.erase(extension);
+	}
+
+	std::vector<CELL_RECORD> cells;
+	std::vector<char> strings(1, '\0');
+	std::map<std::pair<int, int>, std::vector<size_t>>::const_iterator it;
+	for (it = cellObjects.begin(); it != cellObjects.end(); ++it)
+	{
+		SceneFile::SCENE_LAYOUT cellLayout;
+		std::vector<int> textureMap(layout.textureTags.size(), -1);
+		std::vector<int> meshMap(layout.meshTags.size(), -1);
+		std::vector<int> materialMap(layout.materialTags.size(), -1);
+		std::vector<int> usedTextures;
+		std::vector<int> usedMeshes;
+		std::vector<int> usedMaterials;
+
+		CELL_RECORD cell;
+		cell.cellX = it->first.first;
+		cell.cellZ = it->first.second;
+		cell.objectCount = (unsigned int)it->second.size();
+		for (int axis = 0; axis < 3; axis++)
+		{
+			cell.boundsMin[axis] = 1.0e30f;
+			cell.boundsMax[axis] = -1.0e30f;
+		}
+
+		for (size_t i = 0; i < it->second.size(); i++)
+		{
+			SceneFile::OBJECT_RECORD object = layout.objects[it->second[i]];
+			object.texture = AddIndex(object.texture, textureMap, usedTextures);
+			object.mesh = AddIndex(object.mesh, meshMap, usedMeshes);
+			object.material = AddIndex(object.material, materialMap, usedMaterials);
+			cellLayout.objects.push_back(object);
+
+			// the basic shapes all fit in a cube around their origin,
+			// which the model matrix turns into a box
+			for (int axis = 0; axis < 3; axis++)
+			{
+				float extent = SHAPE_EXTENT * (std::fabs(object.model[axis]) +
+					std::fabs(object.model[4 + axis]) + std::fabs(object.model[8 + axis]));
+				cell.boundsMin[axis] = std::min(cell.boundsMin[axis], object.position[axis] - extent);
+				cell.boundsMax[axis] = std::max(cell.boundsMax[axis], object.position[axis] + extent);
+			}
+		}
+		for (size_t i = 0; i < usedTextures.size(); i++)
+		{
+			cellLayout.textureTags.push_back(layout.textureTags[usedTextures[i]]);
+			cellLayout.texturePaths.push_back(layout.texturePaths[usedTextures[i]]);
+		}
+		for (size_t i = 0; i < usedMeshes.size(); i++)
+		{
+			cellLayout.meshTags.push_back(layout.meshTags[usedMeshes[i]]);
+			cellLayout.meshPaths.push_back(layout.meshPaths[usedMeshes[i]]);
+		}
+		for (size_t i = 0; i < usedMaterials.size(); i++)
+		{
+			cellLayout.materialTags.push_back(layout.materialTags[usedMaterials[i]]);
+			cellLayout.materials.push_back(layout.materials[usedMaterials[i]]);
+		}
+
+		std::ostringstream cellPath;
+		cellPath << basePath << "_" << cell.cellX << "_" << cell.cellZ << ".scene";
+		if (SceneFile::Write(cellPath.str().c_str(), cellLayout) == false)
+		{
+			return(false);
+		}
+		cell.pathOffset = (unsigned int)strings.size();
+		std::string path = cellPath.str();
+		strings.insert(strings.end(), path.begin(), path.end());
+		strings.push_back('\0');
+		cells.push_back(cell);
+	}
+
+	INDEX_HEADER header;
+	header.magic = CELL_INDEX_MAGIC;
+	header.version = CELL_INDEX_VERSION;
+	header.cellCount = (unsigned int)cells.size();
+	header.stringBytes = (unsigned int)strings.size();
+	header.cellSize = cellSize;
+	header.reserved = 0;
+
+	std::ofstream file(indexPath, std::ios::binary | std::ios::trunc);
+	if (!file.is_open())
+	{
+		std::cout << "ERROR::SCENE_STREAMER::Could not write " << indexPath << std::endl;
+		return(false);
+	}
+	file.write((const char*)&header, sizeof(header));
+	if (cells.empty() == false)
+	{
+		file.write((const char*)&cells[0], cells.size() * sizeof(CELL_RECORD));
+	}
+	file.write(&strings[0], strings.size());
+	if (!file)
+	{
+		file.close();
+		std::remove(indexPath);
+		std::cout << "ERROR::SCENE_STREAMER::Could not write " << indexPath << std::endl;
+		return(false);
+	}
+
+	std::cout << "INFO: Cooked " << layout.objects.size() << " objects into " << cells.size()
+		<< " cells of " << cellSize << " units, indexed by " << indexPath << std::endl;
+	return(true);
+}
@@ -0,0 +1,155 @@
+///////////////////////////////////////////////////////////////////////////////
+// scenestreamer.h
+// ============
+// split large scene layouts into a grid of cooked cells, and choose which
+// cells are read in and which are dropped as the camera moves
+//
+//  Created for CS-330-Computational Graphics and Visualization
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "MappedFile.h"
+#include "SceneFile.h"
+
+#include <glm/glm.hpp>
+
+#include <future>
+#include <map>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+/***********************************************************
+ *  SceneStreamer
+ *
+ *  This class contains the code for streaming a scene that
+ *  is split into square cells on the floor.  Each cell is a
+ *  cooked scene file of its own, listing only the textures,
+ *  model files and materials its objects use, and an index
+ *  file holds the grid position, bounds and file of every
+ *  cell:
+ *
+ *    header      counts and the size of the cells
+ *    cells       position, bounds and path of each cell
+ *    strings     the cell file paths, each ending in a zero
+ *
+ *  Every frame the cells near the camera, and near where
+ *  the camera will be if it keeps moving the same way, are
+ *  read on worker threads, nearest first.  Cells that are
+ *  left further behind than the eviction radius are handed
+ *  back to be unloaded, so only the cells around the camera
+ *  are ever in memory however large the scene is.
+ ***********************************************************/
+class SceneStreamer
+{
+public:
+	// start of a cooked cell index
+	struct INDEX_HEADER
+	{
+		unsigned int magic;
+		unsigned int version;
+		unsigned int cellCount;
+		unsigned int stringBytes;
+		float cellSize;
+		unsigned int reserved;
+	};
+
+	// a cell of the grid, and the file holding its objects
+	struct CELL_RECORD
+	{
+		int cellX;
+		int cellZ;
+		float boundsMin[3];
+		float boundsMax[3];
+		unsigned int objectCount;
+		unsigned int pathOffset;
+	};
+
+	// constructor
+	SceneStreamer();
+	// destructor
+	~SceneStreamer();
+
+	// map a cooked cell index
+	bool Open(const char* indexPath);
+	// wait for the cells being read and release the index
+	void Close();
+	// check whether an index is open
+	bool IsOpen() const;
+
+	// set the distance within which cells are read in, and the
+	// larger distance beyond which they are dropped again
+	void SetRadius(float loadRadius, float evictRadius);
+	// choose the cells to read and to drop for the passed in
+	// camera position and velocity, in units per second
+	void Update(const glm::vec3& viewPosition, const glm::vec3& velocity);
+
+	// take a cell that has been read, returning false when
+	// none is ready
+	bool TakeReadCell(int& cell, std::unique_ptr<SceneFile>& pSceneFile);
+	// record that a taken cell has been fully loaded
+	void SetCellLoaded(int cell);
+	// move the taken cells that should be unloaded into the
+	// passed in list
+	void TakeEvictedCells(std::vector<int>& cells);
+
+	// check whether any cells are being read or are ready
+	bool IsBusy() const;
+	// number of cells taken and not evicted
+	int GetResidentCount() const;
+
+	// split a JSON scene layout into cooked cell files and
+	// write the index of the cells
+	static bool Cook(const char* jsonPath, const char* indexPath, float cellSize);
+
+private:
+	// where a cell is on its way in or out of memory
+	enum CELL_STATE
+	{
+		CELL_UNLOADED = 0,
+		// the cell file is being read on a worker thread
+		CELL_READING,
+		// the cell file has been read and is waiting to be taken
+		CELL_READ,
+		// the cell has been taken and is being loaded
+		CELL_LOADING,
+		// the cell is fully loaded
+		CELL_LOADED
+	};
+
+	// a cell file being read on a worker thread
+	struct CELL_READ_JOB
+	{
+		int cell;
+		std::future<std::unique_ptr<SceneFile>> result;
+		std::unique_ptr<SceneFile> pSceneFile;
+	};
+
+	// the mapped index and its arrays
+	MappedFile m_file;
+	INDEX_HEADER m_header;
+	const CELL_RECORD* m_pCells;
+	const char* m_pStrings;
+	// cell index by grid position
+	std::map<std::pair<int, int>, int> m_cellGrid;
+	// state of each cell
+	std::vector<CELL_STATE> m_cellStates;
+	// cells that are being read or have been read
+	std::vector<CELL_READ_JOB> m_readJobs;
+	// cells that have been taken
+	std::vector<int> m_residentCells;
+	// cells that were taken and are to be unloaded
+	std::vector<int> m_evictedCells;
+	// distances within which cells are read and kept
+	float m_loadRadius;
+	float m_evictRadius;
+
+	// distance on the floor from a point to the bounds of a cell
+	float GetCellDistance(int cell, const glm::vec3& point) const;
+	// add the cells near a point to the list of wanted cells
+	void FindNearCells(const glm::vec3& point, std::vector<int>& cells) const;
+	// read a cell file on a worker thread
+	static std::unique_ptr<SceneFile> ReadCell(std::string filePath);
+};
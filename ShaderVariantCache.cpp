@@ -0,0 +1,795 @@
+///////////////////////////////////////////////////////////////////////////////
+// shadervariantcache.cpp
+// ============
+// compile and cache specialized versions of the scene shader for each
+// combination of features that the scene objects use
+//
+//  Created for CS-330-Computational Graphics and Visualization
+///////////////////////////////////////////////////////////////////////////////
+
+#include "ShaderVariantCache.h"
+
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+// declaration of the global variables and defines
+namespace
+{
+	// bit position of the light count within a variant key
+	const int LIGHT_COUNT_SHIFT = 8;
+
+	/***********************************************************
+	 *  ReadSourceFile()
+	 *
+	 *  This function is used to read a whole shader source
+	 *  file into a string.
+	 ***********************************************************/
+	bool ReadSourceFile(const char* filePath, std::string& source)
+	{
+		std::ifstream file(filePath);
+		if (!file.is_open())
+		{
+			std::cout << "ERROR::SHADER_FILE_NOT_READ: " << filePath << std::endl;
+			return(false);
+		}
+
+		std::stringstream stream;
+		stream << file.rdbuf();
+		source = stream.str();
+		return(true);
+	}
+
+	/***********************************************************
+	 *  StartShaderStage()
+	 *
+	 *  This function is used to start compiling one shader
+	 *  stage.  The result is not checked here, so the driver
+	 *  can keep compiling while other stages are submitted.
+	 ***********************************************************/
+	GLuint StartShaderStage(GLenum type, const std::string& source)
+	{
+		const char* sourceText = source.c_str();
+		GLuint shader = glCreateShader(type);
+		glShaderSource(shader, 1, &sourceText, NULL);
+		glCompileShader(shader);
+		return(shader);
+	}
+
+	/***********************************************************
+	 *  CheckShaderStage()
+	 *
+	 *  This function is used to check the compile result of a
+	 *  shader stage and report any compile errors.
+	 ***********************************************************/
+	bool CheckShaderStage(GLuint shader)
+	{
+		GLint success = 0;
+		glGetShaderiv(shader, GL_COMPILE_STATUS, &success);
+		if (!success)
+		{
+			char infoLog[1024];
+			glGetShaderInfoLog(shader, 1024, NULL, infoLog);
+			std::cout << "ERROR::SHADER_COMPILATION_ERROR\n" << infoLog << std::endl;
+			return(false);
+		}
+		return(true);
+	}
+}
+
+/***********************************************************
+ *  ShaderVariantCache()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+ShaderVariantCache::ShaderVariantCache(ShaderManager* pShaderManager)
+{
+	m_pShaderManager = pShaderManager;
+	m_baseProgram = 0;
+	m_activeProgram = 0;
+	m_pBinaryCache = new ProgramBinaryCache();
+
+	// let the driver compile shaders on as many threads as it likes
+	m_bParallelCompile = false;
+	if (GLEW_KHR_parallel_shader_compile)
+	{
+		glMaxShaderCompilerThreadsKHR(0xFFFFFFFF);
+		m_bParallelCompile = true;
+	}
+	else if (GLEW_ARB_parallel_shader_compile)
+	{
+		glMaxShaderCompilerThreadsARB(0xFFFFFFFF);
+		m_bParallelCompile = true;
+	}
+}
+
+/***********************************************************
+ *  ~ShaderVariantCache()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+ShaderVariantCache::~ShaderVariantCache()
+{
+	DeleteVariants(m_programs);
+	DeleteVariants(m_reloadPrograms);
+	m_pShaderManager = NULL;
+
+	if (NULL != m_pBinaryCache)
+	{
+		delete m_pBinaryCache;
+		m_pBinaryCache = NULL;
+	}
+}
+
+/***********************************************************
+ *  LoadSource()
+ *
+ *  This method is used for reading the shader source that
+ *  all of the variants are built from.  The variants are
+ *  compiled later, by PrecompileVariants() or the first
+ *  time each one is used.
+ ***********************************************************/
+bool ShaderVariantCache::LoadSource(
+	const char* vertexShaderPath,
+	const char* fragmentShaderPath)
+{
+	if ((ReadSourceFile(vertexShaderPath, m_vertexSource) == false) ||
+		(ReadSourceFile(fragmentShaderPath, m_fragmentSource) == false))
+	{
+		m_vertexSource.clear();
+		m_fragmentSource.clear();
+		return(false);
+	}
+
+	if (NULL != m_pShaderManager)
+	{
+		m_baseProgram = m_pShaderManager->m_programID;
+	}
+	m_activeProgram = m_baseProgram;
+
+	return(true);
+}
+
+/***********************************************************
+ *  ReadSource()
+ *
+ *  This method is used for reading the vertex and fragment
+ *  shader source files into strings.  Nothing is compiled,
+ *  so it is safe to call on a thread without an OpenGL
+ *  context.
+ ***********************************************************/
+bool ShaderVariantCache::ReadSource(
+	const char* vertexShaderPath,
+	const char* fragmentShaderPath,
+	std::string& vertexSource,
+	std::string& fragmentSource)
+{
+	return((ReadSourceFile(vertexShaderPath, vertexSource) == true) &&
+		(ReadSourceFile(fragmentShaderPath, fragmentSource) == true));
+}
+
+/***********************************************************
+ *  ReloadSource()
+ *
+ *  This method is used for rebuilding every variant that
+ *  has been built so far from new shader source.  All of
+ *  the new variants are submitted at once so the driver
+ *  compiles them on its own threads, and the old variants
+ *  keep drawing until UpdateReload() swaps them.  A reload
+ *  that is still compiling is dropped for the newer one.
+ ***********************************************************/
+void ShaderVariantCache::ReloadSource(const std::string& vertexSource, const std::string& fragmentSource)
+{
+	DeleteVariants(m_reloadPrograms);
+	if (m_programs.empty() == true)
+	{
+		// nothing has been built yet, so the new source is simply
+		// used from the next variant on
+		m_vertexSource = vertexSource;
+		m_fragmentSource = fragmentSource;
+		return;
+	}
+
+	m_reloadVertexSource = vertexSource;
+	m_reloadFragmentSource = fragmentSource;
+
+	std::map<unsigned int, VARIANT_PROGRAM>::const_iterator it;
+	for (it = m_programs.begin(); it != m_programs.end(); ++it)
+	{
+		m_reloadPrograms[it->first] = BeginVariant(it->first, vertexSource, fragmentSource);
+	}
+	std::cout << "INFO: Rebuilding " << m_reloadPrograms.size()
+		<< " shader variants from the changed source" << std::endl;
+}
+
+/***********************************************************
+ *  UpdateReload()
+ *
+ *  This method is used for checking on the rebuilt variants
+ *  without waiting for the driver.  When the last one has
+ *  finished they replace the old ones together, so a frame
+ *  never mixes old and new shaders.  When any of them fails
+ *  to build, the old variants are kept and the errors are
+ *  reported, so a broken edit can be fixed and saved again.
+ ***********************************************************/
+bool ShaderVariantCache::UpdateReload()
+{
+	if (m_reloadPrograms.empty() == true)
+	{
+		return(false);
+	}
+
+	bool bComplete = true;
+	bool bFailed = false;
+	std::map<unsigned int, VARIANT_PROGRAM>::iterator it;
+	for (it = m_reloadPrograms.begin(); it != m_reloadPrograms.end(); ++it)
+	{
+		VARIANT_PROGRAM& variant = it->second;
+		if ((variant.bPending == true) &&
+			((m_bParallelCompile == false) || (IsVariantComplete(variant) == true)))
+		{
+			FinishVariant(it->first, variant);
+		}
+		bComplete = bComplete && (variant.bPending == false);
+		bFailed = bFailed || ((variant.bPending == false) && (variant.program == 0));
+	}
+	if (bComplete == false)
+	{
+		return(false);
+	}
+
+	if (bFailed == true)
+	{
+		std::cout << "ERROR::SHADER_RELOAD_FAILED, keeping the previous shader variants" << std::endl;
+		DeleteVariants(m_reloadPrograms);
+		return(false);
+	}
+
+	// nothing may stay bound to a program that is deleted
+	UseBaseProgram();
+	DeleteVariants(m_programs);
+	m_programs.swap(m_reloadPrograms);
+	m_vertexSource.swap(m_reloadVertexSource);
+	m_fragmentSource.swap(m_reloadFragmentSource);
+	m_reloadVertexSource.clear();
+	m_reloadFragmentSource.clear();
+	std::cout << "INFO: Reloaded " << m_programs.size() << " shader variants" << std::endl;
+	return(true);
+}
+
+/***********************************************************
+ *  IsReloading()
+ *
+ *  This method is used for checking whether rebuilt
+ *  variants are waiting to be swapped in.
+ ***********************************************************/
+bool ShaderVariantCache::IsReloading() const
+{
+	return(m_reloadPrograms.empty() == false);
+}
+
+/***********************************************************
+ *  EnableBinaryCache()
+ *
+ *  This method is used for turning on the program binary
+ *  cache, so that variants linked on an earlier run are
+ *  loaded instead of being compiled again.
+ ***********************************************************/
+void ShaderVariantCache::EnableBinaryCache(const char* directory)
+{
+	m_pBinaryCache->Initialize(directory);
+}
+
+/***********************************************************
+ *  PrecompileVariants()
+ *
+ *  This method is used for loading or starting to compile
+ *  all of the passed in variants at once.  Every compile is
+ *  submitted before any result is checked, so a driver with
+ *  parallel shader compilation works on them together.
+ ***********************************************************/
+void ShaderVariantCache::PrecompileVariants(const std::vector<unsigned int>& keys)
+{
+	int loadedCount = 0;
+	int compilingCount = 0;
+
+	for (size_t i = 0; i < keys.size(); i++)
+	{
+		if (m_programs.find(keys[i]) != m_programs.end())
+		{
+			continue;
+		}
+
+		VARIANT_PROGRAM variant = BeginVariant(keys[i]);
+		m_programs[keys[i]] = variant;
+		if (variant.bPending == true)
+		{
+			compilingCount++;
+		}
+		else if (variant.program != 0)
+		{
+			loadedCount++;
+		}
+	}
+
+	std::cout << "INFO: Shader variants: " << loadedCount << " loaded from cache, "
+		<< compilingCount << " compiling" << std::endl;
+}
+
+/***********************************************************
+ *  UseVariant()
+ *
+ *  This method is used for binding the shader variant for
+ *  the passed in key.  The shader manager is pointed at the
+ *  variant so that its uniform set methods apply to it.  A
+ *  variant that is still compiling, or that failed to build,
+ *  falls back to the shader manager program.
+ ***********************************************************/
+bool ShaderVariantCache::UseVariant(unsigned int key)
+{
+	std::map<unsigned int, VARIANT_PROGRAM>::iterator it = m_programs.find(key);
+	if (it == m_programs.end())
+	{
+		it = m_programs.insert(std::make_pair(key, BeginVariant(key))).first;
+	}
+
+	VARIANT_PROGRAM& variant = it->second;
+	if (variant.bPending == true)
+	{
+		// without parallel compilation there is nothing to gain
+		// by waiting, so the result is checked straight away
+		if ((m_bParallelCompile == false) || (IsVariantComplete(variant) == true))
+		{
+			FinishVariant(key, variant);
+		}
+	}
+
+	GLuint program = m_baseProgram;
+	if ((variant.bPending == false) && (variant.program != 0))
+	{
+		program = variant.program;
+	}
+
+	if (program == m_activeProgram)
+	{
+		return(false);
+	}
+
+	glUseProgram(program);
+	m_activeProgram = program;
+	if (NULL != m_pShaderManager)
+	{
+		m_pShaderManager->m_programID = program;
+	}
+	return(true);
+}
+
+/***********************************************************
+ *  UseBaseProgram()
+ *
+ *  This method is used for binding the shader manager
+ *  program again after the scene objects are drawn.
+ ***********************************************************/
+void ShaderVariantCache::UseBaseProgram()
+{
+	if (m_activeProgram != m_baseProgram)
+	{
+		glUseProgram(m_baseProgram);
+		m_activeProgram = m_baseProgram;
+	}
+	if (NULL != m_pShaderManager)
+	{
+		m_pShaderManager->m_programID = m_baseProgram;
+	}
+}
+
+/***********************************************************
+ *  IsBaseProgramActive()
+ *
+ *  This method is used for checking whether the shader
+ *  manager program is the one that is bound.
+ ***********************************************************/
+bool ShaderVariantCache::IsBaseProgramActive() const
+{
+	return(m_activeProgram == m_baseProgram);
+}
+
+/***********************************************************
+ *  GetVariantCount()
+ *
+ *  This method is used for getting the number of variants
+ *  that have been compiled so far.
+ ***********************************************************/
+int ShaderVariantCache::GetVariantCount() const
+{
+	return((int)m_programs.size());
+}
+
+/***********************************************************
+ *  IsCompiling()
+ *
+ *  This method is used for checking whether any variants
+ *  are still being compiled, in which case the scene is
+ *  partly drawn with the shader manager program and needs
+ *  to be drawn again once they are done.
+ ***********************************************************/
+bool ShaderVariantCache::IsCompiling() const
+{
+	std::map<unsigned int, VARIANT_PROGRAM>::const_iterator it;
+	for (it = m_programs.begin(); it != m_programs.end(); ++it)
+	{
+		if (it->second.bPending == true)
+		{
+			return(true);
+		}
+	}
+	return(false);
+}
+
+/***********************************************************
+ *  FinishVariants()
+ *
+ *  This method is used for waiting until every variant that
+ *  is being compiled has been linked, for work such as
+ *  baking that must draw with the variants straight away.
+ ***********************************************************/
+void ShaderVariantCache::FinishVariants()
+{
+	std::map<unsigned int, VARIANT_PROGRAM>::iterator it;
+	for (it = m_programs.begin(); it != m_programs.end(); ++it)
+	{
+		if (it->second.bPending == true)
+		{
+			FinishVariant(it->first, it->second);
+		}
+	}
+}
+
+/***********************************************************
+ *  MakeKey()
+ *
+ *  This method is used for building the key of the cheapest
+ *  variant that supports the passed in features.  Lighting
+ *  is only compiled in when there are lights to apply.  With
+ *  clustered lighting the lights are read from storage
+ *  buffers, so the light count is not part of the key.
+ ***********************************************************/
+unsigned int ShaderVariantCache::MakeKey(
+	bool bUseTexture,
+	bool bUseLighting,
+	bool bTransparent,
+	int lightCount,
+	bool bClusteredLighting)
+{
+	unsigned int key = 0;
+
+	if (bUseTexture == true)
+	{
+		key |= VARIANT_TEXTURE;
+	}
+	if (bTransparent == true)
+	{
+		key |= VARIANT_TRANSPARENCY;
+	}
+	if (bUseLighting == true)
+	{
+		if (lightCount > MAX_LIGHT_COUNT)
+		{
+			lightCount = MAX_LIGHT_COUNT;
+		}
+		if (lightCount < 0)
+		{
+			lightCount = 0;
+		}
+		key |= VARIANT_LIGHTING;
+		if (bClusteredLighting == true)
+		{
+			key |= VARIANT_CLUSTERED_LIGHTING;
+		}
+		else
+		{
+			key |= (unsigned int)lightCount << LIGHT_COUNT_SHIFT;
+		}
+	}
+
+	return(key);
+}
+
+/***********************************************************
+ *  MakeGBufferKey()
+ *
+ *  This method is used for building the key of the variant
+ *  that writes an opaque object into the G-buffer.  The
+ *  lights are applied afterwards by the lighting pass, so
+ *  only the texture selects between these variants.
+ ***********************************************************/
+unsigned int ShaderVariantCache::MakeGBufferKey(bool bUseTexture)
+{
+	unsigned int key = VARIANT_GBUFFER;
+
+	if (bUseTexture == true)
+	{
+		key |= VARIANT_TEXTURE;
+	}
+
+	return(key);
+}
+
+/***********************************************************
+ *  MakeBakedKey()
+ *
+ *  This method is used for building the key of the variant
+ *  that reads the light of the static scene from the baked
+ *  probe volume.  No light sources are applied, so neither
+ *  the light count nor clustering is part of the key.
+ ***********************************************************/
+unsigned int ShaderVariantCache::MakeBakedKey(bool bUseTexture, bool bTransparent)
+{
+	unsigned int key = VARIANT_LIGHTING | VARIANT_BAKED_LIGHTING;
+
+	if (bUseTexture == true)
+	{
+		key |= VARIANT_TEXTURE;
+	}
+	if (bTransparent == true)
+	{
+		key |= VARIANT_TRANSPARENCY;
+	}
+
+	return(key);
+}
+
+/***********************************************************
+ *  MakeMultiViewKey()
+ *
+ *  This method is used for building the key of the variant
+ *  that draws an object into several viewports at once.  The
+ *  light clusters are built for a single view, so objects
+ *  lit by them get the light sources as uniforms instead,
+ *  and the G-buffer is only written for the main view.
+ ***********************************************************/
+unsigned int ShaderVariantCache::MakeMultiViewKey(unsigned int key, int lightCount)
+{
+	key &= ~(unsigned int)VARIANT_GBUFFER;
+	if ((key & VARIANT_CLUSTERED_LIGHTING) != 0)
+	{
+		key = MakeKey(
+			(key & VARIANT_TEXTURE) != 0,
+			true,
+			(key & VARIANT_TRANSPARENCY) != 0,
+			lightCount,
+			false);
+	}
+
+	return(key | VARIANT_MULTI_VIEW);
+}
+
+/***********************************************************
+ *  MakeRecordedKey()
+ *
+ *  This method is used for building the key of the variant
+ *  that draws the instances of a recorded run.  Everything
+ *  else about the object is drawn the same way as before.
+ ***********************************************************/
+unsigned int ShaderVariantCache::MakeRecordedKey(unsigned int key)
+{
+	return(key | VARIANT_RECORDED_DRAWS);
+}
+
+/***********************************************************
+ *  IsMultiViewSupported()
+ *
+ *  This method is used for checking whether the multi view
+ *  variants can be built.  Their geometry stage is run once
+ *  per view and picks the viewport of each triangle copy,
+ *  which needs OpenGL 4.1 or the matching extensions.
+ ***********************************************************/
+bool ShaderVariantCache::IsMultiViewSupported()
+{
+	return(GLEW_VERSION_4_1 ||
+		(GLEW_ARB_viewport_array && GLEW_ARB_gpu_shader5));
+}
+
+/***********************************************************
+ *  BeginVariant()
+ *
+ *  This method is used for loading the program for a
+ *  variant key from the binary cache, or when it is not
+ *  there, submitting its shaders to be compiled and linked
+ *  without waiting for the result.
+ ***********************************************************/
+ShaderVariantCache::VARIANT_PROGRAM ShaderVariantCache::BeginVariant(unsigned int key)
+{
+	return(BeginVariant(key, m_vertexSource, m_fragmentSource));
+}
+
+/***********************************************************
+ *  BeginVariant()
+ *
+ *  This method is used for beginning a variant from the
+ *  passed in source rather than the current source.
+ ***********************************************************/
+ShaderVariantCache::VARIANT_PROGRAM ShaderVariantCache::BeginVariant(
+	unsigned int key,
+	const std::string& vertexSource,
+	const std::string& fragmentSource)
+{
+	VARIANT_PROGRAM variant;
+	variant.program = 0;
+	variant.vertexShader = 0;
+	variant.geometryShader = 0;
+	variant.fragmentShader = 0;
+	variant.binaryKey = 0;
+	variant.bPending = false;
+
+	if (vertexSource.empty() || fragmentSource.empty())
+	{
+		return(variant);
+	}
+
+	std::string variantVertexSource = InsertDefines(vertexSource, key, false);
+	std::string variantFragmentSource = InsertDefines(fragmentSource, key, false);
+
+	variant.binaryKey = m_pBinaryCache->MakeKey(variantVertexSource, variantFragmentSource);
+	variant.program = m_pBinaryCache->LoadProgram(variant.binaryKey);
+	if (variant.program != 0)
+	{
+		return(variant);
+	}
+
+	variant.vertexShader = StartShaderStage(GL_VERTEX_SHADER, variantVertexSource);
+	variant.fragmentShader = StartShaderStage(GL_FRAGMENT_SHADER, variantFragmentSource);
+	// the geometry stage of the multi view variants is kept in
+	// the vertex shader source, behind its own define
+	if ((key & VARIANT_MULTI_VIEW) != 0)
+	{
+		variant.geometryShader = StartShaderStage(GL_GEOMETRY_SHADER,
+			InsertDefines(vertexSource, key, true));
+	}
+
+	variant.program = glCreateProgram();
+	m_pBinaryCache->PrepareProgram(variant.program);
+	glAttachShader(variant.program, variant.vertexShader);
+	if (variant.geometryShader != 0)
+	{
+		glAttachShader(variant.program, variant.geometryShader);
+	}
+	glAttachShader(variant.program, variant.fragmentShader);
+	glLinkProgram(variant.program);
+	variant.bPending = true;
+
+	return(variant);
+}
+
+/***********************************************************
+ *  DeleteVariants()
+ *
+ *  This method is used for freeing the programs of a list
+ *  of variants, along with the shader stages of any that
+ *  are still compiling, and emptying the list.
+ ***********************************************************/
+void ShaderVariantCache::DeleteVariants(std::map<unsigned int, VARIANT_PROGRAM>& programs)
+{
+	std::map<unsigned int, VARIANT_PROGRAM>::iterator it;
+	for (it = programs.begin(); it != programs.end(); ++it)
+	{
+		if (it->second.bPending == true)
+		{
+			glDeleteShader(it->second.vertexShader);
+			glDeleteShader(it->second.geometryShader);
+			glDeleteShader(it->second.fragmentShader);
+		}
+		if (it->second.program != 0)
+		{
+			glDeleteProgram(it->second.program);
+		}
+	}
+	programs.clear();
+}
+
+/***********************************************************
+ *  IsVariantComplete()
+ *
+ *  This method is used for asking the driver whether a
+ *  pending variant has finished linking, without blocking.
+ ***********************************************************/
+bool ShaderVariantCache::IsVariantComplete(const VARIANT_PROGRAM& variant) const
+{
+	GLint complete = GL_TRUE;
+	glGetProgramiv(variant.program, GL_COMPLETION_STATUS_KHR, &complete);
+	return(complete == GL_TRUE);
+}
+
+/***********************************************************
+ *  FinishVariant()
+ *
+ *  This method is used for checking the compile and link
+ *  results of a pending variant.  A variant that built is
+ *  saved to the binary cache, and one that failed is
+ *  deleted so the shader manager program is used instead.
+ ***********************************************************/
+void ShaderVariantCache::FinishVariant(unsigned int key, VARIANT_PROGRAM& variant)
+{
+	bool bSuccess = CheckShaderStage(variant.vertexShader);
+	if (variant.geometryShader != 0)
+	{
+		bSuccess = CheckShaderStage(variant.geometryShader) && bSuccess;
+	}
+	bSuccess = CheckShaderStage(variant.fragmentShader) && bSuccess;
+
+	if (bSuccess == true)
+	{
+		GLint success = 0;
+		glGetProgramiv(variant.program, GL_LINK_STATUS, &success);
+		if (!success)
+		{
+			char infoLog[1024];
+			glGetProgramInfoLog(variant.program, 1024, NULL, infoLog);
+			std::cout << "ERROR::PROGRAM_LINKING_ERROR\n" << infoLog << std::endl;
+			bSuccess = false;
+		}
+	}
+
+	glDetachShader(variant.program, variant.vertexShader);
+	glDetachShader(variant.program, variant.fragmentShader);
+	glDeleteShader(variant.vertexShader);
+	glDeleteShader(variant.fragmentShader);
+	if (variant.geometryShader != 0)
+	{
+		glDetachShader(variant.program, variant.geometryShader);
+		glDeleteShader(variant.geometryShader);
+	}
+	variant.vertexShader = 0;
+	variant.geometryShader = 0;
+	variant.fragmentShader = 0;
+	variant.bPending = false;
+
+	if (bSuccess == false)
+	{
+		glDeleteProgram(variant.program);
+		variant.program = 0;
+		return;
+	}
+
+	m_pBinaryCache->StoreProgram(variant.binaryKey, variant.program);
+	std::cout << "INFO: Compiled shader variant " << key << std::endl;
+}
+
+/***********************************************************
+ *  InsertDefines()
+ *
+ *  This method is used for inserting the preprocessor
+ *  defines for a variant key into the shader source.  GLSL
+ *  requires the version line to come first, so the defines
+ *  are placed right after it.  The geometry stage is built
+ *  from the vertex shader source with GEOMETRY_STAGE set.
+ ***********************************************************/
+std::string ShaderVariantCache::InsertDefines(
+	const std::string& source,
+	unsigned int key,
+	bool bGeometryStage)
+{
+	std::ostringstream defines;
+	defines << "#define USE_TEXTURE " << ((key & VARIANT_TEXTURE) ? 1 : 0) << "\n";
+	defines << "#define USE_LIGHTING " << ((key & VARIANT_LIGHTING) ? 1 : 0) << "\n";
+	defines << "#define USE_TRANSPARENCY " << ((key & VARIANT_TRANSPARENCY) ? 1 : 0) << "\n";
+	defines << "#define CLUSTERED_LIGHTING " << ((key & VARIANT_CLUSTERED_LIGHTING) ? 1 : 0) << "\n";
+	defines << "#define GBUFFER_OUTPUT " << ((key & VARIANT_GBUFFER) ? 1 : 0) << "\n";
+	defines << "#define USE_BAKED_LIGHTING " << ((key & VARIANT_BAKED_LIGHTING) ? 1 : 0) << "\n";
+	defines << "#define MULTI_VIEW " << ((key & VARIANT_MULTI_VIEW) ? 1 : 0) << "\n";
+	defines << "#define RECORDED_DRAWS " << ((key & VARIANT_RECORDED_DRAWS) ? 1 : 0) << "\n";
+	defines << "#define GEOMETRY_STAGE " << ((bGeometryStage == true) ? 1 : 0) << "\n";
+	defines << "#define LIGHT_COUNT " << (key >> LIGHT_COUNT_SHIFT) << "\n";
+
+	size_t insertAt = 0;
+	size_t versionLine = source.find("#version");
+	if (versionLine != std::string::npos)
+	{
+		size_t lineEnd = source.find('\n', versionLine);
+		insertAt = (lineEnd == std::string::npos) ? source.size() : lineEnd + 1;
+	}
+
+	std::string result = source;
+	result.insert(insertAt, defines.str());
+	return(result);
+}
@@ -0,0 +1,173 @@
+///////////////////////////////////////////////////////////////////////////////
+// shadervariantcache.h
+// ============
+// compile and cache specialized versions of the scene shader for each
+// combination of features that the scene objects use
+//
+//  Created for CS-330-Computational Graphics and Visualization
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "ShaderManager.h"
+#include "ProgramBinaryCache.h"
+
+#include <map>
+#include <string>
+#include <vector>
+
+/***********************************************************
+ *  ShaderVariantCache
+ *
+ *  This class contains the code for building shader variants
+ *  from one source file by inserting preprocessor defines,
+ *  caching the compiled programs by feature key, and binding
+ *  them through the shader manager so that the uniform set
+ *  methods apply to the bound variant.  Linked programs are
+ *  kept in a program binary cache on disk, and programs that
+ *  miss the cache are compiled in parallel by the driver
+ *  while the scene is drawn with the shader manager program.
+ ***********************************************************/
+class ShaderVariantCache
+{
+public:
+	// features that select a shader variant
+	enum VARIANT_FEATURE
+	{
+		VARIANT_TEXTURE = 1,
+		VARIANT_LIGHTING = 2,
+		VARIANT_TRANSPARENCY = 4,
+		VARIANT_CLUSTERED_LIGHTING = 8,
+		VARIANT_GBUFFER = 16,
+		VARIANT_BAKED_LIGHTING = 32,
+		VARIANT_MULTI_VIEW = 64,
+		VARIANT_RECORDED_DRAWS = 128
+	};
+
+	// number of views a multi view variant draws at once
+	static const int MULTI_VIEW_COUNT = 4;
+
+	// highest number of light sources a variant can be built for
+	static const int MAX_LIGHT_COUNT = 15;
+
+	// constructor
+	ShaderVariantCache(ShaderManager* pShaderManager);
+	// destructor
+	~ShaderVariantCache();
+
+	// read the vertex and fragment shader source for the variants
+	bool LoadSource(const char* vertexShaderPath, const char* fragmentShaderPath);
+	// read the vertex and fragment shader source without using
+	// OpenGL, so it can be done on a worker thread
+	static bool ReadSource(
+		const char* vertexShaderPath,
+		const char* fragmentShaderPath,
+		std::string& vertexSource,
+		std::string& fragmentSource);
+	// start rebuilding every variant from new shader source, while
+	// the current variants keep drawing
+	void ReloadSource(const std::string& vertexSource, const std::string& fragmentSource);
+	// swap in the rebuilt variants once all of them have finished,
+	// or drop them when any failed.  returns true when the bound
+	// program changed
+	bool UpdateReload();
+	// check whether rebuilt variants are still being compiled
+	bool IsReloading() const;
+	// store the linked variants in the passed in directory
+	void EnableBinaryCache(const char* directory);
+	// start building the variants for the passed in keys, so
+	// they are ready by the time they are first drawn with
+	void PrecompileVariants(const std::vector<unsigned int>& keys);
+
+	// bind the variant for the passed in key, compiling it the
+	// first time it is used.  returns true when a different
+	// program was bound and the frame uniforms need to be set
+	bool UseVariant(unsigned int key);
+	// bind the shader manager program again
+	void UseBaseProgram();
+	// check whether the shader manager program is bound, which
+	// is the case while a variant is still compiling
+	bool IsBaseProgramActive() const;
+
+	// number of variants that have been compiled
+	int GetVariantCount() const;
+	// check whether any variants are still being compiled
+	bool IsCompiling() const;
+	// wait for every variant that is still being compiled
+	void FinishVariants();
+
+	// build the key for a combination of features
+	static unsigned int MakeKey(
+		bool bUseTexture,
+		bool bUseLighting,
+		bool bTransparent,
+		int lightCount,
+		bool bClusteredLighting);
+	// build the key for the variant that writes an object into
+	// the deferred shading G-buffer
+	static unsigned int MakeGBufferKey(bool bUseTexture);
+	// build the key for the variant that lights an object from
+	// the baked light probes
+	static unsigned int MakeBakedKey(bool bUseTexture, bool bTransparent);
+	// build the key for the variant that draws an object into
+	// every view at once, from the key it is drawn with alone
+	static unsigned int MakeMultiViewKey(unsigned int key, int lightCount);
+	// build the key for the variant that reads the transform and
+	// color of each instance from the DrawRecorder records
+	static unsigned int MakeRecordedKey(unsigned int key);
+	// check whether the driver can draw into several viewports
+	// from one geometry shader invocation per view
+	static bool IsMultiViewSupported();
+
+private:
+	// a variant program and the state of its compilation
+	struct VARIANT_PROGRAM
+	{
+		GLuint program;
+		// shader stages attached while the program is compiling
+		GLuint vertexShader;
+		GLuint geometryShader;
+		GLuint fragmentShader;
+		// key of the program in the binary cache
+		unsigned long long binaryKey;
+		// true until the compile and link results are checked
+		bool bPending;
+	};
+
+	// pointer to shader manager object
+	ShaderManager* m_pShaderManager;
+	// the program loaded by the shader manager
+	GLuint m_baseProgram;
+	// the program that is currently bound
+	GLuint m_activeProgram;
+	// shader source the variants are built from
+	std::string m_vertexSource;
+	std::string m_fragmentSource;
+	// compiled programs by variant key
+	std::map<unsigned int, VARIANT_PROGRAM> m_programs;
+	// variants being rebuilt from reloaded source, and the source
+	std::map<unsigned int, VARIANT_PROGRAM> m_reloadPrograms;
+	std::string m_reloadVertexSource;
+	std::string m_reloadFragmentSource;
+	// stored program binaries
+	ProgramBinaryCache* m_pBinaryCache;
+	// true when the driver compiles shaders on its own threads
+	// and can be asked whether a program has finished
+	bool m_bParallelCompile;
+
+	// load the variant from the binary cache, or start compiling
+	// and linking it without waiting for the result
+	VARIANT_PROGRAM BeginVariant(unsigned int key);
+	VARIANT_PROGRAM BeginVariant(
+		unsigned int key,
+		const std::string& vertexSource,
+		const std::string& fragmentSource);
+	// free the programs and any shader stages of a list of variants
+	static void DeleteVariants(std::map<unsigned int, VARIANT_PROGRAM>& programs);
+	// check whether the driver has finished a pending variant
+	bool IsVariantComplete(const VARIANT_PROGRAM& variant) const;
+	// check the results of a pending variant and store its binary
+	void FinishVariant(unsigned int key, VARIANT_PROGRAM& variant);
+	// insert the defines for a variant key after the version line
+	std::string InsertDefines(const std::string& source, unsigned int key, bool bGeometryStage);
+};
@@ -0,0 +1,1104 @@
+///////////////////////////////////////////////////////////////////////////////
+// softwarerasterizer.cpp
+// ============
+// draw the scene objects on the CPU with a binned tile rasterizer, for
+// hosts where OpenGL has no graphics hardware behind it
+//
+//  Created for CS-330-Computational Graphics and Visualization
+///////////////////////////////////////////////////////////////////////////////
+
+#include "SoftwareRasterizer.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+// the edge functions and depth test run four pixels at a time
+// wherever SSE2 is available, which every x64 processor has
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && (_M_IX86_FP >= 2))
+#define SOFTWARE_RASTERIZER_SSE2
+#include <emmintrin.h>
+#endif
+
+// declaration of the global variables and defines
+namespace
+{
+	// vertices moved by one job of the vertex step
+	const int VERTEX_RUN = 4096;
+	// triangles set up and binned by one job of the binning step
+	const int TRIANGLE_RUN = 2048;
+	// pixels drawn together by the edge functions
+	const int PIXEL_RUN = 4;
+
+	/***********************************************************
+	 *  PackColor()
+	 *
+	 *  This function is used to pack a color into the bytes of
+	 *  an RGBA texel, in the order OpenGL reads them.
+	 ***********************************************************/
+	unsigned int PackColor(const glm::vec4& color)
+	{
+		glm::vec4 clamped = glm::clamp(color, glm::vec4(0.0f), glm::vec4(1.0f));
+		return((unsigned int)(clamped.r * 255.0f + 0.5f) |
+			((unsigned int)(clamped.g * 255.0f + 0.5f) << 8) |
+			((unsigned int)(clamped.b * 255.0f + 0.5f) << 16) |
+			((unsigned int)(clamped.a * 255.0f + 0.5f) << 24));
+	}
+
+	/***********************************************************
+	 *  UnpackColor()
+	 *
+	 *  This function is used to unpack an RGBA texel into a
+	 *  color.
+	 ***********************************************************/
+	glm::vec4 UnpackColor(unsigned int texel)
+	{
+		return(glm::vec4(
+			(float)(texel & 0xFF),
+			(float)((texel >> 8) & 0xFF),
+			(float)((texel >> 16) & 0xFF),
+			(float)((texel >> 24) & 0xFF)) / 255.0f);
+	}
+
+	/***********************************************************
+	 *  SmoothStep()
+	 *
+	 *  This function is used to fade smoothly from 0 to 1
+	 *  between two edges, the same as GLSL smoothstep().
+	 ***********************************************************/
+	float SmoothStep(float edge0, float edge1, float x)
+	{
+		float t = glm::clamp((x - edge0) / (edge1 - edge0), 0.0f, 1.0f);
+		return(t * t * (3.0f - 2.0f * t));
+	}
+}
+
+/***********************************************************
+ *  SoftwareRasterizer()
+ *
+ *  The constructor for the class.  One worker thread is
+ *  started for every CPU core but the one that records the
+ *  frames, which takes jobs as well.
+ ***********************************************************/
+SoftwareRasterizer::SoftwareRasterizer()
+{
+	m_viewProjection = glm::mat4(1.0f);
+	m_viewPosition = glm::vec3(0.0f);
+	m_ambientLight = glm::vec3(0.0f);
+	m_width = 0;
+	m_height = 0;
+	m_tileCountX = 0;
+	m_tileCountY = 0;
+	m_clearColor = glm::vec4(0.0f, 0.0f, 0.0f, 1.0f);
+	m_triangleCount = 0;
+	m_jobType = JOB_VERTICES;
+	m_jobCount = 0;
+	m_nextJob = 0;
+	m_busyWorkers = 0;
+	m_jobGeneration = 0;
+	m_bStopWorkers = false;
+	m_presentTexture = 0;
+	m_presentFramebuffer = 0;
+	m_presentWidth = 0;
+	m_presentHeight = 0;
+	m_frameTime = 0.0;
+
+	int workerCount = (int)std::thread::hardware_concurrency() - 1;
+	for (int i = 0; i < workerCount; i++)
+	{
+		m_workers.push_back(std::thread(&SoftwareRasterizer::WorkerLoop, this));
+	}
+}
+
+/***********************************************************
+ *  ~SoftwareRasterizer()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+SoftwareRasterizer::~SoftwareRasterizer()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_jobMutex);
+		m_bStopWorkers = true;
+	}
+	m_jobStarted.notify_all();
+	for (size_t i = 0; i < m_workers.size(); i++)
+	{
+		m_workers[i].join();
+	}
+	m_workers.clear();
+
+	if (m_presentFramebuffer != 0)
+	{
+		glDeleteFramebuffers(1, &m_presentFramebuffer);
+		m_presentFramebuffer = 0;
+	}
+	if (m_presentTexture != 0)
+	{
+		glDeleteTextures(1, &m_presentTexture);
+		m_presentTexture = 0;
+	}
+}
+
+/***********************************************************
+ *  AddMesh()
+ *
+ *  This method is used for adding the vertices and triangle
+ *  indices of a mesh.  A slot freed by RemoveMesh() is used
+ *  again.  A mesh with indices past its vertices is left
+ *  out, returning -1.
+ ***********************************************************/
+int SoftwareRasterizer::AddMesh(const std::vector<MeshImporter::MESH_VERTEX>& vertices, const std::vector<unsigned int>& indices)
+{
+	for (size_t i = 0; i < indices.size(); i++)
+	{
+		if (indices[i] >= vertices.size())
+		{
+			return(-1);
+		}
+	}
+
+	int mesh = 0;
+	while ((mesh < (int)m_meshes.size()) && (m_meshes[mesh].vertices.empty() == false))
+	{
+		mesh++;
+	}
+	if (mesh == (int)m_meshes.size())
+	{
+		m_meshes.push_back(SOFT_MESH());
+	}
+	m_meshes[mesh].vertices = vertices;
+	m_meshes[mesh].indices.assign(indices.begin(), indices.begin() + indices.size() / 3 * 3);
+	return(mesh);
+}
+
+/***********************************************************
+ *  RemoveMesh()
+ *
+ *  This method is used for freeing the vertices and indices
+ *  of a mesh, leaving its slot to be used again.
+ ***********************************************************/
+void SoftwareRasterizer::RemoveMesh(int mesh)
+{
+	if ((mesh >= 0) && (mesh < (int)m_meshes.size()))
+	{
+		std::vector<MeshImporter::MESH_VERTEX>().swap(m_meshes[mesh].vertices);
+		std::vector<unsigned int>().swap(m_meshes[mesh].indices);
+	}
+}
+
+/***********************************************************
+ *  AddTexture()
+ *
+ *  This method is used for adding a texture from its RGBA
+ *  pixels, with the first row at the bottom like OpenGL.
+ *  Each mipmap level averages two by two texels of the one
+ *  before it, down to a single texel.
+ ***********************************************************/
+int SoftwareRasterizer::AddTexture(const unsigned char* pixels, int width, int height)
+{
+	if ((pixels == NULL) || (width <= 0) || (height <= 0))
+	{
+		return(-1);
+	}
+
+	std::vector<MIP_LEVEL> levels(1);
+	levels[0].width = width;
+	levels[0].height = height;
+	levels[0].texels.assign(pixels, pixels + (size_t)width * height * 4);
+	while ((levels.back().width > 1) || (levels.back().height > 1))
+	{
+		const MIP_LEVEL& source = levels.back();
+		MIP_LEVEL level;
+		level.width = std::max(1, source.width / 2);
+		level.height = std::max(1, source.height / 2);
+		level.texels.resize((size_t)level.width * level.height * 4);
+		for (int y = 0; y < level.height; y++)
+		{
+			int sourceY0 = std::min(y * 2, source.height - 1);
+			int sourceY1 = std::min(y * 2 + 1, source.height - 1);
+			for (int x = 0; x < level.width; x++)
+			{
+				int sourceX0 = std::min(x * 2, source.width - 1);
+				int sourceX1 = std::min(x * 2 + 1, source.width - 1);
+				for (int channel = 0; channel < 4; channel++)
+				{
+					int sum = source.texels[((size_t)sourceY0 * source.width + sourceX0) * 4 + channel] +
+						source.texels[((size_t)sourceY0 * source.width + sourceX1) * 4 + channel] +
+						source.texels[((size_t)sourceY1 * source.width + sourceX0) * 4 + channel] +
+						source.texels[((size_t)sourceY1 * source.width + sourceX1) * 4 + channel];
+					level.texels[((size_t)y * level.width + x) * 4 + channel] = (unsigned char)((sum + 2) / 4);
+				}
+			}
+		}
+		levels.push_back(level);
+	}
+
+	int texture = 0;
+	while ((texture < (int)m_textures.size()) && (m_textures[texture].empty() == false))
+	{
+		texture++;
+	}
+	if (texture == (int)m_textures.size())
+	{
+		m_textures.push_back(std::vector<MIP_LEVEL>());
+	}
+	m_textures[texture].swap(levels);
+	return(texture);
+}
+
+/***********************************************************
+ *  RemoveTexture()
+ *
+ *  This method is used for freeing the levels of a texture,
+ *  leaving its slot to be used again.
+ ***********************************************************/
+void SoftwareRasterizer::RemoveTexture(int texture)
+{
+	if ((texture >= 0) && (texture < (int)m_textures.size()))
+	{
+		std::vector<MIP_LEVEL>().swap(m_textures[texture]);
+	}
+}
+
+/***********************************************************
+ *  SetViewTransform()
+ *
+ *  This method is used for setting the view and projection
+ *  the next frame is drawn with.
+ ***********************************************************/
+void SoftwareRasterizer::SetViewTransform(
+	const glm::mat4& view,
+	const glm::mat4& projection,
+	const glm::vec3& viewPosition)
+{
+	m_viewProjection = projection * view;
+	m_viewPosition = viewPosition;
+}
+
+/***********************************************************
+ *  SetLights()
+ *
+ *  This method is used for setting the light sources of the
+ *  next frame.  The values the fragment shader gets from
+ *  uniforms, such as the cone cosines, are worked out here
+ *  once instead of for every pixel.
+ ***********************************************************/
+void SoftwareRasterizer::SetLights(
+	const std::vector<LIGHT_SOURCE>& lights,
+	const glm::vec3& ambientColor,
+	float ambientIntensity)
+{
+	m_lights = lights;
+	m_lightDirections.resize(lights.size());
+	m_innerConeCosines.resize(lights.size());
+	m_outerConeCosines.resize(lights.size());
+	for (size_t i = 0; i < lights.size(); i++)
+	{
+		m_lightDirections[i] = glm::normalize(lights[i].direction);
+		m_innerConeCosines[i] = cos(glm::radians(lights[i].innerConeAngle));
+		m_outerConeCosines[i] = cos(glm::radians(lights[i].outerConeAngle));
+	}
+	m_ambientLight = ambientColor * ambientIntensity;
+}
+
+/***********************************************************
+ *  BeginFrame()
+ *
+ *  This method is used for starting to record the draws of
+ *  a frame.  The buffers are cleared by the tiles as they
+ *  are drawn, so each thread clears its own part.
+ ***********************************************************/
+void SoftwareRasterizer::BeginFrame(int width, int height, const glm::vec4& clearColor)
+{
+	m_width = std::max(width, 0);
+	m_height = std::max(height, 0);
+	m_tileCountX = (m_width + TILE_SIZE - 1) / TILE_SIZE;
+	m_tileCountY = (m_height + TILE_SIZE - 1) / TILE_SIZE;
+	m_clearColor = clearColor;
+	m_colorBuffer.resize((size_t)m_width * m_height);
+	m_depthBuffer.resize((size_t)m_width * m_height);
+	m_draws.clear();
+}
+
+/***********************************************************
+ *  DrawMesh()
+ *
+ *  This method is used for recording a draw of a mesh with
+ *  the passed in transform and properties.  The draws are
+ *  done in the order they are recorded, like OpenGL.
+ ***********************************************************/
+void SoftwareRasterizer::DrawMesh(
+	int mesh,
+	const glm::mat4& model,
+	const glm::mat3& normalMatrix,
+	const DRAW_STATE& state)
+{
+	if ((mesh < 0) || (mesh >= (int)m_meshes.size()) || (m_meshes[mesh].indices.empty() == true))
+	{
+		return;
+	}
+
+	DRAW_COMMAND command;
+	command.mesh = mesh;
+	command.model = model;
+	command.normalMatrix = normalMatrix;
+	command.state = state;
+	if ((state.texture >= (int)m_textures.size()) ||
+		((state.texture >= 0) && (m_textures[state.texture].empty() == true)))
+	{
+		command.state.texture = -1;
+	}
+	command.firstVertex = 0;
+	command.firstTriangle = 0;
+	m_draws.push_back(command);
+}
+
+/***********************************************************
+ *  EndFrame()
+ *
+ *  This method is used for drawing the recorded frame.  The
+ *  vertices and triangles of every draw are numbered one
+ *  after another, so each job of a step can find the draws
+ *  it covers on its own.
+ ***********************************************************/
+void SoftwareRasterizer::EndFrame()
+{
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+	size_t vertexCount = 0;
+	m_triangleCount = 0;
+	for (size_t i = 0; i < m_draws.size(); i++)
+	{
+		const SOFT_MESH& mesh = m_meshes[m_draws[i].mesh];
+		m_draws[i].firstVertex = vertexCount;
+		m_draws[i].firstTriangle = m_triangleCount;
+		vertexCount += mesh.vertices.size();
+		m_triangleCount += mesh.indices.size() / 3;
+	}
+	m_clipVertices.resize(vertexCount);
+
+	int chunkCount = (int)((m_triangleCount + TRIANGLE_RUN - 1) / TRIANGLE_RUN);
+	if ((int)m_chunks.size() < chunkCount)
+	{
+		m_chunks.resize(chunkCount);
+	}
+
+	RunJobs(JOB_VERTICES, (int)((vertexCount + VERTEX_RUN - 1) / VERTEX_RUN));
+	RunJobs(JOB_BINNING, chunkCount);
+	RunJobs(JOB_TILES, m_tileCountX * m_tileCountY);
+
+	m_frameTime = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+/***********************************************************
+ *  Present()
+ *
+ *  This method is used for copying the color buffer into
+ *  the bound draw framebuffer, stretched over the passed in
+ *  rectangle.  The frame is uploaded into a texture that is
+ *  attached to a framebuffer of its own, and blitted from
+ *  it.  The texture binding and read framebuffer are put
+ *  back afterwards.
+ ***********************************************************/
+void SoftwareRasterizer::Present(int x, int y, int width, int height)
+{
+	if ((m_width <= 0) || (m_height <= 0))
+	{
+		return;
+	}
+
+	GLint savedTexture = 0;
+	GLint savedReadFramebuffer = 0;
+	glGetIntegerv(GL_TEXTURE_BINDING_2D, &savedTexture);
+	glGetIntegerv(GL_READ_FRAMEBUFFER_BINDING, &savedReadFramebuffer);
+
+	if (m_presentTexture == 0)
+	{
+		glGenTextures(1, &m_presentTexture);
+		glGenFramebuffers(1, &m_presentFramebuffer);
+	}
+	glBindTexture(GL_TEXTURE_2D, m_presentTexture);
+	if ((m_presentWidth != m_width) || (m_presentHeight != m_height))
+	{
+		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, m_width, m_height, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+		glBindFramebuffer(GL_READ_FRAMEBUFFER, m_presentFramebuffer);
+		glFramebufferTexture2D(GL_READ_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, m_presentTexture, 0);
+		m_presentWidth = m_width;
+		m_presentHeight = m_height;
+	}
+	glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, m_width, m_height, GL_RGBA, GL_UNSIGNED_BYTE, &m_colorBuffer[0]);
+
+	glBindFramebuffer(GL_READ_FRAMEBUFFER, m_presentFramebuffer);
+	glBlitFramebuffer(0, 0, m_width, m_height, x, y, x + width, y + height, GL_COLOR_BUFFER_BIT, GL_NEAREST);
+
+	glBindFramebuffer(GL_READ_FRAMEBUFFER, (GLuint)savedReadFramebuffer);
+	glBindTexture(GL_TEXTURE_2D, (GLuint)savedTexture);
+}
+
+/***********************************************************
+ *  GetFrameTime()
+ *
+ *  This method is used for getting the time in milliseconds
+ *  that the last frame took to draw, from EndFrame() being
+ *  called until every tile was done.
+ ***********************************************************/
+double SoftwareRasterizer::GetFrameTime() const
+{
+	return(m_frameTime);
+}
+
+/***********************************************************
+ *  GetThreadCount()
+ *
+ *  This method is used for getting the number of threads
+ *  that take the jobs of a frame, including the one that
+ *  records it.
+ ***********************************************************/
+int SoftwareRasterizer::GetThreadCount() const
+{
+	return((int)m_workers.size() + 1);
+}
+
+/***********************************************************
+ *  WorkerLoop()
+ *
+ *  This method is used for running a worker thread.  It
+ *  sleeps until a step of the frame is started, takes its
+ *  jobs until none are left, and reports that it is done.
+ ***********************************************************/
+void SoftwareRasterizer::WorkerLoop()
+{
+	unsigned int generation = 0;
+	while (true)
+	{
+		JOB_TYPE type;
+		int jobCount = 0;
+		{
+			std::unique_lock<std::mutex> lock(m_jobMutex);
+			m_jobStarted.wait(lock, [this, generation]()
+				{
+					return((m_bStopWorkers == true) || (m_jobGeneration != generation));
+				});
+			if (m_bStopWorkers == true)
+			{
+				return;
+			}
+			generation = m_jobGeneration;
+			type = m_jobType;
+			jobCount = m_jobCount;
+		}
+
+		TakeJobs(type, jobCount);
+
+		{
+			std::lock_guard<std::mutex> lock(m_jobMutex);
+			m_busyWorkers--;
+		}
+		m_jobFinished.notify_one();
+	}
+}
+
+/***********************************************************
+ *  RunJobs()
+ *
+ *  This method is used for running the jobs of one step of
+ *  the frame.  The workers are woken to take jobs alongside
+ *  the calling thread, and the step is over once every one
+ *  of them has run out of jobs.
+ ***********************************************************/
+void SoftwareRasterizer::RunJobs(JOB_TYPE type, int jobCount)
+{
+	if (jobCount <= 0)
+	{
+		return;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(m_jobMutex);
+		m_jobType = type;
+		m_jobCount = jobCount;
+		m_nextJob = 0;
+		m_busyWorkers = (int)m_workers.size();
+		m_jobGeneration++;
+	}
+	m_jobStarted.notify_all();
+
+	TakeJobs(type, jobCount);
+
+	std::unique_lock<std::mutex> lock(m_jobMutex);
+	m_jobFinished.wait(lock, [this]()
+		{
+			return(m_busyWorkers == 0);
+		});
+}
+
+/***********************************************************
+ *  TakeJobs()
+ *
+ *  This method is used for taking the next job of the step
+ *  and running it, until none are left.
+ ***********************************************************/
+void SoftwareRasterizer::TakeJobs(JOB_TYPE type, int jobCount)
+{
+	for (int job = m_nextJob++; job < jobCount; job = m_nextJob++)
+	{
+		switch (type)
+		{
+		case JOB_VERTICES:
+			TransformVertices(job);
+			break;
+		case JOB_BINNING:
+			BinTriangles(job);
+			break;
+		case JOB_TILES:
+		default:
+			DrawTile(job);
+			break;
+		}
+	}
+}
+
+/***********************************************************
+ *  TransformVertices()
+ *
+ *  This method is used for moving a run of the frame's
+ *  vertices into clip space, along with their world space
+ *  positions and normals for the lighting.
+ ***********************************************************/
+void SoftwareRasterizer::TransformVertices(int job)
+{
+	size_t first = (size_t)job * VERTEX_RUN;
+	size_t last = std::min(first + VERTEX_RUN, m_clipVertices.size());
+
+	// the last draw that starts at or before the first vertex
+	size_t draw = std::upper_bound(m_draws.begin(), m_draws.end(), first,
+		[](size_t vertex, const DRAW_COMMAND& command)
+		{
+			return(vertex < command.firstVertex);
+		}) - m_draws.begin() - 1;
+
+	for (size_t v = first; v < last; v++)
+	{
+		while ((draw + 1 < m_draws.size()) && (m_draws[draw + 1].firstVertex <= v))
+		{
+			draw++;
+		}
+		const DRAW_COMMAND& command = m_draws[draw];
+		const MeshImporter::MESH_VERTEX& vertex = m_meshes[command.mesh].vertices[v - command.firstVertex];
+
+		CLIP_VERTEX& clipVertex = m_clipVertices[v];
+		glm::vec4 worldPosition = command.model * glm::vec4(vertex.position, 1.0f);
+		clipVertex.clipPosition = m_viewProjection * worldPosition;
+		clipVertex.worldPosition = glm::vec3(worldPosition);
+		clipVertex.normal = command.normalMatrix * vertex.normal;
+		clipVertex.textureCoordinate = vertex.textureCoordinate;
+	}
+}
+
+/***********************************************************
+ *  BinTriangles()
+ *
+ *  This method is used for setting up a run of the frame's
+ *  triangles into the chunk of the job.  Triangles outside
+ *  one of the clip planes are dropped, and those crossing
+ *  the near plane are cut at it, which can leave a quad that
+ *  becomes two triangles.  The other planes are left to the
+ *  screen bounds and the depth test.
+ ***********************************************************/
+void SoftwareRasterizer::BinTriangles(int job)
+{
+	TRIANGLE_CHUNK& chunk = m_chunks[job];
+	chunk.triangles.clear();
+	chunk.bins.resize(m_tileCountX * m_tileCountY);
+	for (size_t i = 0; i < chunk.bins.size(); i++)
+	{
+		chunk.bins[i].clear();
+	}
+
+	size_t first = (size_t)job * TRIANGLE_RUN;
+	size_t last = std::min(first + TRIANGLE_RUN, m_triangleCount);
+	size_t draw = std::upper_bound(m_draws.begin(), m_draws.end(), first,
+		[](size_t triangle, const DRAW_COMMAND& command)
+		{
+			return(triangle < command.firstTriangle);
+		}) - m_draws.begin() - 1;
+
+	for (size_t t = first; t < last; t++)
+	{
+		while ((draw + 1 < m_draws.size()) && (m_draws[draw + 1].firstTriangle <= t))
+		{
+			draw++;
+		}
+		const DRAW_COMMAND& command = m_draws[draw];
+		const unsigned int* indices = &m_meshes[command.mesh].indices[(t - command.firstTriangle) * 3];
+
+		const CLIP_VERTEX* corners[3];
+		int outside = 0x3F;
+		bool bCrossesNear = false;
+		for (int i = 0; i < 3; i++)
+		{
+			corners[i] = &m_clipVertices[command.firstVertex + indices[i]];
+			const glm::vec4& position = corners[i]->clipPosition;
+			int planes = ((position.x < -position.w) ? 1 : 0) |
+				((position.x > position.w) ? 2 : 0) |
+				((position.y < -position.w) ? 4 : 0) |
+				((position.y > position.w) ? 8 : 0) |
+				((position.z < -position.w) ? 16 : 0) |
+				((position.z > position.w) ? 32 : 0);
+			outside &= planes;
+			bCrossesNear = bCrossesNear || ((planes & 16) != 0);
+		}
+		if (outside != 0)
+		{
+			continue;
+		}
+
+		if (bCrossesNear == false)
+		{
+			SetupTriangle((int)draw, corners, chunk);
+			continue;
+		}
+
+		// keep the part in front of the near plane, where z + w is
+		// not negative
+		CLIP_VERTEX polygon[4];
+		int cornerCount = 0;
+		for (int i = 0; i < 3; i++)
+		{
+			const CLIP_VERTEX& a = *corners[i];
+			const CLIP_VERTEX& b = *corners[(i + 1) % 3];
+			float distanceA = a.clipPosition.z + a.clipPosition.w;
+			float distanceB = b.clipPosition.z + b.clipPosition.w;
+			if (distanceA >= 0.0f)
+			{
+				polygon[cornerCount++] = a;
+			}
+			if ((distanceA >= 0.0f) != (distanceB >= 0.0f))
+			{
+				float t = distanceA / (distanceA - distanceB);
+				CLIP_VERTEX& cut = polygon[cornerCount++];
+				cut.clipPosition = glm::mix(a.clipPosition, b.clipPosition, t);
+				cut.worldPosition = glm::mix(a.worldPosition, b.worldPosition, t);
+				cut.normal = glm::mix(a.normal, b.normal, t);
+				cut.textureCoordinate = glm::mix(a.textureCoordinate, b.textureCoordinate, t);
+			}
+		}
+		for (int i = 2; i < cornerCount; i++)
+		{
+			const CLIP_VERTEX* fan[3] = { &polygon[0], &polygon[i - 1], &polygon[i] };
+			SetupTriangle((int)draw, fan, chunk);
+		}
+	}
+}
+
+/***********************************************************
+ *  SetupTriangle()
+ *
+ *  This method is used for turning a triangle that is in
+ *  front of the near plane into edge functions and a depth
+ *  plane over the screen, and adding it to the bins of the
+ *  tiles its bounds cover.  The corners are put in counter
+ *  clockwise order, so the inside of every edge is positive
+ *  whichever way the triangle faces.  Pixel centers on an
+ *  edge belong to the triangle when it is a top or left
+ *  edge, so triangles that share an edge draw it once.
+ ***********************************************************/
+void SoftwareRasterizer::SetupTriangle(int draw, const CLIP_VERTEX* corners[3], TRIANGLE_CHUNK& chunk)
+{
+	float screenX[3];
+	float screenY[3];
+	float depth[3];
+	float inverseW[3];
+	for (int i = 0; i < 3; i++)
+	{
+		const glm::vec4& position = corners[i]->clipPosition;
+		inverseW[i] = 1.0f / position.w;
+		screenX[i] = (position.x * inverseW[i] * 0.5f + 0.5f) * (float)m_width;
+		screenY[i] = (position.y * inverseW[i] * 0.5f + 0.5f) * (float)m_height;
+		depth[i] = position.z * inverseW[i] * 0.5f + 0.5f;
+	}
+
+	float area = (screenX[1] - screenX[0]) * (screenY[2] - screenY[0]) -
+		(screenY[1] - screenY[0]) * (screenX[2] - screenX[0]);
+	if (!(std::fabs(area) > 1.0e-8f))
+	{
+		return;
+	}
+	int order[3] = { 0, 1, 2 };
+	if (area < 0.0f)
+	{
+		order[1] = 2;
+		order[2] = 1;
+		area = -area;
+	}
+
+	// the pixels whose centers can be inside
+	float boundsMinX = std::min(screenX[0], std::min(screenX[1], screenX[2]));
+	float boundsMaxX = std::max(screenX[0], std::max(screenX[1], screenX[2]));
+	float boundsMinY = std::min(screenY[0], std::min(screenY[1], screenY[2]));
+	float boundsMaxY = std::max(screenY[0], std::max(screenY[1], screenY[2]));
+	RASTER_TRIANGLE triangle;
+	triangle.minX = (int)std::max(0.0f, std::ceil(boundsMinX - 0.5f));
+	triangle.maxX = (int)std::min((float)(m_width - 1), std::floor(boundsMaxX - 0.5f));
+	triangle.minY = (int)std::max(0.0f, std::ceil(boundsMinY - 0.5f));
+	triangle.maxY = (int)std::min((float)(m_height - 1), std::floor(boundsMaxY - 0.5f));
+	if ((triangle.minX > triangle.maxX) || (triangle.minY > triangle.maxY))
+	{
+		return;
+	}
+
+	triangle.draw = draw;
+	triangle.inverseArea = 1.0f / area;
+	triangle.depthA = 0.0f;
+	triangle.depthB = 0.0f;
+	triangle.depthC = 0.0f;
+	for (int i = 0; i < 3; i++)
+	{
+		// the edge across from each corner, from the next corner to
+		// the one after it
+		int corner = order[i];
+		int from = order[(i + 1) % 3];
+		int to = order[(i + 2) % 3];
+		triangle.edgeA[i] = screenY[from] - screenY[to];
+		triangle.edgeB[i] = screenX[to] - screenX[from];
+		triangle.edgeC[i] = screenX[from] * screenY[to] - screenY[from] * screenX[to];
+		triangle.bTopLeft[i] = (triangle.edgeA[i] > 0.0f) ||
+			((triangle.edgeA[i] == 0.0f) && (triangle.edgeB[i] < 0.0f));
+
+		triangle.depthA += triangle.edgeA[i] * depth[corner];
+		triangle.depthB += triangle.edgeB[i] * depth[corner];
+		triangle.depthC += triangle.edgeC[i] * depth[corner];
+
+		triangle.inverseW[i] = inverseW[corner];
+		triangle.worldPosition[i] = corners[corner]->worldPosition;
+		triangle.normal[i] = corners[corner]->normal;
+		triangle.textureCoordinate[i] = corners[corner]->textureCoordinate;
+	}
+	triangle.depthA *= triangle.inverseArea;
+	triangle.depthB *= triangle.inverseArea;
+	triangle.depthC *= triangle.inverseArea;
+
+	int index = (int)chunk.triangles.size();
+	chunk.triangles.push_back(triangle);
+	for (int tileY = triangle.minY / TILE_SIZE; tileY <= triangle.maxY / TILE_SIZE; tileY++)
+	{
+		for (int tileX = triangle.minX / TILE_SIZE; tileX <= triangle.maxX / TILE_SIZE; tileX++)
+		{
+			chunk.bins[tileY * m_tileCountX + tileX].push_back(index);
+		}
+	}
+}
+
+/***********************************************************
+ *  DrawTile()
+ *
+ *  This method is used for clearing a tile and drawing the
+ *  triangles binned into it, chunk by chunk, which is the
+ *  order the triangles were submitted in.
+ ***********************************************************/
+void SoftwareRasterizer::DrawTile(int tile)
+{
+	int tileMinX = (tile % m_tileCountX) * TILE_SIZE;
+	int tileMinY = (tile / m_tileCountX) * TILE_SIZE;
+	int tileMaxX = std::min(tileMinX + TILE_SIZE, m_width) - 1;
+	int tileMaxY = std::min(tileMinY + TILE_SIZE, m_height) - 1;
+
+	unsigned int clearColor = PackColor(m_clearColor);
+	for (int y = tileMinY; y <= tileMaxY; y++)
+	{
+		size_t row = (size_t)y * m_width;
+		std::fill(m_colorBuffer.begin() + row + tileMinX, m_colorBuffer.begin() + row + tileMaxX + 1, clearColor);
+		std::fill(m_depthBuffer.begin() + row + tileMinX, m_depthBuffer.begin() + row + tileMaxX + 1, 1.0f);
+	}
+
+	int chunkCount = (int)((m_triangleCount + TRIANGLE_RUN - 1) / TRIANGLE_RUN);
+	for (int c = 0; c < chunkCount; c++)
+	{
+		const TRIANGLE_CHUNK& chunk = m_chunks[c];
+		const std::vector<int>& bin = chunk.bins[tile];
+		for (size_t i = 0; i < bin.size(); i++)
+		{
+			DrawTriangle(chunk.triangles[bin[i]], tileMinX, tileMinY, tileMaxX, tileMaxY);
+		}
+	}
+}
+
+/***********************************************************
+ *  DrawTriangle()
+ *
+ *  This method is used for drawing the pixels of a triangle
+ *  inside a tile.  Each row is walked four pixels at a time:
+ *  the edge functions and the depth plane give a mask of the
+ *  pixels that are inside and in front, and only those are
+ *  shaded.  Transparent draws are blended over the color
+ *  buffer, and every draw writes its depth, as in OpenGL.
+ ***********************************************************/
+void SoftwareRasterizer::DrawTriangle(const RASTER_TRIANGLE& triangle, int tileMinX, int tileMinY, int tileMaxX, int tileMaxY)
+{
+	int minX = std::max(triangle.minX, tileMinX);
+	int maxX = std::min(triangle.maxX, tileMaxX);
+	int minY = std::max(triangle.minY, tileMinY);
+	int maxY = std::min(triangle.maxY, tileMaxY);
+	if ((minX > maxX) || (minY > maxY))
+	{
+		return;
+	}
+	bool bTransparent = m_draws[triangle.draw].state.bTransparent;
+
+#ifdef SOFTWARE_RASTERIZER_SSE2
+	const __m128 zero = _mm_setzero_ps();
+	const __m128 one = _mm_set1_ps(1.0f);
+	const __m128 laneOffsets = _mm_set_ps(3.5f, 2.5f, 1.5f, 0.5f);
+	__m128 edgeA[3];
+	__m128 topLeft[3];
+	for (int e = 0; e < 3; e++)
+	{
+		edgeA[e] = _mm_set1_ps(triangle.edgeA[e]);
+		topLeft[e] = (triangle.bTopLeft[e] == true) ? _mm_castsi128_ps(_mm_set1_epi32(-1)) : zero;
+	}
+	const __m128 depthA = _mm_set1_ps(triangle.depthA);
+#endif
+
+	for (int y = minY; y <= maxY; y++)
+	{
+		float pixelY = (float)y + 0.5f;
+		size_t row = (size_t)y * m_width;
+		for (int x = minX; x <= maxX; x += PIXEL_RUN)
+		{
+			int mask = (maxX - x + 1 >= PIXEL_RUN) ? 0xF : ((1 << (maxX - x + 1)) - 1);
+			float depths[PIXEL_RUN];
+
+#ifdef SOFTWARE_RASTERIZER_SSE2
+			__m128 pixelX = _mm_add_ps(_mm_set1_ps((float)x), laneOffsets);
+			for (int e = 0; (e < 3) && (mask != 0); e++)
+			{
+				__m128 value = _mm_add_ps(_mm_mul_ps(edgeA[e], pixelX),
+					_mm_set1_ps(triangle.edgeB[e] * pixelY + triangle.edgeC[e]));
+				__m128 inside = _mm_or_ps(_mm_cmpgt_ps(value, zero),
+					_mm_and_ps(_mm_cmpeq_ps(value, zero), topLeft[e]));
+				mask &= _mm_movemask_ps(inside);
+			}
+			if (mask == 0)
+			{
+				continue;
+			}
+			__m128 depth = _mm_add_ps(_mm_mul_ps(depthA, pixelX),
+				_mm_set1_ps(triangle.depthB * pixelY + triangle.depthC));
+			// a run cut short by the tile edge only reads its own
+			// pixels, since the next tile belongs to another thread
+			float storedDepths[PIXEL_RUN] = { 0.0f, 0.0f, 0.0f, 0.0f };
+			for (int lane = 0; lane < PIXEL_RUN; lane++)
+			{
+				if (x + lane <= maxX)
+				{
+					storedDepths[lane] = m_depthBuffer[row + x + lane];
+				}
+			}
+			__m128 stored = _mm_loadu_ps(storedDepths);
+			mask &= _mm_movemask_ps(_mm_and_ps(_mm_cmplt_ps(depth, stored),
+				_mm_and_ps(_mm_cmpge_ps(depth, zero), _mm_cmple_ps(depth, one))));
+			_mm_storeu_ps(depths, depth);
+#else
+			for (int lane = 0; lane < PIXEL_RUN; lane++)
+			{
+				if ((mask & (1 << lane)) == 0)
+				{
+					continue;
+				}
+				float pixelX = (float)(x + lane) + 0.5f;
+				bool bInside = true;
+				for (int e = 0; (e < 3) && (bInside == true); e++)
+				{
+					float value = triangle.edgeA[e] * pixelX + triangle.edgeB[e] * pixelY + triangle.edgeC[e];
+					bInside = (value > 0.0f) || ((value == 0.0f) && (triangle.bTopLeft[e] == true));
+				}
+				depths[lane] = triangle.depthA * pixelX + triangle.depthB * pixelY + triangle.depthC;
+				if ((bInside == false) || (depths[lane] < 0.0f) || (depths[lane] > 1.0f) ||
+					(depths[lane] >= m_depthBuffer[row + x + lane]))
+				{
+					mask &= ~(1 << lane);
+				}
+			}
+#endif
+
+			for (int lane = 0; (lane < PIXEL_RUN) && (mask != 0); lane++)
+			{
+				if ((mask & (1 << lane)) == 0)
+				{
+					continue;
+				}
+				mask &= ~(1 << lane);
+
+				size_t pixel = row + x + lane;
+				glm::vec4 color = ShadePixel(triangle, (float)(x + lane) + 0.5f, pixelY);
+				if (bTransparent == true)
+				{
+					glm::vec4 destination = UnpackColor(m_colorBuffer[pixel]);
+					color = glm::vec4(glm::vec3(color) * color.a + glm::vec3(destination) * (1.0f - color.a),
+						color.a * color.a + destination.a * (1.0f - color.a));
+				}
+				m_colorBuffer[pixel] = PackColor(color);
+				m_depthBuffer[pixel] = depths[lane];
+			}
+		}
+	}
+}
+
+/***********************************************************
+ *  ShadePixel()
+ *
+ *  This method is used for working out the color of one
+ *  pixel of a triangle, the same way as the scene fragment
+ *  shader.  The attributes are weighted by the barycentric
+ *  weights divided by w, which undoes the perspective.  The
+ *  weights one pixel across and up give the texture steps
+ *  that pick the mipmap level.
+ ***********************************************************/
+glm::vec4 SoftwareRasterizer::ShadePixel(const RASTER_TRIANGLE& triangle, float pixelX, float pixelY) const
+{
+	const DRAW_STATE& state = m_draws[triangle.draw].state;
+
+	glm::vec3 edges;
+	for (int i = 0; i < 3; i++)
+	{
+		edges[i] = triangle.edgeA[i] * pixelX + triangle.edgeB[i] * pixelY + triangle.edgeC[i];
+	}
+	glm::vec3 inverseW(triangle.inverseW[0], triangle.inverseW[1], triangle.inverseW[2]);
+	glm::vec3 weights = edges * inverseW;
+	weights /= (weights.x + weights.y + weights.z);
+
+	glm::vec4 baseColor = state.color;
+	if (state.texture >= 0)
+	{
+		glm::vec3 edgeA(triangle.edgeA[0], triangle.edgeA[1], triangle.edgeA[2]);
+		glm::vec3 edgeB(triangle.edgeB[0], triangle.edgeB[1], triangle.edgeB[2]);
+		glm::vec3 weightsX = (edges + edgeA) * inverseW;
+		glm::vec3 weightsY = (edges + edgeB) * inverseW;
+		weightsX /= (weightsX.x + weightsX.y + weightsX.z);
+		weightsY /= (weightsY.x + weightsY.y + weightsY.z);
+
+		glm::vec2 coordinate(0.0f);
+		glm::vec2 coordinateX(0.0f);
+		glm::vec2 coordinateY(0.0f);
+		for (int i = 0; i < 3; i++)
+		{
+			coordinate += triangle.textureCoordinate[i] * weights[i];
+			coordinateX += triangle.textureCoordinate[i] * weightsX[i];
+			coordinateY += triangle.textureCoordinate[i] * weightsY[i];
+		}
+		baseColor = SampleTexture(state.texture,
+			coordinate * state.UVscale,
+			(coordinateX - coordinate) * state.UVscale,
+			(coordinateY - coordinate) * state.UVscale);
+	}
+
+	glm::vec3 color = glm::vec3(baseColor);
+	if (state.bUseLighting == true)
+	{
+		glm::vec3 position = triangle.worldPosition[0] * weights[0] +
+			triangle.worldPosition[1] * weights[1] + triangle.worldPosition[2] * weights[2];
+		glm::vec3 normal = glm::normalize(triangle.normal[0] * weights[0] +
+			triangle.normal[1] * weights[1] + triangle.normal[2] * weights[2]);
+		glm::vec3 viewDirection = glm::normalize(m_viewPosition - position);
+
+		glm::vec3 lighting = m_ambientLight;
+		for (size_t i = 0; i < m_lights.size(); i++)
+		{
+			// phong lighting from one light source, faded out smoothly
+			// to nothing at the light's range and outside a spot
+			// light's cone
+			const LIGHT_SOURCE& light = m_lights[i];
+			glm::vec3 toLight = light.position - position;
+			float lightDistance = glm::length(toLight);
+			if (lightDistance >= light.range)
+			{
+				continue;
+			}
+			glm::vec3 lightDirection = toLight / lightDistance;
+
+			float falloff = lightDistance / light.range;
+			falloff = glm::clamp(1.0f - falloff * falloff * falloff * falloff, 0.0f, 1.0f);
+			float attenuation = falloff * falloff;
+			if (light.type == LIGHT_SOURCE::LIGHT_SPOT)
+			{
+				float spotCosine = glm::dot(-lightDirection, m_lightDirections[i]);
+				attenuation *= SmoothStep(m_outerConeCosines[i], m_innerConeCosines[i], spotCosine);
+			}
+
+			glm::vec3 ambient = light.ambientColor * state.ambientColor * state.ambientStrength;
+
+			float diffuseImpact = std::max(glm::dot(normal, lightDirection), 0.0f);
+			glm::vec3 diffuse = diffuseImpact * light.diffuseColor * state.diffuseColor;
+
+			glm::vec3 reflectDirection = glm::reflect(-lightDirection, normal);
+			float reflectCosine = glm::dot(viewDirection, reflectDirection);
+			float specularComponent = (reflectCosine > 0.0f) ? std::pow(reflectCosine, light.focalStrength) : 0.0f;
+			glm::vec3 specular = light.specularIntensity * specularComponent * light.specularColor * state.specularColor;
+
+			lighting += (ambient + diffuse + specular) * attenuation;
+		}
+		color = lighting * color;
+	}
+
+	return(glm::vec4(color, (state.bTransparent == true) ? baseColor.a : 1.0f));
+}
+
+/***********************************************************
+ *  SampleTexture()
+ *
+ *  This method is used for sampling a texture with the
+ *  coordinates repeating, like the scene textures.  The
+ *  level is the one whose texels are closest to the size of
+ *  the pixel, and the four texels around the coordinate are
+ *  blended bilinearly within it.
+ ***********************************************************/
+glm::vec4 SoftwareRasterizer::SampleTexture(
+	int texture,
+	const glm::vec2& coordinate,
+	const glm::vec2& stepX,
+	const glm::vec2& stepY) const
+{
+	const std::vector<MIP_LEVEL>& levels = m_textures[texture];
+	glm::vec2 size((float)levels[0].width, (float)levels[0].height);
+	float footprint = std::max(glm::length(stepX * size), glm::length(stepY * size));
+	int level = 0;
+	if (footprint > 1.0f)
+	{
+		level = std::min((int)(std::log2(footprint) + 0.5f), (int)levels.size() - 1);
+	}
+
+	const MIP_LEVEL& mip = levels[level];
+	float texelX = coordinate.x * (float)mip.width - 0.5f;
+	float texelY = coordinate.y * (float)mip.height - 0.5f;
+	float floorX = std::floor(texelX);
+	float floorY = std::floor(texelY);
+	float fractionX = texelX - floorX;
+	float fractionY = texelY - floorY;
+
+	// wrap the four texels into the level
+	int x0 = (int)std::fmod(floorX, (float)mip.width);
+	int y0 = (int)std::fmod(floorY, (float)mip.height);
+	x0 = (x0 < 0) ? x0 + mip.width : x0;
+	y0 = (y0 < 0) ? y0 + mip.height : y0;
+	int x1 = (x0 + 1 == mip.width) ? 0 : x0 + 1;
+	int y1 = (y0 + 1 == mip.height) ? 0 : y0 + 1;
+
+	const unsigned char* texels = &mip.texels[0];
+	glm::vec4 sample(0.0f);
+	const int cornerX[4] = { x0, x1, x0, x1 };
+	const int cornerY[4] = { y0, y0, y1, y1 };
+	const float cornerWeight[4] = {
+		(1.0f - fractionX) * (1.0f - fractionY),
+		fractionX * (1.0f - fractionY),
+		(1.0f - fractionX) * fractionY,
+		fractionX * fractionY };
+	for (int i = 0; i < 4; i++)
+	{
+		const unsigned char* texel = texels + ((size_t)cornerY[i] * mip.width + cornerX[i]) * 4;
+		sample += glm::vec4(texel[0], texel[1], texel[2], texel[3]) * cornerWeight[i];
+	}
+	return(sample / 255.0f);
+}
@@ -0,0 +1,274 @@
+///////////////////////////////////////////////////////////////////////////////
+// softwarerasterizer.h
+// ============
+// draw the scene objects on the CPU with a binned tile rasterizer, for
+// hosts where OpenGL has no graphics hardware behind it
+//
+//  Created for CS-330-Computational Graphics and Visualization
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "ClusteredLighting.h"
+#include "MeshImporter.h"
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/***********************************************************
+ *  SoftwareRasterizer
+ *
+ *  This class contains the code for rendering the scene
+ *  objects without the graphics driver.  The draws of a
+ *  frame are recorded first, and then run in three steps,
+ *  each shared out between worker threads as jobs:
+ *
+ *    vertices    every vertex is moved into clip space and
+ *                world space
+ *    binning     the triangles are clipped against the near
+ *                plane, set up for drawing, and added to the
+ *                bin of each screen tile they cover
+ *    tiles       each tile draws the triangles in its bins,
+ *                in the order they were submitted, with its
+ *                own part of the color and depth buffers
+ *
+ *  The edge functions and depth test run on four pixels at
+ *  once with SSE2.  The attributes are interpolated with
+ *  perspective correction, textures are sampled bilinearly
+ *  from the nearest mipmap level, and the lighting is the
+ *  same Phong lighting as the scene fragment shader.  The
+ *  finished frame is copied into a texture and blitted into
+ *  the bound framebuffer.
+ ***********************************************************/
+class SoftwareRasterizer
+{
+public:
+	// the properties an object is drawn with, matching the
+	// uniforms of the scene shader
+	struct DRAW_STATE
+	{
+		// texture index, or -1 to draw with the color
+		int texture;
+		glm::vec2 UVscale;
+		glm::vec4 color;
+		bool bUseLighting;
+		// keep the alpha of the color or texture for blending
+		bool bTransparent;
+		glm::vec3 ambientColor;
+		float ambientStrength;
+		glm::vec3 diffuseColor;
+		glm::vec3 specularColor;
+	};
+
+	// pixels along each side of a screen tile
+	static const int TILE_SIZE = 64;
+
+	// constructor
+	SoftwareRasterizer();
+	// destructor
+	~SoftwareRasterizer();
+
+	// add a mesh, returning the index draws refer to it by
+	int AddMesh(const std::vector<MeshImporter::MESH_VERTEX>& vertices, const std::vector<unsigned int>& indices);
+	// free a mesh that is no longer drawn
+	void RemoveMesh(int mesh);
+	// add a texture from RGBA pixels, building its mipmap levels,
+	// and return the index draws refer to it by
+	int AddTexture(const unsigned char* pixels, int width, int height);
+	// free a texture that is no longer drawn
+	void RemoveTexture(int texture);
+
+	// set the view and projection of the next frame
+	void SetViewTransform(
+		const glm::mat4& view,
+		const glm::mat4& projection,
+		const glm::vec3& viewPosition);
+	// set the light sources and ambient light of the next frame
+	void SetLights(
+		const std::vector<LIGHT_SOURCE>& lights,
+		const glm::vec3& ambientColor,
+		float ambientIntensity);
+
+	// start recording a frame of the passed in size
+	void BeginFrame(int width, int height, const glm::vec4& clearColor);
+	// record a draw of a mesh
+	void DrawMesh(
+		int mesh,
+		const glm::mat4& model,
+		const glm::mat3& normalMatrix,
+		const DRAW_STATE& state);
+	// draw the recorded frame into the color buffer
+	void EndFrame();
+	// copy the color buffer into the bound draw framebuffer
+	void Present(int x, int y, int width, int height);
+
+	// time in milliseconds the last frame took to draw
+	double GetFrameTime() const;
+	// number of threads the jobs are shared out between
+	int GetThreadCount() const;
+
+private:
+	struct SOFT_MESH
+	{
+		std::vector<MeshImporter::MESH_VERTEX> vertices;
+		std::vector<unsigned int> indices;
+	};
+
+	// one level of a texture, as RGBA texels
+	struct MIP_LEVEL
+	{
+		int width;
+		int height;
+		std::vector<unsigned char> texels;
+	};
+
+	// a recorded draw, and where its vertices and triangles are
+	// placed among those of the whole frame
+	struct DRAW_COMMAND
+	{
+		int mesh;
+		glm::mat4 model;
+		glm::mat3 normalMatrix;
+		DRAW_STATE state;
+		size_t firstVertex;
+		size_t firstTriangle;
+	};
+
+	// a vertex moved into clip space, with its world space values
+	struct CLIP_VERTEX
+	{
+		glm::vec4 clipPosition;
+		glm::vec3 worldPosition;
+		glm::vec3 normal;
+		glm::vec2 textureCoordinate;
+	};
+
+	// a triangle set up for drawing, with the edge functions and
+	// depth as planes over the screen
+	struct RASTER_TRIANGLE
+	{
+		int draw;
+		// edge functions, positive inside, and whether each edge
+		// owns the pixel centers it passes through
+		float edgeA[3];
+		float edgeB[3];
+		float edgeC[3];
+		bool bTopLeft[3];
+		// depth and its steps along x and y
+		float depthA;
+		float depthB;
+		float depthC;
+		// one over the area, turning edge values into barycentric
+		// weights, and one over w of each corner
+		float inverseArea;
+		float inverseW[3];
+		// screen bounds, in pixels
+		int minX;
+		int minY;
+		int maxX;
+		int maxY;
+		glm::vec3 worldPosition[3];
+		glm::vec3 normal[3];
+		glm::vec2 textureCoordinate[3];
+	};
+
+	// the triangles set up by one binning job, and the triangles
+	// of each tile among them.  a tile draws the bins of the jobs
+	// in order, which keeps the submission order
+	struct TRIANGLE_CHUNK
+	{
+		std::vector<RASTER_TRIANGLE> triangles;
+		std::vector<std::vector<int>> bins;
+	};
+
+	// the steps a frame is drawn in
+	enum JOB_TYPE
+	{
+		JOB_VERTICES = 0,
+		JOB_BINNING,
+		JOB_TILES
+	};
+
+	std::vector<SOFT_MESH> m_meshes;
+	std::vector<std::vector<MIP_LEVEL>> m_textures;
+
+	glm::mat4 m_viewProjection;
+	glm::vec3 m_viewPosition;
+	std::vector<LIGHT_SOURCE> m_lights;
+	// cosines of the spot light cone angles, and the normalized
+	// directions, worked out once per frame
+	std::vector<glm::vec3> m_lightDirections;
+	std::vector<float> m_innerConeCosines;
+	std::vector<float> m_outerConeCosines;
+	glm::vec3 m_ambientLight;
+
+	// frame size and buffers, with the bottom row first
+	int m_width;
+	int m_height;
+	int m_tileCountX;
+	int m_tileCountY;
+	glm::vec4 m_clearColor;
+	std::vector<unsigned int> m_colorBuffer;
+	std::vector<float> m_depthBuffer;
+
+	// the recorded draws and their transformed vertices
+	std::vector<DRAW_COMMAND> m_draws;
+	std::vector<CLIP_VERTEX> m_clipVertices;
+	size_t m_triangleCount;
+	std::vector<TRIANGLE_CHUNK> m_chunks;
+
+	// worker threads, which wait for a new step of the frame and
+	// take its jobs until none are left
+	std::vector<std::thread> m_workers;
+	std::mutex m_jobMutex;
+	std::condition_variable m_jobStarted;
+	std::condition_variable m_jobFinished;
+	JOB_TYPE m_jobType;
+	int m_jobCount;
+	std::atomic<int> m_nextJob;
+	int m_busyWorkers;
+	unsigned int m_jobGeneration;
+	bool m_bStopWorkers;
+
+	// texture and framebuffer the frame is presented through
+	GLuint m_presentTexture;
+	GLuint m_presentFramebuffer;
+	int m_presentWidth;
+	int m_presentHeight;
+
+	double m_frameTime;
+
+	// wait for steps of the frame on a worker thread
+	void WorkerLoop();
+	// run the jobs of a step on every thread, returning once all
+	// of them are done
+	void RunJobs(JOB_TYPE type, int jobCount);
+	// take jobs of the current step until none are left
+	void TakeJobs(JOB_TYPE type, int jobCount);
+
+	// move a run of vertices into clip space
+	void TransformVertices(int job);
+	// clip, set up and bin a run of triangles
+	void BinTriangles(int job);
+	// add a clipped triangle to a chunk
+	void SetupTriangle(int draw, const CLIP_VERTEX* corners[3], TRIANGLE_CHUNK& chunk);
+	// draw the binned triangles of a tile
+	void DrawTile(int tile);
+	// draw the part of a triangle inside a tile
+	void DrawTriangle(const RASTER_TRIANGLE& triangle, int tileMinX, int tileMinY, int tileMaxX, int tileMaxY);
+	// light and color one pixel of a triangle
+	glm::vec4 ShadePixel(const RASTER_TRIANGLE& triangle, float pixelX, float pixelY) const;
+	// sample a texture bilinearly from the level that matches how
+	// far the coordinate moves to the next pixel across and up
+	glm::vec4 SampleTexture(
+		int texture,
+		const glm::vec2& coordinate,
+		const glm::vec2& stepX,
+		const glm::vec2& stepY) const;
+};
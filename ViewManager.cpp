@@ -8,12 +8,15 @@
 ///////////////////////////////////////////////////////////////////////////////
 
 #include "ViewManager.h"
+#include "InputQueue.h"
 
 // GLM Math Header inclusions
 #include <glm/glm.hpp>
 #include <glm/gtx/transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
 
+#include <deque>
+
 // declaration of the global variables and defines
 namespace
 {
@@ -32,13 +35,210 @@ namespace
     float gLastY = WINDOW_HEIGHT / 2.0f;
     bool gFirstMouse = true;
 
-    // time between current frame and last frame
-    float gDeltaTime = 0.0f;
-    float gLastFrame = 0.0f;
+    // input events received from the GLFW callbacks, waiting to
+    // be handled by the next simulation step
+    InputQueue<1024> gInputQueue;
+    // events received while the queue was full, oldest first, which
+    // are moved into the queue as it empties.  key events are never
+    // dropped, while mouse moves and scrolls are merged into the
+    // newest one held here
+    std::deque<INPUT_EVENT> gOverflowEvents;
+
+    // the action bound to each key, indexed by GLFW key code
+    ViewManager::INPUT_ACTION gKeyBindings[GLFW_KEY_LAST + 1];
+    // the action each key held down was bound to when it was pressed
+    ViewManager::INPUT_ACTION gKeyPressedActions[GLFW_KEY_LAST + 1];
+    // true while the key bound to an action is held down
+    bool gActionHeld[ViewManager::ACTION_COUNT];
+    // true when an action was pressed during the current step,
+    // so that a quick tap still moves the camera for one step
+    bool gActionTapped[ViewManager::ACTION_COUNT];
+
+    // camera movement for each of the movement actions
+    const struct
+    {
+        ViewManager::INPUT_ACTION action;
+        Camera_Movement direction;
+    } g_MovementActions[] = {
+        { ViewManager::ACTION_MOVE_FORWARD, FORWARD },
+        { ViewManager::ACTION_MOVE_BACKWARD, BACKWARD },
+        { ViewManager::ACTION_MOVE_LEFT, LEFT },
+        { ViewManager::ACTION_MOVE_RIGHT, RIGHT },
+        { ViewManager::ACTION_MOVE_UP, UP },
+        { ViewManager::ACTION_MOVE_DOWN, DOWN } };
+    const int MOVEMENT_ACTION_COUNT = 6;
+
+    // sensitivity multiplier for the scroll speed adjustment
+    const float SCROLL_SENSITIVITY = 2.0f;
+
+    // the camera is simulated in fixed timesteps, in seconds,
+    // independent of how often frames are rendered
+    const double SIMULATION_TIMESTEP = 1.0 / 120.0;
+    // the most time simulated for one frame, so a long frame
+    // doesn't cause a spiral of ever more simulation steps
+    const double MAX_FRAME_TIME = 0.25;
+
+    // time of the last frame and the simulation time not yet run
+    double gLastFrameTime = 0.0;
+    double gAccumulator = 0.0;
+
+    // camera properties captured after each simulation step
+    struct CAMERA_STATE
+    {
+        glm::vec3 position;
+        glm::vec3 front;
+        glm::vec3 up;
+        float zoom;
+    };
+
+    // the camera state after the previous and latest simulation
+    // steps, which rendered frames are interpolated between
+    CAMERA_STATE gPreviousState;
+    CAMERA_STATE gCurrentState;
+
+    // true when the camera was moved to a new view and should not
+    // be interpolated from its old position
+    bool gCameraSnapped = false;
 
     // the following variable is false when orthographic projection
     // is off and true when it is on
     bool bOrthographicProjection = false;
+
+    // camera placement of the front, right, top and back views
+    const struct
+    {
+        glm::vec3 position;
+        glm::vec3 up;
+        glm::vec3 front;
+    } g_PresetViews[] = {
+        { glm::vec3(0.0f, 4.0f, 10.0f), glm::vec3(0.0f, 1.0f, 0.0f), glm::vec3(0.0f, 0.0f, -1.0f) },
+        { glm::vec3(10.0f, 4.0f, 0.0f), glm::vec3(0.0f, 1.0f, 0.0f), glm::vec3(-1.0f, 0.0f, 0.0f) },
+        { glm::vec3(0.0f, 7.0f, 0.0f), glm::vec3(-1.0f, 0.0f, 0.0f), glm::vec3(0.0f, -1.0f, 0.0f) },
+        { glm::vec3(0.0f, 4.0f, -10.0f), glm::vec3(0.0f, 1.0f, 0.0f), glm::vec3(0.0f, 0.0f, 1.0f) } };
+    const int PRESET_VIEW_COUNT = 4;
+
+    // the following variable is true when the four preset views
+    // are shown at once instead of the camera view
+    bool gQuadView = false;
+
+    // the following variable is true when the screenshot key has
+    // been pressed since the last frame was captured
+    bool gScreenshotRequested = false;
+
+    // the following variable is true when something has changed
+    // the view since the last rendered frame
+    bool gRedrawRequested = true;
+
+    // the view and projection of the last prepared frame
+    glm::mat4 gViewMatrix = glm::mat4(1.0f);
+    glm::mat4 gProjectionMatrix = glm::mat4(1.0f);
+    glm::vec3 gViewPosition = glm::vec3(0.0f);
+
+    /***********************************************************
+     *  FlushOverflowEvents()
+     *
+     *  This function is used to move the events held while the
+     *  input queue was full into the queue, in order, as long
+     *  as there is room.
+     ***********************************************************/
+    void FlushOverflowEvents()
+    {
+        while ((gOverflowEvents.empty() == false) &&
+            (gInputQueue.Push(gOverflowEvents.front()) == true))
+        {
+            gOverflowEvents.pop_front();
+        }
+    }
+
+    /***********************************************************
+     *  QueueInputEvent()
+     *
+     *  This function is used to queue an event from the GLFW
+     *  callbacks.  When the queue is full the event is held
+     *  until there is room, and a mouse move or scroll is
+     *  merged into the newest held event of the same type, so
+     *  only key events add to what is held.
+     ***********************************************************/
+    void QueueInputEvent(const INPUT_EVENT& inputEvent)
+    {
+        FlushOverflowEvents();
+        if ((gOverflowEvents.empty() == true) &&
+            (gInputQueue.Push(inputEvent) == true))
+        {
+            return;
+        }
+
+        if ((gOverflowEvents.empty() == false) &&
+            (inputEvent.type != INPUT_EVENT::KEY_EVENT) &&
+            (gOverflowEvents.back().type == inputEvent.type))
+        {
+            INPUT_EVENT& merged = gOverflowEvents.back();
+            merged.time = inputEvent.time;
+            if (inputEvent.type == INPUT_EVENT::MOUSE_MOVE_EVENT)
+            {
+                // the offsets are taken from the positions, so only
+                // the newest position is needed
+                merged.x = inputEvent.x;
+                merged.y = inputEvent.y;
+            }
+            else
+            {
+                merged.x += inputEvent.x;
+                merged.y += inputEvent.y;
+            }
+            return;
+        }
+        gOverflowEvents.push_back(inputEvent);
+    }
+
+    /***********************************************************
+     *  CaptureCameraState()
+     *
+     *  This function is used to copy the simulated properties
+     *  from the camera object.
+     ***********************************************************/
+    CAMERA_STATE CaptureCameraState(const Camera* pCamera)
+    {
+        CAMERA_STATE state;
+        state.position = pCamera->Position;
+        state.front = pCamera->Front;
+        state.up = pCamera->Up;
+        state.zoom = pCamera->Zoom;
+        return(state);
+    }
+
+    /***********************************************************
+     *  InterpolateCameraState()
+     *
+     *  This function is used to blend between two captured
+     *  camera states by the passed in fraction.
+     ***********************************************************/
+    CAMERA_STATE InterpolateCameraState(
+        const CAMERA_STATE& previous,
+        const CAMERA_STATE& current,
+        float alpha)
+    {
+        CAMERA_STATE state;
+        state.position = glm::mix(previous.position, current.position, alpha);
+        state.front = glm::normalize(glm::mix(previous.front, current.front, alpha));
+        state.up = glm::normalize(glm::mix(previous.up, current.up, alpha));
+        state.zoom = previous.zoom + (current.zoom - previous.zoom) * alpha;
+        return(state);
+    }
+
+    /***********************************************************
+     *  IsSameCameraState()
+     *
+     *  This function is used to check whether two captured
+     *  camera states are identical.
+     ***********************************************************/
+    bool IsSameCameraState(const CAMERA_STATE& a, const CAMERA_STATE& b)
+    {
+        return((a.position == b.position) &&
+            (a.front == b.front) &&
+            (a.up == b.up) &&
+            (a.zoom == b.zoom));
+    }
 }
 
 /***********************************************************
@@ -57,6 +257,37 @@ ViewManager::ViewManager(ShaderManager* pShaderManager)
     g_pCamera->Front = glm::vec3(0.0f, -0.5f, -2.0f);
     g_pCamera->Up = glm::vec3(0.0f, 1.0f, 0.0f);
     g_pCamera->Zoom = 80;
+
+    // set the default key bindings
+    for (int i = 0; i <= GLFW_KEY_LAST; i++)
+    {
+        gKeyBindings[i] = ACTION_NONE;
+        gKeyPressedActions[i] = ACTION_NONE;
+    }
+    for (int i = 0; i < ACTION_COUNT; i++)
+    {
+        gActionHeld[i] = false;
+        gActionTapped[i] = false;
+    }
+    BindKey(GLFW_KEY_ESCAPE, ACTION_CLOSE_WINDOW);
+    BindKey(GLFW_KEY_W, ACTION_MOVE_FORWARD);
+    BindKey(GLFW_KEY_S, ACTION_MOVE_BACKWARD);
+    BindKey(GLFW_KEY_A, ACTION_MOVE_LEFT);
+    BindKey(GLFW_KEY_D, ACTION_MOVE_RIGHT);
+    BindKey(GLFW_KEY_Q, ACTION_MOVE_UP);
+    BindKey(GLFW_KEY_E, ACTION_MOVE_DOWN);
+    BindKey(GLFW_KEY_P, ACTION_PERSPECTIVE);
+    BindKey(GLFW_KEY_O, ACTION_ORTHOGRAPHIC);
+    BindKey(GLFW_KEY_1, ACTION_VIEW_FRONT);
+    BindKey(GLFW_KEY_2, ACTION_VIEW_RIGHT);
+    BindKey(GLFW_KEY_3, ACTION_VIEW_TOP);
+    BindKey(GLFW_KEY_4, ACTION_VIEW_BACK);
+    BindKey(GLFW_KEY_5, ACTION_VIEW_QUAD);
+    BindKey(GLFW_KEY_F12, ACTION_SCREENSHOT);
+
+    // start the simulation at the default camera view
+    gCurrentState = CaptureCameraState(g_pCamera);
+    gPreviousState = gCurrentState;
 }
 
 /***********************************************************
@@ -108,12 +339,21 @@ GLFWwindow* ViewManager::CreateDisplayWindow(const char* windowTitle)
     // this callback is used to receive scroll wheel events
     glfwSetScrollCallback(window, &ViewManager::Scroll_Callback);
 
+    // this callback is used to receive keyboard events
+    glfwSetKeyCallback(window, &ViewManager::Key_Callback);
+
+    // this callback is used when the window contents need to be redrawn
+    glfwSetWindowRefreshCallback(window, &ViewManager::Window_Refresh_Callback);
+
     // enable blending for supporting transparent rendering
     glEnable(GL_BLEND);
     glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 
     m_pWindow = window;
 
+    // start the frame timing when the window is shown
+    ResetFrameTiming();
+
     return(window);
 }
 
@@ -125,26 +365,19 @@ GLFWwindow* ViewManager::CreateDisplayWindow(const char* windowTitle)
  ***********************************************************/
 void ViewManager::Mouse_Position_Callback(GLFWwindow* window, double xMousePos, double yMousePos)
 {
-    // when the first mouse move event is received, this needs to be recorded so that
-    // all subsequent mouse moves can correctly calculate the X position offset and Y
-    // position offset for proper operation
-    if (gFirstMouse)
-    {
-        gLastX = xMousePos;
-        gLastY = yMousePos;
-        gFirstMouse = false;
-    }
-
-    // calculate the X offset and Y offset values for moving the 3D camera accordingly
-    float xOffset = xMousePos - gLastX;
-    float yOffset = gLastY - yMousePos; // reversed since y-coordinates go from bottom to top
-
-    // set the current positions into the last position variables
-    gLastX = xMousePos;
-    gLastY = yMousePos;
-
-    // move the 3D camera according to the calculated offsets
-    g_pCamera->ProcessMouseMovement(xOffset, yOffset);
+    // queue the new position to be handled by the next simulation step
+    INPUT_EVENT inputEvent;
+    inputEvent.type = INPUT_EVENT::MOUSE_MOVE_EVENT;
+    inputEvent.time = glfwGetTime();
+    inputEvent.key = 0;
+    inputEvent.action = 0;
+    inputEvent.binding = ACTION_NONE;
+    inputEvent.x = xMousePos;
+    inputEvent.y = yMousePos;
+    QueueInputEvent(inputEvent);
+
+    // the camera will move so the displayed frame is out of date
+    gRedrawRequested = true;
 }
 
 /***********************************************************
@@ -155,87 +388,243 @@ void ViewManager::Mouse_Position_Callback(GLFWwindow* window, double xMousePos,
  ***********************************************************/
 void ViewManager::Scroll_Callback(GLFWwindow* window, double xoffset, double yoffset)
 {
-    // Adjust the sensitivity multiplier for scroll speed
-    float sensitivity = 2.0f; // Increase this value for faster scroll adjustment
-    g_pCamera->ProcessMouseScroll(static_cast<float>(yoffset) * sensitivity);
+    // queue the scroll offsets to be handled by the next simulation step
+    INPUT_EVENT inputEvent;
+    inputEvent.type = INPUT_EVENT::SCROLL_EVENT;
+    inputEvent.time = glfwGetTime();
+    inputEvent.key = 0;
+    inputEvent.action = 0;
+    inputEvent.binding = ACTION_NONE;
+    inputEvent.x = xoffset;
+    inputEvent.y = yoffset;
+    QueueInputEvent(inputEvent);
+
+    // the camera speed or zoom will change so redraw the frame
+    gRedrawRequested = true;
 }
 
 /***********************************************************
- *  ProcessKeyboardEvents()
+ *  Key_Callback()
  *
- *  This method is called to process any keyboard events
- *  that may be waiting in the event queue.
+ *  This method is automatically called from GLFW whenever
+ *  a key is pressed or released within the active GLFW
+ *  display window.
  ***********************************************************/
-void ViewManager::ProcessKeyboardEvents()
+void ViewManager::Key_Callback(GLFWwindow*, int key, int, int action, int)
 {
-    // close the window if the escape key has been pressed
-    if (glfwGetKey(m_pWindow, GLFW_KEY_ESCAPE) == GLFW_PRESS)
-    {
-        glfwSetWindowShouldClose(m_pWindow, true);
-    }
-
-    // if the camera object is null, then exit this method
-    if (NULL == g_pCamera)
+    // key repeats don't change the state of any action
+    if ((action == GLFW_REPEAT) ||
+        (key < 0) || (key > GLFW_KEY_LAST))
     {
         return;
     }
 
-    // process camera zooming in and out
-    if (glfwGetKey(m_pWindow, GLFW_KEY_W) == GLFW_PRESS)
+    // the action is looked up when the key is pressed, and the
+    // release ends that same action even if the key was rebound
+    // while it was held
+    INPUT_ACTION binding = ACTION_NONE;
+    if (action == GLFW_PRESS)
     {
-        g_pCamera->ProcessKeyboard(FORWARD, gDeltaTime);
+        binding = gKeyBindings[key];
+        gKeyPressedActions[key] = binding;
     }
-    if (glfwGetKey(m_pWindow, GLFW_KEY_S) == GLFW_PRESS)
+    else
     {
-        g_pCamera->ProcessKeyboard(BACKWARD, gDeltaTime);
+        binding = gKeyPressedActions[key];
+        gKeyPressedActions[key] = ACTION_NONE;
     }
 
-    // process camera panning left and right
-    if (glfwGetKey(m_pWindow, GLFW_KEY_A) == GLFW_PRESS)
+    // presses of keys without a bound action don't need to be
+    // queued, while releases always are
+    if ((action == GLFW_PRESS) && (binding == ACTION_NONE))
     {
-        g_pCamera->ProcessKeyboard(LEFT, gDeltaTime);
+        return;
     }
-    if (glfwGetKey(m_pWindow, GLFW_KEY_D) == GLFW_PRESS)
+
+    // queue the key change to be handled by the next simulation step
+    INPUT_EVENT inputEvent;
+    inputEvent.type = INPUT_EVENT::KEY_EVENT;
+    inputEvent.time = glfwGetTime();
+    inputEvent.key = key;
+    inputEvent.action = action;
+    inputEvent.binding = binding;
+    inputEvent.x = 0.0;
+    inputEvent.y = 0.0;
+    QueueInputEvent(inputEvent);
+
+    gRedrawRequested = true;
+}
+
+/***********************************************************
+ *  Window_Refresh_Callback()
+ *
+ *  This method is automatically called from GLFW whenever
+ *  the contents of the display window need to be redrawn,
+ *  such as after being resized or uncovered.
+ ***********************************************************/
+void ViewManager::Window_Refresh_Callback(GLFWwindow*)
+{
+    gRedrawRequested = true;
+}
+
+/***********************************************************
+ *  BindKey()
+ *
+ *  This method is used to bind a keyboard key to an input
+ *  action, replacing any action previously bound to it.
+ ***********************************************************/
+void ViewManager::BindKey(int key, INPUT_ACTION action)
+{
+    if ((key >= 0) && (key <= GLFW_KEY_LAST))
     {
-        g_pCamera->ProcessKeyboard(RIGHT, gDeltaTime);
+        gKeyBindings[key] = action;
     }
+}
 
-    // process camera moving up and down
-    if (glfwGetKey(m_pWindow, GLFW_KEY_Q) == GLFW_PRESS)
+/***********************************************************
+ *  ProcessInputEvents()
+ *
+ *  This method is called once per simulation step to handle
+ *  the queued input events received up to the end of the
+ *  step.  Mouse movement and scrolling are combined into one
+ *  camera update per step.
+ ***********************************************************/
+void ViewManager::ProcessInputEvents(double stepEndTime, float timestep)
+{
+    INPUT_EVENT inputEvent;
+    float xOffset = 0.0f;
+    float yOffset = 0.0f;
+    float scrollOffset = 0.0f;
+    bool bMouseMoved = false;
+
+    FlushOverflowEvents();
+    while ((gInputQueue.Peek(inputEvent) == true) &&
+        (inputEvent.time <= stepEndTime))
     {
-        g_pCamera->ProcessKeyboard(UP, gDeltaTime);
+        gInputQueue.Pop();
+        FlushOverflowEvents();
+
+        switch (inputEvent.type)
+        {
+        case INPUT_EVENT::KEY_EVENT:
+        {
+            INPUT_ACTION action = (INPUT_ACTION)inputEvent.binding;
+            if (inputEvent.action == GLFW_PRESS)
+            {
+                gActionHeld[action] = true;
+                gActionTapped[action] = true;
+                PerformAction(action);
+            }
+            else
+            {
+                gActionHeld[action] = false;
+            }
+            break;
+        }
+        case INPUT_EVENT::MOUSE_MOVE_EVENT:
+            // when the first mouse move event is received, this needs to be recorded so that
+            // all subsequent mouse moves can correctly calculate the X position offset and Y
+            // position offset for proper operation
+            if (gFirstMouse)
+            {
+                gLastX = inputEvent.x;
+                gLastY = inputEvent.y;
+                gFirstMouse = false;
+            }
+
+            // calculate the X offset and Y offset values for moving the 3D camera accordingly
+            xOffset += (float)(inputEvent.x - gLastX);
+            yOffset += (float)(gLastY - inputEvent.y); // reversed since y-coordinates go from bottom to top
+
+            // set the current positions into the last position variables
+            gLastX = inputEvent.x;
+            gLastY = inputEvent.y;
+            bMouseMoved = true;
+            break;
+        case INPUT_EVENT::SCROLL_EVENT:
+            scrollOffset += (float)inputEvent.y;
+            break;
+        }
     }
-    if (glfwGetKey(m_pWindow, GLFW_KEY_E) == GLFW_PRESS)
+
+    // if the camera object is null, then exit this method
+    if (NULL == g_pCamera)
     {
-        g_pCamera->ProcessKeyboard(DOWN, gDeltaTime);
+        return;
     }
 
-    // change between different projection views
-    if (glfwGetKey(m_pWindow, GLFW_KEY_P) == GLFW_PRESS)
+    // move the 3D camera according to the combined offsets
+    if (bMouseMoved)
     {
-        bOrthographicProjection = false;
+        g_pCamera->ProcessMouseMovement(xOffset, yOffset);
     }
-    if (glfwGetKey(m_pWindow, GLFW_KEY_O) == GLFW_PRESS)
+    if (scrollOffset != 0.0f)
     {
-        bOrthographicProjection = true;
+        g_pCamera->ProcessMouseScroll(scrollOffset * SCROLL_SENSITIVITY);
     }
 
-    // set different camera views
-    if (glfwGetKey(m_pWindow, GLFW_KEY_1) == GLFW_PRESS)
-    {
-        SetCameraView(1); // Front view
-    }
-    if (glfwGetKey(m_pWindow, GLFW_KEY_2) == GLFW_PRESS)
+    // process camera zooming, panning and moving up and down for
+    // keys held during the step or tapped within it
+    for (int i = 0; i < MOVEMENT_ACTION_COUNT; i++)
     {
-        SetCameraView(2); // Right view
+        INPUT_ACTION action = g_MovementActions[i].action;
+        if (gActionHeld[action] || gActionTapped[action])
+        {
+            g_pCamera->ProcessKeyboard(g_MovementActions[i].direction, timestep);
+        }
     }
-    if (glfwGetKey(m_pWindow, GLFW_KEY_3) == GLFW_PRESS)
+
+    for (int i = 0; i < ACTION_COUNT; i++)
     {
-        SetCameraView(3); // Top view
+        gActionTapped[i] = false;
     }
-    if (glfwGetKey(m_pWindow, GLFW_KEY_4) == GLFW_PRESS)
+}
+
+/***********************************************************
+ *  PerformAction()
+ *
+ *  This method is called once when the key bound to an
+ *  action is pressed, to perform the actions that are not
+ *  continuous camera movements.
+ ***********************************************************/
+void ViewManager::PerformAction(INPUT_ACTION action)
+{
+    switch (action)
     {
-        SetCameraView(4); // Back view
+    // close the window
+    case ACTION_CLOSE_WINDOW:
+        glfwSetWindowShouldClose(m_pWindow, true);
+        break;
+    // change between different projection views
+    case ACTION_PERSPECTIVE:
+        bOrthographicProjection = false;
+        break;
+    case ACTION_ORTHOGRAPHIC:
+        bOrthographicProjection = true;
+        break;
+    // set different camera views
+    case ACTION_VIEW_FRONT:
+        SetCameraView(1);
+        break;
+    case ACTION_VIEW_RIGHT:
+        SetCameraView(2);
+        break;
+    case ACTION_VIEW_TOP:
+        SetCameraView(3);
+        break;
+    case ACTION_VIEW_BACK:
+        SetCameraView(4);
+        break;
+    case ACTION_VIEW_QUAD:
+        ToggleQuadView();
+        break;
+    // save the frame that shows the key press
+    case ACTION_SCREENSHOT:
+        gScreenshotRequested = true;
+        gRedrawRequested = true;
+        break;
+    default:
+        break;
     }
 }
 
@@ -252,16 +641,49 @@ void ViewManager::PrepareSceneView()
     glm::mat4 projection;
 
     // per-frame timing
-    float currentFrame = glfwGetTime();
-    gDeltaTime = currentFrame - gLastFrame;
-    gLastFrame = currentFrame;
+    double currentFrameTime = glfwGetTime();
+    double frameTime = currentFrameTime - gLastFrameTime;
+    gLastFrameTime = currentFrameTime;
+    if (frameTime > MAX_FRAME_TIME)
+    {
+        frameTime = MAX_FRAME_TIME;
+    }
+    gAccumulator += frameTime;
+
+    // the pending redraw is being serviced by this frame
+    gRedrawRequested = false;
+
+    // run as many fixed simulation steps as the elapsed time
+    // allows, so that camera movement doesn't depend on the
+    // frame rate
+    while (gAccumulator >= SIMULATION_TIMESTEP)
+    {
+        gPreviousState = gCurrentState;
+
+        // handle the input events received up to the end of this step
+        double stepEndTime = currentFrameTime - (gAccumulator - SIMULATION_TIMESTEP);
+        ProcessInputEvents(stepEndTime, (float)SIMULATION_TIMESTEP);
 
-    // process any keyboard events that may be waiting in the 
-    // event queue
-    ProcessKeyboardEvents();
+        gCurrentState = CaptureCameraState(g_pCamera);
+        if (gCameraSnapped)
+        {
+            gPreviousState = gCurrentState;
+            gCameraSnapped = false;
+        }
 
-    // get the current view matrix from the camera
-    view = g_pCamera->GetViewMatrix();
+        gAccumulator -= SIMULATION_TIMESTEP;
+    }
+
+    // blend between the last two simulation steps by how far
+    // this frame is into the next step
+    float alpha = (float)(gAccumulator / SIMULATION_TIMESTEP);
+    CAMERA_STATE cameraState = InterpolateCameraState(gPreviousState, gCurrentState, alpha);
+
+    // get the current view matrix from the interpolated camera
+    view = glm::lookAt(
+        cameraState.position,
+        cameraState.position + cameraState.front,
+        cameraState.up);
 
     // define the current projection matrix
     if (bOrthographicProjection)
@@ -270,9 +692,15 @@ void ViewManager::PrepareSceneView()
     }
     else
     {
-        projection = glm::perspective(glm::radians(g_pCamera->Zoom), (GLfloat)WINDOW_WIDTH / (GLfloat)WINDOW_HEIGHT, 0.1f, 100.0f);
+        projection = glm::perspective(glm::radians(cameraState.zoom), (GLfloat)WINDOW_WIDTH / (GLfloat)WINDOW_HEIGHT, 0.1f, 100.0f);
     }
 
+    // keep the view for the scene objects that are drawn with
+    // programs other than the shader manager program
+    gViewMatrix = view;
+    gProjectionMatrix = projection;
+    gViewPosition = cameraState.position;
+
     // if the shader manager object is valid
     if (NULL != m_pShaderManager)
     {
@@ -281,7 +709,7 @@ void ViewManager::PrepareSceneView()
         // set the view matrix into the shader for proper rendering
         m_pShaderManager->setMat4Value(g_ProjectionName, projection);
         // set the view position of the camera into the shader for proper rendering
-        m_pShaderManager->setVec3Value("viewPosition", g_pCamera->Position);
+        m_pShaderManager->setVec3Value("viewPosition", cameraState.position);
     }
 }
 
@@ -293,34 +721,64 @@ void ViewManager::PrepareSceneView()
  ***********************************************************/
 void ViewManager::SetCameraView(int view)
 {
-    switch (view)
+    // 1 is the front view, 2 the right, 3 the top and 4 the back
+    if ((view >= 1) && (view <= PRESET_VIEW_COUNT))
     {
-    case 1: // Front view
-        bOrthographicProjection = true;
-        g_pCamera->Position = glm::vec3(0.0f, 4.0f, 10.0f);
-        g_pCamera->Up = glm::vec3(0.0f, 1.0f, 0.0f);
-        g_pCamera->Front = glm::vec3(0.0f, 0.0f, -1.0f);
-        break;
-    case 2: // Right view
         bOrthographicProjection = true;
-        g_pCamera->Position = glm::vec3(10.0f, 4.0f, 0.0f);
-        g_pCamera->Up = glm::vec3(0.0f, 1.0f, 0.0f);
-        g_pCamera->Front = glm::vec3(-1.0f, 0.0f, 0.0f);
-        break;
-    case 3: // Top view
-        bOrthographicProjection = true;
-        g_pCamera->Position = glm::vec3(0.0f, 7.0f, 0.0f);
-        g_pCamera->Up = glm::vec3(-1.0f, 0.0f, 0.0f);
-        g_pCamera->Front = glm::vec3(0.0f, -1.0f, 0.0f);
-        break;
-    case 4: // Back view
-        bOrthographicProjection = true;
-        g_pCamera->Position = glm::vec3(0.0f, 4.0f, -10.0f);
-        g_pCamera->Up = glm::vec3(0.0f, 1.0f, 0.0f);
-        g_pCamera->Front = glm::vec3(0.0f, 0.0f, 1.0f);
-        break;
-    default:
-        break;
+        g_pCamera->Position = g_PresetViews[view - 1].position;
+        g_pCamera->Up = g_PresetViews[view - 1].up;
+        g_pCamera->Front = g_PresetViews[view - 1].front;
+        gQuadView = false;
+    }
+
+    // the camera has been moved to a new view
+    gCameraSnapped = true;
+    gRedrawRequested = true;
+}
+
+/***********************************************************
+ *  ToggleQuadView()
+ *
+ *  This method toggles between the camera view and the four
+ *  preset views shown at once, one in each quarter of the
+ *  window.
+ ***********************************************************/
+void ViewManager::ToggleQuadView()
+{
+    gQuadView = !gQuadView;
+    gRedrawRequested = true;
+}
+
+/***********************************************************
+ *  IsQuadView()
+ *
+ *  This method returns whether the four preset views are
+ *  shown at once.
+ ***********************************************************/
+bool ViewManager::IsQuadView() const
+{
+    return(gQuadView);
+}
+
+/***********************************************************
+ *  GetQuadViews()
+ *
+ *  This method returns the view, orthographic projection and
+ *  camera position of each of the four preset views.  Each
+ *  view takes a quarter of the window, which has the same
+ *  shape as the whole window, so the projection is the same
+ *  as that of the single orthographic view.
+ ***********************************************************/
+void ViewManager::GetQuadViews(glm::mat4* views, glm::mat4* projections, glm::vec3* viewPositions) const
+{
+    for (int i = 0; i < PRESET_VIEW_COUNT; i++)
+    {
+        views[i] = glm::lookAt(
+            g_PresetViews[i].position,
+            g_PresetViews[i].position + g_PresetViews[i].front,
+            g_PresetViews[i].up);
+        projections[i] = glm::ortho(-10.0f, 10.0f, -10.0f, 10.0f, 0.1f, 100.0f);
+        viewPositions[i] = g_PresetViews[i].position;
     }
 }
 
@@ -332,4 +790,114 @@ void ViewManager::SetCameraView(int view)
 void ViewManager::ToggleProjection()
 {
     bOrthographicProjection = !bOrthographicProjection;
+    gRedrawRequested = true;
+}
+
+/***********************************************************
+ *  RequestRedraw()
+ *
+ *  This method is used to request that a new frame be
+ *  rendered even though the view has not changed.
+ ***********************************************************/
+void ViewManager::RequestRedraw()
+{
+    gRedrawRequested = true;
+}
+
+/***********************************************************
+ *  TakeScreenshotRequest()
+ *
+ *  This method returns whether the screenshot key has been
+ *  pressed since it was last called, and clears the request.
+ ***********************************************************/
+bool ViewManager::TakeScreenshotRequest()
+{
+    bool bRequested = gScreenshotRequested;
+    gScreenshotRequested = false;
+    return(bRequested);
+}
+
+/***********************************************************
+ *  IsRedrawNeeded()
+ *
+ *  This method is used to check whether the displayed frame
+ *  is out of date.  A frame is needed after any input event
+ *  or camera change, and for every frame while one of the
+ *  camera movement keys is being held down.
+ ***********************************************************/
+bool ViewManager::IsRedrawNeeded()
+{
+    if (gRedrawRequested)
+    {
+        return(true);
+    }
+
+    // input events are waiting for the next simulation step
+    if (!gInputQueue.IsEmpty() || !gOverflowEvents.empty())
+    {
+        return(true);
+    }
+
+    // held movement keys keep the camera moving between events
+    for (int i = 0; i < MOVEMENT_ACTION_COUNT; i++)
+    {
+        if (gActionHeld[g_MovementActions[i].action])
+        {
+            return(true);
+        }
+    }
+
+    // frames are still being interpolated towards the latest
+    // simulated camera state
+    if (!IsSameCameraState(gPreviousState, gCurrentState))
+    {
+        return(true);
+    }
+
+    return(false);
+}
+
+/***********************************************************
+ *  ResetFrameTiming()
+ *
+ *  This method is called after the render loop has been
+ *  waiting for events, so that the idle time is not counted
+ *  as camera movement time in the next frame.
+ ***********************************************************/
+void ViewManager::ResetFrameTiming()
+{
+    gLastFrameTime = glfwGetTime();
+}
+
+/***********************************************************
+ *  GetViewMatrix()
+ *
+ *  This method returns the view matrix of the last frame
+ *  that was prepared.
+ ***********************************************************/
+glm::mat4 ViewManager::GetViewMatrix() const
+{
+    return(gViewMatrix);
+}
+
+/***********************************************************
+ *  GetProjectionMatrix()
+ *
+ *  This method returns the projection matrix of the last
+ *  frame that was prepared.
+ ***********************************************************/
+glm::mat4 ViewManager::GetProjectionMatrix() const
+{
+    return(gProjectionMatrix);
+}
+
+/***********************************************************
+ *  GetViewPosition()
+ *
+ *  This method returns the camera position of the last
+ *  frame that was prepared.
+ ***********************************************************/
+glm::vec3 ViewManager::GetViewPosition() const
+{
+    return(gViewPosition);
 }
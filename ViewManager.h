@@ -18,6 +18,28 @@
 class ViewManager
 {
 public:
+    // actions that keyboard keys can be bound to
+    enum INPUT_ACTION
+    {
+        ACTION_NONE = 0,
+        ACTION_CLOSE_WINDOW,
+        ACTION_MOVE_FORWARD,
+        ACTION_MOVE_BACKWARD,
+        ACTION_MOVE_LEFT,
+        ACTION_MOVE_RIGHT,
+        ACTION_MOVE_UP,
+        ACTION_MOVE_DOWN,
+        ACTION_PERSPECTIVE,
+        ACTION_ORTHOGRAPHIC,
+        ACTION_VIEW_FRONT,
+        ACTION_VIEW_RIGHT,
+        ACTION_VIEW_TOP,
+        ACTION_VIEW_BACK,
+        ACTION_VIEW_QUAD,
+        ACTION_SCREENSHOT,
+        ACTION_COUNT
+    };
+
     // constructor
     ViewManager(ShaderManager* pShaderManager);
     // destructor
@@ -29,14 +51,22 @@ public:
     // scroll callback for adjusting the movement speed
     static void Scroll_Callback(GLFWwindow* window, double xoffset, double yoffset);
 
+    // key callback for invalidating the displayed frame on key input
+    static void Key_Callback(GLFWwindow* window, int key, int scancode, int action, int mods);
+
+    // refresh callback for redrawing after the window contents are damaged
+    static void Window_Refresh_Callback(GLFWwindow* window);
+
 private:
     // pointer to shader manager object
     ShaderManager* m_pShaderManager;
     // active OpenGL display window
     GLFWwindow* m_pWindow;
 
-    // process keyboard events for interaction with the 3D scene
-    void ProcessKeyboardEvents();
+    // process queued input events for interaction with the 3D scene
+    void ProcessInputEvents(double stepEndTime, float timestep);
+    // perform an action when its key is pressed
+    void PerformAction(INPUT_ACTION action);
 
 public:
     // create the initial OpenGL display window
@@ -45,10 +75,41 @@ public:
     // prepare the conversion from 3D object display to 2D scene display
     void PrepareSceneView();
 
+    // bind a keyboard key to an input action
+    void BindKey(int key, INPUT_ACTION action);
+
     // toggle between perspective and orthographic views
     void ToggleProjection();
 
     // set camera view
     void SetCameraView(int view);
+
+    // toggle showing the front, right, top and back views at once
+    void ToggleQuadView();
+
+    // check whether the four preset views are shown at once
+    bool IsQuadView() const;
+
+    // the view, projection and camera position of each of the four
+    // preset views, in the order of SetCameraView()
+    void GetQuadViews(glm::mat4* views, glm::mat4* projections, glm::vec3* viewPositions) const;
+
+    // check whether a screenshot has been asked for since the
+    // last call
+    bool TakeScreenshotRequest();
+
+    // request that a new frame be rendered
+    void RequestRedraw();
+
+    // check whether the view has changed since the last frame
+    bool IsRedrawNeeded();
+
+    // restart the frame timing after the render loop has been idle
+    void ResetFrameTiming();
+
+    // the view, projection and camera position of the last prepared frame
+    glm::mat4 GetViewMatrix() const;
+    glm::mat4 GetProjectionMatrix() const;
+    glm::vec3 GetViewPosition() const;
 };
 
@@ -0,0 +1,233 @@
+///////////////////////////////////////////////////////////////////////////////
+// deferredlighting.glsl
+// ============
+// compute shader for the deferred lighting pass.  each work group
+// covers one 16x16 pixel tile: it finds the depth range of the tile,
+// gathers the lights whose range reaches that part of the view, then
+// shades every pixel of the tile with only those lights
+//
+//  Created for CS-330-Computational Graphics and Visualization
+///////////////////////////////////////////////////////////////////////////////
+
+#version 430 core
+
+// must match DeferredRenderer::TILE_SIZE
+layout(local_size_x = 16, local_size_y = 16) in;
+
+// most lights kept for one tile, any more are ignored
+#define MAX_TILE_LIGHTS 256
+
+// light types, matching LIGHT_SOURCE::LIGHT_TYPE
+#define LIGHT_POINT 0
+#define LIGHT_SPOT 1
+
+// G-buffer written by the scene variants with GBUFFER_OUTPUT
+uniform sampler2D albedoMaterialTexture;
+uniform sampler2D normalTexture;
+uniform sampler2D depthTexture;
+
+layout(rgba8) writeonly uniform image2D outputImage;
+
+// light layout written by DeferredRenderer
+struct PackedLight
+{
+	vec4 positionRange;
+	vec4 directionType;
+	vec4 ambientFocal;
+	vec4 diffuseIntensity;
+	vec4 specular;
+	vec4 cone;
+};
+
+struct PackedMaterial
+{
+	vec4 ambient;
+	vec4 diffuse;
+	vec4 specular;
+};
+
+layout(std430, binding = 3) readonly buffer LightBuffer
+{
+	PackedLight packedLights[];
+};
+
+layout(std430, binding = 4) readonly buffer MaterialBuffer
+{
+	PackedMaterial materials[];
+};
+
+uniform int lightCount;
+uniform ivec2 renderSize;
+uniform mat4 view;
+uniform mat4 inverseProjection;
+uniform mat4 inverseView;
+uniform vec3 viewPosition;
+// ambient light color already scaled by its intensity
+uniform vec3 ambientLight;
+uniform bool bUseLighting;
+uniform vec4 backgroundColor;
+
+// depth range of the covered pixels, as the bits of the depth
+// values, which sort the same way as the positive floats
+shared uint tileMinDepth;
+shared uint tileMaxDepth;
+shared uint tileLightCount;
+shared uint tileLights[MAX_TILE_LIGHTS];
+
+// unpack a normal from the two octahedral coordinates
+vec3 DecodeNormal(vec2 encoded)
+{
+	vec2 e = encoded * 2.0 - 1.0;
+	vec3 normal = vec3(e, 1.0 - abs(e.x) - abs(e.y));
+	if (normal.z < 0.0)
+	{
+		vec2 signs = vec2(normal.x >= 0.0 ? 1.0 : -1.0, normal.y >= 0.0 ? 1.0 : -1.0);
+		normal.xy = (1.0 - abs(normal.yx)) * signs;
+	}
+	return normalize(normal);
+}
+
+// rebuild the view space position of a point on the screen
+vec3 GetViewPosition(vec2 pixel, float depth)
+{
+	vec4 clip = vec4(pixel / vec2(renderSize) * 2.0 - 1.0, depth * 2.0 - 1.0, 1.0);
+	vec4 position = inverseProjection * clip;
+	return position.xyz / position.w;
+}
+
+// phong lighting from one light source, faded out smoothly to
+// nothing at the light's range and outside a spot light's cone,
+// the same as CalculateLight() in the scene fragment shader
+vec3 CalculateLight(PackedLight light, PackedMaterial material, vec3 position, vec3 normal, vec3 viewDirection)
+{
+	vec3 toLight = light.positionRange.xyz - position;
+	float lightDistance = length(toLight);
+	float range = light.positionRange.w;
+	if (lightDistance >= range)
+	{
+		return vec3(0.0);
+	}
+	vec3 lightDirection = toLight / lightDistance;
+
+	float falloff = lightDistance / range;
+	falloff = clamp(1.0 - falloff * falloff * falloff * falloff, 0.0, 1.0);
+	float attenuation = falloff * falloff;
+	if (int(light.directionType.w) == LIGHT_SPOT)
+	{
+		float spotCosine = dot(-lightDirection, light.directionType.xyz);
+		attenuation *= smoothstep(light.cone.y, light.cone.x, spotCosine);
+	}
+
+	vec3 ambient = light.ambientFocal.rgb * material.ambient.rgb * material.ambient.w;
+
+	float diffuseImpact = max(dot(normal, lightDirection), 0.0);
+	vec3 diffuse = diffuseImpact * light.diffuseIntensity.rgb * material.diffuse.rgb;
+
+	vec3 reflectDirection = reflect(-lightDirection, normal);
+	float specularComponent = pow(max(dot(viewDirection, reflectDirection), 0.0), light.ambientFocal.w);
+	vec3 specular = light.diffuseIntensity.w * specularComponent * light.specular.rgb * material.specular.rgb;
+
+	return (ambient + diffuse + specular) * attenuation;
+}
+
+void main()
+{
+	ivec2 pixel = ivec2(gl_GlobalInvocationID.xy);
+	bool bInside = all(lessThan(pixel, renderSize));
+
+	if (gl_LocalInvocationIndex == 0u)
+	{
+		tileMinDepth = 0xFFFFFFFFu;
+		tileMaxDepth = 0u;
+		tileLightCount = 0u;
+	}
+	barrier();
+
+	// pixels that no object covered keep the cleared depth of one
+	float depth = 1.0;
+	if (bInside)
+	{
+		depth = texelFetch(depthTexture, pixel, 0).r;
+	}
+	bool bCovered = bInside && (depth < 1.0);
+	if (bCovered)
+	{
+		atomicMin(tileMinDepth, floatBitsToUint(depth));
+		atomicMax(tileMaxDepth, floatBitsToUint(depth));
+	}
+	barrier();
+
+	if (tileMinDepth <= tileMaxDepth)
+	{
+		// view space box around the part of the tile's frustum
+		// between the nearest and farthest covered pixels
+		vec2 tileStart = vec2(gl_WorkGroupID.xy * gl_WorkGroupSize.xy);
+		vec2 tileEnd = min(tileStart + vec2(gl_WorkGroupSize.xy), vec2(renderSize));
+		float minDepth = uintBitsToFloat(tileMinDepth);
+		float maxDepth = uintBitsToFloat(tileMaxDepth);
+		vec3 boxMin = vec3(1.0e30);
+		vec3 boxMax = vec3(-1.0e30);
+		for (int corner = 0; corner < 8; corner++)
+		{
+			vec2 cornerPixel = vec2(
+				((corner & 1) != 0) ? tileEnd.x : tileStart.x,
+				((corner & 2) != 0) ? tileEnd.y : tileStart.y);
+			float cornerDepth = ((corner & 4) != 0) ? maxDepth : minDepth;
+			vec3 position = GetViewPosition(cornerPixel, cornerDepth);
+			boxMin = min(boxMin, position);
+			boxMax = max(boxMax, position);
+		}
+
+		// every thread tests a share of the lights against the box
+		uint threadCount = gl_WorkGroupSize.x * gl_WorkGroupSize.y;
+		for (uint i = gl_LocalInvocationIndex; i < uint(lightCount); i += threadCount)
+		{
+			vec4 positionRange = packedLights[i].positionRange;
+			vec3 center = (view * vec4(positionRange.xyz, 1.0)).xyz;
+			vec3 offset = center - clamp(center, boxMin, boxMax);
+			if (dot(offset, offset) < positionRange.w * positionRange.w)
+			{
+				uint slot = atomicAdd(tileLightCount, 1u);
+				if (slot < MAX_TILE_LIGHTS)
+				{
+					tileLights[slot] = i;
+				}
+			}
+		}
+	}
+	barrier();
+
+	if (!bInside)
+	{
+		return;
+	}
+	if (!bCovered)
+	{
+		imageStore(outputImage, pixel, backgroundColor);
+		return;
+	}
+
+	vec4 albedoMaterial = texelFetch(albedoMaterialTexture, pixel, 0);
+	int materialIndex = int(albedoMaterial.a * 255.0 + 0.5);
+	vec3 color = albedoMaterial.rgb;
+
+	// surfaces without a material are left unlit
+	if (bUseLighting && (materialIndex > 0))
+	{
+		PackedMaterial material = materials[materialIndex - 1];
+		vec3 viewSpacePosition = GetViewPosition(vec2(pixel) + 0.5, depth);
+		vec3 position = (inverseView * vec4(viewSpacePosition, 1.0)).xyz;
+		vec3 normal = DecodeNormal(texelFetch(normalTexture, pixel, 0).rg);
+		vec3 viewDirection = normalize(viewPosition - position);
+
+		vec3 lighting = ambientLight;
+		uint tileLightTotal = min(tileLightCount, uint(MAX_TILE_LIGHTS));
+		for (uint i = 0u; i < tileLightTotal; i++)
+		{
+			lighting += CalculateLight(packedLights[tileLights[i]], material, position, normal, viewDirection);
+		}
+		color = lighting * albedoMaterial.rgb;
+	}
+
+	imageStore(outputImage, pixel, vec4(color, 1.0));
+}
@@ -0,0 +1,153 @@
+///////////////////////////////////////////////////////////////////////////////
+// impostorfragment.glsl
+// ============
+// fragment shader that blends the baked views of a distant group of
+// objects, and places the fragment on the baked surface
+//
+//  Created for CS-330-Computational Graphics and Visualization
+///////////////////////////////////////////////////////////////////////////////
+
+#version 330 core
+
+in vec3 fragmentPosition;
+flat in vec4 impostorCenterRadius;
+flat in float impostorLayer;
+
+out vec4 outFragmentColor;
+
+// baked lit color with the coverage in alpha, and the depth of the
+// surface across the bounding sphere, one layer per group
+uniform sampler2DArray impostorColor;
+uniform sampler2DArray impostorDepth;
+// frames along each side of the grid, and pixels along each side
+// of a frame
+uniform float frameGrid;
+uniform float frameSize;
+
+uniform mat4 view;
+uniform mat4 projection;
+uniform vec3 viewPosition;
+
+// unpack a direction from its octahedral coordinates, with the
+// upper half of the sphere in the middle of the square
+vec3 DecodeDirection(vec2 encoded)
+{
+	encoded = encoded * 2.0 - 1.0;
+	vec3 direction = vec3(encoded.x, 1.0 - abs(encoded.x) - abs(encoded.y), encoded.y);
+	if (direction.y < 0.0)
+	{
+		vec2 signs = vec2(direction.x >= 0.0 ? 1.0 : -1.0, direction.z >= 0.0 ? 1.0 : -1.0);
+		direction.xz = (1.0 - abs(direction.zx)) * signs;
+	}
+	return normalize(direction);
+}
+
+// pack a unit direction into its octahedral coordinates
+vec2 EncodeDirection(vec3 direction)
+{
+	direction /= abs(direction.x) + abs(direction.y) + abs(direction.z);
+	vec2 encoded = direction.xz;
+	if (direction.y < 0.0)
+	{
+		vec2 signs = vec2(direction.x >= 0.0 ? 1.0 : -1.0, direction.z >= 0.0 ? 1.0 : -1.0);
+		encoded = (1.0 - abs(direction.zx)) * signs;
+	}
+	return encoded * 0.5 + 0.5;
+}
+
+// add one baked frame, sampled where the view ray crosses the
+// plane the frame was rendered onto
+void AddFrame(
+	vec2 frame,
+	float weight,
+	vec3 rayOrigin,
+	vec3 rayDirection,
+	inout vec4 color,
+	inout vec3 position,
+	inout float positionWeight)
+{
+	vec3 center = impostorCenterRadius.xyz;
+	float radius = impostorCenterRadius.w;
+
+	// the same camera axes the frame was baked with
+	vec3 direction = DecodeDirection(frame / (frameGrid - 1.0));
+	vec3 up = (abs(direction.y) > 0.999) ? vec3(0.0, 0.0, 1.0) : vec3(0.0, 1.0, 0.0);
+	vec3 right = normalize(cross(-direction, up));
+	up = cross(right, -direction);
+
+	float facing = dot(rayDirection, direction);
+	if ((weight <= 0.0) || (abs(facing) < 1.0e-4))
+	{
+		return;
+	}
+	vec3 planePoint = rayOrigin + rayDirection * (dot(center - rayOrigin, direction) / facing);
+	vec2 tileCoordinate = vec2(dot(planePoint - center, right), dot(planePoint - center, up)) / (2.0 * radius) + 0.5;
+	if (any(lessThan(tileCoordinate, vec2(0.0))) || any(greaterThan(tileCoordinate, vec2(1.0))))
+	{
+		return;
+	}
+
+	// stay half a pixel inside the frame so the filtering does not
+	// pick up the frames next to it
+	float halfPixel = 0.5 / frameSize;
+	tileCoordinate = clamp(tileCoordinate, vec2(halfPixel), vec2(1.0 - halfPixel));
+	vec3 atlasCoordinate = vec3((frame + tileCoordinate) / frameGrid, impostorLayer);
+
+	vec4 texel = texture(impostorColor, atlasCoordinate);
+	float depth = texture(impostorDepth, atlasCoordinate).r;
+	color += texel * weight;
+
+	// the surface lies along the frame direction from the plane,
+	// between the near and far sides of the bounding sphere
+	position += (planePoint + direction * radius * (1.0 - 2.0 * depth)) * texel.a * weight;
+	positionWeight += texel.a * weight;
+}
+
+void main()
+{
+	vec3 center = impostorCenterRadius.xyz;
+	float radius = impostorCenterRadius.w;
+
+	vec3 rayOrigin = viewPosition;
+	vec3 rayDirection = normalize(fragmentPosition - viewPosition);
+	if (projection[3][3] != 0.0)
+	{
+		rayDirection = -vec3(view[0][2], view[1][2], view[2][2]);
+		rayOrigin = fragmentPosition - rayDirection * radius * 2.0;
+	}
+
+	// the three frames around the direction the group is seen from,
+	// weighted by where that direction falls in their triangle
+	vec3 toView = (projection[3][3] != 0.0) ? -rayDirection : normalize(viewPosition - center);
+	vec2 grid = EncodeDirection(toView) * (frameGrid - 1.0);
+	vec2 base = min(floor(grid), vec2(frameGrid - 2.0));
+	vec2 fraction = grid - base;
+
+	vec4 color = vec4(0.0);
+	vec3 position = vec3(0.0);
+	float positionWeight = 0.0;
+	if (fraction.x + fraction.y < 1.0)
+	{
+		AddFrame(base, 1.0 - fraction.x - fraction.y, rayOrigin, rayDirection, color, position, positionWeight);
+		AddFrame(base + vec2(1.0, 0.0), fraction.x, rayOrigin, rayDirection, color, position, positionWeight);
+		AddFrame(base + vec2(0.0, 1.0), fraction.y, rayOrigin, rayDirection, color, position, positionWeight);
+	}
+	else
+	{
+		AddFrame(base + vec2(1.0, 1.0), fraction.x + fraction.y - 1.0, rayOrigin, rayDirection, color, position, positionWeight);
+		AddFrame(base + vec2(1.0, 0.0), 1.0 - fraction.y, rayOrigin, rayDirection, color, position, positionWeight);
+		AddFrame(base + vec2(0.0, 1.0), 1.0 - fraction.x, rayOrigin, rayDirection, color, position, positionWeight);
+	}
+
+	if (color.a < 0.5)
+	{
+		discard;
+	}
+
+	// the filtered color is weighted by the coverage, since the
+	// frames were cleared to nothing around the objects
+	outFragmentColor = vec4(color.rgb / color.a, 1.0);
+
+	vec4 clipPosition = projection * view * vec4(position / positionWeight, 1.0);
+	gl_FragDepth = (clipPosition.z / clipPosition.w) * 0.5 + 0.5;
+}
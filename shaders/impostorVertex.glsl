@@ -0,0 +1,56 @@
+///////////////////////////////////////////////////////////////////////////////
+// impostorvertex.glsl
+// ============
+// vertex shader for the camera facing quads that stand in for distant
+// groups of objects
+//
+//  Created for CS-330-Computational Graphics and Visualization
+///////////////////////////////////////////////////////////////////////////////
+
+#version 330 core
+
+// bounding sphere and atlas layer of the group, once per quad
+layout (location = 0) in vec4 inCenterRadius;
+layout (location = 1) in float inLayer;
+
+out vec3 fragmentPosition;
+flat out vec4 impostorCenterRadius;
+flat out float impostorLayer;
+
+uniform mat4 view;
+uniform mat4 projection;
+uniform vec3 viewPosition;
+
+void main()
+{
+	// the corners of the quad come from the vertex index, drawn as
+	// a strip of two triangles
+	vec2 corner = vec2(((gl_VertexID & 1) == 0) ? -1.0 : 1.0, ((gl_VertexID & 2) == 0) ? -1.0 : 1.0);
+
+	vec3 center = inCenterRadius.xyz;
+	float radius = inCenterRadius.w;
+	vec3 toView = viewPosition - center;
+	float distance = max(length(toView), radius * 1.01);
+	toView /= distance;
+	// an orthographic camera sees every group from the same side
+	if (projection[3][3] != 0.0)
+	{
+		toView = vec3(view[0][2], view[1][2], view[2][2]);
+		distance = radius * 1.0e3;
+	}
+
+	vec3 up = (abs(toView.y) > 0.999) ? vec3(0.0, 0.0, 1.0) : vec3(0.0, 1.0, 0.0);
+	vec3 right = normalize(cross(up, toView));
+	up = cross(toView, right);
+
+	// the outline of the sphere seen in perspective is a little
+	// larger than the sphere where it crosses the quad
+	float extent = radius * distance / sqrt(distance * distance - radius * radius);
+	vec3 worldPosition = center + (right * corner.x + up * corner.y) * extent;
+
+	fragmentPosition = worldPosition;
+	impostorCenterRadius = inCenterRadius;
+	impostorLayer = inLayer;
+
+	gl_Position = projection * view * vec4(worldPosition, 1.0);
+}
@@ -0,0 +1,340 @@
+///////////////////////////////////////////////////////////////////////////////
+// scenefragment.glsl
+// ============
+// fragment shader for the scene shader variants.  the features are
+// selected by the defines that ShaderVariantCache inserts after the
+// version line:
+//
+//   USE_TEXTURE       sample objectTexture instead of objectColor
+//   USE_LIGHTING      apply the material and light sources
+//   USE_TRANSPARENCY  keep the source alpha for blending
+//   LIGHT_COUNT       number of light sources, unrolled at compile time
+//   CLUSTERED_LIGHTING  read the lights reaching the fragment's cluster
+//                       from the storage buffers built by ClusteredLighting
+//   GBUFFER_OUTPUT    write the surface into the DeferredRenderer G-buffer
+//                     instead of a lit color
+//   USE_BAKED_LIGHTING  light static objects from the probe volume baked
+//                       by LightBaker instead of the light sources
+//   MULTI_VIEW        take the camera position from the view the geometry
+//                     stage drew the triangle into
+//   RECORDED_DRAWS    take the color or UV scale from the object record
+//                     the vertex stage read
+//
+//  Created for CS-330-Computational Graphics and Visualization
+///////////////////////////////////////////////////////////////////////////////
+
+#version 330 core
+
+#ifndef USE_TEXTURE
+#define USE_TEXTURE 0
+#endif
+#ifndef USE_LIGHTING
+#define USE_LIGHTING 0
+#endif
+#ifndef USE_TRANSPARENCY
+#define USE_TRANSPARENCY 0
+#endif
+#ifndef LIGHT_COUNT
+#define LIGHT_COUNT 0
+#endif
+#ifndef CLUSTERED_LIGHTING
+#define CLUSTERED_LIGHTING 0
+#endif
+#ifndef GBUFFER_OUTPUT
+#define GBUFFER_OUTPUT 0
+#endif
+#ifndef USE_BAKED_LIGHTING
+#define USE_BAKED_LIGHTING 0
+#endif
+#ifndef MULTI_VIEW
+#define MULTI_VIEW 0
+#endif
+#ifndef RECORDED_DRAWS
+#define RECORDED_DRAWS 0
+#endif
+
+#if CLUSTERED_LIGHTING
+#extension GL_ARB_shader_storage_buffer_object : require
+#endif
+
+in vec3 fragmentPosition;
+in vec3 fragmentVertexNormal;
+in vec2 fragmentTextureCoordinate;
+
+#if GBUFFER_OUTPUT
+layout(location = 0) out vec4 outAlbedoMaterial;
+layout(location = 1) out vec2 outEncodedNormal;
+
+// one more than the index of the object's material, zero for none
+uniform int materialIndex;
+
+// pack a unit normal into two octahedral coordinates
+vec2 EncodeNormal(vec3 normal)
+{
+	normal /= abs(normal.x) + abs(normal.y) + abs(normal.z);
+	vec2 encoded = normal.xy;
+	if (normal.z < 0.0)
+	{
+		vec2 signs = vec2(normal.x >= 0.0 ? 1.0 : -1.0, normal.y >= 0.0 ? 1.0 : -1.0);
+		encoded = (1.0 - abs(normal.yx)) * signs;
+	}
+	return encoded * 0.5 + 0.5;
+}
+#else
+out vec4 outFragmentColor;
+#endif
+
+#if RECORDED_DRAWS
+flat in vec4 fragmentObjectValue;
+#endif
+
+#if USE_TEXTURE
+uniform sampler2D objectTexture;
+#if RECORDED_DRAWS
+#define UVscale fragmentObjectValue.xy
+#else
+uniform vec2 UVscale;
+#endif
+#elif RECORDED_DRAWS
+#define objectColor fragmentObjectValue
+#else
+uniform vec4 objectColor;
+#endif
+
+#if USE_LIGHTING
+struct Material
+{
+	vec3 ambientColor;
+	float ambientStrength;
+	vec3 diffuseColor;
+	vec3 specularColor;
+	float shininess;
+};
+
+// light types, matching LIGHT_SOURCE::LIGHT_TYPE
+#define LIGHT_POINT 0
+#define LIGHT_SPOT 1
+
+struct LightSource
+{
+	int type;
+	vec3 position;
+	vec3 direction;
+	float range;
+	float innerConeCosine;
+	float outerConeCosine;
+	vec3 ambientColor;
+	vec3 diffuseColor;
+	vec3 specularColor;
+	float focalStrength;
+	float specularIntensity;
+};
+
+struct AmbientLight
+{
+	vec3 color;
+	float intensity;
+};
+
+uniform Material material;
+uniform AmbientLight ambientLight;
+#if MULTI_VIEW
+flat in vec3 fragmentViewPosition;
+#define viewPosition fragmentViewPosition
+#else
+uniform vec3 viewPosition;
+#endif
+
+// phong lighting from one light source, faded out smoothly to
+// nothing at the light's range and outside a spot light's cone
+vec3 CalculateLight(LightSource light, vec3 normal, vec3 viewDirection)
+{
+	vec3 toLight = light.position - fragmentPosition;
+	float lightDistance = length(toLight);
+	if (lightDistance >= light.range)
+	{
+		return vec3(0.0);
+	}
+	vec3 lightDirection = toLight / lightDistance;
+
+	float falloff = lightDistance / light.range;
+	falloff = clamp(1.0 - falloff * falloff * falloff * falloff, 0.0, 1.0);
+	float attenuation = falloff * falloff;
+	if (light.type == LIGHT_SPOT)
+	{
+		float spotCosine = dot(-lightDirection, light.direction);
+		attenuation *= smoothstep(light.outerConeCosine, light.innerConeCosine, spotCosine);
+	}
+
+	vec3 ambient = light.ambientColor * material.ambientColor * material.ambientStrength;
+
+	float diffuseImpact = max(dot(normal, lightDirection), 0.0);
+	vec3 diffuse = diffuseImpact * light.diffuseColor * material.diffuseColor;
+
+	vec3 reflectDirection = reflect(-lightDirection, normal);
+	float specularComponent = pow(max(dot(viewDirection, reflectDirection), 0.0), light.focalStrength);
+	vec3 specular = light.specularIntensity * specularComponent * light.specularColor * material.specularColor;
+
+	return (ambient + diffuse + specular) * attenuation;
+}
+
+#if USE_BAKED_LIGHTING
+// probe values written by LightBaker, see LightBaker::PROBE
+uniform sampler3D bakedDirectDirection;
+uniform sampler3D bakedDirectColor;
+uniform sampler3D bakedIndirectColor;
+uniform sampler3D bakedIndirectDirection;
+uniform vec3 bakedVolumeMin;
+uniform vec3 bakedVolumeSize;
+uniform float bakedCellSize;
+uniform float bakedFocalStrength;
+uniform float bakedSpecularIntensity;
+
+// light from the probes around the fragment.  the probes are
+// sampled half a cell out from the surface, so a surface is lit
+// by the probes in front of it rather than the ones behind it
+vec3 CalculateBakedLight(vec3 normal, vec3 viewDirection)
+{
+	vec3 samplePosition = fragmentPosition + normal * (0.5 * bakedCellSize);
+	vec3 coordinate = (samplePosition - bakedVolumeMin) / bakedVolumeSize;
+	vec4 directDirection = texture(bakedDirectDirection, coordinate);
+	vec4 directColor = texture(bakedDirectColor, coordinate);
+	vec4 indirectColor = texture(bakedIndirectColor, coordinate);
+	vec4 indirectDirection = texture(bakedIndirectDirection, coordinate);
+
+	vec3 bakedAmbient = vec3(directDirection.w, directColor.w, indirectColor.w);
+	vec3 ambient = bakedAmbient * material.ambientColor * material.ambientStrength;
+
+	// the filtered direction is shorter where the probes disagree
+	vec3 lightDirection = directDirection.xyz;
+	float directionLength = length(lightDirection);
+	lightDirection = (directionLength > 0.0) ? lightDirection / directionLength : normal;
+	float diffuseImpact = max(dot(normal, lightDirection), 0.0);
+	vec3 diffuse = diffuseImpact * directColor.rgb * material.diffuseColor;
+
+	vec3 reflectDirection = reflect(-lightDirection, normal);
+	float specularComponent = pow(max(dot(viewDirection, reflectDirection), 0.0), bakedFocalStrength);
+	vec3 specular = bakedSpecularIntensity * specularComponent * directColor.rgb * material.specularColor;
+
+	float indirectImpact = max(1.0 + dot(indirectDirection.xyz, normal), 0.0);
+	vec3 indirect = indirectImpact * indirectColor.rgb * material.diffuseColor;
+
+	return ambient + diffuse + specular + indirect;
+}
+#endif
+
+#if CLUSTERED_LIGHTING
+// light layout written by ClusteredLighting
+struct PackedLight
+{
+	vec4 positionRange;
+	vec4 directionType;
+	vec4 ambientFocal;
+	vec4 diffuseIntensity;
+	vec4 specular;
+	vec4 cone;
+};
+
+layout(std430) readonly buffer LightBuffer
+{
+	PackedLight packedLights[];
+};
+
+// offset and count into the light index list for each cluster
+layout(std430) readonly buffer ClusterBuffer
+{
+	uvec2 clusterRanges[];
+};
+
+layout(std430) readonly buffer LightIndexBuffer
+{
+	uint lightIndices[];
+};
+
+uniform mat4 view;
+uniform ivec3 clusterCounts;
+// clusters per pixel across and down the viewport
+uniform vec2 clusterTileScale;
+// window position of the corner of the viewport
+uniform vec2 clusterViewportOrigin;
+// depth slice = log(view depth) * scale + bias
+uniform float clusterDepthScale;
+uniform float clusterDepthBias;
+
+LightSource UnpackLight(PackedLight packed)
+{
+	LightSource light;
+	light.type = int(packed.directionType.w);
+	light.position = packed.positionRange.xyz;
+	light.direction = packed.directionType.xyz;
+	light.range = packed.positionRange.w;
+	light.innerConeCosine = packed.cone.x;
+	light.outerConeCosine = packed.cone.y;
+	light.ambientColor = packed.ambientFocal.rgb;
+	light.diffuseColor = packed.diffuseIntensity.rgb;
+	light.specularColor = packed.specular.rgb;
+	light.focalStrength = packed.ambientFocal.w;
+	light.specularIntensity = packed.diffuseIntensity.w;
+	return light;
+}
+
+// get the index of the cluster holding this fragment
+int GetClusterIndex()
+{
+	float viewDepth = -(view * vec4(fragmentPosition, 1.0)).z;
+	ivec3 cluster;
+	cluster.xy = ivec2((gl_FragCoord.xy - clusterViewportOrigin) * clusterTileScale);
+	cluster.z = int(floor(log(max(viewDepth, 1.0e-4)) * clusterDepthScale + clusterDepthBias));
+	cluster = clamp(cluster, ivec3(0), clusterCounts - 1);
+	return cluster.x + clusterCounts.x * (cluster.y + clusterCounts.y * cluster.z);
+}
+#elif LIGHT_COUNT > 0
+uniform LightSource lightSources[LIGHT_COUNT];
+#endif
+#endif
+
+void main()
+{
+#if USE_TEXTURE
+	vec4 baseColor = texture(objectTexture, fragmentTextureCoordinate * UVscale);
+#else
+	vec4 baseColor = objectColor;
+#endif
+
+#if GBUFFER_OUTPUT
+	// the lighting is applied later by the deferred lighting pass
+	outAlbedoMaterial = vec4(baseColor.rgb, float(materialIndex) / 255.0);
+	outEncodedNormal = EncodeNormal(normalize(fragmentVertexNormal));
+#else
+#if USE_LIGHTING
+	vec3 lighting = ambientLight.color * ambientLight.intensity;
+	vec3 normal = normalize(fragmentVertexNormal);
+	vec3 viewDirection = normalize(viewPosition - fragmentPosition);
+#if USE_BAKED_LIGHTING
+	lighting += CalculateBakedLight(normal, viewDirection);
+#elif CLUSTERED_LIGHTING
+	// only the lights that reach this fragment's cluster
+	uvec2 clusterRange = clusterRanges[GetClusterIndex()];
+	for (uint i = 0u; i < clusterRange.y; i++)
+	{
+		LightSource light = UnpackLight(packedLights[lightIndices[clusterRange.x + i]]);
+		lighting += CalculateLight(light, normal, viewDirection);
+	}
+#elif LIGHT_COUNT > 0
+	for (int i = 0; i < LIGHT_COUNT; i++)
+	{
+		lighting += CalculateLight(lightSources[i], normal, viewDirection);
+	}
+#endif
+	vec3 color = lighting * baseColor.rgb;
+#else
+	vec3 color = baseColor.rgb;
+#endif
+
+#if USE_TRANSPARENCY
+	outFragmentColor = vec4(color, baseColor.a);
+#else
+	outFragmentColor = vec4(color, 1.0);
+#endif
+#endif
+}
@@ -0,0 +1,129 @@
+///////////////////////////////////////////////////////////////////////////////
+// scenevertex.glsl
+// ============
+// vertex shader for the scene shader variants.  with MULTI_VIEW set,
+// the same file is also built as the geometry stage, with GEOMETRY_STAGE
+// set, which copies each triangle into the viewport of every view.  with
+// RECORDED_DRAWS set, each instance reads its transform and color from
+// the records written by DrawRecorder
+//
+//  Created for CS-330-Computational Graphics and Visualization
+///////////////////////////////////////////////////////////////////////////////
+
+#version 330 core
+
+#ifndef MULTI_VIEW
+#define MULTI_VIEW 0
+#endif
+#ifndef GEOMETRY_STAGE
+#define GEOMETRY_STAGE 0
+#endif
+#ifndef RECORDED_DRAWS
+#define RECORDED_DRAWS 0
+#endif
+
+#if MULTI_VIEW
+#extension GL_ARB_gpu_shader5 : require
+#extension GL_ARB_viewport_array : require
+
+// number of views drawn at once, one viewport each
+#define VIEW_COUNT 4
+#endif
+
+#if GEOMETRY_STAGE
+layout (triangles, invocations = VIEW_COUNT) in;
+layout (triangle_strip, max_vertices = 3) out;
+
+in vec3 vertexPosition[];
+in vec3 vertexNormal[];
+in vec2 vertexTextureCoordinate[];
+
+out vec3 fragmentPosition;
+out vec3 fragmentVertexNormal;
+out vec2 fragmentTextureCoordinate;
+flat out vec3 fragmentViewPosition;
+
+uniform mat4 views[VIEW_COUNT];
+uniform mat4 projections[VIEW_COUNT];
+uniform vec3 viewPositions[VIEW_COUNT];
+
+void main()
+{
+	// each invocation draws the triangle into the viewport of
+	// one view
+	mat4 viewProjection = projections[gl_InvocationID] * views[gl_InvocationID];
+	for (int i = 0; i < 3; i++)
+	{
+		fragmentPosition = vertexPosition[i];
+		fragmentVertexNormal = vertexNormal[i];
+		fragmentTextureCoordinate = vertexTextureCoordinate[i];
+		fragmentViewPosition = viewPositions[gl_InvocationID];
+		gl_Position = viewProjection * vec4(vertexPosition[i], 1.0);
+		gl_ViewportIndex = gl_InvocationID;
+		EmitVertex();
+	}
+	EndPrimitive();
+}
+#else
+layout (location = 0) in vec3 inVertexPosition;
+layout (location = 1) in vec3 inVertexNormal;
+layout (location = 2) in vec2 inTextureCoordinate;
+
+#if MULTI_VIEW
+// the views are applied by the geometry stage
+out vec3 vertexPosition;
+out vec3 vertexNormal;
+out vec2 vertexTextureCoordinate;
+#else
+out vec3 fragmentPosition;
+out vec3 fragmentVertexNormal;
+out vec2 fragmentTextureCoordinate;
+#endif
+
+uniform mat4 view;
+uniform mat4 projection;
+#if RECORDED_DRAWS
+// eight texels for each object, see DrawRecorder::OBJECT_RECORD,
+// and the record of the first instance of the draw
+uniform samplerBuffer objectRecords;
+uniform int firstObject;
+// the color, or the UV scale of a textured object
+flat out vec4 fragmentObjectValue;
+#else
+uniform mat4 model;
+// inverse transpose of the model matrix, computed once per object
+uniform mat3 normalMatrix;
+#endif
+
+void main()
+{
+#if RECORDED_DRAWS
+	int record = (firstObject + gl_InstanceID) * 8;
+	mat4 model = mat4(
+		texelFetch(objectRecords, record),
+		texelFetch(objectRecords, record + 1),
+		texelFetch(objectRecords, record + 2),
+		texelFetch(objectRecords, record + 3));
+	mat3 normalMatrix = mat3(
+		texelFetch(objectRecords, record + 4).xyz,
+		texelFetch(objectRecords, record + 5).xyz,
+		texelFetch(objectRecords, record + 6).xyz);
+	fragmentObjectValue = texelFetch(objectRecords, record + 7);
+#endif
+	vec4 worldPosition = model * vec4(inVertexPosition, 1.0);
+
+#if MULTI_VIEW
+	vertexPosition = vec3(worldPosition);
+	vertexNormal = normalMatrix * inVertexNormal;
+	vertexTextureCoordinate = inTextureCoordinate;
+
+	gl_Position = worldPosition;
+#else
+	fragmentPosition = vec3(worldPosition);
+	fragmentVertexNormal = normalMatrix * inVertexNormal;
+	fragmentTextureCoordinate = inTextureCoordinate;
+
+	gl_Position = projection * view * worldPosition;
+#endif
+}
+#endif